@@ -0,0 +1,79 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#ifndef MAPF_AGENTVALUES_H
+#define MAPF_AGENTVALUES_H
+
+#include "Includes.h"
+#include <algorithm>
+
+// Value of an agent in a sparse list of values by agent
+struct AgentValue
+{
+    Agent a;
+    SCIP_Real val;
+};
+
+// Values of the agents using an edge-time, read by agent. Most edge-times are used by a few agents, so the values are
+// a list of the agents in increasing order, which overflows to an array over all agents when the list would take more
+// memory. The storage is owned by the caller. A view without storage has no agents and tests false, like a missing
+// array.
+struct AgentValues
+{
+    AgentValue* entries;    // Values of the agents in increasing order, or null if dense
+    SCIP_Real* dense;       // Values of all agents, or null if sparse
+    Int size;               // Number of agents with a value
+
+    // Constructors
+    AgentValues(std::nullptr_t = nullptr) : entries(nullptr), dense(nullptr), size(0) {}
+
+    // Check if the edge-time is used by any agent
+    explicit inline operator bool() const { return entries || dense; }
+
+    // Check if the values are stored as an array over all agents
+    static inline bool is_dense(const Int size, const Agent N)
+    {
+        return static_cast<size_t>(size) * sizeof(AgentValue) > static_cast<size_t>(N) * sizeof(SCIP_Real);
+    }
+
+    // Get the value of an agent, which is zero if the agent is not in the list
+    inline SCIP_Real operator[](const Agent a) const
+    {
+        if (dense)
+        {
+            return dense[a];
+        }
+        if (size <= 8)
+        {
+            for (auto it = entries; it != entries + size; ++it)
+                if (it->a == a)
+                {
+                    return it->val;
+                }
+            return 0.0;
+        }
+        const auto it = std::lower_bound(entries,
+                                         entries + size,
+                                         a,
+                                         [](const AgentValue& entry, const Agent a) { return entry.a < a; });
+        return it != entries + size && it->a == a ? it->val : 0.0;
+    }
+};
+
+#endif
@@ -0,0 +1,274 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#include "Anytime.h"
+#include <sstream>
+
+#define EVENTHDLR_NAME "mapf_anytime"
+#define EVENTHDLR_DESC "Schedule of gap limits for anytime solving"
+
+#define DEFAULT_ANYTIME_SCHEDULE ""           // Pairs of gap and seconds separated by commas (empty to disable)
+#define DIVING_NODE_SELECTOR "dfs"            // Node selector used before the last target
+#define DIVING_NODE_SELECTOR_PRIORITY 1000000 // Priority of the node selector used before the last target
+
+struct AnytimeTarget
+{
+    SCIP_Real gap;     // Gap limit
+    SCIP_Real time;    // Time when the next target starts
+};
+
+struct AnytimeData
+{
+    Vector<AnytimeTarget> targets;    // Schedule
+    size_t target;                    // Index of the current target
+    int diving_std_priority;          // Original priority of the diving node selector
+    int diving_memsave_priority;      // Original priority of the diving node selector in memory saving mode
+};
+
+// Parse a schedule of gap and time targets
+static Vector<AnytimeTarget> parse_schedule(
+    const char* schedule    // Schedule
+)
+{
+    Vector<AnytimeTarget> targets;
+    std::istringstream input(schedule);
+    String item;
+    while (std::getline(input, item, ','))
+    {
+        AnytimeTarget target;
+        char separator;
+        std::istringstream item_input(item);
+        release_assert(item_input >> target.gap >> separator >> target.time && separator == ':' &&
+                       (item_input >> std::ws).eof(),
+                       "Invalid target {} in anytime schedule {}", item, schedule);
+        release_assert(target.gap >= 0 && target.time > 0 && (targets.empty() || target.time > targets.back().time),
+                       "Targets of anytime schedule {} must have non-negative gaps and increasing times", schedule);
+        targets.push_back(target);
+    }
+    return targets;
+}
+
+// Select nodes depth-first or restore the original node selection
+static SCIP_RETCODE set_diving(
+    SCIP* scip,                   // SCIP
+    AnytimeData& eventhdlrdata,   // Event handler data
+    const bool on                 // Dive?
+)
+{
+    auto nodesel = SCIPfindNodesel(scip, DIVING_NODE_SELECTOR);
+    if (nodesel)
+    {
+        SCIP_CALL(SCIPsetNodeselStdPriority(scip,
+                                            nodesel,
+                                            on ? DIVING_NODE_SELECTOR_PRIORITY :
+                                                 eventhdlrdata.diving_std_priority));
+        SCIP_CALL(SCIPsetNodeselMemsavePriority(scip,
+                                                nodesel,
+                                                on ? DIVING_NODE_SELECTOR_PRIORITY :
+                                                     eventhdlrdata.diving_memsave_priority));
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Move to the target of the current time
+static SCIP_RETCODE update_target(
+    SCIP* scip,                  // SCIP
+    AnytimeData& eventhdlrdata   // Event handler data
+)
+{
+    // Find the target.
+    const auto& targets = eventhdlrdata.targets;
+    const auto time = SCIPgetSolvingTime(scip);
+    auto target = eventhdlrdata.target;
+    while (target + 1 < targets.size() && time >= targets[target].time)
+    {
+        ++target;
+    }
+
+    // Change the gap limit and the node selection.
+    if (target != eventhdlrdata.target)
+    {
+        debugln("Moving to anytime target {} with gap limit {} at time {:.2f}", target, targets[target].gap, time);
+        eventhdlrdata.target = target;
+        SCIP_CALL(SCIPsetRealParam(scip, "limits/gap", targets[target].gap));
+        if (target + 1 == targets.size())
+        {
+            SCIP_CALL(set_diving(scip, eventhdlrdata, false));
+        }
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Start the schedule at the start of the solve
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_EVENTINITSOL(eventInitsolAnytime)
+{
+    // Get event handler data.
+    auto eventhdlrdata = reinterpret_cast<AnytimeData*>(SCIPeventhdlrGetData(eventhdlr));
+    debug_assert(eventhdlrdata);
+
+    // Read the schedule.
+    char* schedule;
+    SCIP_CALL(SCIPgetStringParam(scip, ANYTIME_SCHEDULE_PARAM, &schedule));
+    eventhdlrdata->targets = parse_schedule(schedule);
+    eventhdlrdata->target = 0;
+    const auto& targets = eventhdlrdata->targets;
+    if (targets.empty())
+    {
+        return SCIP_OKAY;
+    }
+
+    // Stop at the time of the last target.
+    SCIP_Real time_limit;
+    SCIP_CALL(SCIPgetRealParam(scip, "limits/time", &time_limit));
+    SCIP_CALL(SCIPsetRealParam(scip, "limits/time", std::min(time_limit, targets.back().time)));
+
+    // Start at the first target.
+    SCIP_CALL(SCIPsetRealParam(scip, "limits/gap", targets.front().gap));
+    if (auto nodesel = SCIPfindNodesel(scip, DIVING_NODE_SELECTOR))
+    {
+        eventhdlrdata->diving_std_priority = SCIPnodeselGetStdPriority(nodesel);
+        eventhdlrdata->diving_memsave_priority = SCIPnodeselGetMemsavePriority(nodesel);
+    }
+    if (targets.size() > 1)
+    {
+        SCIP_CALL(set_diving(scip, *eventhdlrdata, true));
+    }
+
+    // Check the time after every LP and every node.
+    SCIP_CALL(SCIPcatchEvent(scip, SCIP_EVENTTYPE_LPSOLVED | SCIP_EVENTTYPE_NODESOLVED, eventhdlr, nullptr, nullptr));
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Stop the schedule at the end of the solve
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_EVENTEXITSOL(eventExitsolAnytime)
+{
+    // Get event handler data.
+    auto eventhdlrdata = reinterpret_cast<AnytimeData*>(SCIPeventhdlrGetData(eventhdlr));
+    debug_assert(eventhdlrdata);
+
+    // Restore the node selection.
+    if (!eventhdlrdata->targets.empty())
+    {
+        SCIP_CALL(SCIPdropEvent(scip,
+                                SCIP_EVENTTYPE_LPSOLVED | SCIP_EVENTTYPE_NODESOLVED,
+                                eventhdlr,
+                                nullptr,
+                                -1));
+        if (eventhdlrdata->target + 1 < eventhdlrdata->targets.size())
+        {
+            SCIP_CALL(set_diving(scip, *eventhdlrdata, false));
+        }
+        eventhdlrdata->targets.clear();
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Move to the next target when its time is reached
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_EVENTEXEC(eventExecAnytime)
+{
+    // Get event handler data.
+    auto eventhdlrdata = reinterpret_cast<AnytimeData*>(SCIPeventhdlrGetData(eventhdlr));
+    debug_assert(eventhdlrdata);
+
+    // Update.
+    SCIP_CALL(update_target(scip, *eventhdlrdata));
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Free event handler
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_EVENTFREE(eventFreeAnytime)
+{
+    auto eventhdlrdata = reinterpret_cast<AnytimeData*>(SCIPeventhdlrGetData(eventhdlr));
+    debug_assert(eventhdlrdata);
+    eventhdlrdata->~AnytimeData();
+    SCIPfreeBlockMemory(scip, &eventhdlrdata);
+    SCIPeventhdlrSetData(eventhdlr, nullptr);
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Include the anytime event handler
+SCIP_RETCODE SCIPincludeEventhdlrAnytime(
+    SCIP* scip    // SCIP
+)
+{
+    // Create event handler data.
+    AnytimeData* eventhdlrdata = nullptr;
+    SCIP_CALL(SCIPallocBlockMemory(scip, &eventhdlrdata));
+    debug_assert(eventhdlrdata);
+    new (eventhdlrdata) AnytimeData;
+    eventhdlrdata->target = 0;
+    eventhdlrdata->diving_std_priority = 0;
+    eventhdlrdata->diving_memsave_priority = 0;
+
+    // Include event handler.
+    SCIP_EVENTHDLR* eventhdlr = nullptr;
+    SCIP_CALL(SCIPincludeEventhdlrBasic(scip,
+                                        &eventhdlr,
+                                        EVENTHDLR_NAME,
+                                        EVENTHDLR_DESC,
+                                        eventExecAnytime,
+                                        reinterpret_cast<SCIP_EVENTHDLRDATA*>(eventhdlrdata)));
+    debug_assert(eventhdlr);
+
+    // Set callbacks.
+    SCIP_CALL(SCIPsetEventhdlrInitsol(scip, eventhdlr, eventInitsolAnytime));
+    SCIP_CALL(SCIPsetEventhdlrExitsol(scip, eventhdlr, eventExitsolAnytime));
+    SCIP_CALL(SCIPsetEventhdlrFree(scip, eventhdlr, eventFreeAnytime));
+
+    // Add parameters.
+    SCIP_CALL(SCIPaddStringParam(scip,
+                                 ANYTIME_SCHEDULE_PARAM,
+                                 "targets of gap and seconds separated by commas, e.g. 0.05:2,0.01:10 (empty to disable)",
+                                 nullptr,
+                                 FALSE,
+                                 DEFAULT_ANYTIME_SCHEDULE,
+                                 nullptr,
+                                 nullptr));
+
+    // Done.
+    return SCIP_OKAY;
+}
@@ -0,0 +1,34 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#ifndef MAPF_ANYTIME_H
+#define MAPF_ANYTIME_H
+
+#include "Includes.h"
+
+#define ANYTIME_SCHEDULE_PARAM "mapf/anytime/schedule"
+
+// Include the event handler that tightens the gap limit over time according to a schedule of gap and time targets,
+// e.g. "0.05:2,0.01:10" stops at a gap of 5% before 2 seconds, else at a gap of 1% before 10 seconds, else at 10
+// seconds. Before the last target, nodes are selected depth-first to find incumbents quickly.
+SCIP_RETCODE SCIPincludeEventhdlrAnytime(
+    SCIP* scip    // SCIP
+);
+
+#endif
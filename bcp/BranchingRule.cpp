@@ -23,6 +23,8 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Includes.h"
 #include "ProblemData.h"
 #include "VariableData.h"
+#include "Trace.h"
+#include "NodeLog.h"
 #include "Constraint_VertexBranching.h"
 #include "Constraint_WaitBranching.h"
 #include "Constraint_LengthBranching.h"
@@ -34,12 +36,147 @@ Author: Edward Lam <ed@ed-lam.com>
 #define BRANCHRULE_MAXDEPTH        -1
 #define BRANCHRULE_MAXBOUNDDIST    1.0
 
+// Branching rule parameters
+#define DEFAULT_LOOKAHEAD 0        // Number of vertex candidates evaluated with the low-level solver (0 to disable)
+#define DEFAULT_RELIABILITY 0      // Number of observations for the pseudocosts of a decision to be reliable (0 to disable)
+#define DEFAULT_REGION_SIZE 4      // Width and height of the regions of the map sharing the pseudocosts of vertices
+#define DEFAULT_WAIT FALSE         // Branch on an agent waiting at a vertex before branching on vertices
+
+// Pseudocosts of the branching decisions of an agent in a region of the map. Direction 0 forbids the vertex or
+// bounds the length from above, and direction 1 uses the vertex or bounds the length from below.
+struct Pseudocost
+{
+    SCIP_Real sum_gain[2]{0.0, 0.0};    // Sum of the bound gains per unit of change in each direction
+    Int count[2]{0, 0};                 // Number of observations in each direction
+};
+
+// Bound gain of a child node to observe when the node is solved
+struct PendingGain
+{
+    bool is_vertex;         // Indicates if the decision is a vertex or a length branching decision
+    uint64_t key;           // Agent and region of the decision
+    Int dir;                // Direction of the child
+    SCIP_Real parent_lb;    // Lower bound of the parent node
+    SCIP_Real change;       // Change in the value of the decision in the child
+};
+
+// Branching rule data
+struct MAPFBranchruleData
+{
+    HashTable<uint64_t, Pseudocost> vertex_pseudocosts;    // Pseudocosts of vertex decisions by agent and region
+    HashTable<uint64_t, Pseudocost> length_pseudocosts;    // Pseudocosts of length decisions by agent
+    Pseudocost vertex_total;                               // Pseudocosts summed over every vertex decision
+    HashTable<SCIP_Longint, PendingGain> pending;          // Children not yet solved by node number
+};
+
+// Get the branching rule data
+static inline
+MAPFBranchruleData& get_branchrule_data(
+    SCIP* scip    // SCIP
+)
+{
+    auto branchrule = SCIPfindBranchrule(scip, BRANCHRULE_NAME);
+    debug_assert(branchrule);
+    auto branchruledata = reinterpret_cast<MAPFBranchruleData*>(SCIPbranchruleGetData(branchrule));
+    debug_assert(branchruledata);
+    return *branchruledata;
+}
+
+// Get the key of the pseudocosts of a vertex decision
+static inline
+uint64_t get_vertex_pseudocost_key(
+    SCIP* scip,              // SCIP
+    const AgentNodeTime ant  // Branching decision
+)
+{
+    int region_size;
+    scip_assert(SCIPgetIntParam(scip, BRANCHING_REGION_SIZE_PARAM, &region_size));
+    const auto& map = SCIPprobdataGetMap(SCIPgetProbData(scip));
+    const auto [x, y] = map.get_xy(ant.n);
+    const auto nb_regions_x = (map.width() + region_size - 1) / region_size;
+    const auto region = (y / region_size) * nb_regions_x + x / region_size;
+    return (static_cast<uint64_t>(ant.a) << 32) | static_cast<uint32_t>(region);
+}
+
+// Get the pseudocost of each direction of a decision. Directions without an observation take the average over every
+// decision of the same kind.
+static
+Pair<SCIP_Real, SCIP_Real> get_pseudocosts(
+    SCIP* scip,                                         // SCIP
+    const HashTable<uint64_t, Pseudocost>& pseudocosts, // Pseudocosts
+    const Pseudocost& total,                            // Pseudocosts summed over every decision
+    const uint64_t key,                                 // Key of the decision
+    bool& reliable                                      // Output flag to indicate if the pseudocosts are reliable
+)
+{
+    int reliability;
+    scip_assert(SCIPgetIntParam(scip, BRANCHING_RELIABILITY_PARAM, &reliability));
+
+    const auto it = pseudocosts.find(key);
+    const Pseudocost empty;
+    const auto& pseudocost = it != pseudocosts.end() ? it->second : empty;
+    SCIP_Real output[2];
+    for (Int dir = 0; dir < 2; ++dir)
+    {
+        if (pseudocost.count[dir] > 0)
+        {
+            output[dir] = pseudocost.sum_gain[dir] / pseudocost.count[dir];
+        }
+        else if (total.count[dir] > 0)
+        {
+            output[dir] = total.sum_gain[dir] / total.count[dir];
+        }
+        else
+        {
+            output[dir] = 0.0;
+        }
+    }
+    reliable = reliability > 0 && pseudocost.count[0] >= reliability && pseudocost.count[1] >= reliability;
+    return {output[0], output[1]};
+}
+
+// Observe the bound gains of the children of a decision when the children are solved
+static
+void add_pending_gains(
+    SCIP* scip,                   // SCIP
+    const bool is_vertex,         // Indicates if the decision is a vertex or a length branching decision
+    const uint64_t key,           // Key of the decision
+    SCIP_NODE* branch_0_node,     // Child in direction 0
+    const SCIP_Real change_0,     // Change in the value of the decision in direction 0
+    SCIP_NODE* branch_1_node,     // Child in direction 1
+    const SCIP_Real change_1      // Change in the value of the decision in direction 1
+)
+{
+    // Skip if the pseudocosts are not used or the bound of the parent is not from an optimal LP.
+    int reliability;
+    scip_assert(SCIPgetIntParam(scip, BRANCHING_RELIABILITY_PARAM, &reliability));
+    if (reliability == 0 || !SCIPhasCurrentNodeLP(scip) || SCIPgetLPSolstat(scip) != SCIP_LPSOLSTAT_OPTIMAL)
+    {
+        return;
+    }
+
+    // Store the children.
+    auto& pending = get_branchrule_data(scip).pending;
+    const auto parent_lb = SCIPgetLocalLowerbound(scip);
+    if (SCIPisPositive(scip, change_0))
+    {
+        pending[SCIPnodeGetNumber(branch_0_node)] = PendingGain{is_vertex, key, 0, parent_lb, change_0};
+    }
+    if (SCIPisPositive(scip, change_1))
+    {
+        pending[SCIPnodeGetNumber(branch_1_node)] = PendingGain{is_vertex, key, 1, parent_lb, change_1};
+    }
+}
+
 // Branching execution method for fractional LP solutions
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-parameter"
 static
 SCIP_DECL_BRANCHEXECLP(branchExeclpMAPF)
 {
+    // Trace.
+    const TraceScope trace("branching");
+
     // Check.
     debug_assert(scip);
     debug_assert(branchrule);
@@ -57,6 +194,9 @@ SCIP_DECL_BRANCHEXECLP(branchExeclpMAPF)
 static
 SCIP_DECL_BRANCHEXECPS(branchExecpsMAPF)
 {
+    // Trace.
+    const TraceScope trace("pseudo branching");
+
     // Check.
     debug_assert(scip);
     debug_assert(branchrule);
@@ -78,11 +218,62 @@ SCIP_DECL_BRANCHEXECEXT(branchExecextMAPF)
 }
 #pragma GCC diagnostic pop
 
+// Deinitialize the branching rule before the branch-and-bound process is freed
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_BRANCHEXITSOL(branchExitsolMAPF)
+{
+    // Check.
+    debug_assert(scip);
+    debug_assert(branchrule);
+    debug_assert(strcmp(SCIPbranchruleGetName(branchrule), BRANCHRULE_NAME) == 0);
+
+    // Get branching rule data.
+    auto branchruledata = reinterpret_cast<MAPFBranchruleData*>(SCIPbranchruleGetData(branchrule));
+    debug_assert(branchruledata);
+
+    // Forget the children that were never solved.
+    branchruledata->pending.clear();
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Free the branching rule
+static
+SCIP_DECL_BRANCHFREE(branchFreeMAPF)
+{
+    // Check.
+    debug_assert(scip);
+    debug_assert(branchrule);
+    debug_assert(strcmp(SCIPbranchruleGetName(branchrule), BRANCHRULE_NAME) == 0);
+
+    // Get branching rule data.
+    auto branchruledata = reinterpret_cast<MAPFBranchruleData*>(SCIPbranchruleGetData(branchrule));
+    debug_assert(branchruledata);
+
+    // Free memory.
+    branchruledata->~MAPFBranchruleData();
+    SCIPfreeBlockMemory(scip, &branchruledata);
+    SCIPbranchruleSetData(branchrule, nullptr);
+
+    // Done.
+    return SCIP_OKAY;
+}
+
 // Create the branching rule and include it in SCIP
 SCIP_RETCODE SCIPincludeBranchrule(
     SCIP* scip    // SCIP
 )
 {
+    // Create branching rule data.
+    MAPFBranchruleData* branchruledata = nullptr;
+    SCIP_CALL(SCIPallocBlockMemory(scip, &branchruledata));
+    debug_assert(branchruledata);
+    new(branchruledata) MAPFBranchruleData;
+
     // Include branching rule.
     SCIP_BRANCHRULE* branchrule = nullptr;
     SCIP_CALL(SCIPincludeBranchruleBasic(scip,
@@ -92,18 +283,137 @@ SCIP_RETCODE SCIPincludeBranchrule(
                                          BRANCHRULE_PRIORITY,
                                          BRANCHRULE_MAXDEPTH,
                                          BRANCHRULE_MAXBOUNDDIST,
-                                         nullptr));
+                                         reinterpret_cast<SCIP_BRANCHRULEDATA*>(branchruledata)));
     debug_assert(branchrule);
 
     // Activate branching rule.
     SCIP_CALL(SCIPsetBranchruleExecLp(scip, branchrule, branchExeclpMAPF));
     SCIP_CALL(SCIPsetBranchruleExecPs(scip, branchrule, branchExecpsMAPF));
     SCIP_CALL(SCIPsetBranchruleExecExt(scip, branchrule, branchExecextMAPF));
+    SCIP_CALL(SCIPsetBranchruleExitsol(scip, branchrule, branchExitsolMAPF));
+    SCIP_CALL(SCIPsetBranchruleFree(scip, branchrule, branchFreeMAPF));
+
+    // Add parameters.
+    SCIP_CALL(SCIPaddIntParam(scip,
+                              BRANCHING_LOOKAHEAD_PARAM,
+                              "number of vertex candidates whose children are estimated by re-pricing the agent (0 to disable)",
+                              nullptr,
+                              FALSE,
+                              DEFAULT_LOOKAHEAD,
+                              0,
+                              1024,
+                              nullptr,
+                              nullptr));
+    SCIP_CALL(SCIPaddIntParam(scip,
+                              BRANCHING_RELIABILITY_PARAM,
+                              "number of observed bound gains for the pseudocosts of a decision to be reliable (0 to disable)",
+                              nullptr,
+                              FALSE,
+                              DEFAULT_RELIABILITY,
+                              0,
+                              std::numeric_limits<int>::max(),
+                              nullptr,
+                              nullptr));
+    SCIP_CALL(SCIPaddIntParam(scip,
+                              BRANCHING_REGION_SIZE_PARAM,
+                              "width and height of the regions of the map sharing the pseudocosts of vertex decisions",
+                              nullptr,
+                              FALSE,
+                              DEFAULT_REGION_SIZE,
+                              1,
+                              std::numeric_limits<int>::max(),
+                              nullptr,
+                              nullptr));
+    SCIP_CALL(SCIPaddBoolParam(scip,
+                               BRANCHING_WAIT_PARAM,
+                               "branch on an agent waiting at a vertex it both waits at and leaves before branching on vertices",
+                               nullptr,
+                               FALSE,
+                               DEFAULT_WAIT,
+                               nullptr,
+                               nullptr));
 
     // Done.
     return SCIP_OKAY;
 }
 
+// Record the bound gain of a child of a branching decision when the child leaves the active path
+void branching_record_gain(
+    SCIP* scip,          // SCIP
+    SCIP_NODE* node      // Child node
+)
+{
+    // Check.
+    debug_assert(scip);
+    debug_assert(node);
+
+    // Find the decision that created the node.
+    if (SCIPgetStage(scip) != SCIP_STAGE_SOLVING)
+    {
+        return;
+    }
+    auto& branchruledata = get_branchrule_data(scip);
+    auto it = branchruledata.pending.find(SCIPnodeGetNumber(node));
+    if (it == branchruledata.pending.end())
+    {
+        return;
+    }
+    const auto [is_vertex, key, dir, parent_lb, change] = it->second;
+    branchruledata.pending.erase(it);
+
+    // Get the bound of the node. The bound of an infeasible or pruned node is at least the cut-off bound.
+    auto lb = SCIPnodeGetLowerbound(node);
+    if (SCIPisInfinity(scip, lb))
+    {
+        lb = SCIPgetCutoffbound(scip);
+        if (SCIPisInfinity(scip, lb))
+        {
+            return;
+        }
+    }
+
+    // Store the gain per unit of change.
+    const auto gain = std::max(lb - parent_lb, 0.0) / change;
+    auto& pseudocost = is_vertex ?
+                       branchruledata.vertex_pseudocosts[key] :
+                       branchruledata.length_pseudocosts[key];
+    pseudocost.sum_gain[dir] += gain;
+    pseudocost.count[dir]++;
+    if (is_vertex)
+    {
+        branchruledata.vertex_total.sum_gain[dir] += gain;
+        branchruledata.vertex_total.count[dir]++;
+    }
+    debugln("   Observed bound gain {:.4f} per unit in direction {} of {} decision at node {}",
+            gain, dir, is_vertex ? "vertex" : "length", SCIPnodeGetNumber(node));
+}
+
+// Get the pseudocosts per unit of change in the children forbidding and using a vertex
+Pair<SCIP_Real, SCIP_Real> branching_get_vertex_pseudocosts(
+    SCIP* scip,                 // SCIP
+    const AgentNodeTime ant,    // Branching decision
+    bool& reliable              // Output flag to indicate if the pseudocosts are reliable
+)
+{
+    const auto& branchruledata = get_branchrule_data(scip);
+    return get_pseudocosts(scip,
+                           branchruledata.vertex_pseudocosts,
+                           branchruledata.vertex_total,
+                           get_vertex_pseudocost_key(scip, ant),
+                           reliable);
+}
+
+// Get the pseudocosts of the children bounding the length of an agent from above and below
+Pair<SCIP_Real, SCIP_Real> branching_get_length_pseudocosts(
+    SCIP* scip,         // SCIP
+    const Agent a,      // Agent
+    bool& reliable      // Output flag to indicate if the pseudocosts are reliable
+)
+{
+    const auto& branchruledata = get_branchrule_data(scip);
+    return get_pseudocosts(scip, branchruledata.length_pseudocosts, Pseudocost{}, a, reliable);
+}
+
 SCIP_RETCODE branch_on_vertex(
     SCIP* scip,                   // SCIP
     const AgentNodeTime ant,      // Branch decision
@@ -214,114 +524,154 @@ SCIP_RETCODE branch_on_vertex(
     SCIP_CALL(SCIPreleaseCons(scip, &branch_1_cons));
     SCIP_CALL(SCIPreleaseCons(scip, &branch_0_cons));
 
+    // Observe the bound gains of the children. The paths of the agent using the vertex are removed in the forbid
+    // branch and the other paths of the agent are removed in the use branch.
+    {
+        auto probdata = SCIPgetProbData(scip);
+        const auto& agent_vars = SCIPprobdataGetAgentVars(probdata);
+        SCIP_Real val = 0.0;
+        for (const auto& [var, _] : agent_vars[ant.a])
+        {
+            auto vardata = SCIPvarGetData(var);
+            const auto path_length = SCIPvardataGetPathLength(vardata);
+            const auto path = SCIPvardataGetPath(vardata);
+            if (ant.t < path_length && path[ant.t].n == ant.n)
+            {
+                val += SCIPgetSolVal(scip, nullptr, var);
+            }
+        }
+        add_pending_gains(scip,
+                          true,
+                          get_vertex_pseudocost_key(scip, ant),
+                          branch_0_node,
+                          val,
+                          branch_1_node,
+                          1.0 - val);
+    }
+
+    // Log the decision.
+    node_log_set_branching(scip, "vertex", ant);
+
     // Return.
     return SCIP_OKAY;
 }
 
-//SCIP_RETCODE branch_on_wait(
-//    SCIP* scip,                   // SCIP
-//    const AgentTime at,           // Branch decision
-//    const bool prefer_branch_0    // Preferred branch direction
-//)
-//{
-//    // Print.
-//#if defined(PRINT_DEBUG) or defined(DEBUG)
-//    debugln("   Branching on agent {}, wait at time {} at node {}, depth {}",
-//            at.a, at.t,
-//            SCIPnodeGetNumber(SCIPgetCurrentNode(scip)),
-//            SCIPgetDepth(scip));
-//#endif
-//
-//    // Check that the decision hasn't been branched on already.
-//#ifdef DEBUG
-//    {
-//        // Get constraints for vertex branching decisions.
-//        auto conshdlr = SCIPfindConshdlr(scip, "wait_branching");
-//        const auto n_wait_branching_conss = SCIPconshdlrGetNConss(conshdlr);
-//        auto wait_branching_conss = SCIPconshdlrGetConss(conshdlr);
-//        debug_assert(n_wait_branching_conss == 0 || wait_branching_conss);
-//
-//        // Loop through decisions in ancestors of this node.
-//        for (Count c = 0; c < n_wait_branching_conss; ++c)
-//        {
-//            // Get the constraint.
-//            auto cons = wait_branching_conss[c];
-//            debug_assert(cons);
-//
-//            // Ignore constraints that are not active since these are not on the current
-//            // active path of the search tree.
-//            if (!SCIPconsIsActive(cons))
-//            {
-//                continue;
-//            }
-//
-//            // Get the decision.
-//            const auto a = SCIPgetWaitBranchingAgent(cons);
-//            const auto t = SCIPgetWaitBranchingTime(cons);
-//            const AgentTime decision{a, t};
-//
-//            // Check.
-//            release_assert(decision != at);
-//        }
-//    }
-//#endif
-//
-//    // Create two children nodes.
-//    const auto score = SCIPgetLocalTransEstimate(scip);
-//    SCIP_NODE* branch_1_node;
-//    SCIP_NODE* branch_0_node;
-//    SCIP_CALL(SCIPcreateChild(scip,
-//                              &branch_1_node,
-//                              1.0 - static_cast<SCIP_Real>(prefer_branch_0),
-//                              score + (prefer_branch_0 ? 1.0 : 0.0)));
-//    SCIP_CALL(SCIPcreateChild(scip,
-//                              &branch_0_node,
-//                              static_cast<SCIP_Real>(prefer_branch_0),
-//                              score + (prefer_branch_0 ? 0.0 : 1.0)));
-//
-//    // Create local constraints that enforce the branching in the children nodes.
-//    SCIP_CONS* branch_1_cons;
-//    SCIP_CONS* branch_0_cons;
-//#ifdef DEBUG
-//    const auto branch_1_name = fmt::format("branch_must_wait({},{})", at.a, at.t);
-//    const auto branch_0_name = fmt::format("branch_cannot_wait({},{})", at.a, at.t);
-//#endif
-//    SCIP_CALL(SCIPcreateConsWaitBranching(scip,
-//                                          &branch_1_cons,
-//#ifdef DEBUG
-//                                          branch_1_name.c_str(),
-//#else
-//                                          "",
-//#endif
-//                                          WaitBranchDirection::MustWait,
-//                                          at.a,
-//                                          at.t,
-//                                          branch_1_node,
-//                                          TRUE));
-//    SCIP_CALL(SCIPcreateConsWaitBranching(scip,
-//                                          &branch_0_cons,
-//#ifdef DEBUG
-//                                          branch_0_name.c_str(),
-//#else
-//                                          "",
-//#endif
-//                                          WaitBranchDirection::CannotWait,
-//                                          at.a,
-//                                          at.t,
-//                                          branch_0_node,
-//                                          TRUE));
-//
-//    // Add the constraints to the nodes.
-//    SCIP_CALL(SCIPaddConsNode(scip, branch_1_node, branch_1_cons, nullptr));
-//    SCIP_CALL(SCIPaddConsNode(scip, branch_0_node, branch_0_cons, nullptr));
-//
-//    // Decrease reference counter of the constraints.
-//    SCIP_CALL(SCIPreleaseCons(scip, &branch_1_cons));
-//    SCIP_CALL(SCIPreleaseCons(scip, &branch_0_cons));
-//
-//    // Return.
-//    return SCIP_OKAY;
-//}
+SCIP_RETCODE branch_on_wait(
+    SCIP* scip,                   // SCIP
+    const AgentNodeTime ant,      // Branch decision
+    const bool prefer_branch_0    // Preferred branch direction
+)
+{
+    // Print.
+#if defined(PRINT_DEBUG) or defined(DEBUG)
+    Position x, y;
+    {
+        auto probdata = SCIPgetProbData(scip);
+        const auto& map = SCIPprobdataGetMap(probdata);
+        x = map.get_x(ant.n);
+        y = map.get_y(ant.n);
+        debugln("   Branching on agent {}, wait at (({},{}),{}) at node {}, depth {}",
+                ant.a, x, y, ant.t,
+                SCIPnodeGetNumber(SCIPgetCurrentNode(scip)),
+                SCIPgetDepth(scip));
+    }
+#endif
+
+    // Check that the decision hasn't been branched on already.
+#ifdef DEBUG
+    {
+        // Get constraints for wait branching decisions.
+        auto conshdlr = SCIPfindConshdlr(scip, "wait_branching");
+        const auto n_wait_branching_conss = SCIPconshdlrGetNConss(conshdlr);
+        auto wait_branching_conss = SCIPconshdlrGetConss(conshdlr);
+        debug_assert(n_wait_branching_conss == 0 || wait_branching_conss);
+
+        // Loop through decisions in ancestors of this node.
+        for (Int c = 0; c < n_wait_branching_conss; ++c)
+        {
+            // Get the constraint.
+            auto cons = wait_branching_conss[c];
+            debug_assert(cons);
+
+            // Ignore constraints that are not active since these are not on the current
+            // active path of the search tree.
+            if (!SCIPconsIsActive(cons))
+            {
+                continue;
+            }
+
+            // Get the decision.
+            const auto a = SCIPgetWaitBranchingAgent(cons);
+            const auto nt = SCIPgetWaitBranchingNodeTime(cons);
+            const AgentNodeTime decision{.a = a, .n = nt.n, .t = nt.t};
+
+            // Check.
+            release_assert(decision != ant);
+        }
+    }
+#endif
+
+    // Create children nodes.
+    const auto score = SCIPgetLocalTransEstimate(scip);
+    SCIP_NODE* branch_1_node;
+    SCIP_NODE* branch_0_node;
+    SCIP_CALL(SCIPcreateChild(scip,
+                              &branch_1_node,
+                              1.0 - static_cast<SCIP_Real>(prefer_branch_0),
+                              score + (prefer_branch_0 ? 1.0 : 0.0)));
+    SCIP_CALL(SCIPcreateChild(scip,
+                              &branch_0_node,
+                              static_cast<SCIP_Real>(prefer_branch_0),
+                              score + (prefer_branch_0 ? 0.0 : 1.0)));
+
+    // Create local constraints that enforce the branching in the children nodes.
+    SCIP_CONS* branch_1_cons;
+    SCIP_CONS* branch_0_cons;
+#ifdef DEBUG
+    const auto branch_1_name = fmt::format("branch_must_wait({},({},{}),{})",
+                                           ant.a, x, y, ant.t);
+    const auto branch_0_name = fmt::format("branch_cannot_wait({},({},{}),{})",
+                                           ant.a, x, y, ant.t);
+#endif
+    SCIP_CALL(SCIPcreateConsWaitBranching(scip,
+                                          &branch_1_cons,
+#ifdef DEBUG
+                                          branch_1_name.c_str(),
+#else
+                                          "",
+#endif
+                                          WaitBranchDirection::MustWait,
+                                          ant.a,
+                                          NodeTime(ant.n, ant.t),
+                                          branch_1_node,
+                                          TRUE));
+    SCIP_CALL(SCIPcreateConsWaitBranching(scip,
+                                          &branch_0_cons,
+#ifdef DEBUG
+                                          branch_0_name.c_str(),
+#else
+                                          "",
+#endif
+                                          WaitBranchDirection::CannotWait,
+                                          ant.a,
+                                          NodeTime(ant.n, ant.t),
+                                          branch_0_node,
+                                          TRUE));
+
+    // Add the constraints to the nodes.
+    SCIP_CALL(SCIPaddConsNode(scip, branch_1_node, branch_1_cons, nullptr));
+    SCIP_CALL(SCIPaddConsNode(scip, branch_0_node, branch_0_cons, nullptr));
+
+    // Decrease reference counter of the constraints.
+    SCIP_CALL(SCIPreleaseCons(scip, &branch_1_cons));
+    SCIP_CALL(SCIPreleaseCons(scip, &branch_0_cons));
+
+    // Log the decision.
+    node_log_set_branching(scip, "wait", ant);
+
+    // Return.
+    return SCIP_OKAY;
+}
 
 SCIP_RETCODE branch_on_length(
     SCIP* scip,                   // SCIP
@@ -446,6 +796,12 @@ SCIP_RETCODE branch_on_length(
     SCIP_CALL(SCIPreleaseCons(scip, &branch_1_cons));
     SCIP_CALL(SCIPreleaseCons(scip, &branch_0_cons));
 
+    // Observe the bound gains of the children.
+    add_pending_gains(scip, false, ant.a, branch_0_node, 1.0, branch_1_node, 1.0);
+
+    // Log the decision.
+    node_log_set_branching(scip, "length", ant);
+
     // Return.
     return SCIP_OKAY;
 }
@@ -23,6 +23,11 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Includes.h"
 #include "Coordinates.h"
 
+#define BRANCHING_LOOKAHEAD_PARAM "branching/mapf/lookahead"
+#define BRANCHING_RELIABILITY_PARAM "branching/mapf/reliability"
+#define BRANCHING_REGION_SIZE_PARAM "branching/mapf/regionsize"
+#define BRANCHING_WAIT_PARAM "branching/mapf/wait"
+
 // Create the branching rule and include it in SCIP
 SCIP_RETCODE SCIPincludeBranchrule(
     SCIP* scip    // SCIP
@@ -47,6 +52,27 @@ Vector<NodeTime> get_time_of_earliest_goal(
     const Agent N               // Number of agents
 );
 
+// Record the bound gain of a child of a branching decision when the child leaves the active path
+void branching_record_gain(
+    SCIP* scip,          // SCIP
+    SCIP_NODE* node      // Child node
+);
+
+// Get the pseudocosts per unit of change in the children forbidding and using a vertex. The pseudocosts are shared
+// by the vertices of an agent in a region of the map.
+Pair<SCIP_Real, SCIP_Real> branching_get_vertex_pseudocosts(
+    SCIP* scip,                 // SCIP
+    const AgentNodeTime ant,    // Branching decision
+    bool& reliable              // Output flag to indicate if the pseudocosts are reliable
+);
+
+// Get the pseudocosts of the children bounding the length of an agent from above and below
+Pair<SCIP_Real, SCIP_Real> branching_get_length_pseudocosts(
+    SCIP* scip,         // SCIP
+    const Agent a,      // Agent
+    bool& reliable      // Output flag to indicate if the pseudocosts are reliable
+);
+
 // Create children nodes.
 SCIP_RETCODE
 branch_on_vertex(
@@ -54,12 +80,12 @@ branch_on_vertex(
     const AgentNodeTime ant,      // Branch decision
     const bool prefer_branch_0    // Preferred branch direction
 );
-//SCIP_RETCODE
-//branch_on_wait(
-//    SCIP* scip,                   // SCIP
-//    const AgentTime at,           // Branch decision
-//    const bool prefer_branch_0    // Preferred branch direction
-//);
+SCIP_RETCODE
+branch_on_wait(
+    SCIP* scip,                   // SCIP
+    const AgentNodeTime ant,      // Branch decision
+    const bool prefer_branch_0    // Preferred branch direction
+);
 SCIP_RETCODE
 branch_on_length(
     SCIP* scip,                   // SCIP
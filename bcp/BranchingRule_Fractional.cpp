@@ -23,6 +23,7 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Includes.h"
 #include "ProblemData.h"
 #include "VariableData.h"
+#include "Pricer_TruffleHog.h"
 #ifdef USE_RECTANGLE_KNAPSACK_CONFLICTS
 #include "Separator_RectangleKnapsackConflicts.h"
 #endif
@@ -30,6 +31,9 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Separator_RectangleCliqueConflicts.h"
 #endif
 #include <numeric>
+#include <thread>
+
+#define MIN_BRANCH_CANDIDATES_PER_THREAD 256    // Minimum number of fractional columns scanned by each thread
 
 struct Score
 {
@@ -40,8 +44,8 @@ struct Score
 
 struct SuccessorDirection
 {
-    bool has_move{false};
-    bool has_wait{false};
+    SCIP_Real move_val{0.0};    // Value of the paths leaving a vertex
+    SCIP_Real wait_val{0.0};    // Value of the paths waiting at a vertex
 };
 
 struct GoalTimeBound
@@ -51,8 +55,75 @@ struct GoalTimeBound
     Time last;
 };
 
+// Add the vertices used by fractional columns in [begin, end) to the branching candidates
+static
+void add_lp_branch_candidates(
+    SCIP_VAR** candidate_vars,                                              // Fractional columns
+    const SCIP_Real* candidate_var_vals,                                    // Values of the fractional columns
+    const Int begin,                                                        // Index of the first column
+    const Int end,                                                          // One past the index of the last column
+    HashTable<NodeTime, Pair<Vector<Score>, Vector<Score>>>& candidates,    // Output candidate agent-time-nodes
+    HashTable<AgentNodeTime, SuccessorDirection>& succ_dirs,                // Output value of the paths leaving and waiting at a vertex
+    Vector<Int>& nb_paths                                                   // Output number of paths used by an agent
+)
+{
+    for (Int v = begin; v < end; ++v)
+    {
+        // Get the variable.
+        auto var = candidate_vars[v];
+        debug_assert(var);
+
+        // Proceed if not artificial variable.
+        auto vardata = SCIPvarGetData(var);
+        if (vardata)
+        {
+            // Get the path.
+            const auto a = SCIPvardataGetAgent(vardata);
+            const auto path_length = SCIPvardataGetPathLength(vardata);
+            const auto path = SCIPvardataGetPath(vardata);
+
+            // Get the variable value.
+            const auto var_val = candidate_var_vals[v];
+
+            // Update candidates data.
+            nb_paths[a]++;
+            for (Time t = 1; t < path_length; ++t)
+            {
+                // Store the candidate vertex.
+                const NodeTime nt{path[t].n, t};
+                auto& scores = candidates[nt].first;
+                auto it = std::find_if(scores.begin(),
+                                       scores.end(),
+                                       [a](const Score& score){ return score.a == a; });
+                if (it == scores.end())
+                {
+                    scores.push_back({a, var_val, path_length});
+                }
+                else
+                {
+                    auto& score = *it;
+                    score.val += var_val;
+                    if (path_length < score.shortest_path_length)
+                        score.shortest_path_length = path_length;
+                }
+
+                // Store the value of the paths leaving and waiting at the previous vertex.
+                auto& prev = succ_dirs[AgentNodeTime{a, path[t - 1].n, t - 1}];
+                if (path[t - 1].d == Direction::WAIT)
+                {
+                    prev.wait_val += var_val;
+                }
+                else
+                {
+                    prev.move_val += var_val;
+                }
+            }
+        }
+    }
+}
+
 Tuple<HashTable<NodeTime, Pair<Vector<Score>, Vector<Score>>>,
-      HashTable<AgentTime, SuccessorDirection>,
+      HashTable<AgentNodeTime, SuccessorDirection>,
       Vector<Int>,
       Vector<GoalTimeBound>>
 get_lp_branch_candidates(
@@ -63,7 +134,7 @@ get_lp_branch_candidates(
 {
     // Create output.
     Tuple<HashTable<NodeTime, Pair<Vector<Score>, Vector<Score>>>,
-          HashTable<AgentTime, SuccessorDirection>,
+          HashTable<AgentNodeTime, SuccessorDirection>,
           Vector<Int>,
           Vector<GoalTimeBound>> output;
     auto& [candidates, succ_dirs, nb_paths, goal_time_bounds] = output;
@@ -102,52 +173,87 @@ get_lp_branch_candidates(
         }
     }
 
-    // Calculate branching candidates.
+    // Calculate branching candidates. With many fractional columns, the columns are split into contiguous blocks
+    // scanned by the threads of the pricer. The tables of the blocks are merged in order of the blocks so that the
+    // agents of a vertex appear in the same order as in a serial scan.
     nb_paths.resize(N);
-    for (Int v = 0; v < nb_candidate_vars; ++v)
+    const auto nb_workers = std::max<Int>(1, std::min<Int>(SCIPpricerTruffleHogGetAStars(scip).size(),
+                                                           nb_candidate_vars / MIN_BRANCH_CANDIDATES_PER_THREAD));
+    if (nb_workers == 1)
     {
-        // Get the variable.
-        auto var = candidate_vars[v];
-        debug_assert(var);
-
-        // Proceed if not artificial variable.
-        auto vardata = SCIPvarGetData(var);
-        if (vardata)
+        add_lp_branch_candidates(candidate_vars,
+                                 candidate_var_vals,
+                                 0,
+                                 nb_candidate_vars,
+                                 candidates,
+                                 succ_dirs,
+                                 nb_paths);
+    }
+    else
+    {
+        // Scan the blocks in parallel. The first block is written to the output directly.
+        const auto block_size = (nb_candidate_vars + nb_workers - 1) / nb_workers;
+        Vector<HashTable<NodeTime, Pair<Vector<Score>, Vector<Score>>>> block_candidates(nb_workers - 1);
+        Vector<HashTable<AgentNodeTime, SuccessorDirection>> block_succ_dirs(nb_workers - 1);
+        Vector<Vector<Int>> block_nb_paths(nb_workers - 1, Vector<Int>(N));
+        Vector<std::thread> threads;
+        threads.reserve(nb_workers - 1);
+        for (Int idx = 1; idx < nb_workers; ++idx)
         {
-            // Get the path.
-            const auto a = SCIPvardataGetAgent(vardata);
-            const auto path_length = SCIPvardataGetPathLength(vardata);
-            const auto path = SCIPvardataGetPath(vardata);
-
-            // Get the variable value.
-            const auto var_val = candidate_var_vals[v];
+            threads.emplace_back(add_lp_branch_candidates,
+                                 candidate_vars,
+                                 candidate_var_vals,
+                                 idx * block_size,
+                                 std::min(nb_candidate_vars, (idx + 1) * block_size),
+                                 std::ref(block_candidates[idx - 1]),
+                                 std::ref(block_succ_dirs[idx - 1]),
+                                 std::ref(block_nb_paths[idx - 1]));
+        }
+        add_lp_branch_candidates(candidate_vars,
+                                 candidate_var_vals,
+                                 0,
+                                 std::min(nb_candidate_vars, block_size),
+                                 candidates,
+                                 succ_dirs,
+                                 nb_paths);
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
 
-            // Update candidates data.
-            nb_paths[a]++;
-            for (Time t = 1; t < path_length; ++t)
+        // Merge the blocks.
+        for (Int idx = 0; idx < nb_workers - 1; ++idx)
+        {
+            for (const auto& [nt, block_scores] : block_candidates[idx])
             {
-                // Store the candidate vertex.
-                const NodeTime nt{path[t].n, t};
                 auto& scores = candidates[nt].first;
-                auto it = std::find_if(scores.begin(),
-                                       scores.end(),
-                                       [a](const Score& score){ return score.a == a; });
-                if (it == scores.end())
+                for (const auto& block_score : block_scores.first)
                 {
-                    scores.push_back({a, var_val, path_length});
-                }
-                else
-                {
-                    auto& score = *it;
-                    score.val += var_val;
-                    if (path_length < score.shortest_path_length)
-                        score.shortest_path_length = path_length;
+                    auto it = std::find_if(scores.begin(),
+                                           scores.end(),
+                                           [a = block_score.a](const Score& score){ return score.a == a; });
+                    if (it == scores.end())
+                    {
+                        scores.push_back(block_score);
+                    }
+                    else
+                    {
+                        auto& score = *it;
+                        score.val += block_score.val;
+                        if (block_score.shortest_path_length < score.shortest_path_length)
+                            score.shortest_path_length = block_score.shortest_path_length;
+                    }
                 }
-
-                // Store whether the vertex is reached by waiting.
-                auto& prev = succ_dirs[AgentTime{{a, t - 1}}];
-                prev.has_move |= (path[t - 1].d != Direction::WAIT);
-                prev.has_wait |= (path[t - 1].d == Direction::WAIT);
+            }
+            for (const auto& [ant, block_succ_dir] : block_succ_dirs[idx])
+            {
+                auto& succ_dir = succ_dirs[ant];
+                succ_dir.move_val += block_succ_dir.move_val;
+                succ_dir.wait_val += block_succ_dir.wait_val;
+            }
+            for (Agent a = 0; a < N; ++a)
+            {
+                nb_paths[a] += block_nb_paths[idx][a];
             }
         }
     }
@@ -516,174 +622,165 @@ Pair<AgentNodeTime, bool> find_decision_early_goal(
     return {best_ant, prefer_branch_0};
 }
 
-//Pair<AgentTime, bool> find_decision_wait(
-//    SCIP* scip,                                             // SCIP
-//    SCIP_PROBDATA* probdata,                                // Problem data
-//    const HashTable<AgentTime, SuccessorDirection>& succ_dirs,    // Vertices with a wait
-//    const Vector<GoalTimeBound>& goal_time_bounds           // Earliest and latest time an agent reaches its goal
-//)
-//{
-//    // Create output.
-//    AgentTime best_at{-1, std::numeric_limits<Time>::max()};
-//    bool prefer_branch_0 = false;
-//
-//    // Get agent variables.
-//    auto agent_nvars = SCIPprobdataGetAgentNVars(probdata);
-//    auto agent_vars = SCIPprobdataGetAgentVars(probdata);
-//
-//    // Get rectangle constraints.
-//    const auto& rectangle_conflicts_conss = rectangle_conflicts_get_constraints(probdata);
-//
-//    // Find a wait decision.
-//    SCIP_Real best_lhs = 2.01;
-//    Time best_path_length = std::numeric_limits<Time>::max();
-//    for (const auto& conflict : rectangle_conflicts_conss)
-//    {
-//        // Get variables in this row.
-//        auto nvars = SCIProwGetNNonz(conflict.row);
-//        auto cols = SCIProwGetCols(conflict.row);
-//        auto coeffs = SCIProwGetVals(conflict.row);
-//
-//        // Check.
-//#ifdef DEBUG
-//        SCIP_Real tmp = 0.0;
-//        for (Count v = 0; v < agent_nvars[conflict.a1]; ++v)
-//        {
-//            auto var = agent_vars[conflict.a1][v];
-//            auto vardata = SCIPvarGetData(var);
-//            const auto a = SCIPvardataGetAgent(vardata);
-//            const auto path_length = SCIPvardataGetPathLength(vardata);
-//            const auto path = SCIPvardataGetPath(vardata);
-//            const auto var_val = SCIPgetSolVal(scip, nullptr, var);
-//
-//            SCIP_Real coeff = 0.0;
-//            for (auto [it, end] = conflict.agent_edges(a); it != end; ++it)
-//            {
-//                const auto& [t, e] = *it;
-//                if (t < path_length - 1 && path[t] == e)
-//                {
-//                    coeff++;
-//                }
-//            }
-//            tmp += coeff * var_val;
-//        }
-//        for (Count v = 0; v < agent_nvars[conflict.a2]; ++v)
-//        {
-//            auto var = agent_vars[conflict.a2][v];
-//            auto vardata = SCIPvarGetData(var);
-//            const auto a = SCIPvardataGetAgent(vardata);
-//            const auto path_length = SCIPvardataGetPathLength(vardata);
-//            const auto path = SCIPvardataGetPath(vardata);
-//            const auto var_val = SCIPgetSolVal(scip, nullptr, var);
-//
-//            SCIP_Real coeff = 0.0;
-//            for (auto [it, end] = conflict.agent_edges(a); it != end; ++it)
-//            {
-//                const auto& [t, e] = *it;
-//                if (t < path_length - 1 && path[t] == e)
-//                {
-//                    coeff++;
-//                }
-//            }
-//            tmp += coeff * var_val;
-//        }
-//#endif
-//
-//        // Compute LHS.
-//        SCIP_Real lhs = 0.0;
-//        for (auto v = 0; v < nvars; ++v)
-//        {
-//            // Check.
-//            debug_assert(coeffs[v] == 1 || coeffs[v] == 2);
-//
-//            // Sum.
-//            auto var = SCIPcolGetVar(cols[v]);
-//            const auto var_val = SCIPgetSolVal(scip, nullptr, var);
-//            lhs += var_val * coeffs[v];
-//        }
-//        debug_assert(SCIPisSumEQ(scip, lhs, tmp));
-//
-//        // Skip if the constraint is not binding.
-//        if (SCIPisSumLT(scip, lhs, best_lhs))
-//            continue;
-//
-//        // Loop through all columns of the row whose path crosses two boundaries.
-//        for (auto v = 0; v < nvars; ++v)
-//            if (coeffs[v] == 2)
-//            {
-//                // Get the variable value.
-//                auto var = SCIPcolGetVar(cols[v]);
-//                const auto var_val = SCIPgetSolVal(scip, nullptr, var);
-//
-//                // Find a wait.
-//                if (SCIPisPositive(scip, var_val))
-//                {
-//                    // Get the path.
-//                    auto vardata = SCIPvarGetData(var);
-//                    const auto a = SCIPvardataGetAgent(vardata);
-//                    const auto path_length = SCIPvardataGetPathLength(vardata);
-//                    const auto path = SCIPvardataGetPath(vardata);
-//
-//                    // Don't consider longer paths.
-//                    if (path_length > best_path_length)
-//                        continue;
-//
-//                    // Find the time of entry and exit from the rectangle.
-//                    Time entry = -1, exit = -1;
-//                    auto [it, out_begin, out_end] = conflict.agent_in_out_edges(a);
-//                    for (; it != out_begin; ++it)
-//                    {
-//                        const auto& [t, e] = *it;
-//                        if (t < path_length - 1 && path[t] == e)
-//                        {
-//                            entry = t;
-//                            break;
-//                        }
-//                    }
-//                    for (it = out_begin; it != out_end; ++it)
-//                    {
-//                        const auto& [t, e] = *it;
-//                        if (t < path_length - 1 && path[t] == e)
-//                        {
-//                            exit = t;
-//                            break;
-//                        }
-//                    }
-//                    release_assert(entry >= 0 && exit > entry);
-//
-//                    // Find a wait between the entry and exit times.
-//                    for (Time t = entry; t < std::min(exit, best_at.t); ++t)
-//                    {
-//                        const AgentTime at{a, t};
-//                        auto it = succ_dirs.find(at);
-//                        if (it != succ_dirs.end() &&
-//                            it->second.has_move && it->second.has_wait)
-//                        {
-//                            best_lhs = lhs;
-//                            best_path_length = path_length;
-//                            best_at = at;
-//                        }
-//                    }
-//                }
-//            }
-//    }
-//#ifdef PRINT_DEBUG
-//    if (best_at.a >= 0)
-//    {
-//        debugln("   Selected decision as wait");
-//    }
-//#endif
-//
-//    // Return.
-//    return {best_at, prefer_branch_0};
-//}
+// Choose an agent that both waits at and leaves a vertex in the fractional paths. The decision splits the paths at
+// the vertex into the paths that wait and the paths that move, which separates an agent oscillating between waiting
+// and moving in one branch where vertex branching needs a chain of decisions. The most balanced split is chosen and
+// ties are broken by the earliest time.
+Pair<AgentNodeTime, bool> find_decision_wait(
+    SCIP* scip,                                                       // SCIP
+    SCIP_ProbData* probdata,                                          // Problem data
+    const HashTable<AgentNodeTime, SuccessorDirection>& succ_dirs     // Value of the paths leaving and waiting at a vertex
+)
+{
+    // Create output.
+    AgentNodeTime best_ant{-1, 0, std::numeric_limits<Time>::max()};
+    bool prefer_branch_0 = false;
+
+    // Find the vertex with the most balanced split. Waits at the goal of the agent are left to the length branching
+    // decisions because a path that has finished waits at its goal, which the low-level solver cannot express.
+    const auto& agents = SCIPprobdataGetAgentsData(probdata);
+    SCIP_Real best_val = 0.0;
+    for (const auto& [ant, succ_dir] : succ_dirs)
+    {
+        if (ant.n == agents[ant.a].goal)
+        {
+            continue;
+        }
+        const auto val = std::min(succ_dir.move_val, succ_dir.wait_val);
+        if (SCIPisPositive(scip, val) &&
+            (SCIPisGT(scip, val, best_val) || (SCIPisEQ(scip, val, best_val) && ant.t < best_ant.t)))
+        {
+            best_ant = ant;
+            best_val = val;
+            prefer_branch_0 = succ_dir.move_val > succ_dir.wait_val;
+        }
+    }
+    if (best_ant.a >= 0)
+    {
+        debugln("   Selected decision as wait");
+    }
+
+    // Return.
+    return {best_ant, prefer_branch_0};
+}
+
+// Choose a vertex by the gains in the bound estimated for the children. The agent of a candidate with reliable
+// pseudocosts is estimated by its pseudocosts. Otherwise, the agent is solved again in each child with the inputs of
+// its last run, and the reduced cost of its best path in the child times the value of the paths that become
+// infeasible approximates the increase in the bound of the child. Only the best candidates of the default rule are
+// solved again, and every candidate is estimated by its pseudocosts if none are solved again.
+Pair<AgentNodeTime, bool> find_decision_vertex_by_score(
+    SCIP* scip,                                                                   // SCIP
+    const HashTable<NodeTime, Pair<Vector<Score>, Vector<Score>>>& candidates,    // Candidate agent-time-nodes
+    const Vector<GoalTimeBound>& goal_time_bounds,                                // Earliest and latest time an agent reaches its goal
+    const Vector<Int>& nb_paths,                                                  // Number of paths used by an agent
+    const Int lookahead,                                                          // Number of candidates to solve again
+    const bool use_pseudocosts                                                    // Indicates if the pseudocosts are used
+)
+{
+    // Collect the integer vertices, or the fractional vertices if there are no integer vertices.
+    Vector<Pair<AgentNodeTime, Score>> list;
+    for (const auto& [nt, scores] : candidates)
+        for (const auto& score : scores.first)
+        {
+            list.push_back({AgentNodeTime{score.a, nt.n, nt.t}, score});
+        }
+    if (list.empty())
+    {
+        for (const auto& [nt, scores] : candidates)
+            for (const auto& score : scores.second)
+            {
+                list.push_back({AgentNodeTime{score.a, nt.n, nt.t}, score});
+            }
+    }
+    if (list.empty())
+    {
+        return {AgentNodeTime{}, false};
+    }
+
+    // Keep the best candidates in the order of the default rule.
+    if (lookahead > 0)
+    {
+        const auto key = [&](const Pair<AgentNodeTime, Score>& candidate)
+        {
+            const auto& [ant, score] = candidate;
+            const auto diff = goal_time_bounds[ant.a].last - goal_time_bounds[ant.a].first;
+            return std::make_tuple(-diff, -nb_paths[ant.a], score.shortest_path_length, ant.t, -score.val);
+        };
+        const auto nb_candidates = std::min<size_t>(lookahead, list.size());
+        std::partial_sort(list.begin(), list.begin() + nb_candidates, list.end(), [&](const auto& x, const auto& y)
+        {
+            return key(x) < key(y);
+        });
+        list.resize(nb_candidates);
+    }
+
+    // Estimate the gains per unit of change from the pseudocosts.
+    Vector<Pair<SCIP_Real, SCIP_Real>> unit_gains(list.size(), Pair<SCIP_Real, SCIP_Real>{0.0, 0.0});
+    Vector<AgentNodeTime> decisions;
+    Vector<size_t> decision_candidates;
+    for (size_t idx = 0; idx < list.size(); ++idx)
+    {
+        const auto ant = list[idx].first;
+        bool reliable = false;
+        if (use_pseudocosts)
+        {
+            unit_gains[idx] = branching_get_vertex_pseudocosts(scip, ant, reliable);
+        }
+        if (lookahead > 0 && !reliable)
+        {
+            decisions.push_back(ant);
+            decision_candidates.push_back(idx);
+        }
+    }
+
+    // Estimate the reduced cost of the agent in the children of the unreliable candidates.
+    if (!decisions.empty())
+    {
+        const auto costs = SCIPpricerTruffleHogLookahead(scip, decisions);
+        for (size_t idx = 0; idx < decisions.size(); ++idx)
+        {
+            const auto [forbid_cost, use_cost] = costs[idx];
+            unit_gains[decision_candidates[idx]] = {std::max(forbid_cost, 0.0), std::max(use_cost, 0.0)};
+        }
+    }
+
+    // Choose the candidate with the best product of the gains. The paths using the vertex become infeasible in the
+    // child forbidding the vertex, and the other paths of the agent become infeasible in the child using the vertex.
+    AgentNodeTime best_ant;
+    bool prefer_branch_0 = false;
+    SCIP_Real best_score = SCIPgetBranchScore(scip, nullptr, 0.0, 0.0);
+    for (size_t idx = 0; idx < list.size(); ++idx)
+    {
+        const auto& [ant, score] = list[idx];
+        const auto [forbid_unit_gain, use_unit_gain] = unit_gains[idx];
+        const auto forbid_gain = std::min(forbid_unit_gain, SCIPinfinity(scip)) * score.val;
+        const auto use_gain = std::min(use_unit_gain, SCIPinfinity(scip)) * (1.0 - score.val);
+        const auto branch_score = SCIPgetBranchScore(scip, nullptr, forbid_gain, use_gain);
+        debugln("   Estimated agent {}, vertex {}, time {}: forbid gain {:.4f}, use gain {:.4f}, score {:.4f}",
+                ant.a, ant.n, ant.t, forbid_gain, use_gain, branch_score);
+        if (branch_score > best_score)
+        {
+            best_score = branch_score;
+            best_ant = ant;
+            prefer_branch_0 = forbid_gain < use_gain;
+        }
+    }
+    if (best_ant.a >= 0)
+    {
+        debugln("   Selected decision by estimated gains");
+    }
+    return {best_ant, prefer_branch_0};
+}
 
 Pair<AgentNodeTime, bool> find_decision_vertex(
     SCIP* scip,                                                                   // SCIP
     SCIP_PROBDATA* probdata,                                                      // Problem data
     const HashTable<NodeTime, Pair<Vector<Score>, Vector<Score>>>& candidates,    // Candidate agent-time-nodes
     const Vector<GoalTimeBound>& goal_time_bounds,                                // Earliest and latest time an agent reaches its goal
-    const Vector<Int>& nb_paths                                                   // Number of paths used by an agent
+    const Vector<Int>& nb_paths,                                                  // Number of paths used by an agent
+    const Int lookahead,                                                          // Number of candidates to evaluate by re-pricing
+    const bool use_pseudocosts                                                    // Indicates if the pseudocosts are used
 )
 {
     // Create output.
@@ -1002,6 +1099,17 @@ Pair<AgentNodeTime, bool> find_decision_vertex(
     }
 #endif
 
+    // Choose by the gains in the bound estimated for the children.
+    if (lookahead > 0 || use_pseudocosts)
+    {
+        const auto [ant, prefer_branch_0] =
+            find_decision_vertex_by_score(scip, candidates, goal_time_bounds, nb_paths, lookahead, use_pseudocosts);
+        if (ant.a >= 0)
+        {
+            return {ant, prefer_branch_0};
+        }
+    }
+
     // Prefer a vertex allowing an agent to reach its goal the earliest.
     Time best_diff = 0;
     Int best_nb_paths = 0;
@@ -1116,9 +1224,17 @@ SCIP_RETCODE branch_lp(
 
     // Attempt to branch on finishing early.
     {
-        const auto [ant, prefer_branch_0] = find_decision_early_goal(scip, probdata, N, goal_time_bounds);
+        auto [ant, prefer_branch_0] = find_decision_early_goal(scip, probdata, N, goal_time_bounds);
         if (ant.a >= 0)
         {
+            // Explore the child with the smaller expected gain first if its pseudocosts are reliable.
+            bool reliable;
+            const auto [leq_gain, geq_gain] = branching_get_length_pseudocosts(scip, ant.a, reliable);
+            if (reliable)
+            {
+                prefer_branch_0 = leq_gain < geq_gain;
+            }
+
             debug_assert(ant.t >= 0);
             branch_on_length(scip, ant, prefer_branch_0);
             goto DONE;
@@ -1126,19 +1242,29 @@ SCIP_RETCODE branch_lp(
     }
 
     // Attempt to branch on waits.
-//    {
-//        const auto [at, prefer_branch_0] = find_decision_wait(scip, probdata, succ_dirs, goal_time_bounds);
-//        if (at.a >= 0)
-//        {
-//            debug_assert(at.t >= 0);
-//            branch_on_wait(scip, at, prefer_branch_0);
-//            goto DONE;
-//        }
-//    }
+    {
+        SCIP_Bool wait_branching;
+        SCIP_CALL(SCIPgetBoolParam(scip, BRANCHING_WAIT_PARAM, &wait_branching));
+        if (wait_branching)
+        {
+            const auto [ant, prefer_branch_0] = find_decision_wait(scip, probdata, succ_dirs);
+            if (ant.a >= 0)
+            {
+                debug_assert(ant.t >= 0);
+                branch_on_wait(scip, ant, prefer_branch_0);
+                goto DONE;
+            }
+        }
+    }
 
     // Attempt to branch on vertices.
     {
-        const auto [ant, prefer_branch_0] = find_decision_vertex(scip, probdata, candidates, goal_time_bounds, nb_paths);
+        int lookahead;
+        int reliability;
+        SCIP_CALL(SCIPgetIntParam(scip, BRANCHING_LOOKAHEAD_PARAM, &lookahead));
+        SCIP_CALL(SCIPgetIntParam(scip, BRANCHING_RELIABILITY_PARAM, &reliability));
+        const auto [ant, prefer_branch_0] =
+            find_decision_vertex(scip, probdata, candidates, goal_time_bounds, nb_paths, lookahead, reliability > 0);
         if (ant.a >= 0)
         {
             debug_assert(ant.t > 0);
@@ -85,7 +85,7 @@ SCIP_RETCODE branch_pseudosolution(
     const auto candidates = get_pseudosolution_branch_candidates(scip);
 
     // Pick a vertex that hasn't been branched on before.
-    for (const auto [ant, count] : candidates)
+    for (const auto& [ant, count] : candidates)
     {
         // Loop through decisions in ancestors of this node.
         for (Int c = 0; c < n_vertex_branching_conss; ++c)
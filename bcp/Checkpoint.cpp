@@ -0,0 +1,445 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#include "Checkpoint.h"
+#include "ProblemData.h"
+#include "VariableData.h"
+#include "Pricer_TruffleHog.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#define EVENTHDLR_NAME "mapf_checkpoint"
+#define EVENTHDLR_DESC "Checkpoint of the columns, the incumbent and the pricing priorities"
+
+#define DEFAULT_CHECKPOINT_FILE ""          // File to write checkpoints to (empty to disable)
+#define DEFAULT_CHECKPOINT_INTERVAL 600.0   // Seconds between checkpoints
+
+#define CHECKPOINT_MAGIC (0x3143504d46504342ULL)    // "BCPFMPC1"
+
+struct CheckpointData
+{
+    std::chrono::steady_clock::time_point last_checkpoint;    // Time of the last checkpoint
+    Vector<SCIP_Real> price_priority;                         // Pricing priorities read from a checkpoint
+};
+
+// Write a value to a binary file
+template<class T>
+static void write_value(FILE* f, const T& value)
+{
+    release_assert(fwrite(&value, sizeof(T), 1, f) == 1, "Failed to write checkpoint");
+}
+
+// Read a value from a binary file
+template<class T>
+static T read_value(FILE* f)
+{
+    T value;
+    release_assert(fread(&value, sizeof(T), 1, f) == 1, "Checkpoint is truncated");
+    return value;
+}
+
+// Write a checkpoint to file
+SCIP_RETCODE write_checkpoint(
+    SCIP* scip,                                // SCIP
+    const std::filesystem::path& filename      // Output file
+)
+{
+    // Check.
+    debug_assert(scip);
+
+    // Get problem data.
+    auto probdata = SCIPgetProbData(scip);
+    const auto N = SCIPprobdataGetN(probdata);
+    const auto& vars = SCIPprobdataGetVars(probdata);
+
+    // Write to a temporary file and then replace the previous checkpoint so a checkpoint is never left incomplete.
+    auto tmp_filename = filename;
+    tmp_filename += ".tmp";
+    auto f = fopen(tmp_filename.c_str(), "wb");
+    release_assert(f, "Failed to create checkpoint file {}", tmp_filename.string());
+
+    // Write header.
+    write_value<uint64_t>(f, CHECKPOINT_MAGIC);
+    write_value<int32_t>(f, N);
+
+    // Write columns.
+    HashTable<SCIP_VAR*, int64_t> var_index;
+    write_value<uint64_t>(f, vars.size());
+    for (const auto& [var, _] : vars)
+    {
+        auto vardata = SCIPvarGetData(var);
+        const auto a = SCIPvardataGetAgent(vardata);
+        const auto path_length = SCIPvardataGetPathLength(vardata);
+        const auto path = SCIPvardataGetPath(vardata);
+        write_value<int32_t>(f, a);
+        write_value<int32_t>(f, path_length);
+        release_assert(fwrite(path, sizeof(Edge), path_length, f) == static_cast<size_t>(path_length),
+                       "Failed to write checkpoint");
+        var_index.emplace(var, var_index.size());
+    }
+
+    // Write the column of each agent in the incumbent.
+    Vector<int64_t> incumbent(N, -1);
+    if (auto sol = SCIPgetBestSol(scip); sol && SCIPgetSolOrigObj(scip, sol) < ARTIFICIAL_VAR_COST)
+    {
+        for (const auto& [var, _] : vars)
+            if (SCIPisPositive(scip, SCIPgetSolVal(scip, sol, var)))
+            {
+                incumbent[SCIPvardataGetAgent(SCIPvarGetData(var))] = var_index[var];
+            }
+    }
+    const bool has_incumbent = std::find(incumbent.begin(), incumbent.end(), -1) == incumbent.end();
+    write_value<uint8_t>(f, has_incumbent);
+    if (has_incumbent)
+    {
+        release_assert(fwrite(incumbent.data(), sizeof(int64_t), N, f) == static_cast<size_t>(N),
+                       "Failed to write checkpoint");
+    }
+
+    // Write pricing priorities.
+    const auto price_priority = SCIPpricerTruffleHogGetPricePriority(scip);
+    write_value<uint8_t>(f, !price_priority.empty());
+    if (!price_priority.empty())
+    {
+        release_assert(fwrite(price_priority.data(), sizeof(SCIP_Real), N, f) == static_cast<size_t>(N),
+                       "Failed to write checkpoint");
+    }
+
+    // Replace the previous checkpoint.
+    fclose(f);
+    std::filesystem::rename(tmp_filename, filename);
+    debugln("Wrote checkpoint with {} columns to {}", vars.size(), filename.string());
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Add the columns and the incumbent of a checkpoint to the problem
+SCIP_RETCODE read_checkpoint(
+    SCIP* scip,                                // SCIP
+    const std::filesystem::path& filename      // Input file
+)
+{
+    // Check.
+    debug_assert(scip);
+    debug_assert(SCIPgetStage(scip) == SCIP_STAGE_PROBLEM);
+
+    // Get problem data.
+    auto probdata = SCIPgetProbData(scip);
+    const auto N = SCIPprobdataGetN(probdata);
+
+    // Open file.
+    auto f = fopen(filename.c_str(), "rb");
+    release_assert(f, "Failed to open checkpoint file {}", filename.string());
+
+    // Read header.
+    release_assert(read_value<uint64_t>(f) == CHECKPOINT_MAGIC, "{} is not a checkpoint", filename.string());
+    const auto nb_agents = read_value<int32_t>(f);
+    release_assert(nb_agents == N, "Checkpoint has {} agents but the instance has {} agents", nb_agents, N);
+
+    // Read columns.
+    const auto nb_vars = read_value<uint64_t>(f);
+    Vector<SCIP_VAR*> vars(nb_vars, nullptr);
+    Vector<Edge> path;
+    for (auto& var : vars)
+    {
+        const auto a = read_value<int32_t>(f);
+        const auto path_length = read_value<int32_t>(f);
+        release_assert(0 <= a && a < N && path_length >= 1, "Checkpoint is corrupted");
+        path.resize(path_length);
+        release_assert(fread(path.data(), sizeof(Edge), path_length, f) == static_cast<size_t>(path_length),
+                       "Checkpoint is truncated");
+        SCIP_CALL(SCIPprobdataAddInitialVar(scip, probdata, a, path_length, path.data(), &var));
+        debug_assert(var);
+    }
+
+    // Read the incumbent.
+    if (read_value<uint8_t>(f))
+    {
+        SCIP_SOL* sol;
+        SCIP_CALL(SCIPcreateSol(scip, &sol, nullptr));
+        for (Agent a = 0; a < N; ++a)
+        {
+            const auto idx = read_value<int64_t>(f);
+            release_assert(0 <= idx && idx < static_cast<int64_t>(nb_vars), "Checkpoint is corrupted");
+            SCIP_CALL(SCIPsetSolVal(scip, sol, vars[idx], 1.0));
+        }
+        SCIP_Bool stored;
+        SCIP_CALL(SCIPaddSolFree(scip, &sol, &stored));
+    }
+
+    // Read pricing priorities. They are set once the pricer is initialized.
+    if (read_value<uint8_t>(f))
+    {
+        auto eventhdlr = SCIPfindEventhdlr(scip, EVENTHDLR_NAME);
+        debug_assert(eventhdlr);
+        auto eventhdlrdata = reinterpret_cast<CheckpointData*>(SCIPeventhdlrGetData(eventhdlr));
+        debug_assert(eventhdlrdata);
+        eventhdlrdata->price_priority.resize(N);
+        release_assert(fread(eventhdlrdata->price_priority.data(), sizeof(SCIP_Real), N, f) == static_cast<size_t>(N),
+                       "Checkpoint is truncated");
+    }
+
+    // Close file.
+    fclose(f);
+    debugln("Read checkpoint with {} columns from {}", nb_vars, filename.string());
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Copy the columns of the problem
+Vector<CheckpointColumn> save_columns(
+    SCIP* scip    // SCIP
+)
+{
+    // Check.
+    debug_assert(scip);
+
+    // Get problem data.
+    auto probdata = SCIPgetProbData(scip);
+    const auto& vars = SCIPprobdataGetVars(probdata);
+
+    // Copy the paths.
+    Vector<CheckpointColumn> columns;
+    columns.reserve(vars.size());
+    for (const auto& [var, _] : vars)
+    {
+        auto vardata = SCIPvarGetData(var);
+        const auto path_length = SCIPvardataGetPathLength(vardata);
+        const auto path = SCIPvardataGetPath(vardata);
+        columns.push_back({SCIPvardataGetAgent(vardata), Vector<Edge>(path, path + path_length)});
+    }
+    return columns;
+}
+
+// Add columns of a problem with the same agents or a superset of the agents as initial columns
+SCIP_RETCODE restore_columns(
+    SCIP* scip,                                  // SCIP
+    const Vector<CheckpointColumn>& columns      // Columns
+)
+{
+    // Check.
+    debug_assert(scip);
+    debug_assert(SCIPgetStage(scip) == SCIP_STAGE_PROBLEM);
+
+    // Get problem data.
+    auto probdata = SCIPgetProbData(scip);
+    const auto N = SCIPprobdataGetN(probdata);
+
+    // Add the columns.
+    for (const auto& [a, path] : columns)
+    {
+        release_assert(a < N, "Column of agent {} is not in the problem with {} agents", a, N);
+        SCIP_VAR* var = nullptr;
+        SCIP_CALL(SCIPprobdataAddInitialVar(scip, probdata, a, path.size(), path.data(), &var));
+        debug_assert(var);
+    }
+    debugln("Added {} columns from a previous problem", columns.size());
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Shift the columns of a previous problem to start a number of timesteps later
+Vector<CheckpointColumn> shift_columns(
+    const Vector<CheckpointColumn>& columns,    // Columns of the previous problem
+    const Time offset,                          // Number of timesteps to remove from the start of the paths
+    const AgentsData& agents                    // Agents of the new problem
+)
+{
+    // Check.
+    debug_assert(offset >= 0);
+
+    // Cut the start of the paths that pass through the new start of their agent.
+    Vector<CheckpointColumn> shifted;
+    for (const auto& [a, path] : columns)
+        if (a < agents.size() && !path.empty() && path.back().n == agents[a].goal)
+        {
+            const auto t = std::min<Time>(offset, path.size() - 1);
+            if (path[t].n == agents[a].start)
+            {
+                shifted.push_back({a, Vector<Edge>(path.begin() + t, path.end())});
+            }
+        }
+
+    // Remove duplicates.
+    const auto less = [](const CheckpointColumn& lhs, const CheckpointColumn& rhs)
+    {
+        return lhs.a < rhs.a ||
+               (lhs.a == rhs.a && std::lexicographical_compare(lhs.path.begin(), lhs.path.end(),
+                                                               rhs.path.begin(), rhs.path.end(),
+                                                               [](const Edge x, const Edge y) { return x.id < y.id; }));
+    };
+    const auto equal = [](const CheckpointColumn& lhs, const CheckpointColumn& rhs)
+    {
+        return lhs.a == rhs.a && lhs.path == rhs.path;
+    };
+    std::sort(shifted.begin(), shifted.end(), less);
+    shifted.erase(std::unique(shifted.begin(), shifted.end(), equal), shifted.end());
+    debugln("Shifted {} of {} columns by {} timesteps", shifted.size(), columns.size(), offset);
+    return shifted;
+}
+
+// Initialize event handler at the start of the solve
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_EVENTINITSOL(eventInitsolCheckpoint)
+{
+    // Get event handler data.
+    auto eventhdlrdata = reinterpret_cast<CheckpointData*>(SCIPeventhdlrGetData(eventhdlr));
+    debug_assert(eventhdlrdata);
+    eventhdlrdata->last_checkpoint = std::chrono::steady_clock::now();
+
+    // Restore the pricing priorities of a checkpoint.
+    if (!eventhdlrdata->price_priority.empty())
+    {
+        SCIPpricerTruffleHogSetPricePriority(scip, eventhdlrdata->price_priority);
+        eventhdlrdata->price_priority.clear();
+    }
+
+    // Catch the end of every node if checkpoints are written.
+    char* filename;
+    SCIP_CALL(SCIPgetStringParam(scip, CHECKPOINT_FILE_PARAM, &filename));
+    if (filename[0] != '\0')
+    {
+        SCIP_CALL(SCIPcatchEvent(scip, SCIP_EVENTTYPE_NODESOLVED, eventhdlr, nullptr, nullptr));
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Deinitialize event handler at the end of the solve
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_EVENTEXITSOL(eventExitsolCheckpoint)
+{
+    char* filename;
+    SCIP_CALL(SCIPgetStringParam(scip, CHECKPOINT_FILE_PARAM, &filename));
+    if (filename[0] != '\0')
+    {
+        SCIP_CALL(SCIPdropEvent(scip, SCIP_EVENTTYPE_NODESOLVED, eventhdlr, nullptr, -1));
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Write a checkpoint after a node if the interval has passed
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_EVENTEXEC(eventExecCheckpoint)
+{
+    // Get event handler data.
+    auto eventhdlrdata = reinterpret_cast<CheckpointData*>(SCIPeventhdlrGetData(eventhdlr));
+    debug_assert(eventhdlrdata);
+
+    // Check the interval.
+    SCIP_Real interval;
+    SCIP_CALL(SCIPgetRealParam(scip, CHECKPOINT_INTERVAL_PARAM, &interval));
+    const auto now = std::chrono::steady_clock::now();
+    if (std::chrono::duration<SCIP_Real>(now - eventhdlrdata->last_checkpoint).count() < interval)
+    {
+        return SCIP_OKAY;
+    }
+
+    // Write.
+    char* filename;
+    SCIP_CALL(SCIPgetStringParam(scip, CHECKPOINT_FILE_PARAM, &filename));
+    SCIP_CALL(write_checkpoint(scip, filename));
+    eventhdlrdata->last_checkpoint = std::chrono::steady_clock::now();
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Free event handler
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_EVENTFREE(eventFreeCheckpoint)
+{
+    auto eventhdlrdata = reinterpret_cast<CheckpointData*>(SCIPeventhdlrGetData(eventhdlr));
+    debug_assert(eventhdlrdata);
+    eventhdlrdata->~CheckpointData();
+    SCIPfreeBlockMemory(scip, &eventhdlrdata);
+    SCIPeventhdlrSetData(eventhdlr, nullptr);
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Include the checkpoint event handler
+SCIP_RETCODE SCIPincludeEventhdlrCheckpoint(
+    SCIP* scip    // SCIP
+)
+{
+    // Create event handler data.
+    CheckpointData* eventhdlrdata = nullptr;
+    SCIP_CALL(SCIPallocBlockMemory(scip, &eventhdlrdata));
+    debug_assert(eventhdlrdata);
+    new (eventhdlrdata) CheckpointData;
+
+    // Include event handler.
+    SCIP_EVENTHDLR* eventhdlr = nullptr;
+    SCIP_CALL(SCIPincludeEventhdlrBasic(scip,
+                                        &eventhdlr,
+                                        EVENTHDLR_NAME,
+                                        EVENTHDLR_DESC,
+                                        eventExecCheckpoint,
+                                        reinterpret_cast<SCIP_EVENTHDLRDATA*>(eventhdlrdata)));
+    debug_assert(eventhdlr);
+
+    // Set callbacks.
+    SCIP_CALL(SCIPsetEventhdlrInitsol(scip, eventhdlr, eventInitsolCheckpoint));
+    SCIP_CALL(SCIPsetEventhdlrExitsol(scip, eventhdlr, eventExitsolCheckpoint));
+    SCIP_CALL(SCIPsetEventhdlrFree(scip, eventhdlr, eventFreeCheckpoint));
+
+    // Add parameters.
+    SCIP_CALL(SCIPaddStringParam(scip,
+                                 CHECKPOINT_FILE_PARAM,
+                                 "file to periodically write a checkpoint to (empty to disable)",
+                                 nullptr,
+                                 FALSE,
+                                 DEFAULT_CHECKPOINT_FILE,
+                                 nullptr,
+                                 nullptr));
+    SCIP_CALL(SCIPaddRealParam(scip,
+                               CHECKPOINT_INTERVAL_PARAM,
+                               "number of seconds between checkpoints",
+                               nullptr,
+                               FALSE,
+                               DEFAULT_CHECKPOINT_INTERVAL,
+                               0.0,
+                               SCIP_REAL_MAX,
+                               nullptr,
+                               nullptr));
+
+    // Done.
+    return SCIP_OKAY;
+}
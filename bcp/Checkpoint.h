@@ -0,0 +1,76 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#ifndef MAPF_CHECKPOINT_H
+#define MAPF_CHECKPOINT_H
+
+#include "Includes.h"
+#include "trufflehog/AgentsData.h"
+#include <filesystem>
+
+#define CHECKPOINT_FILE_PARAM "mapf/checkpoint/file"
+#define CHECKPOINT_INTERVAL_PARAM "mapf/checkpoint/interval"
+
+// Include the event handler that periodically writes a checkpoint of the columns, the incumbent and the pricing
+// priorities
+SCIP_RETCODE SCIPincludeEventhdlrCheckpoint(
+    SCIP* scip    // SCIP
+);
+
+// Write a checkpoint to file
+SCIP_RETCODE write_checkpoint(
+    SCIP* scip,                                // SCIP
+    const std::filesystem::path& filename      // Output file
+);
+
+// Add the columns and the incumbent of a checkpoint to the problem. The pricing priorities are restored when the
+// solve starts.
+SCIP_RETCODE read_checkpoint(
+    SCIP* scip,                                // SCIP
+    const std::filesystem::path& filename      // Input file
+);
+
+// Column kept in memory across problems
+struct CheckpointColumn
+{
+    Agent a;              // Agent
+    Vector<Edge> path;    // Path
+};
+
+// Copy the columns of the problem
+Vector<CheckpointColumn> save_columns(
+    SCIP* scip    // SCIP
+);
+
+// Add columns of a problem with the same agents or a superset of the agents as initial columns
+SCIP_RETCODE restore_columns(
+    SCIP* scip,                                  // SCIP
+    const Vector<CheckpointColumn>& columns      // Columns
+);
+
+// Shift the columns of a previous problem to start a number of timesteps later. Only the columns at the new start
+// of their agent at that time and ending at its goal are kept, without duplicates. Agents wait at their goal after
+// the end of their path.
+Vector<CheckpointColumn> shift_columns(
+    const Vector<CheckpointColumn>& columns,    // Columns of the previous problem
+    const Time offset,                          // Number of timesteps to remove from the start of the paths
+    const AgentsData& agents                    // Agents of the new problem
+);
+
+#endif
@@ -0,0 +1,194 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#ifndef MAPF_CONFLICTTABLE_H
+#define MAPF_CONFLICTTABLE_H
+
+#include "Includes.h"
+#include "Coordinates.h"
+
+// Sums of the column values on every node-time or edge-time. The sums are stored in one dense layer of entries per
+// timestep instead of a hash table. The storage is reused across separation rounds and only the entries used in the
+// last round are cleared.
+template<class Key>
+class ConflictTable
+{
+    static_assert(std::is_same_v<Key, NodeTime> || std::is_same_v<Key, EdgeTime>);
+    static constexpr Int nb_entries_per_node = std::is_same_v<Key, NodeTime> ? 1 : 5;
+
+    size_t layer_size_;
+    Vector<SCIP_Real> sums_;
+    Vector<size_t> used_;
+
+  public:
+    class Iterator
+    {
+        const ConflictTable* table_;
+        const size_t* it_;
+
+      public:
+        Iterator(const ConflictTable* table, const size_t* it) : table_(table), it_(it) {}
+        inline Pair<Key, SCIP_Real> operator*() const { return {table_->key(*it_), table_->sums_[*it_]}; }
+        inline Iterator& operator++() { ++it_; return *this; }
+        inline bool operator!=(const Iterator& other) const { return it_ != other.it_; }
+    };
+
+    // Constructors
+    ConflictTable() : layer_size_(0), sums_(), used_() {}
+    ConflictTable(const ConflictTable&) = delete;
+    ConflictTable(ConflictTable&&) = delete;
+    ConflictTable& operator=(const ConflictTable&) = delete;
+    ConflictTable& operator=(ConflictTable&&) = delete;
+    ~ConflictTable() = default;
+
+    // Clear the sums and resize for a map and makespan
+    void reset(const Node nb_nodes, const Time makespan)
+    {
+        for (const auto idx : used_)
+        {
+            sums_[idx] = 0.0;
+        }
+        used_.clear();
+        layer_size_ = static_cast<size_t>(nb_nodes) * nb_entries_per_node;
+        const auto size = layer_size_ * makespan;
+        if (sums_.size() < size)
+        {
+            sums_.resize(size, 0.0);
+        }
+    }
+
+    // Get the sum of an entry for summing a positive value
+    inline SCIP_Real& operator[](const Key key)
+    {
+        const auto idx = index(key);
+        debug_assert(idx < sums_.size());
+        auto& sum = sums_[idx];
+        if (sum == 0.0)
+        {
+            used_.push_back(idx);
+        }
+        return sum;
+    }
+
+    // Get the sum of an entry
+    inline SCIP_Real get(const Key key) const
+    {
+        const auto idx = index(key);
+        return idx < sums_.size() ? sums_[idx] : 0.0;
+    }
+
+    // Iterate over the used entries
+    inline Iterator begin() const { return Iterator(this, used_.data()); }
+    inline Iterator end() const { return Iterator(this, used_.data() + used_.size()); }
+
+  private:
+    inline size_t index(const NodeTime nt) const
+    {
+        return nt.t * layer_size_ + nt.n;
+    }
+    inline size_t index(const EdgeTime et) const
+    {
+        return et.t * layer_size_ + et.n * nb_entries_per_node + et.d;
+    }
+    inline Key key(const size_t idx) const
+    {
+        const Time t = idx / layer_size_;
+        const Node offset = idx % layer_size_;
+        if constexpr (std::is_same_v<Key, NodeTime>)
+        {
+            return NodeTime{offset, t};
+        }
+        else
+        {
+            return EdgeTime{offset / nb_entries_per_node, static_cast<Direction>(offset % nb_entries_per_node), t};
+        }
+    }
+};
+
+// Bitmap over every node-time or edge-time for checking that the paths of an integral solution do not share an entry.
+// The storage is reused across checks and only the words set in the last check are cleared.
+template<class Key>
+class ConflictBitmap
+{
+    static_assert(std::is_same_v<Key, NodeTime> || std::is_same_v<Key, EdgeTime>);
+    static constexpr Int nb_entries_per_node = std::is_same_v<Key, NodeTime> ? 1 : 5;
+    using Word = uint64_t;
+    static constexpr size_t WORD_BITS = sizeof(Word) * CHAR_BIT;
+
+    size_t layer_size_;
+    Vector<Word> words_;
+    Vector<size_t> used_;
+
+  public:
+    // Constructors
+    ConflictBitmap() : layer_size_(0), words_(), used_() {}
+    ConflictBitmap(const ConflictBitmap&) = delete;
+    ConflictBitmap(ConflictBitmap&&) = delete;
+    ConflictBitmap& operator=(const ConflictBitmap&) = delete;
+    ConflictBitmap& operator=(ConflictBitmap&&) = delete;
+    ~ConflictBitmap() = default;
+
+    // Clear the bits and resize for a map and makespan
+    void reset(const Node nb_nodes, const Time makespan)
+    {
+        for (const auto idx : used_)
+        {
+            words_[idx] = 0;
+        }
+        used_.clear();
+        layer_size_ = static_cast<size_t>(nb_nodes) * nb_entries_per_node;
+        const auto size = (layer_size_ * makespan + WORD_BITS - 1) / WORD_BITS;
+        if (words_.size() < size)
+        {
+            words_.resize(size, 0);
+        }
+    }
+
+    // Set the bit of an entry and return true if it was already set
+    inline bool test_and_set(const Key key)
+    {
+        const auto bit = index(key);
+        const auto idx = bit / WORD_BITS;
+        debug_assert(idx < words_.size());
+        const auto mask = Word{1} << (bit % WORD_BITS);
+        auto& word = words_[idx];
+        if (word & mask)
+        {
+            return true;
+        }
+        if (!word)
+        {
+            used_.push_back(idx);
+        }
+        word |= mask;
+        return false;
+    }
+
+  private:
+    inline size_t index(const NodeTime nt) const
+    {
+        return nt.t * layer_size_ + nt.n;
+    }
+    inline size_t index(const EdgeTime et) const
+    {
+        return et.t * layer_size_ + et.n * nb_entries_per_node + et.d;
+    }
+};
+
+#endif
@@ -22,6 +22,7 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "ConstraintHandler_EdgeConflicts.h"
 #include "ProblemData.h"
 #include "VariableData.h"
+#include "ConflictTable.h"
 
 #ifdef USE_WAITEDGE_CONFLICTS
 #define CONSHDLR_NAME          "wait_edge"
@@ -42,6 +43,10 @@ Author: Edward Lam <ed@ed-lam.com>
 struct EdgeConflictsConsData
 {
     HashTable<EdgeTime, EdgeConflict> conflicts;
+#ifdef USE_DENSE_CONFLICT_TABLES
+    ConflictTable<EdgeTime> edge_used;
+#endif
+    ConflictBitmap<EdgeTime> check_edge_used;
 };
 
 // Create a constraint for edge conflicts and include it
@@ -240,6 +245,57 @@ SCIP_RETCODE edge_conflicts_check(
     // Get variables.
     const auto& vars = SCIPprobdataGetVars(probdata);
 
+    // Find the makespan and check if the solution is integral.
+    Time makespan = 0;
+    bool is_integral = true;
+    for (const auto& [var, _] : vars)
+    {
+        debug_assert(var);
+        const auto var_val = SCIPgetSolVal(scip, sol, var);
+        if (SCIPisPositive(scip, var_val))
+        {
+            makespan = std::max(makespan, SCIPvardataGetPathLength(SCIPvarGetData(var)));
+            is_integral &= SCIPisFeasEQ(scip, var_val, 1.0);
+        }
+    }
+
+    // Check integral solutions with a bitmap of the used edges. Stop at the first edge used twice.
+    const auto conflict_horizon = SCIPprobdataGetConflictHorizon(probdata);
+    if (is_integral)
+    {
+        // Get the bitmap.
+        auto consdata = reinterpret_cast<EdgeConflictsConsData*>(
+            SCIPconsGetData(SCIPprobdataGetEdgeConflictsCons(probdata)));
+        debug_assert(consdata);
+        auto& edge_used = consdata->check_edge_used;
+        const auto horizon = std::min(makespan, conflict_horizon);
+        edge_used.reset(map.size(), horizon);
+
+        // Set the edges of every path. Wait action cannot be in a conflict.
+        for (const auto& [var, _] : vars)
+            if (SCIPisPositive(scip, SCIPgetSolVal(scip, sol, var)))
+            {
+                // Get the path.
+                auto vardata = SCIPvarGetData(var);
+                const auto path_length = SCIPvardataGetPathLength(vardata);
+                const auto path = SCIPvardataGetPath(vardata);
+
+                // Set the edges.
+                for (Time t = 0; t < std::min(path_length - 1, horizon); ++t)
+                    if (path[t].d != Direction::WAIT &&
+                        edge_used.test_and_set(EdgeTime{map.get_undirected_edge(path[t]), t}))
+                    {
+                        // Infeasible.
+                        debugln("   Infeasible solution has an edge used twice at time {}", t);
+                        *result = SCIP_INFEASIBLE;
+                        return SCIP_OKAY;
+                    }
+            }
+
+        // Done.
+        return SCIP_OKAY;
+    }
+
     // Calculate the number of times an edge is used by summing the columns.
     HashTable<EdgeTime, SCIP_Real> edge_times_used;
     for (const auto& [var, _] : vars)
@@ -266,8 +322,8 @@ SCIP_RETCODE edge_conflicts_check(
     }
 
     // Check for conflicts.
-    for (const auto [et, val] : edge_times_used)
-        if (SCIPisSumGT(scip, val, 1.0))
+    for (const auto& [et, val] : edge_times_used)
+        if (et.t < conflict_horizon && SCIPisSumGT(scip, val, 1.0))
         {
             // Print.
 #ifdef PRINT_DEBUG
@@ -322,25 +378,22 @@ SCIP_RETCODE edge_conflicts_separate(
     // Get variables.
     const auto& vars = SCIPprobdataGetVars(probdata);
 
-    // Find the makespan.
-    Time makespan = 0;
-    for (const auto& [var, var_val] : vars)
-    {
-        // Get the path length.
-        debug_assert(var);
-        auto vardata = SCIPvarGetData(var);
-        const auto path_length = SCIPvardataGetPathLength(vardata);
-
-        // Store the length of the longest path.
-        debug_assert(var_val == SCIPgetSolVal(scip, sol, var));
-        if (path_length > makespan && SCIPisPositive(scip, var_val))
-        {
-            makespan = path_length;
-        }
-    }
+    // Get the makespan.
+    const auto makespan = SCIPprobdataGetMakespan(probdata);
 
     // Calculate the number of times an edge is used by summing the columns.
+#ifdef USE_DENSE_CONFLICT_TABLES
+    auto& edge_used = consdata->edge_used;
+    edge_used.reset(map.size(), makespan);
+    const auto get_edge_used = [&edge_used](const EdgeTime et) { return edge_used.get(et); };
+#else
     HashTable<EdgeTime, SCIP_Real> edge_used;
+    const auto get_edge_used = [&edge_used](const EdgeTime et)
+    {
+        const auto it = edge_used.find(et);
+        return it != edge_used.end() ? it->second : 0.0;
+    };
+#endif
     for (const auto& [var, var_val] : vars)
     {
         // Get the path.
@@ -376,17 +429,17 @@ SCIP_RETCODE edge_conflicts_separate(
     }
 
     // Create cuts.
-    for (const auto [et1, val1] : edge_used)
-        if (et1.d == Direction::NORTH || et1.d == EAST)
+    const auto conflict_horizon = SCIPprobdataGetConflictHorizon(probdata);
+    for (const auto& [et1, val1] : edge_used)
+        if ((et1.d == Direction::NORTH || et1.d == EAST) && et1.t < conflict_horizon)
         {
             // Get the opposite edge.
             const EdgeTime et2{map.get_opposite_edge(et1.et.e), et1.t};
-            const auto it2 = edge_used.find(et2);
-            if (it2 == edge_used.end())
+            const auto val2 = get_edge_used(et2);
+            if (val2 == 0.0)
             {
                 continue;
             }
-            const auto val2 = it2->second;
 
             // Check.
             debug_assert(SCIPisPositive(scip, val1));
@@ -396,10 +449,8 @@ SCIP_RETCODE edge_conflicts_separate(
 #ifdef USE_WAITEDGE_CONFLICTS
             const EdgeTime et3a{et1.n, Direction::WAIT, et1.t};
             const EdgeTime et3b{et2.n, Direction::WAIT, et2.t};
-            const auto it3a = edge_used.find(et3a);
-            const auto it3b = edge_used.find(et3b);
-            const auto val3a = it3a != edge_used.end() ? it3a->second : 0.0;
-            const auto val3b = it3b != edge_used.end() ? it3b->second : 0.0;
+            const auto val3a = get_edge_used(et3a);
+            const auto val3b = get_edge_used(et3b);
 #endif
 
             // Combine the edges.
@@ -916,6 +967,63 @@ SCIP_RETCODE edge_conflicts_add_var(
     return SCIP_OKAY;
 }
 
+SCIP_RETCODE edge_conflicts_add_vars(
+    SCIP* scip,                      // SCIP
+    SCIP_CONS* cons,                 // Edge conflicts constraint
+    const Vector<SCIP_VAR*>& vars    // Variables
+)
+{
+    // Get constraint data.
+    debug_assert(cons);
+    auto consdata = reinterpret_cast<EdgeConflictsConsData*>(SCIPconsGetData(cons));
+    debug_assert(consdata);
+
+    // Check.
+    debug_assert(SCIPconsIsTransformed(cons));
+
+    // Add rounding lock to the new variables.
+    for (const auto var : vars)
+    {
+        debug_assert(var);
+        debug_assert(SCIPvarIsTransformed(var));
+        SCIP_CALL(SCIPlockVarCons(scip, var, cons, FALSE, TRUE));
+    }
+
+    // Add the variables to each constraint in one pass.
+    for (const auto& [et, edge_conflict] : consdata->conflicts)
+    {
+        const auto& [row, edges, t] = edge_conflict;
+        bool cached = false;
+        for (const auto var : vars)
+        {
+            auto vardata = SCIPvarGetData(var);
+            const auto path_length = SCIPvardataGetPathLength(vardata);
+            const auto path = SCIPvardataGetPath(vardata);
+#ifdef USE_WAITEDGE_CONFLICTS
+            if ((t < path_length - 1 && (path[t] == edges[0] || path[t] == edges[1] || path[t] == edges[2])) ||
+                (t >= path_length - 1 && path[path_length - 1].n == edges[2].n))
+#else
+            if (t < path_length - 1 && (path[t] == edges[0] || path[t] == edges[1]))
+#endif
+            {
+                if (!cached)
+                {
+                    SCIP_CALL(SCIPcacheRowExtensions(scip, row));
+                    cached = true;
+                }
+                SCIP_CALL(SCIPaddVarToRow(scip, row, var, 1.0));
+            }
+        }
+        if (cached)
+        {
+            SCIP_CALL(SCIPflushRowExtensions(scip, row));
+        }
+    }
+
+    // Return.
+    return SCIP_OKAY;
+}
+
 const HashTable<EdgeTime, EdgeConflict>& edge_conflicts_get_constraints(
     SCIP_ProbData* probdata    // Problem data
 )
@@ -66,6 +66,13 @@ SCIP_RETCODE edge_conflicts_add_var(
     const Edge* const path     // Path
 );
 
+// Add a batch of variables to the conflicts, extending each row once
+SCIP_RETCODE edge_conflicts_add_vars(
+    SCIP* scip,                      // SCIP
+    SCIP_CONS* cons,                 // Edge conflicts constraint
+    const Vector<SCIP_VAR*>& vars    // Variables
+);
+
 const HashTable<EdgeTime, EdgeConflict>& edge_conflicts_get_constraints(
     SCIP_ProbData* probdata    // Problem data
 );
@@ -22,6 +22,7 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "ConstraintHandler_VertexConflicts.h"
 #include "ProblemData.h"
 #include "VariableData.h"
+#include "ConflictTable.h"
 
 #define CONSHDLR_NAME          "vertex"
 #define CONSHDLR_DESC          "Constraint handler for vertex conflicts"
@@ -38,6 +39,10 @@ Author: Edward Lam <ed@ed-lam.com>
 struct VertexConflictsConsData
 {
     HashTable<NodeTime, VertexConflict> conflicts;
+#ifdef USE_DENSE_CONFLICT_TABLES
+    ConflictTable<NodeTime> vertex_used;
+#endif
+    ConflictBitmap<NodeTime> check_vertex_used;
 };
 
 // Create a constraint for vertex conflicts and include it
@@ -215,8 +220,9 @@ SCIP_RETCODE vertex_conflicts_check(
     // Get variables.
     const auto& vars = SCIPprobdataGetVars(probdata);
 
-    // Find the makespan.
+    // Find the makespan and check if the solution is integral.
     Time makespan = 0;
+    bool is_integral = true;
     for (const auto& [var, _] : vars)
     {
         // Get the path length.
@@ -228,12 +234,50 @@ SCIP_RETCODE vertex_conflicts_check(
         const auto var_val = SCIPgetSolVal(scip, sol, var);
 
         // Store the length of the longest path.
-        if (path_length > makespan && SCIPisPositive(scip, var_val))
+        if (SCIPisPositive(scip, var_val))
         {
-            makespan = path_length;
+            makespan = std::max(makespan, path_length);
+            is_integral &= SCIPisFeasEQ(scip, var_val, 1.0);
         }
     }
 
+    // Check integral solutions with a bitmap of the used vertices. Stop at the first vertex used twice.
+    const auto conflict_horizon = SCIPprobdataGetConflictHorizon(probdata);
+    if (is_integral)
+    {
+        // Get the bitmap.
+        auto consdata = reinterpret_cast<VertexConflictsConsData*>(
+            SCIPconsGetData(SCIPprobdataGetVertexConflictsCons(probdata)));
+        debug_assert(consdata);
+        auto& vertex_used = consdata->check_vertex_used;
+        const auto horizon = std::min(makespan, conflict_horizon);
+        vertex_used.reset(SCIPprobdataGetMap(probdata).size(), horizon);
+
+        // Set the vertices of every path.
+        for (const auto& [var, _] : vars)
+            if (SCIPisPositive(scip, SCIPgetSolVal(scip, sol, var)))
+            {
+                // Get the path.
+                auto vardata = SCIPvarGetData(var);
+                const auto path_length = SCIPvardataGetPathLength(vardata);
+                const auto path = SCIPvardataGetPath(vardata);
+
+                // Set the vertices.
+                const auto n = path[path_length - 1].n;
+                for (Time t = 1; t < horizon; ++t)
+                    if (vertex_used.test_and_set(NodeTime{t < path_length ? path[t].n : n, t}))
+                    {
+                        // Infeasible.
+                        debugln("   Infeasible solution has a vertex used twice at time {}", t);
+                        *result = SCIP_INFEASIBLE;
+                        return SCIP_OKAY;
+                    }
+            }
+
+        // Done.
+        return SCIP_OKAY;
+    }
+
     // Calculate the number of times a vertex is used by summing the columns.
     HashTable<NodeTime, SCIP_Real> vertex_times_used;
     for (const auto& [var, _] : vars)
@@ -266,8 +310,8 @@ SCIP_RETCODE vertex_conflicts_check(
     }
 
     // Check for conflicts.
-    for (const auto [nt, val] : vertex_times_used)
-        if (SCIPisSumGT(scip, val, 1.0))
+    for (const auto& [nt, val] : vertex_times_used)
+        if (nt.t < conflict_horizon && SCIPisSumGT(scip, val, 1.0))
         {
             // Print.
 #ifdef PRINT_DEBUG
@@ -319,25 +363,16 @@ SCIP_RETCODE vertex_conflicts_separate(
     // Get variables.
     const auto& vars = SCIPprobdataGetVars(probdata);
 
-    // Find the makespan.
-    Time makespan = 0;
-    for (const auto& [var, var_val] : vars)
-    {
-        // Get the path length.
-        debug_assert(var);
-        auto vardata = SCIPvarGetData(var);
-        const auto path_length = SCIPvardataGetPathLength(vardata);
-
-        // Store the length of the longest path.
-        debug_assert(var_val == SCIPgetSolVal(scip, sol, var));
-        if (path_length > makespan && SCIPisPositive(scip, var_val))
-        {
-            makespan = path_length;
-        }
-    }
+    // Get the makespan.
+    const auto makespan = SCIPprobdataGetMakespan(probdata);
 
     // Calculate the number of times a vertex is used by summing the columns.
+#ifdef USE_DENSE_CONFLICT_TABLES
+    auto& vertex_used = consdata->vertex_used;
+    vertex_used.reset(SCIPprobdataGetMap(probdata).size(), makespan);
+#else
     HashTable<NodeTime, SCIP_Real> vertex_used;
+#endif
     for (const auto& [var, var_val] : vars)
     {
         // Get the path.
@@ -366,8 +401,9 @@ SCIP_RETCODE vertex_conflicts_separate(
     }
 
     // Create cuts.
-    for (const auto [nt, val] : vertex_used)
-        if (SCIPisSumGT(scip, val, 1.0))
+    const auto conflict_horizon = SCIPprobdataGetConflictHorizon(probdata);
+    for (const auto& [nt, val] : vertex_used)
+        if (nt.t < conflict_horizon && SCIPisSumGT(scip, val, 1.0))
         {
             // Print.
 #ifdef PRINT_DEBUG
@@ -705,6 +741,26 @@ SCIP_DECL_CONSLOCK(consLockVertexConflicts)
 }
 #pragma GCC diagnostic pop
 
+// Variable deletion method of constraint handler
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_CONSDELVARS(consDelvarsVertexConflicts)
+{
+    // Check.
+    debug_assert(scip);
+    debug_assert(conshdlr);
+    debug_assert(strcmp(SCIPconshdlrGetName(conshdlr), CONSHDLR_NAME) == 0);
+
+    // Remove the deleted variables from the problem data. This also removes them from the edge conflicts constraint.
+    auto probdata = SCIPgetProbData(scip);
+    SCIP_CALL(SCIPprobdataRemoveDeletedVars(scip, probdata));
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
 // Copying constraint of constraint handler
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-parameter"
@@ -787,6 +843,9 @@ SCIP_RETCODE SCIPincludeConshdlrVertexConflicts(
     SCIP_CALL(SCIPsetConshdlrTrans(scip,
                                    conshdlr,
                                    consTransVertexConflicts));
+    SCIP_CALL(SCIPsetConshdlrDelvars(scip,
+                                     conshdlr,
+                                     consDelvarsVertexConflicts));
     SCIP_CALL(SCIPsetConshdlrSepa(scip,
                                   conshdlr,
                                   consSepalpVertexConflicts,
@@ -835,6 +894,59 @@ SCIP_RETCODE vertex_conflicts_add_var(
     return SCIP_OKAY;
 }
 
+SCIP_RETCODE vertex_conflicts_add_vars(
+    SCIP* scip,                      // SCIP
+    SCIP_CONS* cons,                 // Vertex conflicts constraint
+    const Vector<SCIP_VAR*>& vars    // Variables
+)
+{
+    // Get constraint data.
+    debug_assert(cons);
+    auto consdata = reinterpret_cast<VertexConflictsConsData*>(SCIPconsGetData(cons));
+    debug_assert(consdata);
+
+    // Check.
+    debug_assert(SCIPconsIsTransformed(cons));
+
+    // Add rounding lock to the new variables.
+    for (const auto var : vars)
+    {
+        debug_assert(var);
+        debug_assert(SCIPvarIsTransformed(var));
+        SCIP_CALL(SCIPlockVarCons(scip, var, cons, FALSE, TRUE));
+    }
+
+    // Add the variables to each constraint in one pass.
+    for (const auto& [nt, vertex_conflict] : consdata->conflicts)
+    {
+        const auto& [row] = vertex_conflict;
+        bool cached = false;
+        for (const auto var : vars)
+        {
+            auto vardata = SCIPvarGetData(var);
+            const auto path_length = SCIPvardataGetPathLength(vardata);
+            const auto path = SCIPvardataGetPath(vardata);
+            if ((nt.t < path_length && path[nt.t].n == nt.n) ||
+                (nt.t >= path_length && path[path_length - 1].n == nt.n))
+            {
+                if (!cached)
+                {
+                    SCIP_CALL(SCIPcacheRowExtensions(scip, row));
+                    cached = true;
+                }
+                SCIP_CALL(SCIPaddVarToRow(scip, row, var, 1.0));
+            }
+        }
+        if (cached)
+        {
+            SCIP_CALL(SCIPflushRowExtensions(scip, row));
+        }
+    }
+
+    // Return.
+    return SCIP_OKAY;
+}
+
 const HashTable<NodeTime, VertexConflict>& vertex_conflicts_get_constraints(
     SCIP_ProbData* probdata    // Problem data
 )
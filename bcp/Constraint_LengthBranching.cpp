@@ -20,6 +20,7 @@ Author: Edward Lam <ed@ed-lam.com>
 //#define PRINT_DEBUG
 
 #include "Constraint_LengthBranching.h"
+#include "BranchingRule.h"
 #include "ProblemData.h"
 #include "VariableData.h"
 
@@ -45,6 +46,11 @@ struct LengthBranchingConsData
     Int npropagatedvars;          // Number of variables that existed when the related node
                                   // was propagated the last time. Used to determine whether
                                   // the constraint should be repropagated
+#ifdef USE_LNS2_REPAIR_PRIMAL_HEURISTIC
+    Int npropagatedheuristicvars; // Number of variables added by primal heuristics that existed
+                                  // when the related node was propagated the last time. These
+                                  // variables can ignore the branching decision
+#endif
     bool propagated : 1;          // Is the constraint already propagated?
     SCIP_NODE* node;              // The node of the branch-and-bound tree for this constraint
 };
@@ -72,6 +78,9 @@ SCIP_RETCODE consdataCreate(
     (*consdata)->a = a;
     (*consdata)->nt = nt;
     (*consdata)->npropagatedvars = 0;
+#ifdef USE_LNS2_REPAIR_PRIMAL_HEURISTIC
+    (*consdata)->npropagatedheuristicvars = 0;
+#endif
     (*consdata)->propagated = false;
     (*consdata)->node = node;
 
@@ -171,7 +180,7 @@ SCIP_RETCODE fix_variables(
     const auto nvars = static_cast<Int>(vars.size());
     debug_assert(consdata->npropagatedvars <= nvars);
 
-    // Check every variable.
+    // Check every new variable.
     Int nfixedvars = 0;
     SCIP_Bool cutoff = FALSE;
     for (Int v = consdata->npropagatedvars; v < nvars && !cutoff; ++v)
@@ -186,6 +195,27 @@ SCIP_RETCODE fix_variables(
                                  &cutoff));
     }
 
+    // Check the new variables of primal heuristics that were added before the propagated variables.
+#ifdef USE_LNS2_REPAIR_PRIMAL_HEURISTIC
+    const auto& heuristic_var_indices = SCIPprobdataGetHeuristicVarIndices(SCIPgetProbData(scip));
+    const auto nheuristicvars = static_cast<Int>(heuristic_var_indices.size());
+    debug_assert(consdata->npropagatedheuristicvars <= nheuristicvars);
+    for (Int i = consdata->npropagatedheuristicvars; i < nheuristicvars && !cutoff; ++i)
+    {
+        const auto v = heuristic_var_indices[i];
+        if (0 <= v && v < consdata->npropagatedvars)
+        {
+            SCIP_CALL(check_variable(scip,
+                                     consdata->dir,
+                                     consdata->a,
+                                     consdata->nt,
+                                     vars[v].first,
+                                     nfixedvars,
+                                     &cutoff));
+        }
+    }
+#endif
+
     // Print.
     debugln("   Disabled {} variables", nfixedvars);
 
@@ -215,6 +245,23 @@ void check_propagation(
     const auto nvars = beforeprop ? consdata->npropagatedvars : static_cast<Int>(vars.size());
     release_assert(nvars <= static_cast<Int>(vars.size()));
 
+    // Skip the variables of primal heuristics that are not propagated yet.
+#ifdef USE_LNS2_REPAIR_PRIMAL_HEURISTIC
+    Vector<bool> skip(nvars, false);
+    if (beforeprop)
+    {
+        const auto& heuristic_var_indices = SCIPprobdataGetHeuristicVarIndices(probdata);
+        for (Int i = consdata->npropagatedheuristicvars; i < static_cast<Int>(heuristic_var_indices.size()); ++i)
+        {
+            const auto v = heuristic_var_indices[i];
+            if (0 <= v && v < nvars)
+            {
+                skip[v] = true;
+            }
+        }
+    }
+#endif
+
     // Get the branching decision.
     const auto a = consdata->a;
     const auto nt = consdata->nt;
@@ -231,6 +278,10 @@ void check_propagation(
         // If the variable is locally fixed to zero, continue.
         if (SCIPvarGetUbLocal(var) < 0.5)
             continue;
+#ifdef USE_LNS2_REPAIR_PRIMAL_HEURISTIC
+        if (skip[v])
+            continue;
+#endif
 
         // Get the path.
         auto vardata = SCIPvarGetData(var);
@@ -347,6 +398,9 @@ SCIP_DECL_CONSPROP(consPropLengthBranching)
     // Get variables.
     const auto& vars = SCIPprobdataGetVars(probdata);
     const auto nvars = static_cast<Int>(vars.size());
+#ifdef USE_LNS2_REPAIR_PRIMAL_HEURISTIC
+    const auto nheuristicvars = static_cast<Int>(SCIPprobdataGetHeuristicVarIndices(probdata).size());
+#endif
 
     // Propagate constraints.
     *result = SCIP_DIDNOTFIND;
@@ -361,8 +415,11 @@ SCIP_DECL_CONSPROP(consPropLengthBranching)
         check_propagation(probdata, consdata, TRUE);
 #endif
 
-        // Propagate.
-#ifndef USE_LNS2_REPAIR_PRIMAL_HEURISTIC
+        // Propagate if the constraint is not propagated or if primal heuristics added variables since the last
+        // propagation.
+#ifdef USE_LNS2_REPAIR_PRIMAL_HEURISTIC
+        if (!consdata->propagated || consdata->npropagatedheuristicvars != nheuristicvars)
+#else
         if (!consdata->propagated)
 #endif
         {
@@ -392,6 +449,9 @@ SCIP_DECL_CONSPROP(consPropLengthBranching)
             {
                 consdata->propagated = TRUE;
                 consdata->npropagatedvars = nvars;
+#ifdef USE_LNS2_REPAIR_PRIMAL_HEURISTIC
+                consdata->npropagatedheuristicvars = nheuristicvars;
+#endif
             }
             else
             {
@@ -452,7 +512,12 @@ SCIP_DECL_CONSACTIVE(consActiveLengthBranching)
 #endif
 
     // Mark constraint as to be repropagated.
+#ifdef USE_LNS2_REPAIR_PRIMAL_HEURISTIC
+    const auto nheuristicvars = static_cast<Int>(SCIPprobdataGetHeuristicVarIndices(probdata).size());
+    if (consdata->npropagatedvars != nvars || consdata->npropagatedheuristicvars != nheuristicvars)
+#else
     if (consdata->npropagatedvars != nvars)
+#endif
     {
         consdata->propagated = FALSE;
         SCIP_CALL(SCIPrepropagateNode(scip, consdata->node));
@@ -496,12 +561,13 @@ SCIP_DECL_CONSDEACTIVE(consDeactiveLengthBranching)
 #endif
 
     // Set the number of propagated variables to the current number of variables because the new variables always
-    // respect the constraint (branching decision) unless using the LNS2 primal heuristic which can add variables that
-    // ignore the branching decisions.
-#ifndef USE_LNS2_REPAIR_PRIMAL_HEURISTIC
+    // respect the constraint (branching decision). The LNS2 primal heuristic can add variables that ignore the
+    // branching decisions but these are checked from the list of variables of primal heuristics instead.
     const auto& vars = SCIPprobdataGetVars(probdata);
     consdata->npropagatedvars = vars.size();
-#endif
+
+    // Record the bound gain of the node for the pseudocosts of the branching rule.
+    branching_record_gain(scip, consdata->node);
 
     // Done.
     return SCIP_OKAY;
@@ -638,3 +704,25 @@ NodeTime SCIPgetLengthBranchingNodeTime(
     debug_assert(consdata);
     return consdata->nt;
 }
+
+// Renumber the variables propagated by every length branching constraint after the deleted variables are removed from
+// the problem data
+void SCIPrenumberLengthBranchingVars(
+    SCIP* scip,                        // SCIP
+    const Vector<Int>& nb_kept_vars    // Number of variables kept before each index of the old array of variables
+)
+{
+    // The variables are compacted in order, so the variables propagated by a constraint are still the first ones.
+    auto conshdlr = SCIPfindConshdlr(scip, CONSHDLR_NAME);
+    debug_assert(conshdlr);
+    auto conss = SCIPconshdlrGetConss(conshdlr);
+    const auto nconss = SCIPconshdlrGetNConss(conshdlr);
+    for (Int c = 0; c < nconss; ++c)
+    {
+        auto consdata = reinterpret_cast<LengthBranchingConsData*>(SCIPconsGetData(conss[c]));
+        debug_assert(consdata);
+        debug_assert(0 <= consdata->npropagatedvars &&
+                     consdata->npropagatedvars < static_cast<Int>(nb_kept_vars.size()));
+        consdata->npropagatedvars = nb_kept_vars[consdata->npropagatedvars];
+    }
+}
@@ -61,4 +61,11 @@ NodeTime SCIPgetLengthBranchingNodeTime(
     SCIP_CONS* cons    // Constraint enforcing goal branching
 );
 
+// Renumber the variables propagated by every length branching constraint after the deleted variables are removed from
+// the problem data
+void SCIPrenumberLengthBranchingVars(
+    SCIP* scip,                        // SCIP
+    const Vector<Int>& nb_kept_vars    // Number of variables kept before each index of the old array of variables
+);
+
 #endif
@@ -0,0 +1,292 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+//#define PRINT_DEBUG
+
+#include "Constraint_ReducedCostFixing.h"
+#include "ProblemData.h"
+#include "VariableData.h"
+
+// Constraint handler properties
+#define CONSHDLR_NAME          "reduced_cost_fixing"
+#define CONSHDLR_DESC          "Stores the node-times forbidden by reduced cost arguments"
+#define CONSHDLR_ENFOPRIORITY  0          // priority of the constraint handler for constraint enforcing
+#define CONSHDLR_CHECKPRIORITY 9999998    // priority of the constraint handler for checking feasibility
+#define CONSHDLR_PROPFREQ      1          // frequency for propagating domains; zero means only preprocessing propagation
+#define CONSHDLR_EAGERFREQ     1          // frequency for using all instead of only the useful constraints in separation,
+                                          // propagation and enforcement, -1 for no eager evaluations, 0 for first only
+#define CONSHDLR_DELAYPROP     FALSE      // should propagation method be delayed, if other propagators found reductions?
+#define CONSHDLR_NEEDSCONS     TRUE       // should the constraint handler be skipped, if no constraints are available?
+
+#define CONSHDLR_PROP_TIMING   SCIP_PROPTIMING_BEFORELP
+
+// Constraint data
+struct ReducedCostFixingConsData
+{
+    Agent a;                                        // Agent
+    Time latest_goal_time;                          // Latest time to finish
+    Vector<Pair<Node, Time>> latest_visit_time;     // Latest time to visit some nodes
+    SCIP_NODE* node;                                // The node of the branch-and-bound tree for this constraint
+};
+
+// Check if a path uses a node-time forbidden by the constraint
+static
+bool is_forbidden(
+    const ReducedCostFixingConsData& consdata,    // Constraint data
+    const Time path_length,                       // Path length
+    const Edge* const path                        // Path
+)
+{
+    if (path_length - 1 > consdata.latest_goal_time)
+    {
+        return true;
+    }
+    for (const auto& [n, latest_t] : consdata.latest_visit_time)
+        for (Time t = std::max<Time>(latest_t + 1, 0); t < path_length; ++t)
+            if (path[t].n == n)
+            {
+                return true;
+            }
+    return false;
+}
+
+// Fix the variables of the agent to zero if their paths use a forbidden node-time. The fixings are local to the node
+// being propagated so every node in the subtree checks the variables again.
+static
+SCIP_RETCODE fix_variables(
+    SCIP* scip,                                        // SCIP
+    const ReducedCostFixingConsData& consdata,         // Constraint data
+    const Vector<Pair<SCIP_VAR*, SCIP_Real>>& vars,    // Variables of the agent
+    SCIP_RESULT* result                                // Pointer to store the result of the fixing
+)
+{
+    Int nfixedvars = 0;
+    for (const auto& [var, _] : vars)
+    {
+        // If the variable is locally fixed to zero, continue to next variable.
+        debug_assert(var);
+        if (SCIPvarGetUbLocal(var) < 0.5)
+            continue;
+
+        // Disable the variable if its path is forbidden.
+        auto vardata = SCIPvarGetData(var);
+        debug_assert(SCIPvardataGetAgent(vardata) == consdata.a);
+        const auto path_length = SCIPvardataGetPathLength(vardata);
+        const auto path = SCIPvardataGetPath(vardata);
+        if (is_forbidden(consdata, path_length, path))
+        {
+            SCIP_Bool success;
+            SCIP_Bool fixing_is_infeasible;
+            SCIP_CALL(SCIPfixVar(scip, var, 0.0, &fixing_is_infeasible, &success));
+            if (fixing_is_infeasible)
+            {
+                debug_assert(SCIPvarGetLbLocal(var) > 0.5);
+                debugln("         Node is infeasible - cut off");
+                *result = SCIP_CUTOFF;
+                return SCIP_OKAY;
+            }
+            debug_assert(success);
+            nfixedvars++;
+        }
+    }
+
+    // Done.
+    debugln("   Disabled {} variables of agent {} by reduced cost fixing", nfixedvars, consdata.a);
+    if (nfixedvars > 0)
+    {
+        *result = SCIP_REDUCEDDOM;
+    }
+    return SCIP_OKAY;
+}
+
+// Free constraint data
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_CONSDELETE(consDeleteReducedCostFixing)
+{
+    // Check.
+    debug_assert(conshdlr);
+    debug_assert(strcmp(SCIPconshdlrGetName(conshdlr), CONSHDLR_NAME) == 0);
+    debug_assert(consdata);
+    debug_assert(*consdata);
+
+    // Free memory.
+    auto data = reinterpret_cast<ReducedCostFixingConsData*>(*consdata);
+    data->~ReducedCostFixingConsData();
+    SCIPfreeBlockMemory(scip, &data);
+    *consdata = nullptr;
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Domain propagation method of constraint handler
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_CONSPROP(consPropReducedCostFixing)
+{
+    // Check.
+    debug_assert(scip);
+    debug_assert(strcmp(SCIPconshdlrGetName(conshdlr), CONSHDLR_NAME) == 0);
+    debug_assert(result);
+
+    // Get problem data.
+    auto probdata = SCIPgetProbData(scip);
+    const auto& agent_vars = SCIPprobdataGetAgentVars(probdata);
+
+    // Propagate constraints.
+    *result = SCIP_DIDNOTFIND;
+    for (Int c = 0; c < nconss && *result != SCIP_CUTOFF; ++c)
+    {
+        auto consdata = reinterpret_cast<ReducedCostFixingConsData*>(SCIPconsGetData(conss[c]));
+        debug_assert(consdata);
+        SCIP_CALL(fix_variables(scip, *consdata, agent_vars[consdata->a], result));
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Create the constraint handler for reduced cost fixing and include it
+SCIP_RETCODE SCIPincludeConshdlrReducedCostFixing(
+    SCIP* scip    // SCIP
+)
+{
+    // Include constraint handler.
+    SCIP_CONSHDLR* conshdlr = nullptr;
+    SCIP_CALL(SCIPincludeConshdlrBasic(scip,
+                                       &conshdlr,
+                                       CONSHDLR_NAME,
+                                       CONSHDLR_DESC,
+                                       CONSHDLR_ENFOPRIORITY,
+                                       CONSHDLR_CHECKPRIORITY,
+                                       CONSHDLR_EAGERFREQ,
+                                       CONSHDLR_NEEDSCONS,
+                                       nullptr,
+                                       nullptr,
+                                       nullptr,
+                                       nullptr,
+                                       nullptr));
+    debug_assert(conshdlr);
+
+    // Set callbacks.
+    SCIP_CALL(SCIPsetConshdlrDelete(scip, conshdlr, consDeleteReducedCostFixing));
+    SCIP_CALL(SCIPsetConshdlrProp(scip,
+                                  conshdlr,
+                                  consPropReducedCostFixing,
+                                  CONSHDLR_PROPFREQ,
+                                  CONSHDLR_DELAYPROP,
+                                  CONSHDLR_PROP_TIMING));
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Create and capture a constraint forbidding the node-times that no path of an agent with a reduced cost below the
+// gap to the incumbent can use in the subtree of a node
+SCIP_RETCODE SCIPcreateConsReducedCostFixing(
+    SCIP* scip,                                     // SCIP
+    SCIP_CONS** cons,                               // Pointer to the created constraint
+    const char* name,                               // Name of constraint
+    const Agent a,                                  // Agent
+    const Time latest_goal_time,                    // Latest time to finish
+    Vector<Pair<Node, Time>>&& latest_visit_time,   // Latest time to visit some nodes
+    SCIP_NODE* node                                 // The node of the branch-and-bound tree for this constraint
+)
+{
+    // Find the constraint handler.
+    auto conshdlr = SCIPfindConshdlr(scip, CONSHDLR_NAME);
+    debug_assert(conshdlr);
+
+    // Create constraint data.
+    ReducedCostFixingConsData* consdata = nullptr;
+    SCIP_CALL(SCIPallocBlockMemory(scip, &consdata));
+    debug_assert(consdata);
+    new(consdata) ReducedCostFixingConsData;
+    consdata->a = a;
+    consdata->latest_goal_time = latest_goal_time;
+    consdata->latest_visit_time = std::move(latest_visit_time);
+    consdata->node = node;
+
+    // Create constraint.
+    SCIP_CALL(SCIPcreateCons(scip,
+                             cons,
+                             name,
+                             conshdlr,
+                             reinterpret_cast<SCIP_CONSDATA*>(consdata),
+                             FALSE,
+                             FALSE,
+                             FALSE,
+                             FALSE,
+                             TRUE,
+                             TRUE,
+                             FALSE,
+                             FALSE,
+                             FALSE,
+                             TRUE));
+
+    // Print.
+    debugln("Creating reduced cost fixing constraint for agent {} with latest goal time {} and {} restricted nodes "
+            "in node {} at depth {}",
+            a,
+            latest_goal_time,
+            consdata->latest_visit_time.size(),
+            SCIPnodeGetNumber(node),
+            SCIPnodeGetDepth(node));
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Get agent
+Agent SCIPgetReducedCostFixingAgent(
+    SCIP_CONS* cons    // Constraint enforcing reduced cost fixing
+)
+{
+    debug_assert(cons);
+    auto consdata = reinterpret_cast<ReducedCostFixingConsData*>(SCIPconsGetData(cons));
+    debug_assert(consdata);
+    return consdata->a;
+}
+
+// Get latest time to finish
+Time SCIPgetReducedCostFixingLatestGoalTime(
+    SCIP_CONS* cons    // Constraint enforcing reduced cost fixing
+)
+{
+    debug_assert(cons);
+    auto consdata = reinterpret_cast<ReducedCostFixingConsData*>(SCIPconsGetData(cons));
+    debug_assert(consdata);
+    return consdata->latest_goal_time;
+}
+
+// Get latest time to visit the restricted nodes
+const Vector<Pair<Node, Time>>& SCIPgetReducedCostFixingLatestVisitTime(
+    SCIP_CONS* cons    // Constraint enforcing reduced cost fixing
+)
+{
+    debug_assert(cons);
+    auto consdata = reinterpret_cast<ReducedCostFixingConsData*>(SCIPconsGetData(cons));
+    debug_assert(consdata);
+    return consdata->latest_visit_time;
+}
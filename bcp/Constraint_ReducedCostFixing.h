@@ -0,0 +1,58 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#ifndef MAPF_CONSTRAINT_REDUCEDCOSTFIXING_H
+#define MAPF_CONSTRAINT_REDUCEDCOSTFIXING_H
+
+#include "Includes.h"
+#include "Coordinates.h"
+
+// Create the constraint handler for reduced cost fixing and include it
+SCIP_RETCODE SCIPincludeConshdlrReducedCostFixing(
+    SCIP* scip    // SCIP
+);
+
+// Create and capture a constraint forbidding the node-times that no path of an agent with a reduced cost below the
+// gap to the incumbent can use in the subtree of a node
+SCIP_RETCODE SCIPcreateConsReducedCostFixing(
+    SCIP* scip,                                     // SCIP
+    SCIP_CONS** cons,                               // Pointer to the created constraint
+    const char* name,                               // Name of constraint
+    const Agent a,                                  // Agent
+    const Time latest_goal_time,                    // Latest time to finish
+    Vector<Pair<Node, Time>>&& latest_visit_time,   // Latest time to visit some nodes
+    SCIP_NODE* node                                 // The node of the branch-and-bound tree for this constraint
+);
+
+// Get agent
+Agent SCIPgetReducedCostFixingAgent(
+    SCIP_CONS* cons    // Constraint enforcing reduced cost fixing
+);
+
+// Get latest time to finish
+Time SCIPgetReducedCostFixingLatestGoalTime(
+    SCIP_CONS* cons    // Constraint enforcing reduced cost fixing
+);
+
+// Get latest time to visit the restricted nodes
+const Vector<Pair<Node, Time>>& SCIPgetReducedCostFixingLatestVisitTime(
+    SCIP_CONS* cons    // Constraint enforcing reduced cost fixing
+);
+
+#endif
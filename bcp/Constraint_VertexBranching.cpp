@@ -20,6 +20,7 @@ Author: Edward Lam <ed@ed-lam.com>
 //#define PRINT_DEBUG
 
 #include "Constraint_VertexBranching.h"
+#include "BranchingRule.h"
 #include "ProblemData.h"
 #include "VariableData.h"
 
@@ -149,7 +150,9 @@ SCIP_RETCODE check_variable(
     return SCIP_OKAY;
 }
 
-// Fix variables to zero if its path is not valid for this constraint/branching
+// Fix variables to zero if its path is not valid for this constraint/branching. Only the variables visiting the
+// vertex and, if the agent must use the vertex, the other variables of the agent can be invalid so the other
+// variables are skipped.
 static
 SCIP_RETCODE fix_variables(
     SCIP* scip,                                        // SCIP
@@ -165,21 +168,50 @@ SCIP_RETCODE fix_variables(
     const auto nvars = static_cast<Int>(vars.size());
     debug_assert(consdata->npropagatedvars <= nvars);
 
-    // Check every variable.
+    // Get the index of the variables.
+    auto probdata = SCIPgetProbData(scip);
+    const auto& vertex_var_indices = SCIPprobdataGetVertexVarIndices(probdata, consdata->nt);
+    const auto& agent_var_indices = SCIPprobdataGetAgentVarIndices(probdata)[consdata->a];
+
+    // Check every variable visiting the vertex.
     Int nfixedvars = 0;
     SCIP_Bool cutoff = FALSE;
-    for (Int v = consdata->npropagatedvars; v < nvars && !cutoff; ++v)
+    for (auto it = std::lower_bound(vertex_var_indices.begin(),
+                                    vertex_var_indices.end(),
+                                    consdata->npropagatedvars);
+         it != vertex_var_indices.end() && !cutoff;
+         ++it)
     {
-        debug_assert(v < nvars);
+        debug_assert(*it < nvars);
         SCIP_CALL(check_variable(scip,
                                  consdata->dir,
                                  consdata->a,
                                  consdata->nt,
-                                 vars[v].first,
+                                 vars[*it].first,
                                  nfixedvars,
                                  &cutoff));
     }
 
+    // Check every variable of the agent if the agent must use the vertex.
+    if (consdata->dir == VertexBranchDirection::Use)
+    {
+        for (auto it = std::lower_bound(agent_var_indices.begin(),
+                                        agent_var_indices.end(),
+                                        consdata->npropagatedvars);
+             it != agent_var_indices.end() && !cutoff;
+             ++it)
+        {
+            debug_assert(*it < nvars);
+            SCIP_CALL(check_variable(scip,
+                                     consdata->dir,
+                                     consdata->a,
+                                     consdata->nt,
+                                     vars[*it].first,
+                                     nfixedvars,
+                                     &cutoff));
+        }
+    }
+
     // Print.
     debugln("   Disabled {} variables", nfixedvars);
 
@@ -504,6 +536,9 @@ SCIP_DECL_CONSDEACTIVE(consDeactiveVertexBranching)
     consdata->npropagatedvars = vars.size();
 #endif
 
+    // Record the bound gain of the node for the pseudocosts of the branching rule.
+    branching_record_gain(scip, consdata->node);
+
     // Done.
     return SCIP_OKAY;
 }
@@ -639,3 +674,25 @@ NodeTime SCIPgetVertexBranchingNodeTime(
     debug_assert(consdata);
     return consdata->nt;
 }
+
+// Renumber the variables propagated by every vertex branching constraint after the deleted variables are removed from
+// the problem data
+void SCIPrenumberVertexBranchingVars(
+    SCIP* scip,                        // SCIP
+    const Vector<Int>& nb_kept_vars    // Number of variables kept before each index of the old array of variables
+)
+{
+    // The variables are compacted in order, so the variables propagated by a constraint are still the first ones.
+    auto conshdlr = SCIPfindConshdlr(scip, CONSHDLR_NAME);
+    debug_assert(conshdlr);
+    auto conss = SCIPconshdlrGetConss(conshdlr);
+    const auto nconss = SCIPconshdlrGetNConss(conshdlr);
+    for (Int c = 0; c < nconss; ++c)
+    {
+        auto consdata = reinterpret_cast<VertexBranchingConsData*>(SCIPconsGetData(conss[c]));
+        debug_assert(consdata);
+        debug_assert(0 <= consdata->npropagatedvars &&
+                     consdata->npropagatedvars < static_cast<Int>(nb_kept_vars.size()));
+        consdata->npropagatedvars = nb_kept_vars[consdata->npropagatedvars];
+    }
+}
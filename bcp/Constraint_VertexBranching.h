@@ -61,4 +61,11 @@ NodeTime SCIPgetVertexBranchingNodeTime(
     SCIP_CONS* cons    // Constraint enforcing vertex branching
 );
 
+// Renumber the variables propagated by every vertex branching constraint after the deleted variables are removed from
+// the problem data
+void SCIPrenumberVertexBranchingVars(
+    SCIP* scip,                        // SCIP
+    const Vector<Int>& nb_kept_vars    // Number of variables kept before each index of the old array of variables
+);
+
 #endif
@@ -17,559 +17,676 @@ along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
 Author: Edward Lam <ed@ed-lam.com>
 */
 
-////#define PRINT_DEBUG
-//
-//#include "Constraint_WaitBranching.h"
-//#include "ProblemData.h"
-//#include "VariableData.h"
-//
+//#define PRINT_DEBUG
+
+#include "Constraint_WaitBranching.h"
+#include "ProblemData.h"
+#include "VariableData.h"
+
 // Constraint handler properties
-//#define CONSHDLR_NAME          "wait_branching"
-//#define CONSHDLR_DESC          "Stores the wait branching decisions"
-//#define CONSHDLR_ENFOPRIORITY  0          // priority of the constraint handler for constraint enforcing
-//#define CONSHDLR_CHECKPRIORITY 9999999    // priority of the constraint handler for checking feasibility
-//#define CONSHDLR_PROPFREQ      1          // frequency for propagating domains; zero means only preprocessing propagation
-//#define CONSHDLR_EAGERFREQ     1          // frequency for using all instead of only the useful constraints in separation,
-//                                          // propagation and enforcement, -1 for no eager evaluations, 0 for first only
-//#define CONSHDLR_DELAYPROP     FALSE      // should propagation method be delayed, if other propagators found reductions?
-//#define CONSHDLR_NEEDSCONS     TRUE       // should the constraint handler be skipped, if no constraints are available?
-//
-//#define CONSHDLR_PROP_TIMING   SCIP_PROPTIMING_BEFORELP
-//
-//// Constraint data
-//struct WaitBranchingConsData
-//{
-//    WaitBranchDirection dir;    // Branch direction
-//    Agent a;                    // Agent
-//    Time t;                     // Time
-//    Count npropagatedvars;      // Number of variables that existed when the related node
-//                                // was propagated the last time. Used to determine whether
-//                                // the constraint should be repropagated
-//    bool propagated : 1;        // Is the constraint already propagated?
-//    SCIP_NODE* node;            // The node of the branch-and-bound tree for this constraint
-//};
-//
-//// Create constraint data
-//static
-//SCIP_RETCODE consdataCreate(
-//    SCIP* scip,                          // SCIP
-//    WaitBranchingConsData** consdata,    // Pointer to the constraint data
-//    const WaitBranchDirection dir,       // Branch direction
-//    const Agent a,                       // Agent
-//    const Time t,                        // Time
-//    SCIP_NODE* node                      // Node of the branch-and-bound tree for this constraint
-//)
-//{
-//    // Check.
-//    debug_assert(scip);
-//    debug_assert(consdata);
-//
-//    // Create constraint data.
-//    SCIP_CALL(SCIPallocBlockMemory(scip, consdata));
-//
-//    // Store data.
-//    (*consdata)->dir = dir;
-//    (*consdata)->a = a;
-//    (*consdata)->t = t;
-//    (*consdata)->npropagatedvars = 0;
-//    (*consdata)->propagated = false;
-//    (*consdata)->node = node;
-//
-//    // Done.
-//    return SCIP_OKAY;
-//}
-//
-//// Fix a variable to zero if its path is not valid for this constraint/branch
-//static inline
-//SCIP_RETCODE check_variable(
-//    SCIP* scip,                       // SCIP
-//    const WaitBranchDirection dir,    // Branch direction
-//    const Agent a,                    // Agent
-//    const Time t,                     // Time
-//    SCIP_VAR* var,                    // Variable to check
-//    Count& nfixedvars,                // Pointer to store the number of fixed variables
-//    SCIP_Bool* cutoff                 // Pointer to store if a cutoff was detected
-//)
-//{
-//    // Check.
-//    debug_assert(scip);
-//    debug_assert(var);
-//    debug_assert(cutoff);
-//
-//    // If the variable is locally fixed to zero, continue to next variable.
-//    if (SCIPvarGetUbLocal(var) < 0.5)
-//        return SCIP_OKAY;
-//
-//    // Get the path.
-//    auto vardata = SCIPvarGetData(var);
-//    const auto path_length = SCIPvardataGetPathLength(vardata);
-//    const auto path = SCIPvardataGetPath(vardata);
-//    debug_assert(a == SCIPvardataGetAgent(vardata));
-//
-//    // Disable the path if the agent does or doesn't wait at the required time.
-//    const auto exists = (t < path_length && path[t].d == Direction::WAIT);
-//    if (exists != static_cast<bool>(dir))
-//    {
-//        // Disable the variable.
-//        SCIP_Bool success;
-//        SCIP_Bool fixing_is_infeasible;
-//        SCIP_CALL(SCIPfixVar(scip, var, 0.0, &fixing_is_infeasible, &success));
-//
-//        // Print.
-//        debugln("      Disabling variable for agent {}, path {}",
-//                a, format_path(SCIPgetProbData(scip), path_length, path));
-//
-//        // Cut off the node if the fixing is infeasible.
-//        if (fixing_is_infeasible)
-//        {
-//            debug_assert(SCIPvarGetLbLocal(var) > 0.5);
-//            debugln("         Node is infeasible - cut off")
-//            (*cutoff) = TRUE;
-//        }
-//        else
-//        {
-//            debug_assert(success);
-//            nfixedvars++;
-//        }
-//    }
-//
-//    // Done.
-//    return SCIP_OKAY;
-//}
-//
-//// Fix variables to zero if its path is not valid for this constraint/branching
-//static
-//SCIP_RETCODE fix_variables(
-//    SCIP* scip,                         // SCIP
-//    WaitBranchingConsData* consdata,    // Constraint data
-//    const Count nvars,                  // Number of variables
-//    SCIP_VAR** vars,                    // Array of variables
-//    SCIP_RESULT* result                 // Pointer to store the result of the fixing
-//)
-//{
-//    // Print.
-//    debugln("   Checking variables {} to {}:", consdata->npropagatedvars, nvars);
-//
-//    // Check.
-//    debug_assert(consdata->npropagatedvars <= nvars);
-//
-//    // Check every variable.
-//    Count nfixedvars = 0;
-//    SCIP_Bool cutoff = FALSE;
-//    for (Count var = consdata->npropagatedvars; var < nvars && !cutoff; ++var)
-//    {
-//        SCIP_CALL(check_variable(scip,
-//                                 consdata->dir,
-//                                 consdata->a,
-//                                 consdata->t,
-//                                 vars[var],
-//                                 nfixedvars,
-//                                 &cutoff));
-//    }
-//
-//    // Print.
-//    debugln("   Disabled {} variables", nfixedvars);
-//
-//    // Done.
-//    if (cutoff)
-//    {
-//        *result = SCIP_CUTOFF;
-//    }
-//    else if (nfixedvars > 0)
-//    {
-//        *result = SCIP_REDUCEDDOM;
-//    }
-//    return SCIP_OKAY;
-//}
-//
-//// Check if all variables are valid for the given constraint
-//#ifdef DEBUG
-//static
-//void check_propagation(
-//    SCIP_PROBDATA* probdata,            // Problem data
-//    WaitBranchingConsData* consdata,    // Constraint data
-//    SCIP_Bool beforeprop                // Is this check performed before propagation?
-//)
-//{
-//    // Get the branching decision.
-//    const auto a = consdata->a;
-//    const auto t = consdata->t;
-//    const auto dir = consdata->dir;
-//
-//    // Get variables.
-//    const auto nvars = beforeprop ?
-//                       consdata->npropagatedvars :
-//                       SCIPprobdataGetAgentNVars(probdata)[a];
-//    release_assert(nvars <= SCIPprobdataGetAgentNVars(probdata)[a]);
-//    auto vars = SCIPprobdataGetAgentVars(probdata)[a];
-//
-//    // Check that the path of every variable is feasible for this constraint.
-//    for (Count v = 0; v < nvars; ++v)
-//    {
-//        // Get variable.
-//        auto var = vars[v];
-//        debug_assert(var);
-//
-//        // If the variable is locally fixed to zero, continue.
-//        if (SCIPvarGetUbLocal(var) < 0.5)
-//            continue;
-//
-//        // Get the path.
-//        auto vardata = SCIPvarGetData(var);
-//        const auto path_length = SCIPvardataGetPathLength(vardata);
-//        const auto path = SCIPvardataGetPath(vardata);
-//        debug_assert(a == SCIPvardataGetAgent(vardata));
-//
-//        // Calculate condition.
-//        const auto exists = (t < path_length && path[t].d == Direction::WAIT);
-//
-//        // Check.
-//        release_assert(!(exists != static_cast<bool>(dir)),
-//                       "Branching decision is not propagated correctly for agent {},"
-//                       "path {}",
-//                       a, format_path(probdata, path_length, path));
-//    }
-//}
-//#endif
-//
-//// Free constraint data
-//static
-//SCIP_DECL_CONSDELETE(consDeleteWaitBranching)
-//{
-//    // Check.
-//    debug_assert(conshdlr);
-//    debug_assert(strcmp(SCIPconshdlrGetName(conshdlr), CONSHDLR_NAME) == 0);
-//    debug_assert(consdata);
-//    debug_assert(*consdata);
-//
-//    // Free memory.
-//    SCIPfreeBlockMemory(scip, reinterpret_cast<WaitBranchingConsData**>(consdata));
-//
-//    // Done.
-//    return SCIP_OKAY;
-//}
-//
-//// Transform constraint data into data belonging to the transformed problem
-//static
-//SCIP_DECL_CONSTRANS(consTransWaitBranching)
-//{
-//    // Check.
-//    debug_assert(conshdlr);
-//    debug_assert(strcmp(SCIPconshdlrGetName(conshdlr), CONSHDLR_NAME) == 0);
-//    debug_assert(SCIPgetStage(scip) == SCIP_STAGE_TRANSFORMING);
-//    debug_assert(sourcecons);
-//    debug_assert(targetcons);
-//
-//    // Get data of original constraint.
-//    auto sourcedata =
-//        reinterpret_cast<WaitBranchingConsData*>(SCIPconsGetData(sourcecons));
-//    debug_assert(sourcedata);
-//
-//    // Create constraint data for target constraint.
-//    WaitBranchingConsData* targetdata;
-//    SCIP_CALL(consdataCreate(scip,
-//                             &targetdata,
-//                             sourcedata->dir,
-//                             sourcedata->a,
-//                             sourcedata->t,
-//                             sourcedata->node));
-//    debug_assert(targetdata);
-//
-//    // Create target constraint.
-//    char name[SCIP_MAXSTRLEN];
-//    SCIPsnprintf(name, SCIP_MAXSTRLEN, "t_%s", SCIPconsGetName(sourcecons));
-//    SCIP_CALL(SCIPcreateCons(scip,
-//                             targetcons,
-//                             SCIPconsGetName(sourcecons),
-//                             conshdlr,
-//                             reinterpret_cast<SCIP_CONSDATA*>(targetdata),
-//                             SCIPconsIsInitial(sourcecons),
-//                             SCIPconsIsSeparated(sourcecons),
-//                             SCIPconsIsEnforced(sourcecons),
-//                             SCIPconsIsChecked(sourcecons),
-//                             SCIPconsIsPropagated(sourcecons),
-//                             SCIPconsIsLocal(sourcecons),
-//                             SCIPconsIsModifiable(sourcecons),
-//                             SCIPconsIsDynamic(sourcecons),
-//                             SCIPconsIsRemovable(sourcecons),
-//                             SCIPconsIsStickingAtNode(sourcecons)));
-//
-//    // Done.
-//    return SCIP_OKAY;
-//}
-//
-//// Domain propagation method of constraint handler
-//static
-//SCIP_DECL_CONSPROP(consPropWaitBranching)
-//{
-//    // Check.
-//    debug_assert(scip);
-//    debug_assert(strcmp(SCIPconshdlrGetName(conshdlr), CONSHDLR_NAME) == 0);
-//    debug_assert(result);
-//
-//    // Get problem data.
-//    auto probdata = SCIPgetProbData(scip);
-//    const auto& agent_vars = SCIPprobdataGetAgentVars(probdata);
-//    const auto nvars = agent_vars.size();
-//
-//    // Propagate constraints.
-//    *result = SCIP_DIDNOTFIND;
-//    for (Count c = 0; c < nconss; ++c)
-//    {
-//        // Get constraint data.
-//        auto consdata =
-//            reinterpret_cast<WaitBranchingConsData*>(SCIPconsGetData(conss[c]));
-//        debug_assert(consdata);
-//        const auto a = consdata->a;
-//
-//        // Check if all variables are valid for this constraint.
-//#ifdef DEBUG
-//        check_propagation(probdata, consdata, TRUE);
-//#endif
-//
-//        // Propagate.
-//        if (!consdata->propagated)
-//        {
-//            // Print.
-//#ifdef PRINT_DEBUG
-//            debugln("Propagating wait branching constraint branch_{}({},{}) from node {} "
-//                    "at depth {} in node {} at depth {}",
-//                    consdata->dir == WaitBranchDirection::MustWait ?
-//                        "must_wait" : "cannot_wait",
-//                    consdata->a,
-//                    consdata->t,
-//                    SCIPnodeGetNumber(consdata->node),
-//                    SCIPnodeGetDepth(consdata->node),
-//                    SCIPnodeGetNumber(SCIPgetCurrentNode(scip)),
-//                    SCIPgetDepth(scip));
-//#endif
-//
-//            // Propagate.
-//            SCIP_CALL(fix_variables(scip,
-//                                    consdata,
-//                                    agent_nvars[a],
-//                                    agent_vars[a],
-//                                    result));
-//
-//            // Set status.
-//            if (*result != SCIP_CUTOFF)
-//            {
-//                consdata->propagated = TRUE;
-//                debug_assert(consdata->npropagatedvars <= agent_nvars[a]);
-//                consdata->npropagatedvars = agent_nvars[a];
-//            }
-//            else
-//            {
-//                break;
-//            }
-//        }
-//
-//        // Check if constraint is completely propagated.
-//#ifdef DEBUG
-//        check_propagation(probdata, consdata, FALSE);
-//#endif
-//    }
-//
-//    // Done.
-//    return SCIP_OKAY;
-//}
-//
-//// Constraint activation notification method of constraint handler
-//static
-//SCIP_DECL_CONSACTIVE(consActiveWaitBranching)
-//{
-//    // Check.
-//    debug_assert(scip);
-//    debug_assert(strcmp(SCIPconshdlrGetName(conshdlr), CONSHDLR_NAME) == 0);
-//    debug_assert(cons);
-//
-//    // Get problem data.
-//    auto probdata = SCIPgetProbData(scip);
-//    auto agent_nvars = SCIPprobdataGetAgentNVars(probdata);
-//
-//    // Get constraint data.
-//    auto consdata = reinterpret_cast<WaitBranchingConsData*>(SCIPconsGetData(cons));
-//    debug_assert(consdata);
-//    debug_assert(consdata->npropagatedvars <= agent_nvars[consdata->a]);
-//
-//    // Print.
-//#ifdef PRINT_DEBUG
-//    debugln("Activating wait branching constraint branch_{}({},{}) from node {} at depth "
-//            "{} in node {} at depth {}",
-//            consdata->dir == WaitBranchDirection::MustWait ? "must_wait" : "cannot_wait",
-//            consdata->a,
-//            consdata->t,
-//            SCIPnodeGetNumber(consdata->node),
-//            SCIPnodeGetDepth(consdata->node),
-//            SCIPnodeGetNumber(SCIPgetCurrentNode(scip)),
-//            SCIPgetDepth(scip));
-//#endif
-//
-//    // Mark constraint as to be repropagated.
-//    if (consdata->npropagatedvars != agent_nvars[consdata->a])
-//    {
-//        consdata->propagated = FALSE;
-//        SCIP_CALL(SCIPrepropagateNode(scip, consdata->node));
-//    }
-//
-//    // Done.
-//    return SCIP_OKAY;
-//}
-//
-//// Constraint deactivation notification method of constraint handler
-//static
-//SCIP_DECL_CONSDEACTIVE(consDeactiveWaitBranching)
-//{
-//    // Check.
-//    debug_assert(scip);
-//    debug_assert(strcmp(SCIPconshdlrGetName(conshdlr), CONSHDLR_NAME) == 0);
-//    debug_assert(cons);
-//
-//    // Get problem data.
-//    auto probdata = SCIPgetProbData(scip);
-//    auto agent_nvars = SCIPprobdataGetAgentNVars(probdata);
-//
-//    // Get constraint data.
-//    auto consdata = reinterpret_cast<WaitBranchingConsData*>(SCIPconsGetData(cons));
-//    debug_assert(consdata);
-//    debug_assert(consdata->propagated || SCIPgetNChildren(scip) == 0);
-//
-//    // Print.
-//#ifdef PRINT_DEBUG
-//    debugln("Deactivating wait branching constraint branch_{}({},{})",
-//            consdata->dir == WaitBranchDirection::MustWait ? "must_wait" : "cannot_wait",
-//            consdata->a,
-//            consdata->t);
-//#endif
-//
-//    // Set the number of propagated variables to the current number of variables.
-//    consdata->npropagatedvars = agent_nvars[consdata->a];
-//
-//    // Done.
-//    return SCIP_OKAY;
-//}
-//
-//// Create the constraint handler for a branch and include it
-//SCIP_RETCODE SCIPincludeConshdlrWaitBranching(
-//    SCIP* scip    // SCIP
-//)
-//{
-//    // Include constraint handler.
-//    SCIP_CONSHDLR* conshdlr = nullptr;
-//    SCIP_CALL(SCIPincludeConshdlrBasic(scip,
-//                                       &conshdlr,
-//                                       CONSHDLR_NAME,
-//                                       CONSHDLR_DESC,
-//                                       CONSHDLR_ENFOPRIORITY,
-//                                       CONSHDLR_CHECKPRIORITY,
-//                                       CONSHDLR_EAGERFREQ,
-//                                       CONSHDLR_NEEDSCONS,
-//                                       nullptr,
-//                                       nullptr,
-//                                       nullptr,
-//                                       nullptr,
-//                                       nullptr));
-//    debug_assert(conshdlr);
-//
-//    // Set callbacks.
-//    SCIP_CALL(SCIPsetConshdlrDelete(scip, conshdlr, consDeleteWaitBranching));
-//    SCIP_CALL(SCIPsetConshdlrTrans(scip, conshdlr, consTransWaitBranching));
-//    SCIP_CALL(SCIPsetConshdlrProp(scip,
-//                                  conshdlr,
-//                                  consPropWaitBranching,
-//                                  CONSHDLR_PROPFREQ,
-//                                  CONSHDLR_DELAYPROP,
-//                                  CONSHDLR_PROP_TIMING));
-//    SCIP_CALL(SCIPsetConshdlrActive(scip, conshdlr, consActiveWaitBranching));
-//    SCIP_CALL(SCIPsetConshdlrDeactive(scip, conshdlr, consDeactiveWaitBranching));
-//
-//    // Done.
-//    return SCIP_OKAY;
-//}
-//
-//// Create and capture a constraint enforcing a branch
-//SCIP_RETCODE SCIPcreateConsWaitBranching(
-//    SCIP* scip,                       // SCIP
-//    SCIP_CONS** cons,                 // Pointer to the created constraint
-//    const char* name,                 // Name of constraint
-//    const WaitBranchDirection dir,    // Branch direction
-//    const Agent a,                    // Agent
-//    const Time t,                     // Time
-//    SCIP_NODE* node,                  // The node of the branch-and-bound tree for this constraint
-//    SCIP_Bool local                   // Is this constraint only valid locally?
-//)
-//{
-//    // Find the constraint handler.
-//    auto conshdlr = SCIPfindConshdlr(scip, CONSHDLR_NAME);
-//    debug_assert(conshdlr);
-//
-//    // Create constraint data.
-//    WaitBranchingConsData* consdata;
-//    SCIP_CALL(consdataCreate(scip, &consdata, dir, a, t, node));
-//    debug_assert(consdata);
-//
-//    // Create constraint.
-//    SCIP_CALL(SCIPcreateCons(scip,
-//                             cons,
-//                             name,
-//                             conshdlr,
-//                             reinterpret_cast<SCIP_CONSDATA*>(consdata),
-//                             FALSE,
-//                             FALSE,
-//                             FALSE,
-//                             FALSE,
-//                             TRUE,
-//                             local,
-//                             FALSE,
-//                             FALSE,
-//                             FALSE,
-//                             TRUE));
-//
-//    // Print.
-//#ifdef PRINT_DEBUG
-//    debugln("Creating wait branching constraint branch_{}({},{}) in node {} at depth {} "
-//            "(parent {})",
-//            consdata->dir == WaitBranchDirection::MustWait ? "must_wait" : "cannot_wait",
-//            consdata->a,
-//            consdata->t,
-//            SCIPnodeGetNumber(consdata->node),
-//            SCIPnodeGetDepth(consdata->node),
-//            SCIPnodeGetNumber(SCIPnodeGetParent(consdata->node)));
-//#endif
-//
-//    // Done.
-//    return SCIP_OKAY;
-//}
-//
-//// Get branch direction
-//WaitBranchDirection SCIPgetWaitBranchingDirection(
-//    SCIP_CONS* cons    // Constraint enforcing wait branching
-//)
-//{
-//    debug_assert(cons);
-//    auto consdata = reinterpret_cast<WaitBranchingConsData*>(SCIPconsGetData(cons));
-//    debug_assert(consdata);
-//    return consdata->dir;
-//}
-//
-//// Get agent
-//Agent SCIPgetWaitBranchingAgent(
-//    SCIP_CONS* cons    // Constraint enforcing wait branching
-//)
-//{
-//    debug_assert(cons);
-//    auto consdata = reinterpret_cast<WaitBranchingConsData*>(SCIPconsGetData(cons));
-//    debug_assert(consdata);
-//    return consdata->a;
-//}
-//
-//// Get time
-//Time SCIPgetWaitBranchingTime(
-//    SCIP_CONS* cons    // Constraint enforcing wait branching
-//)
-//{
-//    debug_assert(cons);
-//    auto consdata = reinterpret_cast<WaitBranchingConsData*>(SCIPconsGetData(cons));
-//    debug_assert(consdata);
-//    return consdata->t;
-//}
+#define CONSHDLR_NAME          "wait_branching"
+#define CONSHDLR_DESC          "Stores the wait branching decisions"
+#define CONSHDLR_ENFOPRIORITY  0          // priority of the constraint handler for constraint enforcing
+#define CONSHDLR_CHECKPRIORITY 9999999    // priority of the constraint handler for checking feasibility
+#define CONSHDLR_PROPFREQ      1          // frequency for propagating domains; zero means only preprocessing propagation
+#define CONSHDLR_EAGERFREQ     1          // frequency for using all instead of only the useful constraints in separation,
+                                          // propagation and enforcement, -1 for no eager evaluations, 0 for first only
+#define CONSHDLR_DELAYPROP     FALSE      // should propagation method be delayed, if other propagators found reductions?
+#define CONSHDLR_NEEDSCONS     TRUE       // should the constraint handler be skipped, if no constraints are available?
+
+#define CONSHDLR_PROP_TIMING   SCIP_PROPTIMING_BEFORELP
+
+// Constraint data
+struct WaitBranchingConsData
+{
+    WaitBranchDirection dir;      // Branch direction
+    Agent a;                      // Agent
+    NodeTime nt;                  // Node-time of the wait
+    Int npropagatedvars;          // Number of variables that existed when the related node
+                                  // was propagated the last time. Used to determine whether
+                                  // the constraint should be repropagated
+#ifdef USE_LNS2_REPAIR_PRIMAL_HEURISTIC
+    Int npropagatedheuristicvars; // Number of variables added by primal heuristics that existed
+                                  // when the related node was propagated the last time. These
+                                  // variables can ignore the branching decision
+#endif
+    bool propagated : 1;          // Is the constraint already propagated?
+    SCIP_NODE* node;              // The node of the branch-and-bound tree for this constraint
+};
+
+// Create constraint data
+static
+SCIP_RETCODE consdataCreate(
+    SCIP* scip,                          // SCIP
+    WaitBranchingConsData** consdata,    // Pointer to the constraint data
+    const WaitBranchDirection dir,       // Branch direction
+    const Agent a,                       // Agent
+    const NodeTime nt,                   // Node-time of the wait
+    SCIP_NODE* node                      // Node of the branch-and-bound tree for this constraint
+)
+{
+    // Check.
+    debug_assert(scip);
+    debug_assert(consdata);
+
+    // Allocate memory.
+    SCIP_CALL(SCIPallocBlockMemory(scip, consdata));
+
+    // Store data.
+    (*consdata)->dir = dir;
+    (*consdata)->a = a;
+    (*consdata)->nt = nt;
+    (*consdata)->npropagatedvars = 0;
+#ifdef USE_LNS2_REPAIR_PRIMAL_HEURISTIC
+    (*consdata)->npropagatedheuristicvars = 0;
+#endif
+    (*consdata)->propagated = false;
+    (*consdata)->node = node;
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Fix a variable to zero if its path is not valid for this constraint/branch
+static inline
+SCIP_RETCODE check_variable(
+    SCIP* scip,                       // SCIP
+    const WaitBranchDirection dir,    // Branch direction
+    const Agent a,                    // Agent
+    const NodeTime nt,                // Node-time of the wait
+    SCIP_VAR* var,                    // Variable to check
+    Int& nfixedvars,                  // Pointer to store the number of fixed variables
+    SCIP_Bool* cutoff                 // Pointer to store if a cutoff was detected
+)
+{
+    // Check.
+    debug_assert(scip);
+    debug_assert(var);
+    debug_assert(cutoff);
+
+    // If the variable is locally fixed to zero, continue to next variable.
+    if (SCIPvarGetUbLocal(var) < 0.5)
+        return SCIP_OKAY;
+
+    // Get the path.
+    auto vardata = SCIPvarGetData(var);
+    const auto path_a = SCIPvardataGetAgent(vardata);
+    const auto path_length = SCIPvardataGetPathLength(vardata);
+    const auto path = SCIPvardataGetPath(vardata);
+
+    // Disable a path of the agent if it does or doesn't wait at the vertex. The paths of the other agents are
+    // unaffected.
+    if (path_a == a && path_waits_at(path_length, path, nt) != static_cast<bool>(dir))
+    {
+        // Disable the variable.
+        SCIP_Bool success;
+        SCIP_Bool fixing_is_infeasible;
+        SCIP_CALL(SCIPfixVar(scip, var, 0.0, &fixing_is_infeasible, &success));
+
+        // Print.
+        debugln("      Disabling variable for agent {}, path {}",
+                path_a, format_path(SCIPgetProbData(scip), path_length, path));
+
+        // Cut off the node if the fixing is infeasible.
+        if (fixing_is_infeasible)
+        {
+            debug_assert(SCIPvarGetLbLocal(var) > 0.5);
+            debugln("         Node is infeasible - cut off");
+            (*cutoff) = TRUE;
+        }
+        else
+        {
+            debug_assert(success);
+            nfixedvars++;
+        }
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Fix variables to zero if its path is not valid for this constraint/branching. Only the variables of the agent can
+// be invalid so the other variables are skipped.
+static
+SCIP_RETCODE fix_variables(
+    SCIP* scip,                                        // SCIP
+    WaitBranchingConsData* consdata,                   // Constraint data
+    const Vector<Pair<SCIP_VAR*, SCIP_Real>>& vars,    // Array of variables
+    SCIP_RESULT* result                                // Pointer to store the result of the fixing
+)
+{
+    // Print.
+    debugln("   Checking variables {} to {}:", consdata->npropagatedvars, vars.size());
+
+    // Check.
+    const auto nvars = static_cast<Int>(vars.size());
+    debug_assert(consdata->npropagatedvars <= nvars);
+
+    // Get the index of the variables of the agent.
+    auto probdata = SCIPgetProbData(scip);
+    const auto& agent_var_indices = SCIPprobdataGetAgentVarIndices(probdata)[consdata->a];
+
+    // Check every new variable of the agent.
+    Int nfixedvars = 0;
+    SCIP_Bool cutoff = FALSE;
+    for (auto it = std::lower_bound(agent_var_indices.begin(),
+                                    agent_var_indices.end(),
+                                    consdata->npropagatedvars);
+         it != agent_var_indices.end() && !cutoff;
+         ++it)
+    {
+        debug_assert(*it < nvars);
+        SCIP_CALL(check_variable(scip,
+                                 consdata->dir,
+                                 consdata->a,
+                                 consdata->nt,
+                                 vars[*it].first,
+                                 nfixedvars,
+                                 &cutoff));
+    }
+
+    // Check the new variables of primal heuristics that were added before the propagated variables.
+#ifdef USE_LNS2_REPAIR_PRIMAL_HEURISTIC
+    const auto& heuristic_var_indices = SCIPprobdataGetHeuristicVarIndices(probdata);
+    const auto nheuristicvars = static_cast<Int>(heuristic_var_indices.size());
+    debug_assert(consdata->npropagatedheuristicvars <= nheuristicvars);
+    for (Int i = consdata->npropagatedheuristicvars; i < nheuristicvars && !cutoff; ++i)
+    {
+        const auto v = heuristic_var_indices[i];
+        if (0 <= v && v < consdata->npropagatedvars)
+        {
+            SCIP_CALL(check_variable(scip,
+                                     consdata->dir,
+                                     consdata->a,
+                                     consdata->nt,
+                                     vars[v].first,
+                                     nfixedvars,
+                                     &cutoff));
+        }
+    }
+#endif
+
+    // Print.
+    debugln("   Disabled {} variables", nfixedvars);
+
+    // Done.
+    if (cutoff)
+    {
+        *result = SCIP_CUTOFF;
+    }
+    else if (nfixedvars > 0)
+    {
+        *result = SCIP_REDUCEDDOM;
+    }
+    return SCIP_OKAY;
+}
+
+// Check if all variables are valid for the given constraint
+#ifdef DEBUG
+static
+void check_propagation(
+    SCIP_PROBDATA* probdata,            // Problem data
+    WaitBranchingConsData* consdata,    // Constraint data
+    SCIP_Bool beforeprop                // Is this check performed before propagation?
+)
+{
+    // Get variables.
+    const auto& vars = SCIPprobdataGetVars(probdata);
+    const auto nvars = beforeprop ? consdata->npropagatedvars : static_cast<Int>(vars.size());
+    release_assert(nvars <= static_cast<Int>(vars.size()));
+
+    // Skip the variables of primal heuristics that are not propagated yet.
+#ifdef USE_LNS2_REPAIR_PRIMAL_HEURISTIC
+    Vector<bool> skip(nvars, false);
+    if (beforeprop)
+    {
+        const auto& heuristic_var_indices = SCIPprobdataGetHeuristicVarIndices(probdata);
+        for (Int i = consdata->npropagatedheuristicvars; i < static_cast<Int>(heuristic_var_indices.size()); ++i)
+        {
+            const auto v = heuristic_var_indices[i];
+            if (0 <= v && v < nvars)
+            {
+                skip[v] = true;
+            }
+        }
+    }
+#endif
+
+    // Check that the path of every variable is feasible for this constraint.
+    for (Int v = 0; v < nvars; ++v)
+    {
+        // Get variable.
+        const auto var = vars[v].first;
+        debug_assert(var);
+
+        // If the variable is locally fixed to zero, continue.
+        if (SCIPvarGetUbLocal(var) < 0.5)
+            continue;
+#ifdef USE_LNS2_REPAIR_PRIMAL_HEURISTIC
+        if (skip[v])
+            continue;
+#endif
+
+        // Get the path.
+        auto vardata = SCIPvarGetData(var);
+        const auto path_a = SCIPvardataGetAgent(vardata);
+        const auto path_length = SCIPvardataGetPathLength(vardata);
+        const auto path = SCIPvardataGetPath(vardata);
+
+        // Check.
+        release_assert(path_a != consdata->a ||
+                       path_waits_at(path_length, path, consdata->nt) == static_cast<bool>(consdata->dir),
+                       "Branching decision is not propagated correctly for agent {}, path {}",
+                       path_a, format_path(probdata, path_length, path));
+    }
+}
+#endif
+
+// Free constraint data
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_CONSDELETE(consDeleteWaitBranching)
+{
+    // Check.
+    debug_assert(conshdlr);
+    debug_assert(strcmp(SCIPconshdlrGetName(conshdlr), CONSHDLR_NAME) == 0);
+    debug_assert(consdata);
+    debug_assert(*consdata);
+
+    // Free memory.
+    SCIPfreeBlockMemory(scip, reinterpret_cast<WaitBranchingConsData**>(consdata));
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Transform constraint data into data belonging to the transformed problem
+static
+SCIP_DECL_CONSTRANS(consTransWaitBranching)
+{
+    // Check.
+    debug_assert(conshdlr);
+    debug_assert(strcmp(SCIPconshdlrGetName(conshdlr), CONSHDLR_NAME) == 0);
+    debug_assert(SCIPgetStage(scip) == SCIP_STAGE_TRANSFORMING);
+    debug_assert(sourcecons);
+    debug_assert(targetcons);
+
+    // Get original data.
+    auto sourcedata =
+        reinterpret_cast<WaitBranchingConsData*>(SCIPconsGetData(sourcecons));
+    debug_assert(sourcedata);
+
+    // Create constraint data for target constraint.
+    WaitBranchingConsData* targetdata;
+    SCIP_CALL(consdataCreate(scip,
+                             &targetdata,
+                             sourcedata->dir,
+                             sourcedata->a,
+                             sourcedata->nt,
+                             sourcedata->node));
+    debug_assert(targetdata);
+
+    // Create target constraint.
+    SCIP_CALL(SCIPcreateCons(scip,
+                             targetcons,
+                             SCIPconsGetName(sourcecons),
+                             conshdlr,
+                             reinterpret_cast<SCIP_CONSDATA*>(targetdata),
+                             SCIPconsIsInitial(sourcecons),
+                             SCIPconsIsSeparated(sourcecons),
+                             SCIPconsIsEnforced(sourcecons),
+                             SCIPconsIsChecked(sourcecons),
+                             SCIPconsIsPropagated(sourcecons),
+                             SCIPconsIsLocal(sourcecons),
+                             SCIPconsIsModifiable(sourcecons),
+                             SCIPconsIsDynamic(sourcecons),
+                             SCIPconsIsRemovable(sourcecons),
+                             SCIPconsIsStickingAtNode(sourcecons)));
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Domain propagation method of constraint handler
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_CONSPROP(consPropWaitBranching)
+{
+    // Check.
+    debug_assert(scip);
+    debug_assert(strcmp(SCIPconshdlrGetName(conshdlr), CONSHDLR_NAME) == 0);
+    debug_assert(result);
+
+    // Get problem data.
+    auto probdata = SCIPgetProbData(scip);
+
+    // Get variables.
+    const auto& vars = SCIPprobdataGetVars(probdata);
+    const auto nvars = static_cast<Int>(vars.size());
+#ifdef USE_LNS2_REPAIR_PRIMAL_HEURISTIC
+    const auto nheuristicvars = static_cast<Int>(SCIPprobdataGetHeuristicVarIndices(probdata).size());
+#endif
+
+    // Propagate constraints.
+    *result = SCIP_DIDNOTFIND;
+    for (Int c = 0; c < nconss; ++c)
+    {
+        // Get constraint data.
+        auto consdata = reinterpret_cast<WaitBranchingConsData*>(SCIPconsGetData(conss[c]));
+        debug_assert(consdata);
+
+        // Check if all variables are valid for this constraint.
+#ifdef DEBUG
+        check_propagation(probdata, consdata, TRUE);
+#endif
+
+        // Propagate if the constraint is not propagated or if primal heuristics added variables since the last
+        // propagation.
+#ifdef USE_LNS2_REPAIR_PRIMAL_HEURISTIC
+        if (!consdata->propagated || consdata->npropagatedheuristicvars != nheuristicvars)
+#else
+        if (!consdata->propagated)
+#endif
+        {
+            // Print.
+#ifdef PRINT_DEBUG
+            {
+                const auto& map = SCIPprobdataGetMap(probdata);
+                const auto [x, y] = map.get_xy(consdata->nt.n);
+                debugln("Propagating wait branching constraint branch_{}({},({},{}),{})"
+                        " from node {} at depth {} in node {} at depth {}",
+                        consdata->dir == WaitBranchDirection::MustWait ? "must_wait" : "cannot_wait",
+                        consdata->a,
+                        x, y,
+                        consdata->nt.t,
+                        SCIPnodeGetNumber(consdata->node),
+                        SCIPnodeGetDepth(consdata->node),
+                        SCIPnodeGetNumber(SCIPgetCurrentNode(scip)),
+                        SCIPgetDepth(scip));
+            }
+#endif
+
+            // Propagate.
+            SCIP_CALL(fix_variables(scip, consdata, vars, result));
+
+            // Set status.
+            if (*result != SCIP_CUTOFF)
+            {
+                consdata->propagated = TRUE;
+                consdata->npropagatedvars = nvars;
+#ifdef USE_LNS2_REPAIR_PRIMAL_HEURISTIC
+                consdata->npropagatedheuristicvars = nheuristicvars;
+#endif
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        // Check if constraint is completely propagated.
+#ifdef DEBUG
+        check_propagation(probdata, consdata, FALSE);
+#endif
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Constraint activation notification method of constraint handler
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_CONSACTIVE(consActiveWaitBranching)
+{
+    // Check.
+    debug_assert(scip);
+    debug_assert(strcmp(SCIPconshdlrGetName(conshdlr), CONSHDLR_NAME) == 0);
+    debug_assert(cons);
+
+    // Get problem data.
+    auto probdata = SCIPgetProbData(scip);
+
+    // Get variables.
+    const auto& vars = SCIPprobdataGetVars(probdata);
+    const auto nvars = static_cast<Int>(vars.size());
+
+    // Get constraint data.
+    auto consdata = reinterpret_cast<WaitBranchingConsData*>(SCIPconsGetData(cons));
+    debug_assert(consdata);
+    debug_assert(consdata->npropagatedvars <= nvars);
+
+    // Print.
+#ifdef PRINT_DEBUG
+    {
+        const auto& map = SCIPprobdataGetMap(probdata);
+        const auto [x, y] = map.get_xy(consdata->nt.n);
+        debugln("Activating wait branching constraint branch_{}({},({},{}),{}) from "
+                "node {} at depth {} in node {} at depth {}",
+                consdata->dir == WaitBranchDirection::MustWait ? "must_wait" : "cannot_wait",
+                consdata->a,
+                x, y,
+                consdata->nt.t,
+                SCIPnodeGetNumber(consdata->node),
+                SCIPnodeGetDepth(consdata->node),
+                SCIPnodeGetNumber(SCIPgetCurrentNode(scip)),
+                SCIPgetDepth(scip));
+    }
+#endif
+
+    // Mark constraint as to be repropagated.
+#ifdef USE_LNS2_REPAIR_PRIMAL_HEURISTIC
+    const auto nheuristicvars = static_cast<Int>(SCIPprobdataGetHeuristicVarIndices(probdata).size());
+    if (consdata->npropagatedvars != nvars || consdata->npropagatedheuristicvars != nheuristicvars)
+#else
+    if (consdata->npropagatedvars != nvars)
+#endif
+    {
+        consdata->propagated = FALSE;
+        SCIP_CALL(SCIPrepropagateNode(scip, consdata->node));
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Constraint deactivation notification method of constraint handler
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_CONSDEACTIVE(consDeactiveWaitBranching)
+{
+    // Check.
+    debug_assert(scip);
+    debug_assert(strcmp(SCIPconshdlrGetName(conshdlr), CONSHDLR_NAME) == 0);
+    debug_assert(cons);
+
+    // Get problem data.
+    auto probdata = SCIPgetProbData(scip);
+
+    // Get constraint data.
+    auto consdata = reinterpret_cast<WaitBranchingConsData*>(SCIPconsGetData(cons));
+    debug_assert(consdata);
+    debug_assert(consdata->propagated || SCIPgetNChildren(scip) == 0);
+
+    // Print.
+#ifdef PRINT_DEBUG
+    {
+        const auto& map = SCIPprobdataGetMap(probdata);
+        const auto [x, y] = map.get_xy(consdata->nt.n);
+        debugln("Deactivating wait branching constraint branch_{}({},({},{}),{})",
+                consdata->dir == WaitBranchDirection::MustWait ? "must_wait" : "cannot_wait",
+                consdata->a,
+                x, y,
+                consdata->nt.t);
+    }
+#endif
+
+    // Set the number of propagated variables to the current number of variables because the new variables always
+    // respect the constraint (branching decision). The variables of primal heuristics are checked from their list.
+    const auto& vars = SCIPprobdataGetVars(probdata);
+    consdata->npropagatedvars = vars.size();
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Create the constraint handler for a branch and include it
+SCIP_RETCODE SCIPincludeConshdlrWaitBranching(
+    SCIP* scip    // SCIP
+)
+{
+    // Include constraint handler.
+    SCIP_CONSHDLR* conshdlr = nullptr;
+    SCIP_CALL(SCIPincludeConshdlrBasic(scip,
+                                       &conshdlr,
+                                       CONSHDLR_NAME,
+                                       CONSHDLR_DESC,
+                                       CONSHDLR_ENFOPRIORITY,
+                                       CONSHDLR_CHECKPRIORITY,
+                                       CONSHDLR_EAGERFREQ,
+                                       CONSHDLR_NEEDSCONS,
+                                       nullptr,
+                                       nullptr,
+                                       nullptr,
+                                       nullptr,
+                                       nullptr));
+    debug_assert(conshdlr);
+
+    // Set callbacks.
+    SCIP_CALL(SCIPsetConshdlrDelete(scip, conshdlr, consDeleteWaitBranching));
+    SCIP_CALL(SCIPsetConshdlrTrans(scip, conshdlr, consTransWaitBranching));
+    SCIP_CALL(SCIPsetConshdlrProp(scip,
+                                  conshdlr,
+                                  consPropWaitBranching,
+                                  CONSHDLR_PROPFREQ,
+                                  CONSHDLR_DELAYPROP,
+                                  CONSHDLR_PROP_TIMING));
+    SCIP_CALL(SCIPsetConshdlrActive(scip, conshdlr, consActiveWaitBranching));
+    SCIP_CALL(SCIPsetConshdlrDeactive(scip, conshdlr, consDeactiveWaitBranching));
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Create and capture a constraint enforcing a branch
+SCIP_RETCODE SCIPcreateConsWaitBranching(
+    SCIP* scip,                       // SCIP
+    SCIP_CONS** cons,                 // Pointer to the created constraint
+    const char* name,                 // Name of constraint
+    const WaitBranchDirection dir,    // Branch direction
+    const Agent a,                    // Agent
+    const NodeTime nt,                // Node-time of the wait
+    SCIP_NODE* node,                  // The node of the branch-and-bound tree for this constraint
+    SCIP_Bool local                   // Is this constraint only valid locally?
+)
+{
+    // Find the constraint handler.
+    auto conshdlr = SCIPfindConshdlr(scip, CONSHDLR_NAME);
+    debug_assert(conshdlr);
+
+    // Create constraint data.
+    WaitBranchingConsData* consdata;
+    SCIP_CALL(consdataCreate(scip, &consdata, dir, a, nt, node));
+    debug_assert(consdata);
+
+    // Create constraint.
+    SCIP_CALL(SCIPcreateCons(scip,
+                             cons,
+                             name,
+                             conshdlr,
+                             reinterpret_cast<SCIP_CONSDATA*>(consdata),
+                             FALSE,
+                             FALSE,
+                             FALSE,
+                             FALSE,
+                             TRUE,
+                             local,
+                             FALSE,
+                             FALSE,
+                             FALSE,
+                             TRUE));
+
+    // Print.
+#ifdef PRINT_DEBUG
+    {
+        auto probdata = SCIPgetProbData(scip);
+        const auto& map = SCIPprobdataGetMap(probdata);
+        const auto [x, y] = map.get_xy(consdata->nt.n);
+        debugln("Creating wait branching constraint branch_{}({},({},{}),{}) in node "
+                "{} at depth {} (parent {})",
+                consdata->dir == WaitBranchDirection::MustWait ? "must_wait" : "cannot_wait",
+                consdata->a,
+                x, y,
+                consdata->nt.t,
+                SCIPnodeGetNumber(consdata->node),
+                SCIPnodeGetDepth(consdata->node),
+                SCIPnodeGetNumber(SCIPnodeGetParent(consdata->node)));
+    }
+#endif
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Get branch direction
+WaitBranchDirection SCIPgetWaitBranchingDirection(
+    SCIP_CONS* cons    // Constraint enforcing wait branching
+)
+{
+    debug_assert(cons);
+    auto consdata = reinterpret_cast<WaitBranchingConsData*>(SCIPconsGetData(cons));
+    debug_assert(consdata);
+    return consdata->dir;
+}
+
+// Get agent
+Agent SCIPgetWaitBranchingAgent(
+    SCIP_CONS* cons    // Constraint enforcing wait branching
+)
+{
+    debug_assert(cons);
+    auto consdata = reinterpret_cast<WaitBranchingConsData*>(SCIPconsGetData(cons));
+    debug_assert(consdata);
+    return consdata->a;
+}
+
+// Get node-time
+NodeTime SCIPgetWaitBranchingNodeTime(
+    SCIP_CONS* cons    // Constraint enforcing wait branching
+)
+{
+    debug_assert(cons);
+    auto consdata = reinterpret_cast<WaitBranchingConsData*>(SCIPconsGetData(cons));
+    debug_assert(consdata);
+    return consdata->nt;
+}
+
+// Renumber the variables propagated by every wait branching constraint after the deleted variables are removed from
+// the problem data
+void SCIPrenumberWaitBranchingVars(
+    SCIP* scip,                        // SCIP
+    const Vector<Int>& nb_kept_vars    // Number of variables kept before each index of the old array of variables
+)
+{
+    // The variables are compacted in order, so the variables propagated by a constraint are still the first ones.
+    auto conshdlr = SCIPfindConshdlr(scip, CONSHDLR_NAME);
+    debug_assert(conshdlr);
+    auto conss = SCIPconshdlrGetConss(conshdlr);
+    const auto nconss = SCIPconshdlrGetNConss(conshdlr);
+    for (Int c = 0; c < nconss; ++c)
+    {
+        auto consdata = reinterpret_cast<WaitBranchingConsData*>(SCIPconsGetData(conss[c]));
+        debug_assert(consdata);
+        debug_assert(0 <= consdata->npropagatedvars &&
+                     consdata->npropagatedvars < static_cast<Int>(nb_kept_vars.size()));
+        consdata->npropagatedvars = nb_kept_vars[consdata->npropagatedvars];
+    }
+}
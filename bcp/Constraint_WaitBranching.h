@@ -17,48 +17,67 @@ along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
 Author: Edward Lam <ed@ed-lam.com>
 */
 
-//#ifndef MAPF_CONSTRAINT_WAITBRANCHING_H
-//#define MAPF_CONSTRAINT_WAITBRANCHING_H
-//
-//#include "Includes.h"
-//#include "Coordinates.h"
-//
-//enum WaitBranchDirection : bool
-//{
-//    CannotWait = false,
-//    MustWait = true
-//};
-//
-//// Create the constraint handler for a branch and include it
-//SCIP_RETCODE SCIPincludeConshdlrWaitBranching(
-//    SCIP* scip    // SCIP
-//);
-//
-//// Create and capture a constraint enforcing a branch
-//SCIP_RETCODE SCIPcreateConsWaitBranching(
-//    SCIP* scip,                       // SCIP
-//    SCIP_CONS** cons,                 // Pointer to the created constraint
-//    const char* name,                 // Name of constraint
-//    const WaitBranchDirection dir,    // Branch direction
-//    const Agent a,                    // Agent
-//    const Time t,                     // Time
-//    SCIP_NODE* node,                  // The node of the branch-and-bound tree for this constraint
-//    SCIP_Bool local                   // Is this constraint only valid locally?
-//);
-//
-//// Get branch direction
-//WaitBranchDirection SCIPgetWaitBranchingDirection(
-//    SCIP_CONS* cons    // Constraint enforcing wait branching
-//);
-//
-//// Get agent
-//Agent SCIPgetWaitBranchingAgent(
-//    SCIP_CONS* cons    // Constraint enforcing wait branching
-//);
-//
-//// Get time
-//Time SCIPgetWaitBranchingTime(
-//    SCIP_CONS* cons    // Constraint enforcing wait branching
-//);
-//
-//#endif
+#ifndef MAPF_CONSTRAINT_WAITBRANCHING_H
+#define MAPF_CONSTRAINT_WAITBRANCHING_H
+
+#include "Includes.h"
+#include "Coordinates.h"
+
+enum WaitBranchDirection : bool
+{
+    CannotWait = false,
+    MustWait = true
+};
+
+// Check if a path waits at a vertex. A path waits at every time after it reaches its goal.
+inline bool path_waits_at(
+    const Time path_length,    // Path length
+    const Edge* const path,    // Path
+    const NodeTime nt          // Node-time of the wait
+)
+{
+    return nt.t < path_length - 1 ?
+           path[nt.t].n == nt.n && path[nt.t].d == Direction::WAIT :
+           path[path_length - 1].n == nt.n;
+}
+
+// Create the constraint handler for a branch and include it
+SCIP_RETCODE SCIPincludeConshdlrWaitBranching(
+    SCIP* scip    // SCIP
+);
+
+// Create and capture a constraint enforcing a branch
+SCIP_RETCODE SCIPcreateConsWaitBranching(
+    SCIP* scip,                       // SCIP
+    SCIP_CONS** cons,                 // Pointer to the created constraint
+    const char* name,                 // Name of constraint
+    const WaitBranchDirection dir,    // Branch direction
+    const Agent a,                    // Agent
+    const NodeTime nt,                // Node-time of the wait
+    SCIP_NODE* node,                  // The node of the branch-and-bound tree for this constraint
+    SCIP_Bool local                   // Is this constraint only valid locally?
+);
+
+// Get branch direction
+WaitBranchDirection SCIPgetWaitBranchingDirection(
+    SCIP_CONS* cons    // Constraint enforcing wait branching
+);
+
+// Get agent
+Agent SCIPgetWaitBranchingAgent(
+    SCIP_CONS* cons    // Constraint enforcing wait branching
+);
+
+// Get node-time
+NodeTime SCIPgetWaitBranchingNodeTime(
+    SCIP_CONS* cons    // Constraint enforcing wait branching
+);
+
+// Renumber the variables propagated by every wait branching constraint after the deleted variables are removed from
+// the problem data
+void SCIPrenumberWaitBranchingVars(
+    SCIP* scip,                        // SCIP
+    const Vector<Int>& nb_kept_vars    // Number of variables kept before each index of the old array of variables
+);
+
+#endif
@@ -0,0 +1,424 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#ifdef USE_DIVING_PRIMAL_HEURISTIC
+
+// #define PRINT_DEBUG
+
+#include "Heuristic_Diving.h"
+#include "Heuristic_Planning.h"
+#include "Pricer_TruffleHog.h"
+#include "ProblemData.h"
+#include "VariableData.h"
+#include "Trace.h"
+#include "ConstraintHandler_VertexConflicts.h"
+#include "ConstraintHandler_EdgeConflicts.h"
+#include <chrono>
+#include <algorithm>
+
+#define HEUR_NAME             "mapf-diving"
+#define HEUR_DESC             "MAPF LP-guided diving with A* repair"
+#define HEUR_DISPCHAR         'D'
+#define HEUR_PRIORITY         9000
+#define HEUR_FREQ             1
+#define HEUR_FREQOFS          0
+#define HEUR_MAXDEPTH         -1
+#define HEUR_TIMING           SCIP_HEURTIMING_AFTERLPNODE
+#define HEUR_USESSUBSCIP      FALSE    // Does the heuristic use a secondary SCIP instance?
+
+#ifndef DIVING_TIME_LIMIT
+#define DIVING_TIME_LIMIT 1.0       // Time limit in seconds of each call
+#endif
+
+struct DivingData
+{
+    SCIP_CONSHDLR* vertex_branching_conshdlr;           // Constraint handler for vertex branching
+    SCIP_CONSHDLR* wait_branching_conshdlr;             // Constraint handler for wait branching
+    SCIP_CONSHDLR* length_branching_conshdlr;           // Constraint handler for length branching
+};
+
+// Initialize primal heuristic (called after the problem was transformed)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_HEURINIT(heurInitDiving)
+{
+    // Check.
+    debug_assert(scip);
+    debug_assert(heur);
+
+    // Create heuristic data.
+    DivingData* heurdata;
+    SCIP_CALL(SCIPallocBlockMemory(scip, &heurdata));
+    new (heurdata) DivingData;
+
+    // Find constraint handler for branching decisions.
+    heurdata->vertex_branching_conshdlr = SCIPfindConshdlr(scip, "vertex_branching");
+    release_assert(heurdata->vertex_branching_conshdlr,
+                   "Constraint handler for vertex branching is missing");
+    heurdata->wait_branching_conshdlr = SCIPfindConshdlr(scip, "wait_branching");
+    release_assert(heurdata->wait_branching_conshdlr,
+                   "Constraint handler for wait branching is missing");
+    heurdata->length_branching_conshdlr = SCIPfindConshdlr(scip, "length_branching");
+    release_assert(heurdata->length_branching_conshdlr,
+                   "Constraint handler for length branching rule is missing");
+
+    // Set pointer to pricer data.
+    SCIPheurSetData(heur, reinterpret_cast<SCIP_HeurData*>(heurdata));
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Free primal heuristic
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_HEURFREE(heurFreeDiving)
+{
+    // Check.
+    debug_assert(scip);
+    debug_assert(heur);
+
+    // Get heuristic data.
+    auto heurdata = reinterpret_cast<DivingData*>(SCIPheurGetData(heur));
+    debug_assert(heurdata);
+
+    // Deallocate.
+    heurdata->~DivingData();
+    SCIPfreeBlockMemory(scip, &heurdata);
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Get the dual value of a row, or zero if the row is not in the LP
+static inline SCIP_Real get_dual(SCIP_ROW* row)
+{
+    return SCIProwGetLPPos(row) >= 0 ? SCIProwGetDualsol(row) : 0.0;
+}
+
+// Make edge penalties from the duals of the vertex and edge conflicts
+static void make_dual_edge_penalties(SCIP* scip, SCIP_ProbData* probdata, const Map& map, EdgePenalties& edge_penalties)
+{
+    // Input dual values for vertex conflicts.
+    for (const auto& [nt, vertex_conflict] : vertex_conflicts_get_constraints(probdata))
+    {
+        const auto& [row] = vertex_conflict;
+        const auto dual = get_dual(row);
+        if (SCIPisFeasLT(scip, dual, 0.0))
+        {
+            // Add the dual variable value to the edges leading into the vertex.
+            const auto t = nt.t - 1;
+            {
+                const auto n = map.get_south(nt.n);
+                auto& penalties = edge_penalties.get_edge_penalties(n, t);
+                penalties.north -= dual;
+            }
+            {
+                const auto n = map.get_north(nt.n);
+                auto& penalties = edge_penalties.get_edge_penalties(n, t);
+                penalties.south -= dual;
+            }
+            {
+                const auto n = map.get_west(nt.n);
+                auto& penalties = edge_penalties.get_edge_penalties(n, t);
+                penalties.east -= dual;
+            }
+            {
+                const auto n = map.get_east(nt.n);
+                auto& penalties = edge_penalties.get_edge_penalties(n, t);
+                penalties.west -= dual;
+            }
+            {
+                const auto n = map.get_wait(nt.n);
+                auto& penalties = edge_penalties.get_edge_penalties(n, t);
+                penalties.wait -= dual;
+            }
+        }
+    }
+
+    // Input dual values for edge conflicts.
+    for (const auto& [et, edge_conflict] : edge_conflicts_get_constraints(probdata))
+    {
+        const auto& [row, edges, t] = edge_conflict;
+        const auto dual = get_dual(row);
+        if (SCIPisFeasLT(scip, dual, 0.0))
+        {
+            // Add the dual variable value to the edges.
+            for (const auto e : edges)
+            {
+                auto& penalties = edge_penalties.get_edge_penalties(e.n, t);
+                penalties.d[e.d] -= dual;
+            }
+        }
+    }
+}
+
+// Execution method of primal heuristic
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_HEUREXEC(heurExecDiving)
+{
+    // Trace.
+    const TraceScope trace(HEUR_NAME);
+
+    // Do not run if the node is infeasible or the duals are not available.
+    if (nodeinfeasible || SCIPgetLPSolstat(scip) != SCIP_LPSOLSTAT_OPTIMAL)
+    {
+        *result = SCIP_DIDNOTRUN;
+        return SCIP_OKAY;
+    }
+
+    // Initialize.
+    *result = SCIP_DIDNOTFIND;
+    const auto deadline = std::chrono::steady_clock::now() +
+                          std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                              std::chrono::duration<double>(DIVING_TIME_LIMIT));
+
+    // Get problem data.
+    auto probdata = SCIPgetProbData(scip);
+    const auto N = SCIPprobdataGetN(probdata);
+    const auto& map = SCIPprobdataGetMap(probdata);
+    const auto& agents = SCIPprobdataGetAgentsData(probdata);
+
+    // Update variable values.
+    update_variable_values(scip);
+
+    // Get heuristic data.
+    auto heurdata = reinterpret_cast<DivingData*>(SCIPheurGetData(heur));
+    debug_assert(heurdata);
+
+    // Get variables.
+    const auto& agent_vars = SCIPprobdataGetAgentVars(probdata);
+
+    // Get the low-level solver. The solver of the pricer is idle while the heuristic runs.
+    const auto& astars = SCIPpricerTruffleHogGetAStars(scip);
+    auto& astar = astars.empty() ? SCIPprobdataGetAStar(probdata) : *astars.front();
+    const auto max_path_length = astar.max_path_length();
+    debug_assert(max_path_length >= 1);
+
+    // Collect the branching decisions of each agent.
+    Vector<HeuristicAgentInput> agent_inputs;
+    Vector<AgentNodeTime> blocked_targets;
+    heuristic_get_agent_inputs(scip,
+                               heurdata->vertex_branching_conshdlr,
+                               heurdata->wait_branching_conshdlr,
+                               heurdata->length_branching_conshdlr,
+                               max_path_length,
+                               agent_inputs,
+                               blocked_targets);
+
+    // Collect the columns with a positive value in the LP, closest to 1 first, and the largest value of each agent.
+    struct Candidate
+    {
+        SCIP_Real val;
+        Agent a;
+        SCIP_VAR* var;
+    };
+    Vector<Candidate> candidates;
+    Vector<SCIP_Real> agent_max_val(N, 0.0);
+    bool is_fractional = false;
+    for (Agent a = 0; a < N; ++a)
+        for (const auto& [var, var_val] : agent_vars[a])
+        {
+            debug_assert(var_val == SCIPgetSolVal(scip, nullptr, var));
+            if (SCIPisPositive(scip, var_val))
+            {
+                candidates.push_back({var_val, a, var});
+                agent_max_val[a] = std::max(agent_max_val[a], var_val);
+                is_fractional |= !SCIPisEQ(scip, var_val, 1.0);
+            }
+        }
+    if (!is_fractional)
+    {
+        *result = SCIP_DIDNOTRUN;
+        return SCIP_OKAY;
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b)
+    {
+        return a.val > b.val;
+    });
+
+    // Start from the duals of the conflicts. Blocked vertices and edges are overwritten with infinite penalties.
+    EdgePenalties global_edge_penalties;
+    make_dual_edge_penalties(scip, probdata, map, global_edge_penalties);
+    HashTable<Node, Time> node_latest_visit_time;
+
+    // Dive. Fix the column closest to 1 whose path is not blocked by the fixed agents and block its path. A blocked
+    // column stays blocked so the columns are visited once in order.
+    Vector<SCIP_VAR*> vars(N, nullptr);
+    for (const auto& [val, a, var] : candidates)
+        if (!vars[a])
+        {
+            // Get the path.
+            auto vardata = SCIPvarGetData(var);
+            const auto path_length = SCIPvardataGetPathLength(vardata);
+            const auto path = SCIPvardataGetPath(vardata);
+
+            // Fix the column if its path is not blocked.
+            if (!is_path_blocked(path, path_length, global_edge_penalties, node_latest_visit_time))
+            {
+                vars[a] = var;
+                block_path(path,
+                           path_length,
+                           global_edge_penalties,
+                           node_latest_visit_time,
+                           max_path_length,
+                           map);
+            }
+        }
+
+    // Repair the agents without an unblocked column by pricing their best path against the duals and the paths of
+    // the fixed agents, the agents closest to integral in the LP first.
+    Vector<Agent> order;
+    for (Agent a = 0; a < N; ++a)
+        if (!vars[a])
+        {
+            order.push_back(a);
+        }
+    std::stable_sort(order.begin(), order.end(), [&agent_max_val](const Agent a, const Agent b)
+    {
+        return agent_max_val[a] > agent_max_val[b];
+    });
+    Vector<Vector<Edge>> paths(N);
+    bool success = true;
+    for (const auto a : order)
+    {
+        // Stop if out of time.
+        if (std::chrono::steady_clock::now() >= deadline)
+        {
+            success = false;
+            break;
+        }
+
+        // Find the best path. Exit if no path is found.
+        auto& path = paths[a];
+        if (!heuristic_set_up_agent(astar,
+                                    map,
+                                    agents,
+                                    a,
+                                    agent_inputs[a],
+                                    blocked_targets,
+                                    global_edge_penalties,
+                                    node_latest_visit_time) ||
+            !heuristic_solve_agent(astar, map, path))
+        {
+            success = false;
+            break;
+        }
+
+        // Block the path for future agents.
+        block_path(path.data(),
+                   path.size(),
+                   global_edge_penalties,
+                   node_latest_visit_time,
+                   max_path_length,
+                   map);
+    }
+
+    // Drop the layer of penalties before they go out of scope.
+    astar.data().edge_penalties.clear();
+    if (!success)
+    {
+        return SCIP_OKAY;
+    }
+
+    // Create a solution.
+    SCIP_SOL* sol;
+    SCIP_CALL(SCIPcreateSol(scip, &sol, heur));
+#ifdef PRINT_DEBUG
+    Cost sol_cost = 0;
+#endif
+    for (Agent a = 0; a < N; ++a)
+    {
+        // Create the variable if it doesn't already exist.
+        if (!vars[a])
+        {
+            const auto& path = paths[a];
+            debug_assert(!path.empty());
+            SCIP_CALL(SCIPprobdataAddHeuristicVar(scip,
+                                                  probdata,
+                                                  a,
+                                                  path.size(),
+                                                  path.data(),
+                                                  &vars[a]));
+            debug_assert(vars[a]);
+        }
+
+        // Put the variable in the solution.
+        SCIP_CALL(SCIPsetSolVal(scip, sol, vars[a], 1.0));
+
+        // Increment cost.
+#ifdef PRINT_DEBUG
+        sol_cost += SCIPvarGetObj(vars[a]);
+#endif
+    }
+    debugln("Diving primal heuristic found solution with cost {} after repairing {} agents", sol_cost, order.size());
+
+    // Inject solution.
+    SCIP_Bool found;
+    SCIP_CALL(SCIPtrySol(scip, sol, FALSE, FALSE, FALSE, TRUE, TRUE, &found));
+    if (found)
+    {
+        *result = SCIP_FOUNDSOL;
+    }
+
+    // Deallocate.
+    SCIP_CALL(SCIPfreeSol(scip, &sol));
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Create the LP-guided diving primal heuristic and include it in SCIP
+SCIP_RETCODE SCIPincludeHeurDiving(
+    SCIP* scip
+)
+{
+    // Create heuristic.
+    SCIP_HEUR* heur;
+    SCIP_CALL(SCIPincludeHeurBasic(scip,
+                                   &heur,
+                                   HEUR_NAME,
+                                   HEUR_DESC,
+                                   HEUR_DISPCHAR,
+                                   HEUR_PRIORITY,
+                                   HEUR_FREQ,
+                                   HEUR_FREQOFS,
+                                   HEUR_MAXDEPTH,
+                                   HEUR_TIMING,
+                                   HEUR_USESSUBSCIP,
+                                   heurExecDiving,
+                                   nullptr));
+    debug_assert(heur);
+
+    // Set callbacks.
+    SCIP_CALL(SCIPsetHeurInit(scip, heur, heurInitDiving));
+    SCIP_CALL(SCIPsetHeurFree(scip, heur, heurFreeDiving));
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+#endif
@@ -21,20 +21,11 @@ Author: Edward Lam <ed@ed-lam.com>
 
 // #define PRINT_DEBUG
 
-#define HEUR_NAME             "eecbs"
-#define HEUR_DESC             "MAPF-EECBS"
-#define HEUR_DISPCHAR         'E'
-#define HEUR_PRIORITY         19999
-#define HEUR_FREQ             0
-#define HEUR_FREQOFS          0
-#define HEUR_MAXDEPTH         -1
-#define HEUR_TIMING           SCIP_HEURTIMING_BEFORENODE
-#define HEUR_USESSUBSCIP      FALSE    // Does the heuristic use a secondary SCIP instance?
-
 #include "Heuristic_EECBS.h"
 #include "ProblemData.h"
 #include "VariableData.h"
-#include "Clock.h"
+#include "Trace.h"
+#include <thread>
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wdelete-non-virtual-dtor"
@@ -44,130 +35,68 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "eecbs/inc/ECBS.h"
 #pragma GCC diagnostic pop
 
-struct EECBSData
-{
-    eecbs::Instance instance;
-    eecbs::ECBS ecbs;
-    bool called;
-
-    EECBSData(const String& scenario_path, const String& map_path, const Agent N) :
-        instance(map_path, scenario_path, N),
-        ecbs(create_ecbs(instance)),
-        called(false)
-    {
-    }
-    static eecbs::ECBS create_ecbs(const eecbs::Instance& instance)
-    {
-#ifdef PRINT_DEBUG
-        const int screen = 2;
-#else
-        const int screen = 0;
+#ifndef EECBS_NB_RUNS
+#define EECBS_NB_RUNS 4    // Number of EECBS runs in parallel, each with a larger suboptimality factor
 #endif
+static_assert(EECBS_NB_RUNS >= 1);
 
-        eecbs::ECBS ecbs(instance, false, screen);
-        ecbs.setPrioritizeConflicts(true);
-        ecbs.setDisjointSplitting(false);
-        ecbs.setBypass(true);
-        ecbs.setRectangleReasoning(true);
-        ecbs.setCorridorReasoning(true);
-        ecbs.setHeuristicType(eecbs::heuristics_type::WDG, eecbs::heuristics_type::GLOBAL);
-        ecbs.setTargetReasoning(true);
-        ecbs.setMutexReasoning(false);
-        ecbs.setConflictSelectionRule(eecbs::conflict_selection::EARLIEST);
-        ecbs.setNodeSelectionRule(eecbs::node_selection::NODE_CONFLICTPAIRS);
-        ecbs.setSavingStats(false);
-        ecbs.setHighLevelSolver(eecbs::high_level_solver_type::EES, EECBS_SUBOPTIMALITY);
-        return ecbs;
-    }
+// Solution of an EECBS run
+struct EECBSResult
+{
+    Vector<Vector<Edge>> paths;
+    int cost;
+    bool success;
 };
 
-// Copy method for primal heuristic
-// static
-// SCIP_DECL_HEURCOPY(heurCopyEECBS)
-// {
-//     debug_assert(scip);
-//     debug_assert(heur);
-//     debug_assert(strcmp(SCIPheurGetName(heur), HEUR_NAME) == 0);
-
-//     SCIP_CALL(SCIPincludeHeurEECBS(scip));
-
-//     return SCIP_OKAY;
-// }
-
-// Free method for primal heuristic
-static
-SCIP_DECL_HEURFREE(heurFreeEECBS)
+// Create an EECBS solver with a suboptimality factor
+static eecbs::ECBS create_ecbs(const eecbs::Instance& instance, const double suboptimality)
 {
-    debug_assert(scip);
-    debug_assert(heur);
-    debug_assert(strcmp(SCIPheurGetName(heur), HEUR_NAME) == 0);
-
-    auto eecbs_data = reinterpret_cast<EECBSData*>(SCIPheurGetData(heur));
-    SCIPfreeBlockMemory(scip, &eecbs_data);
+#ifdef PRINT_DEBUG
+    const int screen = 2;
+#else
+    const int screen = 0;
+#endif
 
-    return SCIP_OKAY;
+    eecbs::ECBS ecbs(instance, false, screen);
+    ecbs.setPrioritizeConflicts(true);
+    ecbs.setDisjointSplitting(false);
+    ecbs.setBypass(true);
+    ecbs.setRectangleReasoning(true);
+    ecbs.setCorridorReasoning(true);
+    ecbs.setHeuristicType(eecbs::heuristics_type::WDG, eecbs::heuristics_type::GLOBAL);
+    ecbs.setTargetReasoning(true);
+    ecbs.setMutexReasoning(false);
+    ecbs.setConflictSelectionRule(eecbs::conflict_selection::EARLIEST);
+    ecbs.setNodeSelectionRule(eecbs::node_selection::NODE_CONFLICTPAIRS);
+    ecbs.setSavingStats(false);
+    ecbs.setHighLevelSolver(eecbs::high_level_solver_type::EES, suboptimality);
+    return ecbs;
 }
 
-// Execution method of primal heuristic
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wunused-parameter"
-static
-SCIP_DECL_HEUREXEC(heurExecEECBS)
+// Run EECBS with a suboptimality factor. Each run reads its own copy of the instance.
+static void run_eecbs(const String& scenario_path,
+                      const String& map_path,
+                      const Agent N,
+                      const Map& map,
+                      const double suboptimality,
+                      EECBSResult& result)
 {
-    // Skip if previously called.
-    auto eecbs_data = reinterpret_cast<EECBSData*>(SCIPheurGetData(heur));
-    if (!eecbs_data->called)
-    {
-        // Print.
-        debugln("Starting EECBS primal heuristic at node {}, depth {}, node LB {}:",
-                SCIPnodeGetNumber(SCIPgetCurrentNode(scip)),
-                SCIPgetDepth(scip),
-                SCIPgetNodeLowerbound(scip, SCIPgetCurrentNode(scip)));
-    }
-    else
-    {
-        debugln("Skipping EECBS primal heuristic at node {}, depth {}, node LB {}",
-                SCIPnodeGetNumber(SCIPgetCurrentNode(scip)),
-                SCIPgetDepth(scip),
-                SCIPgetNodeLowerbound(scip, SCIPgetCurrentNode(scip)));
-        return SCIP_OKAY;
-    }
-
-    // Initialize.
-    *result = SCIP_DIDNOTFIND;
-
-    // Get problem data.
-    auto probdata = SCIPgetProbData(scip);
-    const auto& map = SCIPprobdataGetMap(probdata);
-    const auto& agents = SCIPprobdataGetAgentsData(probdata);
-    const auto N = SCIPprobdataGetN(probdata);
-
-    // Get ECBS object.
-    const auto& instance = eecbs_data->instance;
-    auto& ecbs = eecbs_data->ecbs;
-
-    // Run.
-    const int lowerbound = std::max<SCIP_Real>(SCIPceil(scip, SCIPgetNodeLowerbound(scip, SCIPgetCurrentNode(scip))), 0.);
-	srand(0);
-    ecbs.clear();
-    ecbs.solve(EECBS_TIME_LIMIT, lowerbound);
-
-    // Get solution.
+    // Solve.
+    eecbs::Instance instance(map_path, scenario_path, N);
+    auto ecbs = create_ecbs(instance, suboptimality);
+    ecbs.solve(EECBS_TIME_LIMIT, 0);
     debug_assert(!ecbs.solution_found || ecbs.solution_cost >= 0);
-    if (ecbs.solution_found && ecbs.solution_cost < SCIPgetUpperbound(scip))
-    {
-        // Create solution object.
-        SCIP_SOL* sol;
-        SCIP_CALL(SCIPcreateSol(scip, &sol, heur));
-        debugln("Found solution with cost {}:", ecbs.solution_cost);
+    result.success = ecbs.solution_found;
+    result.cost = ecbs.solution_cost;
 
-        // Create paths.
-        Vector<Edge> path;
+    // Get the paths.
+    if (result.success)
+    {
         const auto& paths = ecbs.getPaths();
+        result.paths.resize(N);
         for (Agent a = 0; a < N; ++a)
         {
-            // Get the path from EECBS.
-            path.clear();
+            auto& path = result.paths[a];
             for (const auto& t : *paths[a])
             {
                 const auto x = instance.getColCoordinate(t.location);
@@ -178,85 +107,93 @@ SCIP_DECL_HEUREXEC(heurExecEECBS)
             {
                 path[t].d = map.get_direction(path[t].n, path[t + 1].n);
             }
-            release_assert(path.front().n == agents[a].start);
-            release_assert(path.back().n == agents[a].goal);
-
-            // Add column.
-            SCIP_VAR* var = nullptr;
-            SCIP_CALL(SCIPprobdataAddHeuristicVar(scip,
-                                                  probdata,
-                                                  a,
-                                                  path.size(),
-                                                  path.data(),
-                                                  &var));
-            debug_assert(var);
-            SCIP_CALL(SCIPsetSolVal(scip, sol, var, 1.0));
-
-            // Print.
-            debugln("Agent {:4d}: {}", a, format_path_spaced(probdata, path.size(), path.data()));
         }
-
-        // Inject solution.
-        SCIP_Bool success;
-        SCIP_CALL(SCIPtrySol(scip, sol, FALSE, FALSE, FALSE, TRUE, TRUE, &success));
-        if (success)
-        {
-            *result = SCIP_FOUNDSOL;
-        }
-
-        // Deallocate.
-        SCIP_CALL(SCIPfreeSol(scip, &sol));
     }
 
     // Finish.
     ecbs.clearSearchEngines();
-    eecbs_data->called = true;
-
-    // Done.
-    debugln("");
-    return SCIP_OKAY;
 }
-#pragma GCC diagnostic pop
 
-// Create the LNS primal heuristic and include it in SCIP
-SCIP_RETCODE SCIPincludeHeurEECBS(
+SCIP_RETCODE add_eecbs_columns(
     SCIP* scip
 )
 {
-    // Set random seed.
-    srand(0);
+    // Trace.
+    const TraceScope trace("eecbs");
+
+    // Check.
+    debug_assert(scip);
+    debug_assert(SCIPgetStage(scip) == SCIP_STAGE_PROBLEM);
 
     // Get problem data.
     auto probdata = SCIPgetProbData(scip);
-    const auto& scenario_path = SCIPprobdataGetScenarioPath(probdata);
-    const auto& map_path = SCIPprobdataGetMapPath(probdata);
+    const auto& map = SCIPprobdataGetMap(probdata);
+    const auto& agents = SCIPprobdataGetAgentsData(probdata);
     const auto N = SCIPprobdataGetN(probdata);
+    const auto scenario_path = SCIPprobdataGetScenarioPath(probdata).string();
+    const auto map_path = SCIPprobdataGetMapPath(probdata).string();
+
+    // Run EECBS in parallel. The suboptimality factor doubles its distance to 1 in every run so the runs find
+    // diverse solutions. EECBS draws random numbers from the global generator shared by the runs.
+    srand(0);
+    Vector<EECBSResult> results(EECBS_NB_RUNS);
+    {
+        Vector<std::thread> threads;
+        threads.reserve(EECBS_NB_RUNS);
+        for (Int run = 0; run < EECBS_NB_RUNS; ++run)
+        {
+            const double suboptimality = 1.0 + (EECBS_SUBOPTIMALITY - 1.0) * (1 << run);
+            threads.emplace_back(run_eecbs,
+                                 std::cref(scenario_path),
+                                 std::cref(map_path),
+                                 N,
+                                 std::cref(map),
+                                 suboptimality,
+                                 std::ref(results[run]));
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
 
-    // Create EECBS data.
-    EECBSData* eecbs_data = nullptr;
-    SCIP_CALL(SCIPallocBlockMemory(scip, &eecbs_data));
-    debug_assert(eecbs_data);
-    new(eecbs_data) EECBSData(scenario_path, map_path, N);
+    // Add the distinct paths as columns and the solutions as initial solutions.
+    Int nb_columns = 0;
+    for (const auto& [paths, cost, success] : results)
+        if (success)
+        {
+            // Create solution object.
+            SCIP_SOL* sol;
+            SCIP_CALL(SCIPcreateSol(scip, &sol, nullptr));
+            debugln("EECBS found solution with cost {}:", cost);
 
-    // Create heuristic.
-    SCIP_HEUR* heur;
-    SCIP_CALL(SCIPincludeHeurBasic(scip,
-                                   &heur,
-                                   HEUR_NAME,
-                                   HEUR_DESC,
-                                   HEUR_DISPCHAR,
-                                   HEUR_PRIORITY,
-                                   HEUR_FREQ,
-                                   HEUR_FREQOFS,
-                                   HEUR_MAXDEPTH,
-                                   HEUR_TIMING,
-                                   HEUR_USESSUBSCIP,
-                                   heurExecEECBS,
-                                   reinterpret_cast<SCIP_HeurData*>(eecbs_data)));
-    debug_assert(heur);
+            // Add the paths.
+            for (Agent a = 0; a < N; ++a)
+            {
+                // Check.
+                const auto& path = paths[a];
+                release_assert(path.front().n == agents[a].start);
+                release_assert(path.back().n == agents[a].goal);
+
+                // Add column if the path is new.
+                auto var = SCIPprobdataFindVar(probdata, a, path.size(), path.data());
+                if (!var)
+                {
+                    SCIP_CALL(SCIPprobdataAddInitialVar(scip, probdata, a, path.size(), path.data(), &var));
+                    ++nb_columns;
+                }
+                debug_assert(var);
+                SCIP_CALL(SCIPsetSolVal(scip, sol, var, 1.0));
+
+                // Print.
+                debugln("Agent {:4d}: {}", a, format_path_spaced(probdata, path.size(), path.data()));
+            }
 
-    // Set callbacks.
-    SCIP_CALL(SCIPsetHeurFree(scip, heur, heurFreeEECBS));
+            // Store solution.
+            SCIP_Bool stored;
+            SCIP_CALL(SCIPaddSolFree(scip, &sol, &stored));
+        }
+    debugln("Added {} columns from EECBS", nb_columns);
 
     // Done.
     return SCIP_OKAY;
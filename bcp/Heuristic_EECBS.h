@@ -26,9 +26,10 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "scip/type_retcode.h"
 #include "scip/type_scip.h"
 
-// Create the EECBS initialization primal heuristic and include it in SCIP
-SCIP_RETCODE SCIPincludeHeurEECBS(
-    SCIP* scip
+// Run EECBS with several suboptimality factors in parallel and add the distinct paths of the solutions as initial
+// columns and the solutions as initial solutions
+SCIP_RETCODE add_eecbs_columns(
+    SCIP* scip    // SCIP
 );
 
 #endif
@@ -35,6 +35,7 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Heuristic_LNS2Init.h"
 #include "ProblemData.h"
 #include "VariableData.h"
+#include "Trace.h"
 #include "Clock.h"
 
 #pragma GCC diagnostic push
@@ -135,6 +136,9 @@ SCIP_DECL_HEURFREE(heurFreeLNS2Init)
 static
 SCIP_DECL_HEUREXEC(heurExecLNS2Init)
 {
+    // Trace.
+    const TraceScope trace(HEUR_NAME);
+
     // Skip if previously called.
     auto lns_data = reinterpret_cast<LNS2InitData*>(SCIPheurGetData(heur));
     if (!lns_data->called)
@@ -32,9 +32,16 @@ Author: Edward Lam <ed@ed-lam.com>
 #define HEUR_TIMING           SCIP_HEURTIMING_AFTERLPNODE
 #define HEUR_USESSUBSCIP      FALSE    // Does the heuristic use a secondary SCIP instance?
 
+#define LNS2_REPAIR_QUEUE_CAPACITY 16     // Number of solutions the worker can queue before the heuristic collects them
+
 #include "Heuristic_LNS2Repair.h"
 #include "ProblemData.h"
 #include "VariableData.h"
+#include "Trace.h"
+#include "SubmissionQueue.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wdelete-non-virtual-dtor"
@@ -47,16 +54,42 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "lns2/inc/PIBT/pibt.h"
 #pragma GCC diagnostic pop
 
+// Solution found by LNS2 in the locations of LNS2
+struct LNS2RepairSolution
+{
+    int cost;                        // Sum of costs
+    Vector<Vector<int>> paths;       // Locations of the path of each agent
+};
+
+// LNS2 runs in a background thread beside the branch-and-bound. The heuristic callback only posts the latest LP
+// paths to the worker and collects the solutions found since the last call, so the search is never blocked by LNS2.
 struct LNS2RepairData
 {
     lns::PIBTPPS_option pipp_option;
     lns::Instance instance;
-    lns::LNS lns;
+    lns::LNS lns;                                   // Only used by the worker while it is running
+
+    std::thread worker;                             // Thread running LNS2
+    SubmissionQueue<LNS2RepairSolution> solutions;  // Solutions found by the worker since the last poll
+    std::mutex mutex;                               // Lock for the data below
+    std::condition_variable cv;                     // Wakes up the worker for a new snapshot or to stop
+    bool stop;                                      // Indicates if the worker should exit
+    bool has_snapshot;                              // Indicates if a snapshot is waiting for the worker
+    Vector<Vector<int>> snapshot;                   // Locations of the input path of each agent
+    int snapshot_lb;                                // Lower bound of the node of the snapshot
 
     LNS2RepairData(const String& scenario_path, const String& map_path, const Agent N) :
         pipp_option(create_pipp_option()),
         instance(map_path, scenario_path, N),
-        lns(create_repair_lns(pipp_option, instance, N))
+        lns(create_repair_lns(pipp_option, instance, N)),
+        worker(),
+        solutions(LNS2_REPAIR_QUEUE_CAPACITY),
+        mutex(),
+        cv(),
+        stop(false),
+        has_snapshot(false),
+        snapshot(),
+        snapshot_lb(0)
     {
     }
     static lns::PIBTPPS_option create_pipp_option()
@@ -112,6 +145,99 @@ struct LNS2RepairData
 //     return SCIP_OKAY;
 // }
 
+// Run LNS2 on each snapshot posted by the heuristic until asked to stop
+static void run_lns2_worker(LNS2RepairData& lns_data)
+{
+    auto& lns = lns_data.lns;
+    while (true)
+    {
+        // Wait for a snapshot and enter it into LNS2.
+        int lb;
+        {
+            std::unique_lock<std::mutex> lock(lns_data.mutex);
+            lns_data.cv.wait(lock, [&lns_data]() { return lns_data.stop || lns_data.has_snapshot; });
+            if (lns_data.stop)
+            {
+                return;
+            }
+            lns_data.has_snapshot = false;
+
+            lns.reset();
+            for (auto& [a, _, lns2_path] : lns.agents)
+            {
+                lns2_path.clear();
+                for (const auto location : lns_data.snapshot[a])
+                {
+                    lns2_path.emplace_back(location);
+                }
+            }
+            lb = lns_data.snapshot_lb;
+        }
+
+        // Run.
+        const auto succ = lns.run(lb);
+        if (!succ)
+        {
+            continue;
+        }
+#ifdef DEBUG
+        lns.validateSolution();
+#endif
+
+        // Get the solution.
+        LNS2RepairSolution solution;
+        solution.cost = lns.sum_of_costs;
+        solution.paths.reserve(lns.agents.size());
+        for (const auto& agent : lns.agents)
+        {
+            auto& path = solution.paths.emplace_back();
+            for (const auto& state : agent.path)
+            {
+                path.push_back(state.location);
+            }
+        }
+
+        // Queue the solution for the heuristic. The solution is dropped if the heuristic has fallen behind since it
+        // only keeps solutions better than the incumbent.
+        lns_data.solutions.push(std::move(solution));
+    }
+}
+
+// Stop the worker and discard its data
+static void stop_lns2_worker(LNS2RepairData& lns_data)
+{
+    if (lns_data.worker.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(lns_data.mutex);
+            lns_data.stop = true;
+        }
+        lns_data.cv.notify_one();
+        lns_data.worker.join();
+    }
+    lns_data.stop = false;
+    lns_data.has_snapshot = false;
+    lns_data.snapshot.clear();
+    lns_data.solutions.drain([](LNS2RepairSolution&&) {});
+}
+
+// Deinitialization method of primal heuristic (called before the branch-and-bound process data is freed)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_HEUREXITSOL(heurExitsolLNS2Repair)
+{
+    debug_assert(scip);
+    debug_assert(heur);
+    debug_assert(strcmp(SCIPheurGetName(heur), HEUR_NAME) == 0);
+
+    auto lns_data = reinterpret_cast<LNS2RepairData*>(SCIPheurGetData(heur));
+    stop_lns2_worker(*lns_data);
+
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
 // Free method for primal heuristic
 static
 SCIP_DECL_HEURFREE(heurFreeLNS2Repair)
@@ -121,17 +247,91 @@ SCIP_DECL_HEURFREE(heurFreeLNS2Repair)
     debug_assert(strcmp(SCIPheurGetName(heur), HEUR_NAME) == 0);
 
     auto lns_data = reinterpret_cast<LNS2RepairData*>(SCIPheurGetData(heur));
+    stop_lns2_worker(*lns_data);
+    lns_data->~LNS2RepairData();
     SCIPfreeBlockMemory(scip, &lns_data);
 
     return SCIP_OKAY;
 }
 
+// Add a solution found by the worker to SCIP
+static SCIP_RETCODE add_lns2_solution(
+    SCIP* scip,                               // SCIP
+    SCIP_HEUR* heur,                          // Heuristic
+    const LNS2RepairSolution& solution,       // Solution
+    SCIP_RESULT* result                       // Output result
+)
+{
+    // Get problem data.
+    auto probdata = SCIPgetProbData(scip);
+    const auto& map = SCIPprobdataGetMap(probdata);
+    const auto& agents = SCIPprobdataGetAgentsData(probdata);
+    auto lns_data = reinterpret_cast<LNS2RepairData*>(SCIPheurGetData(heur));
+    const auto& instance = lns_data->instance;
+
+    // Create solution object.
+    SCIP_SOL* sol;
+    SCIP_CALL(SCIPcreateSol(scip, &sol, heur));
+    debugln("Found solution with cost {}:", solution.cost);
+
+    // Create paths.
+    Vector<Edge> path;
+    for (Agent a = 0; a < static_cast<Agent>(solution.paths.size()); ++a)
+    {
+        // Get the path from LNS2.
+        path.clear();
+        for (const auto location : solution.paths[a])
+        {
+            const auto x = instance.getColCoordinate(location);
+            const auto y = instance.getRowCoordinate(location);
+            path.emplace_back(Edge{map.get_id(x + 1, y + 1), Direction::INVALID});
+        }
+        for (Time t = 0; t < static_cast<Time>(path.size()) - 1; ++t)
+        {
+            path[t].d = map.get_direction(path[t].n, path[t + 1].n);
+        }
+        release_assert(path.front().n == agents[a].start);
+        release_assert(path.back().n == agents[a].goal);
+
+        // Add column.
+        SCIP_VAR* var = nullptr;
+        SCIP_CALL(SCIPprobdataAddHeuristicVar(scip,
+                                              probdata,
+                                              a,
+                                              path.size(),
+                                              path.data(),
+                                              &var));
+        debug_assert(var);
+        SCIP_CALL(SCIPsetSolVal(scip, sol, var, 1.0));
+
+        // Print.
+        debugln("Agent {:4d}: {}", a, format_path_spaced(probdata, path.size(), path.data()));
+    }
+
+    // Inject solution.
+    SCIP_Bool success;
+    SCIP_CALL(SCIPtrySol(scip, sol, FALSE, FALSE, FALSE, TRUE, TRUE, &success));
+    if (success)
+    {
+        *result = SCIP_FOUNDSOL;
+    }
+
+    // Deallocate.
+    SCIP_CALL(SCIPfreeSol(scip, &sol));
+
+    // Done.
+    return SCIP_OKAY;
+}
+
 // Execution method of primal heuristic
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-parameter"
 static
 SCIP_DECL_HEUREXEC(heurExecLNS2Repair)
 {
+    // Trace.
+    const TraceScope trace(HEUR_NAME);
+
     // Print.
     debugln("Starting LNS2 repair primal heuristic at node {}, depth {}, node LB {}, LP obj {}:",
             SCIPnodeGetNumber(SCIPgetCurrentNode(scip)),
@@ -146,15 +346,27 @@ SCIP_DECL_HEUREXEC(heurExecLNS2Repair)
     auto probdata = SCIPgetProbData(scip);
     const auto N = SCIPprobdataGetN(probdata);
     const auto& map = SCIPprobdataGetMap(probdata);
-    const auto& agents = SCIPprobdataGetAgentsData(probdata);
 
     // Get LNS2 object.
     auto lns_data = reinterpret_cast<LNS2RepairData*>(SCIPheurGetData(heur));
     const auto& instance = lns_data->instance;
-    auto& lns = lns_data->lns;
-    lns.reset();
+
+    // Add the solutions found by the worker since the last call.
+    {
+        Vector<LNS2RepairSolution> solutions;
+        lns_data->solutions.drain([&solutions](LNS2RepairSolution&& solution)
+        {
+            solutions.push_back(std::move(solution));
+        });
+        for (const auto& solution : solutions)
+            if (solution.cost < SCIPgetUpperbound(scip))
+            {
+                SCIP_CALL(add_lns2_solution(scip, heur, solution, result));
+            }
+    }
 
     // Attempt to repair LP solution.
+    Vector<Vector<int>> snapshot(N);
     {
         // Update variable values.
         update_variable_values(scip);
@@ -225,11 +437,8 @@ SCIP_DECL_HEUREXEC(heurExecLNS2Repair)
             HashTable<NodeTime, SCIP_Real> vertex_used;
             HashTable<EdgeTime, SCIP_Real> edge_used;
 #endif
-            for (auto& [a, _, lns2_path] : lns.agents)
+            for (Agent a = 0; a < N; ++a)
             {
-                // Clear previously-entered path.
-                lns2_path.clear();
-
                 // Get the path.
                 auto& var = vars[a];
                 debug_assert(var);
@@ -279,7 +488,7 @@ SCIP_DECL_HEUREXEC(heurExecLNS2Repair)
                 {
                     const auto [x, y] = map.get_xy(path[t].n);
                     // println("{} {} {}", x - 1, y - 1, instance.linearizeCoordinate(y - 1, x - 1));
-                    lns2_path.emplace_back(instance.linearizeCoordinate(y - 1, x - 1));
+                    snapshot[a].push_back(instance.linearizeCoordinate(y - 1, x - 1));
                 }
 
                 // Go to here if skipping entering a path for this agent.
@@ -290,76 +499,19 @@ SCIP_DECL_HEUREXEC(heurExecLNS2Repair)
         }
     }
 
-    // Run.
-    const int lb = std::max<SCIP_Real>(SCIPceil(scip, SCIPgetNodeLowerbound(scip, SCIPgetCurrentNode(scip))), 0.);
-    const auto succ = lns.run(lb);
-
-    // Check.
-#ifdef DEBUG
-    if (succ)
+    // Post the snapshot to the worker, replacing a snapshot not yet taken by the worker.
     {
-        lns.validateSolution();
+        std::lock_guard<std::mutex> lock(lns_data->mutex);
+        lns_data->snapshot = std::move(snapshot);
+        lns_data->snapshot_lb =
+            std::max<SCIP_Real>(SCIPceil(scip, SCIPgetNodeLowerbound(scip, SCIPgetCurrentNode(scip))), 0.);
+        lns_data->has_snapshot = true;
     }
-#endif
-
-    // Get solution.
-    if (succ && lns.sum_of_costs < SCIPgetUpperbound(scip))
+    if (!lns_data->worker.joinable())
     {
-        // Create solution object.
-        SCIP_SOL* sol;
-        SCIP_CALL(SCIPcreateSol(scip, &sol, heur));
-        debugln("Found solution with cost {}:", lns.sum_of_costs);
-
-        // Create paths.
-        Vector<Edge> path;
-        int a = 0;
-        for (const auto& agent : lns.agents)
-        {
-            // Get the path from LNS2.
-            release_assert(agent.id == a);
-            path.clear();
-            for (const auto &state : agent.path)
-            {
-                const auto x = instance.getColCoordinate(state.location);
-                const auto y = instance.getRowCoordinate(state.location);
-                path.emplace_back(Edge{map.get_id(x + 1, y + 1), Direction::INVALID});
-            }
-            for (Time t = 0; t < static_cast<Time>(path.size()) - 1; ++t)
-            {
-                path[t].d = map.get_direction(path[t].n, path[t + 1].n);
-            }
-            release_assert(path.front().n == agents[a].start);
-            release_assert(path.back().n == agents[a].goal);
-
-            // Add column.
-            SCIP_VAR* var = nullptr;
-            SCIP_CALL(SCIPprobdataAddHeuristicVar(scip,
-                                                  probdata,
-                                                  a,
-                                                  path.size(),
-                                                  path.data(),
-                                                  &var));
-            debug_assert(var);
-            SCIP_CALL(SCIPsetSolVal(scip, sol, var, 1.0));
-
-            // Print.
-            debugln("Agent {:4d}: {}", a, format_path_spaced(probdata, path.size(), path.data()));
-
-            // Advance to next agent.
-            ++a;
-        }
-
-        // Inject solution.
-        SCIP_Bool success;
-        SCIP_CALL(SCIPtrySol(scip, sol, FALSE, FALSE, FALSE, TRUE, TRUE, &success));
-        if (success)
-        {
-            *result = SCIP_FOUNDSOL;
-        }
-
-        // Deallocate.
-        SCIP_CALL(SCIPfreeSol(scip, &sol));
+        lns_data->worker = std::thread(run_lns2_worker, std::ref(*lns_data));
     }
+    lns_data->cv.notify_one();
 
     // Done.
     debugln("");
@@ -405,6 +557,7 @@ SCIP_RETCODE SCIPincludeHeurLNS2Repair(
     debug_assert(heur);
 
     // Set callbacks.
+    SCIP_CALL(SCIPsetHeurExitsol(scip, heur, heurExitsolLNS2Repair));
     SCIP_CALL(SCIPsetHeurFree(scip, heur, heurFreeLNS2Repair));
 
     // Done.
@@ -0,0 +1,431 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#include "Heuristic_Planning.h"
+#include "ProblemData.h"
+#include "Constraint_VertexBranching.h"
+#include "Constraint_WaitBranching.h"
+#include "Constraint_LengthBranching.h"
+#include <algorithm>
+#include <limits>
+
+void heuristic_get_agent_inputs(
+    SCIP* scip,
+    SCIP_CONSHDLR* vertex_branching_conshdlr,
+    SCIP_CONSHDLR* wait_branching_conshdlr,
+    SCIP_CONSHDLR* length_branching_conshdlr,
+    const Time max_path_length,
+    Vector<HeuristicAgentInput>& agent_inputs,
+    Vector<AgentNodeTime>& blocked_targets
+)
+{
+    // Get problem data.
+    auto probdata = SCIPgetProbData(scip);
+    const auto N = SCIPprobdataGetN(probdata);
+    const auto& agents = SCIPprobdataGetAgentsData(probdata);
+
+    // Get constraints for branching decisions.
+    const auto n_vertex_branching_conss = SCIPconshdlrGetNConss(vertex_branching_conshdlr);
+    auto vertex_branching_conss = SCIPconshdlrGetConss(vertex_branching_conshdlr);
+    debug_assert(n_vertex_branching_conss == 0 || vertex_branching_conss);
+    const auto n_wait_branching_conss = SCIPconshdlrGetNConss(wait_branching_conshdlr);
+    auto wait_branching_conss = SCIPconshdlrGetConss(wait_branching_conshdlr);
+    debug_assert(n_wait_branching_conss == 0 || wait_branching_conss);
+    const auto n_length_branching_conss = SCIPconshdlrGetNConss(length_branching_conshdlr);
+    auto length_branching_conss = SCIPconshdlrGetConss(length_branching_conshdlr);
+    debug_assert(n_length_branching_conss == 0 || length_branching_conss);
+
+    // Collect the branching decisions of each agent. Ignore constraints that are not active since these are not on
+    // the current active path of the search tree.
+    agent_inputs.clear();
+    agent_inputs.resize(N);
+    for (auto& input : agent_inputs)
+    {
+        input.earliest_goal_time = 0;
+        input.latest_goal_time = max_path_length - 1;
+    }
+    Vector<NodeTime> used_vertices;
+    Vector<Agent> used_vertices_agent;
+    for (Int c = 0; c < n_vertex_branching_conss; ++c)
+    {
+        // Get the constraint.
+        auto cons = vertex_branching_conss[c];
+        debug_assert(cons);
+        if (!SCIPconsIsActive(cons))
+            continue;
+
+        // Store the decision.
+        const auto branch_a = SCIPgetVertexBranchingAgent(cons);
+        const auto dir = SCIPgetVertexBranchingDirection(cons);
+        const auto nt = SCIPgetVertexBranchingNodeTime(cons);
+        if (dir == VertexBranchDirection::Forbid)
+        {
+            agent_inputs[branch_a].forbidden_vertices.push_back(nt);
+        }
+        else
+        {
+            agent_inputs[branch_a].waypoints.push_back(nt);
+            used_vertices.push_back(nt);
+            used_vertices_agent.push_back(branch_a);
+        }
+    }
+    for (size_t idx = 0; idx < used_vertices.size(); ++idx)
+        for (Agent a = 0; a < N; ++a)
+            if (a != used_vertices_agent[idx])
+            {
+                agent_inputs[a].forbidden_vertices.push_back(used_vertices[idx]);
+            }
+    blocked_targets.clear();
+    for (Int c = 0; c < n_length_branching_conss; ++c)
+    {
+        // Get the constraint.
+        auto cons = length_branching_conss[c];
+        debug_assert(cons);
+        if (!SCIPconsIsActive(cons))
+            continue;
+
+        // Enforce the decision if the same agent. Disable crossing if different agent.
+        const auto branch_a = SCIPgetLengthBranchingAgent(cons);
+        const auto dir = SCIPgetLengthBranchingDirection(cons);
+        const auto nt = SCIPgetLengthBranchingNodeTime(cons);
+        auto& input = agent_inputs[branch_a];
+        if (dir == LengthBranchDirection::LEq)
+        {
+            input.latest_goal_time = std::min(input.latest_goal_time, nt.t);
+            blocked_targets.push_back(AgentNodeTime{branch_a, nt.n, nt.t});
+        }
+        else
+        {
+            input.earliest_goal_time = std::max(input.earliest_goal_time, nt.t);
+        }
+    }
+    for (Int c = 0; c < n_wait_branching_conss; ++c)
+    {
+        // Get the constraint.
+        auto cons = wait_branching_conss[c];
+        debug_assert(cons);
+        if (!SCIPconsIsActive(cons))
+            continue;
+
+        // Block waiting or leaving the vertex. An agent that cannot wait at its goal cannot finish by that time.
+        const auto branch_a = SCIPgetWaitBranchingAgent(cons);
+        const auto dir = SCIPgetWaitBranchingDirection(cons);
+        const auto nt = SCIPgetWaitBranchingNodeTime(cons);
+        auto& input = agent_inputs[branch_a];
+        if (dir == WaitBranchDirection::CannotWait)
+        {
+            input.forbidden_waits.push_back(nt);
+            if (nt.n == agents[branch_a].goal)
+            {
+                input.earliest_goal_time = std::max(input.earliest_goal_time, nt.t + 1);
+            }
+        }
+        else
+        {
+            input.required_waits.push_back(nt);
+            if (nt.t > 0)
+            {
+                input.waypoints.push_back(nt);
+            }
+        }
+    }
+
+    // Sort waypoints by time.
+    for (auto& input : agent_inputs)
+    {
+        std::sort(input.waypoints.begin(), input.waypoints.end(), [](const auto& a, const auto& b)
+        {
+            return a.t < b.t;
+        });
+        input.waypoints.erase(std::unique(input.waypoints.begin(), input.waypoints.end()), input.waypoints.end());
+#ifdef DEBUG
+        for (size_t idx = 1; idx < input.waypoints.size(); ++idx)
+        {
+            debug_assert(input.waypoints[idx - 1].t < input.waypoints[idx].t);
+        }
+#endif
+        debug_assert(input.waypoints.empty() || input.latest_goal_time >= input.waypoints.back().t);
+    }
+
+}
+
+void block_path(
+    const Edge* const path,
+    const Time path_length,
+    EdgePenalties& global_edge_penalties,
+    HashTable<Node, Time>& node_latest_visit_time,
+    const Time max_path_length,
+    const Map& map
+)
+{
+    // Update latest time to visit a node.
+    for (Time t = 0; t < path_length; ++t)
+    {
+        auto [it, success] = node_latest_visit_time.emplace(Node{path[t].n}, t);
+        if (!success)
+        {
+            it->second = std::max(it->second, t);
+        }
+    }
+
+    // Block vertices in future paths.
+    {
+        Node path_n;
+        Time t = 1;
+        for (; t < path_length; ++t)
+        {
+            // Don't use the vertex.
+            path_n = path[t].n;
+            const auto prev_time = t - 1;
+            {
+                const auto n = map.get_south(path_n);
+                auto& penalties = global_edge_penalties.get_edge_penalties(n, prev_time);
+                penalties.north = std::numeric_limits<Cost>::infinity();
+            }
+            {
+                const auto n = map.get_north(path_n);
+                auto& penalties = global_edge_penalties.get_edge_penalties(n, prev_time);
+                penalties.south = std::numeric_limits<Cost>::infinity();
+            }
+            {
+                const auto n = map.get_west(path_n);
+                auto& penalties = global_edge_penalties.get_edge_penalties(n, prev_time);
+                penalties.east = std::numeric_limits<Cost>::infinity();
+            }
+            {
+                const auto n = map.get_east(path_n);
+                auto& penalties = global_edge_penalties.get_edge_penalties(n, prev_time);
+                penalties.west = std::numeric_limits<Cost>::infinity();
+            }
+            {
+                const auto n = map.get_wait(path_n);
+                auto& penalties = global_edge_penalties.get_edge_penalties(n, prev_time);
+                penalties.wait = std::numeric_limits<Cost>::infinity();
+            }
+        }
+        for (; t < max_path_length; ++t)
+        {
+            // Don't use the vertex.
+            const auto prev_time = t - 1;
+            {
+                const auto n = map.get_south(path_n);
+                auto& penalties = global_edge_penalties.get_edge_penalties(n, prev_time);
+                penalties.north = std::numeric_limits<Cost>::infinity();
+            }
+            {
+                const auto n = map.get_north(path_n);
+                auto& penalties = global_edge_penalties.get_edge_penalties(n, prev_time);
+                penalties.south = std::numeric_limits<Cost>::infinity();
+            }
+            {
+                const auto n = map.get_west(path_n);
+                auto& penalties = global_edge_penalties.get_edge_penalties(n, prev_time);
+                penalties.east = std::numeric_limits<Cost>::infinity();
+            }
+            {
+                const auto n = map.get_east(path_n);
+                auto& penalties = global_edge_penalties.get_edge_penalties(n, prev_time);
+                penalties.west = std::numeric_limits<Cost>::infinity();
+            }
+            {
+                const auto n = map.get_wait(path_n);
+                auto& penalties = global_edge_penalties.get_edge_penalties(n, prev_time);
+                penalties.wait = std::numeric_limits<Cost>::infinity();
+            }
+        }
+    }
+
+    // Block edges in future paths.
+    for (Time t = 0; t < path_length - 1; ++t)
+    {
+        const auto e = map.get_opposite_edge(path[t]);
+        auto& penalties = global_edge_penalties.get_edge_penalties(e.n, t);
+        penalties.d[e.d] = std::numeric_limits<Cost>::infinity();
+    }
+}
+
+bool is_path_blocked(
+    const Edge* const path,
+    const Time path_length,
+    const EdgePenalties& global_edge_penalties,
+    const HashTable<Node, Time>& node_latest_visit_time
+)
+{
+    // Check if the goal is visited after the path finishes.
+    const auto finish_time = path_length - 1;
+    if (const auto it = node_latest_visit_time.find(path[finish_time].n);
+        it != node_latest_visit_time.end() && it->second >= finish_time)
+    {
+        return true;
+    }
+
+    // Check the edges.
+    for (Time t = 0; t < finish_time; ++t)
+        if (const auto penalties = global_edge_penalties.find_edge_penalties(NodeTime{path[t].n, t});
+            penalties && penalties->d[path[t].d] == std::numeric_limits<Cost>::infinity())
+        {
+            return true;
+        }
+
+    // Not blocked.
+    return false;
+}
+
+// Block a vertex for the agent being planned
+static void block_vertex(const NodeTime nt, EdgePenalties& edge_penalties, const Map& map)
+{
+    const auto prev_time = nt.t - 1;
+    {
+        const auto n = map.get_south(nt.n);
+        auto& penalties = edge_penalties.get_edge_penalties(n, prev_time);
+        penalties.north = std::numeric_limits<Cost>::infinity();
+    }
+    {
+        const auto n = map.get_north(nt.n);
+        auto& penalties = edge_penalties.get_edge_penalties(n, prev_time);
+        penalties.south = std::numeric_limits<Cost>::infinity();
+    }
+    {
+        const auto n = map.get_west(nt.n);
+        auto& penalties = edge_penalties.get_edge_penalties(n, prev_time);
+        penalties.east = std::numeric_limits<Cost>::infinity();
+    }
+    {
+        const auto n = map.get_east(nt.n);
+        auto& penalties = edge_penalties.get_edge_penalties(n, prev_time);
+        penalties.west = std::numeric_limits<Cost>::infinity();
+    }
+    {
+        const auto n = map.get_wait(nt.n);
+        auto& penalties = edge_penalties.get_edge_penalties(n, prev_time);
+        penalties.wait = std::numeric_limits<Cost>::infinity();
+    }
+}
+
+bool heuristic_set_up_agent(
+    AStar& astar,
+    const Map& map,
+    const AgentsData& agents,
+    const Agent a,
+    const HeuristicAgentInput& input,
+    const Vector<AgentNodeTime>& blocked_targets,
+    const EdgePenalties& global_edge_penalties,
+    const HashTable<Node, Time>& node_latest_visit_time
+)
+{
+    // Get data from the low-level solver.
+    auto& [start,
+           waypoints,
+           goal,
+           earliest_goal_time,
+           latest_goal_time,
+           cost_offset,
+           latest_visit_time,
+           edge_penalties,
+           finish_time_penalties
+#ifdef USE_GOAL_CONFLICTS
+         , goal_penalties
+#endif
+    ] = astar.data();
+
+    // Reset unused costs.
+    cost_offset = -astar.max_path_length() * 1e2;
+    finish_time_penalties.clear();
+#ifdef USE_GOAL_CONFLICTS
+    goal_penalties.clear();
+#endif
+
+    // Set up start and end points.
+    start = agents[a].start;
+    goal = agents[a].goal;
+
+    // Modify edge costs for vertex branching decisions.
+    edge_penalties.clear();
+    edge_penalties.set_base(&global_edge_penalties);
+    for (const auto nt : input.forbidden_vertices)
+    {
+        block_vertex(nt, edge_penalties, map);
+    }
+    waypoints = input.waypoints;
+
+    // Modify edge costs for wait branching decisions.
+    for (const auto nt : input.forbidden_waits)
+    {
+        auto& penalties = edge_penalties.get_edge_penalties(nt.n, nt.t);
+        penalties.wait = std::numeric_limits<Cost>::infinity();
+    }
+    for (const auto nt : input.required_waits)
+    {
+        auto& penalties = edge_penalties.get_edge_penalties(nt.n, nt.t);
+        penalties.north = std::numeric_limits<Cost>::infinity();
+        penalties.south = std::numeric_limits<Cost>::infinity();
+        penalties.east = std::numeric_limits<Cost>::infinity();
+        penalties.west = std::numeric_limits<Cost>::infinity();
+    }
+
+    // Modify edge costs for length branching decisions.
+    earliest_goal_time = input.earliest_goal_time;
+    latest_goal_time = input.latest_goal_time;
+    latest_visit_time.clear();
+    for (const auto& [branch_a, n, t] : blocked_targets)
+        if (a != branch_a)
+        {
+            latest_visit_time.emplace_back(n, t - 1);
+        }
+
+    // Delay the goal if the node has been visited by another agent.
+    if (const auto it = node_latest_visit_time.find(goal); it != node_latest_visit_time.end())
+    {
+        earliest_goal_time = std::max(earliest_goal_time, it->second + 1);
+    }
+    return earliest_goal_time <= latest_goal_time;
+}
+
+bool heuristic_solve_agent(
+    AStar& astar,
+    const Map& map,
+    Vector<Edge>& path
+)
+{
+    // Solve.
+    astar.preprocess_input();
+    astar.before_solve(); // TODO: Merge back in.
+#ifdef USE_SIPP
+    const auto [path_vertices, path_cost] = astar.solve_sipp<false>();
+#else
+    const auto [path_vertices, path_cost] = astar.solve<false>();
+#endif
+
+    // Exit if no path is found.
+    if (path_vertices.empty())
+    {
+        return false;
+    }
+
+    // Get the path.
+    path.clear();
+    for (auto it = path_vertices.begin(); it != path_vertices.end(); ++it)
+    {
+        const auto d = it != path_vertices.end() - 1 ?
+                        map.get_direction(it->n, (it + 1)->n) :
+                        Direction::INVALID;
+        path.push_back(Edge{it->n, d});
+    }
+    return true;
+}
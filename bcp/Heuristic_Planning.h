@@ -0,0 +1,88 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#ifndef MAPF_HEURISTIC_PLANNING_H
+#define MAPF_HEURISTIC_PLANNING_H
+
+#include "Includes.h"
+#include "Coordinates.h"
+#include "trufflehog/AgentsData.h"
+#include "trufflehog/AStar.h"
+
+// Branching decisions of an agent at the current node
+struct HeuristicAgentInput
+{
+    Vector<NodeTime> waypoints;             // Vertices the agent must use
+    Vector<NodeTime> forbidden_vertices;    // Vertices the agent must not use
+    Vector<NodeTime> forbidden_waits;       // Vertices the agent cannot wait at
+    Vector<NodeTime> required_waits;        // Vertices the agent must wait at
+    Time earliest_goal_time;                // Earliest time the agent can finish
+    Time latest_goal_time;                  // Latest time the agent can finish
+};
+
+// Collect the branching decisions of each agent at the current node
+void heuristic_get_agent_inputs(
+    SCIP* scip,                                       // SCIP
+    SCIP_CONSHDLR* vertex_branching_conshdlr,         // Constraint handler for vertex branching
+    SCIP_CONSHDLR* wait_branching_conshdlr,           // Constraint handler for wait branching
+    SCIP_CONSHDLR* length_branching_conshdlr,         // Constraint handler for length branching
+    const Time max_path_length,                       // Maximum length of a path
+    Vector<HeuristicAgentInput>& agent_inputs,        // Output branching decisions of each agent
+    Vector<AgentNodeTime>& blocked_targets            // Output targets other agents cannot visit from a time
+);
+
+// Block the vertices and edges of a path for the agents planned after it
+void block_path(
+    const Edge* const path,                           // Path
+    const Time path_length,                           // Length of the path
+    EdgePenalties& global_edge_penalties,             // Edge penalties of the agents planned after the path
+    HashTable<Node, Time>& node_latest_visit_time,    // Latest time each node is visited by a planned path
+    const Time max_path_length,                       // Maximum length of a path
+    const Map& map                                    // Map
+);
+
+// Check if a path uses a vertex or an edge blocked by the paths planned before it
+bool is_path_blocked(
+    const Edge* const path,                                 // Path
+    const Time path_length,                                 // Length of the path
+    const EdgePenalties& global_edge_penalties,             // Edge penalties of the planned paths
+    const HashTable<Node, Time>& node_latest_visit_time     // Latest time each node is visited by a planned path
+);
+
+// Set up the low-level solver to plan an agent with its branching decisions around the paths planned before it.
+// Returns false if the agent cannot finish in time.
+bool heuristic_set_up_agent(
+    AStar& astar,                                           // Low-level solver
+    const Map& map,                                         // Map
+    const AgentsData& agents,                               // Agents
+    const Agent a,                                          // Agent to plan
+    const HeuristicAgentInput& input,                       // Branching decisions of the agent
+    const Vector<AgentNodeTime>& blocked_targets,           // Targets other agents cannot visit from a time
+    const EdgePenalties& global_edge_penalties,             // Edge penalties of the planned paths
+    const HashTable<Node, Time>& node_latest_visit_time     // Latest time each node is visited by a planned path
+);
+
+// Solve for the path of the agent set up in the low-level solver. Returns false if no path is found.
+bool heuristic_solve_agent(
+    AStar& astar,        // Low-level solver
+    const Map& map,      // Map
+    Vector<Edge>& path   // Output path
+);
+
+#endif
@@ -22,18 +22,20 @@ Author: Edward Lam <ed@ed-lam.com>
 // #define PRINT_DEBUG
 
 #include "Heuristic_PrioritizedPlanning.h"
+#include "Heuristic_Planning.h"
+#include "Heuristic_SafeIntervals.h"
+#include "Pricer_TruffleHog.h"
 #include "ProblemData.h"
 #include "VariableData.h"
+#include "Trace.h"
 #include "ConstraintHandler_VertexConflicts.h"
 #include "ConstraintHandler_EdgeConflicts.h"
-#include "Constraint_VertexBranching.h"
-//#include "Constraint_WaitBranching.h"
-#include "Constraint_LengthBranching.h"
 #include <chrono>
 #include <numeric>
 #include <algorithm>
 #include <random>
-#include <limits>
+#include <atomic>
+#include <thread>
 
 #define HEUR_NAME             "mapf-pp"
 #define HEUR_DESC             "MAPF prioritized planning"
@@ -45,10 +47,18 @@ Author: Edward Lam <ed@ed-lam.com>
 #define HEUR_TIMING           SCIP_HEURTIMING_AFTERLPNODE
 #define HEUR_USESSUBSCIP      FALSE    // Does the heuristic use a secondary SCIP instance?
 
+#ifndef PRIORITIZED_PLANNING_NB_ORDERS
+#define PRIORITIZED_PLANNING_NB_ORDERS 8          // Number of orders of the agents tried in each call
+#endif
+#ifndef PRIORITIZED_PLANNING_TIME_LIMIT
+#define PRIORITIZED_PLANNING_TIME_LIMIT 1.0       // Time limit in seconds of each call
+#endif
+static_assert(PRIORITIZED_PLANNING_NB_ORDERS >= 1);
+
 struct PrioritizedPlanningData
 {
     SCIP_CONSHDLR* vertex_branching_conshdlr;           // Constraint handler for vertex branching
-//    SCIP_CONSHDLR* wait_branching_conshdlr;           // Constraint handler for wait branching
+    SCIP_CONSHDLR* wait_branching_conshdlr;             // Constraint handler for wait branching
     SCIP_CONSHDLR* length_branching_conshdlr;           // Constraint handler for length branching
 
     std::mt19937 rng{0};
@@ -73,9 +83,9 @@ SCIP_DECL_HEURINIT(heurInitPrioritizedPlanning)
     heurdata->vertex_branching_conshdlr = SCIPfindConshdlr(scip, "vertex_branching");
     release_assert(heurdata->vertex_branching_conshdlr,
                    "Constraint handler for vertex branching is missing");
-//    heurdata->wait_branching_conshdlr = SCIPfindConshdlr(scip, "wait_branching");
-//    release_assert(heurdata->wait_branching_conshdlr,
-//                   "Constraint handler for wait branching is missing");
+    heurdata->wait_branching_conshdlr = SCIPfindConshdlr(scip, "wait_branching");
+    release_assert(heurdata->wait_branching_conshdlr,
+                   "Constraint handler for wait branching is missing");
     heurdata->length_branching_conshdlr = SCIPfindConshdlr(scip, "length_branching");
     release_assert(heurdata->length_branching_conshdlr,
                    "Constraint handler for length branching rule is missing");
@@ -111,97 +121,46 @@ SCIP_DECL_HEURFREE(heurFreePrioritizedPlanning)
 }
 #pragma GCC diagnostic pop
 
-void block_path(const Edge* const path,
-                const Time path_length,
-                EdgePenalties& global_edge_penalties,
-                HashTable<Node, Time>& node_latest_visit_time,
-                const Time max_path_length,
-                const Map& map)
+// Plan the agents one at a time in the given order around the paths of the fixed agents. Returns false if an agent
+// has no path or the time limit is reached.
+static bool plan_paths(AStar& astar,
+                       const Map& map,
+                       const AgentsData& agents,
+                       const Vector<Agent>& order,
+                       const Vector<HeuristicAgentInput>& agent_inputs,
+                       const Vector<AgentNodeTime>& blocked_targets,
+                       const SafeIntervalTable& fixed_table,
+                       const std::chrono::steady_clock::time_point deadline,
+                       Vector<Vector<Edge>>& paths,
+                       Cost& cost)
 {
-    // Update latest time to visit a node.
-    for (Time t = 0; t < path_length; ++t)
+    // Start from the paths of the fixed agents.
+    auto table = fixed_table;
+
+    // Find a path for each agent.
+    cost = 0;
+    for (const auto a : order)
     {
-        auto [it, success] = node_latest_visit_time.emplace(Node{path[t].n}, t);
-        if (!success)
+        // Stop if out of time.
+        if (std::chrono::steady_clock::now() >= deadline)
         {
-            it->second = std::max(it->second, t);
+            return false;
         }
-    }
 
-    // Block vertices in future paths.
-    {
-        Node path_n;
-        Time t = 1;
-        for (; t < path_length; ++t)
+        // Plan the agent around the paths of the previous agents. Exit if no path is found.
+        auto& path = paths[a];
+        if (!safe_interval_solve_agent(astar, map, table, agents, a, agent_inputs[a], blocked_targets, path))
         {
-            // Don't use the vertex.
-            path_n = path[t].n;
-            const auto prev_time = t - 1;
-            {
-                const auto n = map.get_south(path_n);
-                auto& penalties = global_edge_penalties.get_edge_penalties(n, prev_time);
-                penalties.north = std::numeric_limits<Cost>::infinity();
-            }
-            {
-                const auto n = map.get_north(path_n);
-                auto& penalties = global_edge_penalties.get_edge_penalties(n, prev_time);
-                penalties.south = std::numeric_limits<Cost>::infinity();
-            }
-            {
-                const auto n = map.get_west(path_n);
-                auto& penalties = global_edge_penalties.get_edge_penalties(n, prev_time);
-                penalties.east = std::numeric_limits<Cost>::infinity();
-            }
-            {
-                const auto n = map.get_east(path_n);
-                auto& penalties = global_edge_penalties.get_edge_penalties(n, prev_time);
-                penalties.west = std::numeric_limits<Cost>::infinity();
-            }
-            {
-                const auto n = map.get_wait(path_n);
-                auto& penalties = global_edge_penalties.get_edge_penalties(n, prev_time);
-                penalties.wait = std::numeric_limits<Cost>::infinity();
-            }
+            return false;
         }
-        for (; t < max_path_length; ++t)
-        {
-            // Don't use the vertex.
-            const auto prev_time = t - 1;
-            {
-                const auto n = map.get_south(path_n);
-                auto& penalties = global_edge_penalties.get_edge_penalties(n, prev_time);
-                penalties.north = std::numeric_limits<Cost>::infinity();
-            }
-            {
-                const auto n = map.get_north(path_n);
-                auto& penalties = global_edge_penalties.get_edge_penalties(n, prev_time);
-                penalties.south = std::numeric_limits<Cost>::infinity();
-            }
-            {
-                const auto n = map.get_west(path_n);
-                auto& penalties = global_edge_penalties.get_edge_penalties(n, prev_time);
-                penalties.east = std::numeric_limits<Cost>::infinity();
-            }
-            {
-                const auto n = map.get_east(path_n);
-                auto& penalties = global_edge_penalties.get_edge_penalties(n, prev_time);
-                penalties.west = std::numeric_limits<Cost>::infinity();
-            }
-            {
-                const auto n = map.get_wait(path_n);
-                auto& penalties = global_edge_penalties.get_edge_penalties(n, prev_time);
-                penalties.wait = std::numeric_limits<Cost>::infinity();
-            }
-        }
-    }
+        cost += path.size() - 1;
 
-    // Block edges in future paths.
-    for (Time t = 0; t < path_length - 1; ++t)
-    {
-        const auto e = map.get_opposite_edge(path[t]);
-        auto& penalties = global_edge_penalties.get_edge_penalties(e.n, t);
-        penalties.d[e.d] = std::numeric_limits<Cost>::infinity();
+        // Reserve the path for future agents.
+        table.reserve_path(a, path.data(), path.size());
     }
+
+    // Done.
+    return true;
 }
 
 // Execution method of primal heuristic
@@ -210,6 +169,9 @@ void block_path(const Edge* const path,
 static
 SCIP_DECL_HEUREXEC(heurExecPrioritizedPlanning)
 {
+    // Trace.
+    const TraceScope trace(HEUR_NAME);
+
     // Do not run if the node is infeasible.
     if (nodeinfeasible)
     {
@@ -224,6 +186,9 @@ SCIP_DECL_HEUREXEC(heurExecPrioritizedPlanning)
 
     // Initialize.
     *result = SCIP_DIDNOTFIND;
+    const auto deadline = std::chrono::steady_clock::now() +
+                          std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                              std::chrono::duration<double>(PRIORITIZED_PLANNING_TIME_LIMIT));
 
     // Get problem data.
     auto probdata = SCIPgetProbData(scip);
@@ -241,45 +206,33 @@ SCIP_DECL_HEUREXEC(heurExecPrioritizedPlanning)
     // Get variables.
     const auto& agent_vars = SCIPprobdataGetAgentVars(probdata);
 
-    // Get constraints for branching decisions.
-    const auto n_vertex_branching_conss = SCIPconshdlrGetNConss(heurdata->vertex_branching_conshdlr);
-    auto vertex_branching_conss = SCIPconshdlrGetConss(heurdata->vertex_branching_conshdlr);
-    debug_assert(n_vertex_branching_conss == 0 || vertex_branching_conss);
-    const auto n_length_branching_conss = SCIPconshdlrGetNConss(heurdata->length_branching_conshdlr);
-    auto length_branching_conss = SCIPconshdlrGetConss(heurdata->length_branching_conshdlr);
-    debug_assert(n_length_branching_conss == 0 || length_branching_conss);
-
-    // Get the low-level solver.
-    auto& astar = SCIPprobdataGetAStar(probdata);
-
-    // Get data from the low-level solver.
-    auto& [start,
-           waypoints,
-           goal,
-           earliest_goal_time,
-           latest_goal_time,
-           cost_offset,
-           latest_visit_time,
-           edge_penalties,
-           finish_time_penalties
-#ifdef USE_GOAL_CONFLICTS
-         , goal_penalties
-#endif
-    ] = astar.data();
-
-    // Reset unused costs.
-    cost_offset = -astar.max_path_length() * 1e2;
-    finish_time_penalties.clear();
-#ifdef USE_GOAL_CONFLICTS
-    goal_penalties.clear();
-#endif
-
-    // Create order of agents to solve.
+    // Get the low-level solvers. Each thread uses its own solver from the pricer, which is idle while the
+    // heuristic runs.
+    Vector<AStar*> astars = SCIPpricerTruffleHogGetAStars(scip);
+    if (astars.empty())
+    {
+        astars.push_back(&SCIPprobdataGetAStar(probdata));
+    }
+    const auto max_path_length = astars.front()->max_path_length();
+    debug_assert(max_path_length >= 1);
+
+    // Collect the branching decisions of each agent.
+    Vector<HeuristicAgentInput> agent_inputs;
+    Vector<AgentNodeTime> blocked_targets;
+    heuristic_get_agent_inputs(scip,
+                               heurdata->vertex_branching_conshdlr,
+                               heurdata->wait_branching_conshdlr,
+                               heurdata->length_branching_conshdlr,
+                               max_path_length,
+                               agent_inputs,
+                               blocked_targets);
+
+    // Keep the paths of agents with an integral column and find the largest value of the columns of the other agents.
     Vector<SCIP_VAR*> vars(N, nullptr);
-    Vector<Agent> order;
-    order.reserve(N);
-    EdgePenalties global_edge_penalties;
-    HashTable<Node, Time> node_latest_visit_time;
+    Vector<Agent> free_agents;
+    Vector<SCIP_Real> agent_max_val(N, 0.0);
+    free_agents.reserve(N);
+    SafeIntervalTable fixed_table(map);
     for (Agent a = 0; a < N; ++a)
     {
         for (const auto& [var, var_val] : agent_vars[a])
@@ -295,265 +248,84 @@ SCIP_DECL_HEUREXEC(heurExecPrioritizedPlanning)
                 const auto path_length = SCIPvardataGetPathLength(vardata);
                 const auto path = SCIPvardataGetPath(vardata);
 
-                // Block the path.
-                block_path(path,
-                           path_length,
-                           global_edge_penalties,
-                           node_latest_visit_time,
-                           astar.max_path_length(),
-                           map);
+                // Reserve the path.
+                fixed_table.reserve_path(a, path, path_length);
 
                 // Advance to next agent.
                 goto NEXT_AGENT;
             }
+            agent_max_val[a] = std::max(agent_max_val[a], var_val);
         }
-        order.push_back(a);
+        free_agents.push_back(a);
         NEXT_AGENT:;
     }
-    std::shuffle(order.begin(), order.end(), heurdata->rng);
 
-    // Find a path for each agent.
-    Vector<Vector<Edge>> paths(N);
-    for (const auto a : order)
+    // Create the orders of agents to solve. The first order plans the agents closest to integral in the LP first.
+    // The other orders are random.
+    Vector<Vector<Agent>> orders(PRIORITIZED_PLANNING_NB_ORDERS, free_agents);
+    for (auto& order : orders)
     {
-        // Set up start and end points.
-        start = agents[a].start;
-        goal = agents[a].goal;
-
-        // Modify edge costs for vertex branching decisions.
-        waypoints.clear();
-        edge_penalties = global_edge_penalties;
-        for (Int c = 0; c < n_vertex_branching_conss; ++c)
-        {
-            // Get the constraint.
-            auto cons = vertex_branching_conss[c];
-            debug_assert(cons);
-
-            // Ignore constraints that are not active since these are not on the current
-            // active path of the search tree.
-            if (!SCIPconsIsActive(cons))
-                continue;
-
-            // Enforce the decision.
-            const auto branch_a = SCIPgetVertexBranchingAgent(cons);
-            const auto dir = SCIPgetVertexBranchingDirection(cons);
-            const auto nt = SCIPgetVertexBranchingNodeTime(cons);
-            if ((a == branch_a && dir == VertexBranchDirection::Forbid) ||
-                (a != branch_a && dir == VertexBranchDirection::Use))
-            {
-                // Don't use the vertex.
-                const auto prev_time = nt.t - 1;
-                {
-                    const auto n = map.get_south(nt.n);
-                    auto& penalties = edge_penalties.get_edge_penalties(n, prev_time);
-                    penalties.north = std::numeric_limits<Cost>::infinity();
-                }
-                {
-                    const auto n = map.get_north(nt.n);
-                    auto& penalties = edge_penalties.get_edge_penalties(n, prev_time);
-                    penalties.south = std::numeric_limits<Cost>::infinity();
-                }
-                {
-                    const auto n = map.get_west(nt.n);
-                    auto& penalties = edge_penalties.get_edge_penalties(n, prev_time);
-                    penalties.east = std::numeric_limits<Cost>::infinity();
-                }
-                {
-                    const auto n = map.get_east(nt.n);
-                    auto& penalties = edge_penalties.get_edge_penalties(n, prev_time);
-                    penalties.west = std::numeric_limits<Cost>::infinity();
-                }
-                {
-                    const auto n = map.get_wait(nt.n);
-                    auto& penalties = edge_penalties.get_edge_penalties(n, prev_time);
-                    penalties.wait = std::numeric_limits<Cost>::infinity();
-                }
-            }
-            else if (a == branch_a)
-            {
-                debug_assert(dir == VertexBranchDirection::Use);
-
-                // Store a waypoint to enforce use of the vertex.
-                waypoints.push_back(nt);
-            }
-        }
-
-        // Sort waypoints by time.
-        std::sort(waypoints.begin(), waypoints.end(), [](const auto& a, const auto& b)
-        {
-            return a.t < b.t;
-        });
-#ifdef DEBUG
-        for (size_t idx = 1; idx < waypoints.size(); ++idx)
-        {
-            debug_assert(waypoints[idx - 1].t < waypoints[idx].t);
-        }
-#endif
+        std::shuffle(order.begin(), order.end(), heurdata->rng);
+    }
+    std::stable_sort(orders[0].begin(), orders[0].end(), [&agent_max_val](const Agent a, const Agent b)
+    {
+        return agent_max_val[a] > agent_max_val[b];
+    });
 
-        // Modify edge costs for length branching decisions.
-        debug_assert(astar.max_path_length() >= 1);
-        earliest_goal_time = 0;
-        latest_goal_time = astar.max_path_length() - 1;
-        latest_visit_time = map.latest_visit_time();
-        for (Int c = 0; c < n_length_branching_conss; ++c)
+    // Plan every order. Each thread takes the next unplanned order.
+    struct PlanningResult
+    {
+        Vector<Vector<Edge>> paths;
+        Cost cost;
+        bool success;
+    };
+    Vector<PlanningResult> results(orders.size());
+    {
+        std::atomic<Int> next_order(0);
+        const auto worker = [&](AStar& astar)
         {
-            // Get the constraint.
-            auto cons = length_branching_conss[c];
-            debug_assert(cons);
-
-            // Ignore constraints that are not active since these are not on the current active path of the search tree.
-            if (!SCIPconsIsActive(cons))
-                continue;
-
-            // Enforce the decision if the same agent. Disable crossing if different agent.
-            const auto branch_a = SCIPgetLengthBranchingAgent(cons);
-            const auto dir = SCIPgetLengthBranchingDirection(cons);
-            const auto nt = SCIPgetLengthBranchingNodeTime(cons);
-            if (a == branch_a)
-            {
-                if (dir == LengthBranchDirection::LEq)
-                {
-                    latest_goal_time = std::min(latest_goal_time, nt.t);
-                }
-                else
-                {
-                    earliest_goal_time = std::max(earliest_goal_time, nt.t);
-                }
-            }
-            else if (dir == LengthBranchDirection::LEq)
+            for (Int idx = next_order++; idx < static_cast<Int>(orders.size()); idx = next_order++)
             {
-                // Block the vertex at time t and onwards.
-                latest_visit_time[nt.n] = nt.t - 1;
+                auto& [paths, cost, success] = results[idx];
+                paths.resize(N);
+                success = plan_paths(astar,
+                                     map,
+                                     agents,
+                                     orders[idx],
+                                     agent_inputs,
+                                     blocked_targets,
+                                     fixed_table,
+                                     deadline,
+                                     paths,
+                                     cost);
             }
-        }
-        debug_assert(waypoints.empty() || latest_goal_time >= waypoints.back().t);
-
-        // Delay the goal if the node has been visited by another agent.
-        if (const auto it = node_latest_visit_time.find(goal);it != node_latest_visit_time.end())
+        };
+        const auto nb_workers = std::min<Int>(astars.size(), orders.size());
+        Vector<std::thread> threads;
+        threads.reserve(nb_workers - 1);
+        for (Int idx = 1; idx < nb_workers; ++idx)
         {
-            earliest_goal_time = std::max(earliest_goal_time, it->second + 1);
+            threads.emplace_back(worker, std::ref(*astars[idx]));
         }
-
-        // Preprocess input data.
-        astar.preprocess_input();
-
-        // Start timer.
-// #ifdef PRINT_DEBUG
-//         const auto start_time = std::chrono::high_resolution_clock::now();
-// #endif
-
-        // Solve.
-        astar.before_solve(); // TODO: Merge back in.
-#ifdef USE_SIPP
-        const auto [path_vertices, path_cost] = astar.solve_sipp<false>();
-#ifdef DEBUG
+        worker(*astars[0]);
+        for (auto& thread : threads)
         {
-            const auto [time_expanded_astar_path_vertices, time_expanded_astar_path_cost] = astar.solve<false>();
-            debug_assert(std::abs(time_expanded_astar_path_cost - path_cost) < 1e-8);
-        }
-#endif
-#else
-        const auto [path_vertices, path_cost] = astar.solve<false>();
-#endif
-
-        // End timer.
-// #ifdef PRINT_DEBUG
-//         const auto end_time = std::chrono::high_resolution_clock::now();
-//         const auto duration = std::chrono::duration<double>(end_time - start_time).count();
-//         debugln("    Done in {:.4f} seconds", duration);
-// #endif
-
-        // Exit if no path is found.
-        if (path_vertices.empty())
-        {
-            return SCIP_OKAY;
+            thread.join();
         }
+    }
 
-        // Get the path.
-        auto& path = paths[a];
-        for (auto it = path_vertices.begin(); it != path_vertices.end(); ++it)
+    // Find the best order.
+    const PlanningResult* best = nullptr;
+    for (const auto& planning_result : results)
+        if (planning_result.success && (!best || planning_result.cost < best->cost))
         {
-            const auto d = it != path_vertices.end() - 1 ?
-                            map.get_direction(it->n, (it + 1)->n) :
-                            Direction::INVALID;
-            path.push_back(Edge{it->n, d});
+            best = &planning_result;
         }
-        const auto path_length = path.size();
-
-        // Print.
-        // debugln("    Found path with length {} ({})", path.size(), format_path(probdata, path.size(), path.data()));
-
-        // Block the path for future agents.
-        block_path(path.data(),
-                   path_length,
-                   global_edge_penalties,
-                   node_latest_visit_time,
-                   astar.max_path_length(),
-                   map);
+    if (!best)
+    {
+        return SCIP_OKAY;
     }
-
-    // Check.
-// #ifdef DEBUG
-//     {
-//         HashTable<NodeTime, SCIP_Real> used_vertices;
-//         HashTable<EdgeTime, SCIP_Real> used_edges;
-
-//         for (Agent a = 0; a < N; ++a)
-//         {
-//             // Get the path.
-//             const auto& path = paths[a];
-//             const auto path_length = path.size();
-
-//             // Store everything except the last vertex.
-//             Time t = 0;
-//             for (; t < static_cast<Time>(path_length) - 1; ++t)
-//             {
-//                 // Store the vertex.
-//                 {
-//                     const NodeTime nt{path[t].n, t};
-//                     used_vertices[nt] += 1;
-//                 }
-
-//                 // Store the edge.
-//                 {
-//                     const EdgeTime et{path[t], t};
-//                     used_edges[et] += 1;
-//                 }
-//             }
-
-//             // Store the edges after the agent reaches its goal.
-//             const auto n = path[t].n;
-//             for (; t < astar.max_path_length(); ++t)
-//             {
-//                 // Store the vertex.
-//                 {
-//                     const NodeTime nt{n, t};
-//                     used_vertices[nt] += 1;
-//                 }
-
-//                 // Store the edge.
-//                 {
-//                     const EdgeTime et{n, Direction::WAIT, t};
-//                     used_edges[et] += 1;
-//                 }
-//             }
-
-//             // Store the last vertex.
-//             {
-//                 const NodeTime nt{n, t};
-//                 used_vertices[nt] += 1;
-//             }
-//         }
-//         for (const auto [nt, val] : used_vertices)
-//         {
-//             release_assert(val == 1, "({},{}) {}", map.get_x(nt.n), map.get_y(nt.n), nt.t);
-//         }
-//         for (const auto [et, val] : used_edges)
-//         {
-//             release_assert(val == 1, "({},{}) {} {}", map.get_x(et.n), map.get_y(et.n), et.t, et.et.e);
-//         }
-//     }
-// #endif
+    const auto& paths = best->paths;
 
     // Create a solution.
     SCIP_SOL* sol;
@@ -566,38 +338,18 @@ SCIP_DECL_HEUREXEC(heurExecPrioritizedPlanning)
         // Create the variable if it doesn't already exist.
         if (!vars[a])
         {
-            // Get the path.
             const auto& path = paths[a];
-#ifdef DEBUG
             debug_assert(!path.empty());
-#endif
-
-            // Find the path if it already exists.
-            for (const auto& [var, _] : agent_vars[a])
-            {
-                debug_assert(var);
-                auto vardata = SCIPvarGetData(var);
-                const auto existing_path_length = SCIPvardataGetPathLength(vardata);
-                const auto existing_path = SCIPvardataGetPath(vardata);
-                if (std::equal(path.begin(), path.end(), existing_path, existing_path + existing_path_length))
-                {
-                    vars[a] = var;
-                    goto ADD_VAR_TO_SOL;
-                }
-            }
-
-            // Add the path if not yet added.
-            SCIP_CALL(SCIPprobdataAddInitialVar(scip,
-                                                probdata,
-                                                a,
-                                                path.size(),
-                                                path.data(),
-                                                &vars[a]));
+            SCIP_CALL(SCIPprobdataAddHeuristicVar(scip,
+                                                  probdata,
+                                                  a,
+                                                  path.size(),
+                                                  path.data(),
+                                                  &vars[a]));
             debug_assert(vars[a]);
         }
 
         // Put the variable in the solution.
-        ADD_VAR_TO_SOL:
         SCIP_CALL(SCIPsetSolVal(scip, sol, vars[a], 1.0));
 
         // Increment cost.
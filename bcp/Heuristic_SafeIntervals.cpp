@@ -0,0 +1,441 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+// #define PRINT_DEBUG
+
+#include "Heuristic_SafeIntervals.h"
+#include <algorithm>
+#include <queue>
+
+SafeIntervalTable::SafeIntervalTable(const Map& map) :
+    node_times_(map.size()),
+    node_parked_time_(map.size(), NO_TIME),
+    edge_agent_()
+{
+}
+
+void SafeIntervalTable::reserve_path(const Agent a, const Edge* const path, const Time path_length)
+{
+    debug_assert(path_length >= 1);
+
+    // Reserve the vertices.
+    for (Time t = 0; t < path_length; ++t)
+    {
+        auto& times = node_times_[path[t].n];
+        const auto it = std::lower_bound(times.begin(), times.end(), t);
+        if (it == times.end() || *it != t)
+        {
+            times.insert(it, t);
+        }
+    }
+
+    // Park the agent at the end of the path.
+    const auto finish_time = path_length - 1;
+    auto& parked_time = node_parked_time_[path[finish_time].n];
+    parked_time = std::min(parked_time, finish_time);
+
+    // Reserve the edges.
+    for (Time t = 0; t < finish_time; ++t)
+        if (path[t].d != Direction::WAIT)
+        {
+            edge_agent_[EdgeTime{path[t], t}] = a;
+        }
+}
+
+// Label of the search
+struct SafeIntervalLabel
+{
+    Node n;          // Node
+    Time t;          // Arrival time at the node
+    Int parent;      // Index of the previous label or -1
+};
+
+// Search over the safe intervals of the nodes for one agent. The branching decisions of the agent are checked in
+// addition to the reservations of the other agents.
+class SafeIntervalSearch
+{
+    using OpenEntry = Tuple<Time, Time, Int>;
+
+    const Map& map_;
+    const SafeIntervalTable& table_;
+    const HeuristicAgentInput& input_;
+    HashTable<Node, Time> latest_visit_time_;          // Latest time each node can be visited by the agent
+    Time latest_time_;                                 // Latest time of the search
+    Vector<SafeIntervalLabel> labels_;                 // Labels of every segment
+    HashTable<NodeTime, Time> earliest_arrival_;       // Earliest arrival at each safe interval, keyed by its start
+    std::priority_queue<OpenEntry, Vector<OpenEntry>, std::greater<OpenEntry>> open_;
+
+  public:
+    SafeIntervalSearch(const Map& map,
+                       const SafeIntervalTable& table,
+                       const HeuristicAgentInput& input,
+                       const Time latest_time) :
+        map_(map),
+        table_(table),
+        input_(input),
+        latest_visit_time_(),
+        latest_time_(latest_time),
+        labels_(),
+        earliest_arrival_(),
+        open_()
+    {
+    }
+
+    // Getters
+    inline const auto& labels() const { return labels_; }
+
+    // Restrict the latest time a node can be visited
+    void set_latest_visit_time(const Node n, const Time t)
+    {
+        auto [it, success] = latest_visit_time_.emplace(n, t);
+        if (!success)
+        {
+            it->second = std::min(it->second, t);
+        }
+    }
+
+    // Create a label for the start
+    Int add_start_label(const Node n, const Time t)
+    {
+        labels_.push_back({n, t, -1});
+        return static_cast<Int>(labels_.size()) - 1;
+    }
+
+    // Check if the agent can be at a node at a time
+    bool is_free(const Node n, const Time t) const
+    {
+        const auto& times = table_.node_times(n);
+        return t < table_.node_parked_time(n) &&
+               t <= get_latest_visit_time(n) &&
+               !std::binary_search(times.begin(), times.end(), t) &&
+               !is_forbidden(n, t);
+    }
+
+    // Get the latest time a node can be visited without blocking the target of another agent
+    inline Time get_latest_visit_time(const Node n) const
+    {
+        const auto it = latest_visit_time_.find(n);
+        return it != latest_visit_time_.end() ? it->second : SafeIntervalTable::NO_TIME;
+    }
+
+    // Check if a vertex is forbidden by the branching decisions of the agent
+    inline bool is_forbidden(const Node n, const Time t) const
+    {
+        return std::find(input_.forbidden_vertices.begin(), input_.forbidden_vertices.end(), NodeTime{n, t}) !=
+               input_.forbidden_vertices.end();
+    }
+
+    // Find the earliest time no earlier than a time and no later than a limit at which a node is free
+    Time next_free_time(const Node n, Time t, const Time limit) const
+    {
+        for (; t <= limit; ++t)
+            if (is_free(n, t))
+            {
+                return t;
+            }
+        return SafeIntervalTable::NO_TIME;
+    }
+
+    // Find the first time of the safe interval containing a free time. Waiting is not allowed across a forbidden
+    // wait so it separates two safe intervals.
+    Time interval_start(const Node n, const Time t) const
+    {
+        debug_assert(is_free(n, t));
+        Time start = 0;
+        const auto& times = table_.node_times(n);
+        if (const auto it = std::lower_bound(times.begin(), times.end(), t); it != times.begin())
+        {
+            start = std::max(start, *(it - 1) + 1);
+        }
+        for (const auto nt : input_.forbidden_vertices)
+            if (nt.n == n && nt.t < t)
+            {
+                start = std::max(start, nt.t + 1);
+            }
+        for (const auto nt : input_.forbidden_waits)
+            if (nt.n == n && nt.t < t)
+            {
+                start = std::max(start, nt.t + 1);
+            }
+        return start;
+    }
+
+    // Find the last time of the safe interval containing a free time, or NO_TIME if the interval does not end
+    Time interval_end(const Node n, const Time t) const
+    {
+        debug_assert(is_free(n, t));
+        const auto parked_time = table_.node_parked_time(n);
+        auto end = std::min(parked_time == SafeIntervalTable::NO_TIME ? parked_time : parked_time - 1,
+                            get_latest_visit_time(n));
+        const auto& times = table_.node_times(n);
+        if (const auto it = std::upper_bound(times.begin(), times.end(), t); it != times.end())
+        {
+            end = std::min(end, *it - 1);
+        }
+        for (const auto nt : input_.forbidden_vertices)
+            if (nt.n == n && nt.t > t)
+            {
+                end = std::min(end, nt.t - 1);
+            }
+        for (const auto nt : input_.forbidden_waits)
+            if (nt.n == n && nt.t >= t)
+            {
+                end = std::min(end, nt.t);
+            }
+        return end;
+    }
+
+    // Check if the agent can stay at its goal from a time until the end without meeting another agent
+    bool can_park(const Node n, const Time t) const
+    {
+        const auto& times = table_.node_times(n);
+        return table_.node_parked_time(n) == SafeIntervalTable::NO_TIME &&
+               get_latest_visit_time(n) == SafeIntervalTable::NO_TIME &&
+               std::upper_bound(times.begin(), times.end(), t) == times.end();
+    }
+
+    // Check if the agent can leave a node in a direction at a time
+    bool can_move(const Node n, const Direction d, const Time t) const
+    {
+        const auto opposite = map_.get_opposite_edge(Edge{n, d});
+        return !table_.is_edge_reserved(EdgeTime{opposite, t}) &&
+               std::find(input_.required_waits.begin(), input_.required_waits.end(), NodeTime{n, t}) ==
+               input_.required_waits.end();
+    }
+
+    // Search from a label to a target node. A waypoint must be visited at its time and the goal must be reached no
+    // earlier than the earliest goal time, after which the agent stays there. Returns the index of the label at the
+    // target or -1 if it cannot be reached.
+    Int search(const Int start_label,
+               const Node target,
+               const Time target_time,
+               const bool is_goal,
+               const Vector<IntCost>& h,
+               const Time earliest_goal_time)
+    {
+        // Start from the label.
+        open_ = decltype(open_){};
+        earliest_arrival_.clear();
+        {
+            const auto [n, t, parent] = labels_[start_label];
+            if (!is_free(n, t))
+            {
+                return -1;
+            }
+            earliest_arrival_[NodeTime{n, interval_start(n, t)}] = t;
+            open_.emplace(std::max<Time>(t + h[n], is_goal ? earliest_goal_time : 0), -t, start_label);
+        }
+
+        // Expand labels in order of the earliest finish time.
+        const auto deadline = is_goal ? latest_time_ : target_time;
+        while (!open_.empty())
+        {
+            const auto idx = std::get<2>(open_.top());
+            open_.pop();
+            const auto [n, t, parent] = labels_[idx];
+
+            // Skip the label if its safe interval is reached earlier by another label.
+            if (earliest_arrival_.at(NodeTime{n, interval_start(n, t)}) < t)
+            {
+                continue;
+            }
+            const auto end = interval_end(n, t);
+
+            // Stop if the target is reached.
+            if (n == target)
+            {
+                if (!is_goal && target_time <= end)
+                {
+                    labels_.push_back({n, target_time, idx});
+                    return static_cast<Int>(labels_.size()) - 1;
+                }
+                else if (is_goal)
+                {
+                    const auto finish_time = std::max(t, earliest_goal_time);
+                    if (finish_time <= end && finish_time <= latest_time_ && can_park(n, finish_time))
+                    {
+                        labels_.push_back({n, finish_time, idx});
+                        return static_cast<Int>(labels_.size()) - 1;
+                    }
+                }
+            }
+
+            // Move to the safe intervals of the neighbours reachable by waiting in this safe interval.
+            const auto last_arrival = end < deadline ? end + 1 : deadline;
+            const auto mask = map_.neighbours(n);
+            for (Int d = 0; d < 4; ++d)
+                if ((mask >> d) & 1)
+                {
+                    const auto m = map_.get_neighbour(n, d);
+                    for (auto arrival = next_free_time(m, t + 1, last_arrival); arrival != SafeIntervalTable::NO_TIME;)
+                    {
+                        // Depart at the earliest time not swapping with another agent.
+                        const auto m_end = interval_end(m, arrival);
+                        const auto m_last_arrival = std::min(m_end, last_arrival);
+                        for (auto next_t = arrival; next_t <= m_last_arrival; ++next_t)
+                            if (can_move(n, static_cast<Direction>(d), next_t - 1))
+                            {
+                                generate(m, next_t, interval_start(m, arrival), idx, deadline, is_goal, h,
+                                         earliest_goal_time);
+                                break;
+                            }
+
+                        // Advance to the next safe interval of the neighbour.
+                        if (m_end >= last_arrival)
+                        {
+                            break;
+                        }
+                        arrival = next_free_time(m, m_end + 1, last_arrival);
+                    }
+                }
+        }
+
+        // Not found.
+        return -1;
+    }
+
+  private:
+    // Create a label at a safe interval if it is reached earlier than before
+    void generate(const Node n,
+                  const Time t,
+                  const Time start,
+                  const Int parent,
+                  const Time deadline,
+                  const bool is_goal,
+                  const Vector<IntCost>& h,
+                  const Time earliest_goal_time)
+    {
+        // Check if time-infeasible.
+        if (t + h[n] > deadline)
+        {
+            return;
+        }
+
+        // Check if the safe interval is reached earlier.
+        auto [it, success] = earliest_arrival_.emplace(NodeTime{n, start}, t);
+        if (!success)
+        {
+            if (it->second <= t)
+            {
+                return;
+            }
+            it->second = t;
+        }
+
+        // Store the label.
+        labels_.push_back({n, t, parent});
+        open_.emplace(std::max<Time>(t + h[n], is_goal ? earliest_goal_time : 0),
+                      -t,
+                      static_cast<Int>(labels_.size()) - 1);
+    }
+};
+
+bool safe_interval_solve_agent(
+    AStar& astar,
+    const Map& map,
+    const SafeIntervalTable& table,
+    const AgentsData& agents,
+    const Agent a,
+    const HeuristicAgentInput& input,
+    const Vector<AgentNodeTime>& blocked_targets,
+    Vector<Edge>& path
+)
+{
+    // Get the start and goal.
+    const auto start = agents[a].start;
+    const auto goal = agents[a].goal;
+
+    // Get the lower bounds to the goal. The lower bounds to the waypoints stay valid until the next run.
+    astar.compute_h(goal);
+    const auto& h_goal = astar.get_h(goal);
+
+    // Get the time window of the goal.
+    const auto earliest_goal_time = input.earliest_goal_time;
+    const auto latest_goal_time = std::min<Time>(input.latest_goal_time, astar.max_path_length() - 1);
+    if (earliest_goal_time > latest_goal_time)
+    {
+        return false;
+    }
+
+    // Restrict the targets of the other agents.
+    SafeIntervalSearch search(map, table, input, latest_goal_time);
+    for (const auto& [branch_a, n, t] : blocked_targets)
+        if (a != branch_a)
+        {
+            search.set_latest_visit_time(n, t - 1);
+        }
+
+    // Solve each segment between the waypoints.
+    auto label = search.add_start_label(start, 0);
+    for (const auto w : input.waypoints)
+    {
+        const auto& h_waypoint = astar.get_h(w.n);
+        if (w.t + h_goal[w.n] > latest_goal_time)
+        {
+            return false;
+        }
+        label = search.search(label, w.n, w.t, false, h_waypoint, earliest_goal_time);
+        if (label < 0)
+        {
+            return false;
+        }
+    }
+    label = search.search(label, goal, latest_goal_time, true, h_goal, earliest_goal_time);
+    if (label < 0)
+    {
+        return false;
+    }
+
+    // Get the vertices of the path. The agent waits at a node until the arrival time of the next label.
+    const auto& labels = search.labels();
+    Vector<Node> path_vertices;
+    {
+        Vector<Int> chain;
+        for (auto idx = label; idx >= 0; idx = labels[idx].parent)
+        {
+            chain.push_back(idx);
+        }
+        std::reverse(chain.begin(), chain.end());
+        debug_assert(labels[chain.front()].t == 0);
+        for (size_t idx = 1; idx < chain.size(); ++idx)
+        {
+            const auto& prev = labels[chain[idx - 1]];
+            const auto& next = labels[chain[idx]];
+            debug_assert(prev.t < next.t || (prev.t == next.t && prev.n == next.n));
+            for (Time t = prev.t; t < next.t; ++t)
+            {
+                path_vertices.push_back(prev.n);
+            }
+        }
+        path_vertices.push_back(labels[chain.back()].n);
+    }
+    debug_assert(static_cast<Time>(path_vertices.size()) == labels[label].t + 1);
+
+    // Get the path.
+    path.clear();
+    for (auto it = path_vertices.begin(); it != path_vertices.end(); ++it)
+    {
+        const auto d = it != path_vertices.end() - 1 ?
+                       map.get_direction(*it, *(it + 1)) :
+                       Direction::INVALID;
+        path.push_back(Edge{*it, d});
+    }
+    debugln("Planned agent {} with safe intervals in {} labels", a, labels.size());
+    return true;
+}
@@ -0,0 +1,73 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#ifndef MAPF_HEURISTIC_SAFEINTERVALS_H
+#define MAPF_HEURISTIC_SAFEINTERVALS_H
+
+#include "Includes.h"
+#include "Coordinates.h"
+#include "Heuristic_Planning.h"
+#include "trufflehog/AgentsData.h"
+#include "trufflehog/AStar.h"
+
+// Vertices and edges used by the paths of the agents planned so far. The safe intervals of a node are the times
+// between the times at which it is occupied, so they are found from the sorted occupied times without storing them.
+class SafeIntervalTable
+{
+  public:
+    static constexpr Time NO_TIME = std::numeric_limits<Time>::max();
+
+  private:
+    Vector<Vector<Time>> node_times_;          // Sorted times at which each node is occupied
+    Vector<Time> node_parked_time_;            // Time from which an agent stays at each node, or NO_TIME
+    HashTable<EdgeTime, Agent> edge_agent_;    // Agent moving along each edge
+
+  public:
+    // Constructors
+    SafeIntervalTable() = delete;
+    SafeIntervalTable(const Map& map);
+    SafeIntervalTable(const SafeIntervalTable&) = default;
+    SafeIntervalTable(SafeIntervalTable&&) = default;
+    SafeIntervalTable& operator=(const SafeIntervalTable&) = default;
+    SafeIntervalTable& operator=(SafeIntervalTable&&) = default;
+    ~SafeIntervalTable() = default;
+
+    // Reserve the vertices and edges of a path. The agent stays at the end of the path after it finishes.
+    void reserve_path(const Agent a, const Edge* const path, const Time path_length);
+
+    // Getters
+    inline const Vector<Time>& node_times(const Node n) const { return node_times_[n]; }
+    inline Time node_parked_time(const Node n) const { return node_parked_time_[n]; }
+    inline bool is_edge_reserved(const EdgeTime et) const { return edge_agent_.find(et) != edge_agent_.end(); }
+};
+
+// Plan an agent with its branching decisions around the paths in the reservation table using safe interval path
+// planning. The lower bounds of the low-level solver guide the search. Returns false if no path is found.
+bool safe_interval_solve_agent(
+    AStar& astar,                                    // Low-level solver providing the lower bounds
+    const Map& map,                                  // Map
+    const SafeIntervalTable& table,                  // Paths of the agents planned before
+    const AgentsData& agents,                        // Agents
+    const Agent a,                                   // Agent to plan
+    const HeuristicAgentInput& input,                // Branching decisions of the agent
+    const Vector<AgentNodeTime>& blocked_targets,    // Targets other agents cannot visit from a time
+    Vector<Edge>& path                               // Output path
+);
+
+#endif
@@ -0,0 +1,238 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+
+#include "IndependenceDetection.h"
+#include "ProblemData.h"
+#include <numeric>
+
+// Find a shortest path of an agent ignoring every other agent
+Vector<Edge> find_shortest_path(
+    const Map& map,      // Map
+    const Node start,    // Start of the agent
+    const Node goal      // Goal of the agent
+)
+{
+    // Find the distance of every node to the goal by breadth-first search.
+    Vector<Time> dist(map.size(), -1);
+    Vector<Node> queue{goal};
+    dist[goal] = 0;
+    for (size_t idx = 0; idx < queue.size() && dist[start] < 0; ++idx)
+    {
+        const auto n = queue[idx];
+        for (const auto d : {Direction::NORTH, Direction::SOUTH, Direction::EAST, Direction::WEST})
+            if (const auto m = map.get_destination(n, d); map[m] && dist[m] < 0)
+            {
+                dist[m] = dist[n] + 1;
+                queue.push_back(m);
+            }
+    }
+    release_assert(dist[start] >= 0, "Goal is unreachable from the start");
+
+    // Walk down to the goal.
+    Vector<Edge> path;
+    path.reserve(dist[start] + 1);
+    for (auto n = start; n != goal;)
+        for (const auto d : {Direction::NORTH, Direction::SOUTH, Direction::EAST, Direction::WEST})
+            if (const auto m = map.get_destination(n, d); map[m] && dist[m] == dist[n] - 1)
+            {
+                path.push_back(Edge{n, d});
+                n = m;
+                break;
+            }
+    path.push_back(Edge{goal, Direction::INVALID});
+    return path;
+}
+
+// Make an instance with only some of the agents of another instance
+SharedPtr<Instance> make_group_instance(
+    const Instance& instance,        // Instance with every agent
+    const Vector<Agent>& agents      // Agents to keep
+)
+{
+    auto group_instance = std::make_shared<Instance>();
+    group_instance->scenario_path = instance.scenario_path;
+    group_instance->map_path = instance.map_path;
+    group_instance->map = instance.map;
+    for (const auto a : agents)
+    {
+        const auto& agent = instance.agents[a];
+        group_instance->agents.add_agent(agent.start_x,
+                                         agent.start_y,
+                                         agent.goal_x,
+                                         agent.goal_y,
+                                         group_instance->map);
+    }
+    return group_instance;
+}
+
+// Find the pairs of groups with colliding paths. Agents wait at their goal after the end of their path.
+Vector<Pair<Int, Int>> find_group_conflicts(
+    const Vector<AgentGroup>& groups    // Groups with their paths
+)
+{
+    // Gather the paths.
+    Vector<Pair<Int, const Vector<Edge>*>> paths;
+    Time makespan = 0;
+    for (Int g = 0; g < static_cast<Int>(groups.size()); ++g)
+        for (const auto& path : groups[g].paths)
+        {
+            debug_assert(!path.empty());
+            paths.emplace_back(g, &path);
+            makespan = std::max<Time>(makespan, path.size());
+        }
+    const auto position = [&](const Int idx, const Time t)
+    {
+        const auto& path = *paths[idx].second;
+        return t < static_cast<Time>(path.size()) ? path[t].n : path.back().n;
+    };
+
+    // Find the vertex and edge conflicts between the groups.
+    Vector<Pair<Int, Int>> conflicts;
+    const auto add_conflict = [&](Int g1, Int g2)
+    {
+        if (g1 != g2)
+        {
+            conflicts.emplace_back(std::min(g1, g2), std::max(g1, g2));
+        }
+    };
+    const auto nb_paths = static_cast<Int>(paths.size());
+    HashTable<NodeTime, Int> first_occupant;
+    first_occupant.reserve(nb_paths * makespan);
+    Vector<Int> next_occupant(nb_paths * makespan, -1);
+    for (Time t = 0; t < makespan; ++t)
+        for (Int idx = 0; idx < nb_paths; ++idx)
+        {
+            // Store the path as the first occupant of its vertex and check the other occupants.
+            auto& first = first_occupant.try_emplace(NodeTime{position(idx, t), t}, -1).first->second;
+            for (auto other = first; other >= 0; other = next_occupant[t * nb_paths + other])
+            {
+                add_conflict(paths[other].first, paths[idx].first);
+            }
+            next_occupant[t * nb_paths + idx] = first;
+            first = idx;
+        }
+    for (Time t = 0; t + 1 < makespan; ++t)
+        for (Int idx = 0; idx < nb_paths; ++idx)
+            if (const auto n = position(idx, t), m = position(idx, t + 1); n != m)
+            {
+                // Check the paths moving the other way.
+                const auto it = first_occupant.find(NodeTime{m, t});
+                for (auto other = it != first_occupant.end() ? it->second : -1; other >= 0;
+                     other = next_occupant[t * nb_paths + other])
+                    if (position(other, t + 1) == n)
+                    {
+                        add_conflict(paths[other].first, paths[idx].first);
+                    }
+            }
+
+    // Remove duplicates.
+    std::sort(conflicts.begin(), conflicts.end());
+    conflicts.erase(std::unique(conflicts.begin(), conflicts.end()), conflicts.end());
+    return conflicts;
+}
+
+// Merge the groups connected by conflicts. The paths of the merged groups are cleared and the other groups are kept.
+Vector<AgentGroup> merge_groups(
+    Vector<AgentGroup>&& groups,                   // Groups with their paths
+    const Vector<Pair<Int, Int>>& conflicts        // Pairs of groups in conflict
+)
+{
+    // Find the connected groups.
+    Vector<Int> parent(groups.size());
+    std::iota(parent.begin(), parent.end(), 0);
+    const auto find = [&](Int g)
+    {
+        while (parent[g] != g)
+        {
+            g = parent[g] = parent[parent[g]];
+        }
+        return g;
+    };
+    for (const auto& [g1, g2] : conflicts)
+    {
+        const auto r1 = find(g1);
+        const auto r2 = find(g2);
+        parent[std::max(r1, r2)] = std::min(r1, r2);
+    }
+
+    // Merge the groups into the group of lowest index.
+    Vector<AgentGroup> merged_groups;
+    Vector<Int> merged_idx(groups.size(), -1);
+    Vector<bool> is_merged(groups.size(), false);
+    for (Int g = 0; g < static_cast<Int>(groups.size()); ++g)
+    {
+        const auto r = find(g);
+        if (r == g)
+        {
+            merged_idx[g] = merged_groups.size();
+            merged_groups.push_back(std::move(groups[g]));
+        }
+        else
+        {
+            auto& merged_group = merged_groups[merged_idx[r]];
+            merged_group.agents.insert(merged_group.agents.end(), groups[g].agents.begin(), groups[g].agents.end());
+            is_merged[r] = true;
+        }
+    }
+    for (Int g = 0; g < static_cast<Int>(groups.size()); ++g)
+        if (is_merged[g])
+        {
+            auto& merged_group = merged_groups[merged_idx[g]];
+            std::sort(merged_group.agents.begin(), merged_group.agents.end());
+            merged_group.instance.reset();
+            merged_group.paths.clear();
+            merged_group.cost = 0;
+            merged_group.lower_bound = 0;
+        }
+    return merged_groups;
+}
+
+// Write the paths of every group to file in the format of write_path in order of the agents
+void write_group_paths(
+    const Map& map,                          // Map
+    const Vector<AgentGroup>& groups,        // Groups with their paths
+    const std::filesystem::path& filename    // Output file
+)
+{
+    // Order the paths by agent.
+    Vector<const Vector<Edge>*> agent_paths;
+    for (const auto& group : groups)
+        for (Int idx = 0; idx < static_cast<Int>(group.agents.size()); ++idx)
+        {
+            const auto a = group.agents[idx];
+            if (a >= static_cast<Agent>(agent_paths.size()))
+            {
+                agent_paths.resize(a + 1, nullptr);
+            }
+            agent_paths[a] = idx < static_cast<Int>(group.paths.size()) ? &group.paths[idx] : nullptr;
+        }
+
+    // Write.
+    auto f = fopen(filename.c_str(), "w");
+    release_assert(f, "Failed to create file to write solution");
+    if (std::all_of(agent_paths.begin(), agent_paths.end(), [](const auto path) { return path; }))
+    {
+        for (const auto path : agent_paths)
+        {
+            fmt::print(f, "{}\n", format_path_action(map, path->size(), path->data()));
+        }
+    }
+    fclose(f);
+}
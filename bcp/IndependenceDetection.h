@@ -0,0 +1,70 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+
+#ifndef MAPF_INDEPENDENCEDETECTION_H
+#define MAPF_INDEPENDENCEDETECTION_H
+
+#include "Includes.h"
+#include "Coordinates.h"
+#include "trufflehog/Instance.h"
+#include <filesystem>
+
+// Agents solved together as one problem in independence detection
+struct AgentGroup
+{
+    Vector<Agent> agents;            // Agents of the group in increasing order
+    SharedPtr<Instance> instance;    // Instance with only the agents of the group
+    Vector<Vector<Edge>> paths;      // Path of each agent of the group, or empty if the group is not solved
+    SCIP_Real cost;                  // Sum of the path costs
+    SCIP_Real lower_bound;           // Lower bound on the sum of the path costs
+};
+
+// Find a shortest path of an agent ignoring every other agent
+Vector<Edge> find_shortest_path(
+    const Map& map,      // Map
+    const Node start,    // Start of the agent
+    const Node goal      // Goal of the agent
+);
+
+// Make an instance with only some of the agents of another instance
+SharedPtr<Instance> make_group_instance(
+    const Instance& instance,        // Instance with every agent
+    const Vector<Agent>& agents      // Agents to keep
+);
+
+// Find the pairs of groups with colliding paths. Agents wait at their goal after the end of their path.
+Vector<Pair<Int, Int>> find_group_conflicts(
+    const Vector<AgentGroup>& groups    // Groups with their paths
+);
+
+// Merge the groups connected by conflicts. The paths of the merged groups are cleared and the other groups are kept.
+Vector<AgentGroup> merge_groups(
+    Vector<AgentGroup>&& groups,                   // Groups with their paths
+    const Vector<Pair<Int, Int>>& conflicts        // Pairs of groups in conflict
+);
+
+// Write the paths of every group to file in the format of write_path in order of the agents
+void write_group_paths(
+    const Map& map,                          // Map
+    const Vector<AgentGroup>& groups,        // Groups with their paths
+    const std::filesystem::path& filename    // Output file
+);
+
+#endif
@@ -20,6 +20,18 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Includes.h"
 #include "Reader.h"
 #include "Output.h"
+#include "Pricer_TruffleHog.h"
+#include "Checkpoint.h"
+#include "SolutionStream.h"
+#include "Anytime.h"
+#include "Subtree.h"
+#include "NodeSelector_Hybrid.h"
+#include "ProblemData.h"
+#include "Separator_Selection.h"
+#include "IndependenceDetection.h"
+#include "Solver.h"
+#include "Server.h"
+#include "Trace.h"
 
 #include "scip/scipshell.h"
 #include "scip/scipdefplugins.h"
@@ -28,7 +40,755 @@ Author: Edward Lam <ed@ed-lam.com>
 
 #include <fstream>
 #include <iostream>  
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <sstream>
+#include <thread>
 
+// Find the scenarios of a batch from a directory of scenario files or a file listing one scenario per line
+static Vector<String> read_batch(const std::filesystem::path& batch_path)
+{
+    Vector<String> scenarios;
+    if (std::filesystem::is_directory(batch_path))
+    {
+        for (const auto& entry : std::filesystem::directory_iterator(batch_path))
+            if (entry.is_regular_file() && entry.path().extension() == ".scen")
+            {
+                scenarios.push_back(entry.path().string());
+            }
+        std::sort(scenarios.begin(), scenarios.end());
+    }
+    else
+    {
+        std::ifstream file(batch_path);
+        release_assert(file.good(), "Cannot open batch file {}", batch_path.string());
+        String line;
+        while (std::getline(file, line))
+        {
+            line.erase(line.find_last_not_of(" \t\r") + 1);
+            if (!line.empty())
+            {
+                scenarios.push_back(line);
+            }
+        }
+    }
+    release_assert(!scenarios.empty(), "No scenarios in batch {}", batch_path.string());
+    return scenarios;
+}
+
+
+// Solve every scenario of a batch in worker threads. The scenarios on the same map share the parsed map and the
+// lower bounds of the low-level solver.
+static SCIP_RETCODE solve_batch(
+    const SolverOptions& options,      // Program options
+    const Vector<String>& scenarios,   // Paths to instances
+    const Int nb_threads,              // Number of instances to solve at the same time
+    Int& nb_solved                     // Number of instances solved
+)
+{
+    // Create the data shared by the instances.
+    SharedInstanceData shared;
+
+    // Solve.
+    std::atomic<Int> next_idx(0);
+    std::atomic<Int> nb_solved_shared(0);
+    Vector<SCIP_RETCODE> retcodes(std::max<Int>(nb_threads, 1), SCIP_OKAY);
+    const auto worker = [&](const Int thread_idx)
+    {
+        for (Int idx = next_idx++; idx < static_cast<Int>(scenarios.size()); idx = next_idx++)
+        {
+            // Write the outputs of each instance to separate files.
+            const auto& instance_file = scenarios[idx];
+            const auto name = std::filesystem::path(instance_file).stem().string();
+            auto instance_options = options;
+            instance_options.quiet = options.quiet || nb_threads > 1;
+            if (!options.path_file.empty())
+            {
+                instance_options.path_file = fmt::format("{}.{}", options.path_file, name);
+            }
+            if (!options.statistics_file.empty())
+            {
+                instance_options.statistics_file = fmt::format("{}.{}", options.statistics_file, name);
+            }
+            if (!options.pricing_record_file.empty())
+            {
+                instance_options.pricing_record_file = fmt::format("{}.{}", options.pricing_record_file, name);
+            }
+            if (!options.separation_record_file.empty())
+            {
+                instance_options.separation_record_file = fmt::format("{}.{}", options.separation_record_file, name);
+            }
+            if (!options.node_log_file.empty())
+            {
+                instance_options.node_log_file = fmt::format("{}.{}", options.node_log_file, name);
+            }
+
+            // Solve the instance.
+            bool solved = false;
+            const auto retcode = solve_instance(instance_options, instance_file, &shared, solved);
+            if (retcode != SCIP_OKAY)
+            {
+                retcodes[thread_idx] = retcode;
+                return;
+            }
+            nb_solved_shared += solved;
+            if (nb_threads > 1)
+            {
+                std::lock_guard<std::mutex> lock(output_mutex);
+                println("Finished instance {} of {}: {} ({})",
+                        idx + 1,
+                        scenarios.size(),
+                        instance_file,
+                        solved ? "solved" : "not solved");
+            }
+        }
+    };
+    Vector<std::thread> threads;
+    for (Int thread_idx = 1; thread_idx < nb_threads; ++thread_idx)
+    {
+        threads.emplace_back(worker, thread_idx);
+    }
+    worker(0);
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    for (const auto retcode : retcodes)
+    {
+        SCIP_CALL(retcode);
+    }
+    nb_solved = nb_solved_shared;
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Solve an instance with an increasing number of agents. Each problem starts from the columns of the problem with
+// fewer agents and reuses its map and lower bounds. Stops when a problem is not solved or every agent is included.
+static SCIP_RETCODE solve_agent_sweep(
+    const SolverOptions& options,    // Program options
+    const String& instance_file,     // Path to instance
+    bool& solved                     // Indicates if every problem is solved
+)
+{
+    // Check.
+    release_assert(options.agent_step > 0, "Cannot add {} agents at a time", options.agent_step);
+    release_assert(options.agent_limit > 0 && options.agent_limit < std::numeric_limits<Agent>::max(),
+                   "Adding agents incrementally needs the initial number of agents");
+
+    // Solve.
+    SharedInstanceData shared;
+    AgentSweepData sweep;
+    for (Agent nb_agents = options.agent_limit; ; nb_agents += options.agent_step)
+    {
+        // Write the output of each problem to a separate file.
+        auto problem_options = options;
+        problem_options.agent_limit = nb_agents;
+        if (!options.path_file.empty())
+        {
+            problem_options.path_file = fmt::format("{}.{}", options.path_file, nb_agents);
+        }
+        if (!options.statistics_file.empty())
+        {
+            problem_options.statistics_file = fmt::format("{}.{}", options.statistics_file, nb_agents);
+        }
+
+        // Start only the first problem from a warm start or a checkpoint.
+        if (nb_agents != options.agent_limit)
+        {
+            problem_options.warm_start_file.clear();
+            problem_options.resume_file.clear();
+        }
+
+        // Solve the problem.
+        SCIP_CALL(solve_instance(problem_options, instance_file, &shared, solved, &sweep));
+        println("Finished problem with {} agents ({})", sweep.nb_agents, solved ? "solved" : "not solved");
+
+        // Stop if the problem is not solved or every agent is included.
+        if (!solved || sweep.nb_agents < nb_agents ||
+            nb_agents > std::numeric_limits<Agent>::max() - options.agent_step)
+        {
+            break;
+        }
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Solve an instance by independence detection. Every agent starts in its own group with a shortest path. The groups
+// whose paths collide are merged and solved again as separate problems in worker threads until no paths collide.
+// The solution is optimal if every merged group is solved to optimality.
+static SCIP_RETCODE solve_independent_groups(
+    const SolverOptions& options,    // Program options
+    const String& instance_file,     // Path to instance
+    bool& solved                     // Indicates if every group is solved
+)
+{
+    // Check.
+    release_assert(options.independence_threads > 0,
+                   "Cannot solve groups with {} threads", options.independence_threads);
+    release_assert(!options.binary_path, "Independence detection only writes the paths in text");
+
+    // Read the instance.
+    const auto start_time = std::chrono::steady_clock::now();
+    SharedInstanceData shared;
+    const Instance instance(instance_file, options.agent_limit, options.map_cache, &shared.maps);
+    const auto& map = instance.map;
+    const auto N = instance.agents.size();
+
+    // Start with every agent in its own group.
+    Vector<AgentGroup> groups(N);
+    for (Agent a = 0; a < N; ++a)
+    {
+        auto& group = groups[a];
+        group.agents = {a};
+        group.paths = {find_shortest_path(map, instance.agents[a].start, instance.agents[a].goal)};
+        group.cost = group.paths.front().size() - 1;
+        group.lower_bound = group.cost;
+    }
+
+    // Merge the groups in conflict and solve them until no paths collide.
+    auto group_options = options;
+    group_options.quiet = options.quiet || options.independence_threads > 1;
+    group_options.warm_start_file.clear();
+    group_options.resume_file.clear();
+    group_options.subtree_file.clear();
+    group_options.checkpoint_file.clear();
+    group_options.solution_stream_file.clear();
+    group_options.node_log_file.clear();
+    group_options.cutoff = 0;
+    solved = true;
+    for (auto conflicts = find_group_conflicts(groups); solved && !conflicts.empty();
+         conflicts = find_group_conflicts(groups))
+    {
+        // Merge the groups.
+        groups = merge_groups(std::move(groups), conflicts);
+        Vector<Int> unsolved;
+        for (Int g = 0; g < static_cast<Int>(groups.size()); ++g)
+            if (groups[g].paths.empty())
+            {
+                groups[g].instance = make_group_instance(instance, groups[g].agents);
+                unsolved.push_back(g);
+            }
+        println("Solving {} merged groups of {} groups", unsolved.size(), groups.size());
+
+        // Solve the merged groups.
+        std::atomic<Int> next_idx(0);
+        std::atomic<bool> all_solved(true);
+        Vector<SCIP_RETCODE> retcodes(options.independence_threads, SCIP_OKAY);
+        const auto worker = [&](const Int thread_idx)
+        {
+            for (Int idx = next_idx++; idx < static_cast<Int>(unsolved.size()); idx = next_idx++)
+            {
+                auto& group = groups[unsolved[idx]];
+                bool group_solved = false;
+                const auto retcode = solve_instance(group_options, instance_file, &shared, group_solved, nullptr, &group);
+                if (retcode != SCIP_OKAY)
+                {
+                    retcodes[thread_idx] = retcode;
+                    return;
+                }
+                if (!group_solved)
+                {
+                    all_solved = false;
+                }
+                group.instance.reset();
+                std::lock_guard<std::mutex> lock(output_mutex);
+                println("Finished group of {} agents starting at agent {} ({})",
+                        group.agents.size(),
+                        group.agents.front(),
+                        group_solved ? "solved" : "not solved");
+            }
+        };
+        Vector<std::thread> threads;
+        for (Int thread_idx = 1; thread_idx < options.independence_threads; ++thread_idx)
+        {
+            threads.emplace_back(worker, thread_idx);
+        }
+        worker(0);
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        for (const auto retcode : retcodes)
+        {
+            SCIP_CALL(retcode);
+        }
+        solved = all_solved;
+    }
+
+    // Output.
+    {
+        // Sum the bounds of the groups.
+        SCIP_Real upper_bound = 0;
+        SCIP_Real lower_bound = 0;
+        Int largest_group = 0;
+        for (const auto& group : groups)
+        {
+            upper_bound += group.cost;
+            lower_bound += group.lower_bound;
+            largest_group = std::max<Int>(largest_group, group.agents.size());
+        }
+        println("Found {} independent groups with at most {} agents", groups.size(), largest_group);
+
+        // Write statistics in the format of solve_instance.
+        const std::chrono::duration<SCIP_Real> run_time = std::chrono::steady_clock::now() - start_time;
+        append_statistics(options, instance_file, run_time.count(), solved, upper_bound, lower_bound);
+
+        // Write the paths.
+        write_group_paths(map, solved ? groups : Vector<AgentGroup>{}, options.path_file);
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Configurations of the racers, which differ in the node selection, the branching and the separators
+static const Vector<std::function<void(SolverOptions&)>> racing_configurations{
+    [](SolverOptions&) {},
+    [](SolverOptions& options) { options.node_selection = "dfs"; },
+    [](SolverOptions& options) { options.wait_branching = true; },
+    [](SolverOptions& options) { options.separator_profile = "auto"; },
+    [](SolverOptions& options) { options.branching_lookahead = std::max<Int>(options.branching_lookahead, 4); },
+    [](SolverOptions& options) { options.node_selection = "estimate"; },
+};
+
+// Solve an instance by racing differently configured solvers in worker threads. The racers share their incumbents
+// and stop as soon as one of them proves optimality. The first racer uses the given options. The others change one
+// setting each and use a different seed.
+static SCIP_RETCODE solve_racing(
+    const SolverOptions& options,    // Program options
+    const String& instance_file,     // Path to instance
+    bool& solved                     // Indicates if a racer solved the instance
+)
+{
+    // Check.
+    release_assert(options.racing_threads > 0, "Cannot race {} solvers", options.racing_threads);
+    release_assert(!options.binary_path, "Racing mode only writes the paths in text");
+
+    // Read the instance.
+    const auto start_time = std::chrono::steady_clock::now();
+    SharedInstanceData shared;
+    const auto instance = std::make_shared<Instance>(instance_file,
+                                                     options.agent_limit,
+                                                     options.map_cache,
+                                                     &shared.maps);
+    const auto& map = instance->map;
+    const auto N = instance->agents.size();
+
+    // Make the options of every racer.
+    Vector<SolverOptions> racer_options(options.racing_threads, options);
+    for (Int racer = 0; racer < options.racing_threads; ++racer)
+    {
+        auto& racer_option = racer_options[racer];
+        racing_configurations[racer % racing_configurations.size()](racer_option);
+        racer_option.seed = options.seed + racer;
+        racer_option.quiet = options.quiet || racer > 0;
+        racer_option.checkpoint_file.clear();
+        racer_option.solution_stream_file.clear();
+        racer_option.node_log_file.clear();
+        racer_option.pricing_record_file.clear();
+        racer_option.separation_record_file.clear();
+    }
+
+    // Solve every agent as one group in each racer so that no racer writes output.
+    Vector<AgentGroup> groups(options.racing_threads);
+    for (auto& group : groups)
+    {
+        group.instance = instance;
+        for (Agent a = 0; a < N; ++a)
+        {
+            group.agents.push_back(a);
+        }
+    }
+
+    // Race.
+    RaceData race;
+    Vector<SCIP_RETCODE> retcodes(options.racing_threads, SCIP_OKAY);
+    const auto worker = [&](const Int racer)
+    {
+        bool racer_solved = false;
+        retcodes[racer] = solve_instance(racer_options[racer],
+                                         instance_file,
+                                         &shared,
+                                         racer_solved,
+                                         nullptr,
+                                         &groups[racer],
+                                         &race);
+        if (retcodes[racer] == SCIP_OKAY && racer_solved)
+        {
+            std::lock_guard<std::mutex> lock(race.mutex);
+            if (race.winner < 0)
+            {
+                race.winner = racer;
+                race.finished = true;
+            }
+        }
+    };
+    Vector<std::thread> threads;
+    for (Int racer = 1; racer < options.racing_threads; ++racer)
+    {
+        threads.emplace_back(worker, racer);
+    }
+    worker(0);
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    for (const auto retcode : retcodes)
+    {
+        SCIP_CALL(retcode);
+    }
+
+    // Output.
+    {
+        // Take the solution of the winner or else the best incumbent and the best lower bound of every racer.
+        solved = race.winner >= 0;
+        AgentGroup result;
+        result.agents = groups.front().agents;
+        if (solved)
+        {
+            const auto& winner = groups[race.winner];
+            result.paths = winner.paths;
+            result.cost = winner.cost;
+            result.lower_bound = winner.lower_bound;
+            println("Racer {} solved the instance", race.winner);
+        }
+        else
+        {
+            result.paths = race.paths;
+            result.cost = race.cost;
+            result.lower_bound = -SCIP_DEFAULT_INFINITY;
+            for (const auto& group : groups)
+            {
+                result.lower_bound = std::max(result.lower_bound, group.lower_bound);
+            }
+            println("No racer solved the instance");
+        }
+
+        // Write statistics in the format of solve_instance.
+        const std::chrono::duration<SCIP_Real> run_time = std::chrono::steady_clock::now() - start_time;
+        append_statistics(options, instance_file, run_time.count(), solved, result.cost, result.lower_bound);
+
+        // Write the paths.
+        write_group_paths(map,
+                          result.paths.empty() ? Vector<AgentGroup>{} : Vector<AgentGroup>{std::move(result)},
+                          options.path_file);
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Solve an instance in rolling windows. Each window only resolves the conflicts in its first timesteps and starts
+// from the positions reached in the previous window. The first timesteps of the paths of each window are kept and
+// the rest of the paths become the initial columns of the next window. Stops once every path ends inside a window.
+// The solution is collision-free but not optimal.
+static SCIP_RETCODE solve_rolling_horizon(
+    const SolverOptions& options,    // Program options
+    const String& instance_file,     // Path to instance
+    bool& solved                     // Indicates if every agent reaches its goal
+)
+{
+    // Check.
+    release_assert(options.window_step >= 1 && options.window_step < options.window,
+                   "Cannot keep {} timesteps of a window of {} timesteps", options.window_step, options.window);
+    release_assert(!options.binary_path, "Rolling-horizon mode only writes the paths in text");
+
+    // Read the instance.
+    const auto start_time = std::chrono::steady_clock::now();
+    SharedInstanceData shared;
+    const Instance instance(instance_file, options.agent_limit, options.map_cache, &shared.maps);
+    const auto& map = instance.map;
+    const auto N = instance.agents.size();
+
+    // Start the kept paths at the start of every agent. The sum of the shortest path lengths is a lower bound.
+    AgentGroup plan;
+    plan.paths.resize(N);
+    plan.lower_bound = 0;
+    for (Agent a = 0; a < N; ++a)
+    {
+        plan.agents.push_back(a);
+        plan.paths[a] = {Edge{instance.agents[a].start, Direction::INVALID}};
+        plan.lower_bound += find_shortest_path(map, instance.agents[a].start, instance.agents[a].goal).size() - 1;
+    }
+
+    // Solve the windows.
+    auto window_options = options;
+    window_options.warm_start_file.clear();
+    window_options.resume_file.clear();
+    window_options.subtree_file.clear();
+    window_options.checkpoint_file.clear();
+    window_options.solution_stream_file.clear();
+    window_options.cutoff = 0;
+    AgentGroup window;
+    window.agents = plan.agents;
+    solved = false;
+    for (Time offset = 0; ; offset += options.window_step)
+    {
+        // Share the time limit among the windows.
+        if (options.time_limit > 0)
+        {
+            const std::chrono::duration<SCIP_Real> run_time = std::chrono::steady_clock::now() - start_time;
+            window_options.time_limit = options.time_limit - run_time.count();
+            if (window_options.time_limit <= 0)
+            {
+                break;
+            }
+        }
+
+        // Make the instance of the window from the current positions of the agents.
+        window.instance = std::make_shared<Instance>();
+        window.instance->scenario_path = instance.scenario_path;
+        window.instance->map_path = instance.map_path;
+        window.instance->map = map;
+        for (Agent a = 0; a < N; ++a)
+        {
+            const auto [x, y] = map.get_xy(plan.paths[a].back().n);
+            const auto& agent = instance.agents[a];
+            window.instance->agents.add_agent(x, y, agent.goal_x, agent.goal_y, window.instance->map);
+        }
+
+        // Solve the window.
+        bool window_solved = false;
+        SCIP_CALL(solve_instance(window_options, instance_file, &shared, window_solved, nullptr, &window));
+        window.instance.reset();
+        if (!window_solved)
+        {
+            break;
+        }
+        Time window_length = 0;
+        for (const auto& path : window.paths)
+        {
+            window_length = std::max<Time>(window_length, path.size());
+        }
+        println("Solved window at timestep {} with paths of up to {} timesteps", offset, window_length);
+
+        // Keep the whole paths if every path ends inside the window. Agents wait at their goal after the end of their
+        // path, so no conflicts are left after the window.
+        const auto length = window_length <= options.window ? window_length : options.window_step + 1;
+        bool moved = false;
+        for (Agent a = 0; a < N; ++a)
+        {
+            auto& kept_path = plan.paths[a];
+            auto& path = window.paths[a];
+            const auto end = std::min<Time>(length, path.size());
+            for (Time t = 1; t < end; ++t)
+            {
+                kept_path.back().d = map.get_direction(path[t - 1].n, path[t].n);
+                kept_path.push_back(Edge{path[t].n, Direction::INVALID});
+            }
+            for (Time t = end; t < length; ++t)
+            {
+                kept_path.back().d = Direction::WAIT;
+                kept_path.push_back(Edge{path.back().n, Direction::INVALID});
+            }
+            moved |= end > 1;
+
+            // Continue the rest of the path in the next window.
+            path.erase(path.begin(), path.begin() + (end - 1));
+        }
+        if (window_length <= options.window)
+        {
+            solved = true;
+            break;
+        }
+
+        // Stop if no agent moves since the next window is the same problem.
+        if (!moved)
+        {
+            break;
+        }
+    }
+
+    // Remove the waits at the goal at the end of the paths.
+    plan.cost = 0;
+    for (Agent a = 0; a < N; ++a)
+    {
+        auto& path = plan.paths[a];
+        const auto goal = instance.agents[a].goal;
+        while (path.size() >= 2 && path[path.size() - 2].n == goal && path.back().n == goal)
+        {
+            path.pop_back();
+        }
+        path.back().d = Direction::INVALID;
+        plan.cost += path.size() - 1;
+    }
+
+    // Output.
+    {
+        // Write statistics in the format of solve_instance.
+        const std::chrono::duration<SCIP_Real> run_time = std::chrono::steady_clock::now() - start_time;
+        append_statistics(options, instance_file, run_time.count(), solved, solved ? plan.cost : -1, plan.lower_bound);
+
+        // Write the paths.
+        write_group_paths(map, solved ? Vector<AgentGroup>{plan} : Vector<AgentGroup>{}, options.path_file);
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Replan given by a line of a replan file
+struct Replan
+{
+    Time offset;                                     // Number of timesteps of the previous plan executed
+    Vector<Tuple<Agent, Position, Position>> goals;  // New goals of some agents
+};
+
+// Read the replans from a file with one replan per line. Each line has the number of timesteps executed since the
+// previous plan started followed by the agent and the coordinates of every new goal in the format of the
+// scenario files.
+static Vector<Replan> read_replans(const std::filesystem::path& replan_path)
+{
+    Vector<Replan> replans;
+    std::ifstream file(replan_path);
+    release_assert(file.good(), "Cannot open replan file {}", replan_path.string());
+    String line;
+    while (std::getline(file, line))
+    {
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (line.empty() || line.front() == '#')
+        {
+            continue;
+        }
+        std::istringstream ss(line);
+        auto& replan = replans.emplace_back();
+        release_assert(ss >> replan.offset && replan.offset > 0, "Invalid replan {}", line);
+        Agent a;
+        Position x;
+        Position y;
+        while (ss >> a)
+        {
+            release_assert(ss >> x >> y, "Invalid goal of agent {} in replan {}", a, line);
+            replan.goals.emplace_back(a, x, y);
+        }
+        release_assert(ss.eof(), "Invalid replan {}", line);
+    }
+    return replans;
+}
+
+// Solve an instance and replan after the agents execute the plan for some timesteps and some receive new goals.
+// Each replan starts from the positions of the agents in the previous plan and from the rest of the columns of the
+// previous problem. The rest of the previous plan is also the initial solution if no goal changes.
+static SCIP_RETCODE solve_lifelong(
+    const SolverOptions& options,    // Program options
+    const String& instance_file,     // Path to instance
+    bool& solved                     // Indicates if every plan is found
+)
+{
+    // Check.
+    release_assert(!options.binary_path, "Lifelong mode only writes the paths in text");
+
+    // Read the instance and the replans.
+    SharedInstanceData shared;
+    const Instance instance(instance_file, options.agent_limit, options.map_cache, &shared.maps);
+    const auto& map = instance.map;
+    const auto N = instance.agents.size();
+    const auto replans = read_replans(options.replan_file);
+
+    // Start with the agents of the instance.
+    AgentGroup plan;
+    for (Agent a = 0; a < N; ++a)
+    {
+        plan.agents.push_back(a);
+    }
+    plan.instance = make_group_instance(instance, plan.agents);
+
+    // Solve and replan.
+    AgentSweepData sweep;
+    for (Int k = 0; ; ++k)
+    {
+        // Start only the first plan from a warm start or a checkpoint and write every plan to a separate file.
+        auto plan_options = options;
+        if (k > 0)
+        {
+            plan_options.warm_start_file.clear();
+            plan_options.resume_file.clear();
+            plan_options.subtree_file.clear();
+            plan_options.cutoff = 0;
+        }
+        plan_options.checkpoint_file.clear();
+
+        // Solve.
+        const auto start_time = std::chrono::steady_clock::now();
+        SCIP_CALL(solve_instance(plan_options, instance_file, &shared, solved, &sweep, &plan));
+        const std::chrono::duration<SCIP_Real> run_time = std::chrono::steady_clock::now() - start_time;
+        println("Finished plan {} in {:.2f} seconds ({})", k, run_time.count(), solved ? "solved" : "not solved");
+        append_statistics(options, instance_file, run_time.count(), solved, plan.cost, plan.lower_bound);
+        write_group_paths(map,
+                          solved ? Vector<AgentGroup>{plan} : Vector<AgentGroup>{},
+                          fmt::format("{}.{}", options.path_file, k));
+
+        // Stop if the plan is not found or no replans are left.
+        if (!solved || k == static_cast<Int>(replans.size()))
+        {
+            break;
+        }
+
+        // Move the agents along the plan and change the goals.
+        const auto& [offset, goals] = replans[k];
+        const auto& agents = plan.instance->agents;
+        Vector<Pair<Position, Position>> new_goals(N);
+        for (Agent a = 0; a < N; ++a)
+        {
+            new_goals[a] = {agents[a].goal_x, agents[a].goal_y};
+        }
+        for (const auto& [a, x, y] : goals)
+        {
+            // Add padding.
+            release_assert(a < N, "Replan {} changes the goal of agent {} of {} agents", k, a, N);
+            release_assert(x >= 0 && y >= 0 && x + 2 < map.width() && y + 2 < map.height() &&
+                           map[map.get_id(x + 1, y + 1)],
+                           "Goal ({},{}) of agent {} in replan {} is not passable", x, y, a, k);
+            new_goals[a] = {x + 1, y + 1};
+        }
+        auto next_instance = std::make_shared<Instance>();
+        next_instance->scenario_path = instance.scenario_path;
+        next_instance->map_path = instance.map_path;
+        next_instance->map = map;
+        for (Agent a = 0; a < N; ++a)
+        {
+            const auto& path = plan.paths[a];
+            const auto [x, y] = map.get_xy(path[std::min<Time>(offset, path.size() - 1)].n);
+            next_instance->agents.add_agent(x, y, new_goals[a].first, new_goals[a].second, next_instance->map);
+        }
+
+        // Shift the columns and the plan.
+        sweep.columns = shift_columns(sweep.columns, offset, next_instance->agents);
+        Vector<CheckpointColumn> incumbent;
+        for (Agent a = 0; a < N; ++a)
+        {
+            incumbent.push_back({a, std::move(plan.paths[a])});
+        }
+        incumbent = shift_columns(incumbent, offset, next_instance->agents);
+        plan.paths.clear();
+        if (incumbent.size() == N)
+        {
+            // Add the rest of the plan separately from the other columns.
+            for (auto& [a, path] : incumbent)
+            {
+                plan.paths.push_back(std::move(path));
+            }
+            sweep.columns.erase(std::remove_if(sweep.columns.begin(),
+                                               sweep.columns.end(),
+                                               [&](const CheckpointColumn& column)
+                                               {
+                                                   return column.path == plan.paths[column.a];
+                                               }),
+                                sweep.columns.end());
+        }
+        println("Replanning {} timesteps later with {} new goals and {} columns",
+                offset, goals.size(), sweep.columns.size() + plan.paths.size());
+        plan.instance = std::move(next_instance);
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
 
 int start_solver(
     int argc,      // Number of shell parameters
@@ -36,38 +796,100 @@ int start_solver(
 )
 {
     // Parse program options.
+    SolverOptions options;
     String instance_file;
-    Agent agent_limit = std::numeric_limits<Agent>::max();
-    String path_file;
-    String output_file;
-    SCIP_Real time_limit = 0;
-    SCIP_Longint node_limit = 0;
-    SCIP_Real gap_limit = 0;
+    String batch_path;
+    Int batch_threads = 1;
+    String server_path;
+    Int server_threads = 1;
+    String trace_path;
+    Int trace_buffer_size = 1000000;
     try
     {
         // Create program options.
-        cxxopts::Options options(argv[0],
-                                 "BCP-MAPF - branch-and-cut-and-price for multi-agent path finding");
-        options.positional_help("instance_file").show_positional_help();
-        options.add_options()
+        cxxopts::Options program_options(argv[0],
+                                         "BCP-MAPF - branch-and-cut-and-price for multi-agent path finding");
+        program_options.positional_help("instance_file").show_positional_help();
+        program_options.add_options()
             ("help", "Print help")
             ("f,file", "Path to instance file", cxxopts::value<String>())
             ("a,agent-limit", "Read the first several agents only", cxxopts::value<Agent>())
             ("t,time-limit", "Time limit in seconds", cxxopts::value<SCIP_Real>())
             ("n,node-limit", "Maximum number of branch-and-bound nodes", cxxopts::value<SCIP_Longint>())
+            ("seed", "Shift the seeds of the random number generators of SCIP", cxxopts::value<Int>())
             ("g,gap-limit", "Solve to an optimality gap", cxxopts::value<SCIP_Real>())
+            ("anytime", "Schedule of gap limits as gap:seconds targets separated by commas, e.g. 0.05:2,0.01:10 stops at a 5% gap within 2 s, else at a 1% gap within 10 s", cxxopts::value<String>())
+            ("node-selection", "Node selection rule (bfs, dfs, estimate, hybridestim, restartdfs or hybrid to dive until an incumbent is found and then use the best bound)", cxxopts::value<String>())
+            ("pricing-threads", "Number of threads for pricing agents in parallel", cxxopts::value<Int>())
+            ("pricing-columns", "Maximum number of columns to add for an agent in each round of pricing", cxxopts::value<Int>())
+            ("pricing-smoothing", "Weight of the stability center in the smoothed duals for pricing (0 to disable)", cxxopts::value<SCIP_Real>())
+            ("adaptive-pricing", "Choose the number of agents to price in each round from the LP and pricing times")
+            ("backward-pruning", "Prune labels that cannot reach the goal in time for agents constrained by branching")
+            ("penalty-heuristic", "Bound the unavoidable penalties in the heuristic for agents constrained by branching")
+            ("symmetric-pricing", "Price agents with the same start and goal once while they have no branching decisions or cuts of their own")
+            ("reduced-cost-fixing", "Forbid the node-times that no path improving on the incumbent can use once the LP of a node is solved")
+            ("label-budget", "Number of labels expanded for an agent before repricing exactly if no column is found (0 to disable)", cxxopts::value<Int>())
+            ("focal-weight", "Weight of the lower bound in the pricer before repricing exactly if no column is found (1 to disable)", cxxopts::value<Float>())
+            ("label-block-size", "Size in MB of each block of memory for the labels of the pricer", cxxopts::value<Int>())
+            ("huge-pages", "Back the labels of the pricer with transparent huge pages")
+            ("pin-threads", "Pin each pricing thread to a CPU so that its memory stays on its NUMA node")
+            ("numa-replicate", "Copy the map and the global edge penalties to the NUMA node of each pricing thread (implies --pin-threads)")
+            ("frontier-budget", "Size in MB of the dense dominance frontier of each pricer thread (0 to always hash)", cxxopts::value<Int>())
+            ("pricer", "Low-level solver of the pricer (astar, sipp or auto)", cxxopts::value<String>())
+            ("heuristic-cache", "Directory to cache the heuristic across runs", cxxopts::value<String>())
+            ("heuristic-memory", "Memory in MB for the heuristic of each pricing thread before evicting the least recently used goals (0 to disable)", cxxopts::value<Int>())
+            ("heuristic-threads", "Number of threads computing the heuristic of every goal at startup (0 for the number of pricing threads, -1 to compute it on demand)", cxxopts::value<Int>())
+            ("map-cache", "Cache the parsed map next to the map file for faster reloads")
+            ("record-pricing", "Record the pricing problems to a file for replay in trufflehog", cxxopts::value<String>())
+            ("record-separation", "Record the input of the separators to a file for replay in bcp-mapf-separation-replay", cxxopts::value<String>())
+            ("record-separation-node", "Branch-and-bound node whose separation rounds are recorded (-1 for every node)", cxxopts::value<Int>())
+            ("record-separation-rounds", "Number of separation rounds recorded in each node (-1 for every round)", cxxopts::value<Int>())
+            ("separation-threads", "Number of threads for finding cuts in parallel", cxxopts::value<Int>())
+            ("adaptive-separation", "Skip separators whose recent calls took long without finding cuts")
+            ("separators", "Only run these separators, separated by commas", cxxopts::value<Vector<String>>())
+            ("disable-separators", "Do not run these separators, separated by commas", cxxopts::value<Vector<String>>())
+            ("separator-profile", "Choose the separators from the map (auto) or run all of them (all)", cxxopts::value<String>())
+            ("column-age-limit", "Delete columns unused in the LP for this many rounds (0 to keep all columns)", cxxopts::value<Int>())
+            ("cut-age-limit", "Remove two-agent robust cuts with zero dual for this many rounds (0 to keep all cuts)", cxxopts::value<Int>())
+            ("root-lp-algorithm", "Algorithm for the initial LP at the root (auto, primal, dual, barrier or barrier-crossover)", cxxopts::value<String>())
+            ("resolve-lp-algorithm", "Algorithm for re-solving the LP after pricing or branching (auto, primal, dual, barrier or barrier-crossover)", cxxopts::value<String>())
+            ("branching-lookahead", "Number of vertex branching candidates evaluated by re-pricing the agent (0 to disable)", cxxopts::value<Int>())
+            ("branching-reliability", "Number of observed bound gains for the pseudocosts of a branching decision to be reliable (0 to disable)", cxxopts::value<Int>())
+            ("wait-branching", "Branch on an agent waiting at a vertex that it both waits at and leaves before branching on vertices")
+            ("warm-start", "Start from the paths in a solution file written by a previous run", cxxopts::value<String>())
+            ("checkpoint", "Periodically write the columns, the incumbent and the pricing priorities to a file", cxxopts::value<String>())
+            ("checkpoint-interval", "Number of seconds between checkpoints", cxxopts::value<SCIP_Real>())
+            ("memory-interval", "Number of seconds between samples of the memory usage, which is also printed on SIGUSR1 (0 to disable)", cxxopts::value<SCIP_Real>())
+            ("resume", "Resume from a checkpoint file", cxxopts::value<String>())
+            ("stream-solutions", "Append every new incumbent and the bounds as a line of JSON to a file or a pipe", cxxopts::value<String>())
+            ("node-log", "Append a line of CSV for every node of the search tree with its branching decision, bounds, pricing rounds, columns, cuts and time", cxxopts::value<String>())
+            ("subtree", "Solve the subtree given by a file of branching decisions", cxxopts::value<String>())
+            ("cutoff", "Only search for solutions better than this cost", cxxopts::value<SCIP_Real>())
+            ("agent-step", "Solve again with this many more agents after each solve, starting from the previous columns", cxxopts::value<Agent>())
+            ("independence-detection", "Solve the groups of agents whose shortest paths do not collide as separate problems, this many at a time", cxxopts::value<Int>())
+            ("racing-threads", "Race this many differently configured solvers sharing their incumbents until one proves optimality", cxxopts::value<Int>())
+            ("window", "Resolve the conflicts in the next this many timesteps only and roll the window forward", cxxopts::value<Time>())
+            ("window-step", "Number of timesteps to keep from each window, by default half the window", cxxopts::value<Time>())
+            ("replan", "Replan after the number of timesteps and the new goals in each line of a file", cxxopts::value<String>())
             ("o,output","write statistics to a file", cxxopts::value<Vector<String>>())
             ("p,output-path","write solution path to a file", cxxopts::value<Vector<String>>())
+            ("binary-path", "Write the solution paths in the compact binary format")
+            ("batch", "Solve every scenario in a directory or listed in a file, one per line", cxxopts::value<String>())
+            ("batch-threads", "Number of instances to solve at the same time in batch mode", cxxopts::value<Int>())
+            ("server", "Serve solve requests on a Unix domain socket, keeping the maps and the lower bounds across requests", cxxopts::value<String>())
+            ("server-threads", "Number of requests to solve at the same time in server mode", cxxopts::value<Int>())
+            ("trace", "Write a timeline of the LP solves, pricing, separators, branching and heuristics to a file in the Chrome trace format", cxxopts::value<String>())
+            ("trace-buffer-size", "Number of trace events kept by each thread, after which the oldest are overwritten", cxxopts::value<Int>())
         ;
-        options.parse_positional({"file"});
+        program_options.parse_positional({"file"});
 
         // Parse options.
-        auto result = options.parse(argc, argv);
+        auto result = program_options.parse(argc, argv);
 
         // Print help.
-        if (result.count("help") || !result.count("file"))
+        if (result.count("help") || (!result.count("file") && !result.count("batch") && !result.count("server")))
         {
-            println("{}", options.help());
+            println("{}", program_options.help());
             exit(0);
         }
 
@@ -81,37 +903,351 @@ int start_solver(
         // Get path to instance.
         if (result.count("output-path"))
         {
-            path_file = result["output-path"].as<Vector<String>>().at(0);
+            options.path_file = result["output-path"].as<Vector<String>>().at(0);
         }
+        options.binary_path = result.count("binary-path") > 0;
         
         // Get path to instance.
         if (result.count("output"))
         {
-            output_file = result["output"].as<Vector<String>>().at(0);
+            options.output_file = result["output"].as<Vector<String>>().at(0);
+            options.statistics_file = options.output_file;
         }
 
         // Get agents limit.
         if (result.count("agent-limit"))
         {
-            agent_limit = result["agent-limit"].as<Agent>();
+            options.agent_limit = result["agent-limit"].as<Agent>();
         }
 
         // Get time limit.
         if (result.count("time-limit"))
         {
-            time_limit = result["time-limit"].as<SCIP_Real>();
+            options.time_limit = result["time-limit"].as<SCIP_Real>();
         }
 
         // Get node limit.
         if (result.count("node-limit"))
         {
-            node_limit = result["node-limit"].as<SCIP_Longint>();
+            options.node_limit = result["node-limit"].as<SCIP_Longint>();
+        }
+
+        // Get the shift of the random seeds.
+        if (result.count("seed"))
+        {
+            options.seed = result["seed"].as<Int>();
         }
 
         // Get optimality gap limit.
         if (result.count("gap-limit"))
         {
-            gap_limit = result["gap-limit"].as<SCIP_Real>();
+            options.gap_limit = result["gap-limit"].as<SCIP_Real>();
+        }
+        if (result.count("anytime"))
+        {
+            options.anytime_schedule = result["anytime"].as<String>();
+        }
+
+        // Get node selection rule.
+        if (result.count("node-selection"))
+        {
+            options.node_selection = result["node-selection"].as<String>();
+        }
+
+        // Get number of pricing threads.
+        if (result.count("pricing-threads"))
+        {
+            options.pricing_threads = result["pricing-threads"].as<Int>();
+        }
+
+        // Get number of columns per agent in each round of pricing.
+        if (result.count("pricing-columns"))
+        {
+            options.pricing_columns = result["pricing-columns"].as<Int>();
+        }
+
+        // Get weight of the stability center for pricing.
+        if (result.count("pricing-smoothing"))
+        {
+            options.pricing_smoothing = result["pricing-smoothing"].as<SCIP_Real>();
+        }
+
+        // Check if the number of agents to price is adaptive.
+        options.adaptive_pricing = result.count("adaptive-pricing") > 0;
+
+        // Check if labels of constrained agents are pruned backward from the goal.
+        options.backward_pruning = result.count("backward-pruning") > 0;
+
+        // Check if the heuristic of constrained agents bounds the penalties.
+        options.penalty_heuristic = result.count("penalty-heuristic") > 0;
+
+        // Check if interchangeable agents share their pricing problem.
+        options.symmetric_pricing = result.count("symmetric-pricing") > 0;
+        options.reduced_cost_fixing = result.count("reduced-cost-fixing") > 0;
+
+        // Get the number of labels expanded for an agent before pricing exactly.
+        if (result.count("label-budget"))
+        {
+            options.label_budget = result["label-budget"].as<Int>();
+        }
+
+        // Get the weight of the lower bound in the pricer before pricing exactly.
+        if (result.count("focal-weight"))
+        {
+            options.focal_weight = result["focal-weight"].as<Float>();
+        }
+
+        // Get memory settings for the labels of the pricer.
+        if (result.count("label-block-size"))
+        {
+            options.label_block_size = result["label-block-size"].as<Int>();
+        }
+        options.huge_pages = result.count("huge-pages") > 0;
+
+        // Get placement of the pricing threads.
+        options.pin_threads = result.count("pin-threads") > 0;
+        options.numa_replicate = result.count("numa-replicate") > 0;
+        if (result.count("frontier-budget"))
+        {
+            options.frontier_budget = result["frontier-budget"].as<Int>();
+        }
+
+        // Get low-level solver of the pricer.
+        if (result.count("pricer"))
+        {
+            options.pricer_low_level_solver = result["pricer"].as<String>();
+        }
+
+        // Get heuristic cache directory.
+        if (result.count("heuristic-cache"))
+        {
+            options.heuristic_cache_dir = result["heuristic-cache"].as<String>();
+        }
+
+        // Get memory budget of the heuristic.
+        if (result.count("heuristic-memory"))
+        {
+            options.heuristic_memory = result["heuristic-memory"].as<Int>();
+            release_assert(options.heuristic_memory >= 0, "Invalid heuristic memory {} MB", options.heuristic_memory);
+        }
+
+        // Get number of threads computing the heuristic at startup.
+        if (result.count("heuristic-threads"))
+        {
+            options.heuristic_threads = result["heuristic-threads"].as<Int>();
+            release_assert(options.heuristic_threads >= -1,
+                           "Invalid number of heuristic threads {}", options.heuristic_threads);
+        }
+
+        // Check if the parsed map is cached.
+        options.map_cache = result.count("map-cache") > 0;
+
+        // Get file to record the pricing problems.
+        if (result.count("record-pricing"))
+        {
+            options.pricing_record_file = result["record-pricing"].as<String>();
+        }
+
+        // Get file to record the input of the separators.
+        if (result.count("record-separation"))
+        {
+            options.separation_record_file = result["record-separation"].as<String>();
+        }
+        if (result.count("record-separation-node"))
+        {
+            options.separation_record_node = result["record-separation-node"].as<Int>();
+        }
+        if (result.count("record-separation-rounds"))
+        {
+            options.separation_record_rounds = result["record-separation-rounds"].as<Int>();
+        }
+
+        // Get number of separation threads.
+        if (result.count("separation-threads"))
+        {
+            options.separation_threads = result["separation-threads"].as<Int>();
+        }
+
+        // Get adaptive scheduling of separators.
+        options.adaptive_separation = result.count("adaptive-separation") > 0;
+
+        // Get the separators to run.
+        if (result.count("separators"))
+        {
+            options.separators = result["separators"].as<Vector<String>>();
+        }
+        if (result.count("disable-separators"))
+        {
+            options.disabled_separators = result["disable-separators"].as<Vector<String>>();
+        }
+        if (result.count("separator-profile"))
+        {
+            options.separator_profile = result["separator-profile"].as<String>();
+        }
+
+        // Get age limit of columns.
+        if (result.count("column-age-limit"))
+        {
+            options.column_age_limit = result["column-age-limit"].as<Int>();
+        }
+
+        // Get age limit of two-agent robust cuts.
+        if (result.count("cut-age-limit"))
+        {
+            options.cut_age_limit = result["cut-age-limit"].as<Int>();
+        }
+
+        // Get the LP algorithms.
+        if (result.count("root-lp-algorithm"))
+        {
+            options.root_lp_algorithm = result["root-lp-algorithm"].as<String>();
+        }
+        if (result.count("resolve-lp-algorithm"))
+        {
+            options.resolve_lp_algorithm = result["resolve-lp-algorithm"].as<String>();
+        }
+
+        // Get number of branching candidates to evaluate by re-pricing.
+        if (result.count("branching-lookahead"))
+        {
+            options.branching_lookahead = result["branching-lookahead"].as<Int>();
+        }
+
+        // Get number of observations for the pseudocosts of a branching decision to be reliable.
+        if (result.count("branching-reliability"))
+        {
+            options.branching_reliability = result["branching-reliability"].as<Int>();
+        }
+
+        // Get whether to branch on waits.
+        options.wait_branching = result.count("wait-branching") > 0;
+
+        // Get the file of paths to warm-start from.
+        if (result.count("warm-start"))
+        {
+            options.warm_start_file = result["warm-start"].as<String>();
+        }
+
+        // Get the checkpoint file.
+        if (result.count("checkpoint"))
+        {
+            options.checkpoint_file = result["checkpoint"].as<String>();
+        }
+        if (result.count("checkpoint-interval"))
+        {
+            options.checkpoint_interval = result["checkpoint-interval"].as<SCIP_Real>();
+        }
+
+        // Get the interval between samples of the memory usage.
+        if (result.count("memory-interval"))
+        {
+            options.memory_interval = result["memory-interval"].as<SCIP_Real>();
+        }
+
+        // Get the file to stream the incumbents to.
+        if (result.count("stream-solutions"))
+        {
+            options.solution_stream_file = result["stream-solutions"].as<String>();
+        }
+
+        // Get the file to log the nodes to.
+        if (result.count("node-log"))
+        {
+            options.node_log_file = result["node-log"].as<String>();
+        }
+
+        // Get the subtree to solve.
+        if (result.count("subtree"))
+        {
+            options.subtree_file = result["subtree"].as<String>();
+        }
+
+        // Get the cut-off.
+        if (result.count("cutoff"))
+        {
+            options.cutoff = result["cutoff"].as<SCIP_Real>();
+        }
+
+        // Get the number of agents to add after each solve.
+        if (result.count("agent-step"))
+        {
+            options.agent_step = result["agent-step"].as<Agent>();
+        }
+
+        // Get the number of groups of agents to solve at the same time in independence detection.
+        if (result.count("independence-detection"))
+        {
+            options.independence_threads = result["independence-detection"].as<Int>();
+            release_assert(options.independence_threads > 0,
+                           "Cannot solve groups with {} threads", options.independence_threads);
+        }
+
+        // Get the number of solvers racing on the instance.
+        if (result.count("racing-threads"))
+        {
+            options.racing_threads = result["racing-threads"].as<Int>();
+            release_assert(options.racing_threads > 0, "Cannot race {} solvers", options.racing_threads);
+        }
+
+        // Get the file of replans in lifelong mode.
+        if (result.count("replan"))
+        {
+            options.replan_file = result["replan"].as<String>();
+        }
+
+        // Get the window and the number of timesteps to keep from each window in rolling-horizon mode.
+        if (result.count("window"))
+        {
+            options.window = result["window"].as<Time>();
+            release_assert(options.window >= 2, "Cannot roll a window of {} timesteps", options.window);
+            options.window_step = std::max<Time>(1, options.window / 2);
+        }
+        if (result.count("window-step"))
+        {
+            options.window_step = result["window-step"].as<Time>();
+            release_assert(options.window > 0, "Window step requires a window");
+            release_assert(options.window_step >= 1 && options.window_step < options.window,
+                           "Cannot keep {} timesteps of a window of {} timesteps",
+                           options.window_step,
+                           options.window);
+        }
+
+        // Get the checkpoint file to resume from.
+        if (result.count("resume"))
+        {
+            options.resume_file = result["resume"].as<String>();
+        }
+
+        // Get the scenarios to solve in batch mode.
+        if (result.count("batch"))
+        {
+            batch_path = result["batch"].as<String>();
+        }
+        if (result.count("batch-threads"))
+        {
+            batch_threads = result["batch-threads"].as<Int>();
+        }
+
+        // Get the socket and the number of worker threads in server mode.
+        if (result.count("server"))
+        {
+            server_path = result["server"].as<String>();
+        }
+        if (result.count("server-threads"))
+        {
+            server_threads = result["server-threads"].as<Int>();
+            release_assert(server_threads > 0, "Cannot serve requests with {} threads", server_threads);
+        }
+
+        // Get the file to write the trace to.
+        if (result.count("trace"))
+        {
+            trace_path = result["trace"].as<String>();
+        }
+        if (result.count("trace-buffer-size"))
+        {
+            trace_buffer_size = result["trace-buffer-size"].as<Int>();
+            release_assert(trace_buffer_size > 0, "Cannot trace with a buffer of {} events", trace_buffer_size);
         }
     }
     catch (const cxxopts::OptionException& e)
@@ -188,242 +1324,59 @@ int start_solver(
 #endif
     println("");
 
-    // Initialize SCIP.
-    SCIP* scip = nullptr;
-    SCIP_CALL(SCIPcreate(&scip));
-
-    // Set up plugins.
-    {
-        // Include some default SCIP plugins.
-        {
-            SCIP_CALL( SCIPincludeConshdlrLinear(scip) ); /* linear must be before its specializations due to constraint upgrading */
-            SCIP_CALL( SCIPincludeConshdlrIndicator(scip) );
-            SCIP_CALL( SCIPincludeConshdlrIntegral(scip) );
-            SCIP_CALL( SCIPincludeConshdlrKnapsack(scip) );
-            SCIP_CALL( SCIPincludeConshdlrSetppc(scip) );
-
-            SCIP_CALL( SCIPincludeNodeselBfs(scip) );
-            SCIP_CALL( SCIPincludeNodeselBreadthfirst(scip) );
-            SCIP_CALL( SCIPincludeNodeselDfs(scip) );
-            SCIP_CALL( SCIPincludeNodeselEstimate(scip) );
-            SCIP_CALL( SCIPincludeNodeselHybridestim(scip) );
-            SCIP_CALL( SCIPincludeNodeselRestartdfs(scip) );
-            SCIP_CALL( SCIPincludeNodeselUct(scip) );
-
-            SCIP_CALL( SCIPincludeEventHdlrEstim(scip) );
-            SCIP_CALL( SCIPincludeEventHdlrSolvingphase(scip) );
-
-            SCIP_CALL( SCIPincludeHeurActconsdiving(scip) );
-            SCIP_CALL( SCIPincludeHeurAdaptivediving(scip) );
-            SCIP_CALL( SCIPincludeHeurBound(scip) );
-            SCIP_CALL( SCIPincludeHeurClique(scip) );
-            SCIP_CALL( SCIPincludeHeurCoefdiving(scip) );
-            SCIP_CALL( SCIPincludeHeurCompletesol(scip) );
-            SCIP_CALL( SCIPincludeHeurConflictdiving(scip) );
-            SCIP_CALL( SCIPincludeHeurCrossover(scip) );
-            SCIP_CALL( SCIPincludeHeurDins(scip) );
-            SCIP_CALL( SCIPincludeHeurDistributiondiving(scip) );
-            SCIP_CALL( SCIPincludeHeurDualval(scip) );
-            SCIP_CALL( SCIPincludeHeurFarkasdiving(scip) );
-            SCIP_CALL( SCIPincludeHeurFeaspump(scip) );
-            SCIP_CALL( SCIPincludeHeurFixandinfer(scip) );
-            SCIP_CALL( SCIPincludeHeurFracdiving(scip) );
-            SCIP_CALL( SCIPincludeHeurGins(scip) );
-            SCIP_CALL( SCIPincludeHeurGuideddiving(scip) );
-            SCIP_CALL( SCIPincludeHeurZeroobj(scip) );
-            SCIP_CALL( SCIPincludeHeurIndicator(scip) );
-            SCIP_CALL( SCIPincludeHeurIntdiving(scip) );
-            SCIP_CALL( SCIPincludeHeurIntshifting(scip) );
-            SCIP_CALL( SCIPincludeHeurLinesearchdiving(scip) );
-            SCIP_CALL( SCIPincludeHeurLocalbranching(scip) );
-            SCIP_CALL( SCIPincludeHeurLocks(scip) );
-            SCIP_CALL( SCIPincludeHeurLpface(scip) );
-            SCIP_CALL( SCIPincludeHeurAlns(scip) );
-            SCIP_CALL( SCIPincludeHeurNlpdiving(scip) );
-            SCIP_CALL( SCIPincludeHeurMutation(scip) );
-            SCIP_CALL( SCIPincludeHeurMultistart(scip) );
-            SCIP_CALL( SCIPincludeHeurMpec(scip) );
-            SCIP_CALL( SCIPincludeHeurObjpscostdiving(scip) );
-            SCIP_CALL( SCIPincludeHeurOctane(scip) );
-            SCIP_CALL( SCIPincludeHeurOfins(scip) );
-            SCIP_CALL( SCIPincludeHeurOneopt(scip) );
-            SCIP_CALL( SCIPincludeHeurPADM(scip) );
-            SCIP_CALL( SCIPincludeHeurProximity(scip) );
-            SCIP_CALL( SCIPincludeHeurPscostdiving(scip) );
-            SCIP_CALL( SCIPincludeHeurRandrounding(scip) );
-            SCIP_CALL( SCIPincludeHeurRens(scip) );
-            SCIP_CALL( SCIPincludeHeurReoptsols(scip) );
-            SCIP_CALL( SCIPincludeHeurRepair(scip) );
-            SCIP_CALL( SCIPincludeHeurRins(scip) );
-            SCIP_CALL( SCIPincludeHeurRootsoldiving(scip) );
-            SCIP_CALL( SCIPincludeHeurRounding(scip) );
-            SCIP_CALL( SCIPincludeHeurShiftandpropagate(scip) );
-            SCIP_CALL( SCIPincludeHeurShifting(scip) );
-            SCIP_CALL( SCIPincludeHeurSimplerounding(scip) );
-            SCIP_CALL( SCIPincludeHeurSubNlp(scip) );
-            SCIP_CALL( SCIPincludeHeurTrivial(scip) );
-            SCIP_CALL( SCIPincludeHeurTrivialnegation(scip) );
-            SCIP_CALL( SCIPincludeHeurTrustregion(scip) );
-            SCIP_CALL( SCIPincludeHeurTrySol(scip) );
-            SCIP_CALL( SCIPincludeHeurTwoopt(scip) );
-            SCIP_CALL( SCIPincludeHeurUndercover(scip) );
-            SCIP_CALL( SCIPincludeHeurVbounds(scip) );
-            SCIP_CALL( SCIPincludeHeurVeclendiving(scip) );
-            SCIP_CALL( SCIPincludeHeurZirounding(scip) );
-
-            SCIP_CALL( SCIPincludeDispDefault(scip) );
-            SCIP_CALL( SCIPincludeTableDefault(scip) );
-
-            SCIP_CALL( SCIPincludeConcurrentScipSolvers(scip) );
-        }
-        // SCIP_CALL(SCIPincludeDefaultPlugins(scip));
-
-        // Disable parallel solve.
-        SCIP_CALL(SCIPsetIntParam(scip, "parallel/maxnthreads", 1));
-        SCIP_CALL(SCIPsetIntParam(scip, "lp/threads", 1));
-
-        // Set parameters.
-        SCIP_CALL(SCIPsetIntParam(scip, "presolving/maxrounds", 0));
-        // SCIP_CALL(SCIPsetIntParam(scip, "propagating/rootredcost/freq", -1));
-        SCIP_CALL(SCIPsetIntParam(scip, "separating/maxaddrounds", -1));
-        SCIP_CALL(SCIPsetIntParam(scip, "separating/maxstallrounds", 5));
-        SCIP_CALL(SCIPsetIntParam(scip, "separating/maxstallroundsroot", 20));
-        SCIP_CALL(SCIPsetIntParam(scip, "separating/cutagelimit", -1));
-
-        // Turn off all separation algorithms.
-        SCIP_CALL(SCIPsetSeparating(scip, SCIP_PARAMSETTING_OFF, TRUE));
-
-        // Set node selection rule.
-        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/bfs/stdpriority", 0));
-        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/bfs/memsavepriority", 0));
-        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/breadthfirst/stdpriority", 0));
-        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/breadthfirst/memsavepriority", 0));
-        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/dfs/stdpriority", 0));
-        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/dfs/memsavepriority", 0));
-        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/estimate/stdpriority", 0));
-        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/estimate/memsavepriority", 0));
-        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/hybridestim/stdpriority", 0));
-        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/hybridestim/memsavepriority", 0));
-        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/restartdfs/stdpriority", 0));
-        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/restartdfs/memsavepriority", 0));
-        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/uct/stdpriority", 0));
-        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/uct/memsavepriority", 0));
-#ifdef USE_BEST_FIRST_NODE_SELECTION
-        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/bfs/stdpriority", 500000));
-        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/bfs/memsavepriority", 500000));
-#endif
-#ifdef USE_DEPTH_FIRST_NODE_SELECTION
-        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/dfs/stdpriority", 500000));
-        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/dfs/memsavepriority", 500000));
-#endif
-#ifdef USE_BEST_ESTIMATE_NODE_SELECTION
-        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/estimate/stdpriority", 500000));
-        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/estimate/memsavepriority", 500000));
-#endif
-#ifdef USE_HYBRID_ESTIMATE_BOUND_NODE_SELECTION
-        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/hybridestim/stdpriority", 500000));
-        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/hybridestim/memsavepriority", 500000));
-#endif
-#ifdef USE_RESTART_DEPTH_FIRST_NODE_SELECTION
-        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/restartdfs/stdpriority", 500000));
-        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/restartdfs/memsavepriority", 500000));
-#endif
-
-        // Turn on aggressive primal heuristics.
-        SCIP_CALL(SCIPsetHeuristics(scip, SCIP_PARAMSETTING_AGGRESSIVE, TRUE));
-
-        // Turn off some primal heuristics.
-        {
-            const auto nheurs = SCIPgetNHeurs(scip);
-            auto heurs = SCIPgetHeurs(scip);
-            for (Int idx = 0; idx < nheurs; ++idx)
-            {
-                auto heur = heurs[idx];
-                const String name(SCIPheurGetName(heur));
-                if (name == "alns" ||
-                    name == "bound" ||
-                    name == "coefdiving" ||
-                    name == "crossover" ||
-                    name == "dins" ||
-                    name == "fixandinfer" ||
-                    name == "gins" ||
-                    name == "guideddiving" ||
-                    name == "intdiving" ||
-                    name == "localbranching" ||
-                    name == "locks" ||
-                    name == "mutation" ||
-                    name == "oneopt" ||
-                    name == "rens" ||
-                    name == "repair" ||
-                    name == "rins" ||
-                    name == "trivial" ||
-                    name == "zeroobj" ||
-                    name == "zirounding" ||
-                    name == "proximity" || // Buggy
-                    name == "twoopt")      // Buggy
-                {
-                    SCIPheurSetFreq(heur, -1);
-                }
-            }
-        }
+    // Start tracing.
+    if (!trace_path.empty())
+    {
+        trace_start(trace_buffer_size);
     }
 
-    // Read instance.
-    release_assert(agent_limit > 0, "Cannot limit to {} number of agents", agent_limit);
-    SCIP_CALL(read_instance(scip, instance_file.c_str(), agent_limit));
-
-    // Set time limit.
-    if (time_limit > 0)
+    // Solve.
+    bool solved = false;
+    if (!server_path.empty())
     {
-        SCIP_CALL(SCIPsetRealParam(scip, "limits/time", time_limit));
+        SCIP_CALL(run_server(options, server_path, server_threads));
+        solved = true;
     }
-
-    // Set node limit.
-    if (node_limit > 0)
+    else if (batch_path.empty() && !options.replan_file.empty())
     {
-        SCIP_CALL(SCIPsetLongintParam(scip, "limits/nodes", node_limit));
+        SCIP_CALL(solve_lifelong(options, instance_file, solved));
     }
-
-    // Set optimality gap limit.
-    if (gap_limit > 0)
+    else if (batch_path.empty() && options.window > 0)
     {
-        SCIP_CALL(SCIPsetRealParam(scip, "limits/gap", gap_limit));
+        SCIP_CALL(solve_rolling_horizon(options, instance_file, solved));
     }
-
-    // Solve.
-    SCIP_CALL(SCIPsolve(scip));
-    
-    bool solved = scip->set->stage == 10;
-    // Output.
+    else if (batch_path.empty() && options.independence_threads > 0)
     {
-        // Print.
-        // println("");
-        // SCIP_CALL(SCIPprintStatistics(scip, NULL));
-
-        double solvingtime = SCIPclockGetTime(scip->stat->solvingtime);
-        int solvingnodes = scip->stat->nnodes;
-        double upper_bound = SCIPgetPrimalbound(scip);
-        double lower_bound = SCIPgetDualbound(scip);
-        
-        std::ifstream infile(output_file);
-        bool exist = infile.good();
-        infile.close();
-        if (!exist)
-        {
-            std::ofstream addHeads(output_file);
-            addHeads << "runtime,solution cost,lower bound,upper bound," <<
-                    "nodes," << "instance name, #agents" << std::endl;
-            addHeads.close();
-        }
-        std::ofstream stats(output_file, std::ios::app);
-        stats <<solvingtime <<"," << (solved?upper_bound:-1) << "," << lower_bound <<"," <<upper_bound <<","<< instance_file <<","<<agent_limit  <<std::endl;
-        stats.close();
-        // Write best solution to file.
-        SCIP_CALL(write_path(scip, path_file));
+        SCIP_CALL(solve_independent_groups(options, instance_file, solved));
+    }
+    else if (batch_path.empty() && options.racing_threads > 0)
+    {
+        SCIP_CALL(solve_racing(options, instance_file, solved));
+    }
+    else if (batch_path.empty() && options.agent_step > 0)
+    {
+        SCIP_CALL(solve_agent_sweep(options, instance_file, solved));
+    }
+    else if (batch_path.empty())
+    {
+        SCIP_CALL(solve_instance(options, instance_file, nullptr, solved));
+    }
+    else
+    {
+        release_assert(batch_threads > 0, "Cannot solve a batch with {} threads", batch_threads);
+        const auto scenarios = read_batch(batch_path);
+        Int nb_solved = 0;
+        SCIP_CALL(solve_batch(options, scenarios, batch_threads, nb_solved));
+        println("Solved {} of {} instances", nb_solved, scenarios.size());
+        solved = nb_solved == static_cast<Int>(scenarios.size());
     }
 
-    // Free memory.
-    SCIP_CALL(SCIPfree(&scip));
+    // Write the trace.
+    if (!trace_path.empty())
+    {
+        trace_write(trace_path);
+        println("Wrote trace to {}", trace_path);
+    }
 
     // Check if memory is leaked.
     BMScheckEmptyMemory();
@@ -0,0 +1,267 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+
+#include "MemoryUsage.h"
+#include "ProblemData.h"
+#include "Pricer_TruffleHog.h"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <mutex>
+
+#define EVENTHDLR_NAME "mapf_memory"
+#define EVENTHDLR_DESC "Sampling of the memory used by the largest data structures"
+
+#define DEFAULT_MEMORY_USAGE_INTERVAL 10.0    // Seconds between samples of the memory usage (0 to disable)
+
+struct MemoryUsageData
+{
+    std::chrono::steady_clock::time_point last_sample;    // Time of the last sample
+    MemoryUsage peak;                                     // Largest memory of every component over the samples
+    uint64_t nb_reports;                                  // Number of reports requested by signal when last checked
+};
+
+// Number of reports requested by SIGUSR1. Every solver prints a report when it sees the count change.
+static std::atomic<uint64_t> nb_requested_reports{0};
+static_assert(std::atomic<uint64_t>::is_always_lock_free);
+
+// Request a report of the memory usage
+static void request_memory_usage_report(int)
+{
+    nb_requested_reports.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Measure the memory used by the solver now
+MemoryUsage get_memory_usage(
+    SCIP* scip    // SCIP
+)
+{
+    MemoryUsage usage{};
+    if (auto probdata = SCIPgetProbData(scip))
+    {
+        SCIPprobdataGetMemoryUsage(probdata, usage);
+    }
+    SCIPpricerTruffleHogGetMemoryUsage(scip, usage);
+    return usage;
+}
+
+// Update the largest memory of every component with a sample and get it
+static MemoryUsage update_peak_memory_usage(
+    SCIP* scip,                  // SCIP
+    const MemoryUsage& usage     // Sample
+)
+{
+    auto peak = usage;
+    if (auto eventhdlr = SCIPfindEventhdlr(scip, EVENTHDLR_NAME))
+    {
+        auto eventhdlrdata = reinterpret_cast<MemoryUsageData*>(SCIPeventhdlrGetData(eventhdlr));
+        debug_assert(eventhdlrdata);
+        eventhdlrdata->peak.update_peak(usage);
+        peak = eventhdlrdata->peak;
+    }
+    return peak;
+}
+
+// Get the largest memory of every component over the samples
+MemoryUsage get_peak_memory_usage(
+    SCIP* scip    // SCIP
+)
+{
+    return update_peak_memory_usage(scip, get_memory_usage(scip));
+}
+
+// Print the current and the peak memory of every component
+void print_memory_usage(
+    SCIP* scip    // SCIP
+)
+{
+    const auto current = get_memory_usage(scip);
+    const auto peak = update_peak_memory_usage(scip, current);
+    Vector<size_t> peak_values;
+    peak.for_each([&](const char*, const size_t nb_bytes) { peak_values.push_back(nb_bytes); });
+
+    // Format the report in one string so that reports of several solvers are not interleaved.
+    String report = fmt::format("Memory usage of {} after {:.1f} seconds:\n"
+                                "    {:<20} {:>12} {:>12}\n",
+                                SCIPgetProbName(scip),
+                                SCIPgetSolvingTime(scip),
+                                "Component",
+                                "Now (MB)",
+                                "Peak (MB)");
+    size_t idx = 0;
+    size_t total = 0;
+    current.for_each([&](const char* name, const size_t nb_bytes)
+    {
+        report += fmt::format("    {:<20} {:>12.1f} {:>12.1f}\n", name, nb_bytes / 1e6, peak_values[idx] / 1e6);
+        total += nb_bytes;
+        ++idx;
+    });
+    report += fmt::format("    {:<20} {:>12.1f}\n", "Total", total / 1e6);
+    fmt::print("{}", report);
+    std::fflush(stdout);
+}
+
+// Initialize event handler at the start of the solve
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_EVENTINITSOL(eventInitsolMemoryUsage)
+{
+    // Get event handler data.
+    auto eventhdlrdata = reinterpret_cast<MemoryUsageData*>(SCIPeventhdlrGetData(eventhdlr));
+    debug_assert(eventhdlrdata);
+    eventhdlrdata->last_sample = std::chrono::steady_clock::now();
+    eventhdlrdata->peak = MemoryUsage{};
+    eventhdlrdata->nb_reports = nb_requested_reports.load(std::memory_order_relaxed);
+
+    // Catch the end of every node and LP solve if the memory is sampled.
+    SCIP_Real interval;
+    SCIP_CALL(SCIPgetRealParam(scip, MEMORY_USAGE_INTERVAL_PARAM, &interval));
+    if (interval > 0.0)
+    {
+        SCIP_CALL(SCIPcatchEvent(scip, SCIP_EVENTTYPE_NODESOLVED | SCIP_EVENTTYPE_LPSOLVED, eventhdlr, nullptr,
+                                 nullptr));
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Deinitialize event handler at the end of the solve
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_EVENTEXITSOL(eventExitsolMemoryUsage)
+{
+    SCIP_Real interval;
+    SCIP_CALL(SCIPgetRealParam(scip, MEMORY_USAGE_INTERVAL_PARAM, &interval));
+    if (interval > 0.0)
+    {
+        SCIP_CALL(SCIPdropEvent(scip, SCIP_EVENTTYPE_NODESOLVED | SCIP_EVENTTYPE_LPSOLVED, eventhdlr, nullptr, -1));
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Sample the memory if the interval has passed and print a report if requested
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_EVENTEXEC(eventExecMemoryUsage)
+{
+    // Get event handler data.
+    auto eventhdlrdata = reinterpret_cast<MemoryUsageData*>(SCIPeventhdlrGetData(eventhdlr));
+    debug_assert(eventhdlrdata);
+
+    // Print a report if requested by signal.
+    if (const auto nb_reports = nb_requested_reports.load(std::memory_order_relaxed);
+        nb_reports != eventhdlrdata->nb_reports)
+    {
+        eventhdlrdata->nb_reports = nb_reports;
+        print_memory_usage(scip);
+        eventhdlrdata->last_sample = std::chrono::steady_clock::now();
+        return SCIP_OKAY;
+    }
+
+    // Check the interval.
+    SCIP_Real interval;
+    SCIP_CALL(SCIPgetRealParam(scip, MEMORY_USAGE_INTERVAL_PARAM, &interval));
+    const auto now = std::chrono::steady_clock::now();
+    if (std::chrono::duration<SCIP_Real>(now - eventhdlrdata->last_sample).count() < interval)
+    {
+        return SCIP_OKAY;
+    }
+
+    // Sample.
+    update_peak_memory_usage(scip, get_memory_usage(scip));
+    eventhdlrdata->last_sample = std::chrono::steady_clock::now();
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Free event handler
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_EVENTFREE(eventFreeMemoryUsage)
+{
+    auto eventhdlrdata = reinterpret_cast<MemoryUsageData*>(SCIPeventhdlrGetData(eventhdlr));
+    debug_assert(eventhdlrdata);
+    eventhdlrdata->~MemoryUsageData();
+    SCIPfreeBlockMemory(scip, &eventhdlrdata);
+    SCIPeventhdlrSetData(eventhdlr, nullptr);
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Include the memory usage event handler
+SCIP_RETCODE SCIPincludeEventhdlrMemoryUsage(
+    SCIP* scip    // SCIP
+)
+{
+    // Create event handler data.
+    MemoryUsageData* eventhdlrdata = nullptr;
+    SCIP_CALL(SCIPallocBlockMemory(scip, &eventhdlrdata));
+    debug_assert(eventhdlrdata);
+    new (eventhdlrdata) MemoryUsageData{};
+
+    // Include event handler.
+    SCIP_EVENTHDLR* eventhdlr = nullptr;
+    SCIP_CALL(SCIPincludeEventhdlrBasic(scip,
+                                        &eventhdlr,
+                                        EVENTHDLR_NAME,
+                                        EVENTHDLR_DESC,
+                                        eventExecMemoryUsage,
+                                        reinterpret_cast<SCIP_EVENTHDLRDATA*>(eventhdlrdata)));
+    debug_assert(eventhdlr);
+
+    // Set callbacks.
+    SCIP_CALL(SCIPsetEventhdlrInitsol(scip, eventhdlr, eventInitsolMemoryUsage));
+    SCIP_CALL(SCIPsetEventhdlrExitsol(scip, eventhdlr, eventExitsolMemoryUsage));
+    SCIP_CALL(SCIPsetEventhdlrFree(scip, eventhdlr, eventFreeMemoryUsage));
+
+    // Add parameters.
+    SCIP_CALL(SCIPaddRealParam(scip,
+                               MEMORY_USAGE_INTERVAL_PARAM,
+                               "number of seconds between samples of the memory usage (0: disable the sampling and "
+                               "the report on SIGUSR1)",
+                               nullptr,
+                               FALSE,
+                               DEFAULT_MEMORY_USAGE_INTERVAL,
+                               0.0,
+                               SCIP_REAL_MAX,
+                               nullptr,
+                               nullptr));
+
+    // Print a report on SIGUSR1. The handler only counts the requests and the report is printed by the solver at the
+    // next node or LP solve.
+    static std::once_flag install_signal_handler;
+    std::call_once(install_signal_handler, []() { std::signal(SIGUSR1, request_memory_usage_report); });
+
+    // Done.
+    return SCIP_OKAY;
+}
@@ -0,0 +1,86 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+
+#ifndef MAPF_MEMORYUSAGE_H
+#define MAPF_MEMORYUSAGE_H
+
+#include "Includes.h"
+
+#define MEMORY_USAGE_INTERVAL_PARAM "mapf/memory/interval"
+
+// Memory in bytes used by the largest data structures of the solver. Hash tables are counted by their elements so
+// the empty slots are not included.
+struct MemoryUsage
+{
+    size_t label_pools;           // Blocks of the label pools of the low-level solvers
+    size_t heuristics;            // Lower bounds of the low-level solvers
+    size_t previous_data;         // Inputs to the previous run of each agent kept by the pricer
+    size_t columns;               // Variable data of the columns
+    size_t robust_cuts;           // Edge-times of the two-agent robust cuts
+    size_t fractional_edges;      // Tables of the fractionally used vertices and edges
+    size_t reservation_tables;    // Reservation tables of the low-level solvers
+
+    // Apply a function to the name and the value of every component
+    template<class F>
+    void for_each(F&& f) const
+    {
+        f("label pools", label_pools);
+        f("heuristics", heuristics);
+        f("previous data", previous_data);
+        f("columns", columns);
+        f("robust cuts", robust_cuts);
+        f("fractional edges", fractional_edges);
+        f("reservation tables", reservation_tables);
+    }
+
+    // Take the larger value of every component
+    void update_peak(const MemoryUsage& other)
+    {
+        label_pools = std::max(label_pools, other.label_pools);
+        heuristics = std::max(heuristics, other.heuristics);
+        previous_data = std::max(previous_data, other.previous_data);
+        columns = std::max(columns, other.columns);
+        robust_cuts = std::max(robust_cuts, other.robust_cuts);
+        fractional_edges = std::max(fractional_edges, other.fractional_edges);
+        reservation_tables = std::max(reservation_tables, other.reservation_tables);
+    }
+};
+
+// Include the event handler that periodically samples the memory usage and prints a report on SIGUSR1
+SCIP_RETCODE SCIPincludeEventhdlrMemoryUsage(
+    SCIP* scip    // SCIP
+);
+
+// Measure the memory used by the solver now
+MemoryUsage get_memory_usage(
+    SCIP* scip    // SCIP
+);
+
+// Get the largest memory of every component over the samples, including a sample taken now
+MemoryUsage get_peak_memory_usage(
+    SCIP* scip    // SCIP
+);
+
+// Print the current and the peak memory of every component
+void print_memory_usage(
+    SCIP* scip    // SCIP
+);
+
+#endif
@@ -0,0 +1,300 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+
+#include "NodeLog.h"
+#include "ProblemData.h"
+#include <chrono>
+#include <cstdio>
+
+#define EVENTHDLR_NAME "mapf_node_log"
+#define EVENTHDLR_DESC "Log of the nodes of the search tree"
+
+#define DEFAULT_NODE_LOG_FILE ""    // File to append a line for every solved node to (empty to disable)
+
+struct NodeLogData
+{
+    FILE* f;                                         // Output file
+    std::chrono::steady_clock::time_point start;     // Time when the current node is focused
+    SCIP_Real first_lp_obj;                          // LP objective before the first round of pricing at the node
+    Int nb_pricing_rounds;                           // Number of rounds of pricing at the node
+    int nb_vars;                                     // Number of columns when the node is focused
+    SCIP_Longint nb_cuts;                            // Number of cuts applied when the node is focused
+    bool has_decision;                               // Indicates if the node is branched on
+    const char* decision_type;                       // Type of the decision (vertex, wait or length)
+    AgentNodeTime decision;                          // Branching decision made at the node
+};
+
+// Get the event handler data if the log is written
+static NodeLogData* get_node_log_data(
+    SCIP* scip    // SCIP
+)
+{
+    auto eventhdlr = SCIPfindEventhdlr(scip, EVENTHDLR_NAME);
+    if (!eventhdlr)
+    {
+        return nullptr;
+    }
+    auto eventhdlrdata = reinterpret_cast<NodeLogData*>(SCIPeventhdlrGetData(eventhdlr));
+    debug_assert(eventhdlrdata);
+    return eventhdlrdata->f ? eventhdlrdata : nullptr;
+}
+
+// Count a round of pricing at the current node
+void node_log_add_pricing_round(
+    SCIP* scip,              // SCIP
+    const bool is_farkas     // Indicates if the round prices an infeasible master problem
+)
+{
+    if (auto eventhdlrdata = get_node_log_data(scip))
+    {
+        if (!is_farkas && eventhdlrdata->first_lp_obj == SCIP_INVALID)
+        {
+            eventhdlrdata->first_lp_obj = SCIPgetLPObjval(scip);
+        }
+        eventhdlrdata->nb_pricing_rounds++;
+    }
+}
+
+// Store the branching decision made at the current node
+void node_log_set_branching(
+    SCIP* scip,              // SCIP
+    const char* type,        // Type of the decision (vertex, wait or length)
+    const AgentNodeTime ant  // Branching decision
+)
+{
+    if (auto eventhdlrdata = get_node_log_data(scip))
+    {
+        eventhdlrdata->has_decision = true;
+        eventhdlrdata->decision_type = type;
+        eventhdlrdata->decision = ant;
+    }
+}
+
+// Format a real number in CSV, which is empty if unknown or infinite
+static String format_csv_real(
+    SCIP* scip,              // SCIP
+    const SCIP_Real value    // Value
+)
+{
+    return value == SCIP_INVALID || SCIPisInfinity(scip, REALABS(value)) ? String() : fmt::format("{:.6f}", value);
+}
+
+// Start measuring a node when it is focused
+static void start_node(
+    SCIP* scip,                   // SCIP
+    NodeLogData& eventhdlrdata    // Event handler data
+)
+{
+    eventhdlrdata.start = std::chrono::steady_clock::now();
+    eventhdlrdata.first_lp_obj = SCIP_INVALID;
+    eventhdlrdata.nb_pricing_rounds = 0;
+    eventhdlrdata.nb_vars = SCIPgetNVars(scip);
+    eventhdlrdata.nb_cuts = SCIPgetNCutsApplied(scip);
+    eventhdlrdata.has_decision = false;
+}
+
+// Write the line of a solved node
+static void write_node_line(
+    SCIP* scip,                          // SCIP
+    const NodeLogData& eventhdlrdata,    // Event handler data
+    SCIP_NODE* node,                     // Node
+    const SCIP_EVENTTYPE type            // Event of the solved node
+)
+{
+    // Get the node.
+    auto parent = SCIPnodeGetParent(node);
+    const auto result = type == SCIP_EVENTTYPE_NODEBRANCHED ? "branched" :
+                        type == SCIP_EVENTTYPE_NODEFEASIBLE ? "feasible" :
+                                                              "infeasible";
+    const auto lp_obj = SCIPgetLPSolstat(scip) == SCIP_LPSOLSTAT_OPTIMAL ? SCIPgetLPObjval(scip) : SCIP_INVALID;
+    const auto time = std::chrono::duration<SCIP_Real>(std::chrono::steady_clock::now() - eventhdlrdata.start).count();
+
+    // Format the branching decision.
+    String decision = ",,,,";
+    if (eventhdlrdata.has_decision)
+    {
+        const auto& map = SCIPprobdataGetMap(SCIPgetProbData(scip));
+        const auto [a, n, t] = eventhdlrdata.decision;
+        const auto [x, y] = map.get_xy(n);
+        decision = fmt::format("{},{},{},{},{}", eventhdlrdata.decision_type, a, x, y, t);
+    }
+
+    // Write.
+    fmt::print(eventhdlrdata.f,
+               "{},{},{},{},{},{},{},{},{},{},{},{:.6f}\n",
+               SCIPnodeGetNumber(node),
+               parent ? SCIPnodeGetNumber(parent) : -1,
+               SCIPnodeGetDepth(node),
+               result,
+               decision,
+               format_csv_real(scip, eventhdlrdata.first_lp_obj),
+               format_csv_real(scip, lp_obj),
+               format_csv_real(scip, SCIPnodeGetLowerbound(node)),
+               eventhdlrdata.nb_pricing_rounds,
+               SCIPgetNVars(scip) - eventhdlrdata.nb_vars,
+               SCIPgetNCutsApplied(scip) - eventhdlrdata.nb_cuts,
+               time);
+}
+
+// Open the log at the start of the solve
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_EVENTINITSOL(eventInitsolNodeLog)
+{
+    // Get event handler data.
+    auto eventhdlrdata = reinterpret_cast<NodeLogData*>(SCIPeventhdlrGetData(eventhdlr));
+    debug_assert(eventhdlrdata);
+    debug_assert(!eventhdlrdata->f);
+
+    // Open the file in append mode so that the nodes of earlier solves are kept, and write the header if it is new.
+    char* filename;
+    SCIP_CALL(SCIPgetStringParam(scip, NODE_LOG_FILE_PARAM, &filename));
+    if (filename[0] != '\0')
+    {
+        eventhdlrdata->f = fopen(filename, "a");
+        release_assert(eventhdlrdata->f, "Failed to open file {} to write the node log", filename);
+        if (ftell(eventhdlrdata->f) == 0)
+        {
+            fmt::print(eventhdlrdata->f,
+                       "node,parent,depth,result,branch,agent,x,y,t,lp before pricing,lp after pricing,lower bound,"
+                       "pricing rounds,columns,cuts,time\n");
+        }
+        start_node(scip, *eventhdlrdata);
+
+        // Catch the start and the end of every node.
+        SCIP_CALL(SCIPcatchEvent(scip, SCIP_EVENTTYPE_NODEFOCUSED | SCIP_EVENTTYPE_NODESOLVED, eventhdlr, nullptr,
+                                 nullptr));
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Close the log at the end of the solve
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_EVENTEXITSOL(eventExitsolNodeLog)
+{
+    // Get event handler data.
+    auto eventhdlrdata = reinterpret_cast<NodeLogData*>(SCIPeventhdlrGetData(eventhdlr));
+    debug_assert(eventhdlrdata);
+
+    // Close the file.
+    if (eventhdlrdata->f)
+    {
+        SCIP_CALL(SCIPdropEvent(scip, SCIP_EVENTTYPE_NODEFOCUSED | SCIP_EVENTTYPE_NODESOLVED, eventhdlr, nullptr, -1));
+        fclose(eventhdlrdata->f);
+        eventhdlrdata->f = nullptr;
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Start measuring a focused node or write the line of a solved node
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_EVENTEXEC(eventExecNodeLog)
+{
+    // Get event handler data.
+    auto eventhdlrdata = reinterpret_cast<NodeLogData*>(SCIPeventhdlrGetData(eventhdlr));
+    debug_assert(eventhdlrdata);
+    debug_assert(eventhdlrdata->f);
+
+    // Process the event.
+    const auto type = SCIPeventGetType(event);
+    if (type == SCIP_EVENTTYPE_NODEFOCUSED)
+    {
+        start_node(scip, *eventhdlrdata);
+    }
+    else
+    {
+        auto node = SCIPeventGetNode(event);
+        debug_assert(node);
+        write_node_line(scip, *eventhdlrdata, node, type);
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Free event handler
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_EVENTFREE(eventFreeNodeLog)
+{
+    auto eventhdlrdata = reinterpret_cast<NodeLogData*>(SCIPeventhdlrGetData(eventhdlr));
+    debug_assert(eventhdlrdata);
+    debug_assert(!eventhdlrdata->f);
+    eventhdlrdata->~NodeLogData();
+    SCIPfreeBlockMemory(scip, &eventhdlrdata);
+    SCIPeventhdlrSetData(eventhdlr, nullptr);
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Include the node log event handler
+SCIP_RETCODE SCIPincludeEventhdlrNodeLog(
+    SCIP* scip    // SCIP
+)
+{
+    // Create event handler data.
+    NodeLogData* eventhdlrdata = nullptr;
+    SCIP_CALL(SCIPallocBlockMemory(scip, &eventhdlrdata));
+    debug_assert(eventhdlrdata);
+    new (eventhdlrdata) NodeLogData{};
+
+    // Include event handler.
+    SCIP_EVENTHDLR* eventhdlr = nullptr;
+    SCIP_CALL(SCIPincludeEventhdlrBasic(scip,
+                                        &eventhdlr,
+                                        EVENTHDLR_NAME,
+                                        EVENTHDLR_DESC,
+                                        eventExecNodeLog,
+                                        reinterpret_cast<SCIP_EVENTHDLRDATA*>(eventhdlrdata)));
+    debug_assert(eventhdlr);
+
+    // Set callbacks.
+    SCIP_CALL(SCIPsetEventhdlrInitsol(scip, eventhdlr, eventInitsolNodeLog));
+    SCIP_CALL(SCIPsetEventhdlrExitsol(scip, eventhdlr, eventExitsolNodeLog));
+    SCIP_CALL(SCIPsetEventhdlrFree(scip, eventhdlr, eventFreeNodeLog));
+
+    // Add parameters.
+    SCIP_CALL(SCIPaddStringParam(scip,
+                                 NODE_LOG_FILE_PARAM,
+                                 "file to append a line of CSV to for every solved node (empty to disable)",
+                                 nullptr,
+                                 FALSE,
+                                 DEFAULT_NODE_LOG_FILE,
+                                 nullptr,
+                                 nullptr));
+
+    // Done.
+    return SCIP_OKAY;
+}
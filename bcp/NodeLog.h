@@ -0,0 +1,50 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+
+#ifndef MAPF_NODELOG_H
+#define MAPF_NODELOG_H
+
+#include "Includes.h"
+#include "Coordinates.h"
+
+#define NODE_LOG_FILE_PARAM "mapf/nodelog/file"
+
+// Include the event handler that writes one CSV line for every node of the search tree when the node is solved. A
+// line has the parent and the depth of the node, the branching decision made at the node, the LP objective before
+// the first and after the last round of pricing, the number of pricing rounds, the columns and the cuts added at the
+// node, and the time spent in the node.
+SCIP_RETCODE SCIPincludeEventhdlrNodeLog(
+    SCIP* scip    // SCIP
+);
+
+// Count a round of pricing at the current node
+void node_log_add_pricing_round(
+    SCIP* scip,              // SCIP
+    const bool is_farkas     // Indicates if the round prices an infeasible master problem
+);
+
+// Store the branching decision made at the current node
+void node_log_set_branching(
+    SCIP* scip,              // SCIP
+    const char* type,        // Type of the decision (vertex, wait or length)
+    const AgentNodeTime ant  // Branching decision
+);
+
+#endif
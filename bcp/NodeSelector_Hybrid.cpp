@@ -0,0 +1,185 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#include "NodeSelector_Hybrid.h"
+
+#define NODESEL_NAME            "mapf_hybrid"
+#define NODESEL_DESC            "Dive into the child agreeing with the LP until an incumbent is found, then best bound"
+#define NODESEL_STDPRIORITY     0
+#define NODESEL_MEMSAVEPRIORITY 0
+
+struct NodeselHybridData
+{
+    bool found_incumbent;    // Indicates if a non-artificial incumbent has been found
+};
+
+// Check if an incumbent without artificial variables exists
+static bool has_incumbent(
+    SCIP* scip    // SCIP
+)
+{
+    auto sol = SCIPgetBestSol(scip);
+    return sol && SCIPgetSolOrigObj(scip, sol) < ARTIFICIAL_VAR_COST;
+}
+
+// Reset the phase at the start of the solve
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_NODESELINITSOL(nodeselInitsolHybrid)
+{
+    // Get node selector data.
+    auto nodeseldata = reinterpret_cast<NodeselHybridData*>(SCIPnodeselGetData(nodesel));
+    debug_assert(nodeseldata);
+
+    // Start diving.
+    nodeseldata->found_incumbent = false;
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Free node selector data
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_NODESELFREE(nodeselFreeHybrid)
+{
+    // Get node selector data.
+    auto nodeseldata = reinterpret_cast<NodeselHybridData*>(SCIPnodeselGetData(nodesel));
+    debug_assert(nodeseldata);
+
+    // Free memory.
+    nodeseldata->~NodeselHybridData();
+    SCIPfreeBlockMemory(scip, &nodeseldata);
+    SCIPnodeselSetData(nodesel, nullptr);
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Select the next node
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_NODESELSELECT(nodeselSelectHybrid)
+{
+    // Get node selector data.
+    auto nodeseldata = reinterpret_cast<NodeselHybridData*>(SCIPnodeselGetData(nodesel));
+    debug_assert(nodeseldata);
+    debug_assert(selnode);
+
+    // Switch to best bound for the rest of the solve once an incumbent is found.
+    if (!nodeseldata->found_incumbent && has_incumbent(scip))
+    {
+        debugln("Switching to best-bound node selection at node {}", SCIPgetNNodes(scip));
+        nodeseldata->found_incumbent = true;
+    }
+
+    // Select the node.
+    if (!nodeseldata->found_incumbent)
+    {
+        // Dive into the child agreeing with the LP, which the branching rule gives the higher priority. Only the
+        // siblings along the dive stay open so the memory used by the tree stays small.
+        *selnode = SCIPgetPrioChild(scip);
+        if (!*selnode)
+        {
+            *selnode = SCIPgetPrioSibling(scip);
+        }
+        if (!*selnode)
+        {
+            *selnode = SCIPgetBestNode(scip);
+        }
+    }
+    else
+    {
+        *selnode = SCIPgetBestboundNode(scip);
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Order the open nodes by lower bound, then by estimate, then deepest first
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_NODESELCOMP(nodeselCompHybrid)
+{
+    const auto lb1 = SCIPnodeGetLowerbound(node1);
+    const auto lb2 = SCIPnodeGetLowerbound(node2);
+    if (SCIPisLT(scip, lb1, lb2))
+    {
+        return -1;
+    }
+    else if (SCIPisGT(scip, lb1, lb2))
+    {
+        return +1;
+    }
+
+    const auto estimate1 = SCIPnodeGetEstimate(node1);
+    const auto estimate2 = SCIPnodeGetEstimate(node2);
+    if (SCIPisLT(scip, estimate1, estimate2))
+    {
+        return -1;
+    }
+    else if (SCIPisGT(scip, estimate1, estimate2))
+    {
+        return +1;
+    }
+
+    return SCIPnodeGetDepth(node2) - SCIPnodeGetDepth(node1);
+}
+#pragma GCC diagnostic pop
+
+// Create node selector and include it in SCIP
+SCIP_RETCODE SCIPincludeNodeselHybrid(
+    SCIP* scip    // SCIP
+)
+{
+    // Create node selector data.
+    NodeselHybridData* nodeseldata = nullptr;
+    SCIP_CALL(SCIPallocBlockMemory(scip, &nodeseldata));
+    debug_assert(nodeseldata);
+    new(nodeseldata) NodeselHybridData;
+    nodeseldata->found_incumbent = false;
+
+    // Include node selector.
+    SCIP_NODESEL* nodesel = nullptr;
+    SCIP_CALL(SCIPincludeNodeselBasic(scip,
+                                      &nodesel,
+                                      NODESEL_NAME,
+                                      NODESEL_DESC,
+                                      NODESEL_STDPRIORITY,
+                                      NODESEL_MEMSAVEPRIORITY,
+                                      nodeselSelectHybrid,
+                                      nodeselCompHybrid,
+                                      reinterpret_cast<SCIP_NODESELDATA*>(nodeseldata)));
+    debug_assert(nodesel);
+
+    // Set callbacks.
+    SCIP_CALL(SCIPsetNodeselInitsol(scip, nodesel, nodeselInitsolHybrid));
+    SCIP_CALL(SCIPsetNodeselFree(scip, nodesel, nodeselFreeHybrid));
+
+    // Done.
+    return SCIP_OKAY;
+}
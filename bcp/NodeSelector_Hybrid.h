@@ -0,0 +1,31 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#ifndef MAPF_NODESELECTOR_HYBRID_H
+#define MAPF_NODESELECTOR_HYBRID_H
+
+#include "Includes.h"
+
+// Include the node selector that dives depth-first into the child agreeing with the LP solution until an incumbent
+// is found and then selects the node with the best lower bound
+SCIP_RETCODE SCIPincludeNodeselHybrid(
+    SCIP* scip    // SCIP
+);
+
+#endif
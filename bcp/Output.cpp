@@ -21,7 +21,14 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Includes.h"
 #include "ProblemData.h"
 #include "VariableData.h"
+#include "Pricer_TruffleHog.h"
+#include "MemoryUsage.h"
+#include "scip/clock.h"
 #include <sys/stat.h>
+#include <cmath>
+#include <sys/resource.h>
+
+#define BINARY_PATH_MAGIC (0x3148545046504342ULL)    // "BCPFPTH1"
 
 SCIP_RETCODE write_best_solution(
     SCIP* scip    // SCIP
@@ -237,4 +244,454 @@ SCIP_RETCODE write_path(
 
     // Done.
     return SCIP_OKAY;
-}
\ No newline at end of file
+}
+
+// Get the path of every agent in the best solution, or nothing if no solution without dummy variables is found
+Vector<Vector<Edge>> get_best_solution_paths(
+    SCIP* scip    // SCIP
+)
+{
+    // Check.
+    debug_assert(scip);
+
+    // Get problem data.
+    auto probdata = SCIPgetProbData(scip);
+    const auto N = SCIPprobdataGetN(probdata);
+    const auto& dummy_vars = SCIPprobdataGetDummyVars(probdata);
+    const auto& agent_vars = SCIPprobdataGetAgentVars(probdata);
+
+    // Get best solution.
+    Vector<Vector<Edge>> paths;
+    auto sol = SCIPgetBestSol(scip);
+    if (!sol || SCIPgetSolOrigObj(scip, sol) >= ARTIFICIAL_VAR_COST)
+    {
+        return paths;
+    }
+    for (Agent a = 0; a < N; ++a)
+        if (SCIPisPositive(scip, SCIPgetSolVal(scip, sol, dummy_vars[a])))
+        {
+            return paths;
+        }
+
+    // Get the paths.
+    paths.resize(N);
+    for (Agent a = 0; a < N; ++a)
+    {
+        for (const auto& [var, _] : agent_vars[a])
+            if (SCIPisPositive(scip, SCIPgetSolVal(scip, sol, var)))
+            {
+                auto vardata = SCIPvarGetData(var);
+                const auto path_length = SCIPvardataGetPathLength(vardata);
+                const auto path = SCIPvardataGetPath(vardata);
+                paths[a].assign(path, path + path_length);
+                break;
+            }
+        release_assert(!paths[a].empty(), "Agent {} has no path in the solution", a);
+    }
+    return paths;
+}
+
+// Header of the binary path format
+struct BinaryPathHeader
+{
+    uint64_t magic;       // BINARY_PATH_MAGIC
+    int32_t nb_agents;    // Number of agents, or zero if no solution is found
+    int32_t makespan;     // Length of the longest path
+};
+static_assert(sizeof(BinaryPathHeader) == 16);
+
+// Entry of an agent in the binary path format
+struct BinaryPathAgent
+{
+    uint64_t offset;        // Offset of the moves from the start of the file
+    int32_t path_length;    // Number of nodes in the path
+    int32_t start_x;        // Coordinates of the start
+    int32_t start_y;        // Coordinates of the start
+    int32_t reserved;       // Zero
+};
+static_assert(sizeof(BinaryPathAgent) == 24);
+
+SCIP_RETCODE write_path_binary(
+    SCIP* scip,                // SCIP
+    const String& filename     // Output file
+)
+{
+    // Check.
+    debug_assert(scip);
+
+    // Get problem data.
+    auto probdata = SCIPgetProbData(scip);
+    const auto N = SCIPprobdataGetN(probdata);
+
+    // Get variables.
+    const auto& dummy_vars = SCIPprobdataGetDummyVars(probdata);
+    const auto& agent_vars = SCIPprobdataGetAgentVars(probdata);
+
+    // Find the path of every agent in the best solution. Write no agents if there is no solution.
+    Vector<Pair<Time, const Edge*>> paths;
+    if (auto sol = SCIPgetBestSol(scip);
+        sol &&
+        SCIPgetSolOrigObj(scip, sol) < ARTIFICIAL_VAR_COST &&
+        std::none_of(dummy_vars.begin(), dummy_vars.end(),
+                     [&](SCIP_VAR* var) { return SCIPisPositive(scip, SCIPgetSolVal(scip, sol, var)); }))
+    {
+        paths.resize(N, {0, nullptr});
+        for (Agent a = 0; a < N; ++a)
+        {
+            for (const auto& [var, _] : agent_vars[a])
+            {
+                debug_assert(var);
+                if (SCIPisPositive(scip, SCIPgetSolVal(scip, sol, var)))
+                {
+                    auto vardata = SCIPvarGetData(var);
+                    paths[a] = {SCIPvardataGetPathLength(vardata), SCIPvardataGetPath(vardata)};
+                    break;
+                }
+            }
+            release_assert(paths[a].second, "Agent {} has no path in the solution", a);
+        }
+    }
+
+    // Make the header and the table of agents.
+    BinaryPathHeader header{BINARY_PATH_MAGIC, static_cast<int32_t>(paths.size()), 0};
+    Vector<BinaryPathAgent> agents(paths.size());
+    uint64_t offset = sizeof(BinaryPathHeader) + sizeof(BinaryPathAgent) * agents.size();
+    for (size_t a = 0; a < paths.size(); ++a)
+    {
+        const auto [path_length, path] = paths[a];
+        const auto [x, y] = get_output_xy(probdata, path[0].n);
+        agents[a] = BinaryPathAgent{offset, path_length, x, y, 0};
+        header.makespan = std::max(header.makespan, path_length);
+        offset += (3 * (path_length - 1) + 7) / 8;
+    }
+
+    // Open file.
+    auto f = fopen(filename.c_str(), "wb");
+    release_assert(f, "Failed to create file to write solution");
+
+    // Write the header and the table of agents.
+    release_assert(fwrite(&header, sizeof(BinaryPathHeader), 1, f) == 1, "Failed to write solution");
+    release_assert(fwrite(agents.data(), sizeof(BinaryPathAgent), agents.size(), f) == agents.size(),
+                   "Failed to write solution");
+
+    // Write the moves of every agent.
+    Vector<uint8_t> bytes;
+    for (const auto& [path_length, path] : paths)
+    {
+        bytes.assign((3 * (path_length - 1) + 7) / 8, 0);
+        for (Time t = 0; t < path_length - 1; ++t)
+        {
+            const auto d = static_cast<uint32_t>(path[t].d);
+            debug_assert(d < Direction::INVALID);
+            const auto bit = 3 * t;
+            bytes[bit / 8] |= d << (bit % 8);
+            if (bit % 8 > 5)
+            {
+                bytes[bit / 8 + 1] |= d >> (8 - bit % 8);
+            }
+        }
+        release_assert(fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size(), "Failed to write solution");
+    }
+
+    // Close file.
+    fclose(f);
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Write a row of pricing statistics
+static void write_pricing_statistics_row(
+    FILE* f,                                // Output file
+    const char* scope,                      // Agent or node
+    const SCIP_Longint id,                  // Agent or node number
+    const PricerStatistics& statistics      // Statistics
+)
+{
+    fmt::print(f,
+               "{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{:.6f},{:.6f},{:.6f},{},{}\n",
+               scope,
+               id,
+               statistics.nb_solves,
+               statistics.nb_cache_skips,
+               statistics.nb_pool_columns,
+               statistics.nb_symmetric_skips,
+               statistics.nb_bound_skips,
+               statistics.nb_truncated,
+               statistics.nb_exact_solves,
+               statistics.nb_focal_solves,
+               statistics.nb_labels_generated,
+               statistics.nb_labels_dominated,
+               statistics.nb_heap_pushes,
+               statistics.nb_heap_pops,
+               statistics.nb_penalty_lookups,
+               statistics.nb_tail_shortcuts,
+               statistics.nb_macro_waits,
+               statistics.nb_minimal_solves,
+               statistics.preprocess_seconds,
+               statistics.before_solve_seconds,
+               statistics.solve_seconds,
+               statistics.peak_label_bytes,
+               statistics.nb_lp_iterations);
+}
+
+SCIP_RETCODE write_pricing_statistics(
+    SCIP* scip,                // SCIP
+    const String& filename     // Output file
+)
+{
+    // Check.
+    debug_assert(scip);
+
+    // Get statistics.
+    const auto& agent_statistics = SCIPpricerTruffleHogGetAgentStatistics(scip);
+    const auto& node_statistics = SCIPpricerTruffleHogGetNodeStatistics(scip);
+
+    // Open file.
+    auto f = fopen(filename.c_str(), "w");
+    release_assert(f, "Failed to create file to write pricing statistics");
+
+    // Write header.
+    fmt::print(f,
+               "scope,id,solves,cache skips,pool columns,symmetric skips,bound skips,truncated solves,exact solves,"
+               "focal solves,labels generated,labels dominated,heap pushes,heap pops,penalty lookups,tail shortcuts,"
+               "macro waits,minimal solves,preprocess time,before solve time,solve time,peak label bytes,"
+               "lp iterations\n");
+
+    // Write statistics of each agent and the total.
+    PricerStatistics total{};
+    for (Agent a = 0; a < static_cast<Agent>(agent_statistics.size()); ++a)
+    {
+        write_pricing_statistics_row(f, "agent", a, agent_statistics[a]);
+        total += agent_statistics[a];
+    }
+    write_pricing_statistics_row(f, "total", -1, total);
+
+    // Write statistics of each node.
+    for (const auto& [node_number, statistics] : node_statistics)
+    {
+        write_pricing_statistics_row(f, "node", node_number, statistics);
+    }
+
+    // Close file.
+    fclose(f);
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+SCIP_RETCODE write_plugin_statistics(
+    SCIP* scip,                // SCIP
+    const String& filename     // Output file
+)
+{
+    // Check.
+    debug_assert(scip);
+
+    // Open file.
+    auto f = fopen(filename.c_str(), "w");
+    release_assert(f, "Failed to create file to write plugin statistics");
+
+    // Write the summary of the solve. The bounds and the root gap are null if they are infinite. The peak memory is
+    // of the whole process.
+    fmt::print(f, "{{\n");
+    {
+        const auto format_real = [scip](const SCIP_Real value)
+        {
+            return SCIPisInfinity(scip, std::abs(value)) ? String("null") : fmt::format("{:.6f}", value);
+        };
+        const auto upper_bound = SCIPgetPrimalbound(scip) < ARTIFICIAL_VAR_COST ? SCIPgetPrimalbound(scip) :
+                                                                                   SCIPinfinity(scip);
+        const auto root_lower_bound = SCIPgetDualboundRoot(scip);
+        const auto root_gap = SCIPisInfinity(scip, std::abs(upper_bound)) ||
+                              SCIPisInfinity(scip, std::abs(root_lower_bound)) ||
+                              SCIPisZero(scip, upper_bound) ?
+                              SCIPinfinity(scip) :
+                              (upper_bound - root_lower_bound) / std::abs(upper_bound);
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        fmt::print(f,
+                   "    \"summary\": {{\"solving time\": {:.6f}, \"nodes\": {}, \"columns\": {}, "
+                   "\"duplicate columns\": {}, \"cuts\": {}, "
+                   "\"root lower bound\": {}, \"lower bound\": {}, \"upper bound\": {}, \"root gap\": {}, "
+                   "\"peak memory (MB)\": {:.1f}}},\n",
+                   SCIPgetSolvingTime(scip),
+                   SCIPgetNTotalNodes(scip),
+                   SCIPgetNVars(scip),
+                   SCIPprobdataGetNDuplicateColumns(SCIPgetProbData(scip)),
+                   SCIPgetNCutsApplied(scip),
+                   format_real(root_lower_bound),
+                   format_real(SCIPgetDualbound(scip)),
+                   format_real(upper_bound),
+                   format_real(root_gap),
+                   usage.ru_maxrss / 1024.0);
+    }
+
+    // Write the current and the peak memory of the largest data structures.
+    {
+        const auto current = get_memory_usage(scip);
+        const auto peak = get_peak_memory_usage(scip);
+        Vector<size_t> peak_values;
+        peak.for_each([&](const char*, const size_t nb_bytes) { peak_values.push_back(nb_bytes); });
+        fmt::print(f, "    \"memory (MB)\": {{");
+        size_t idx = 0;
+        current.for_each([&](const char* name, const size_t nb_bytes)
+        {
+            fmt::print(f, "{}\"{}\": {{\"current\": {:.3f}, \"peak\": {:.3f}}}",
+                       idx == 0 ? "" : ", ", name, nb_bytes / 1e6, peak_values[idx] / 1e6);
+            ++idx;
+        });
+        fmt::print(f, "}},\n");
+    }
+
+    // Write the statistics of the plugins that are called. The times are measured by the clocks of SCIP.
+    const auto write_array = [f](const char* type, const Vector<String>& rows, const bool last)
+    {
+        fmt::print(f, "    \"{}\": [", type);
+        for (size_t idx = 0; idx < rows.size(); ++idx)
+        {
+            fmt::print(f, "{}\n        {}", idx == 0 ? "" : ",", rows[idx]);
+        }
+        fmt::print(f, "{}]{}\n", rows.empty() ? "" : "\n    ", last ? "" : ",");
+    };
+    Vector<String> rows;
+
+    // Write the LP solves by algorithm.
+    {
+        const auto write_lp = [&rows](const char* name, SCIP_CLOCK* clock, const SCIP_Longint nb_lps,
+                                      const SCIP_Longint nb_iterations)
+        {
+            if (nb_lps > 0)
+            {
+                rows.push_back(fmt::format("{{\"name\": \"{}\", \"time\": {:.6f}, \"calls\": {}, "
+                                           "\"iterations\": {}}}",
+                                           name,
+                                           SCIPclockGetTime(clock),
+                                           nb_lps,
+                                           nb_iterations));
+            }
+        };
+        write_lp("primal", scip->stat->primallptime, SCIPgetNPrimalLPs(scip), SCIPgetNPrimalLPIterations(scip));
+        write_lp("dual", scip->stat->duallptime, SCIPgetNDualLPs(scip), SCIPgetNDualLPIterations(scip));
+        write_lp("barrier", scip->stat->barrierlptime, SCIPgetNBarrierLPs(scip), SCIPgetNBarrierLPIterations(scip));
+        write_array("lp", rows, false);
+        rows.clear();
+    }
+
+    // Write pricers.
+    {
+        auto pricers = SCIPgetPricers(scip);
+        const auto nb_pricers = SCIPgetNPricers(scip);
+        for (Int idx = 0; idx < nb_pricers; ++idx)
+            if (auto pricer = pricers[idx]; SCIPpricerGetNCalls(pricer) > 0)
+            {
+                rows.push_back(fmt::format("{{\"name\": \"{}\", \"time\": {:.6f}, \"calls\": {}, \"columns\": {}}}",
+                                           SCIPpricerGetName(pricer),
+                                           SCIPpricerGetTime(pricer),
+                                           SCIPpricerGetNCalls(pricer),
+                                           SCIPpricerGetNVarsFound(pricer)));
+            }
+        write_array("pricers", rows, false);
+        rows.clear();
+    }
+
+    // Write separators.
+    {
+        auto sepas = SCIPgetSepas(scip);
+        const auto nb_sepas = SCIPgetNSepas(scip);
+        for (Int idx = 0; idx < nb_sepas; ++idx)
+            if (auto sepa = sepas[idx]; SCIPsepaGetNCalls(sepa) > 0)
+            {
+                rows.push_back(fmt::format("{{\"name\": \"{}\", \"time\": {:.6f}, \"calls\": {}, \"cuts\": {}}}",
+                                           SCIPsepaGetName(sepa),
+                                           SCIPsepaGetTime(sepa),
+                                           SCIPsepaGetNCalls(sepa),
+                                           SCIPsepaGetNCutsFound(sepa)));
+            }
+        write_array("separators", rows, false);
+        rows.clear();
+    }
+
+    // Write constraint handlers.
+    {
+        auto conshdlrs = SCIPgetConshdlrs(scip);
+        const auto nb_conshdlrs = SCIPgetNConshdlrs(scip);
+        for (Int idx = 0; idx < nb_conshdlrs; ++idx)
+        {
+            auto conshdlr = conshdlrs[idx];
+            const auto nb_calls = SCIPconshdlrGetNSepaCalls(conshdlr) +
+                                  SCIPconshdlrGetNEnfoLPCalls(conshdlr) +
+                                  SCIPconshdlrGetNEnfoPSCalls(conshdlr) +
+                                  SCIPconshdlrGetNCheckCalls(conshdlr) +
+                                  SCIPconshdlrGetNPropCalls(conshdlr);
+            if (nb_calls > 0)
+            {
+                const auto time = SCIPconshdlrGetSepaTime(conshdlr) +
+                                  SCIPconshdlrGetEnfoLPTime(conshdlr) +
+                                  SCIPconshdlrGetEnfoPSTime(conshdlr) +
+                                  SCIPconshdlrGetCheckTime(conshdlr) +
+                                  SCIPconshdlrGetPropTime(conshdlr);
+                rows.push_back(fmt::format("{{\"name\": \"{}\", \"time\": {:.6f}, \"calls\": {}, "
+                                           "\"separation time\": {:.6f}, \"separation calls\": {}, \"cuts\": {}, "
+                                           "\"enforcement time\": {:.6f}, \"enforcement calls\": {}, "
+                                           "\"check time\": {:.6f}, \"check calls\": {}}}",
+                                           SCIPconshdlrGetName(conshdlr),
+                                           time,
+                                           nb_calls,
+                                           SCIPconshdlrGetSepaTime(conshdlr),
+                                           SCIPconshdlrGetNSepaCalls(conshdlr),
+                                           SCIPconshdlrGetNCutsFound(conshdlr),
+                                           SCIPconshdlrGetEnfoLPTime(conshdlr),
+                                           SCIPconshdlrGetNEnfoLPCalls(conshdlr),
+                                           SCIPconshdlrGetCheckTime(conshdlr),
+                                           SCIPconshdlrGetNCheckCalls(conshdlr)));
+            }
+        }
+        write_array("constraint handlers", rows, false);
+        rows.clear();
+    }
+
+    // Write branching rules.
+    {
+        auto branchrules = SCIPgetBranchrules(scip);
+        const auto nb_branchrules = SCIPgetNBranchrules(scip);
+        for (Int idx = 0; idx < nb_branchrules; ++idx)
+            if (auto branchrule = branchrules[idx]; SCIPbranchruleGetNLPCalls(branchrule) > 0)
+            {
+                rows.push_back(fmt::format("{{\"name\": \"{}\", \"time\": {:.6f}, \"calls\": {}, "
+                                           "\"children\": {}}}",
+                                           SCIPbranchruleGetName(branchrule),
+                                           SCIPbranchruleGetTime(branchrule),
+                                           SCIPbranchruleGetNLPCalls(branchrule),
+                                           SCIPbranchruleGetNChildren(branchrule)));
+            }
+        write_array("branching rules", rows, false);
+        rows.clear();
+    }
+
+    // Write heuristics.
+    {
+        auto heurs = SCIPgetHeurs(scip);
+        const auto nb_heurs = SCIPgetNHeurs(scip);
+        for (Int idx = 0; idx < nb_heurs; ++idx)
+            if (auto heur = heurs[idx]; SCIPheurGetNCalls(heur) > 0)
+            {
+                rows.push_back(fmt::format("{{\"name\": \"{}\", \"time\": {:.6f}, \"calls\": {}, "
+                                           "\"solutions\": {}, \"best solutions\": {}}}",
+                                           SCIPheurGetName(heur),
+                                           SCIPheurGetTime(heur),
+                                           SCIPheurGetNCalls(heur),
+                                           SCIPheurGetNSolsFound(heur),
+                                           SCIPheurGetNBestSolsFound(heur)));
+            }
+        write_array("heuristics", rows, true);
+        rows.clear();
+    }
+    fmt::print(f, "}}\n");
+
+    // Close file.
+    fclose(f);
+
+    // Done.
+    return SCIP_OKAY;
+}
@@ -21,6 +21,7 @@ Author: Edward Lam <ed@ed-lam.com>
 #define MAPF_OUTPUT_H
 
 #include "Includes.h"
+#include "Coordinates.h"
 
 // Write best solution to file
 SCIP_RETCODE write_best_solution(
@@ -32,4 +33,29 @@ SCIP_RETCODE write_path(
     , String filename
 );
 
+// Get the path of every agent in the best solution, or nothing if no solution without dummy variables is found
+Vector<Vector<Edge>> get_best_solution_paths(
+    SCIP* scip    // SCIP
+);
+
+// Write the paths of the best solution to file in a binary format. The file starts with a header and a table with
+// the start and the offset of the moves of every agent so that a reader can seek to any agent. The moves of each
+// agent are packed as 3-bit directions, least significant bits first.
+SCIP_RETCODE write_path_binary(
+    SCIP* scip,                // SCIP
+    const String& filename     // Output file
+);
+
+// Write the statistics of the pricer for each agent and each node to file
+SCIP_RETCODE write_pricing_statistics(
+    SCIP* scip,                // SCIP
+    const String& filename     // Output file
+);
+
+// Write a summary of the solve and the running time, number of calls and output of each plugin to file in JSON
+SCIP_RETCODE write_plugin_statistics(
+    SCIP* scip,                // SCIP
+    const String& filename     // Output file
+);
+
 #endif
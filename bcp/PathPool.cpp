@@ -0,0 +1,87 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#include "PathPool.h"
+
+#define BLOCK_SIZE (4 * 1024 * 1024)
+
+PathPool::PathPool() :
+    blocks_(),
+    block_size_(0),
+    byte_idx_(0),
+    nb_bytes_allocated_(0),
+    free_(),
+    nb_bytes_free_(0),
+    mutex_()
+{
+    debug_assert(BLOCK_SIZE % 8 == 0);
+
+    blocks_.reserve(50);
+    allocate_block(BLOCK_SIZE);
+}
+
+void* PathPool::allocate(size_t size)
+{
+    // Round up to the next multiple of 8.
+    size = size % 8 ? size + (8 - size % 8) : size;
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Reuse the memory of a deleted column of the same size.
+    if (auto it = free_.find(size); it != free_.end() && !it->second.empty())
+    {
+        auto ptr = it->second.back();
+        it->second.pop_back();
+        nb_bytes_free_ -= size;
+        return ptr;
+    }
+
+    // Allocate a new block if there's no space in the current block. Columns longer than a block get their own block.
+    if (byte_idx_ + size > block_size_)
+    {
+        allocate_block(std::max<size_t>(size, BLOCK_SIZE));
+    }
+
+    // Find the memory to store the column.
+    debug_assert(byte_idx_ + size <= block_size_);
+    auto ptr = reinterpret_cast<void*>(&(blocks_.back()[byte_idx_]));
+    debug_assert(reinterpret_cast<uintptr_t>(ptr) % 8 == 0);
+    byte_idx_ += size;
+
+    // Done.
+    return ptr;
+}
+
+void PathPool::deallocate(void* ptr, size_t size)
+{
+    // Store the memory in the free list of its size.
+    debug_assert(ptr);
+    size = size % 8 ? size + (8 - size % 8) : size;
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_[size].push_back(ptr);
+    nb_bytes_free_ += size;
+}
+
+void PathPool::allocate_block(const size_t size)
+{
+    blocks_.push_back(std::make_unique<std::byte[]>(size));
+    debug_assert(blocks_.back());
+    block_size_ = size;
+    byte_idx_ = 0;
+    nb_bytes_allocated_ += size;
+}
@@ -0,0 +1,64 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#ifndef MAPF_PATHPOOL_H
+#define MAPF_PATHPOOL_H
+
+#include "Includes.h"
+#include <cstddef>
+#include <mutex>
+
+// Storage of the variable data of all columns in large contiguous blocks. The memory of a deleted column is kept in a
+// free list of its size and given to the next column of the same size, so the blocks only grow with the number of
+// columns alive at once. The blocks are released when the pool is destroyed. Columns can be freed from any thread.
+class PathPool
+{
+    Vector<UniquePtr<std::byte[]>> blocks_;
+    size_t block_size_;
+    size_t byte_idx_;
+    size_t nb_bytes_allocated_;
+    HashTable<size_t, Vector<void*>> free_;
+    size_t nb_bytes_free_;
+    std::mutex mutex_;
+
+  public:
+    // Constructors
+    PathPool();
+    PathPool(const PathPool&) = delete;
+    PathPool(PathPool&&) = delete;
+    PathPool& operator=(const PathPool&) = delete;
+    PathPool& operator=(PathPool&&) = delete;
+    ~PathPool() = default;
+
+    // Getters
+    inline size_t nb_bytes_allocated() const { return nb_bytes_allocated_; }
+    inline size_t nb_bytes_free() const { return nb_bytes_free_; }
+
+    // Get memory for a column
+    void* allocate(size_t size);
+
+    // Return the memory of a column for reuse
+    void deallocate(void* ptr, size_t size);
+
+  private:
+    // Allocate
+    void allocate_block(const size_t size);
+};
+
+#endif
@@ -20,6 +20,7 @@ Author: Edward Lam <ed@ed-lam.com>
 //#define PRINT_DEBUG
 
 #include "Pricer_TruffleHog.h"
+#include "BranchingRule.h"
 #include "Includes.h"
 #include "ProblemData.h"
 #include "VariableData.h"
@@ -27,13 +28,20 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "ConstraintHandler_VertexConflicts.h"
 #include "ConstraintHandler_EdgeConflicts.h"
 #include "Constraint_VertexBranching.h"
-//#include "Constraint_WaitBranching.h"
+#include "Constraint_WaitBranching.h"
 #include "Constraint_LengthBranching.h"
+#include "Constraint_ReducedCostFixing.h"
+#include "Trace.h"
+#include "NodeLog.h"
+#include "ThreadPlacement.h"
 #include <chrono>
 #include <numeric>
+#include <atomic>
+#include <thread>
 
 #include "trufflehog/Instance.h"
 #include "trufflehog/AStar.h"
+#include "trufflehog/PricingProblemLog.h"
 
 // Pricer properties
 #define PRICER_NAME     "trufflehog"
@@ -41,9 +49,37 @@ Author: Edward Lam <ed@ed-lam.com>
 #define PRICER_PRIORITY 0
 #define PRICER_DELAY    TRUE    // Only call pricer if all problem variables have non-negative reduced costs
 
+// Pricer parameters
+#define DEFAULT_THREADS 1       // Number of threads for pricing agents in parallel
+#define DEFAULT_COLUMNS 1       // Maximum number of columns to add for an agent in each round of pricing
+#define DEFAULT_RECORD_FILE ""  // File to record the pricing problems for offline replay (empty to disable)
+#define DEFAULT_SMOOTHING 0.0   // Weight of the stability center in the smoothed duals (0 to disable)
+#define DEFAULT_ADAPTIVE_BATCH FALSE    // Choose the number of agents to price from the LP and low-level solver times
+#define DEFAULT_LABEL_BLOCK_SIZE 10     // Size in MB of each block of memory for the labels of the low-level solver
+#define DEFAULT_HUGE_PAGES FALSE        // Back the labels of the low-level solver with transparent huge pages
+#define DEFAULT_PIN_THREADS FALSE       // Pin each pricing thread to a CPU so its memory stays on its NUMA node
+#define DEFAULT_NUMA_REPLICATE FALSE    // Copy the map and the global edge penalties to each NUMA node of the threads
+#define DEFAULT_HEURISTIC_THREADS 0     // Threads computing the heuristic of every goal at startup (0 for pricing)
+#define DEFAULT_FRONTIER_BUDGET 64      // Size in MB of the dense frontier of each low-level solver (0 to disable)
+#define DEFAULT_BACKWARD_PRUNING FALSE  // Prune labels that cannot reach the goal in time for constrained agents
+#define DEFAULT_PENALTY_HEURISTIC FALSE // Bound the unavoidable edge penalties in the heuristic for constrained agents
+#define DEFAULT_LABEL_BUDGET 0          // Labels expanded for an agent before pricing exactly (0 to disable)
+#define DEFAULT_FOCAL_WEIGHT 1.0        // Weight of the lower bound in the search before pricing exactly (1 to disable)
+#define DEFAULT_SYMMETRY FALSE          // Price interchangeable agents once and share their paths
+#define DEFAULT_REDUCED_COST_FIXING FALSE    // Forbid the node-times that cannot improve on the incumbent
+#ifdef USE_SIPP
+#define DEFAULT_LOW_LEVEL_SOLVER PricerLowLevelSolver::SIPP
+#else
+#define DEFAULT_LOW_LEVEL_SOLVER PricerLowLevelSolver::AStar
+#endif
+
+#define AUTO_SIPP_MIN_HORIZON (64)            // Use time-expanded A* on short time horizons in auto mode
+#define AUTO_SIPP_MAX_PENALTY_DENSITY (0.01)   // Use SIPP if fewer node-times than this fraction have penalties
+
 #define EPS (1e-6)
 #define STALLED_NB_ROUNDS (4)
 #define STALLED_ABSOLUTE_CHANGE (-1)
+#define BATCH_TIME_SMOOTHING (0.5)    // Weight of the previous rounds in the measured times for adaptive batches
 
 struct PricingOrder
 {
@@ -52,25 +88,114 @@ struct PricingOrder
     SCIP_VAR* new_var;
 };
 
+// Paths of an agent stored one after another so that the memory is reused when the agent is priced again
+struct PricingResult
+{
+    Vector<Edge> path_edges;       // Edges of the paths with negative reduced cost in order of increasing reduced cost
+    Vector<size_t> path_starts;    // Index of the first edge of each path
+    Vector<Cost> path_costs;       // Reduced cost of each path
+    PricerStatistics statistics;   // Statistics of the low-level solver
+
+    inline auto nb_paths() const { return path_costs.size(); }
+    inline const Edge* path(const size_t idx) const { return path_edges.data() + path_starts[idx]; }
+    inline Time path_length(const size_t idx) const
+    {
+        const auto end = idx + 1 < path_starts.size() ? path_starts[idx + 1] : path_edges.size();
+        return static_cast<Time>(end - path_starts[idx]);
+    }
+    inline void clear()
+    {
+        path_edges.clear();
+        path_starts.clear();
+        path_costs.clear();
+    }
+};
+
 // Pricer data
 struct SCIP_PricerData
 {
     SCIP_CONSHDLR* vertex_branching_conshdlr;           // Constraint handler for vertex branching
-//    SCIP_CONSHDLR* wait_branching_conshdlr;           // Constraint handler for wait branching
+    SCIP_CONSHDLR* wait_branching_conshdlr;             // Constraint handler for wait branching
     SCIP_CONSHDLR* length_branching_conshdlr;           // Constraint handler for length branching
+    SCIP_CONSHDLR* reduced_cost_fixing_conshdlr;        // Constraint handler for reduced cost fixing
     Agent N;                                            // Number of agents
+    Int nb_columns;                                     // Maximum number of columns to add for an agent
+    PricerLowLevelSolver low_level_solver;              // Low-level solver of the agents
+    SCIP_Real smoothing;                                // Weight of the stability center in the smoothed duals
 
     SCIP_Real* agent_part_dual;                         // Dual variable values of agent set partition constraints
     SCIP_Real* price_priority;                          // Pricing priority of each agent
     bool* agent_priced;                                 // Indicates if an agent is priced in the current round
     PricingOrder* order;                                // Order of agents to price
+    Vector<PricingResult> results;                      // Output of pricing each agent in the order
+
+    EdgePenalties global_edge_penalties;                // Edge penalties shared by all agents
+    Vector<SCIP_Real> row_duals;                        // Dual value of each row in the LP indexed by its LP position
+    Vector<Vector<NodeTime>> agent_forbidden_vertices;  // Vertices forbidden to an agent by its own branching decisions
+    Vector<Vector<NodeTime>> agent_waypoints;           // Vertices that an agent must use
+    Vector<Pair<Agent, NodeTime>> used_vertices;        // Vertices that an agent must use and the others cannot use
+    Vector<Vector<NodeTime>> agent_forbidden_waits;     // Vertices that an agent cannot wait at
+    Vector<Vector<NodeTime>> agent_required_waits;      // Vertices that an agent must wait at
+    Vector<Time> agent_earliest_goal_time;              // Earliest time for an agent to finish from length branching
+    Vector<Time> agent_latest_goal_time;                // Latest time for an agent to finish from length branching
+    Vector<Time> agent_min_finish_time;                 // Earliest time for an agent to finish at the current node
+    SCIP_Real sum_min_finish_time;                      // Sum of the earliest finish times at the current node
+    SCIP_Longint min_finish_time_node;                  // Node number of the earliest finish times
+    Vector<Time> incumbent_latest_goal_time;            // Latest time for an agent to finish in a better solution
+    Vector<Vector<Pair<Node, Time>>> agent_latest_visit_time;    // Latest times to visit nodes from reduced costs
+    Vector<Pair<Agent, NodeTime>> blocked_targets;      // Targets that other agents cannot cross at and after a time
+    Vector<Vector<Agent>> symmetric_classes;            // Agents with the same start and goal
+    Vector<Int> symmetric_result;                       // Order index of the result shared by an agent (-1 for none)
+    Vector<SCIP_Real> symmetric_dual;                   // Largest partition dual of the agents sharing a result
+    Vector<AStar*> astars;                              // Low-level solver of each thread
+    ThreadPlacement placement;                          // CPUs and NUMA nodes of the machine
+    bool pin_threads;                                   // Indicates if the pricing threads are pinned to CPUs
+    Vector<Int> thread_replica;                         // Index of the replica used by each thread (-1 for none)
+    Vector<Int> replica_thread;                         // Thread placed on the NUMA node of each replica
+    Vector<EdgePenalties> replica_edge_penalties;       // Copy of the global edge penalties on each NUMA node
+    Vector<Vector<Pair<Vector<NodeTime>, Cost>>> astar_outputs;    // Buffer for the paths found by each solver
+#ifdef USE_RESERVATION_TABLE
+    HashTable<int, Pair<Vector<Edge>, float>> reserved_paths;    // Paths and weights of the reserved columns by variable index
+    Vector<Vector<Edge>> round_reserved_paths;          // Paths found in the last round in the table of the first thread
+    Time reserved_makespan;                             // Length to which the reserved paths are extended
+#endif
+    Vector<UniquePtr<Map>> replica_maps;                // Copy of the map on each NUMA node of the threads
+    Vector<UniquePtr<AStar>> astar_pool;                // Low-level solvers owned by the pricer
+    UniquePtr<PricingProblemWriter> recorder;           // Log of the pricing problems
 
 #ifdef USE_ASTAR_SOLUTION_CACHING
-    Vector<AStar::Data> previous_data;                  // Inputs to the previous run for an agent
+    Vector<AStar::CachedData> previous_data;            // Inputs to the previous run for an agent
+    Vector<Cost> previous_cost;                         // Lower bound on the cost in the previous run for an agent
 #endif
-
+    Vector<AStar::WaypointCache> waypoint_caches;       // Preprocessed waypoints of each agent at the current node
+    SCIP_Longint waypoint_cache_node;                   // Node number of the preprocessed waypoints
+    Vector<AStar::Data> lookahead_data;                 // Inputs to the last run of each agent for look-ahead branching
+    Vector<Time> fixing_latest_goal_time;               // Latest goal time found by reduced cost fixing of each agent
+    Vector<Vector<Pair<Node, Time>>> fixing_latest_visit_time;   // Latest visit times found by reduced cost fixing
+    SCIP_Longint fixing_node;                           // Node number of the last reduced cost fixing
+    Vector<SCIP_Longint> lookahead_node;                // Node number of the last run of each agent
+
+    Vector<PricerStatistics> agent_statistics;          // Statistics of the low-level solver for each agent
+    Vector<Pair<SCIP_Longint, PricerStatistics>> node_statistics;    // Statistics of the low-level solver for each node
+    HashTable<SCIP_ROW*, SCIP_Real> row_duals_center;   // Dual values of the rows at the stability center
+    Vector<SCIP_Real> agent_part_dual_center;           // Dual values of the agent partition constraints at the center
+    SCIP_Longint center_node;                           // Node number of the stability center
+    bool mispriced;                                     // Indicates if repricing with the LP duals after a misprice
+    bool exact_pricing;                                 // Indicates if repricing without the label budget or weight
+    bool adaptive_batch;                                // Indicates if the number of agents to price is adaptive
+    bool backward_pruning;                              // Indicates if constrained agents prune labels backward
+    bool penalty_heuristic;                             // Indicates if constrained agents bound the penalties in h
+    bool reduced_cost_fixing;                           // Indicates if node-times are fixed by reduced cost
+    size_t label_budget;                                // Maximum number of labels expanded for an agent (0 for none)
+    Cost focal_weight;                                  // Weight of the lower bound in the search (1 for exact)
+    Agent batch_size;                                   // Minimum number of agents to price in a round
+    Float lp_time;                                      // Average time to re-solve the LP between two rounds
+    Float agent_time;                                   // Average time to price an agent
+    SCIP_Longint last_round_node;                       // Node number of the last round of pricing
+    std::chrono::steady_clock::time_point last_round_end;    // Time at the end of the last round of pricing
     SCIP_Longint last_solved_node;                      // Node number of the last node pricing
     SCIP_Real last_solved_lp_obj[STALLED_NB_ROUNDS];    // LP objective in the last few rounds of pricing
+    SCIP_Longint last_lp_iterations;                    // Simplex iterations of the master problem at the last round
 };
 
 // Initialize pricer (called after the problem was transformed)
@@ -92,18 +217,35 @@ SCIP_DECL_PRICERINIT(pricerTruffleHogInit)
     SCIP_CALL(SCIPallocBlockMemory(scip, &pricerdata));
     new (pricerdata) SCIP_PricerData;
     pricerdata->N = SCIPprobdataGetN(probdata);
+    pricerdata->center_node = -1;
+    pricerdata->mispriced = false;
+    pricerdata->exact_pricing = false;
+    pricerdata->batch_size = 1;
+    pricerdata->lp_time = -1;
+    pricerdata->agent_time = -1;
+    pricerdata->last_round_node = -1;
     pricerdata->last_solved_node = -1;
+    pricerdata->waypoint_cache_node = -1;
+    pricerdata->min_finish_time_node = -1;
+    pricerdata->fixing_node = -1;
+    pricerdata->last_lp_iterations = 0;
+#ifdef USE_RESERVATION_TABLE
+    pricerdata->reserved_makespan = -1;
+#endif
 
     // Find constraint handler for branching decisions.
     pricerdata->vertex_branching_conshdlr = SCIPfindConshdlr(scip, "vertex_branching");
     release_assert(pricerdata->vertex_branching_conshdlr,
                    "Constraint handler for vertex branching is missing");
-//    pricerdata->wait_branching_conshdlr = SCIPfindConshdlr(scip, "wait_branching");
-//    release_assert(pricerdata->wait_branching_conshdlr,
-//                   "Constraint handler for wait branching is missing");
+    pricerdata->wait_branching_conshdlr = SCIPfindConshdlr(scip, "wait_branching");
+    release_assert(pricerdata->wait_branching_conshdlr,
+                   "Constraint handler for wait branching is missing");
     pricerdata->length_branching_conshdlr = SCIPfindConshdlr(scip, "length_branching");
     release_assert(pricerdata->length_branching_conshdlr,
                    "Constraint handler for length branching rule is missing");
+    pricerdata->reduced_cost_fixing_conshdlr = SCIPfindConshdlr(scip, "reduced_cost_fixing");
+    release_assert(pricerdata->reduced_cost_fixing_conshdlr,
+                   "Constraint handler for reduced cost fixing is missing");
 
     // Create array for dual variable values of agent partition constraints.
     SCIP_CALL(SCIPallocBlockMemoryArray(scip, &pricerdata->agent_part_dual, pricerdata->N));
@@ -121,11 +263,320 @@ SCIP_DECL_PRICERINIT(pricerTruffleHogInit)
     SCIP_CALL(SCIPallocBlockMemoryArray(scip, &pricerdata->order, pricerdata->N));
     // Overwritten in each run. No need for initialisation.
 
+    // Get the maximum number of columns of each agent.
+    {
+        int nb_columns;
+        SCIP_CALL(SCIPgetIntParam(scip, "pricers/" PRICER_NAME "/columns", &nb_columns));
+        debug_assert(nb_columns >= 1);
+        pricerdata->nb_columns = nb_columns;
+    }
+
+    // Get the low-level solver.
+    {
+        int low_level_solver;
+        SCIP_CALL(SCIPgetIntParam(scip, "pricers/" PRICER_NAME "/lowlevel", &low_level_solver));
+        pricerdata->low_level_solver = static_cast<PricerLowLevelSolver>(low_level_solver);
+    }
+
+    // Get the weight of the stability center.
+    SCIP_CALL(SCIPgetRealParam(scip, "pricers/" PRICER_NAME "/smoothing", &pricerdata->smoothing));
+
+    // Check if the number of agents to price is adaptive.
+    {
+        SCIP_Bool adaptive_batch;
+        SCIP_CALL(SCIPgetBoolParam(scip, "pricers/" PRICER_NAME "/adaptivebatch", &adaptive_batch));
+        pricerdata->adaptive_batch = adaptive_batch;
+    }
+
+    // Check if labels of constrained agents are pruned by a backward pass from the goal.
+    {
+        SCIP_Bool backward_pruning;
+        SCIP_CALL(SCIPgetBoolParam(scip, "pricers/" PRICER_NAME "/backwardpruning", &backward_pruning));
+        pricerdata->backward_pruning = backward_pruning;
+    }
+
+    // Check if the heuristic of constrained agents includes a bound on the edge penalties.
+    {
+        SCIP_Bool penalty_heuristic;
+        SCIP_CALL(SCIPgetBoolParam(scip, "pricers/" PRICER_NAME "/penaltyheuristic", &penalty_heuristic));
+        pricerdata->penalty_heuristic = penalty_heuristic;
+    }
+
+    // Check if node-times are fixed by reduced cost.
+    {
+        SCIP_Bool reduced_cost_fixing;
+        SCIP_CALL(SCIPgetBoolParam(scip, "pricers/" PRICER_NAME "/redcostfixing", &reduced_cost_fixing));
+        pricerdata->reduced_cost_fixing = reduced_cost_fixing;
+    }
+
+    // Get the maximum number of labels expanded for an agent before falling back to exact pricing.
+    {
+        int label_budget;
+        SCIP_CALL(SCIPgetIntParam(scip, "pricers/" PRICER_NAME "/labelbudget", &label_budget));
+        debug_assert(label_budget >= 0);
+        pricerdata->label_budget = label_budget;
+    }
+
+    // Get the weight of the lower bound in the search before falling back to exact pricing.
+    {
+        SCIP_Real focal_weight;
+        SCIP_CALL(SCIPgetRealParam(scip, "pricers/" PRICER_NAME "/focalweight", &focal_weight));
+        debug_assert(focal_weight >= 1.0);
+        pricerdata->focal_weight = focal_weight;
+    }
+
+    // Group the interchangeable agents. Agents with the same start and goal have the same pricing problem unless
+    // they have branching decisions or cuts of their own.
+    {
+        SCIP_Bool symmetry;
+        SCIP_CALL(SCIPgetBoolParam(scip, "pricers/" PRICER_NAME "/symmetry", &symmetry));
+        if (symmetry)
+        {
+            const auto& agents = SCIPprobdataGetAgentsData(probdata);
+            Vector<Agent> sorted_agents(pricerdata->N);
+            std::iota(sorted_agents.begin(), sorted_agents.end(), 0);
+            std::stable_sort(sorted_agents.begin(), sorted_agents.end(), [&agents](const Agent a1, const Agent a2)
+            {
+                return std::tie(agents[a1].start, agents[a1].goal) < std::tie(agents[a2].start, agents[a2].goal);
+            });
+            for (Agent begin = 0, end = 0; begin < pricerdata->N; begin = end)
+            {
+                const auto a = sorted_agents[begin];
+                for (end = begin + 1; end < pricerdata->N; ++end)
+                {
+                    const auto a2 = sorted_agents[end];
+                    if (agents[a2].start != agents[a].start || agents[a2].goal != agents[a].goal)
+                    {
+                        break;
+                    }
+                }
+                if (end - begin >= 2)
+                {
+                    pricerdata->symmetric_classes.emplace_back(sorted_agents.begin() + begin,
+                                                               sorted_agents.begin() + end);
+                }
+            }
+        }
+        pricerdata->symmetric_result.resize(pricerdata->N, -1);
+        pricerdata->symmetric_dual.resize(pricerdata->N);
+    }
+
+    // Open the log of pricing problems.
+    {
+        char* record_file;
+        SCIP_CALL(SCIPgetStringParam(scip, "pricers/" PRICER_NAME "/recordfile", &record_file));
+        if (record_file && record_file[0] != '\0')
+        {
+            pricerdata->recorder = std::make_unique<PricingProblemWriter>(SCIPprobdataGetMap(probdata), record_file);
+        }
+    }
+
+    // Create space for the output of each agent.
+    pricerdata->results.resize(pricerdata->N);
+    pricerdata->agent_statistics.resize(pricerdata->N);
+    pricerdata->agent_part_dual_center.resize(pricerdata->N);
+    pricerdata->agent_forbidden_vertices.resize(pricerdata->N);
+    pricerdata->agent_waypoints.resize(pricerdata->N);
+    pricerdata->agent_forbidden_waits.resize(pricerdata->N);
+    pricerdata->agent_required_waits.resize(pricerdata->N);
+    pricerdata->agent_earliest_goal_time.resize(pricerdata->N);
+    pricerdata->agent_latest_goal_time.resize(pricerdata->N);
+    pricerdata->agent_min_finish_time.resize(pricerdata->N);
+    pricerdata->incumbent_latest_goal_time.resize(pricerdata->N);
+    pricerdata->agent_latest_visit_time.resize(pricerdata->N);
+    pricerdata->fixing_latest_goal_time.resize(pricerdata->N);
+    pricerdata->fixing_latest_visit_time.resize(pricerdata->N);
+    pricerdata->waypoint_caches.resize(pricerdata->N);
     // Create space to store the penalties from the previous failed iteration.
 #ifdef USE_ASTAR_SOLUTION_CACHING
     pricerdata->previous_data.resize(pricerdata->N);
+    pricerdata->previous_cost.resize(pricerdata->N, -std::numeric_limits<Cost>::infinity());
 #endif
 
+    // Create space to keep the inputs of each agent if the branching rule looks ahead with the low-level solver.
+    {
+        int lookahead;
+        SCIP_CALL(SCIPgetIntParam(scip, BRANCHING_LOOKAHEAD_PARAM, &lookahead));
+        if (lookahead > 0)
+        {
+            pricerdata->lookahead_data.resize(pricerdata->N);
+            pricerdata->lookahead_node.resize(pricerdata->N, -1);
+        }
+    }
+
+    // Create a low-level solver for each thread. The first thread uses the solver in the problem data. The solvers
+    // of the other threads are created in parallel because computing the heuristic of every goal is expensive.
+    {
+        int nb_threads;
+        SCIP_CALL(SCIPgetIntParam(scip, "pricers/" PRICER_NAME "/threads", &nb_threads));
+        debug_assert(nb_threads >= 1);
+
+        // Pin the threads to CPUs and copy the read-only data to the NUMA nodes of the threads other than the first.
+        // The copies are only local to the threads if they are pinned.
+        SCIP_Bool pin_threads;
+        SCIP_Bool numa_replicate;
+        SCIP_CALL(SCIPgetBoolParam(scip, "pricers/" PRICER_NAME "/pinthreads", &pin_threads));
+        SCIP_CALL(SCIPgetBoolParam(scip, "pricers/" PRICER_NAME "/numareplicate", &numa_replicate));
+        const auto& placement = pricerdata->placement;
+        pin_threads |= numa_replicate;
+        pricerdata->pin_threads = pin_threads;
+        pricerdata->thread_replica.assign(nb_threads, -1);
+        if (numa_replicate && placement.nb_nodes() > 1)
+        {
+            Vector<Int> node_replica(placement.nb_nodes(), -1);
+            for (Int thread_idx = 1; thread_idx < nb_threads; ++thread_idx)
+            {
+                const auto node = placement.thread_node(thread_idx);
+                if (node != placement.thread_node(0))
+                {
+                    if (node_replica[node] < 0)
+                    {
+                        node_replica[node] = static_cast<Int>(pricerdata->replica_thread.size());
+                        pricerdata->replica_thread.push_back(thread_idx);
+                    }
+                    pricerdata->thread_replica[thread_idx] = node_replica[node];
+                }
+            }
+        }
+
+        // Copy the map on a thread placed on the node of each replica so that its memory is local to the node.
+        {
+            const auto& map = SCIPprobdataGetMap(probdata);
+            pricerdata->replica_maps.resize(pricerdata->replica_thread.size());
+            pricerdata->replica_edge_penalties.resize(pricerdata->replica_thread.size());
+            Vector<std::thread> threads;
+            threads.reserve(pricerdata->replica_maps.size());
+            for (size_t replica = 0; replica < pricerdata->replica_maps.size(); ++replica)
+            {
+                threads.emplace_back([&placement, &map, &replica_map = pricerdata->replica_maps[replica],
+                                      thread_idx = pricerdata->replica_thread[replica]]()
+                {
+                    placement.pin(thread_idx);
+                    replica_map = std::make_unique<Map>(map);
+                });
+            }
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+        }
+
+        const auto& agents = SCIPprobdataGetAgentsData(probdata);
+        auto& first_astar = SCIPprobdataGetAStar(probdata);
+        const auto& heuristic_cache_dir = first_astar.heuristic_cache_directory();
+        const auto heuristic_shared_cache = first_astar.heuristic_shared_cache();
+        const auto heuristic_memory_budget = first_astar.heuristic_memory_budget();
+
+        // Compute the heuristic of every goal at once in parallel in the solver of the first thread instead of on
+        // demand. The solvers of the other threads copy it from a cache shared during the setup instead of searching
+        // again.
+        auto setup_shared_cache = heuristic_shared_cache;
+        {
+            int heuristic_threads;
+            SCIP_CALL(SCIPgetIntParam(scip, "pricers/" PRICER_NAME "/heuristicthreads", &heuristic_threads));
+            if (heuristic_threads >= 0)
+            {
+                if (heuristic_threads == 0)
+                {
+                    heuristic_threads = nb_threads;
+                }
+                if (!setup_shared_cache && nb_threads > 1)
+                {
+                    setup_shared_cache = std::make_shared<HeuristicCache>();
+                }
+
+                Vector<Node> goals(agents.size());
+                for (Agent a = 0; a < agents.size(); ++a)
+                {
+                    goals[a] = agents[a].goal;
+                }
+                first_astar.set_heuristic_shared_cache(setup_shared_cache);
+                first_astar.precompute_h(goals, heuristic_threads);
+                first_astar.set_heuristic_shared_cache(heuristic_shared_cache);
+            }
+        }
+
+        pricerdata->astar_pool.resize(nb_threads - 1);
+        Vector<std::thread> threads;
+        threads.reserve(pricerdata->astar_pool.size());
+        for (size_t pool_idx = 0; pool_idx < pricerdata->astar_pool.size(); ++pool_idx)
+        {
+            const auto thread_idx = static_cast<Int>(pool_idx) + 1;
+            const auto replica = pricerdata->thread_replica[thread_idx];
+            const auto& map = replica >= 0 ? *pricerdata->replica_maps[replica] : SCIPprobdataGetMap(probdata);
+            threads.emplace_back([&astar = pricerdata->astar_pool[pool_idx],
+                                  &map,
+                                  &agents,
+                                  &heuristic_cache_dir,
+                                  &heuristic_shared_cache,
+                                  &setup_shared_cache,
+                                  heuristic_memory_budget,
+                                  &placement,
+                                  pin_threads,
+                                  thread_idx]()
+            {
+                // The solver is created on the thread it is placed on so that its memory is local to the node.
+                if (pin_threads)
+                {
+                    placement.pin(thread_idx);
+                }
+                astar = std::make_unique<AStar>(map);
+                if (!heuristic_cache_dir.empty())
+                {
+                    astar->set_heuristic_cache_directory(heuristic_cache_dir);
+                }
+                astar->set_heuristic_memory_budget(heuristic_memory_budget);
+                astar->set_heuristic_shared_cache(setup_shared_cache);
+                for (Agent a = 0; a < agents.size(); ++a)
+                {
+                    astar->compute_h(agents[a].goal);
+                }
+                astar->set_heuristic_shared_cache(heuristic_shared_cache);
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        pricerdata->astars.push_back(&SCIPprobdataGetAStar(probdata));
+        for (const auto& astar : pricerdata->astar_pool)
+        {
+            pricerdata->astars.push_back(astar.get());
+        }
+        pricerdata->astar_outputs.resize(pricerdata->astars.size());
+    }
+
+    // Set up the memory for the labels of each low-level solver.
+    {
+        int label_block_size;
+        SCIP_Bool huge_pages;
+        SCIP_CALL(SCIPgetIntParam(scip, "pricers/" PRICER_NAME "/labelblocksize", &label_block_size));
+        SCIP_CALL(SCIPgetBoolParam(scip, "pricers/" PRICER_NAME "/hugepages", &huge_pages));
+        for (auto astar : pricerdata->astars)
+        {
+            astar->configure_label_pool(static_cast<size_t>(label_block_size) * 1024 * 1024, huge_pages);
+        }
+    }
+
+    // Set up the memory for the dense frontier of each low-level solver.
+    {
+        int frontier_budget;
+        SCIP_CALL(SCIPgetIntParam(scip, "pricers/" PRICER_NAME "/frontierbudget", &frontier_budget));
+        debug_assert(frontier_budget >= 0);
+        for (auto astar : pricerdata->astars)
+        {
+            astar->set_frontier_memory_budget(static_cast<size_t>(frontier_budget) * 1024 * 1024);
+        }
+    }
+
+    // Prune the labels of the low-level solvers whose paths cannot have negative reduced cost under the tolerance of
+    // SCIP, so a search stops as soon as every remaining label would only give a column that is discarded.
+    for (auto astar : pricerdata->astars)
+    {
+        astar->set_cost_threshold(-SCIPsumepsilon(scip));
+    }
+
     // Set pointer to pricer data.
     SCIPpricerSetData(pricer, pricerdata);
     SCIPprobdataSetPricerData(probdata, pricerdata);
@@ -167,6 +618,7 @@ enum class MasterProblemStatus
 };
 
 // Compute ordering of agents to price
+template<bool is_farkas>
 MasterProblemStatus calculate_agents_order(
     SCIP* scip,                    // SCIP
     SCIP_PROBDATA* probdata,       // Problem data
@@ -180,9 +632,21 @@ MasterProblemStatus calculate_agents_order(
     const auto& dummy_vars = SCIPprobdataGetDummyVars(probdata);
     const auto& agent_vars = SCIPprobdataGetAgentVars(probdata);
 
+    // Price every agent together if the master problem is infeasible. The LP has no primal solution to prioritise
+    // agents and a new column of any agent can remove the infeasibility.
+    auto order = pricerdata->order;
+    if constexpr (is_farkas)
+    {
+        for (Agent a = 0; a < N; ++a)
+        {
+            order[a] = {a, true, nullptr};
+        }
+        memset(pricerdata->agent_priced, 0, sizeof(bool) * pricerdata->N);
+        return MasterProblemStatus::Infeasible;
+    }
+
     // Calculate the order of the agents.
     MasterProblemStatus master_lp_status = MasterProblemStatus::Integral;
-    auto order = pricerdata->order;
     for (Agent a = 0; a < N; ++a)
     {
         // Must price an agent if it is using an artificial variable.
@@ -234,6 +698,22 @@ MasterProblemStatus calculate_agents_order(
                   });
     }
 
+    // Price a batch of agents regardless of whether an earlier agent finds a column. The batch is sized so that the
+    // time in the low-level solver is about the time to re-solve the LP, which balances the number of LP re-solves
+    // against the work of pricing agents that are not needed.
+    if (pricerdata->adaptive_batch)
+    {
+        if (pricerdata->lp_time >= 0 && pricerdata->agent_time > 0)
+        {
+            const auto batch_size = std::round(pricerdata->lp_time / pricerdata->agent_time);
+            pricerdata->batch_size = static_cast<Agent>(std::clamp<Float>(batch_size, 1, N));
+        }
+        for (Agent idx = 0; idx < pricerdata->batch_size; ++idx)
+        {
+            order[idx].must_price = true;
+        }
+    }
+
     // Reset.
     memset(pricerdata->agent_priced, 0, sizeof(bool) * pricerdata->N);
 
@@ -241,6 +721,45 @@ MasterProblemStatus calculate_agents_order(
     return master_lp_status;
 }
 
+// Block the edges into a vertex
+static
+void forbid_vertex(
+    const Map& map,                  // Map
+    EdgePenalties& edge_penalties,   // Edge penalties of an agent
+    const NodeTime nt                // Vertex to block
+)
+{
+    const auto prev_time = nt.t - 1;
+    {
+        const auto n = map.get_south(nt.n);
+        auto& penalties = edge_penalties.get_edge_penalties(n, prev_time);
+        penalties.north = std::numeric_limits<Cost>::infinity();
+    }
+    {
+        const auto n = map.get_north(nt.n);
+        auto& penalties = edge_penalties.get_edge_penalties(n, prev_time);
+        penalties.south = std::numeric_limits<Cost>::infinity();
+    }
+    {
+        const auto n = map.get_west(nt.n);
+        auto& penalties = edge_penalties.get_edge_penalties(n, prev_time);
+        penalties.east = std::numeric_limits<Cost>::infinity();
+    }
+    {
+        const auto n = map.get_east(nt.n);
+        auto& penalties = edge_penalties.get_edge_penalties(n, prev_time);
+        penalties.west = std::numeric_limits<Cost>::infinity();
+    }
+    {
+        const auto n = map.get_wait(nt.n);
+        auto& penalties = edge_penalties.get_edge_penalties(n, prev_time);
+        penalties.wait = std::numeric_limits<Cost>::infinity();
+    }
+}
+
+// Price the agents with the LP duals or with the Farkas duals if the master problem is infeasible. Farkas pricing
+// does not output early branching or a lower bound.
+template<bool is_farkas>
 static
 SCIP_RETCODE run_trufflehog_pricer(
     SCIP* scip,               // SCIP
@@ -250,13 +769,17 @@ SCIP_RETCODE run_trufflehog_pricer(
     SCIP_Real* lower_bound    // Output lower bound
 )
 {
-    // No Farkas pricing.
-    constexpr bool is_farkas = false;
-
     // Check.
     debug_assert(scip);
     debug_assert(pricer);
 
+    // Trace the round.
+    const TraceScope trace(is_farkas ? "farkas pricing" : "pricing", "node",
+                           SCIPnodeGetNumber(SCIPgetCurrentNode(scip)));
+
+    // Count the round in the node log.
+    node_log_add_pricing_round(scip, is_farkas);
+
     // Get pricer data.
     auto pricerdata = SCIPpricerGetData(pricer);
     debug_assert(pricerdata);
@@ -282,24 +805,39 @@ SCIP_RETCODE run_trufflehog_pricer(
     const auto N = SCIPprobdataGetN(probdata);
     const auto& map = SCIPprobdataGetMap(probdata);
     const auto& agents = SCIPprobdataGetAgentsData(probdata);
+    auto& column_pool = SCIPprobdataGetColumnPool(probdata);
+
+    // Update variable values. The infeasible LP has no solution.
+    if constexpr (!is_farkas)
+    {
+        update_variable_values(scip);
+    }
 
-    // Update variable values.
-    update_variable_values(scip);
+    // Measure the time to re-solve the LP since the last round at the same node.
+    const auto current_node = SCIPnodeGetNumber(SCIPgetCurrentNode(scip));
+    if (!is_farkas &&
+        pricerdata->adaptive_batch && !pricerdata->mispriced && pricerdata->last_round_node == current_node)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        const auto lp_time = std::chrono::duration<Float>(now - pricerdata->last_round_end).count();
+        pricerdata->lp_time = pricerdata->lp_time < 0 ?
+                              lp_time :
+                              BATCH_TIME_SMOOTHING * pricerdata->lp_time + (1 - BATCH_TIME_SMOOTHING) * lp_time;
+    }
 
     // Create order of agents to solve.
     auto order = pricerdata->order;
-    const auto master_lp_status = calculate_agents_order(scip, probdata, pricerdata);
+    const auto master_lp_status = calculate_agents_order<is_farkas>(scip, probdata, pricerdata);
     for (Agent a = 0; a < N; ++a)
     {
         pricerdata->price_priority[a] /= PRICE_PRIORITY_DECAY_FACTOR;
     }
 
-    // Early branching if LP is stalled.
+    // Early branching if LP is stalled. Not checked when repricing after a misprice because the LP is unchanged.
     if constexpr (!is_farkas)
     {
-        if (master_lp_status == MasterProblemStatus::Fractional)
+        if (master_lp_status == MasterProblemStatus::Fractional && !pricerdata->mispriced)
         {
-            const auto current_node = SCIPnodeGetNumber(SCIPgetCurrentNode(scip));
             if (pricerdata->last_solved_node != current_node)
             {
                 constexpr auto nan = std::numeric_limits<SCIP_Real>::quiet_NaN();
@@ -363,34 +901,28 @@ SCIP_RETCODE run_trufflehog_pricer(
     const auto& crossing_agent_goal_conflicts = SCIPprobdataGetCrossingAgentGoalConflicts(probdata);
 #endif
 #ifdef USE_PATH_LENGTH_NOGOODS
-    const auto& path_length_nogoods = SCIPprobdataGetPathLengthNogoods(probdata);
+    const auto& agent_path_length_nogoods = SCIPprobdataGetAgentPathLengthNogoods(probdata);
 #endif
 
     // Get constraints for branching decisions.
     const auto n_vertex_branching_conss = SCIPconshdlrGetNConss(pricerdata->vertex_branching_conshdlr);
     auto vertex_branching_conss = SCIPconshdlrGetConss(pricerdata->vertex_branching_conshdlr);
     debug_assert(n_vertex_branching_conss == 0 || vertex_branching_conss);
+    const auto n_wait_branching_conss = SCIPconshdlrGetNConss(pricerdata->wait_branching_conshdlr);
+    auto wait_branching_conss = SCIPconshdlrGetConss(pricerdata->wait_branching_conshdlr);
+    debug_assert(n_wait_branching_conss == 0 || wait_branching_conss);
     const auto n_length_branching_conss = SCIPconshdlrGetNConss(pricerdata->length_branching_conshdlr);
     auto length_branching_conss = SCIPconshdlrGetConss(pricerdata->length_branching_conshdlr);
     debug_assert(n_length_branching_conss == 0 || length_branching_conss);
+    const auto n_reduced_cost_fixing_conss = SCIPconshdlrGetNConss(pricerdata->reduced_cost_fixing_conshdlr);
+    auto reduced_cost_fixing_conss = SCIPconshdlrGetConss(pricerdata->reduced_cost_fixing_conshdlr);
+    debug_assert(n_reduced_cost_fixing_conss == 0 || reduced_cost_fixing_conss);
 
-    // Get the low-level solver.
-    auto& astar = SCIPprobdataGetAStar(probdata);
-
-    // Get data from the low-level solver.
-    auto& [start,
-           waypoints,
-           goal,
-           earliest_goal_time,
-           latest_goal_time,
-           cost_offset,
-           latest_visit_time,
-           edge_penalties,
-           finish_time_penalties
-#ifdef USE_GOAL_CONFLICTS
-         , goal_penalties
-#endif
-    ] = astar.data();
+    // Get the low-level solvers.
+    const auto& astars = pricerdata->astars;
+    const auto nb_threads = static_cast<Int>(astars.size());
+    debug_assert(nb_threads >= 1);
+    debug_assert(astars[0] == &SCIPprobdataGetAStar(probdata));
 
     // Print used paths.
 #ifdef PRINT_DEBUG
@@ -482,21 +1014,8 @@ SCIP_RETCODE run_trufflehog_pricer(
 //         }
 //     }
 
-    // Find the makespan.
-    Time makespan = 0;
-    for (const auto& [var, _] : vars)
-    {
-        // Get the path length.
-        debug_assert(var);
-        auto vardata = SCIPvarGetData(var);
-        const auto path_length = SCIPvardataGetPathLength(vardata);
-
-        // Store the length of the longest path.
-        if (path_length > makespan)
-        {
-            makespan = path_length;
-        }
-    }
+    // Get the length of the longest path.
+    const auto makespan = SCIPprobdataGetMaxPathLength(probdata);
 
     // Print dual values.
 //#ifdef PRINT_DEBUG
@@ -512,143 +1031,653 @@ SCIP_RETCODE run_trufflehog_pricer(
 //#endif
 //#endif
 
-    // Set up reservation table. Reserve vertices of paths with value 1.
+    // Set up reservation tables. Reserve the vertices and edges of the paths with a positive value weighted by their
+    // values. The tables are updated with only the columns whose values changed since the last round and are only
+    // rebuilt when the makespan changes.
 #ifdef USE_RESERVATION_TABLE
-    auto& restab = astar.reservation_table();
-    restab.clear_reservations();
-    for (const auto& [var, var_val] : vars)
+    const auto reserve_path = [makespan](ReservationTable& restab,
+                                         const Time path_length,
+                                         const Edge* const path,
+                                         const float weight)
     {
-        debug_assert(var);
-        debug_assert(var_val == SCIPgetSolVal(scip, nullptr, var));
-        if (var_val >= 0.5)
+        Node n;
+        Time t = 0;
+        for (; t < path_length; ++t)
         {
-            // Get the path.
-            auto vardata = SCIPvarGetData(var);
-            const auto path_length = SCIPvardataGetPathLength(vardata);
-            const auto path = SCIPvardataGetPath(vardata);
-
-            // Update reservation table.
-            Node n;
-            Time t = 0;
-            for (; t < path_length; ++t)
+            n = path[t].n;
+            restab.reserve(NodeTime{n, t}, weight);
+            if (t < path_length - 1 && path[t].d != Direction::WAIT)
             {
-                n = path[t].n;
-                restab.reserve(NodeTime{n, t});
+                restab.reserve(EdgeTime{path[t], t}, weight);
             }
-            for (; t < makespan; ++t)
+        }
+        for (; t < makespan; ++t)
+        {
+            restab.reserve(NodeTime{n, t}, weight);
+        }
+    };
+    const auto unreserve_path = [makespan](ReservationTable& restab,
+                                           const Time path_length,
+                                           const Edge* const path,
+                                           const float weight)
+    {
+        Node n;
+        Time t = 0;
+        for (; t < path_length; ++t)
+        {
+            n = path[t].n;
+            if (t < path_length - 1 && path[t].d != Direction::WAIT)
             {
-                restab.reserve(NodeTime{n, t});
+                restab.unreserve(EdgeTime{path[t], t}, weight);
             }
+            restab.unreserve(NodeTime{n, t}, weight);
         }
-    }
-#endif
-
-    // Make edge penalties for all agents.
-    EdgePenalties global_edge_penalties;
-
-    // Input dual values for vertex conflicts.
-    for (const auto& [nt, vertex_conflict] : vertex_conflicts_conss)
+        for (; t < makespan; ++t)
+        {
+            restab.unreserve(NodeTime{n, t}, weight);
+        }
+    };
     {
-        const auto& [row] = vertex_conflict;
-        const auto dual = is_farkas ? SCIProwGetDualfarkas(row) : SCIProwGetDualsol(row);
-        debug_assert(SCIPisFeasLE(scip, dual, 0.0));
-        if (SCIPisFeasLT(scip, dual, 0.0))
+        auto& reserved_paths = pricerdata->reserved_paths;
+        auto& round_reserved_paths = pricerdata->round_reserved_paths;
+        if (makespan != pricerdata->reserved_makespan)
         {
-            // Add the dual variable value to the edges leading into the vertex.
-            const auto t = nt.t - 1;
+            // Clear the tables if the paths are extended to a different length.
+            for (auto astar : astars)
             {
-                const auto n = map.get_south(nt.n);
-                auto& penalties = global_edge_penalties.get_edge_penalties(n, t);
-                penalties.north -= dual;
+                astar->reservation_table().clear_reservations();
             }
+            reserved_paths.clear();
+            pricerdata->reserved_makespan = makespan;
+        }
+        else
+        {
+            // Remove the paths found in the last round.
+            for (const auto& path : round_reserved_paths)
             {
-                const auto n = map.get_north(nt.n);
-                auto& penalties = global_edge_penalties.get_edge_penalties(n, t);
-                penalties.south -= dual;
+                unreserve_path(astars[0]->reservation_table(), path.size(), path.data(), 1.0);
             }
+        }
+        round_reserved_paths.clear();
+
+        // Find the columns to reserve.
+        HashTable<int, Pair<SCIP_VAR*, float>> reserve_vars;
+        for (const auto& [var, var_val] : vars)
+        {
+            debug_assert(var);
+            debug_assert(var_val == SCIPgetSolVal(scip, nullptr, var));
+            if (SCIPisPositive(scip, var_val))
             {
-                const auto n = map.get_west(nt.n);
-                auto& penalties = global_edge_penalties.get_edge_penalties(n, t);
-                penalties.east -= dual;
+                reserve_vars.emplace(SCIPvarGetIndex(var), Pair<SCIP_VAR*, float>{var, var_val});
             }
+        }
+
+        // Remove the columns whose values changed.
+        for (auto it = reserved_paths.begin(); it != reserved_paths.end();)
+        {
+            const auto& [path, weight] = it->second;
+            if (auto reserve_it = reserve_vars.find(it->first);
+                reserve_it == reserve_vars.end() || reserve_it->second.second != weight)
             {
-                const auto n = map.get_east(nt.n);
-                auto& penalties = global_edge_penalties.get_edge_penalties(n, t);
-                penalties.west -= dual;
+                for (auto astar : astars)
+                {
+                    unreserve_path(astar->reservation_table(), path.size(), path.data(), weight);
+                }
+                it = reserved_paths.erase(it);
             }
+            else
             {
-                const auto n = map.get_wait(nt.n);
-                auto& penalties = global_edge_penalties.get_edge_penalties(n, t);
-                penalties.wait -= dual;
+                ++it;
             }
         }
-    }
 
-    // Input dual values for edge conflicts.
-    for (const auto& [et, edge_conflict] : edge_conflicts_conss)
-    {
-        const auto& [row, edges, t] = edge_conflict;
-        const auto dual = is_farkas ? SCIProwGetDualfarkas(row) : SCIProwGetDualsol(row);
-        debug_assert(SCIPisFeasLE(scip, dual, 0.0));
-        if (SCIPisFeasLT(scip, dual, 0.0))
+        // Add the columns with new values.
+        for (const auto& [var_idx, reserve_var] : reserve_vars)
         {
-            // Add the dual variable value to the edges.
-            for (const auto e : edges)
+            const auto& [var, weight] = reserve_var;
+            if (reserved_paths.find(var_idx) == reserved_paths.end())
             {
-                auto& penalties = global_edge_penalties.get_edge_penalties(e.n, t);
-                penalties.d[e.d] -= dual;
+                auto vardata = SCIPvarGetData(var);
+                const auto path_length = SCIPvardataGetPathLength(vardata);
+                const auto path = SCIPvardataGetPath(vardata);
+                for (auto astar : astars)
+                {
+                    reserve_path(astar->reservation_table(), path_length, path, weight);
+                }
+                reserved_paths.emplace(var_idx, Pair<Vector<Edge>, float>{Vector<Edge>(path, path + path_length),
+                                                                          weight});
             }
         }
     }
-
-    // Price each agent.
-    Float min_reduced_cost = 0;
-#ifdef PRINT_DEBUG
-    Int nb_new_cols = 0;
 #endif
-    bool found = false;
-    auto agent_priced = pricerdata->agent_priced;
-    for (Int order_idx = 0;
-         order_idx < N && (!found || order[order_idx].must_price) && !SCIPisStopped(scip);
-         ++order_idx)
+
+    // Remove two-agent robust cuts that have been inactive for many rounds.
+    if constexpr (!is_farkas)
     {
-        // Create output.
-        Vector<Edge> path;
-        Vector<NodeTime> path_vertices;
-        SCIP_Real path_cost;
+        SCIP_CALL(SCIPprobdataAgeTwoAgentRobustCuts(scip, probdata));
+    }
 
-        // Set up start and end points.
-        const auto a = order[order_idx].a;
-        start = agents[a].start;
-        goal = agents[a].goal;
+    // Take a snapshot of the dual values. Every row in the LP is read once into an array indexed by its LP position.
+    auto& row_duals = pricerdata->row_duals;
+    SCIP_ROW** rows;
+    Int nb_rows;
+    SCIP_CALL(SCIPgetLPRowsData(scip, &rows, &nb_rows));
+    row_duals.resize(nb_rows);
+    for (Int idx = 0; idx < nb_rows; ++idx)
+    {
+        debug_assert(SCIProwGetLPPos(rows[idx]) == idx);
+        row_duals[idx] = is_farkas ? SCIProwGetDualfarkas(rows[idx]) : SCIProwGetDualsol(rows[idx]);
+    }
+    const auto get_dual = [&row_duals](SCIP_ROW* row)
+    {
+        const auto lp_pos = SCIProwGetLPPos(row);
+        return lp_pos >= 0 ? row_duals[lp_pos] : 0.0;
+    };
 
-        // Input the agent partition dual.
-        {
-            // Get the constraint.
-            auto cons = agent_part[a];
-            debug_assert(cons);
+    // Store the duals of the agent partition constraints.
+    auto agent_part_dual = pricerdata->agent_part_dual;
+    for (Agent a = 0; a < N; ++a)
+    {
+        // Get the constraint.
+        auto cons = agent_part[a];
+        debug_assert(cons);
 
-            // Check that the constraint is not (locally) disabled/redundant.
-            debug_assert(SCIPconsIsEnabled(cons));
+        // Check that the constraint is not (locally) disabled/redundant.
+        debug_assert(SCIPconsIsEnabled(cons));
 
-            // Check that no variable is fixed to one.
-            debug_assert(SCIPgetNFixedonesSetppc(scip, cons) == 0);
+        // Check that no variable is fixed to one.
+        debug_assert(SCIPgetNFixedonesSetppc(scip, cons) == 0);
 
-            // Store dual value.
-            const auto dual = is_farkas ? SCIPgetDualfarkasSetppc(scip, cons) : SCIPgetDualsolSetppc(scip, cons);
-            debug_assert(SCIPisGE(scip, dual, 0.0));
-            cost_offset = -dual;
+        // Store dual value.
+        agent_part_dual[a] = is_farkas ? SCIPgetDualfarkasSetppc(scip, cons) : SCIPgetDualsolSetppc(scip, cons);
+        debug_assert(SCIPisGE(scip, agent_part_dual[a], 0.0));
+    }
+
+    // Smooth the duals towards the stability center (Wentges smoothing). The center is the smoothed duals of the
+    // previous round at the same node. Rows added since the previous round are not smoothed. The smoothed duals are a
+    // convex combination of dual feasible points so they have the same signs as the LP duals.
+    bool smoothed = false;
+    if constexpr (!is_farkas)
+    {
+        if (pricerdata->smoothing > 0)
+        {
+            auto& row_duals_center = pricerdata->row_duals_center;
+            auto& agent_part_dual_center = pricerdata->agent_part_dual_center;
+            if (!pricerdata->mispriced && pricerdata->center_node == current_node)
+            {
+                const auto alpha = pricerdata->smoothing;
+                for (Int idx = 0; idx < nb_rows; ++idx)
+                    if (auto it = row_duals_center.find(rows[idx]); it != row_duals_center.end())
+                    {
+                        row_duals[idx] = alpha * it->second + (1 - alpha) * row_duals[idx];
+                    }
+                for (Agent a = 0; a < N; ++a)
+                {
+                    agent_part_dual[a] = alpha * agent_part_dual_center[a] + (1 - alpha) * agent_part_dual[a];
+                }
+                smoothed = true;
+            }
+
+            // Store the duals as the next stability center.
+            row_duals_center.clear();
+            for (Int idx = 0; idx < nb_rows; ++idx)
+            {
+                row_duals_center[rows[idx]] = row_duals[idx];
+            }
+            std::copy(agent_part_dual, agent_part_dual + N, agent_part_dual_center.begin());
+            pricerdata->center_node = current_node;
+        }
+    }
+
+    // Group the active vertex branching decisions by agent.
+    auto& agent_forbidden_vertices = pricerdata->agent_forbidden_vertices;
+    auto& agent_waypoints = pricerdata->agent_waypoints;
+    auto& used_vertices = pricerdata->used_vertices;
+    for (Agent a = 0; a < N; ++a)
+    {
+        agent_forbidden_vertices[a].clear();
+        agent_waypoints[a].clear();
+    }
+    used_vertices.clear();
+    for (Int c = 0; c < n_vertex_branching_conss; ++c)
+    {
+        // Get the constraint.
+        auto cons = vertex_branching_conss[c];
+        debug_assert(cons);
+
+        // Ignore constraints that are not active since these are not on the current
+        // active path of the search tree.
+        if (!SCIPconsIsActive(cons))
+            continue;
+
+        // Store the decision.
+        const auto branch_a = SCIPgetVertexBranchingAgent(cons);
+        const auto dir = SCIPgetVertexBranchingDirection(cons);
+        const auto nt = SCIPgetVertexBranchingNodeTime(cons);
+        if (dir == VertexBranchDirection::Forbid)
+        {
+            agent_forbidden_vertices[branch_a].push_back(nt);
+        }
+        else
+        {
+            agent_waypoints[branch_a].push_back(nt);
+            used_vertices.emplace_back(branch_a, nt);
+        }
+    }
+
+    // Group the active length branching decisions by agent.
+    auto& agent_earliest_goal_time = pricerdata->agent_earliest_goal_time;
+    auto& agent_latest_goal_time = pricerdata->agent_latest_goal_time;
+    auto& blocked_targets = pricerdata->blocked_targets;
+    std::fill(agent_earliest_goal_time.begin(), agent_earliest_goal_time.end(), 0);
+    std::fill(agent_latest_goal_time.begin(), agent_latest_goal_time.end(), std::numeric_limits<Time>::max());
+    blocked_targets.clear();
+    for (Int c = 0; c < n_length_branching_conss; ++c)
+    {
+        // Get the constraint.
+        auto cons = length_branching_conss[c];
+        debug_assert(cons);
+
+        // Ignore constraints that are not active since these are not on the current active path of the search tree.
+        if (!SCIPconsIsActive(cons))
+            continue;
+
+        // Store the decision.
+        const auto branch_a = SCIPgetLengthBranchingAgent(cons);
+        const auto dir = SCIPgetLengthBranchingDirection(cons);
+        const auto nt = SCIPgetLengthBranchingNodeTime(cons);
+        if (dir == LengthBranchDirection::LEq)
+        {
+            agent_latest_goal_time[branch_a] = std::min(agent_latest_goal_time[branch_a], nt.t);
+            blocked_targets.emplace_back(branch_a, nt);
+        }
+        else
+        {
+            agent_earliest_goal_time[branch_a] = std::max(agent_earliest_goal_time[branch_a], nt.t);
+        }
+    }
+
+    // Group the active wait branching decisions by agent. An agent that must wait at a vertex must also visit it. An
+    // agent that cannot wait at its goal cannot finish by that time since it waits at its goal after finishing.
+    auto& agent_forbidden_waits = pricerdata->agent_forbidden_waits;
+    auto& agent_required_waits = pricerdata->agent_required_waits;
+    for (Agent a = 0; a < N; ++a)
+    {
+        agent_forbidden_waits[a].clear();
+        agent_required_waits[a].clear();
+    }
+    for (Int c = 0; c < n_wait_branching_conss; ++c)
+    {
+        // Get the constraint.
+        auto cons = wait_branching_conss[c];
+        debug_assert(cons);
+
+        // Ignore constraints that are not active since these are not on the current active path of the search tree.
+        if (!SCIPconsIsActive(cons))
+            continue;
+
+        // Store the decision.
+        const auto branch_a = SCIPgetWaitBranchingAgent(cons);
+        const auto dir = SCIPgetWaitBranchingDirection(cons);
+        const auto nt = SCIPgetWaitBranchingNodeTime(cons);
+        if (dir == WaitBranchDirection::CannotWait)
+        {
+            agent_forbidden_waits[branch_a].push_back(nt);
+            if (nt.n == agents[branch_a].goal)
+            {
+                agent_earliest_goal_time[branch_a] = std::max(agent_earliest_goal_time[branch_a], nt.t + 1);
+            }
+        }
+        else
+        {
+            agent_required_waits[branch_a].push_back(nt);
+            if (nt.t > 0)
+            {
+                agent_waypoints[branch_a].push_back(nt);
+            }
+        }
+    }
+
+    // Group the active reduced cost fixings by agent.
+    auto& agent_latest_visit_time = pricerdata->agent_latest_visit_time;
+    for (auto& latest_visit_time : agent_latest_visit_time)
+    {
+        latest_visit_time.clear();
+    }
+    for (Int c = 0; c < n_reduced_cost_fixing_conss; ++c)
+    {
+        // Get the constraint.
+        auto cons = reduced_cost_fixing_conss[c];
+        debug_assert(cons);
+
+        // Ignore constraints that are not active since these are not on the current active path of the search tree.
+        if (!SCIPconsIsActive(cons))
+            continue;
+
+        // Store the fixings.
+        const auto fixing_a = SCIPgetReducedCostFixingAgent(cons);
+        const auto& latest_visit_time = SCIPgetReducedCostFixingLatestVisitTime(cons);
+        agent_latest_goal_time[fixing_a] = std::min(agent_latest_goal_time[fixing_a],
+                                                    SCIPgetReducedCostFixingLatestGoalTime(cons));
+        agent_latest_visit_time[fixing_a].insert(agent_latest_visit_time[fixing_a].end(),
+                                                 latest_visit_time.begin(),
+                                                 latest_visit_time.end());
+    }
+
+    // Bound the finish time of every agent by the incumbent. Every other agent finishes no earlier than its shortest
+    // finish time through its waypoints, so a path finishing later cannot be in a solution better than the incumbent.
+    auto& incumbent_latest_goal_time = pricerdata->incumbent_latest_goal_time;
+    std::fill(incumbent_latest_goal_time.begin(), incumbent_latest_goal_time.end(), std::numeric_limits<Time>::max());
+    if (const auto cutoff = SCIPgetCutoffbound(scip); cutoff < ARTIFICIAL_VAR_COST)
+    {
+        // Find the earliest finish times once per node since the branching decisions do not change within a node.
+        auto& agent_min_finish_time = pricerdata->agent_min_finish_time;
+        auto& sum_min_finish_time = pricerdata->sum_min_finish_time;
+        if (pricerdata->min_finish_time_node != current_node)
+        {
+            sum_min_finish_time = 0;
+            for (Agent a = 0; a < N; ++a)
+            {
+                agent_min_finish_time[a] = std::max(astars[0]->min_finish_time(agents[a].start,
+                                                                               agent_waypoints[a],
+                                                                               agents[a].goal),
+                                                    agent_earliest_goal_time[a]);
+                sum_min_finish_time += agent_min_finish_time[a];
+            }
+            pricerdata->min_finish_time_node = current_node;
+        }
+        for (Agent a = 0; a < N; ++a)
+        {
+            const auto slack = cutoff - (sum_min_finish_time - agent_min_finish_time[a]);
+            if (slack < std::numeric_limits<Time>::max())
+            {
+                incumbent_latest_goal_time[a] = static_cast<Time>(SCIPfeasCeil(scip, slack)) - 1;
+            }
+        }
+    }
+
+    // Make edge penalties for all agents.
+    auto& global_edge_penalties = pricerdata->global_edge_penalties;
+    global_edge_penalties.clear();
+
+    // Input dual values for vertex conflicts.
+    for (const auto& [nt, vertex_conflict] : vertex_conflicts_conss)
+    {
+        const auto& [row] = vertex_conflict;
+        const auto dual = get_dual(row);
+        debug_assert(SCIPisFeasLE(scip, dual, 0.0));
+        if (SCIPisFeasLT(scip, dual, 0.0))
+        {
+            // Add the dual variable value to the edges leading into the vertex.
+            const auto t = nt.t - 1;
+            {
+                const auto n = map.get_south(nt.n);
+                auto& penalties = global_edge_penalties.get_edge_penalties(n, t);
+                penalties.north -= dual;
+            }
+            {
+                const auto n = map.get_north(nt.n);
+                auto& penalties = global_edge_penalties.get_edge_penalties(n, t);
+                penalties.south -= dual;
+            }
+            {
+                const auto n = map.get_west(nt.n);
+                auto& penalties = global_edge_penalties.get_edge_penalties(n, t);
+                penalties.east -= dual;
+            }
+            {
+                const auto n = map.get_east(nt.n);
+                auto& penalties = global_edge_penalties.get_edge_penalties(n, t);
+                penalties.west -= dual;
+            }
+            {
+                const auto n = map.get_wait(nt.n);
+                auto& penalties = global_edge_penalties.get_edge_penalties(n, t);
+                penalties.wait -= dual;
+            }
+        }
+    }
+
+    // Input dual values for edge conflicts.
+    for (const auto& [et, edge_conflict] : edge_conflicts_conss)
+    {
+        const auto& [row, edges, t] = edge_conflict;
+        const auto dual = get_dual(row);
+        debug_assert(SCIPisFeasLE(scip, dual, 0.0));
+        if (SCIPisFeasLT(scip, dual, 0.0))
+        {
+            // Add the dual variable value to the edges.
+            for (const auto e : edges)
+            {
+                auto& penalties = global_edge_penalties.get_edge_penalties(e.n, t);
+                penalties.d[e.d] -= dual;
+            }
+        }
+    }
+
+    // Index the node-times with penalties.
+    global_edge_penalties.build_index(map.size());
+
+    // Copy the global edge penalties to the NUMA node of each replica.
+    {
+        auto& replica_edge_penalties = pricerdata->replica_edge_penalties;
+        Vector<std::thread> threads;
+        threads.reserve(replica_edge_penalties.size());
+        for (size_t replica = 0; replica < replica_edge_penalties.size(); ++replica)
+        {
+            threads.emplace_back([&placement = pricerdata->placement,
+                                  &global_edge_penalties,
+                                  &replica_edge_penalties = replica_edge_penalties[replica],
+                                  thread_idx = pricerdata->replica_thread[replica],
+                                  map_size = map.size()]()
+            {
+                placement.pin(thread_idx);
+                replica_edge_penalties = global_edge_penalties;
+                replica_edge_penalties.build_index(map_size);
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    // Check if an agent has no branching decisions or cuts of its own with a non-zero dual.
+    const auto is_interchangeable = [&](const Agent a)
+    {
+        if (!agent_forbidden_vertices[a].empty() || !agent_waypoints[a].empty() ||
+            !agent_forbidden_waits[a].empty() || !agent_required_waits[a].empty() ||
+            agent_earliest_goal_time[a] != 0 || agent_latest_goal_time[a] != std::numeric_limits<Time>::max() ||
+            !agent_latest_visit_time[a].empty())
+        {
+            return false;
+        }
+        for (const auto& [row, ets_begin, ets_end] : agent_robust_cuts[a])
+            if (SCIPisFeasLT(scip, get_dual(row), 0.0))
+            {
+                return false;
+            }
+#ifdef USE_GOAL_CONFLICTS
+        for (const auto& [t, row] : goal_agent_goal_conflicts[a])
+            if (SCIPisFeasLT(scip, get_dual(row), 0.0))
+            {
+                return false;
+            }
+        for (const auto& [nt, row] : crossing_agent_goal_conflicts[a])
+            if (SCIPisFeasLT(scip, get_dual(row), 0.0))
+            {
+                return false;
+            }
+#endif
+#ifdef USE_PATH_LENGTH_NOGOODS
+        for (const auto& [t, row] : agent_path_length_nogoods[a])
+            if (SCIPisFeasLT(scip, get_dual(row), 0.0))
+            {
+                return false;
+            }
+#endif
+        return true;
+    };
+
+    // Share the pricing problem of interchangeable agents. Their paths are the same and the reduced costs only differ
+    // by the duals of their partition constraints. The first of these agents in the order is solved for the largest
+    // dual so that its paths include every path with negative reduced cost for the others.
+    auto& symmetric_result = pricerdata->symmetric_result;
+    auto& symmetric_dual = pricerdata->symmetric_dual;
+    std::fill(symmetric_result.begin(), symmetric_result.end(), -1);
+    if (!pricerdata->symmetric_classes.empty())
+    {
+        Vector<Int> agent_order_idx(N);
+        for (Int order_idx = 0; order_idx < N; ++order_idx)
+        {
+            agent_order_idx[order[order_idx].a] = order_idx;
+        }
+        Vector<Agent> symmetric_agents;
+        for (const auto& symmetric_class : pricerdata->symmetric_classes)
+        {
+            // Find the agents without constraints of their own.
+            symmetric_agents.clear();
+            for (const auto a : symmetric_class)
+                if (is_interchangeable(a))
+                {
+                    symmetric_agents.push_back(a);
+                }
+            if (symmetric_agents.size() < 2)
+            {
+                continue;
+            }
+
+            // Solve the first agent in the order for the largest dual.
+            const auto leader = *std::min_element(symmetric_agents.begin(),
+                                                  symmetric_agents.end(),
+                                                  [&agent_order_idx](const Agent a1, const Agent a2)
+                                                  {
+                                                      return agent_order_idx[a1] < agent_order_idx[a2];
+                                                  });
+            symmetric_dual[leader] = 0.0;
+            for (const auto a : symmetric_agents)
+            {
+                symmetric_result[a] = agent_order_idx[leader];
+                symmetric_dual[leader] = std::max(symmetric_dual[leader], agent_part_dual[a]);
+            }
+        }
+    }
+
+    // Forget the preprocessed waypoints of the previous node. The branching decisions do not change within a node.
+    auto& waypoint_caches = pricerdata->waypoint_caches;
+    if (pricerdata->waypoint_cache_node != current_node)
+    {
+        for (auto& cache : waypoint_caches)
+        {
+            cache.valid = false;
+            cache.latest_reach_time.clear();
+        }
+        pricerdata->waypoint_cache_node = current_node;
+    }
+
+    // Price an agent. Only the low-level solver of the thread and the output of the agent are modified so that
+    // different agents can be priced concurrently on different solvers.
+    auto& results = pricerdata->results;
+    const auto node_number = SCIPnodeGetNumber(SCIPgetCurrentNode(scip));
+    bool fixing_pass = false;
+    const auto price_agent = [&](const Int thread_idx, const Int order_idx)
+    {
+        // Trace the agent.
+        const TraceScope trace("price agent", "agent", order[order_idx].a);
+
+        // Get data from the low-level solver.
+        auto& astar = *astars[thread_idx];
+        auto& [start,
+               waypoints,
+               goal,
+               earliest_goal_time,
+               latest_goal_time,
+               cost_offset,
+               latest_visit_time,
+               edge_penalties,
+               finish_time_penalties
+#ifdef USE_GOAL_CONFLICTS
+             , goal_penalties
+#endif
+        ] = astar.data();
+
+        // Create output. The paths reuse the memory of the previous run.
+        auto& result = results[order_idx];
+        auto& [path_edges, path_starts, path_costs, statistics] = result;
+        auto& outputs = pricerdata->astar_outputs[thread_idx];
+        Int nb_outputs = 0;
+        bool use_sipp = false;
+        bool truncated = false;
+        result.clear();
+        statistics = PricerStatistics{};
+        astar.reset_statistics();
+
+        // Skip the agent if it reuses the paths of an interchangeable agent earlier in the order.
+        const auto a = order[order_idx].a;
+        const auto shared_idx = symmetric_result[a];
+        if (shared_idx >= 0 && shared_idx != order_idx)
+        {
+            statistics.nb_symmetric_skips++;
+            return;
+        }
+        const auto part_dual = shared_idx >= 0 ? symmetric_dual[a] : agent_part_dual[a];
+
+        // Set up start and end points.
+        start = agents[a].start;
+        goal = agents[a].goal;
+
+        // Skip the agent if the Farkas dual of its partition constraint is not positive. Every path of the agent then
+        // has non-negative Farkas reduced cost because the other Farkas duals are non-positive.
+        if constexpr (is_farkas)
+        {
+            if (!SCIPisSumPositive(scip, part_dual))
+            {
+                return;
+            }
+        }
+
+        // Skip the agent if the partition dual does not cover the shortest finish time through its waypoints. Every
+        // path then has non-negative reduced cost because every edge costs at least one and the penalties are
+        // non-negative. The inputs are still needed for the reduced cost fixing and to evaluate look-ahead branching.
+        if constexpr (!is_farkas)
+        {
+            if (!fixing_pass && pricerdata->lookahead_data.empty())
+            {
+                const auto min_finish_time = std::max(astar.min_finish_time(start, agent_waypoints[a], goal),
+                                                      agent_earliest_goal_time[a]);
+                if (!SCIPisSumLT(scip, min_finish_time - part_dual, 0.0))
+                {
+                    statistics.nb_bound_skips++;
+                    return;
+                }
+            }
+        }
+
+        // Skip the agent if it cannot finish in time for a solution better than the incumbent. This only adds no
+        // column for the agent. Its paths are in no improving solution, so leaving them out of the master problem
+        // keeps the lower bound valid for improving solutions, and the node is pruned by SCIP only if its lower bound
+        // reaches the cutoff bound. The reduced cost fixing bounds the finish time by itself.
+        if (!fixing_pass && incumbent_latest_goal_time[a] < pricerdata->agent_min_finish_time[a])
+        {
+            statistics.nb_bound_skips++;
+            return;
         }
 
-        // Modify edge costs for two-agent robust cuts.
-        edge_penalties = global_edge_penalties;
+        // Input the agent partition dual.
+        cost_offset = -part_dual;
+
+        // Modify edge costs for two-agent robust cuts. The penalties of the agent are layered over the global
+        // penalties.
+        edge_penalties.clear();
+        const auto replica = pricerdata->thread_replica[thread_idx];
+        edge_penalties.set_base(replica >= 0 ? &pricerdata->replica_edge_penalties[replica] : &global_edge_penalties);
         finish_time_penalties.clear();
 #ifdef USE_GOAL_CONFLICTS
         goal_penalties.clear();
 #endif
         for (const auto& [row, ets_begin, ets_end] : agent_robust_cuts[a])
         {
-            const auto dual = is_farkas ? SCIProwGetDualfarkas(row) : SCIProwGetDualsol(row);
+            const auto dual = get_dual(row);
             debug_assert(SCIPisFeasLE(scip, dual, 0.0));
             if (SCIPisFeasLT(scip, dual, 0.0))
             {
@@ -676,7 +1705,7 @@ SCIP_RETCODE run_trufflehog_pricer(
         // after the agent has completed its path.
         for (const auto& [t, row] : agent_goal_vertex_conflicts[a])
         {
-            const auto dual = is_farkas ? SCIProwGetDualfarkas(row) : SCIProwGetDualsol(row);
+            const auto dual = get_dual(row);
             debug_assert(SCIPisFeasLE(scip, dual, 0.0));
             if (SCIPisFeasLT(scip, dual, 0.0))
             {
@@ -690,7 +1719,7 @@ SCIP_RETCODE run_trufflehog_pricer(
 #ifdef USE_WAITEDGE_CONFLICTS
         for (const auto& [t, row] : agent_goal_edge_conflicts[a])
         {
-            const auto dual = is_farkas ? SCIProwGetDualfarkas(row) : SCIProwGetDualsol(row);
+            const auto dual = get_dual(row);
             debug_assert(SCIPisFeasLE(scip, dual, 0.0));
             if (SCIPisFeasLT(scip, dual, 0.0))
             {
@@ -706,7 +1735,7 @@ SCIP_RETCODE run_trufflehog_pricer(
 #ifdef USE_GOAL_CONFLICTS
         for (const auto& [t, row] : goal_agent_goal_conflicts[a])
         {
-            const auto dual = is_farkas ? SCIProwGetDualfarkas(row) : SCIProwGetDualsol(row);
+            const auto dual = get_dual(row);
             debug_assert(SCIPisFeasLE(scip, dual, 0.0));
             if (SCIPisFeasLT(scip, dual, 0.0))
             {
@@ -715,7 +1744,7 @@ SCIP_RETCODE run_trufflehog_pricer(
         }
         for (const auto& [nt, row] : crossing_agent_goal_conflicts[a])
         {
-            const auto dual = is_farkas ? SCIProwGetDualfarkas(row) : SCIProwGetDualsol(row);
+            const auto dual = get_dual(row);
             debug_assert(SCIPisFeasLE(scip, dual, 0.0));
             if (SCIPisFeasLT(scip, dual, 0.0))
             {
@@ -726,81 +1755,54 @@ SCIP_RETCODE run_trufflehog_pricer(
 
         // Modify edge costs for path length nogoods. If agent a finishes at or before time t, incur the penalty.
 #ifdef USE_PATH_LENGTH_NOGOODS
-        for (const auto& [row, latest_finish_times] : path_length_nogoods)
-            for (const auto& [nogood_a, t] : latest_finish_times)
-                if (a == nogood_a)
-                {
-                    const auto dual = is_farkas ? SCIProwGetDualfarkas(row) : SCIProwGetDualsol(row);
-                    debug_assert(SCIPisFeasLE(scip, dual, 0.0));
-                    if (SCIPisFeasLT(scip, dual, 0.0))
-                    {
-                        finish_time_penalties.add(t, -dual);
-                    }
-                }
+        for (const auto& [t, row] : agent_path_length_nogoods[a])
+        {
+            const auto dual = get_dual(row);
+            debug_assert(SCIPisFeasLE(scip, dual, 0.0));
+            if (SCIPisFeasLT(scip, dual, 0.0))
+            {
+                finish_time_penalties.add(t, -dual);
+            }
+        }
 #endif
 
-        // Modify edge costs for vertex branching decisions.
-        waypoints.clear();
-        for (Int c = 0; c < n_vertex_branching_conss; ++c)
+        // Modify edge costs for vertex branching decisions. Block the vertices forbidden to the agent and the vertices
+        // that another agent must use.
+        for (const auto nt : agent_forbidden_vertices[a])
         {
-            // Get the constraint.
-            auto cons = vertex_branching_conss[c];
-            debug_assert(cons);
-
-            // Ignore constraints that are not active since these are not on the current
-            // active path of the search tree.
-            if (!SCIPconsIsActive(cons))
-                continue;
-
-            // Enforce the decision.
-            const auto branch_a = SCIPgetVertexBranchingAgent(cons);
-            const auto dir = SCIPgetVertexBranchingDirection(cons);
-            const auto nt = SCIPgetVertexBranchingNodeTime(cons);
-            if ((a == branch_a && dir == VertexBranchDirection::Forbid) ||
-                (a != branch_a && dir == VertexBranchDirection::Use))
+            forbid_vertex(map, edge_penalties, nt);
+        }
+        for (const auto& [branch_a, nt] : used_vertices)
+            if (a != branch_a)
             {
-                // Don't use the vertex.
-                const auto prev_time = nt.t - 1;
-                {
-                    const auto n = map.get_south(nt.n);
-                    auto& penalties = edge_penalties.get_edge_penalties(n, prev_time);
-                    penalties.north = std::numeric_limits<Cost>::infinity();
-                }
-                {
-                    const auto n = map.get_north(nt.n);
-                    auto& penalties = edge_penalties.get_edge_penalties(n, prev_time);
-                    penalties.south = std::numeric_limits<Cost>::infinity();
-                }
-                {
-                    const auto n = map.get_west(nt.n);
-                    auto& penalties = edge_penalties.get_edge_penalties(n, prev_time);
-                    penalties.east = std::numeric_limits<Cost>::infinity();
-                }
-                {
-                    const auto n = map.get_east(nt.n);
-                    auto& penalties = edge_penalties.get_edge_penalties(n, prev_time);
-                    penalties.west = std::numeric_limits<Cost>::infinity();
-                }
-                {
-                    const auto n = map.get_wait(nt.n);
-                    auto& penalties = edge_penalties.get_edge_penalties(n, prev_time);
-                    penalties.wait = std::numeric_limits<Cost>::infinity();
-                }
+                forbid_vertex(map, edge_penalties, nt);
             }
-            else if (a == branch_a)
-            {
-                debug_assert(dir == VertexBranchDirection::Use);
 
-                // Store a waypoint to enforce use of the vertex.
-                waypoints.push_back(nt);
-            }
+        // Modify edge costs for wait branching decisions. Block waiting at the vertices the agent cannot wait at and
+        // leaving the vertices the agent must wait at.
+        for (const auto nt : agent_forbidden_waits[a])
+        {
+            auto& penalties = edge_penalties.get_edge_penalties(nt.n, nt.t);
+            penalties.wait = std::numeric_limits<Cost>::infinity();
+        }
+        for (const auto nt : agent_required_waits[a])
+        {
+            auto& penalties = edge_penalties.get_edge_penalties(nt.n, nt.t);
+            penalties.north = std::numeric_limits<Cost>::infinity();
+            penalties.south = std::numeric_limits<Cost>::infinity();
+            penalties.east = std::numeric_limits<Cost>::infinity();
+            penalties.west = std::numeric_limits<Cost>::infinity();
         }
 
-        // Sort waypoints by time.
+        // Store the waypoints to enforce use of the vertices.
+        waypoints = agent_waypoints[a];
+
+        // Sort waypoints by time. A vertex that the agent must wait at can also be a vertex that it must use.
         std::sort(waypoints.begin(), waypoints.end(), [](const auto& a, const auto& b)
         {
             return a.t < b.t;
         });
+        waypoints.erase(std::unique(waypoints.begin(), waypoints.end()), waypoints.end());
 #ifdef DEBUG
         for (size_t idx = 1; idx < waypoints.size(); ++idx)
         {
@@ -808,135 +1810,276 @@ SCIP_RETCODE run_trufflehog_pricer(
         }
 #endif
 
-        // Modify edge costs for length branching decisions.
+        // Modify edge costs for length branching decisions. Block crossing the target of another agent at and after
+        // its latest finish time. The finish time is also bounded by the incumbent.
         debug_assert(astar.max_path_length() >= 1);
-        earliest_goal_time = 0;
-        latest_goal_time = astar.max_path_length() - 1;
-        latest_visit_time = map.latest_visit_time();
-        for (Int c = 0; c < n_length_branching_conss; ++c)
+        earliest_goal_time = agent_earliest_goal_time[a];
+        latest_goal_time = std::min(astar.max_path_length() - 1, agent_latest_goal_time[a]);
+        if (!fixing_pass)
         {
-            // Get the constraint.
-            auto cons = length_branching_conss[c];
-            debug_assert(cons);
-
-            // Ignore constraints that are not active since these are not on the current active path of the search tree.
-            if (!SCIPconsIsActive(cons))
-                continue;
-
-            // Enforce the decision if the same agent. Disable crossing if different agent.
-            const auto branch_a = SCIPgetLengthBranchingAgent(cons);
-            const auto dir = SCIPgetLengthBranchingDirection(cons);
-            const auto nt = SCIPgetLengthBranchingNodeTime(cons);
-            if (a == branch_a)
-            {
-                if (dir == LengthBranchDirection::LEq)
-                {
-                    latest_goal_time = std::min(latest_goal_time, nt.t);
-                }
-                else
-                {
-                    earliest_goal_time = std::max(earliest_goal_time, nt.t);
-                }
-            }
-            else if (dir == LengthBranchDirection::LEq)
+            latest_goal_time = std::min(latest_goal_time, incumbent_latest_goal_time[a]);
+        }
+        latest_visit_time.clear();
+        for (const auto& [branch_a, nt] : blocked_targets)
+            if (a != branch_a)
             {
-                // Block crossing the node at time t and later.
-                latest_visit_time[nt.n] = std::min(latest_visit_time[nt.n], nt.t - 1);
+                latest_visit_time.emplace_back(nt.n, nt.t - 1);
             }
-        }
+        latest_visit_time.insert(latest_visit_time.end(),
+                                 agent_latest_visit_time[a].begin(),
+                                 agent_latest_visit_time[a].end());
         debug_assert(waypoints.empty() || latest_goal_time >= waypoints.back().t);
 
+        // Prune labels backward from the goal and bound the unavoidable penalties if the agent is constrained by
+        // the length branching decisions. Both cost about a search of the map and rarely help other agents.
+        const bool is_constrained = agent_latest_goal_time[a] < astar.max_path_length() - 1 ||
+                                    !blocked_targets.empty();
+        astar.set_backward_pruning(pricerdata->backward_pruning && is_constrained);
+        const bool use_penalty_heuristic = pricerdata->penalty_heuristic && is_constrained;
+        astar.set_penalty_heuristic(use_penalty_heuristic);
+
+        // Limit the search to the label budget and weight the lower bound unless repricing exactly. The weighted
+        // search finds a path of negative reduced cost sooner but not the cheapest one, so the Farkas pricing is
+        // always exact.
+        astar.set_label_budget(pricerdata->exact_pricing ? 0 : pricerdata->label_budget);
+        const bool is_focal = !is_farkas && !pricerdata->exact_pricing && pricerdata->focal_weight > 1;
+        astar.set_focal_weight(is_focal ? pricerdata->focal_weight : 1);
+
+        // Keep the inputs for evaluating branching candidates.
+        if (!is_farkas && !pricerdata->lookahead_data.empty())
+        {
+            pricerdata->lookahead_data[a] = astar.data();
+            pricerdata->lookahead_node[a] = node_number;
+        }
+
         // Preprocess input data.
         astar.preprocess_input();
 
+        // Find the node-times that cannot be used by a path improving on the incumbent instead of pricing.
+        if (fixing_pass)
+        {
+            auto& fixing_latest_visit_time = pricerdata->fixing_latest_visit_time[a];
+            fixing_latest_visit_time.clear();
+            const auto gap = SCIPgetCutoffbound(scip) - SCIPgetLPObjval(scip);
+            const auto fixing_latest_goal_time = astar.compute_reduced_cost_fixing(gap, fixing_latest_visit_time);
+            pricerdata->fixing_latest_goal_time[a] = fixing_latest_goal_time < latest_goal_time ?
+                                                     fixing_latest_goal_time :
+                                                     std::numeric_limits<Time>::max();
+            return;
+        }
+
         // Start timer.
 #ifdef PRINT_DEBUG
         const auto start_time = std::chrono::high_resolution_clock::now();
 #endif
 
         // Skip running A* if the penalties in the last iteration of this agent have stayed the same or worsened.
+        // The previous runs are forgotten in Farkas pricing.
 #ifdef USE_ASTAR_SOLUTION_CACHING
-        if (!astar.data().can_be_better(pricerdata->previous_data[a]))
+        if (!is_farkas && !astar.data().can_be_better(pricerdata->previous_data[a]))
         {
+            statistics.nb_cache_skips++;
             goto FINISHED_PRICING_AGENT;
         }
 #endif
 
-        // Solve.
-        astar.before_solve(); // TODO: Merge back in.
-#ifdef USE_SIPP
-        std::tie(path_vertices, path_cost) = astar.solve_sipp<is_farkas>();
-#ifdef DEBUG
+        // Skip running A* if the penalties have improved by too little to find a path with negative reduced cost.
+#ifdef USE_ASTAR_SOLUTION_CACHING
+        if (const auto previous_cost = pricerdata->previous_cost[a];
+            !is_farkas && previous_cost > -std::numeric_limits<Cost>::infinity())
         {
-            const auto [time_expanded_astar_path_vertices, time_expanded_astar_path_cost] = astar.solve<is_farkas>();
-            debug_assert(std::abs(time_expanded_astar_path_cost - path_cost) < 1e-8);
+            const auto max_improvement = astar.data().max_improvement(pricerdata->previous_data[a]);
+            if (max_improvement < std::numeric_limits<Cost>::infinity() &&
+                !SCIPisSumLT(scip, previous_cost - max_improvement, 0.0))
+            {
+                statistics.nb_cache_skips++;
+                goto FINISHED_PRICING_AGENT;
+            }
         }
 #endif
-#else
-        std::tie(path_vertices, path_cost) = astar.solve<is_farkas>();
-#endif
-        if (!path_vertices.empty())
+
+        // Reuse deleted columns with negative reduced cost instead of running A*. The columns are checked against
+        // the waypoints and blocked vertices of the branching decisions in the current node. Each agent has its own
+        // pool so the agents can be scanned concurrently.
         {
-            // Get the path.
-            for (auto it = path_vertices.begin(); it != path_vertices.end(); ++it)
+            auto& agent_column_pool = column_pool[a];
+            Vector<Pair<Cost, size_t>> pool_candidates;
+            for (size_t idx = 0; idx < agent_column_pool.size(); ++idx)
             {
-                const auto d = it != path_vertices.end() - 1 ?
-                               map.get_direction(it->n, (it + 1)->n) :
-                               Direction::INVALID;
-                path.push_back(Edge{it->n, d});
+                const auto vardata = agent_column_pool[idx];
+                const auto path_cost = astar.calculate_path_cost<is_farkas>(SCIPvardataGetPath(vardata),
+                                                                            SCIPvardataGetPathLength(vardata));
+                if (SCIPisSumLT(scip, path_cost, 0.0))
+                {
+                    pool_candidates.emplace_back(path_cost, idx);
+                }
             }
-
-            // Add a column only if the path has negative reduced cost.
-            min_reduced_cost = std::min(min_reduced_cost, path_cost);
-            if (SCIPisSumLT(scip, path_cost, 0.0))
+            if (!pool_candidates.empty())
             {
-                // Print.
-                debugln("    Found path with length {}, reduced cost {:.6f} ({})",
-                        path.size(),
-                        path_cost,
-                        format_path(probdata, path.size(), path.data()));
-
-                // Add column.
-                SCIP_VAR* var = nullptr;
-                SCIP_CALL(SCIPprobdataAddPricedVar(scip, probdata, a, path.size(), path.data(), &var));
-                debug_assert(var);
-                found = true;
-                order[order_idx].new_var = var;
-                pricerdata->price_priority[a]++;
-#ifdef PRINT_DEBUG
-                nb_new_cols++;
-#endif
+                // Take the columns with the lowest reduced cost.
+                std::sort(pool_candidates.begin(), pool_candidates.end());
+                if (static_cast<Int>(pool_candidates.size()) > pricerdata->nb_columns)
+                {
+                    pool_candidates.resize(pricerdata->nb_columns);
+                }
+                for (const auto& [path_cost, idx] : pool_candidates)
+                {
+                    const auto vardata = agent_column_pool[idx];
+                    const auto path = SCIPvardataGetPath(vardata);
+                    path_starts.push_back(path_edges.size());
+                    path_edges.insert(path_edges.end(), path, path + SCIPvardataGetPathLength(vardata));
+                    path_costs.push_back(path_cost);
+                }
+                statistics.nb_pool_columns = pool_candidates.size();
 
-                // Update reservation table.
-#ifdef USE_RESERVATION_TABLE
+                // Remove the columns from the pool and free their paths, which are copied into new columns. A column
+                // returns to the pool if it is deleted again.
+                std::sort(pool_candidates.begin(), pool_candidates.end(), [](const auto& a, const auto& b)
                 {
-                    Node n;
-                    Time t = 0;
-                    for (; t < static_cast<Time>(path.size()); ++t)
-                    {
-                        n = path[t].n;
-                        restab.reserve(NodeTime{n, t});
-                    }
-                    for (; t < makespan; ++t)
-                    {
-                        restab.reserve(NodeTime{n, t});
-                    }
+                    return a.second > b.second;
+                });
+                for (const auto& [path_cost, idx] : pool_candidates)
+                {
+                    SCIPvardataFree(scip, agent_column_pool[idx]);
+                    agent_column_pool[idx] = agent_column_pool.back();
+                    agent_column_pool.pop_back();
                 }
-#endif
 
                 // Advance to the next agent.
                 goto FINISHED_PRICING_AGENT;
             }
         }
 
-        // Store the penalties of the run.
+        // Choose the low-level solver. SIPP avoids generating a label for every wait when the penalties are sparse
+        // over a long time horizon.
+        use_sipp = pricerdata->low_level_solver == PricerLowLevelSolver::SIPP;
+        if (pricerdata->low_level_solver == PricerLowLevelSolver::Auto)
+        {
+            const auto horizon = std::max(makespan, earliest_goal_time + 1);
+            use_sipp = horizon >= AUTO_SIPP_MIN_HORIZON &&
+                       edge_penalties.size_upper_bound() <=
+                       AUTO_SIPP_MAX_PENALTY_DENSITY * map.size() * static_cast<Float>(horizon);
+        }
+
+        // Solve.
+        statistics.nb_solves++;
+        statistics.nb_exact_solves += pricerdata->exact_pricing;
+        astar.before_solve(); // TODO: Merge back in.
+        astar.set_waypoint_cache(&waypoint_caches[a]);
+        if (use_sipp)
+        {
+            nb_outputs = astar.solve_sipp_k<is_farkas>(pricerdata->nb_columns, outputs);
+            truncated = astar.truncated();
+#ifdef DEBUG
+            if (!truncated && !is_focal)
+            {
+                astar.set_label_budget(0);
+                const auto [time_expanded_astar_path_vertices, time_expanded_astar_path_cost] =
+                    astar.solve<is_farkas>();
+                debug_assert((nb_outputs == 0) == time_expanded_astar_path_vertices.empty());
+                debug_assert(nb_outputs == 0 ||
+                             std::abs(time_expanded_astar_path_cost - outputs.front().second) < 1e-8);
+            }
+#endif
+        }
+        else
+        {
+            nb_outputs = astar.solve_k<is_farkas>(pricerdata->nb_columns, outputs);
+            truncated = astar.truncated();
+        }
+        astar.set_waypoint_cache(nullptr);
+        statistics.nb_truncated += truncated;
+        statistics.nb_focal_solves += is_focal;
+
+        // Treat the weighted search as truncated because its path need not be the cheapest.
+        truncated |= is_focal;
+
+        // Record the problem.
+        if (pricerdata->recorder)
+        {
+            pricerdata->recorder->write(a,
+                                        node_number,
+                                        nb_outputs == 0 ? std::numeric_limits<Cost>::infinity() : outputs.front().second,
+                                        astar.data());
+        }
+        for (Int idx = 0; idx < nb_outputs; ++idx)
+        {
+            // A column is added later only if the path has negative reduced cost.
+            const auto& [path_vertices, path_cost] = outputs[idx];
+            if (!SCIPisSumLT(scip, path_cost, 0.0))
+            {
+                continue;
+            }
+
+            // Get the path.
+            const auto path_start = path_edges.size();
+            path_starts.push_back(path_start);
+            for (auto it = path_vertices.begin(); it != path_vertices.end(); ++it)
+            {
+                const auto d = it != path_vertices.end() - 1 ?
+                               map.get_direction(it->n, (it + 1)->n) :
+                               Direction::INVALID;
+                path_edges.push_back(Edge{it->n, d});
+            }
+            path_costs.push_back(path_cost);
+
+            // Update reservation table. Skipped when running in parallel because the agents solved by each
+            // thread are not deterministic.
+#ifdef USE_RESERVATION_TABLE
+            if (nb_threads == 1)
+            {
+                const auto path = path_edges.data() + path_start;
+                const auto path_length = static_cast<Time>(path_edges.size() - path_start);
+                reserve_path(astar.reservation_table(), path_length, path, 1.0);
+                pricerdata->round_reserved_paths.emplace_back(path, path + path_length);
+            }
+#endif
+        }
+        if (result.nb_paths() > 0)
+        {
+            // Advance to the next agent.
+            goto FINISHED_PRICING_AGENT;
+        }
+
+        // Store the penalties of the run. SIPP does not record the edge penalties used by the search, a truncated
+        // run does not give the optimal cost and the Farkas costs do not bound the reduced costs so the previous run
+        // is forgotten to always solve the agent next time. No path costs less than the lowest f value of the labels
+        // pruned by the cost threshold, or there is no path if no label is pruned. The bound needs a heuristic that
+        // does not depend on the penalties.
 #ifdef USE_ASTAR_SOLUTION_CACHING
-        pricerdata->previous_data[a] = astar.data();
+        if (!is_farkas && !use_sipp && !truncated)
+        {
+            astar.cache_data(pricerdata->previous_data[a]);
+            pricerdata->previous_cost[a] = use_penalty_heuristic ?
+                                           -std::numeric_limits<Cost>::infinity() :
+                                           std::max(astar.min_pruned_cost(), -SCIPsumepsilon(scip));
+        }
+        else
+        {
+            pricerdata->previous_data[a].valid = false;
+            pricerdata->previous_cost[a] = -std::numeric_limits<Cost>::infinity();
+        }
 #endif
 
         // End of this agent.
-        FINISHED_PRICING_AGENT:
-        agent_priced[a] = true;
+        FINISHED_PRICING_AGENT:;
+
+        // Store the statistics of the low-level solver.
+        {
+            const auto& astar_statistics = astar.statistics();
+            statistics.nb_labels_generated = astar_statistics.nb_labels_generated;
+            statistics.nb_labels_dominated = astar_statistics.nb_labels_dominated;
+            statistics.nb_heap_pushes = astar_statistics.nb_heap_pushes;
+            statistics.nb_heap_pops = astar_statistics.nb_labels_expanded;
+            statistics.nb_penalty_lookups = astar_statistics.nb_penalty_lookups;
+            statistics.nb_tail_shortcuts = astar_statistics.nb_tail_shortcuts;
+            statistics.nb_macro_waits = astar_statistics.nb_macro_waits;
+            statistics.nb_minimal_solves = astar_statistics.nb_minimal_solves;
+            statistics.preprocess_seconds = astar_statistics.preprocess_seconds;
+            statistics.before_solve_seconds = astar_statistics.before_solve_seconds;
+            statistics.solve_seconds = astar_statistics.solve_seconds;
+            statistics.peak_label_bytes = std::max(statistics.peak_label_bytes, astar.label_pool().nb_bytes_used());
+        }
 
         // End timer.
 #ifdef PRINT_DEBUG
@@ -944,16 +2087,231 @@ SCIP_RETCODE run_trufflehog_pricer(
         const auto duration = std::chrono::duration<double>(end_time - start_time).count();
         debugln("    Done in {:.4f} seconds", duration);
 #endif
+    };
+
+    // Price a range of agents in the order. Each thread takes the next unsolved agent from the range.
+    const auto price_agents = [&](const Int begin, const Int end)
+    {
+        const auto nb_workers = std::min(nb_threads, end - begin);
+        if (nb_workers == 1)
+        {
+            for (Int order_idx = begin; order_idx < end; ++order_idx)
+            {
+                price_agent(0, order_idx);
+            }
+        }
+        else
+        {
+            std::atomic<Int> next_order_idx(begin);
+            const auto worker = [&](const Int thread_idx)
+            {
+                if (pricerdata->pin_threads && thread_idx > 0)
+                {
+                    pricerdata->placement.pin(thread_idx);
+                }
+                for (Int order_idx = next_order_idx++; order_idx < end; order_idx = next_order_idx++)
+                {
+                    price_agent(thread_idx, order_idx);
+                }
+            };
+            Vector<std::thread> threads;
+            threads.reserve(nb_workers - 1);
+            for (Int idx = 1; idx < nb_workers; ++idx)
+            {
+                threads.emplace_back(worker, idx);
+            }
+            worker(0);
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+        }
+    };
+
+    // Get the statistics of the node.
+    auto& agent_statistics = pricerdata->agent_statistics;
+    auto& node_statistics = pricerdata->node_statistics;
+    if (node_statistics.empty() || node_statistics.back().first != node_number)
+    {
+        node_statistics.emplace_back(node_number, PricerStatistics{});
+    }
+
+    // Count the simplex iterations to re-solve the master problem since the last round.
+    {
+        const auto nb_lp_iterations = SCIPgetNLPIterations(scip);
+        node_statistics.back().second.nb_lp_iterations += nb_lp_iterations - pricerdata->last_lp_iterations;
+        pricerdata->last_lp_iterations = nb_lp_iterations;
+    }
+
+    // Check if a path already exists for an agent. An existing column has non-negative reduced cost in the LP so
+    // finding it again is a misprice of the smoothed duals.
+    const auto path_exists = [probdata](const Agent a, const Time path_length, const Edge* const path)
+    {
+        return SCIPprobdataFindVar(probdata, a, path_length, path) != nullptr;
+    };
+
+    // Price each agent.
+    const auto pricing_start_time = std::chrono::steady_clock::now();
+    Float sum_min_reduced_cost = 0;
+    bool used_column_pool = false;
+    bool truncated = false;
+#ifdef PRINT_DEBUG
+    Int nb_new_cols = 0;
+#endif
+    bool found = false;
+    auto agent_priced = pricerdata->agent_priced;
+    Vector<PricedColumn> columns;
+    Vector<Int> column_order_idx;
+    for (Int order_idx = 0;
+         order_idx < N && (!found || order[order_idx].must_price) && !SCIPisStopped(scip);)
+    {
+        // Get the next batch of agents. Agents that must be priced are solved together. Other agents are solved one
+        // per thread at a time so that pricing stops soon after a column is found.
+        auto batch_end = std::min(order_idx + nb_threads, N);
+        if (nb_threads > 1 && order[order_idx].must_price)
+        {
+            batch_end = order_idx + 1;
+            while (batch_end < N && order[batch_end].must_price)
+            {
+                ++batch_end;
+            }
+        }
+
+        // Solve.
+        price_agents(order_idx, batch_end);
+
+        // Collect the columns in the order of the agents.
+        columns.clear();
+        column_order_idx.clear();
+        for (; order_idx < batch_end; ++order_idx)
+        {
+            const auto a = order[order_idx].a;
+            const auto& statistics = results[order_idx].statistics;
+            agent_statistics[a] += statistics;
+            node_statistics.back().second += statistics;
+            truncated |= statistics.nb_truncated > 0 || statistics.nb_focal_solves > 0;
+
+            // Get the paths of the agent or of the interchangeable agent solved for it. The reduced costs of shared
+            // paths are relative to the largest dual of the agents sharing them.
+            const auto shared_idx = symmetric_result[a];
+            const auto& result = results[shared_idx >= 0 ? shared_idx : order_idx];
+            const auto& path_costs = result.path_costs;
+            const auto cost_shift = shared_idx >= 0 ?
+                                    symmetric_dual[order[shared_idx].a] - agent_part_dual[a] :
+                                    0.0;
+            if (shared_idx >= 0 && !is_farkas && !pricerdata->lookahead_data.empty())
+            {
+                pricerdata->lookahead_data[a] = pricerdata->lookahead_data[order[shared_idx].a];
+                pricerdata->lookahead_data[a].cost_offset = -agent_part_dual[a];
+                pricerdata->lookahead_node[a] = node_number;
+            }
+            if (result.nb_paths() > 0 && SCIPisSumLT(scip, path_costs.front() + cost_shift, 0.0))
+            {
+                // The first path has the lowest reduced cost of the agent. Columns reused from the column pool do
+                // not give the minimum reduced cost.
+                sum_min_reduced_cost += path_costs.front() + cost_shift;
+                used_column_pool |= result.statistics.nb_pool_columns > 0;
+
+                // Add a column for every path.
+                for (size_t idx = 0; idx < result.nb_paths(); ++idx)
+                {
+                    // Stop at the first shared path without negative reduced cost for this agent.
+                    const auto path_cost = path_costs[idx] + cost_shift;
+                    if (!SCIPisSumLT(scip, path_cost, 0.0))
+                    {
+                        break;
+                    }
+
+                    // Skip paths that already exist.
+                    const auto path_length = result.path_length(idx);
+                    const auto path = result.path(idx);
+                    if (smoothed && path_exists(a, path_length, path))
+                    {
+                        continue;
+                    }
+
+                    // Print.
+                    debugln("    Found path for agent {} with length {}, reduced cost {:.6f} ({})",
+                            a,
+                            path_length,
+                            path_cost,
+                            format_path(probdata, path_length, path));
+
+                    // Collect column.
+                    columns.push_back({a, path_length, path, nullptr});
+                    column_order_idx.push_back(order_idx);
+                }
+            }
+            agent_priced[a] = true;
+        }
+
+        // Add the columns of the batch together so that each conflict row is extended once.
+        SCIP_CALL(SCIPprobdataAddPricedVars(scip, probdata, columns));
+        for (size_t idx = 0; idx < columns.size(); ++idx)
+        {
+            const auto col_order_idx = column_order_idx[idx];
+            if (idx == 0 || column_order_idx[idx - 1] != col_order_idx)
+            {
+                order[col_order_idx].new_var = columns[idx].var;
+                found = true;
+                pricerdata->price_priority[order[col_order_idx].a]++;
+            }
+#ifdef PRINT_DEBUG
+            nb_new_cols++;
+#endif
+        }
     }
 
     // Print.
     debugln("Added {} new columns", nb_new_cols);
 
+    // Measure the average time to price an agent.
+    if (!is_farkas && pricerdata->adaptive_batch)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        const auto nb_agents_priced = std::count(agent_priced, agent_priced + N, true);
+        if (nb_agents_priced > 0)
+        {
+            const auto agent_time = std::chrono::duration<Float>(now - pricing_start_time).count() / nb_agents_priced;
+            pricerdata->agent_time = pricerdata->agent_time < 0 ?
+                                     agent_time :
+                                     BATCH_TIME_SMOOTHING * pricerdata->agent_time +
+                                     (1 - BATCH_TIME_SMOOTHING) * agent_time;
+        }
+        pricerdata->last_round_node = current_node;
+        pricerdata->last_round_end = now;
+    }
+
+    // Reprice without the label budget and focal weight if no new column is found by the inexact searches. Otherwise
+    // the column generation could stop before the LP is optimal.
+    if (truncated && !found && !SCIPisStopped(scip))
+    {
+        debugln("No column found within the label budget or by the focal search - repricing exactly");
+        pricerdata->exact_pricing = true;
+        SCIP_CALL(run_trufflehog_pricer<is_farkas>(scip, pricer, result, stopearly, lower_bound));
+        pricerdata->exact_pricing = false;
+        return SCIP_OKAY;
+    }
+
+    // Reprice with the LP duals if the smoothed duals found no new column. Otherwise the column generation would stop
+    // before the LP is optimal.
+    if (smoothed && !found && !SCIPisStopped(scip))
+    {
+        debugln("Mispriced with smoothed duals - repricing with LP duals");
+        pricerdata->mispriced = true;
+        SCIP_CALL(run_trufflehog_pricer<is_farkas>(scip, pricer, result, stopearly, lower_bound));
+        pricerdata->mispriced = false;
+        return SCIP_OKAY;
+    }
+
     // Finish.
     if (!SCIPisStopped(scip))
     {
-        // Compute lower bound.
-        if constexpr (!is_farkas)
+        // Compute the Lagrangian lower bound. Every agent uses exactly one column so the LP objective plus the
+        // minimum reduced cost of each agent is a lower bound when every agent is priced. An agent without a path
+        // of negative reduced cost contributes zero. The reduced costs of the smoothed duals and of the runs
+        // truncated by the label budget do not give a bound on the LP.
+        if (!is_farkas && !smoothed && !used_column_pool && !truncated)
         {
             bool all_agents_priced = true;
             for (Agent a = 0; a < N; ++a)
@@ -964,9 +2322,57 @@ SCIP_RETCODE run_trufflehog_pricer(
                 }
             if (all_agents_priced)
             {
-                *lower_bound = SCIPgetLPObjval(scip) + N * min_reduced_cost;
+                *lower_bound = SCIPgetLPObjval(scip) + sum_min_reduced_cost;
                 debugln("   Computed lower bound {}", *lower_bound);
             }
+
+            // Fix the node-times that no column improving on the incumbent can use once the LP of the node is
+            // solved. A column can only be in such a solution if its reduced cost is below the gap between the
+            // incumbent and the LP. The fixings hold in the subtree of the node.
+            const auto best_sol = SCIPgetBestSol(scip);
+            if (all_agents_priced && !found && pricerdata->reduced_cost_fixing &&
+                pricerdata->fixing_node != current_node &&
+                best_sol && SCIPgetSolOrigObj(scip, best_sol) < ARTIFICIAL_VAR_COST &&
+                SCIPisSumPositive(scip, SCIPgetCutoffbound(scip) - SCIPgetLPObjval(scip)))
+            {
+                // Compute the fixings of every agent.
+                pricerdata->fixing_node = current_node;
+                std::fill(symmetric_result.begin(), symmetric_result.end(), -1);
+                fixing_pass = true;
+                price_agents(0, N);
+                fixing_pass = false;
+
+                // Cut off the node if an agent has no path below the gap. Otherwise store the fixings.
+                auto node = SCIPgetCurrentNode(scip);
+                const auto& fixing_latest_goal_time = pricerdata->fixing_latest_goal_time;
+                auto& fixing_latest_visit_time = pricerdata->fixing_latest_visit_time;
+                if (std::any_of(fixing_latest_goal_time.begin(),
+                                fixing_latest_goal_time.end(),
+                                [](const Time t) { return t < 0; }))
+                {
+                    debugln("   Reduced cost fixing found an agent without a path below the gap");
+                    *lower_bound = SCIPgetCutoffbound(scip);
+                }
+                else
+                {
+                    for (Agent a = 0; a < N; ++a)
+                        if (fixing_latest_goal_time[a] != std::numeric_limits<Time>::max() ||
+                            !fixing_latest_visit_time[a].empty())
+                        {
+                            SCIP_CONS* cons = nullptr;
+                            const auto name = fmt::format("reduced_cost_fixing({},{})", a, node_number);
+                            SCIP_CALL(SCIPcreateConsReducedCostFixing(scip,
+                                                                      &cons,
+                                                                      name.c_str(),
+                                                                      a,
+                                                                      fixing_latest_goal_time[a],
+                                                                      std::move(fixing_latest_visit_time[a]),
+                                                                      node));
+                            SCIP_CALL(SCIPaddConsNode(scip, node, cons, nullptr));
+                            SCIP_CALL(SCIPreleaseCons(scip, &cons));
+                        }
+                }
+            }
         }
 
         // Mark as completed.
@@ -979,18 +2385,15 @@ SCIP_RETCODE run_trufflehog_pricer(
 static
 SCIP_DECL_PRICERREDCOST(pricerTruffleHogRedCost)
 {
-    return run_trufflehog_pricer(scip, pricer, result, stopearly, lowerbound);
+    return run_trufflehog_pricer<false>(scip, pricer, result, stopearly, lowerbound);
 }
 
 // Farkas pricing for infeasible master problem
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wunused-parameter"
 static
 SCIP_DECL_PRICERFARKAS(pricerTruffleHogFarkas)
 {
-    unreachable();
+    return run_trufflehog_pricer<true>(scip, pricer, result, nullptr, nullptr);
 }
-#pragma GCC diagnostic pop
 
 // Create pricer and include it in SCIP
 SCIP_RETCODE SCIPincludePricerTruffleHog(
@@ -1013,6 +2416,179 @@ SCIP_RETCODE SCIPincludePricerTruffleHog(
     SCIP_CALL(SCIPsetPricerInit(scip, pricer, pricerTruffleHogInit));
     SCIP_CALL(SCIPsetPricerFree(scip, pricer, pricerTruffleHogFree));
 
+    // Add parameters.
+    SCIP_CALL(SCIPaddIntParam(scip,
+                              "pricers/" PRICER_NAME "/threads",
+                              "number of threads for pricing agents in parallel",
+                              nullptr,
+                              FALSE,
+                              DEFAULT_THREADS,
+                              1,
+                              1024,
+                              nullptr,
+                              nullptr));
+    SCIP_CALL(SCIPaddIntParam(scip,
+                              "pricers/" PRICER_NAME "/columns",
+                              "maximum number of columns to add for an agent in each round of pricing",
+                              nullptr,
+                              FALSE,
+                              DEFAULT_COLUMNS,
+                              1,
+                              std::numeric_limits<int>::max(),
+                              nullptr,
+                              nullptr));
+    SCIP_CALL(SCIPaddStringParam(scip,
+                                 "pricers/" PRICER_NAME "/recordfile",
+                                 "file to record the pricing problems for offline replay (empty to disable)",
+                                 nullptr,
+                                 FALSE,
+                                 DEFAULT_RECORD_FILE,
+                                 nullptr,
+                                 nullptr));
+    SCIP_CALL(SCIPaddIntParam(scip,
+                              "pricers/" PRICER_NAME "/lowlevel",
+                              "low-level solver (0: time-expanded A*, 1: SIPP, 2: choose by density of penalties)",
+                              nullptr,
+                              FALSE,
+                              static_cast<int>(DEFAULT_LOW_LEVEL_SOLVER),
+                              static_cast<int>(PricerLowLevelSolver::AStar),
+                              static_cast<int>(PricerLowLevelSolver::Auto),
+                              nullptr,
+                              nullptr));
+    SCIP_CALL(SCIPaddBoolParam(scip,
+                               "pricers/" PRICER_NAME "/adaptivebatch",
+                               "choose the number of agents to price in a round from the LP and low-level solver times",
+                               nullptr,
+                               FALSE,
+                               DEFAULT_ADAPTIVE_BATCH,
+                               nullptr,
+                               nullptr));
+    SCIP_CALL(SCIPaddRealParam(scip,
+                               "pricers/" PRICER_NAME "/smoothing",
+                               "weight of the stability center in the smoothed duals (0 to disable)",
+                               nullptr,
+                               FALSE,
+                               DEFAULT_SMOOTHING,
+                               0.0,
+                               0.99,
+                               nullptr,
+                               nullptr));
+    SCIP_CALL(SCIPaddIntParam(scip,
+                              "pricers/" PRICER_NAME "/labelblocksize",
+                              "size in MB of each block of memory for the labels of the low-level solver",
+                              nullptr,
+                              TRUE,
+                              DEFAULT_LABEL_BLOCK_SIZE,
+                              1,
+                              4096,
+                              nullptr,
+                              nullptr));
+    SCIP_CALL(SCIPaddBoolParam(scip,
+                               "pricers/" PRICER_NAME "/hugepages",
+                               "back the labels of the low-level solver with transparent huge pages",
+                               nullptr,
+                               TRUE,
+                               DEFAULT_HUGE_PAGES,
+                               nullptr,
+                               nullptr));
+    SCIP_CALL(SCIPaddBoolParam(scip,
+                               "pricers/" PRICER_NAME "/pinthreads",
+                               "pin each pricing thread to a CPU so that its memory stays on its NUMA node",
+                               nullptr,
+                               TRUE,
+                               DEFAULT_PIN_THREADS,
+                               nullptr,
+                               nullptr));
+    SCIP_CALL(SCIPaddBoolParam(scip,
+                               "pricers/" PRICER_NAME "/numareplicate",
+                               "copy the map and the global edge penalties to the NUMA node of each pricing thread "
+                               "(implies pinthreads)",
+                               nullptr,
+                               TRUE,
+                               DEFAULT_NUMA_REPLICATE,
+                               nullptr,
+                               nullptr));
+    SCIP_CALL(SCIPaddIntParam(scip,
+                              "pricers/" PRICER_NAME "/heuristicthreads",
+                              "number of threads computing the heuristic of every goal at once when the pricer starts "
+                              "(0 for the number of pricing threads, -1 to compute it on demand)",
+                              nullptr,
+                              TRUE,
+                              DEFAULT_HEURISTIC_THREADS,
+                              -1,
+                              1024,
+                              nullptr,
+                              nullptr));
+    SCIP_CALL(SCIPaddIntParam(scip,
+                              "pricers/" PRICER_NAME "/frontierbudget",
+                              "size in MB of the array indexed by node-time that replaces the hash table of dominance "
+                              "labels in the low-level solver if the time horizon fits (0 to always use the hash table)",
+                              nullptr,
+                              TRUE,
+                              DEFAULT_FRONTIER_BUDGET,
+                              0,
+                              INT_MAX / (1024 * 1024),
+                              nullptr,
+                              nullptr));
+    SCIP_CALL(SCIPaddBoolParam(scip,
+                               "pricers/" PRICER_NAME "/backwardpruning",
+                               "prune labels that cannot reach the goal in time for agents with a latest goal time or "
+                               "blocked vertices?",
+                               nullptr,
+                               FALSE,
+                               DEFAULT_BACKWARD_PRUNING,
+                               nullptr,
+                               nullptr));
+    SCIP_CALL(SCIPaddBoolParam(scip,
+                               "pricers/" PRICER_NAME "/penaltyheuristic",
+                               "add a lower bound on the unavoidable edge penalties to the heuristic for agents with a "
+                               "latest goal time or blocked vertices?",
+                               nullptr,
+                               FALSE,
+                               DEFAULT_PENALTY_HEURISTIC,
+                               nullptr,
+                               nullptr));
+    SCIP_CALL(SCIPaddIntParam(scip,
+                              "pricers/" PRICER_NAME "/labelbudget",
+                              "maximum number of labels expanded for an agent before repricing the round without a "
+                              "limit if no column is found (0 to disable)",
+                              nullptr,
+                              FALSE,
+                              DEFAULT_LABEL_BUDGET,
+                              0,
+                              INT_MAX,
+                              nullptr,
+                              nullptr));
+    SCIP_CALL(SCIPaddRealParam(scip,
+                               "pricers/" PRICER_NAME "/focalweight",
+                               "weight of the lower bound in the order of the labels before repricing the round exactly "
+                               "if no column is found (1 to disable)",
+                               nullptr,
+                               FALSE,
+                               DEFAULT_FOCAL_WEIGHT,
+                               1.0,
+                               1e6,
+                               nullptr,
+                               nullptr));
+    SCIP_CALL(SCIPaddBoolParam(scip,
+                               "pricers/" PRICER_NAME "/symmetry",
+                               "price agents with the same start and goal and no branching decisions or cuts of their "
+                               "own once and share the paths?",
+                               nullptr,
+                               FALSE,
+                               DEFAULT_SYMMETRY,
+                               nullptr,
+                               nullptr));
+    SCIP_CALL(SCIPaddBoolParam(scip,
+                               "pricers/" PRICER_NAME "/redcostfixing",
+                               "forbid the node-times of an agent that no path with reduced cost below the gap to the "
+                               "incumbent can use once the LP of a node is solved?",
+                               nullptr,
+                               FALSE,
+                               DEFAULT_REDUCED_COST_FIXING,
+                               nullptr,
+                               nullptr));
+
     // Done.
     return SCIP_OKAY;
 }
@@ -1035,3 +2611,264 @@ SCIP_RETCODE SCIPpricerTruffleHogActivate(
     // Done.
     return SCIP_OKAY;
 }
+
+// Get the statistics of the low-level solver summed over each agent
+const Vector<PricerStatistics>& SCIPpricerTruffleHogGetAgentStatistics(
+    SCIP* scip    // SCIP
+)
+{
+    // Check.
+    debug_assert(scip);
+
+    // Get pricer data.
+    static const Vector<PricerStatistics> empty;
+    auto pricer = SCIPfindPricer(scip, PRICER_NAME);
+    debug_assert(pricer);
+    auto pricerdata = SCIPpricerGetData(pricer);
+    return pricerdata ? pricerdata->agent_statistics : empty;
+}
+
+// Get the statistics of the low-level solver summed over each node in the order the nodes are priced
+const Vector<Pair<SCIP_Longint, PricerStatistics>>& SCIPpricerTruffleHogGetNodeStatistics(
+    SCIP* scip    // SCIP
+)
+{
+    // Check.
+    debug_assert(scip);
+
+    // Get pricer data.
+    static const Vector<Pair<SCIP_Longint, PricerStatistics>> empty;
+    auto pricer = SCIPfindPricer(scip, PRICER_NAME);
+    debug_assert(pricer);
+    auto pricerdata = SCIPpricerGetData(pricer);
+    return pricerdata ? pricerdata->node_statistics : empty;
+}
+
+// Get the pricing priority of each agent, or nothing if the pricer is not active
+Vector<SCIP_Real> SCIPpricerTruffleHogGetPricePriority(
+    SCIP* scip    // SCIP
+)
+{
+    // Check.
+    debug_assert(scip);
+
+    // Get pricer data.
+    auto pricer = SCIPfindPricer(scip, PRICER_NAME);
+    debug_assert(pricer);
+    auto pricerdata = SCIPpricerGetData(pricer);
+    if (!pricerdata)
+    {
+        return {};
+    }
+
+    // Copy the priorities.
+    return Vector<SCIP_Real>(pricerdata->price_priority, pricerdata->price_priority + pricerdata->N);
+}
+
+// Set the pricing priority of each agent
+void SCIPpricerTruffleHogSetPricePriority(
+    SCIP* scip,                                 // SCIP
+    const Vector<SCIP_Real>& price_priority     // Pricing priority of each agent
+)
+{
+    // Check.
+    debug_assert(scip);
+
+    // Get pricer data.
+    auto pricer = SCIPfindPricer(scip, PRICER_NAME);
+    debug_assert(pricer);
+    auto pricerdata = SCIPpricerGetData(pricer);
+    release_assert(pricerdata, "Cannot set the pricing priority before the pricer is initialized");
+    release_assert(static_cast<Agent>(price_priority.size()) == pricerdata->N,
+                   "Pricing priority of {} agents given for {} agents", price_priority.size(), pricerdata->N);
+
+    // Copy the priorities.
+    std::copy(price_priority.begin(), price_priority.end(), pricerdata->price_priority);
+}
+
+// Get the low-level solver of each thread, or nothing if the pricer is not active
+const Vector<AStar*>& SCIPpricerTruffleHogGetAStars(
+    SCIP* scip    // SCIP
+)
+{
+    // Check.
+    debug_assert(scip);
+
+    // Get pricer data.
+    static const Vector<AStar*> empty;
+    auto pricer = SCIPfindPricer(scip, PRICER_NAME);
+    debug_assert(pricer);
+    auto pricerdata = SCIPpricerGetData(pricer);
+    return pricerdata ? pricerdata->astars : empty;
+}
+
+// Add the memory of the label pools, the heuristic tables and the reservation tables of the low-level solvers and the
+// memory of the cached inputs of the previous runs
+void SCIPpricerTruffleHogGetMemoryUsage(
+    SCIP* scip,            // SCIP
+    MemoryUsage& usage     // Output memory usage
+)
+{
+    // Check.
+    debug_assert(scip);
+
+    // Get pricer data.
+    auto pricer = SCIPfindPricer(scip, PRICER_NAME);
+    if (!pricer)
+    {
+        return;
+    }
+    auto pricerdata = SCIPpricerGetData(pricer);
+    if (!pricerdata)
+    {
+        return;
+    }
+
+    // Get the memory of the low-level solvers.
+    for (auto astar : pricerdata->astars)
+    {
+        usage.label_pools += astar->label_pool().nb_bytes_allocated();
+        usage.heuristics += astar->heuristic_memory_used();
+#ifdef USE_RESERVATION_TABLE
+        usage.reservation_tables += astar->reservation_table().nb_bytes();
+#endif
+    }
+
+    // Get the memory of the inputs to the previous runs.
+#ifdef USE_ASTAR_SOLUTION_CACHING
+    for (const auto& previous_data : pricerdata->previous_data)
+    {
+        usage.previous_data += vector_bytes(previous_data.waypoints) +
+                               vector_bytes(previous_data.used_edge_penalties) +
+                               vector_bytes(previous_data.latest_visit_time) +
+                               vector_bytes(previous_data.finish_time_penalties);
+#ifdef USE_GOAL_CONFLICTS
+        usage.previous_data += vector_bytes(previous_data.goal_penalties);
+#endif
+    }
+#endif
+}
+
+// Estimate the reduced cost of the best path of the agent of each vertex branching decision in the two children
+Vector<Pair<Cost, Cost>> SCIPpricerTruffleHogLookahead(
+    SCIP* scip,                                // SCIP
+    const Vector<AgentNodeTime>& decisions     // Branching decisions
+)
+{
+    // Check.
+    debug_assert(scip);
+
+    // Get pricer data.
+    auto pricer = SCIPfindPricer(scip, PRICER_NAME);
+    debug_assert(pricer);
+    auto pricerdata = SCIPpricerGetData(pricer);
+    debug_assert(pricerdata);
+
+    // Create output. Decisions of agents not priced at this node are given no estimate.
+    Vector<Pair<Cost, Cost>> costs(decisions.size(), Pair<Cost, Cost>{0.0, 0.0});
+    if (pricerdata->lookahead_data.empty())
+    {
+        return costs;
+    }
+
+    // Get problem data.
+    auto probdata = SCIPgetProbData(scip);
+    const auto& map = SCIPprobdataGetMap(probdata);
+    const auto node_number = SCIPnodeGetNumber(SCIPgetCurrentNode(scip));
+
+    // Solve an agent with the inputs of its last run and one additional decision.
+    const auto solve = [&](AStar& astar, const AgentNodeTime ant, const bool use)
+    {
+        // Get the inputs.
+        astar.data() = pricerdata->lookahead_data[ant.a];
+        auto& [start,
+               waypoints,
+               goal,
+               earliest_goal_time,
+               latest_goal_time,
+               cost_offset,
+               latest_visit_time,
+               edge_penalties,
+               finish_time_penalties
+#ifdef USE_GOAL_CONFLICTS
+             , goal_penalties
+#endif
+        ] = astar.data();
+        const NodeTime nt{ant.n, ant.t};
+
+        // Add the decision.
+        if (use)
+        {
+            if (nt.t > latest_goal_time)
+            {
+                return 0.0;
+            }
+            auto it = std::lower_bound(waypoints.begin(), waypoints.end(), nt, [](const NodeTime a, const NodeTime b)
+            {
+                return a.t < b.t;
+            });
+            if (it != waypoints.end() && it->t == nt.t)
+            {
+                return it->n == nt.n ? 0.0 : std::numeric_limits<Cost>::infinity();
+            }
+            waypoints.insert(it, nt);
+        }
+        else
+        {
+            forbid_vertex(map, edge_penalties, nt);
+        }
+
+        // Solve.
+        astar.preprocess_input();
+        astar.before_solve();
+        const auto [path_vertices, path_cost] = astar.solve<false>();
+        return path_vertices.empty() ? std::numeric_limits<Cost>::infinity() : path_cost;
+    };
+
+    // Evaluate a decision.
+    const auto evaluate = [&](AStar& astar, const size_t idx)
+    {
+        const auto ant = decisions[idx];
+        if (pricerdata->lookahead_node[ant.a] == node_number)
+        {
+            costs[idx].first = solve(astar, ant, false);
+            costs[idx].second = solve(astar, ant, true);
+        }
+    };
+
+    // Evaluate the decisions in parallel. Each thread takes the next unevaluated decision.
+    const auto& astars = pricerdata->astars;
+    const auto nb_workers = std::min(astars.size(), decisions.size());
+    if (nb_workers <= 1)
+    {
+        for (size_t idx = 0; idx < decisions.size(); ++idx)
+        {
+            evaluate(*astars[0], idx);
+        }
+    }
+    else
+    {
+        std::atomic<size_t> next_idx(0);
+        const auto worker = [&](AStar* astar)
+        {
+            for (size_t idx = next_idx++; idx < decisions.size(); idx = next_idx++)
+            {
+                evaluate(*astar, idx);
+            }
+        };
+        Vector<std::thread> threads;
+        threads.reserve(nb_workers - 1);
+        for (size_t idx = 1; idx < nb_workers; ++idx)
+        {
+            threads.emplace_back(worker, astars[idx]);
+        }
+        worker(astars[0]);
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    // Done.
+    return costs;
+}
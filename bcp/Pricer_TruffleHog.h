@@ -23,6 +23,66 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Includes.h"
 #include "ProblemData.h"
 
+// Low-level solver of the Truffle Hog pricer
+enum class PricerLowLevelSolver : int
+{
+    AStar = 0,    // Time-expanded A*
+    SIPP = 1,     // Safe interval path planning
+    Auto = 2      // Choose for each agent depending on the density of the penalties
+};
+
+// Statistics of the low-level solver
+struct PricerStatistics
+{
+    size_t nb_solves;               // Runs of the low-level solver
+    size_t nb_cache_skips;          // Runs skipped because the previous run cannot be improved
+    size_t nb_pool_columns;         // Columns reused from the column pool instead of running the low-level solver
+    size_t nb_symmetric_skips;      // Runs skipped because the paths of an interchangeable agent are reused
+    size_t nb_bound_skips;          // Runs skipped because the partition dual is below the shortest path length
+    size_t nb_truncated;            // Runs stopped after exhausting the label budget
+    size_t nb_exact_solves;         // Runs without the label budget after no column is found within the budget
+    size_t nb_focal_solves;         // Runs with a weighted lower bound before pricing exactly
+    size_t nb_labels_generated;     // Labels checked for dominance
+    size_t nb_labels_dominated;     // Labels discarded by dominance
+    size_t nb_heap_pushes;          // Labels pushed into the priority queue
+    size_t nb_heap_pops;            // Labels popped from the priority queue
+    size_t nb_penalty_lookups;      // Lookups of the edge penalties or intervals out of a node
+    size_t nb_tail_shortcuts;       // Paths closed along the lower bounds after the penalty horizon
+    size_t nb_macro_waits;          // Labels waiting over more than one time step without penalties
+    size_t nb_minimal_solves;       // Runs solved by the kernel specialised for inputs without any feature
+    double preprocess_seconds;      // Time preprocessing the input
+    double before_solve_seconds;    // Time preparing the penalties for the search
+    double solve_seconds;           // Time in the search
+    size_t peak_label_bytes;        // Largest memory used by the labels in a run
+    size_t nb_lp_iterations;        // Simplex iterations re-solving the master problem before the rounds of pricing
+
+    PricerStatistics& operator+=(const PricerStatistics& other)
+    {
+        nb_solves += other.nb_solves;
+        nb_cache_skips += other.nb_cache_skips;
+        nb_pool_columns += other.nb_pool_columns;
+        nb_symmetric_skips += other.nb_symmetric_skips;
+        nb_bound_skips += other.nb_bound_skips;
+        nb_truncated += other.nb_truncated;
+        nb_exact_solves += other.nb_exact_solves;
+        nb_focal_solves += other.nb_focal_solves;
+        nb_labels_generated += other.nb_labels_generated;
+        nb_labels_dominated += other.nb_labels_dominated;
+        nb_heap_pushes += other.nb_heap_pushes;
+        nb_heap_pops += other.nb_heap_pops;
+        nb_penalty_lookups += other.nb_penalty_lookups;
+        nb_tail_shortcuts += other.nb_tail_shortcuts;
+        nb_macro_waits += other.nb_macro_waits;
+        nb_minimal_solves += other.nb_minimal_solves;
+        preprocess_seconds += other.preprocess_seconds;
+        before_solve_seconds += other.before_solve_seconds;
+        solve_seconds += other.solve_seconds;
+        peak_label_bytes = std::max(peak_label_bytes, other.peak_label_bytes);
+        nb_lp_iterations += other.nb_lp_iterations;
+        return *this;
+    }
+};
+
 // Include Truffle Hog pricer
 SCIP_RETCODE SCIPincludePricerTruffleHog(
     SCIP* scip    // SCIP
@@ -33,4 +93,46 @@ SCIP_RETCODE SCIPpricerTruffleHogActivate(
     SCIP* scip    // SCIP
 );
 
+// Get the statistics of the low-level solver summed over each agent
+const Vector<PricerStatistics>& SCIPpricerTruffleHogGetAgentStatistics(
+    SCIP* scip    // SCIP
+);
+
+// Get the statistics of the low-level solver summed over each node in the order the nodes are priced
+const Vector<Pair<SCIP_Longint, PricerStatistics>>& SCIPpricerTruffleHogGetNodeStatistics(
+    SCIP* scip    // SCIP
+);
+
+// Get the pricing priority of each agent, or nothing if the pricer is not active
+Vector<SCIP_Real> SCIPpricerTruffleHogGetPricePriority(
+    SCIP* scip    // SCIP
+);
+
+// Set the pricing priority of each agent
+void SCIPpricerTruffleHogSetPricePriority(
+    SCIP* scip,                                 // SCIP
+    const Vector<SCIP_Real>& price_priority     // Pricing priority of each agent
+);
+
+// Get the low-level solver of each thread, or nothing if the pricer is not active
+const Vector<AStar*>& SCIPpricerTruffleHogGetAStars(
+    SCIP* scip    // SCIP
+);
+
+// Add the memory of the label pools, the heuristic tables and the reservation tables of the low-level solvers and the
+// memory of the cached inputs of the previous runs
+void SCIPpricerTruffleHogGetMemoryUsage(
+    SCIP* scip,            // SCIP
+    MemoryUsage& usage     // Output memory usage
+);
+
+// Estimate the reduced cost of the best path of the agent of each vertex branching decision in the two children by
+// solving the agent with the inputs of its last run at the current node. The output of each decision is the cost in
+// the child forbidding the vertex and the cost in the child using the vertex, or zero if the agent has no inputs kept
+// from the current node.
+Vector<Pair<Cost, Cost>> SCIPpricerTruffleHogLookahead(
+    SCIP* scip,                                // SCIP
+    const Vector<AgentNodeTime>& decisions     // Branching decisions
+);
+
 #endif
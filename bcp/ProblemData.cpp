@@ -19,14 +19,14 @@ Author: Edward Lam <ed@ed-lam.com>
 
 //#define PRINT_DEBUG
 
-#ifdef DEBUG
-//#define MAKE_NAMES
-#endif
-
 #ifndef DEBUG
 #define REMOVE_PADDING
 #endif
 
+#define DEFAULT_ROBUST_CUT_AGE_LIMIT -1    // Number of pricing rounds with zero dual before a two-agent robust cut is removed
+#define DEFAULT_CONFLICT_HORIZON -1        // Time from which conflicts are ignored (-1: never ignore)
+#define COLUMN_POOL_SIZE 100               // Number of deleted columns of each agent kept for reuse by the pricer
+
 #include "ProblemData.h"
 #include "VariableData.h"
 #include "Pricer_TruffleHog.h"
@@ -35,6 +35,12 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "ConstraintHandler_VertexConflicts.h"
 #include "ConstraintHandler_EdgeConflicts.h"
 #include "Separator_Preprocessing.h"
+#include "Separator_Parallel.h"
+#include "Separator_Scheduling.h"
+#include "Separator_CutSelection.h"
+#include "SeparationLog.h"
+#include "Trace.h"
+#include "NodeLog.h"
 #ifdef USE_RECTANGLE_KNAPSACK_CONFLICTS
 #include "Separator_RectangleKnapsackConflicts.h"
 #endif
@@ -90,9 +96,7 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Constraint_VertexBranching.h"
 #include "Constraint_WaitBranching.h"
 #include "Constraint_LengthBranching.h"
-#ifdef USE_EECBS_PRIMAL_HEURISTIC
-#include "Heuristic_EECBS.h"
-#endif
+#include "Constraint_ReducedCostFixing.h"
 #ifdef USE_LNS2_INIT_PRIMAL_HEURISTIC
 #include "Heuristic_LNS2Init.h"
 #endif
@@ -102,6 +106,14 @@ Author: Edward Lam <ed@ed-lam.com>
 #ifdef USE_PRIORITIZED_PLANNING_PRIMAL_HEURISTIC
 #include "Heuristic_PrioritizedPlanning.h"
 #endif
+#ifdef USE_DIVING_PRIMAL_HEURISTIC
+#include "Heuristic_Diving.h"
+#endif
+#include "Checkpoint.h"
+#include "Subtree.h"
+#include "SolutionStream.h"
+#include "Anytime.h"
+#include <numeric>
 
 // Problem data
 struct SCIP_ProbData
@@ -114,24 +126,55 @@ struct SCIP_ProbData
     SCIP_PricerData* pricerdata;                                                // Pricer data
     SharedPtr<AStar> astar;                                                     // Pricing solver
     bool found_cuts;                                                            // Indicates whether a cut is found in the current separation round
+    HashTable<SCIP_SEPA*, SeparatorSchedule> separator_schedules;               // Measured yield of the separators
+    bool deletable_vars;                                                        // Indicates whether priced variables can be deleted by SCIP
+    Time conflict_horizon;                                                      // Time from which conflicts between the agents are ignored
 
     // Variables
+    PathPool path_pool;                                                         // Storage of the paths of the columns
     Vector<SCIP_VAR*> dummy_vars;                                               // Array of dummy variables
     Vector<Pair<SCIP_VAR*, SCIP_Real>> vars;                                    // Array of variables for all agents
     Vector<Vector<Pair<SCIP_VAR*, SCIP_Real>>> agent_vars;                      // Array of variables for each agent
+    Vector<Vector<Int>> agent_var_indices;                                      // Index in the array of all variables of the variables of each agent
+    HashTable<NodeTime, Vector<Int>> vertex_var_indices;                        // Index in the array of all variables of the variables visiting a vertex
+    HashTable<SCIP_VAR*, Pair<Int, Int>> var_indices;                           // Index of each variable in the array of all variables and of its agent
+    Vector<HashTable<uint64_t, SCIP_VAR*>> agent_path_hashes;                   // Variable of each agent with a hash of its path
+    SCIP_Longint nb_duplicate_columns;                                          // Number of paths rejected because their column already exists
+#ifdef USE_LNS2_REPAIR_PRIMAL_HEURISTIC
+    Vector<Int> heuristic_var_indices;                                          // Index in the array of all variables of the variables added by primal heuristics
+#endif
+#ifdef USE_GOAL_CONFLICTS
+    Vector<Agent> goal_agent;                                                   // Agent whose goal is at a node, or -1
+    Vector<Vector<GoalCrossing>> goal_crossings;                                // Variables of other agents visiting the goal of each agent
+#endif
+    Vector<Vector<SCIP_VARDATA*>> column_pool;                                  // Paths of the deleted variables of each agent
+    Time max_path_length;                                                       // Length of the longest path of all variables
+    Time makespan;                                                              // Length of the longest path with positive value in the LP solution
+    Vector<Time> agent_makespan;                                                // Length of the longest path of each agent with positive value in the LP solution
+    SCIP_Longint var_values_nb_lps;                                             // Number of LPs solved in the last update of the variable values, or -1 if stale
+    SCIP_Longint var_values_node;                                               // Node of the last update of the variable values
+    Vector<Int> nonzero_var_indices;                                            // Index of the variables with nonzero value in the last update
+    Vector<int> basis_indices;                                                  // Storage of the basis of the LP
 #if defined(USE_THREEVERTEX_CONFLICTS) || defined(USE_VERTEX_FOUREDGE_CONFLICTS)
     Vector<HashTable<NodeTime, SCIP_Real>> fractional_vertices;                 // Vertices with fractional values
 #endif
     Vector<HashTable<EdgeTime, SCIP_Real>> fractional_edges;                    // Edges with fractional values
     Vector<HashTable<EdgeTime, SCIP_Real>> fractional_move_edges;               // Non-wait edges with fractional values
     Vector<HashTable<EdgeTime, SCIP_Real>> positive_move_edges;                 // Non-wait edges with positive value
-    HashTable<EdgeTime, SCIP_Real*> fractional_edges_vec;                       // Edges with fractional values organised by edge
+    HashTable<EdgeTime, AgentValues> fractional_edges_vec;                      // Edges with fractional values organised by edge
+    Vector<AgentValue> fractional_edges_entries;                                // Storage of the sparse values in fractional_edges_vec
+    Vector<SCIP_Real> fractional_edges_vals;                                    // Storage of the dense values in fractional_edges_vec
+    HashTable<NodeTime, Vector<Agent>> fractional_agents;                       // Agents with a fractional edge at a node in each timestep
+    Vector<Agent> active_agents;                                                // Agents with a fractional edge or meeting one
+    Vector<Vector<Pair<SCIP_VAR*, SCIP_Real>>> agent_positive_vars;             // Columns with positive value in the last update of each agent
+    Time fractional_makespan;                                                   // Makespan in the last update of the fractional edges
 
     // Constraints
     Vector<SCIP_CONS*> agent_part;                                              // Agent partition constraints
     SCIP_CONS* vertex_conflicts;                                                // Constraint for vertex conflicts
     SCIP_CONS* edge_conflicts;                                                  // Constraint for edge conflicts
     Vector<TwoAgentRobustCut> two_agent_robust_cuts;                            // Robust cuts over two agents
+    Vector<RobustCutCandidate> robust_cut_candidates;                           // Robust cuts waiting for the cut selection
 #ifdef USE_RECTANGLE_KNAPSACK_CONFLICTS
     SCIP_SEPA* rectangle_knapsack_conflicts;                                    // Separator for rectangle knapsack conflicts
 #endif
@@ -147,6 +190,9 @@ struct SCIP_ProbData
 
     // Constraints separated by agent for fast retrieval
     Vector<Vector<AgentRobustCut>> agent_robust_cuts;                           // Two-agent robust cuts grouped by agent
+    Vector<Vector<EdgeTime>> agent_robust_cut_edge_times;                       // Storage of the edge-times of the two-agent robust cuts of each agent
+    Vector<HashTable<EdgeTime, Vector<Int>>> agent_robust_cut_index;            // Index in the cuts of each agent of the cuts containing an edge-time
+    Vector<Vector<Pair<Time, Int>>> agent_robust_cut_goal_waits;                // Time and index of the waits at the goal in the cuts of each agent
     Vector<Vector<Pair<Time, SCIP_ROW*>>> agent_goal_vertex_conflicts;          // Vertex conflicts at the goal of an agent
 #ifdef USE_WAITEDGE_CONFLICTS
     Vector<Vector<Pair<Time, SCIP_ROW*>>> agent_goal_edge_conflicts;            // Edge conflicts at the goal of an agent
@@ -155,8 +201,191 @@ struct SCIP_ProbData
     Vector<Vector<Pair<Time, SCIP_ROW*>>> goal_agent_goal_conflicts;            // Goal conflicts of an agent whose goal is in conflict
     Vector<Vector<Pair<NodeTime, SCIP_ROW*>>> crossing_agent_goal_conflicts;    // Goal conflicts of an agent crossing the goal of another agent
 #endif
+#ifdef USE_PATH_LENGTH_NOGOODS
+    Vector<Vector<Pair<Time, SCIP_ROW*>>> agent_path_length_nogoods;            // Path length nogoods of an agent by latest finish time
+#endif
 };
 
+// Hash a path for finding its column
+static inline
+uint64_t hash_path(
+    const Time path_length,    // Path length
+    const Edge* const path     // Path
+)
+{
+    return robin_hood::hash_bytes(path, sizeof(Edge) * path_length);
+}
+
+// Find the variable of an agent with a path
+static
+SCIP_VAR* find_var(
+    SCIP_ProbData* probdata,    // Problem data
+    const Agent a,              // Agent
+    const Time path_length,     // Path length
+    const Edge* const path      // Path
+)
+{
+    // Check if the path has the same hash as a path of the agent.
+    const auto& path_hashes = probdata->agent_path_hashes[a];
+    const auto it = path_hashes.find(hash_path(path_length, path));
+    if (it == path_hashes.end())
+    {
+        return nullptr;
+    }
+
+    // Compare the paths.
+    const auto is_path = [path_length, path](SCIP_VAR* var)
+    {
+        auto vardata = SCIPvarGetData(var);
+        const auto existing_path_length = SCIPvardataGetPathLength(vardata);
+        const auto existing_path = SCIPvardataGetPath(vardata);
+        return std::equal(path, path + path_length, existing_path, existing_path + existing_path_length);
+    };
+    if (is_path(it->second))
+    {
+        return it->second;
+    }
+
+    // Search every variable of the agent if the hashes collide. Only the first path with a hash is indexed.
+    for (const auto& [var, _] : probdata->agent_vars[a])
+        if (is_path(var))
+        {
+            return var;
+        }
+    return nullptr;
+}
+
+// Index the vertices visited by the path of a variable in the array of all variables
+static
+void index_var(
+    SCIP_ProbData* probdata,    // Problem data
+    const Int v                 // Index of the variable in the array of all variables
+)
+{
+    auto vardata = SCIPvarGetData(probdata->vars[v].first);
+    const auto a = SCIPvardataGetAgent(vardata);
+    const auto path_length = SCIPvardataGetPathLength(vardata);
+    const auto path = SCIPvardataGetPath(vardata);
+    const auto agent_v = static_cast<Int>(probdata->agent_var_indices[a].size());
+    debug_assert(probdata->agent_vars[a][agent_v].first == probdata->vars[v].first);
+    probdata->var_indices[probdata->vars[v].first] = {v, agent_v};
+    probdata->agent_var_indices[a].push_back(v);
+    probdata->agent_path_hashes[a].try_emplace(hash_path(path_length, path), probdata->vars[v].first);
+    for (Time t = 0; t < path_length; ++t)
+    {
+        probdata->vertex_var_indices[NodeTime{path[t].n, t}].push_back(v);
+    }
+
+    // Index the last visit of the path to the goal of every other agent.
+#ifdef USE_GOAL_CONFLICTS
+    for (Time t = path_length - 2; t >= 0; --t)
+        if (const auto goal_a = probdata->goal_agent[path[t].n]; goal_a >= 0 && goal_a != a)
+        {
+            auto& crossings = probdata->goal_crossings[goal_a];
+            if (crossings.empty() || crossings.back().v != v)
+            {
+                crossings.push_back({v, a, t});
+            }
+        }
+#endif
+}
+
+// Rebuild the index of the vertices visited by the paths of all variables
+static
+void index_all_vars(
+    SCIP_ProbData* probdata    // Problem data
+)
+{
+    for (auto& indices : probdata->agent_var_indices)
+    {
+        indices.clear();
+    }
+    probdata->vertex_var_indices.clear();
+    probdata->var_indices.clear();
+    for (auto& path_hashes : probdata->agent_path_hashes)
+    {
+        path_hashes.clear();
+    }
+#ifdef USE_GOAL_CONFLICTS
+    for (auto& crossings : probdata->goal_crossings)
+    {
+        crossings.clear();
+    }
+#endif
+    for (Int v = 0; v < static_cast<Int>(probdata->vars.size()); ++v)
+    {
+        index_var(probdata, v);
+    }
+}
+
+// Get the coefficient of a path in a robust cut from the edge-times of its agent in the cut
+static inline
+SCIP_Real get_robust_cut_coeff(
+    const Int path_length,          // Path length
+    const Edge* path,               // Path
+    const EdgeTime* ets_begin,      // First edge-time of the agent in the cut
+    const EdgeTime* ets_end         // One past the last edge-time of the agent in the cut
+)
+{
+    SCIP_Real coeff = 0.0;
+    for (auto it = ets_begin; it != ets_end; ++it)
+    {
+        const auto [e, t] = it->et;
+        coeff += (t < path_length - 1 && e == path[t]) ||
+                 (t >= path_length - 1 && e.n == path[path_length - 1].n && e.d == Direction::WAIT);
+    }
+    return coeff;
+}
+
+// Add a new variable to the two-agent robust cuts of its agent. The coefficients are found from the index of the
+// edge-times of the cuts in one pass over the path instead of by scanning every cut.
+static
+SCIP_RETCODE agent_robust_cuts_add_var(
+    SCIP* scip,                 // SCIP
+    SCIP_ProbData* probdata,    // Problem data
+    SCIP_VAR* var,              // Variable
+    const Agent a,              // Agent
+    const Time path_length,     // Path length
+    const Edge* const path      // Path
+)
+{
+    // Find the cuts containing each edge of the path. The path waits at the goal after its end.
+    const auto& index = probdata->agent_robust_cut_index[a];
+    if (index.empty())
+    {
+        return SCIP_OKAY;
+    }
+    Vector<Int> cut_indices;
+    for (Time t = 0; t < path_length - 1; ++t)
+        if (const auto it = index.find(EdgeTime{path[t], t}); it != index.end())
+        {
+            cut_indices.insert(cut_indices.end(), it->second.begin(), it->second.end());
+        }
+    for (const auto& [t, idx] : probdata->agent_robust_cut_goal_waits[a])
+        if (t >= path_length - 1)
+        {
+            cut_indices.push_back(idx);
+        }
+
+    // Add the variable to each cut with the number of its edges in the cut as the coefficient.
+    std::sort(cut_indices.begin(), cut_indices.end());
+    const auto& agent_cuts = probdata->agent_robust_cuts[a];
+    for (auto it = cut_indices.begin(); it != cut_indices.end();)
+    {
+        const auto end = std::upper_bound(it, cut_indices.end(), *it);
+        const SCIP_Real coeff = end - it;
+        debug_assert(coeff == get_robust_cut_coeff(path_length,
+                                                   path,
+                                                   agent_cuts[*it].begin,
+                                                   agent_cuts[*it].end));
+        SCIP_CALL(SCIPaddVarToRow(scip, agent_cuts[*it].row, var, coeff));
+        it = end;
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+
 // Create problem data for transformed problem
 static
 SCIP_DECL_PROBTRANS(probtrans)
@@ -182,11 +411,28 @@ SCIP_DECL_PROBTRANS(probtrans)
     (*targetdata)->pricerdata = sourcedata->pricerdata;
     (*targetdata)->astar = sourcedata->astar;
     (*targetdata)->found_cuts = false;
+    {
+        SCIP_Bool delvars;
+        SCIP_Bool delvarsroot;
+        SCIP_CALL(SCIPgetBoolParam(scip, "pricing/delvars", &delvars));
+        SCIP_CALL(SCIPgetBoolParam(scip, "pricing/delvarsroot", &delvarsroot));
+        (*targetdata)->deletable_vars = delvars || delvarsroot;
+    }
+    {
+        int conflict_horizon;
+        SCIP_CALL(SCIPgetIntParam(scip, CONFLICT_HORIZON_PARAM, &conflict_horizon));
+        (*targetdata)->conflict_horizon = conflict_horizon >= 0 ? conflict_horizon : std::numeric_limits<Time>::max();
+    }
 
     // Copy agent path variables.
     (*targetdata)->vars = sourcedata->vars;
     (*targetdata)->vars.reserve(N * 5000);
     (*targetdata)->agent_vars.resize(N);
+    (*targetdata)->max_path_length = 0;
+    (*targetdata)->makespan = 0;
+    (*targetdata)->agent_makespan.resize(N);
+    (*targetdata)->var_values_nb_lps = -1;
+    (*targetdata)->var_values_node = -1;
     for (Agent a = 0; a < N; ++a)
     {
         (*targetdata)->agent_vars[a].reserve(5000);
@@ -199,7 +445,22 @@ SCIP_DECL_PROBTRANS(probtrans)
         const auto a = SCIPvardataGetAgent(vardata);
 
         (*targetdata)->agent_vars[a].emplace_back(var, 0);
+        (*targetdata)->max_path_length = std::max((*targetdata)->max_path_length,
+                                                  SCIPvardataGetPathLength(vardata));
+    }
+    (*targetdata)->agent_var_indices.resize(N);
+    (*targetdata)->agent_path_hashes.resize(N);
+    (*targetdata)->nb_duplicate_columns = 0;
+#ifdef USE_GOAL_CONFLICTS
+    (*targetdata)->goal_agent.resize(sourcedata->instance->map.size(), -1);
+    for (Agent a = 0; a < N; ++a)
+    {
+        (*targetdata)->goal_agent[sourcedata->instance->agents[a].goal] = a;
     }
+    (*targetdata)->goal_crossings.resize(N);
+#endif
+    index_all_vars(*targetdata);
+    (*targetdata)->column_pool.resize(N);
 
     // Copy dummy variables.
     debug_assert(static_cast<Agent>(sourcedata->dummy_vars.size()) == N);
@@ -216,6 +477,8 @@ SCIP_DECL_PROBTRANS(probtrans)
     (*targetdata)->fractional_edges.resize(N);
     (*targetdata)->fractional_move_edges.resize(N);
     (*targetdata)->positive_move_edges.resize(N);
+    (*targetdata)->agent_positive_vars.resize(N);
+    (*targetdata)->fractional_makespan = -1;
     {
         const auto& map = (*targetdata)->instance->map;
         const auto reserve_size = sqrt(map.width() * map.height()) * 5;
@@ -229,6 +492,7 @@ SCIP_DECL_PROBTRANS(probtrans)
             (*targetdata)->positive_move_edges[a].reserve(reserve_size);
         }
         (*targetdata)->fractional_edges_vec.reserve(reserve_size * N);
+        (*targetdata)->fractional_agents.reserve(reserve_size * N);
     }
 
     // Copy agent partition constraints.
@@ -278,9 +542,13 @@ SCIP_DECL_PROBTRANS(probtrans)
     // Allocate memory for two-agent robust cuts grouped by agent.
     debug_assert(sourcedata->agent_robust_cuts.empty());
     (*targetdata)->agent_robust_cuts.resize(N);
+    (*targetdata)->agent_robust_cut_edge_times.resize(N);
+    (*targetdata)->agent_robust_cut_index.resize(N);
+    (*targetdata)->agent_robust_cut_goal_waits.resize(N);
     for (Agent a = 0; a < N; ++a)
     {
         (*targetdata)->agent_robust_cuts[a].reserve(5000);
+        (*targetdata)->agent_robust_cut_edge_times[a].reserve(5000 * 4);
     }
 
     // Allocate memory for vertex conflicts at the goal of an agent.
@@ -321,6 +589,11 @@ SCIP_DECL_PROBTRANS(probtrans)
     }
 #endif
 
+    // Allocate memory for path length nogoods grouped by agent.
+#ifdef USE_PATH_LENGTH_NOGOODS
+    (*targetdata)->agent_path_length_nogoods.resize(N);
+#endif
+
     // Done.
     return SCIP_OKAY;
 }
@@ -374,13 +647,7 @@ SCIP_RETCODE probdataFree(
         const auto size = cut.size();
         SCIPfreeBlockMemoryArray(scip, &ptr, size);
     }
-
-    // Release fractional edges.
-    const auto N = SCIPprobdataGetN(*probdata);
-    for (auto& [_, ptr] : (*probdata)->fractional_edges_vec)
-    {
-        SCIPfreeBlockMemoryArray(scip, &ptr, N);
-    }
+    SCIPprobdataClearTwoAgentRobustCutCandidates(scip, *probdata);
 
     // Destroy object.
     (*probdata)->~SCIP_ProbData();
@@ -418,6 +685,9 @@ SCIP_DECL_PROBDELTRANS(probdeltrans)
 static
 SCIP_DECL_PROBEXITSOL(probexitsol)
 {
+    // Discard the cuts waiting for the cut selection.
+    SCIPprobdataClearTwoAgentRobustCutCandidates(scip, probdata);
+
     // Free rows of two-agent robust cuts.
     for (auto& cut : probdata->two_agent_robust_cuts)
     {
@@ -460,16 +730,9 @@ SCIP_RETCODE SCIPprobdataAddDummyVar(
     constexpr SCIP_Real obj = ARTIFICIAL_VAR_COST;
 
     // Create and add variable.
-#ifdef MAKE_NAMES
-    const auto name = fmt::format("dummy_path({})", a);
-#endif
     SCIP_CALL(SCIPcreateVar(scip,
                             var,
-#ifdef MAKE_NAMES
-                            name.c_str(),
-#else
                             "",
-#endif
                             obj,
                             nullptr));
     debug_assert(*var);
@@ -515,19 +778,11 @@ SCIP_RETCODE SCIPprobdataAddHeuristicVar(
     debug_assert(path[path_length - 1].n == SCIPprobdataGetAgentsData(probdata)[a].goal);
 
     // Retrieve the existing variable if it exists.
-    for (const auto& [existing_var, var_val] : probdata->agent_vars.at(a))
+    if (auto existing_var = find_var(probdata, a, path_length, path))
     {
-        debug_assert(existing_var);
-        debug_assert(var_val == SCIPgetSolVal(scip, nullptr, existing_var));
-
-        auto vardata = SCIPvarGetData(existing_var);
-        const auto existing_path_length = SCIPvardataGetPathLength(vardata);
-        const auto existing_path = SCIPvardataGetPath(vardata);
-        if (std::equal(path, path + path_length, existing_path, existing_path + existing_path_length))
-        {
-            *var = existing_var;
-            return SCIP_OKAY;
-        }
+        ++probdata->nb_duplicate_columns;
+        *var = existing_var;
+        return SCIP_OKAY;
     }
 
     // Create variable data.
@@ -539,17 +794,9 @@ SCIP_RETCODE SCIPprobdataAddHeuristicVar(
     const SCIP_Real obj = path_length - 1;
 
     // Create and add variable.
-#ifdef MAKE_NAMES
-    const auto name = fmt::format("path({},({}))",
-                                  a, format_path(probdata, path_length, path)).substr(0, 255);
-#endif
     SCIP_CALL(SCIPcreateVar(scip,
                             var,
-#ifdef MAKE_NAMES
-                            name.c_str(),
-#else
                             "",
-#endif
                             obj,
                             vardata));
     debug_assert(*var);
@@ -585,23 +832,7 @@ SCIP_RETCODE SCIPprobdataAddHeuristicVar(
                                      path));
 
     // Add coefficients to two-agent robust cuts.
-    for (const auto& [row, ets_begin, ets_end] : probdata->agent_robust_cuts[a])
-    {
-        // Calculate the coefficient.
-        SCIP_Real coeff = 0.0;
-        for (auto it = ets_begin; it != ets_end; ++it)
-        {
-            const auto [e, t] = it->et;
-            coeff += (t < path_length - 1 && e == path[t]) ||
-                     (t >= path_length - 1 && e.n == path[path_length - 1].n && e.d == Direction::WAIT);
-        }
-
-        // Add variable to the cut.
-        if (coeff)
-        {
-            SCIP_CALL(SCIPaddVarToRow(scip, row, *var, coeff));
-        }
-    }
+    SCIP_CALL(agent_robust_cuts_add_var(scip, probdata, *var, a, path_length, path));
 
     // Add coefficient to goal conflicts constraints.
 #ifdef USE_GOAL_CONFLICTS
@@ -616,24 +847,29 @@ SCIP_RETCODE SCIPprobdataAddHeuristicVar(
     // Add coefficient to path length nogoods.
 #ifdef USE_PATH_LENGTH_NOGOODS
     SCIP_CALL(path_length_nogoods_add_var(scip,
-                                          probdata->path_length_nogoods,
+                                          probdata->agent_path_length_nogoods[a],
                                           *var,
-                                          a,
                                           path_length));
 #endif
 
     // Store variable in array of all variables.
     probdata->vars.emplace_back(*var, 0);
+    probdata->max_path_length = std::max(probdata->max_path_length, path_length);
 
     // Store variable in agent variables array.
     debug_assert(a < static_cast<Agent>(probdata->agent_vars.size()));
     probdata->agent_vars[a].emplace_back(*var, 0);
 
+    // Index the vertices visited by the variable.
+    index_var(probdata, static_cast<Int>(probdata->vars.size()) - 1);
+
     // Capture variable again. Previously captured in addVar.
     SCIP_CALL(SCIPcaptureVar(scip, *var));
 
-    // Mark constraints enforcing branching decisions to be repropagated.
+    // Mark constraints enforcing branching decisions to be repropagated. The variable can ignore the branching
+    // decisions so it is recorded for the constraints that have already propagated past its index.
 #ifdef USE_LNS2_REPAIR_PRIMAL_HEURISTIC
+    probdata->heuristic_var_indices.push_back(static_cast<Int>(probdata->vars.size()) - 1);
     {
         Vector<SCIP_NODE*> nodes;
         for (auto node = SCIPgetCurrentNode(scip); node; node = SCIPnodeGetParent(node))
@@ -669,26 +905,13 @@ SCIP_RETCODE SCIPprobdataAddInitialVar(
     debug_assert(path[0].n == SCIPprobdataGetAgentsData(probdata)[a].start);
     debug_assert(path[path_length - 1].n == SCIPprobdataGetAgentsData(probdata)[a].goal);
 
-    // Check that the path doesn't already exist.
-#ifdef DEBUG
-    for (const auto& [var, var_val] : probdata->agent_vars.at(a))
+    // Retrieve the existing variable if the path already exists.
+    if (auto existing_var = find_var(probdata, a, path_length, path))
     {
-        debug_assert(var);
-        debug_assert(var_val == SCIPgetSolVal(scip, nullptr, var));
-
-        auto vardata = SCIPvarGetData(var);
-        const auto existing_path_length = SCIPvardataGetPathLength(vardata);
-        const auto existing_path = SCIPvardataGetPath(vardata);
-        release_assert(!std::equal(path,
-                                   path + path_length,
-                                   existing_path,
-                                   existing_path + existing_path_length),
-                       "Path {} already exists for agent {} with value {}",
-                       format_path(probdata, path_length, path),
-                       a,
-                       var_val);
+        ++probdata->nb_duplicate_columns;
+        *var = existing_var;
+        return SCIP_OKAY;
     }
-#endif
 
     // Create variable data.
     SCIP_VarData* vardata = nullptr;
@@ -699,17 +922,9 @@ SCIP_RETCODE SCIPprobdataAddInitialVar(
     const SCIP_Real obj = path_length - 1;
 
     // Create and add variable.
-#ifdef MAKE_NAMES
-    const auto name = fmt::format("path({},({}))",
-                                  a, format_path(probdata, path_length, path)).substr(0, 255);
-#endif
     SCIP_CALL(SCIPcreateVar(scip,
                             var,
-#ifdef MAKE_NAMES
-                            name.c_str(),
-#else
                             "",
-#endif
                             obj,
                             vardata));
     debug_assert(*var);
@@ -745,23 +960,7 @@ SCIP_RETCODE SCIPprobdataAddInitialVar(
                                      path));
 
     // Add coefficients to two-agent robust cuts.
-    for (const auto& [row, ets_begin, ets_end] : probdata->agent_robust_cuts[a])
-    {
-        // Calculate the coefficient.
-        SCIP_Real coeff = 0.0;
-        for (auto it = ets_begin; it != ets_end; ++it)
-        {
-            const auto [e, t] = it->et;
-            coeff += (t < path_length - 1 && e == path[t]) ||
-                     (t >= path_length - 1 && e.n == path[path_length - 1].n && e.d == Direction::WAIT);
-        }
-
-        // Add variable to the cut.
-        if (coeff)
-        {
-            SCIP_CALL(SCIPaddVarToRow(scip, row, *var, coeff));
-        }
-    }
+    SCIP_CALL(agent_robust_cuts_add_var(scip, probdata, *var, a, path_length, path));
 
     // Add coefficient to goal conflicts constraints.
 #ifdef USE_GOAL_CONFLICTS
@@ -776,19 +975,22 @@ SCIP_RETCODE SCIPprobdataAddInitialVar(
     // Add coefficient to path length nogoods.
 #ifdef USE_PATH_LENGTH_NOGOODS
     SCIP_CALL(path_length_nogoods_add_var(scip,
-                                          probdata->path_length_nogoods,
+                                          probdata->agent_path_length_nogoods[a],
                                           *var,
-                                          a,
                                           path_length));
 #endif
 
     // Store variable in array of all variables.
     probdata->vars.emplace_back(*var, 0);
+    probdata->max_path_length = std::max(probdata->max_path_length, path_length);
 
     // Store variable in agent variables array.
     debug_assert(a < static_cast<Agent>(probdata->agent_vars.size()));
     probdata->agent_vars[a].emplace_back(*var, 0);
 
+    // Index the vertices visited by the variable.
+    index_var(probdata, static_cast<Int>(probdata->vars.size()) - 1);
+
     // Capture variable again. Previously captured in addVar.
     SCIP_CALL(SCIPcaptureVar(scip, *var));
 
@@ -796,14 +998,16 @@ SCIP_RETCODE SCIPprobdataAddInitialVar(
     return SCIP_OKAY;
 }
 
-// Add a new variable from pricing
-SCIP_RETCODE SCIPprobdataAddPricedVar(
-    SCIP* scip,                 // SCIP
-    SCIP_ProbData* probdata,    // Problem data
-    const Agent a,              // Agent
-    const Time path_length,     // Path length
-    const Edge* const path,     // Path
-    SCIP_VAR** var              // Output new variable
+// Add a new variable from pricing. The coefficients of the vertex and edge conflicts are left to the caller if the
+// new variable is collected into a batch.
+static SCIP_RETCODE add_priced_var(
+    SCIP* scip,                       // SCIP
+    SCIP_ProbData* probdata,          // Problem data
+    const Agent a,                    // Agent
+    const Time path_length,           // Path length
+    const Edge* const path,           // Path
+    SCIP_VAR** var,                   // Output new variable
+    Vector<SCIP_VAR*>* const batch    // Output new variables missing the conflicts or nullptr
 )
 {
     // Check.
@@ -812,26 +1016,13 @@ SCIP_RETCODE SCIPprobdataAddPricedVar(
     debug_assert(path[0].n == SCIPprobdataGetAgentsData(probdata)[a].start);
     debug_assert(path[path_length - 1].n == SCIPprobdataGetAgentsData(probdata)[a].goal);
 
-    // Check that the path doesn't already exist.
-#ifdef DEBUG
-    for (const auto& [var, var_val] : probdata->agent_vars.at(a))
+    // Retrieve the existing variable if the path already exists.
+    if (auto existing_var = find_var(probdata, a, path_length, path))
     {
-        debug_assert(var);
-        debug_assert(var_val == SCIPgetSolVal(scip, nullptr, var));
-
-        auto vardata = SCIPvarGetData(var);
-        const auto existing_path_length = SCIPvardataGetPathLength(vardata);
-        const auto existing_path = SCIPvardataGetPath(vardata);
-        release_assert(!std::equal(path,
-                                   path + path_length,
-                                   existing_path,
-                                   existing_path + existing_path_length),
-                       "Path {} already exists for agent {} with value {}",
-                       format_path(probdata, path_length, path),
-                       a,
-                       var_val);
+        ++probdata->nb_duplicate_columns;
+        *var = existing_var;
+        return SCIP_OKAY;
     }
-#endif
 
     // Create variable data.
     SCIP_VarData* vardata = nullptr;
@@ -842,20 +1033,16 @@ SCIP_RETCODE SCIPprobdataAddPricedVar(
     const SCIP_Real obj = path_length - 1;
 
     // Create and add variable.
-#ifdef MAKE_NAMES
-    const auto name = fmt::format("path({},({}))",
-                                  a, format_path(probdata, path_length, path)).substr(0, 255);
-#endif
     SCIP_CALL(SCIPcreateVar(scip,
                             var,
-#ifdef MAKE_NAMES
-                            name.c_str(),
-#else
                             "",
-#endif
                             obj,
                             vardata));
     debug_assert(*var);
+    if (probdata->deletable_vars)
+    {
+        SCIPvarMarkDeletable(*var);
+    }
     SCIP_CALL(SCIPaddPricedVar(scip, *var, 1.0));
 
     // Print.
@@ -873,39 +1060,28 @@ SCIP_RETCODE SCIPprobdataAddPricedVar(
     debug_assert(SCIPconsIsEnabled(probdata->agent_part[a]));
     SCIP_CALL(SCIPaddCoefSetppc(scip, probdata->agent_part[a], *var));
 
-    // Add coefficient to vertex conflicts constraints.
-    SCIP_CALL(vertex_conflicts_add_var(scip,
-                                       probdata->vertex_conflicts,
-                                       *var,
-                                       path_length,
-                                       path));
-
-    // Add coefficient to edge conflicts constraints.
-    SCIP_CALL(edge_conflicts_add_var(scip,
-                                     probdata->edge_conflicts,
-                                     *var,
-                                     path_length,
-                                     path));
-
-    // Add coefficients to two-agent robust cuts.
-    for (const auto& [row, ets_begin, ets_end] : probdata->agent_robust_cuts[a])
+    // Add coefficient to vertex and edge conflicts constraints.
+    if (batch)
     {
-        // Calculate the coefficient.
-        SCIP_Real coeff = 0.0;
-        for (auto it = ets_begin; it != ets_end; ++it)
-        {
-            const auto [e, t] = it->et;
-            coeff += (t < path_length - 1 && e == path[t]) ||
-                     (t >= path_length - 1 && e.n == path[path_length - 1].n && e.d == Direction::WAIT);
-        }
-
-        // Add variable to the cut.
-        if (coeff)
-        {
-            SCIP_CALL(SCIPaddVarToRow(scip, row, *var, coeff));
-        }
+        batch->push_back(*var);
+    }
+    else
+    {
+        SCIP_CALL(vertex_conflicts_add_var(scip,
+                                           probdata->vertex_conflicts,
+                                           *var,
+                                           path_length,
+                                           path));
+        SCIP_CALL(edge_conflicts_add_var(scip,
+                                         probdata->edge_conflicts,
+                                         *var,
+                                         path_length,
+                                         path));
     }
 
+    // Add coefficients to two-agent robust cuts.
+    SCIP_CALL(agent_robust_cuts_add_var(scip, probdata, *var, a, path_length, path));
+
     // Add coefficient to rectangle clique conflicts constraints.
 #ifdef USE_RECTANGLE_CLIQUE_CONFLICTS
     SCIP_CALL(rectangle_clique_conflicts_add_var(scip,
@@ -929,19 +1105,22 @@ SCIP_RETCODE SCIPprobdataAddPricedVar(
     // Add coefficient to path length nogoods.
 #ifdef USE_PATH_LENGTH_NOGOODS
     SCIP_CALL(path_length_nogoods_add_var(scip,
-                                          probdata->path_length_nogoods,
+                                          probdata->agent_path_length_nogoods[a],
                                           *var,
-                                          a,
                                           path_length));
 #endif
 
     // Store variable in array of all variables.
     probdata->vars.emplace_back(*var, 0);
+    probdata->max_path_length = std::max(probdata->max_path_length, path_length);
 
     // Store variable in agent variables array.
     debug_assert(a < static_cast<Agent>(probdata->agent_vars.size()));
     probdata->agent_vars[a].emplace_back(*var, 0);
 
+    // Index the vertices visited by the variable.
+    index_var(probdata, static_cast<Int>(probdata->vars.size()) - 1);
+
     // Capture variable again. Previously captured in addVar.
     SCIP_CALL(SCIPcaptureVar(scip, *var));
 
@@ -949,66 +1128,285 @@ SCIP_RETCODE SCIPprobdataAddPricedVar(
     return SCIP_OKAY;
 }
 
-// Add a new two-agent robust cut
-SCIP_RETCODE SCIPprobdataAddTwoAgentRobustCut(
+// Add a new variable from pricing
+SCIP_RETCODE SCIPprobdataAddPricedVar(
     SCIP* scip,                 // SCIP
     SCIP_ProbData* probdata,    // Problem data
-    SCIP_SEPA* sepa,            // Separator
-    TwoAgentRobustCut&& cut,    // Data for the cut
-    const SCIP_Real rhs,        // RHS
-    SCIP_RESULT* result,        // Output result
-    Int* idx                    // Output index of the cut
+    const Agent a,              // Agent
+    const Time path_length,     // Path length
+    const Edge* const path,     // Path
+    SCIP_VAR** var              // Output new variable
 )
 {
-    // Create a row.
-    SCIP_ROW* row = nullptr;
-    SCIP_CALL(SCIPcreateEmptyRowSepa(scip,
-                                     &row,
-                                     sepa,
-#ifdef MAKE_NAMES
-                                     cut.name().c_str(),
-#else
-                                     "",
-#endif
-                                     -SCIPinfinity(scip),
-                                     rhs,
-                                     FALSE,
-                                     TRUE,
-                                     FALSE));
-    debug_assert(row);
-    cut.set_row(row);
-
-    // Get variables.
-    const auto& agent_vars = SCIPprobdataGetAgentVars(probdata);
+    return add_priced_var(scip, probdata, a, path_length, path, var, nullptr);
+}
 
-    // Add variables to the constraint.
-#ifdef DEBUG
-    SCIP_Real lhs = 0.0;
-#endif
-    SCIP_CALL(SCIPcacheRowExtensions(scip, row));
-    const auto iterators = cut.iterators();
-    for (const auto& [a, ets_begin, ets_end] : iterators)
-        for (const auto& [var, var_val] : agent_vars[a])
-        {
-            debug_assert(var);
-            debug_assert(var_val == SCIPgetSolVal(scip, nullptr, var));
+// Add a batch of new variables from pricing
+SCIP_RETCODE SCIPprobdataAddPricedVars(
+    SCIP* scip,                      // SCIP
+    SCIP_ProbData* probdata,         // Problem data
+    Vector<PricedColumn>& columns    // Columns and their output variables
+)
+{
+    // Create the variables.
+    Vector<SCIP_VAR*> batch;
+    batch.reserve(columns.size());
+    for (auto& [a, path_length, path, var] : columns)
+    {
+        SCIP_CALL(add_priced_var(scip, probdata, a, path_length, path, &var, &batch));
+        debug_assert(var);
+    }
 
-            // Get the path.
-            auto vardata = SCIPvarGetData(var);
-            debug_assert(a == SCIPvardataGetAgent(vardata));
-            const auto path_length = SCIPvardataGetPathLength(vardata);
-            const auto path = SCIPvardataGetPath(vardata);
+    // Add the new variables to the vertex and edge conflicts constraints, extending each row once.
+    if (!batch.empty())
+    {
+        SCIP_CALL(vertex_conflicts_add_vars(scip, probdata->vertex_conflicts, batch));
+        SCIP_CALL(edge_conflicts_add_vars(scip, probdata->edge_conflicts, batch));
+    }
 
-            // Add coefficients.
-            SCIP_Real coeff = 0.0;
-            for (auto it = ets_begin; it != ets_end; ++it)
-            {
-                const auto [e, t] = it->et;
-                coeff += (t < path_length - 1 && e == path[t]) ||
-                         (t >= path_length - 1 && e.n == path[path_length - 1].n && e.d == Direction::WAIT);
-            }
+    // Done.
+    return SCIP_OKAY;
+}
 
-            // Add coefficient.
+// Remove the variables deleted by SCIP after being unused for a long time
+SCIP_RETCODE SCIPprobdataRemoveDeletedVars(
+    SCIP* scip,                // SCIP
+    SCIP_ProbData* probdata    // Problem data
+)
+{
+    // Check.
+    debug_assert(probdata);
+    if (!probdata->deletable_vars)
+    {
+        return SCIP_OKAY;
+    }
+
+    // Remove from the array of all variables. Release the locks of the conflicts constraints, which are added to every
+    // priced variable, and release the capture in the problem data. The path of a deleted variable is kept in the
+    // column pool of its agent for the pricer to reuse.
+    auto& vars = probdata->vars;
+    Vector<Pair<SCIP_VAR*, SCIP_Real>>::size_type nb_vars = 0;
+    Time max_path_length = 0;
+    Vector<Int> nb_kept_vars(vars.size() + 1, 0);
+    for (size_t v = 0; v < vars.size(); ++v)
+    {
+        nb_kept_vars[v + 1] = nb_kept_vars[v] + !SCIPvarIsDeleted(vars[v].first);
+    }
+    for (auto& [var, var_val] : vars)
+    {
+        debug_assert(var);
+        if (SCIPvarIsDeleted(var))
+        {
+            SCIP_CALL(SCIPunlockVarCons(scip, var, probdata->vertex_conflicts, FALSE, TRUE));
+            SCIP_CALL(SCIPunlockVarCons(scip, var, probdata->edge_conflicts, FALSE, TRUE));
+            auto vardata = SCIPvarGetData(var);
+            probdata->column_pool[SCIPvardataGetAgent(vardata)].push_back(vardata);
+            SCIP_CALL(SCIPreleaseVar(scip, &var));
+        }
+        else
+        {
+            max_path_length = std::max(max_path_length, SCIPvardataGetPathLength(SCIPvarGetData(var)));
+            vars[nb_vars++] = {var, var_val};
+        }
+    }
+    if (nb_vars == vars.size())
+    {
+        return SCIP_OKAY;
+    }
+    debugln("Removing {} deleted variables", vars.size() - nb_vars);
+    vars.resize(nb_vars);
+    probdata->max_path_length = max_path_length;
+
+    // Remove from the array of variables of each agent.
+    for (auto& agent_vars : probdata->agent_vars)
+    {
+        nb_vars = 0;
+        for (auto& [var, var_val] : agent_vars)
+        {
+            debug_assert(var);
+            if (SCIPvarIsDeleted(var))
+            {
+                SCIP_CALL(SCIPreleaseVar(scip, &var));
+            }
+            else
+            {
+                agent_vars[nb_vars++] = {var, var_val};
+            }
+        }
+        agent_vars.resize(nb_vars);
+    }
+
+    // Free the oldest paths in the column pool of each agent if the pool is full.
+    for (auto& agent_column_pool : probdata->column_pool)
+        if (agent_column_pool.size() > COLUMN_POOL_SIZE)
+        {
+            const auto nb_freed = agent_column_pool.size() - COLUMN_POOL_SIZE;
+            for (size_t idx = 0; idx < nb_freed; ++idx)
+            {
+                SCIPvardataFree(scip, agent_column_pool[idx]);
+            }
+            agent_column_pool.erase(agent_column_pool.begin(), agent_column_pool.begin() + nb_freed);
+        }
+
+    // Renumber the variables propagated by the branching constraints. The variables keep their order, so the variables
+    // propagated by a constraint are the first ones that are kept.
+    SCIPrenumberVertexBranchingVars(scip, nb_kept_vars);
+    SCIPrenumberWaitBranchingVars(scip, nb_kept_vars);
+    SCIPrenumberLengthBranchingVars(scip, nb_kept_vars);
+
+    // Renumber the variables added by primal heuristics. The entries of deleted variables are kept with index -1
+    // so the number of entries seen by the branching constraints stays valid.
+#ifdef USE_LNS2_REPAIR_PRIMAL_HEURISTIC
+    for (auto& v : probdata->heuristic_var_indices)
+    {
+        v = v >= 0 && nb_kept_vars[v + 1] > nb_kept_vars[v] ? nb_kept_vars[v] : -1;
+    }
+#endif
+
+    // Rebuild the index of the vertices visited by the variables.
+    index_all_vars(probdata);
+
+    // Recompute the fractional vertices and edges of every agent in the next update.
+    for (auto& agent_positive_vars : probdata->agent_positive_vars)
+    {
+        agent_positive_vars.clear();
+    }
+    probdata->fractional_makespan = -1;
+
+    // Read the value of every variable in the next update since the indices are renumbered.
+    probdata->var_values_nb_lps = -1;
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Store a two-agent robust cut in the cuts of an agent. The edge-times of the cuts of an agent are copied into one
+// array in order of the cuts so the pricer scans adjacent memory. The array is compacted into a larger array when it
+// is full.
+static
+void add_agent_robust_cut(
+    SCIP_ProbData* probdata,       // Problem data
+    const Agent a,                 // Agent
+    SCIP_ROW* row,                 // Row of the cut
+    const EdgeTime* ets_begin,     // First edge-time of the agent in the cut
+    const EdgeTime* ets_end        // One past the last edge-time of the agent in the cut
+)
+{
+    auto& agent_cuts = probdata->agent_robust_cuts[a];
+    auto& ets = probdata->agent_robust_cut_edge_times[a];
+    const auto nb_ets = static_cast<size_t>(ets_end - ets_begin);
+
+    // Move the edge-times into a larger array.
+    if (ets.size() + nb_ets > ets.capacity())
+    {
+        Vector<EdgeTime> new_ets;
+        new_ets.reserve(std::max(2 * ets.capacity(), ets.size() + nb_ets));
+        for (auto& cut : agent_cuts)
+        {
+            const auto begin = new_ets.size();
+            new_ets.insert(new_ets.end(), cut.begin, cut.end);
+            cut.begin = new_ets.data() + begin;
+            cut.end = new_ets.data() + new_ets.size();
+        }
+        ets = std::move(new_ets);
+    }
+
+    // Append the edge-times.
+    const auto begin = ets.size();
+    ets.insert(ets.end(), ets_begin, ets_end);
+    agent_cuts.push_back(AgentRobustCut{row, ets.data() + begin, ets.data() + ets.size()});
+
+    // Index the edge-times for finding the coefficients of new columns.
+    const auto idx = static_cast<Int>(agent_cuts.size()) - 1;
+    const auto goal = probdata->instance->agents[a].goal;
+    auto& index = probdata->agent_robust_cut_index[a];
+    for (auto it = ets_begin; it != ets_end; ++it)
+    {
+        index[*it].push_back(idx);
+        if (it->n == goal && it->d == Direction::WAIT)
+        {
+            probdata->agent_robust_cut_goal_waits[a].emplace_back(it->t, idx);
+        }
+    }
+}
+
+// Add a new two-agent robust cut to the LP
+static
+SCIP_RETCODE add_two_agent_robust_cut(
+    SCIP* scip,                 // SCIP
+    SCIP_ProbData* probdata,    // Problem data
+    SCIP_SEPA* sepa,            // Separator
+    TwoAgentRobustCut&& cut,    // Data for the cut
+    const SCIP_Real rhs,        // RHS
+    SCIP_RESULT* result,        // Output result
+    Int* idx                    // Output index of the cut
+)
+{
+    // Create a row. The row is removable from the LP if inactive cuts are aged out.
+    int age_limit;
+    scip_assert(SCIPgetIntParam(scip, ROBUST_CUT_AGE_LIMIT_PARAM, &age_limit));
+    SCIP_ROW* row = nullptr;
+    SCIP_CALL(SCIPcreateEmptyRowSepa(scip,
+                                     &row,
+                                     sepa,
+                                     "",
+                                     -SCIPinfinity(scip),
+                                     rhs,
+                                     FALSE,
+                                     TRUE,
+                                     age_limit >= 0));
+    debug_assert(row);
+    cut.set_row(row);
+
+    // Get variables.
+    const auto& vars = probdata->vars;
+    const auto& agents = SCIPprobdataGetAgentsData(probdata);
+
+    // Add variables to the constraint.
+#ifdef DEBUG
+    SCIP_Real lhs = 0.0;
+#endif
+    SCIP_CALL(SCIPcacheRowExtensions(scip, row));
+    const auto iterators = cut.iterators();
+    Vector<Int> var_indices;
+    for (const auto& [a, ets_begin, ets_end] : iterators)
+    {
+        // Find the columns of the agent visiting the vertices of the cut. Paths are not indexed at the times they wait
+        // at the goal after their end, so every column of the agent is read if the cut has a wait at the goal.
+        const auto goal = agents[a].goal;
+        const auto is_goal_wait = [goal](const EdgeTime et) { return et.n == goal && et.d == Direction::WAIT; };
+        if (std::any_of(ets_begin, ets_end, is_goal_wait))
+        {
+            var_indices = probdata->agent_var_indices[a];
+        }
+        else
+        {
+            var_indices.clear();
+            for (auto it = ets_begin; it != ets_end; ++it)
+                for (const auto v : SCIPprobdataGetVertexVarIndices(probdata, it->nt()))
+                    if (SCIPvardataGetAgent(SCIPvarGetData(vars[v].first)) == a)
+                    {
+                        var_indices.push_back(v);
+                    }
+            std::sort(var_indices.begin(), var_indices.end());
+            var_indices.erase(std::unique(var_indices.begin(), var_indices.end()), var_indices.end());
+        }
+
+        // Add the columns.
+        for (const auto v : var_indices)
+        {
+            const auto& [var, var_val] = vars[v];
+            debug_assert(var);
+            debug_assert(var_val == SCIPgetSolVal(scip, nullptr, var));
+
+            // Get the path.
+            auto vardata = SCIPvarGetData(var);
+            debug_assert(a == SCIPvardataGetAgent(vardata));
+            const auto path_length = SCIPvardataGetPathLength(vardata);
+            const auto path = SCIPvardataGetPath(vardata);
+
+            // Add coefficient.
+            const auto coeff = get_robust_cut_coeff(path_length, path, ets_begin, ets_end);
             if (coeff)
             {
                 // Add coefficient.
@@ -1025,6 +1423,7 @@ SCIP_RETCODE SCIPprobdataAddTwoAgentRobustCut(
                         format_path_spaced(SCIPgetProbData(scip), path_length, path));
             }
         }
+    }
     SCIP_CALL(SCIPflushRowExtensions(scip, row));
 #ifdef DEBUG
     debug_assert(SCIPisSumGT(scip, lhs, rhs));
@@ -1114,7 +1513,7 @@ SCIP_RETCODE SCIPprobdataAddTwoAgentRobustCut(
     // Store the cut in the set of cuts specific to an agent.
     for (const auto& [a, ets_begin, ets_end] : iterators)
     {
-        probdata->agent_robust_cuts[a].push_back(AgentRobustCut{cut.row(), ets_begin, ets_end});
+        add_agent_robust_cut(probdata, a, cut.row(), ets_begin, ets_end);
     }
 
     // Store the cut.
@@ -1128,6 +1527,306 @@ SCIP_RETCODE SCIPprobdataAddTwoAgentRobustCut(
     return SCIP_OKAY;
 }
 
+// Add a new two-agent robust cut
+SCIP_RETCODE SCIPprobdataAddTwoAgentRobustCut(
+    SCIP* scip,                 // SCIP
+    SCIP_ProbData* probdata,    // Problem data
+    SCIP_SEPA* sepa,            // Separator
+    TwoAgentRobustCut&& cut,    // Data for the cut
+    const SCIP_Real rhs,        // RHS
+    SCIP_RESULT* result,        // Output result
+    Int* idx                    // Output index of the cut
+)
+{
+    // Add the cut to the LP if the cut selection is disabled or the separator needs the index of the cut.
+    int max_cuts;
+    scip_assert(SCIPgetIntParam(scip, CUT_SELECTION_MAX_CUTS_PARAM, &max_cuts));
+    if (max_cuts < 0 || idx)
+    {
+        return add_two_agent_robust_cut(scip, probdata, sepa, std::move(cut), rhs, result, idx);
+    }
+
+    // Calculate the activity of the cut in the LP solution.
+    const auto& agent_vars = SCIPprobdataGetAgentVars(probdata);
+    SCIP_Real activity = 0.0;
+    for (const auto& [a, ets_begin, ets_end] : cut.iterators())
+        for (const auto& [var, var_val] : agent_vars[a])
+        {
+            debug_assert(var);
+            auto vardata = SCIPvarGetData(var);
+            const auto path_length = SCIPvardataGetPathLength(vardata);
+            const auto path = SCIPvardataGetPath(vardata);
+            activity += var_val * get_robust_cut_coeff(path_length, path, ets_begin, ets_end);
+        }
+    debug_assert(SCIPisSumGT(scip, activity, rhs));
+
+    // Keep the cut for the selection. The coefficients of the cut over its edge-times are all one.
+    const auto efficacy = (activity - rhs) / std::sqrt(static_cast<SCIP_Real>(cut.size()));
+    probdata->separator_schedules[sepa].nb_candidates++;
+    probdata->robust_cut_candidates.push_back({sepa, std::move(cut), rhs, efficacy});
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Count the edge-times shared by two sorted lists of edge-times of the same agent
+static
+Int count_common_edge_times(
+    const Vector<uint64_t>& ets1,    // Sorted IDs of the first edge-times
+    const Vector<uint64_t>& ets2     // Sorted IDs of the second edge-times
+)
+{
+    Int nb_common = 0;
+    for (auto it1 = ets1.begin(), it2 = ets2.begin(); it1 != ets1.end() && it2 != ets2.end();)
+    {
+        if (*it1 < *it2)
+        {
+            ++it1;
+        }
+        else if (*it2 < *it1)
+        {
+            ++it2;
+        }
+        else
+        {
+            ++nb_common;
+            ++it1;
+            ++it2;
+        }
+    }
+    return nb_common;
+}
+
+// Add the most efficacious two-agent robust cuts that are not nearly parallel to a cut added before them
+SCIP_RETCODE SCIPprobdataAddSelectedTwoAgentRobustCuts(
+    SCIP* scip,                 // SCIP
+    SCIP_ProbData* probdata,    // Problem data
+    SCIP_RESULT* result         // Output result
+)
+{
+    // Check.
+    auto& candidates = probdata->robust_cut_candidates;
+    if (candidates.empty())
+    {
+        return SCIP_OKAY;
+    }
+
+    // Get parameters.
+    int max_cuts;
+    SCIP_Real max_parallelism;
+    scip_assert(SCIPgetIntParam(scip, CUT_SELECTION_MAX_CUTS_PARAM, &max_cuts));
+    scip_assert(SCIPgetRealParam(scip, CUT_SELECTION_MAX_PARALLELISM_PARAM, &max_parallelism));
+    const auto nb_candidates = static_cast<Int>(candidates.size());
+    if (max_cuts == 0)
+    {
+        max_cuts = nb_candidates;
+    }
+
+    // Sort the candidates by decreasing efficacy.
+    Vector<Int> order(nb_candidates);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&candidates](const Int idx1, const Int idx2)
+    {
+        return candidates[idx1].efficacy > candidates[idx2].efficacy;
+    });
+
+    // Get the sorted edge-times of each agent in each candidate.
+    Vector<Array<Vector<uint64_t>, 2>> supports(nb_candidates);
+    for (Int idx = 0; idx < nb_candidates; ++idx)
+    {
+        const auto& cut = candidates[idx].cut;
+        Int side = 0;
+        for (const auto& [a, ets_begin, ets_end] : cut.iterators())
+        {
+            auto& ets = supports[idx][side++];
+            for (auto it = ets_begin; it != ets_end; ++it)
+            {
+                ets.push_back(it->id);
+            }
+            std::sort(ets.begin(), ets.end());
+        }
+    }
+
+    // Select the cuts greedily. The parallelism of two cuts is the cosine of the angle between their coefficients
+    // over the edge-times of each agent.
+    Vector<Int> selected;
+    for (const auto idx : order)
+    {
+        if (static_cast<Int>(selected.size()) >= max_cuts)
+        {
+            break;
+        }
+        const auto& cut = candidates[idx].cut;
+        const Array<Agent, 2> agents{cut.a1(), cut.a2()};
+        bool is_parallel = false;
+        for (const auto other_idx : selected)
+        {
+            const auto& other_cut = candidates[other_idx].cut;
+            const Array<Agent, 2> other_agents{other_cut.a1(), other_cut.a2()};
+            Int nb_common = 0;
+            for (Int side = 0; side < 2; ++side)
+                for (Int other_side = 0; other_side < 2; ++other_side)
+                    if (agents[side] == other_agents[other_side])
+                    {
+                        nb_common += count_common_edge_times(supports[idx][side], supports[other_idx][other_side]);
+                    }
+            if (nb_common > 0 &&
+                nb_common > max_parallelism * std::sqrt(static_cast<SCIP_Real>(cut.size()) * other_cut.size()))
+            {
+                is_parallel = true;
+                break;
+            }
+        }
+        if (!is_parallel)
+        {
+            selected.push_back(idx);
+        }
+    }
+    debugln("   Selected {} of {} two-agent robust cuts", selected.size(), nb_candidates);
+
+    // Add the selected cuts.
+    for (const auto idx : selected)
+    {
+        auto& candidate = candidates[idx];
+        SCIP_RESULT cut_result;
+        SCIP_CALL(add_two_agent_robust_cut(scip,
+                                           probdata,
+                                           candidate.sepa,
+                                           std::move(candidate.cut),
+                                           candidate.rhs,
+                                           &cut_result,
+                                           nullptr));
+        if (*result != SCIP_CUTOFF)
+        {
+            *result = cut_result;
+        }
+        candidate.sepa = nullptr;
+    }
+
+    // Discard the rest.
+    SCIPprobdataClearTwoAgentRobustCutCandidates(scip, probdata);
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Discard the two-agent robust cuts waiting for the cut selection
+void SCIPprobdataClearTwoAgentRobustCutCandidates(
+    SCIP* scip,                 // SCIP
+    SCIP_ProbData* probdata     // Problem data
+)
+{
+    // Free the edge-times of the candidates that are not added. The added candidates are marked by a null separator.
+    for (auto& candidate : probdata->robust_cut_candidates)
+        if (candidate.sepa)
+        {
+            auto ptr = candidate.cut.begin();
+            const auto size = candidate.cut.size();
+            SCIPfreeBlockMemoryArray(scip, &ptr, size);
+        }
+    probdata->robust_cut_candidates.clear();
+}
+
+// Age the two-agent robust cuts with zero dual and remove the cuts that have been inactive for too many rounds
+SCIP_RETCODE SCIPprobdataAgeTwoAgentRobustCuts(
+    SCIP* scip,                 // SCIP
+    SCIP_ProbData* probdata     // Problem data
+)
+{
+    // Check if aging is enabled.
+    int age_limit;
+    scip_assert(SCIPgetIntParam(scip, ROBUST_CUT_AGE_LIMIT_PARAM, &age_limit));
+    if (age_limit < 0)
+    {
+        return SCIP_OKAY;
+    }
+
+    // Age the cuts. A cut is inactive if its row is not in the LP or its dual is zero.
+    auto& cuts = probdata->two_agent_robust_cuts;
+    bool has_expired = false;
+    for (auto& cut : cuts)
+    {
+        auto row = cut.row();
+        if (SCIProwIsInLP(row) && !SCIPisFeasZero(scip, SCIProwGetDualsol(row)))
+        {
+            cut.set_age(0);
+        }
+        else
+        {
+            cut.set_age(cut.age() + 1);
+            has_expired |= cut.age() > age_limit;
+        }
+    }
+    if (!has_expired)
+    {
+        return SCIP_OKAY;
+    }
+
+    // Remove the expired cuts and compact the remaining cuts. New columns are no longer added to the row of a removed
+    // cut. This is valid because a subset of the columns in a cut with non-negative coefficients still forms a valid
+    // cut, so the row can stay in LPs of other nodes until SCIP discards it.
+    Vector<Int> new_idx(cuts.size(), -1);
+    Int nb_kept = 0;
+    for (Int idx = 0; idx < static_cast<Int>(cuts.size()); ++idx)
+    {
+        auto& cut = cuts[idx];
+        if (cut.age() > age_limit)
+        {
+            // Free the edge-times and the row.
+            debugln("   Removing two-agent robust cut {} after {} inactive rounds",
+                    SCIProwGetName(cut.row()),
+                    cut.age());
+            auto ptr = cut.begin();
+            const auto size = cut.size();
+            SCIPfreeBlockMemoryArray(scip, &ptr, size);
+            auto row = cut.row();
+            SCIP_CALL(SCIPreleaseRow(scip, &row));
+        }
+        else
+        {
+            // Keep the cut.
+            new_idx[idx] = nb_kept;
+            if (nb_kept != idx)
+            {
+                cuts[nb_kept] = std::move(cut);
+            }
+            ++nb_kept;
+        }
+    }
+    cuts.erase(cuts.begin() + nb_kept, cuts.end());
+
+    // Rebuild the cuts grouped by agent.
+    for (auto& agent_cuts : probdata->agent_robust_cuts)
+    {
+        agent_cuts.clear();
+    }
+    for (auto& ets : probdata->agent_robust_cut_edge_times)
+    {
+        ets.clear();
+    }
+    for (auto& index : probdata->agent_robust_cut_index)
+    {
+        index.clear();
+    }
+    for (auto& goal_waits : probdata->agent_robust_cut_goal_waits)
+    {
+        goal_waits.clear();
+    }
+    for (const auto& cut : cuts)
+        for (const auto& [a, ets_begin, ets_end] : cut.iterators())
+        {
+            add_agent_robust_cut(probdata, a, cut.row(), ets_begin, ets_end);
+        }
+
+    // Update the indices of rectangle knapsack cuts.
+#ifdef USE_RECTANGLE_KNAPSACK_CONFLICTS
+    rectangle_knapsack_remap_cuts(probdata, new_idx);
+#endif
+
+    // Done.
+    return SCIP_OKAY;
+}
+
 // Create the problem
 SCIP_RETCODE SCIPprobdataCreate(
     SCIP* scip,                       // SCIP
@@ -1203,6 +1902,13 @@ SCIP_RETCODE SCIPprobdataCreate(
     // Copy model data.
     probdata->pricerdata = nullptr;
     probdata->astar = astar;
+    probdata->deletable_vars = false;
+    probdata->conflict_horizon = std::numeric_limits<Time>::max();
+    probdata->max_path_length = 0;
+    probdata->makespan = 0;
+    probdata->agent_makespan.resize(N);
+    probdata->var_values_nb_lps = -1;
+    probdata->var_values_node = -1;
 
     // Create agent partition constraints.
     probdata->agent_part.resize(N);
@@ -1271,6 +1977,44 @@ SCIP_RETCODE SCIPprobdataCreate(
     // Include separator for preprocessing dummy constraint.
     SCIP_CALL(SCIPincludeSepaPreprocessing(scip));
 
+    // Include separator for selecting the two-agent robust cuts.
+    SCIP_CALL(SCIPincludeSepaCutSelection(scip));
+
+    // Add parameter for finding cuts in parallel.
+    SCIP_CALL(SCIPaddParamSeparationThreads(scip));
+
+    // Add parameter for skipping separators that rarely find cuts.
+    SCIP_CALL(SCIPaddParamSeparationScheduling(scip));
+
+    // Add parameters for recording the input of the separators.
+    SCIP_CALL(SCIPaddParamsSeparationLog(scip));
+
+    // Add parameter for removing inactive two-agent robust cuts.
+    SCIP_CALL(SCIPaddIntParam(scip,
+                              ROBUST_CUT_AGE_LIMIT_PARAM,
+                              "number of consecutive pricing rounds with zero dual after which a two-agent robust cut "
+                              "is removed (-1: never remove)",
+                              nullptr,
+                              FALSE,
+                              DEFAULT_ROBUST_CUT_AGE_LIMIT,
+                              -1,
+                              INT_MAX,
+                              nullptr,
+                              nullptr));
+
+    // Add parameter for ignoring conflicts after a time.
+    SCIP_CALL(SCIPaddIntParam(scip,
+                              CONFLICT_HORIZON_PARAM,
+                              "time from which conflicts between the agents are neither separated nor checked "
+                              "(-1: never ignore)",
+                              nullptr,
+                              FALSE,
+                              DEFAULT_CONFLICT_HORIZON,
+                              -1,
+                              INT_MAX,
+                              nullptr,
+                              nullptr));
+
     // Include separator for rectangle knapsack conflicts.
 #ifdef USE_RECTANGLE_KNAPSACK_CONFLICTS
     SCIP_CALL(SCIPincludeSepaRectangleKnapsackConflicts(scip, &probdata->rectangle_knapsack_conflicts));
@@ -1385,13 +2129,9 @@ SCIP_RETCODE SCIPprobdataCreate(
     // Include branching rule.
     SCIP_CALL(SCIPincludeBranchrule(scip));
     SCIP_CALL(SCIPincludeConshdlrVertexBranching(scip));
-//    SCIP_CALL(SCIPincludeConshdlrWaitBranching(scip));
+    SCIP_CALL(SCIPincludeConshdlrWaitBranching(scip));
     SCIP_CALL(SCIPincludeConshdlrLengthBranching(scip));
-
-    // Include EECBS primal heuristic.
-#ifdef USE_EECBS_PRIMAL_HEURISTIC
-    SCIP_CALL(SCIPincludeHeurEECBS(scip));
-#endif
+    SCIP_CALL(SCIPincludeConshdlrReducedCostFixing(scip));
 
     // Include LNS2 primal heuristic.
 #ifdef USE_LNS2_INIT_PRIMAL_HEURISTIC
@@ -1406,6 +2146,32 @@ SCIP_RETCODE SCIPprobdataCreate(
     SCIP_CALL(SCIPincludeHeurPrioritizedPlanning(scip));
 #endif
 
+    // Include diving primal heuristic.
+#ifdef USE_DIVING_PRIMAL_HEURISTIC
+    SCIP_CALL(SCIPincludeHeurDiving(scip));
+#endif
+
+    // Include checkpoint event handler.
+    SCIP_CALL(SCIPincludeEventhdlrCheckpoint(scip));
+
+    // Include subtree event handler.
+    SCIP_CALL(SCIPincludeEventhdlrSubtree(scip));
+
+    // Include solution stream event handler.
+    SCIP_CALL(SCIPincludeEventhdlrSolutionStream(scip));
+
+    // Include anytime event handler.
+    SCIP_CALL(SCIPincludeEventhdlrAnytime(scip));
+
+    // Include memory usage event handler.
+    SCIP_CALL(SCIPincludeEventhdlrMemoryUsage(scip));
+
+    // Include trace event handler.
+    SCIP_CALL(SCIPincludeEventhdlrTrace(scip));
+
+    // Include node log event handler.
+    SCIP_CALL(SCIPincludeEventhdlrNodeLog(scip));
+
     // Add callbacks.
     SCIP_CALL(SCIPsetProbTrans(scip, probtrans));
     SCIP_CALL(SCIPsetProbDelorig(scip, probdelorig));
@@ -1434,6 +2200,17 @@ Vector<Pair<SCIP_VAR*, SCIP_Real>>& SCIPprobdataGetVars(
     return probdata->vars;
 }
 
+// Get the index in the array of all variables of the variables added by primal heuristics
+#ifdef USE_LNS2_REPAIR_PRIMAL_HEURISTIC
+const Vector<Int>& SCIPprobdataGetHeuristicVarIndices(
+    SCIP_ProbData* probdata    // Problem data
+)
+{
+    debug_assert(probdata);
+    return probdata->heuristic_var_indices;
+}
+#endif
+
 // Get array of variables for each agent
 Vector<Vector<Pair<SCIP_VAR*, SCIP_Real>>>& SCIPprobdataGetAgentVars(
     SCIP_ProbData* probdata    // Problem data
@@ -1443,6 +2220,57 @@ Vector<Vector<Pair<SCIP_VAR*, SCIP_Real>>>& SCIPprobdataGetAgentVars(
     return probdata->agent_vars;
 }
 
+// Get the index in the array of all variables of the variables of each agent in increasing order
+const Vector<Vector<Int>>& SCIPprobdataGetAgentVarIndices(
+    SCIP_ProbData* probdata    // Problem data
+)
+{
+    debug_assert(probdata);
+    return probdata->agent_var_indices;
+}
+
+// Find the variable of an agent with a path, or nullptr if the path has no column
+SCIP_VAR* SCIPprobdataFindVar(
+    SCIP_ProbData* probdata,    // Problem data
+    const Agent a,              // Agent
+    const Time path_length,     // Path length
+    const Edge* const path      // Path
+)
+{
+    debug_assert(probdata);
+    return find_var(probdata, a, path_length, path);
+}
+
+// Get the number of paths rejected because their column already exists
+SCIP_Longint SCIPprobdataGetNDuplicateColumns(
+    SCIP_ProbData* probdata    // Problem data
+)
+{
+    debug_assert(probdata);
+    return probdata->nb_duplicate_columns;
+}
+
+// Get the index in the array of all variables of the variables visiting a vertex in increasing order
+const Vector<Int>& SCIPprobdataGetVertexVarIndices(
+    SCIP_ProbData* probdata,    // Problem data
+    const NodeTime nt           // Vertex
+)
+{
+    debug_assert(probdata);
+    static const Vector<Int> empty;
+    auto it = probdata->vertex_var_indices.find(nt);
+    return it != probdata->vertex_var_indices.end() ? it->second : empty;
+}
+
+// Get the paths of the deleted variables of each agent
+Vector<Vector<SCIP_VARDATA*>>& SCIPprobdataGetColumnPool(
+    SCIP_ProbData* probdata    // Problem data
+)
+{
+    debug_assert(probdata);
+    return probdata->column_pool;
+}
+
 // Get agent partition constraints
 Vector<SCIP_CONS*>& SCIPprobdataGetAgentPartConss(
     SCIP_ProbData* probdata    // Problem data
@@ -1578,6 +2406,28 @@ Vector<Vector<Pair<NodeTime, SCIP_ROW*>>>& SCIPprobdataGetCrossingAgentGoalConfl
 }
 #endif
 
+// Get the path length nogoods of each agent with their latest finish time
+#ifdef USE_PATH_LENGTH_NOGOODS
+Vector<Vector<Pair<Time, SCIP_ROW*>>>& SCIPprobdataGetAgentPathLengthNogoods(
+    SCIP_ProbData* probdata    // Problem data
+)
+{
+    debug_assert(probdata);
+    return probdata->agent_path_length_nogoods;
+}
+#endif
+
+// Get the variables of other agents visiting the goal of each agent
+#ifdef USE_GOAL_CONFLICTS
+const Vector<Vector<GoalCrossing>>& SCIPprobdataGetGoalCrossings(
+    SCIP_ProbData* probdata    // Problem data
+)
+{
+    debug_assert(probdata);
+    return probdata->goal_crossings;
+}
+#endif
+
 // Get the vertices fractionally used by each agent
 #if defined(USE_THREEVERTEX_CONFLICTS) || defined(USE_VERTEX_FOUREDGE_CONFLICTS)
 const Vector<HashTable<NodeTime, SCIP_Real>>& SCIPprobdataGetFractionalVertices(
@@ -1617,7 +2467,7 @@ const Vector<HashTable<EdgeTime, SCIP_Real>>& SCIPprobdataGetPositiveMoveEdges(
 }
 
 // Get the edges fractionally used by each agent, grouped by edge-time
-const HashTable<EdgeTime, SCIP_Real*>& SCIPprobdataGetFractionalEdgesVec(
+const HashTable<EdgeTime, AgentValues>& SCIPprobdataGetFractionalEdgesVec(
     SCIP_ProbData* probdata    // Problem data
 )
 {
@@ -1625,48 +2475,211 @@ const HashTable<EdgeTime, SCIP_Real*>& SCIPprobdataGetFractionalEdgesVec(
     return probdata->fractional_edges_vec;
 }
 
-// Update the database of fractionally used vertices and edges
-void update_fractional_vertices_and_edges(
-    SCIP* scip    // SCIP
+// Get the agents with a fractional edge starting or ending at a node in the timestep beginning at a time
+const Vector<Agent>& SCIPprobdataGetFractionalAgents(
+    SCIP_ProbData* probdata,    // Problem data
+    const NodeTime nt           // Node-time
 )
 {
-    // Print.
-    debugln("Updating fractional vertices and edges");
+    debug_assert(probdata);
+    static const Vector<Agent> no_agents;
+    const auto it = probdata->fractional_agents.find(nt);
+    return it != probdata->fractional_agents.end() ? it->second : no_agents;
+}
 
-    // Get problem data.
-    auto probdata = SCIPgetProbData(scip);
-    const auto N = SCIPprobdataGetN(probdata);
+// Get the agents with a fractional edge starting or ending at each node-time
+const HashTable<NodeTime, Vector<Agent>>& SCIPprobdataGetFractionalAgentsByNodeTime(
+    SCIP_ProbData* probdata    // Problem data
+)
+{
+    debug_assert(probdata);
+    return probdata->fractional_agents;
+}
 
-    // Get variables.
-    auto& vars = SCIPprobdataGetVars(probdata);
-    auto& agent_vars = SCIPprobdataGetAgentVars(probdata);
+// Get the agents with a fractional edge or visiting a node-time of a fractional edge, sorted in increasing order
+const Vector<Agent>& SCIPprobdataGetActiveAgents(
+    SCIP_ProbData* probdata    // Problem data
+)
+{
+    debug_assert(probdata);
+    return probdata->active_agents;
+}
 
-    // Find the makespan.
-    Time makespan = 0;
-    for (auto& [var, var_val] : vars)
+// Add the memory of the columns, the two-agent robust cuts and the tables of fractional vertices and edges
+void SCIPprobdataGetMemoryUsage(
+    SCIP_ProbData* probdata,    // Problem data
+    MemoryUsage& usage          // Output memory usage
+)
+{
+    debug_assert(probdata);
+
+    // Get the memory of the columns.
+    usage.columns += probdata->path_pool.nb_bytes_allocated();
+    for (const auto& path_hashes : probdata->agent_path_hashes)
     {
-        // Get the path length.
-        debug_assert(var);
-        auto vardata = SCIPvarGetData(var);
-        const auto path_length = SCIPvardataGetPathLength(vardata);
+        usage.columns += hash_table_bytes(path_hashes);
+    }
 
-        // Get the variable value.
-        var_val = SCIPgetSolVal(scip, nullptr, var);
+    // Get the memory of the cuts.
+    usage.robust_cuts += vector_bytes(probdata->two_agent_robust_cuts);
+    for (const auto& cut : probdata->two_agent_robust_cuts)
+    {
+        usage.robust_cuts += sizeof(EdgeTime) * cut.size();
+    }
+    for (Agent a = 0; a < static_cast<Agent>(probdata->agent_robust_cuts.size()); ++a)
+    {
+        usage.robust_cuts += vector_bytes(probdata->agent_robust_cuts[a]) +
+                             vector_bytes(probdata->agent_robust_cut_edge_times[a]) +
+                             hash_table_bytes(probdata->agent_robust_cut_index[a]) +
+                             vector_bytes(probdata->agent_robust_cut_goal_waits[a]);
+        for (const auto& [et, cut_indices] : probdata->agent_robust_cut_index[a])
+        {
+            usage.robust_cuts += vector_bytes(cut_indices);
+        }
+    }
 
-        // Store the length of the longest path.
-        if (path_length > makespan && SCIPisPositive(scip, var_val))
+    // Get the memory of the fractional vertices and edges.
+    const auto tables_bytes = [](const auto& tables)
+    {
+        size_t nb_bytes = 0;
+        for (const auto& table : tables)
         {
-            makespan = path_length;
+            nb_bytes += hash_table_bytes(table);
         }
+        return nb_bytes;
+    };
+#if defined(USE_THREEVERTEX_CONFLICTS) || defined(USE_VERTEX_FOUREDGE_CONFLICTS)
+    usage.fractional_edges += tables_bytes(probdata->fractional_vertices);
+#endif
+    usage.fractional_edges += tables_bytes(probdata->fractional_edges);
+    usage.fractional_edges += tables_bytes(probdata->fractional_move_edges);
+    usage.fractional_edges += tables_bytes(probdata->positive_move_edges);
+    usage.fractional_edges += hash_table_bytes(probdata->fractional_edges_vec);
+    usage.fractional_edges += vector_bytes(probdata->fractional_edges_entries);
+    usage.fractional_edges += vector_bytes(probdata->fractional_edges_vals);
+    usage.fractional_edges += hash_table_bytes(probdata->fractional_agents);
+    for (const auto& [_, agents] : probdata->fractional_agents)
+    {
+        usage.fractional_edges += vector_bytes(agents);
     }
+    usage.fractional_edges += vector_bytes(probdata->active_agents);
+}
 
-    // Free allocations.
-    auto& fractional_edges_vec = probdata->fractional_edges_vec;
-    for (auto& [_, ptr] : fractional_edges_vec)
+// Organise the fractional edges of every agent by edge-time and find the agents at every node-time
+void index_fractional_edges(
+    const Map& map,                                                    // Map
+    const Vector<HashTable<EdgeTime, SCIP_Real>>& fractional_edges,    // Edges fractionally used by each agent
+    HashTable<EdgeTime, AgentValues>& fractional_edges_vec,            // Output values of each edge by agent
+    Vector<AgentValue>& fractional_edges_entries,                      // Output storage of the sparse values
+    Vector<SCIP_Real>& fractional_edges_vals,                          // Output storage of the dense values
+    HashTable<NodeTime, Vector<Agent>>& fractional_agents              // Output agents at each node-time
+)
+{
+    // Clear.
+    const Agent N = fractional_edges.size();
+    fractional_edges_vec.clear();
+    fractional_agents.clear();
+
+    // Count the agents of each edge.
+    for (Agent a = 0; a < N; ++a)
+        for (const auto& [et, _] : fractional_edges[a])
+        {
+            ++fractional_edges_vec[et].size;
+        }
+
+    // Store the values of all edges in two buffers reused across updates. An edge used by many agents stores the
+    // values of all agents so that the buffers grow with the number of agents using each edge instead of the number
+    // of agents.
     {
-        SCIPfreeBlockMemoryArray(scip, &ptr, N);
+        size_t nb_entries = 0;
+        size_t nb_vals = 0;
+        for (const auto& [_, vals] : fractional_edges_vec)
+        {
+            if (AgentValues::is_dense(vals.size, N))
+            {
+                nb_vals += N;
+            }
+            else
+            {
+                nb_entries += vals.size;
+            }
+        }
+        fractional_edges_entries.resize(nb_entries);
+        fractional_edges_vals.assign(nb_vals, 0.0);
     }
+    {
+        auto entries_ptr = fractional_edges_entries.data();
+        auto vals_ptr = fractional_edges_vals.data();
+        for (auto& [_, vals] : fractional_edges_vec)
+        {
+            if (AgentValues::is_dense(vals.size, N))
+            {
+                vals.dense = vals_ptr;
+                vals_ptr += N;
+            }
+            else
+            {
+                vals.entries = entries_ptr;
+                entries_ptr += vals.size;
+                vals.size = 0;
+            }
+        }
+    }
+    for (Agent a = 0; a < N; ++a)
+        for (const auto& [et, val] : fractional_edges[a])
+        {
+            // Store the value. Agents are visited in order so the lists stay sorted.
+            auto& vals = fractional_edges_vec.at(et);
+            if (vals.dense)
+            {
+                vals.dense[a] = val;
+            }
+            else
+            {
+                vals.entries[vals.size++] = AgentValue{a, val};
+            }
+
+            // Store the agent at both ends of the edge.
+            for (const auto n : Array<Node, 2>{et.n, map.get_destination(et)})
+            {
+                auto& agents = fractional_agents[NodeTime{n, et.t}];
+                if (agents.empty() || agents.back() != a)
+                {
+                    agents.push_back(a);
+                }
+            }
+        }
+}
+
+// Update the database of fractionally used vertices and edges
+void update_fractional_vertices_and_edges(
+    SCIP* scip    // SCIP
+)
+{
+    // Print.
+    debugln("Updating fractional vertices and edges");
+
+    // Get problem data.
+    auto probdata = SCIPgetProbData(scip);
+    const auto N = SCIPprobdataGetN(probdata);
+
+    // Update variable values and get the makespan.
+    update_variable_values(scip);
+    const auto& agent_vars = SCIPprobdataGetAgentVars(probdata);
+    const auto makespan = SCIPprobdataGetMakespan(probdata);
+    const auto conflict_horizon = SCIPprobdataGetConflictHorizon(probdata);
+
+    // Clear the edges organised by edge.
+    auto& fractional_edges_vec = probdata->fractional_edges_vec;
     fractional_edges_vec.clear();
+    auto& fractional_agents = probdata->fractional_agents;
+    fractional_agents.clear();
+    const auto& map = SCIPprobdataGetMap(probdata);
+
+    // Check if the makespan changed. The fractional paths of every agent are extended to the makespan so every agent
+    // needs to be recomputed.
+    const auto makespan_changed = (makespan != probdata->fractional_makespan);
+    probdata->fractional_makespan = makespan;
 
     // Get vertices of each agent.
 #if defined(USE_THREEVERTEX_CONFLICTS) || defined(USE_VERTEX_FOUREDGE_CONFLICTS)
@@ -1675,41 +2688,59 @@ void update_fractional_vertices_and_edges(
     auto& fractional_edges = probdata->fractional_edges;
     auto& fractional_move_edges = probdata->fractional_move_edges;
     auto& positive_move_edges = probdata->positive_move_edges;
-    for (Agent a = 0; a < N; ++a)
+
+    // Update the agents in parallel. The agents only read SCIP and write their own tables.
+    const auto update_agent = [&](const Agent a)
     {
-        // Clear data from previous iteration.
+        // Get the columns of the agent with positive value.
+        Vector<Pair<SCIP_VAR*, SCIP_Real>> positive_vars;
+        for (const auto& [var, var_val] : agent_vars[a])
+        {
+            if (SCIPisPositive(scip, var_val))
+            {
+                positive_vars.emplace_back(var, var_val);
+            }
+        }
+
+        // Get vertices and edges of the agent.
 #if defined(USE_THREEVERTEX_CONFLICTS) || defined(USE_VERTEX_FOUREDGE_CONFLICTS)
         auto& agent_fractional_vertices = fractional_vertices[a];
-        agent_fractional_vertices.clear();
 #endif
-
-        // Clear data from previous iteration.
         auto& agent_fractional_edges = fractional_edges[a];
-        agent_fractional_edges.clear();
-
-        // Clear data from previous iteration.
         auto& agent_fractional_move_edges = fractional_move_edges[a];
-        agent_fractional_move_edges.clear();
-
-        // Clear data from previous iteration.
         auto& agent_positive_move_edges = positive_move_edges[a];
-        agent_positive_move_edges.clear();
 
-        // Calculate the number of times a vertex is used by summing the columns.
-        for (auto& [var, var_val] : agent_vars[a])
+        // Recompute the vertices and edges of the agent only if its columns changed value since the last update.
+        auto& agent_positive_vars = probdata->agent_positive_vars[a];
+        if (makespan_changed || positive_vars != agent_positive_vars)
         {
-            // Get the path.
-            debug_assert(var);
-            const auto vardata = SCIPvarGetData(var);
-            const auto path_length = SCIPvardataGetPathLength(vardata);
-            const auto path = SCIPvardataGetPath(vardata);
+            std::swap(agent_positive_vars, positive_vars);
 
-            // Proceed for paths with positive value.
-            var_val = SCIPgetSolVal(scip, nullptr, var);
-            if (SCIPisPositive(scip, var_val))
+            // Clear data from previous iteration.
+#if defined(USE_THREEVERTEX_CONFLICTS) || defined(USE_VERTEX_FOUREDGE_CONFLICTS)
+            agent_fractional_vertices.clear();
+#endif
+
+            // Clear data from previous iteration.
+            agent_fractional_edges.clear();
+
+            // Clear data from previous iteration.
+            agent_fractional_move_edges.clear();
+
+            // Clear data from previous iteration.
+            agent_positive_move_edges.clear();
+
+            // Calculate the number of times a vertex is used by summing the columns.
+            for (const auto& [var, var_val] : agent_positive_vars)
             {
+                // Get the path.
+                debug_assert(var);
+                const auto vardata = SCIPvarGetData(var);
+                const auto path_length = SCIPvardataGetPathLength(vardata);
+                const auto path = SCIPvardataGetPath(vardata);
+
                 // Store the positive vertices.
-                for (Time t = 0; t < path_length - 1; ++t)
+                for (Time t = 0; t < std::min(path_length - 1, conflict_horizon); ++t)
                     if (path[t].d != Direction::WAIT)
                     {
                         const EdgeTime et{path[t], t};
@@ -1773,70 +2804,63 @@ void update_fractional_vertices_and_edges(
 #endif
                 }
             }
-        }
 
-        // Delete vertices with integer values.
+            // Delete vertices with integer values and after the conflict horizon.
 #if defined(USE_THREEVERTEX_CONFLICTS) || defined(USE_VERTEX_FOUREDGE_CONFLICTS)
-        for (auto it = agent_fractional_vertices.begin(); it != agent_fractional_vertices.end();)
-        {
-            const auto& [nt, val] = *it;
-            if (SCIPisIntegral(scip, val))
-            {
-                it = agent_fractional_vertices.erase(it);
-            }
-            else
+            for (auto it = agent_fractional_vertices.begin(); it != agent_fractional_vertices.end();)
             {
-                ++it;
+                const auto& [nt, val] = *it;
+                if (SCIPisIntegral(scip, val) || nt.t >= conflict_horizon)
+                {
+                    it = agent_fractional_vertices.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
             }
-        }
 #endif
 
-        // Delete edges with integer values.
-        for (auto it = agent_fractional_edges.begin(); it != agent_fractional_edges.end();)
-        {
-            const auto& [et, val] = *it;
-            if (SCIPisIntegral(scip, val))
+            // Delete edges with integer values and after the conflict horizon.
+            for (auto it = agent_fractional_edges.begin(); it != agent_fractional_edges.end();)
             {
-                it = agent_fractional_edges.erase(it);
-            }
-            else
-            {
-                // Store the edge in another place, organised by edge.
+                const auto& [et, val] = *it;
+                if (SCIPisIntegral(scip, val) || et.t >= conflict_horizon)
                 {
-                    auto [it, success] = fractional_edges_vec.try_emplace(et, nullptr);
-                    if (success)
-                    {
-                        scip_assert(SCIPallocClearBlockMemoryArray(scip, &it->second, N));
-                    }
-                    it->second[a] += val;
+                    it = agent_fractional_edges.erase(it);
+                }
+                else
+                {
+                    ++it;
                 }
-
-                // Advance to the next edge.
-                ++it;
             }
-        }
 
-        // Delete move edges with integer values.
-        for (auto it = agent_fractional_move_edges.begin(); it != agent_fractional_move_edges.end();)
-        {
-            const auto& [et, val] = *it;
-            if (SCIPisIntegral(scip, val))
+            // Delete move edges with integer values and after the conflict horizon.
+            for (auto it = agent_fractional_move_edges.begin(); it != agent_fractional_move_edges.end();)
             {
-                it = agent_fractional_move_edges.erase(it);
-            }
-            else
-            {
-                ++it;
+                const auto& [et, val] = *it;
+                if (SCIPisIntegral(scip, val) || et.t >= conflict_horizon)
+                {
+                    it = agent_fractional_move_edges.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
             }
         }
+    };
+    for_each_agent_in_parallel(scip, 0, N, update_agent);
 
-        // Print.
-#if defined(USE_THREEVERTEX_CONFLICTS) || defined(USE_VERTEX_FOUREDGE_CONFLICTS)
+    // Print.
 #ifdef PRINT_DEBUG
+    for (Agent a = 0; a < N; ++a)
+    {
+#if defined(USE_THREEVERTEX_CONFLICTS) || defined(USE_VERTEX_FOUREDGE_CONFLICTS)
+        const auto& agent_fractional_vertices = fractional_vertices[a];
         if (!agent_fractional_vertices.empty())
         {
             println("   Fractional vertices for agent {}:", a);
-            const auto& map = SCIPprobdataGetMap(probdata);
             for (const auto [nt, val] : agent_fractional_vertices)
             {
                 const auto [x, y] = map.get_xy(nt.n);
@@ -1844,14 +2868,10 @@ void update_fractional_vertices_and_edges(
             }
         }
 #endif
-#endif
-
-        // Print.
-#ifdef PRINT_DEBUG
+        const auto& agent_fractional_edges = fractional_edges[a];
         if (!agent_fractional_edges.empty())
         {
             println("   Fractional edges used by agent {}:", a);
-            const auto& map = SCIPprobdataGetMap(probdata);
             for (const auto [et, val] : agent_fractional_edges)
             {
                 const auto [x1, y1] = map.get_xy(et.n);
@@ -1859,14 +2879,10 @@ void update_fractional_vertices_and_edges(
                 println("      (({},{}),({},{}),{}) val {:.4f}", x1, y1, x2, y2, et.t, val);
             }
         }
-#endif
-
-        // Print.
-#ifdef PRINT_DEBUG
+        const auto& agent_fractional_move_edges = fractional_move_edges[a];
         if (!agent_fractional_move_edges.empty())
         {
             println("   Fractional move edges used by agent {}:", a);
-            const auto& map = SCIPprobdataGetMap(probdata);
             for (const auto [et, val] : agent_fractional_move_edges)
             {
                 const auto [x1, y1] = map.get_xy(et.n);
@@ -1874,29 +2890,243 @@ void update_fractional_vertices_and_edges(
                 println("      (({},{}),({},{}),{}) val {:.4f}", x1, y1, x2, y2, et.t, val);
             }
         }
+    }
 #endif
+
+    // Store the edges in another place, organised by edge.
+    index_fractional_edges(map,
+                           fractional_edges,
+                           fractional_edges_vec,
+                           probdata->fractional_edges_entries,
+                           probdata->fractional_edges_vals,
+                           fractional_agents);
+
+    // Find the active agents. An integral agent whose path avoids every node-time of the fractional edges cannot
+    // appear in a violated cut with another agent, so the separators only need to check the agents with a fractional
+    // edge and the integral agents meeting them.
+    auto& active_agents = probdata->active_agents;
+    active_agents.clear();
+    for (Agent a = 0; a < N; ++a)
+    {
+        // Add the agent if it has a fractional edge.
+        if (!fractional_edges[a].empty())
+        {
+            active_agents.push_back(a);
+            continue;
+        }
+
+        // Add the integral agent if its path visits a node-time of a fractional edge. A fractional edge is indexed at
+        // the time it starts so a vertex can also be entered by an edge indexed one timestep earlier.
+        bool is_active = false;
+        for (const auto& [var, _] : probdata->agent_positive_vars[a])
+        {
+            debug_assert(var);
+            const auto vardata = SCIPvarGetData(var);
+            const auto path_length = SCIPvardataGetPathLength(vardata);
+            const auto path = SCIPvardataGetPath(vardata);
+            for (Time t = 0; t < std::max(path_length, makespan) && !is_active; ++t)
+            {
+                const auto n = path[std::min(t, path_length - 1)].n;
+                is_active = fractional_agents.find(NodeTime{n, t}) != fractional_agents.end() ||
+                            (t > 0 && fractional_agents.find(NodeTime{n, t - 1}) != fractional_agents.end());
+            }
+        }
+        if (is_active)
+        {
+            active_agents.push_back(a);
+        }
     }
 }
 
 // Update the arrays of variable values
+// Set the value of a variable in the array of all variables and of its agent
+static inline
+void set_variable_value(
+    SCIP_ProbData* probdata,    // Problem data
+    const Int v,                // Index of the variable in the array of all variables
+    const Int agent_v,          // Index of the variable in the array of its agent
+    const SCIP_Real var_val     // Value of the variable
+)
+{
+    auto& [var, val] = probdata->vars[v];
+    val = var_val;
+    const auto a = SCIPvardataGetAgent(SCIPvarGetData(var));
+    debug_assert(probdata->agent_vars[a][agent_v].first == var);
+    probdata->agent_vars[a][agent_v].second = var_val;
+}
+
+// Read the value of every variable
+static
+void read_all_variable_values(
+    SCIP* scip,                // SCIP
+    SCIP_ProbData* probdata    // Problem data
+)
+{
+    auto& nonzero_var_indices = probdata->nonzero_var_indices;
+    nonzero_var_indices.clear();
+    auto& vars = probdata->vars;
+    for (Int v = 0; v < static_cast<Int>(vars.size()); ++v)
+    {
+        auto& [var, var_val] = vars[v];
+        var_val = SCIPgetSolVal(scip, nullptr, var);
+        if (var_val != 0.0)
+        {
+            nonzero_var_indices.push_back(v);
+        }
+    }
+    for (auto& agent_vars : probdata->agent_vars)
+        for (auto& [var, var_val] : agent_vars)
+        {
+            var_val = SCIPgetSolVal(scip, nullptr, var);
+        }
+}
+
+// Read the value of the variables whose value can change from the last update, which are the variables nonzero in
+// the last update and the basic columns of the LP. The variables are never given a positive lower bound and their
+// upper bound is lazy, so every nonbasic column is zero.
+static
+SCIP_RETCODE read_basic_variable_values(
+    SCIP* scip,                // SCIP
+    SCIP_ProbData* probdata    // Problem data
+)
+{
+    // Zero the variables nonzero in the last update.
+    auto& nonzero_var_indices = probdata->nonzero_var_indices;
+    for (const auto v : nonzero_var_indices)
+    {
+        const auto& [v_, agent_v] = probdata->var_indices.at(probdata->vars[v].first);
+        debug_assert(v_ == v);
+        set_variable_value(probdata, v, agent_v, 0.0);
+    }
+    nonzero_var_indices.clear();
+
+    // Get the basis.
+    SCIP_COL** cols;
+    int nb_cols;
+    SCIP_CALL(SCIPgetLPColsData(scip, &cols, &nb_cols));
+    auto& basis_indices = probdata->basis_indices;
+    basis_indices.resize(SCIPgetNLPRows(scip));
+    SCIP_CALL(SCIPgetLPBasisInd(scip, basis_indices.data()));
+
+    // Read the basic columns. Slack variables and the dummy variables are skipped.
+    for (const auto idx : basis_indices)
+        if (idx >= 0)
+        {
+            debug_assert(idx < nb_cols);
+            auto col = cols[idx];
+            const auto it = probdata->var_indices.find(SCIPcolGetVar(col));
+            if (it != probdata->var_indices.end())
+            {
+                const auto [v, agent_v] = it->second;
+                const auto var_val = SCIPcolGetPrimsol(col);
+                set_variable_value(probdata, v, agent_v, var_val);
+                if (var_val != 0.0)
+                {
+                    nonzero_var_indices.push_back(v);
+                }
+            }
+        }
+
+#ifdef DEBUG
+    // Check.
+    for (const auto& [var, var_val] : probdata->vars)
+    {
+        debug_assert(var_val == SCIPgetSolVal(scip, nullptr, var));
+    }
+#endif
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Update the arrays of variable values. The values are only read once per LP solution. They are read again in every
+// call when there is no LP solution at the current node since the pseudo solution changes with the bounds.
 void update_variable_values(
     SCIP* scip    // SCIP
 )
 {
     auto probdata = SCIPgetProbData(scip);
 
-    auto& vars = SCIPprobdataGetVars(probdata);
-    for (auto& [var, var_val] : vars)
+    // Check if the LP solution is unchanged since the last update. The LP solution is restored without solving an LP
+    // at the end of probing and diving, so the values are read in every call during probing and diving.
+    const auto has_lp_solution = SCIPgetStage(scip) == SCIP_STAGE_SOLVING &&
+                                 SCIPhasCurrentNodeLP(scip) &&
+                                 !SCIPinProbing(scip) &&
+                                 !SCIPinDive(scip);
+    const auto nb_lps = SCIPgetNLPs(scip);
+    const auto node = has_lp_solution ? SCIPnodeGetNumber(SCIPgetCurrentNode(scip)) : -1;
+    if (has_lp_solution && nb_lps == probdata->var_values_nb_lps && node == probdata->var_values_node)
     {
-        var_val = SCIPgetSolVal(scip, nullptr, var);
+        return;
+    }
+
+    // Update the values. Only the variables whose value can change are read if the LP solution is basic.
+    if (has_lp_solution &&
+        probdata->var_values_nb_lps >= 0 &&
+        SCIPgetLPSolstat(scip) == SCIP_LPSOLSTAT_OPTIMAL &&
+        SCIPisLPSolBasic(scip))
+    {
+        SCIP_CALL_ABORT(read_basic_variable_values(scip, probdata));
     }
+    else
+    {
+        read_all_variable_values(scip, probdata);
+    }
+    probdata->var_values_nb_lps = has_lp_solution ? nb_lps : -1;
+    probdata->var_values_node = node;
 
-    auto& agent_vars = SCIPprobdataGetAgentVars(probdata);
-    for (auto& vars : agent_vars)
-        for (auto& [var, var_val] : vars)
+    // Find the longest path with positive value of each agent. Only the paths with positive value are read.
+    auto& agent_makespan = probdata->agent_makespan;
+    std::fill(agent_makespan.begin(), agent_makespan.end(), 0);
+    for (const auto v : probdata->nonzero_var_indices)
+    {
+        const auto& [var, var_val] = probdata->vars[v];
+        if (SCIPisPositive(scip, var_val))
         {
-            var_val = SCIPgetSolVal(scip, nullptr, var);
+            auto vardata = SCIPvarGetData(var);
+            const auto a = SCIPvardataGetAgent(vardata);
+            agent_makespan[a] = std::max(agent_makespan[a], SCIPvardataGetPathLength(vardata));
         }
+    }
+    probdata->makespan = agent_makespan.empty() ? 0 : *std::max_element(agent_makespan.begin(), agent_makespan.end());
+}
+
+// Get the time from which conflicts between the agents are ignored
+Time SCIPprobdataGetConflictHorizon(
+    SCIP_ProbData* probdata    // Problem data
+)
+{
+    debug_assert(probdata);
+    return probdata->conflict_horizon;
+}
+
+// Get the length of the longest path of all variables
+Time SCIPprobdataGetMaxPathLength(
+    SCIP_ProbData* probdata    // Problem data
+)
+{
+    debug_assert(probdata);
+    return probdata->max_path_length;
+}
+
+// Get the length of the longest path with positive value in the LP solution of the last update of the variable values
+Time SCIPprobdataGetMakespan(
+    SCIP_ProbData* probdata    // Problem data
+)
+{
+    debug_assert(probdata);
+    return probdata->makespan;
+}
+
+// Get the length of the longest path of an agent with positive value in the LP solution of the last update of the
+// variable values
+Time SCIPprobdataGetAgentMakespan(
+    SCIP_ProbData* probdata,    // Problem data
+    const Agent a               // Agent
+)
+{
+    debug_assert(probdata);
+    return probdata->agent_makespan[a];
 }
 
 // Get pricer data
@@ -1926,6 +3156,14 @@ bool& SCIPprobdataGetFoundCutsIndicator(
     return probdata->found_cuts;
 }
 
+// Get the measured yield of the separators
+HashTable<SCIP_SEPA*, SeparatorSchedule>& SCIPprobdataGetSeparatorSchedules(
+    SCIP_ProbData* probdata    // Problem data
+)
+{
+    return probdata->separator_schedules;
+}
+
 // Get the scenario path
 const std::filesystem::path& SCIPprobdataGetScenarioPath(
     SCIP_ProbData* probdata    // Problem data
@@ -1953,6 +3191,15 @@ const Map& SCIPprobdataGetMap(
     return probdata->instance->map;
 }
 
+// Get the storage of the variable data of the columns
+PathPool& SCIPprobdataGetPathPool(
+    SCIP_ProbData* probdata    // Problem data
+)
+{
+    debug_assert(probdata);
+    return probdata->path_pool;
+}
+
 // Get the agents data
 const AgentsData& SCIPprobdataGetAgentsData(
     SCIP_ProbData* probdata    // Problem data
@@ -1997,6 +3244,21 @@ String get_move_string(Position curr_x,Position curr_y, Position prev_x, Positio
     return "w";
 }
 
+// Get the coordinates of a node as written to the output files
+Pair<Position, Position> get_output_xy(
+    SCIP_ProbData* probdata,    // Problem data
+    const Node n                // Node
+)
+{
+    const auto& map = SCIPprobdataGetMap(probdata);
+    auto [x, y] = map.get_xy(n);
+#ifdef REMOVE_PADDING
+    --x;
+    --y;
+#endif
+    return {x, y};
+}
+
 // Format path
 String format_path_action(
     SCIP_ProbData* probdata,    // Problem data
@@ -2004,8 +3266,16 @@ String format_path_action(
     const Edge* const path      // Path
 )
 {
-    const auto& map = SCIPprobdataGetMap(probdata);
+    return format_path_action(SCIPprobdataGetMap(probdata), path_length, path);
+}
 
+// Format path
+String format_path_action(
+    const Map& map,             // Map
+    const Time path_length,     // Path length
+    const Edge* const path      // Path
+)
+{
     String str;
     Time t = 1;
     for (; t <= path_length - 1; ++t)
@@ -2078,13 +3348,274 @@ String format_path_spaced(
     return str;
 }
 
-// Write LP relaxation to file
+// Format edge-time
+static String format_edge_time(
+    const Map& map,       // Map
+    const EdgeTime et    // Edge-time
+)
+{
+    auto [x1, y1] = map.get_xy(et.n);
+    auto [x2, y2] = map.get_destination_xy(et);
+#ifdef REMOVE_PADDING
+    --x1;
+    --y1;
+    --x2;
+    --y2;
+#endif
+    return fmt::format("(({},{}),({},{}),{})", x1, y1, x2, y2, et.t);
+}
+
+// Format the name of a two-agent robust cut
+static String format_two_agent_robust_cut_name(
+    SCIP_ProbData* probdata,        // Problem data
+    const TwoAgentRobustCut& cut    // Cut
+)
+{
+    const auto& map = SCIPprobdataGetMap(probdata);
+    auto sepa = SCIProwGetOriginSepa(cut.row());
+    auto str = fmt::format("{}({},{}", sepa ? SCIPsepaGetName(sepa) : "robust_cut", cut.a1(), cut.a2());
+    for (const auto& [a, ets_begin, ets_end] : cut.iterators())
+    {
+        str += ",(";
+        for (auto it = ets_begin; it != ets_end; ++it)
+        {
+            if (it != ets_begin)
+            {
+                str += ",";
+            }
+            str += format_edge_time(map, *it);
+        }
+        str += ")";
+    }
+    str += ")";
+    return str.substr(0, 255);
+}
+
+// Format the name of a row by the constraint or separator that created it
+static String format_row_origin_name(
+    SCIP_ROW* row    // Row
+)
+{
+    const auto cons = SCIProwGetOriginCons(row);
+    const auto sepa = SCIProwGetOriginSepa(row);
+    const auto origin = cons ? SCIPconsGetName(cons) : sepa ? SCIPsepaGetName(sepa) : "row";
+    return fmt::format("{}_{}", origin, SCIProwGetIndex(row));
+}
+
+// Format the name of a column on demand. Columns are created without names because formatting a string for
+// every priced column is expensive.
+String format_var_name(
+    SCIP_ProbData* probdata,    // Problem data
+    SCIP_VAR* var               // Variable
+)
+{
+    // Name path variables by their path.
+    debug_assert(var);
+    auto vardata = SCIPvarGetData(var);
+    if (vardata)
+    {
+        const auto a = SCIPvardataGetAgent(vardata);
+        const auto path_length = SCIPvardataGetPathLength(vardata);
+        const auto path = SCIPvardataGetPath(vardata);
+        return fmt::format("path({},({}))", a, format_path(probdata, path_length, path)).substr(0, 255);
+    }
+
+    // Name artificial variables by their agent.
+    const auto& dummy_vars = SCIPprobdataGetDummyVars(probdata);
+    for (Agent a = 0; a < static_cast<Agent>(dummy_vars.size()); ++a)
+        if (dummy_vars[a] == var)
+        {
+            return fmt::format("dummy_path({})", a);
+        }
+
+    // Name other variables by their index.
+    return fmt::format("var_{}", SCIPvarGetIndex(var));
+}
+
+// Format the name of a row on demand. Robust cuts are created without names because formatting a string for
+// every cut is expensive.
+String format_row_name(
+    SCIP_ProbData* probdata,    // Problem data
+    SCIP_ROW* row               // Row
+)
+{
+    // Use the name given when the row was created.
+    debug_assert(row);
+    const String name = SCIProwGetName(row);
+    if (!name.empty())
+    {
+        return name;
+    }
+
+    // Name two-agent robust cuts by their edge-times.
+    const auto& two_agent_robust_cuts = SCIPprobdataGetTwoAgentRobustCuts(probdata);
+    for (const auto& cut : two_agent_robust_cuts)
+        if (cut.row() == row)
+        {
+            return format_two_agent_robust_cut_name(probdata, cut);
+        }
+
+    // Name other rows by their origin.
+    return format_row_origin_name(row);
+}
+
+// Write a term of a linear expression to an LP file
+static void write_lp_term(
+    FILE* f,                  // File
+    const SCIP_Real coeff,    // Coefficient
+    const String& name,       // Variable name
+    size_t& line_length       // Length of the current line
+)
+{
+    // Wrap long lines because LP files have a maximum line length.
+    if (line_length >= 255)
+    {
+        fmt::print(f, "\n     ");
+        line_length = 5;
+    }
+    const auto term = fmt::format(" {} {:.15g} {}", coeff < 0 ? '-' : '+', std::abs(coeff), name);
+    fmt::print(f, "{}", term);
+    line_length += term.size();
+}
+
+// Write LP relaxation to file. Columns and rows without names are named on demand from their data.
 SCIP_RETCODE write_master(
     SCIP* scip    // SCIP
 )
 {
+    // Get problem data.
+    auto probdata = SCIPgetProbData(scip);
+    const auto& two_agent_robust_cuts = SCIPprobdataGetTwoAgentRobustCuts(probdata);
+
+    // Get the LP.
+    debug_assert(SCIPisLPConstructed(scip));
+    SCIP_COL** cols;
+    SCIP_ROW** rows;
+    int nb_cols;
+    int nb_rows;
+    SCIP_CALL(SCIPgetLPColsData(scip, &cols, &nb_cols));
+    SCIP_CALL(SCIPgetLPRowsData(scip, &rows, &nb_rows));
+
+    // Name the columns.
+    HashTable<SCIP_COL*, String> col_names;
+    for (int idx = 0; idx < nb_cols; ++idx)
+    {
+        col_names[cols[idx]] = format_var_name(probdata, SCIPcolGetVar(cols[idx]));
+    }
+
+    // Name the rows. Look up the robust cuts once instead of for every row.
+    HashTable<SCIP_ROW*, const TwoAgentRobustCut*> row_cuts;
+    for (const auto& cut : two_agent_robust_cuts)
+    {
+        row_cuts[cut.row()] = &cut;
+    }
+    Vector<String> row_names(nb_rows);
+    for (int idx = 0; idx < nb_rows; ++idx)
+    {
+        auto row = rows[idx];
+        row_names[idx] = SCIProwGetName(row);
+        if (row_names[idx].empty())
+        {
+            auto it = row_cuts.find(row);
+            row_names[idx] = it != row_cuts.end() ?
+                             format_two_agent_robust_cut_name(probdata, *it->second) :
+                             format_row_origin_name(row);
+        }
+    }
+
+    // Open file.
     static size_t iter = 0;
-    SCIP_CALL(SCIPwriteLP(scip, fmt::format("master_{}.lp", ++iter).c_str()));
+    const auto filename = fmt::format("master_{}.lp", ++iter);
+    auto f = fopen(filename.c_str(), "w");
+    release_assert(f, "Failed to create file to write LP relaxation");
+
+    // Write objective function.
+    fmt::print(f, "\\ LP relaxation at branch-and-bound node {}\n", SCIPnodeGetNumber(SCIPgetCurrentNode(scip)));
+    fmt::print(f, "Minimize\n obj:");
+    {
+        size_t line_length = 5;
+        for (int idx = 0; idx < nb_cols; ++idx)
+        {
+            const auto obj = SCIPcolGetObj(cols[idx]);
+            if (!SCIPisZero(scip, obj))
+            {
+                write_lp_term(f, obj, col_names[cols[idx]], line_length);
+            }
+        }
+    }
+    fmt::print(f, "\n");
+
+    // Write constraints. Ranged rows are split into two constraints.
+    fmt::print(f, "Subject To\n");
+    for (int idx = 0; idx < nb_rows; ++idx)
+    {
+        auto row = rows[idx];
+        const auto constant = SCIProwGetConstant(row);
+        const auto lhs = SCIProwGetLhs(row) - constant;
+        const auto rhs = SCIProwGetRhs(row) - constant;
+        const auto row_cols = SCIProwGetCols(row);
+        const auto row_vals = SCIProwGetVals(row);
+        const auto nb_row_cols = SCIProwGetNNonz(row);
+        const auto write_row = [&](const char* suffix, const char* sense, const SCIP_Real side)
+        {
+            fmt::print(f, " {}{}:", row_names[idx], suffix);
+            size_t line_length = row_names[idx].size() + 3;
+            for (int col_idx = 0; col_idx < nb_row_cols; ++col_idx)
+                if (SCIPcolIsInLP(row_cols[col_idx]))
+                {
+                    write_lp_term(f, row_vals[col_idx], col_names[row_cols[col_idx]], line_length);
+                }
+            fmt::print(f, " {} {:.15g}\n", sense, side);
+        };
+        if (SCIPisEQ(scip, lhs, rhs))
+        {
+            write_row("", "=", rhs);
+        }
+        else if (SCIPisInfinity(scip, -lhs))
+        {
+            write_row("", "<=", rhs);
+        }
+        else if (SCIPisInfinity(scip, rhs))
+        {
+            write_row("", ">=", lhs);
+        }
+        else
+        {
+            write_row("_lhs", ">=", lhs);
+            write_row("_rhs", "<=", rhs);
+        }
+    }
+
+    // Write bounds.
+    fmt::print(f, "Bounds\n");
+    for (int idx = 0; idx < nb_cols; ++idx)
+    {
+        const auto lb = SCIPcolGetLb(cols[idx]);
+        const auto ub = SCIPcolGetUb(cols[idx]);
+        const auto& name = col_names[cols[idx]];
+        if (SCIPisInfinity(scip, -lb) && SCIPisInfinity(scip, ub))
+        {
+            fmt::print(f, " {} free\n", name);
+        }
+        else if (SCIPisInfinity(scip, ub))
+        {
+            fmt::print(f, " {} >= {:.15g}\n", name, lb);
+        }
+        else if (SCIPisInfinity(scip, -lb))
+        {
+            fmt::print(f, " -inf <= {} <= {:.15g}\n", name, ub);
+        }
+        else
+        {
+            fmt::print(f, " {:.15g} <= {} <= {:.15g}\n", lb, name, ub);
+        }
+    }
+    fmt::print(f, "End\n");
+
+    // Close file.
+    fclose(f);
+
+    // Done.
     return SCIP_OKAY;
 }
 
@@ -2130,22 +3661,8 @@ void print_used_paths(
     const auto& agent_vars = SCIPprobdataGetAgentVars(probdata);
     const auto& dummy_vars = SCIPprobdataGetDummyVars(probdata);
 
-    // Calculate makespan.
-    Time makespan = 0;
-    for (Agent a = 0; a < N; ++a)
-        for (const auto& [var, _] : agent_vars[a])
-        {
-            // Get the path length.
-            debug_assert(var);
-            auto vardata = SCIPvarGetData(var);
-            const auto path_length = SCIPvardataGetPathLength(vardata);
-
-            // Compute the makespan.
-            if (makespan < path_length)
-            {
-                makespan = path_length;
-            }
-        }
+    // Get the makespan.
+    const auto makespan = SCIPprobdataGetMaxPathLength(probdata);
 
     // Get fractional vertices.
     HashTable<NodeTime, HashTable<Agent, SCIP_Real>> vertex_times_used;
@@ -23,10 +23,25 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Includes.h"
 #include "Coordinates.h"
 #include "Separator.h"
+#include "PathPool.h"
+#include "MemoryUsage.h"
+#include "AgentValues.h"
 
 #include "trufflehog/Instance.h"
 #include "trufflehog/AStar.h"
 
+#define ROBUST_CUT_AGE_LIMIT_PARAM "separating/mapf/cutagelimit"
+#define CONFLICT_HORIZON_PARAM "constraints/mapf/conflicthorizon"
+
+// Path found by pricing waiting to be added as a column
+struct PricedColumn
+{
+    Agent a;              // Agent
+    Time path_length;     // Path length
+    const Edge* path;     // Path
+    SCIP_VAR* var;        // Output variable of the column
+};
+
 #ifdef USE_GOAL_CONFLICTS
 struct GoalConflict
 {
@@ -37,6 +52,15 @@ struct GoalConflict
 };
 #endif
 
+#ifdef USE_GOAL_CONFLICTS
+struct GoalCrossing
+{
+    Int v;      // Index of the variable in the array of all variables
+    Agent a;    // Agent of the variable
+    Time t;     // Last time the path visits the goal before the path finishes
+};
+#endif
+
 #ifdef USE_PATH_LENGTH_NOGOODS
 struct PathLengthNogood
 {
@@ -83,7 +107,21 @@ SCIP_RETCODE SCIPprobdataAddPricedVar(
     SCIP_VAR** var              // Output new variable
 );
 
-// Add a new two-agent robust cut
+// Add a batch of new variables from pricing
+SCIP_RETCODE SCIPprobdataAddPricedVars(
+    SCIP* scip,                      // SCIP
+    SCIP_ProbData* probdata,         // Problem data
+    Vector<PricedColumn>& columns    // Columns and their output variables
+);
+
+// Remove the variables deleted by SCIP after being unused for a long time
+SCIP_RETCODE SCIPprobdataRemoveDeletedVars(
+    SCIP* scip,                // SCIP
+    SCIP_ProbData* probdata    // Problem data
+);
+
+// Add a new two-agent robust cut. If the cut selection is enabled, the cut waits for the selection at the end of the
+// separation round instead, unless the index of the cut is requested.
 SCIP_RETCODE SCIPprobdataAddTwoAgentRobustCut(
     SCIP* scip,                 // SCIP
     SCIP_ProbData* probdata,    // Problem data
@@ -94,6 +132,26 @@ SCIP_RETCODE SCIPprobdataAddTwoAgentRobustCut(
     Int* idx = nullptr          // Output index of the cut
 );
 
+// Add the most efficacious two-agent robust cuts waiting for the cut selection that are not nearly parallel to a cut
+// added before them, and discard the others
+SCIP_RETCODE SCIPprobdataAddSelectedTwoAgentRobustCuts(
+    SCIP* scip,                 // SCIP
+    SCIP_ProbData* probdata,    // Problem data
+    SCIP_RESULT* result         // Output result
+);
+
+// Discard the two-agent robust cuts waiting for the cut selection
+void SCIPprobdataClearTwoAgentRobustCutCandidates(
+    SCIP* scip,                 // SCIP
+    SCIP_ProbData* probdata     // Problem data
+);
+
+// Age the two-agent robust cuts with zero dual and remove the cuts that have been inactive for too many rounds
+SCIP_RETCODE SCIPprobdataAgeTwoAgentRobustCuts(
+    SCIP* scip,                 // SCIP
+    SCIP_ProbData* probdata     // Problem data
+);
+
 // Get array of dummy variables
 Vector<SCIP_VAR*>& SCIPprobdataGetDummyVars(
     SCIP_ProbData* probdata    // Problem data
@@ -104,11 +162,47 @@ Vector<Pair<SCIP_VAR*, SCIP_Real>>& SCIPprobdataGetVars(
     SCIP_ProbData* probdata    // Problem data
 );
 
+// Get the index in the array of all variables of the variables added by primal heuristics
+#ifdef USE_LNS2_REPAIR_PRIMAL_HEURISTIC
+const Vector<Int>& SCIPprobdataGetHeuristicVarIndices(
+    SCIP_ProbData* probdata    // Problem data
+);
+#endif
+
 // Get array of variables for each agent
 Vector<Vector<Pair<SCIP_VAR*, SCIP_Real>>>& SCIPprobdataGetAgentVars(
     SCIP_ProbData* probdata    // Problem data
 );
 
+// Get the index in the array of all variables of the variables of each agent in increasing order
+const Vector<Vector<Int>>& SCIPprobdataGetAgentVarIndices(
+    SCIP_ProbData* probdata    // Problem data
+);
+
+// Find the variable of an agent with a path, or nullptr if the path has no column
+SCIP_VAR* SCIPprobdataFindVar(
+    SCIP_ProbData* probdata,    // Problem data
+    const Agent a,              // Agent
+    const Time path_length,     // Path length
+    const Edge* const path      // Path
+);
+
+// Get the number of paths rejected because their column already exists
+SCIP_Longint SCIPprobdataGetNDuplicateColumns(
+    SCIP_ProbData* probdata    // Problem data
+);
+
+// Get the index in the array of all variables of the variables visiting a vertex in increasing order
+const Vector<Int>& SCIPprobdataGetVertexVarIndices(
+    SCIP_ProbData* probdata,    // Problem data
+    const NodeTime nt           // Vertex
+);
+
+// Get the paths of the deleted variables of each agent
+Vector<Vector<SCIP_VARDATA*>>& SCIPprobdataGetColumnPool(
+    SCIP_ProbData* probdata    // Problem data
+);
+
 // Get agent partition constraints
 Vector<SCIP_CONS*>& SCIPprobdataGetAgentPartConss(
     SCIP_ProbData* probdata    // Problem data
@@ -188,6 +282,20 @@ Vector<Vector<Pair<NodeTime, SCIP_ROW*>>>& SCIPprobdataGetCrossingAgentGoalConfl
 );
 #endif
 
+// Get the path length nogoods of each agent with their latest finish time
+#ifdef USE_PATH_LENGTH_NOGOODS
+Vector<Vector<Pair<Time, SCIP_ROW*>>>& SCIPprobdataGetAgentPathLengthNogoods(
+    SCIP_ProbData* probdata    // Problem data
+);
+#endif
+
+// Get the variables of other agents visiting the goal of each agent
+#ifdef USE_GOAL_CONFLICTS
+const Vector<Vector<GoalCrossing>>& SCIPprobdataGetGoalCrossings(
+    SCIP_ProbData* probdata    // Problem data
+);
+#endif
+
 // Get the vertices fractionally used by each agent
 const Vector<HashTable<NodeTime, SCIP_Real>>& SCIPprobdataGetFractionalVertices(
     SCIP_ProbData* probdata    // Problem data
@@ -209,20 +317,77 @@ const Vector<HashTable<EdgeTime, SCIP_Real>>& SCIPprobdataGetPositiveMoveEdges(
 );
 
 // Get the edges fractionally used by each agent, grouped by edge-time
-const HashTable<EdgeTime, SCIP_Real*>& SCIPprobdataGetFractionalEdgesVec(
+const HashTable<EdgeTime, AgentValues>& SCIPprobdataGetFractionalEdgesVec(
     SCIP_ProbData* probdata    // Problem data
 );
 
+// Get the agents with a fractional edge starting or ending at a node in the timestep beginning at a time, sorted
+// in increasing order
+const Vector<Agent>& SCIPprobdataGetFractionalAgents(
+    SCIP_ProbData* probdata,    // Problem data
+    const NodeTime nt           // Node-time
+);
+
+// Get the agents with a fractional edge starting or ending at each node-time
+const HashTable<NodeTime, Vector<Agent>>& SCIPprobdataGetFractionalAgentsByNodeTime(
+    SCIP_ProbData* probdata    // Problem data
+);
+
+// Get the agents with a fractional edge or visiting a node-time of a fractional edge, sorted in increasing order.
+// The separators only need to check these agents since the other agents have an integral path away from the
+// fractional part of the solution.
+const Vector<Agent>& SCIPprobdataGetActiveAgents(
+    SCIP_ProbData* probdata    // Problem data
+);
+
+// Add the memory of the columns, the two-agent robust cuts and the tables of fractional vertices and edges
+void SCIPprobdataGetMemoryUsage(
+    SCIP_ProbData* probdata,    // Problem data
+    MemoryUsage& usage          // Output memory usage
+);
+
+// Organise the fractional edges of every agent by edge-time and find the agents at every node-time
+void index_fractional_edges(
+    const Map& map,                                                    // Map
+    const Vector<HashTable<EdgeTime, SCIP_Real>>& fractional_edges,    // Edges fractionally used by each agent
+    HashTable<EdgeTime, AgentValues>& fractional_edges_vec,            // Output values of each edge by agent
+    Vector<AgentValue>& fractional_edges_entries,                      // Output storage of the sparse values
+    Vector<SCIP_Real>& fractional_edges_vals,                          // Output storage of the dense values
+    HashTable<NodeTime, Vector<Agent>>& fractional_agents              // Output agents at each node-time
+);
+
 // Update the database of fractional vertices and edges
 void update_fractional_vertices_and_edges(
     SCIP* scip    // SCIP
 );
 
-// Update the arrays of variable values
+// Update the arrays of variable values if the LP solution changed since the last update
 void update_variable_values(
     SCIP* scip    // SCIP
 );
 
+// Get the time from which conflicts between the agents are ignored
+Time SCIPprobdataGetConflictHorizon(
+    SCIP_ProbData* probdata    // Problem data
+);
+
+// Get the length of the longest path of all variables
+Time SCIPprobdataGetMaxPathLength(
+    SCIP_ProbData* probdata    // Problem data
+);
+
+// Get the length of the longest path with positive value in the LP solution of the last update of the variable values
+Time SCIPprobdataGetMakespan(
+    SCIP_ProbData* probdata    // Problem data
+);
+
+// Get the length of the longest path of an agent with positive value in the LP solution of the last update of the
+// variable values
+Time SCIPprobdataGetAgentMakespan(
+    SCIP_ProbData* probdata,    // Problem data
+    const Agent a               // Agent
+);
+
 // Get pricer data
 SCIP_PricerData* SCIPprobdataGetPricerData(
     SCIP_ProbData* probdata    // Problem data
@@ -239,6 +404,11 @@ bool& SCIPprobdataGetFoundCutsIndicator(
     SCIP_ProbData* probdata    // Problem data
 );
 
+// Get the measured yield of the separators
+HashTable<SCIP_SEPA*, SeparatorSchedule>& SCIPprobdataGetSeparatorSchedules(
+    SCIP_ProbData* probdata    // Problem data
+);
+
 // Get the scenario path
 const std::filesystem::path& SCIPprobdataGetScenarioPath(
     SCIP_ProbData* probdata    // Problem data
@@ -254,6 +424,11 @@ const Map& SCIPprobdataGetMap(
     SCIP_ProbData* probdata    // Problem data
 );
 
+// Get the storage of the variable data of the columns
+PathPool& SCIPprobdataGetPathPool(
+    SCIP_ProbData* probdata    // Problem data
+);
+
 // Get the number of agents
 Agent SCIPprobdataGetN(
     SCIP_ProbData* probdata    // Problem data
@@ -269,12 +444,23 @@ AStar& SCIPprobdataGetAStar(
     SCIP_ProbData* probdata    // Problem data
 );
 
+// Get the coordinates of a node as written to the output files
+Pair<Position, Position> get_output_xy(
+    SCIP_ProbData* probdata,    // Problem data
+    const Node n                // Node
+);
+
 // Format path
 String format_path_action(
     SCIP_ProbData* probdata,    // Problem data
     const Time path_length,     // Path length
     const Edge* const path      // Path
 );
+String format_path_action(
+    const Map& map,             // Map
+    const Time path_length,     // Path length
+    const Edge* const path      // Path
+);
 
 // Format path
 String format_path(
@@ -290,6 +476,18 @@ String format_path_spaced(
     const Edge* const path      // Path
 );
 
+// Format the name of a column on demand
+String format_var_name(
+    SCIP_ProbData* probdata,    // Problem data
+    SCIP_VAR* var               // Variable
+);
+
+// Format the name of a row on demand
+String format_row_name(
+    SCIP_ProbData* probdata,    // Problem data
+    SCIP_ROW* row               // Row
+);
+
 // Write LP relaxation to file
 SCIP_RETCODE write_master(
     SCIP* scip    // SCIP
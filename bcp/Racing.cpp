@@ -0,0 +1,168 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+// #define PRINT_DEBUG
+
+#define HEUR_NAME             "racing"
+#define HEUR_DESC             "Incumbents shared with the other racers"
+#define HEUR_DISPCHAR         'X'
+#define HEUR_PRIORITY         1000000
+#define HEUR_FREQ             1
+#define HEUR_FREQOFS          0
+#define HEUR_MAXDEPTH         -1
+#define HEUR_TIMING           SCIP_HEURTIMING_AFTERNODE
+#define HEUR_USESSUBSCIP      FALSE    // Does the heuristic use a secondary SCIP instance?
+
+#include "Racing.h"
+#include "ProblemData.h"
+#include "VariableData.h"
+#include "Output.h"
+#include "Trace.h"
+
+// Add the incumbent of another racer as a solution
+static SCIP_RETCODE add_race_solution(
+    SCIP* scip,                              // SCIP
+    SCIP_HEUR* heur,                         // Heuristic
+    const Vector<Vector<Edge>>& paths,       // Path of every agent
+    SCIP_RESULT* result                      // Output result
+)
+{
+    // Get problem data.
+    auto probdata = SCIPgetProbData(scip);
+    debug_assert(static_cast<Agent>(paths.size()) == SCIPprobdataGetN(probdata));
+
+    // Create solution object.
+    SCIP_SOL* sol;
+    SCIP_CALL(SCIPcreateSol(scip, &sol, heur));
+
+    // Add the paths. The racers solve the same instance so the paths are valid columns.
+    for (Agent a = 0; a < static_cast<Agent>(paths.size()); ++a)
+    {
+        const auto& path = paths[a];
+        SCIP_VAR* var = nullptr;
+        SCIP_CALL(SCIPprobdataAddHeuristicVar(scip, probdata, a, path.size(), path.data(), &var));
+        debug_assert(var);
+        SCIP_CALL(SCIPsetSolVal(scip, sol, var, 1.0));
+
+        // Print.
+        debugln("Agent {:4d}: {}", a, format_path_spaced(probdata, path.size(), path.data()));
+    }
+
+    // Inject solution.
+    SCIP_Bool success;
+    SCIP_CALL(SCIPtrySol(scip, sol, FALSE, FALSE, FALSE, TRUE, TRUE, &success));
+    if (success)
+    {
+        *result = SCIP_FOUNDSOL;
+    }
+
+    // Deallocate.
+    SCIP_CALL(SCIPfreeSol(scip, &sol));
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Execution method of primal heuristic
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_HEUREXEC(heurExecRacing)
+{
+    // Trace.
+    const TraceScope trace(HEUR_NAME);
+
+    // Initialize.
+    *result = SCIP_DIDNOTFIND;
+
+    // Get the shared data.
+    auto race = reinterpret_cast<RaceData*>(SCIPheurGetData(heur));
+    debug_assert(race);
+
+    // Stop once another racer finishes.
+    if (race->finished)
+    {
+        SCIP_CALL(SCIPinterruptSolve(scip));
+        return SCIP_OKAY;
+    }
+
+    // Publish the incumbent of this racer if it is better than every other racer. The paths are empty if the
+    // incumbent uses an artificial variable.
+    auto sol = SCIPgetBestSol(scip);
+    const auto cost = sol ? SCIPgetSolOrigObj(scip, sol) : SCIPinfinity(scip);
+    Vector<Vector<Edge>> paths;
+    {
+        std::lock_guard<std::mutex> lock(race->mutex);
+        if (SCIPisLT(scip, cost, race->cost))
+        {
+            paths = get_best_solution_paths(scip);
+            if (!paths.empty())
+            {
+                debugln("Publishing incumbent with cost {} to the other racers", cost);
+                race->paths = std::move(paths);
+                race->cost = cost;
+            }
+        }
+        else if (SCIPisGT(scip, cost, race->cost))
+        {
+            paths = race->paths;
+        }
+    }
+
+    // Add the incumbent of another racer if it is better.
+    if (!paths.empty())
+    {
+        debugln("Adding incumbent of another racer with cost better than {}:", cost);
+        SCIP_CALL(add_race_solution(scip, heur, paths, result));
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Include the racing primal heuristic
+SCIP_RETCODE SCIPincludeHeurRacing(
+    SCIP* scip,       // SCIP
+    RaceData* race    // Data shared by the racers
+)
+{
+    // Check.
+    debug_assert(race);
+
+    // Create heuristic. The shared data is owned by the caller.
+    SCIP_HEUR* heur;
+    SCIP_CALL(SCIPincludeHeurBasic(scip,
+                                   &heur,
+                                   HEUR_NAME,
+                                   HEUR_DESC,
+                                   HEUR_DISPCHAR,
+                                   HEUR_PRIORITY,
+                                   HEUR_FREQ,
+                                   HEUR_FREQOFS,
+                                   HEUR_MAXDEPTH,
+                                   HEUR_TIMING,
+                                   HEUR_USESSUBSCIP,
+                                   heurExecRacing,
+                                   reinterpret_cast<SCIP_HeurData*>(race)));
+    debug_assert(heur);
+
+    // Done.
+    return SCIP_OKAY;
+}
@@ -0,0 +1,46 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#ifndef MAPF_RACING_H
+#define MAPF_RACING_H
+
+#include "Includes.h"
+#include "Coordinates.h"
+#include <atomic>
+#include <mutex>
+
+// Data shared by the differently configured solvers racing on the same instance
+struct RaceData
+{
+    std::mutex mutex;                          // Lock for the incumbent and the winner
+    Vector<Vector<Edge>> paths;                // Path of every agent in the best incumbent of all racers
+    SCIP_Real cost = SCIP_DEFAULT_INFINITY;    // Cost of the best incumbent
+    Int winner = -1;                           // Index of the first racer to finish
+    std::atomic<bool> finished{false};         // Indicates if a racer finished and the others should stop
+};
+
+// Include the primal heuristic that shares the incumbents of a racer with the other racers. After every node, it
+// publishes a better incumbent of this racer, adds a better incumbent of another racer and interrupts the solve once
+// another racer finishes.
+SCIP_RETCODE SCIPincludeHeurRacing(
+    SCIP* scip,       // SCIP
+    RaceData* race    // Data shared by the racers
+);
+
+#endif
@@ -21,6 +21,7 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Includes.h"
 #include "ProblemData.h"
 #include <regex>
+#include <fstream>
 
 #include "trufflehog/Instance.h"
 #include "trufflehog/AStar.h"
@@ -29,7 +30,11 @@ Author: Edward Lam <ed@ed-lam.com>
 SCIP_RETCODE read_instance(
     SCIP* scip,                                    // SCIP
     const std::filesystem::path& scenario_path,    // File path to scenario
-    const Agent nb_agents                          // Number of agents to read
+    const Agent nb_agents,                         // Number of agents to read
+    const std::filesystem::path& heuristic_cache_dir,   // Directory to cache the heuristic in
+    const bool cache_map,                               // Cache the parsed map next to the map file
+    const size_t heuristic_memory_budget,               // Bytes of memory for the heuristic (0 if unlimited)
+    SharedInstanceData* shared                          // Data shared with other instances
 )
 {
     // Get instance name.
@@ -40,10 +45,42 @@ SCIP_RETCODE read_instance(
     }
 
     // Load instance.
-    auto instance = std::make_shared<Instance>(scenario_path, nb_agents);
+    auto instance = std::make_shared<Instance>(scenario_path, nb_agents, cache_map, shared ? &shared->maps : nullptr);
 
+    // Create the problem.
+    SCIP_CALL(read_instance(scip, instance, instance_name, heuristic_cache_dir, heuristic_memory_budget, shared));
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Create the problem of an instance already in memory
+SCIP_RETCODE read_instance(
+    SCIP* scip,                                         // SCIP
+    SharedPtr<Instance> instance,                       // Instance
+    const String& instance_name,                        // Problem name
+    const std::filesystem::path& heuristic_cache_dir,   // Directory to cache the heuristic in
+    const size_t heuristic_memory_budget,               // Bytes of memory for the heuristic (0 if unlimited)
+    SharedInstanceData* shared                          // Data shared with other instances
+)
+{
     // Create pricing solver.
     auto astar = std::make_shared<AStar>(instance->map);
+    if (!heuristic_cache_dir.empty())
+    {
+        astar->set_heuristic_cache_directory(heuristic_cache_dir);
+    }
+    astar->set_heuristic_memory_budget(heuristic_memory_budget);
+    if (shared)
+    {
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        auto& heuristic = shared->heuristics[instance->map_path.lexically_normal().string()];
+        if (!heuristic)
+        {
+            heuristic = std::make_shared<HeuristicCache>();
+        }
+        astar->set_heuristic_shared_cache(heuristic);
+    }
 
     // Create the problem.
     SCIP_CALL(SCIPprobdataCreate(scip, instance_name.c_str(), instance, astar));
@@ -51,3 +88,145 @@ SCIP_RETCODE read_instance(
     // Done.
     return SCIP_OKAY;
 }
+
+// Parse a path written by write_path as the moves of the agent from its start
+static bool parse_path_moves(const Map& map, const Node start, const String& line, Vector<Edge>& path)
+{
+    path.clear();
+    path.push_back(Edge{start, Direction::INVALID});
+    for (const auto c : line)
+    {
+        Direction d;
+        switch (c)
+        {
+            case 'u': { d = Direction::SOUTH; break; }
+            case 'd': { d = Direction::NORTH; break; }
+            case 'r': { d = Direction::EAST; break; }
+            case 'l': { d = Direction::WEST; break; }
+            case 'w': { d = Direction::WAIT; break; }
+            case '\r':
+            case ' ': { continue; }
+            default: { return false; }
+        }
+        path.back().d = d;
+        const auto n = map.get_destination(path.back());
+        if (n < 0 || n >= map.size() || !map[n])
+        {
+            return false;
+        }
+        path.push_back(Edge{n, Direction::INVALID});
+    }
+    return true;
+}
+
+// Parse a path written by write_best_solution as a list of coordinates
+static bool parse_path_coordinates(const Map& map, const String& line, Vector<Edge>& path)
+{
+    static const std::regex coordinate_regex("\\((\\d+),(\\d+)\\)");
+    path.clear();
+    for (auto it = std::sregex_iterator(line.begin(), line.end(), coordinate_regex);
+         it != std::sregex_iterator();
+         ++it)
+    {
+        // Coordinates are written without the padding around the map.
+        const auto x = std::stoi((*it)[1]) + 1;
+        const auto y = std::stoi((*it)[2]) + 1;
+        if (x >= map.width() || y >= map.height() || !map[map.get_id(x, y)])
+        {
+            return false;
+        }
+        const auto n = map.get_id(x, y);
+        if (!path.empty())
+        {
+            const auto prev_n = path.back().n;
+            if (n != map.get_north(prev_n) && n != map.get_south(prev_n) && n != map.get_east(prev_n) &&
+                n != map.get_west(prev_n) && n != map.get_wait(prev_n))
+            {
+                return false;
+            }
+            path.back().d = map.get_direction(prev_n, n);
+        }
+        path.push_back(Edge{n, Direction::INVALID});
+    }
+    return !path.empty();
+}
+
+// Read paths from a previous run and add them as initial columns
+SCIP_RETCODE read_warm_start(
+    SCIP* scip,                                 // SCIP
+    const std::filesystem::path& path_file,     // File path to the paths
+    const bool add_solution                     // Add the paths as a solution if every agent has a path
+)
+{
+    // Check.
+    debug_assert(scip);
+    debug_assert(SCIPgetStage(scip) == SCIP_STAGE_PROBLEM);
+
+    // Get problem data.
+    auto probdata = SCIPgetProbData(scip);
+    const auto N = SCIPprobdataGetN(probdata);
+    const auto& map = SCIPprobdataGetMap(probdata);
+    const auto& agents = SCIPprobdataGetAgentsData(probdata);
+
+    // Open file.
+    std::ifstream file(path_file);
+    release_assert(file.good(), "Failed to open warm-start file {}", path_file.string());
+
+    // Read the path of each agent. Paths that are invalid for the current instance, such as after agents are added or
+    // removed from the scenario, are skipped.
+    Vector<SCIP_VAR*> vars(N, nullptr);
+    Vector<Edge> path;
+    String line;
+    Agent a = 0;
+    Agent nb_paths = 0;
+    while (a < N && std::getline(file, line))
+    {
+        // Parse the path.
+        bool valid;
+        if (line.rfind("Agent ", 0) == 0)
+        {
+            const auto pos = line.find("path ");
+            valid = pos != String::npos && parse_path_coordinates(map, line.substr(pos), path);
+        }
+        else if (a == 0 && !line.empty() && line.front() >= '0' && line.front() <= '9')
+        {
+            // Skip the objective value written by write_best_solution.
+            continue;
+        }
+        else if (line.empty() || line == "-")
+        {
+            continue;
+        }
+        else
+        {
+            valid = parse_path_moves(map, agents[a].start, line, path);
+        }
+        valid = valid && path.front().n == agents[a].start && path.back().n == agents[a].goal;
+
+        // Add the column.
+        if (valid)
+        {
+            SCIP_CALL(SCIPprobdataAddInitialVar(scip, probdata, a, path.size(), path.data(), &vars[a]));
+            debug_assert(vars[a]);
+            ++nb_paths;
+        }
+        ++a;
+    }
+    debugln("Read {} warm-start paths for {} agents", nb_paths, N);
+
+    // Add the solution. SCIP checks its feasibility when the problem is transformed.
+    if (add_solution && nb_paths == N)
+    {
+        SCIP_SOL* sol;
+        SCIP_CALL(SCIPcreateSol(scip, &sol, nullptr));
+        for (const auto var : vars)
+        {
+            SCIP_CALL(SCIPsetSolVal(scip, sol, var, 1.0));
+        }
+        SCIP_Bool stored;
+        SCIP_CALL(SCIPaddSolFree(scip, &sol, &stored));
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
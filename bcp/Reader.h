@@ -21,13 +21,45 @@ Author: Edward Lam <ed@ed-lam.com>
 #define MAPF_READER_H
 
 #include "Includes.h"
+#include "trufflehog/Instance.h"
+#include "trufflehog/Heuristic.h"
 #include <filesystem>
+#include <mutex>
+
+// Maps and lower bounds kept across the instances solved in one process
+struct SharedInstanceData
+{
+    MapCache maps;                                                  // Parsed maps
+    std::mutex mutex;                                               // Lock for the lower bounds
+    HashTable<String, SharedPtr<HeuristicCache>> heuristics;        // Lower bounds of each map
+};
 
 // Read instance from file
 SCIP_RETCODE read_instance(
     SCIP* scip,                                                  // SCIP
     const std::filesystem::path& scenario_path,                  // File path to scenario
-    const Agent nb_agents = std::numeric_limits<Agent>::max()    // Number of agents to read
+    const Agent nb_agents = std::numeric_limits<Agent>::max(),   // Number of agents to read
+    const std::filesystem::path& heuristic_cache_dir = {},       // Directory to cache the heuristic in
+    const bool cache_map = false,                                // Cache the parsed map next to the map file
+    const size_t heuristic_memory_budget = 0,                    // Bytes of memory for the heuristic (0 if unlimited)
+    SharedInstanceData* shared = nullptr                         // Data shared with other instances
+);
+
+// Create the problem of an instance already in memory
+SCIP_RETCODE read_instance(
+    SCIP* scip,                                                  // SCIP
+    SharedPtr<Instance> instance,                                // Instance
+    const String& instance_name,                                 // Problem name
+    const std::filesystem::path& heuristic_cache_dir = {},       // Directory to cache the heuristic in
+    const size_t heuristic_memory_budget = 0,                    // Bytes of memory for the heuristic (0 if unlimited)
+    SharedInstanceData* shared = nullptr                         // Data shared with other instances
+);
+
+// Read paths from a previous run and add them as initial columns
+SCIP_RETCODE read_warm_start(
+    SCIP* scip,                                 // SCIP
+    const std::filesystem::path& path_file,     // File path to the paths in the format of write_path
+    const bool add_solution = true              // Add the paths as a solution if every agent has a path
 );
 
 #endif
@@ -0,0 +1,305 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+
+#include "SeparationLog.h"
+#include "ProblemData.h"
+#include "VariableData.h"
+
+#define LOG_FILE_MAGIC 0x3130504553504342ULL // "BCPSEP01"
+
+#define DEFAULT_SEPARATION_RECORD_FILE ""    // File to record the input of the separators (empty to disable)
+#define DEFAULT_SEPARATION_RECORD_NODE 1     // Branch-and-bound node whose rounds are recorded (-1: every node)
+#define DEFAULT_SEPARATION_RECORD_ROUNDS -1  // Number of rounds recorded in each node (-1: every round)
+
+// Records stored in the log
+struct EdgeValueRecord
+{
+    EdgeTime et;
+    SCIP_Real val;
+};
+
+// Write a value
+template<class T>
+static inline void write_value(String& buffer, const T& value)
+{
+    static_assert(std::is_trivially_copyable<T>::value);
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Write a vector prefixed by its size
+template<class T>
+static inline void write_vector(String& buffer, const Vector<T>& values)
+{
+    const uint32_t size = values.size();
+    write_value(buffer, size);
+    buffer.append(reinterpret_cast<const char*>(values.data()), sizeof(T) * size);
+}
+
+// Write a table of edge values prefixed by its size
+static inline void write_edges(String& buffer, const HashTable<EdgeTime, SCIP_Real>& edges)
+{
+    Vector<EdgeValueRecord> records;
+    records.reserve(edges.size());
+    for (const auto& [et, val] : edges)
+    {
+        records.push_back({et, val});
+    }
+    write_vector(buffer, records);
+}
+
+// Read a value
+template<class T>
+static inline void read_value(std::ifstream& file, T& value)
+{
+    static_assert(std::is_trivially_copyable<T>::value);
+    file.read(reinterpret_cast<char*>(&value), sizeof(T));
+}
+
+// Read a vector prefixed by its size
+template<class T>
+static inline void read_vector(std::ifstream& file, Vector<T>& values)
+{
+    uint32_t size = 0;
+    read_value(file, size);
+    if (file)
+    {
+        values.resize(size);
+        file.read(reinterpret_cast<char*>(values.data()), sizeof(T) * size);
+    }
+}
+
+// Read a table of edge values prefixed by its size
+static inline void read_edges(std::ifstream& file, const Map& map, HashTable<EdgeTime, SCIP_Real>& edges)
+{
+    Vector<EdgeValueRecord> records;
+    read_vector(file, records);
+    edges.clear();
+    for (const auto& [et, val] : records)
+    {
+        release_assert(0 <= et.n && et.n < map.size(), "Invalid node {} in separation log", et.n);
+        edges.emplace(et, val);
+    }
+}
+
+SeparationLogReader::SeparationLogReader(const Map& map, const std::filesystem::path& path) :
+    map_(map),
+    file_(path, std::ios::binary),
+    N_(0)
+{
+    // Check the header.
+    release_assert(file_.good(), "Cannot open separation log {}", path.string());
+    uint64_t magic = 0;
+    Position width = 0;
+    Position height = 0;
+    read_value(file_, magic);
+    read_value(file_, width);
+    read_value(file_, height);
+    read_value(file_, N_);
+    release_assert(file_ && magic == LOG_FILE_MAGIC, "Invalid separation log {}", path.string());
+    release_assert(width == map_.width() && height == map_.height(),
+                   "Separation log {} is recorded on a map of size {}x{} instead of {}x{}",
+                   path.string(), width, height, map_.width(), map_.height());
+}
+
+SeparationLogWriter::SeparationLogWriter(const Map& map, const Agent N, const std::filesystem::path& path) :
+    map_(map),
+    file_(path, std::ios::binary | std::ios::trunc)
+{
+    // Write the header.
+    release_assert(file_.good(), "Cannot create separation log {}", path.string());
+    String buffer;
+    write_value(buffer, static_cast<uint64_t>(LOG_FILE_MAGIC));
+    write_value(buffer, map_.width());
+    write_value(buffer, map_.height());
+    write_value(buffer, N);
+    file_.write(buffer.data(), buffer.size());
+}
+
+void SeparationLogWriter::write(const int64_t node,
+                                const Int round,
+                                const SCIP_Real epsilon,
+                                const Vector<HashTable<EdgeTime, SCIP_Real>>& fractional_edges,
+                                const Vector<HashTable<EdgeTime, SCIP_Real>>& positive_move_edges,
+                                const Vector<Vector<SeparationColumn>>& columns)
+{
+    // Check.
+    const Agent N = fractional_edges.size();
+    debug_assert(static_cast<Agent>(positive_move_edges.size()) == N);
+    debug_assert(static_cast<Agent>(columns.size()) == N);
+
+    // Serialise the round.
+    String buffer;
+    write_value(buffer, node);
+    write_value(buffer, round);
+    write_value(buffer, epsilon);
+    for (Agent a = 0; a < N; ++a)
+    {
+        write_edges(buffer, fractional_edges[a]);
+        write_edges(buffer, positive_move_edges[a]);
+        const uint32_t nb_columns = columns[a].size();
+        write_value(buffer, nb_columns);
+        for (const auto& [val, path] : columns[a])
+        {
+            write_value(buffer, val);
+            write_vector(buffer, path);
+        }
+    }
+
+    // Append to the log.
+    file_.write(buffer.data(), buffer.size());
+    release_assert(file_.good(), "Failed to write to separation log");
+}
+
+bool SeparationLogReader::read(SeparationRound& round)
+{
+    // Read the position of the round.
+    read_value(file_, round.node);
+    if (file_.eof())
+    {
+        return false;
+    }
+    read_value(file_, round.round);
+    read_value(file_, round.epsilon);
+
+    // Read the input of each agent.
+    round.fractional_edges.resize(N_);
+    round.positive_move_edges.resize(N_);
+    round.columns.resize(N_);
+    for (Agent a = 0; a < N_; ++a)
+    {
+        read_edges(file_, map_, round.fractional_edges[a]);
+        read_edges(file_, map_, round.positive_move_edges[a]);
+        uint32_t nb_columns = 0;
+        read_value(file_, nb_columns);
+        release_assert(file_, "Truncated separation log");
+        round.columns[a].resize(nb_columns);
+        for (auto& [val, path] : round.columns[a])
+        {
+            read_value(file_, val);
+            read_vector(file_, path);
+        }
+    }
+
+    // Clear the fractional edges organised by edge-time since they are not stored.
+    round.fractional_edges_vec.clear();
+    round.fractional_edges_entries.clear();
+    round.fractional_edges_vals.clear();
+    round.fractional_agents.clear();
+
+    // Done.
+    release_assert(file_.good(), "Truncated separation log");
+    return true;
+}
+
+// Add the parameters for recording the input of the separators
+SCIP_RETCODE SCIPaddParamsSeparationLog(
+    SCIP* scip    // SCIP
+)
+{
+    SCIP_CALL(SCIPaddStringParam(scip,
+                                 SEPARATION_RECORD_FILE_PARAM,
+                                 "file to record the input of the separators for offline replay (empty to disable)",
+                                 nullptr,
+                                 FALSE,
+                                 DEFAULT_SEPARATION_RECORD_FILE,
+                                 nullptr,
+                                 nullptr));
+    SCIP_CALL(SCIPaddIntParam(scip,
+                              SEPARATION_RECORD_NODE_PARAM,
+                              "branch-and-bound node whose separation rounds are recorded (-1: every node)",
+                              nullptr,
+                              FALSE,
+                              DEFAULT_SEPARATION_RECORD_NODE,
+                              -1,
+                              INT_MAX,
+                              nullptr,
+                              nullptr));
+    SCIP_CALL(SCIPaddIntParam(scip,
+                              SEPARATION_RECORD_ROUNDS_PARAM,
+                              "number of separation rounds recorded in each node (-1: every round)",
+                              nullptr,
+                              FALSE,
+                              DEFAULT_SEPARATION_RECORD_ROUNDS,
+                              -1,
+                              INT_MAX,
+                              nullptr,
+                              nullptr));
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Record the input of the separators in the current separation round
+SCIP_RETCODE record_separation_round(
+    SCIP* scip,                                // SCIP
+    UniquePtr<SeparationLogWriter>& writer     // Log of the separation rounds
+)
+{
+    // Check if this round is recorded.
+    char* record_file;
+    int record_node;
+    int record_rounds;
+    SCIP_CALL(SCIPgetStringParam(scip, SEPARATION_RECORD_FILE_PARAM, &record_file));
+    SCIP_CALL(SCIPgetIntParam(scip, SEPARATION_RECORD_NODE_PARAM, &record_node));
+    SCIP_CALL(SCIPgetIntParam(scip, SEPARATION_RECORD_ROUNDS_PARAM, &record_rounds));
+    const int64_t node = SCIPnodeGetNumber(SCIPgetCurrentNode(scip));
+    const Int round = SCIPgetNSepaRounds(scip);
+    if (!record_file || record_file[0] == '\0' ||
+        (record_node >= 0 && node != record_node) ||
+        (record_rounds >= 0 && round >= record_rounds))
+    {
+        return SCIP_OKAY;
+    }
+
+    // Get problem data.
+    auto probdata = SCIPgetProbData(scip);
+    const auto N = SCIPprobdataGetN(probdata);
+    const auto& map = SCIPprobdataGetMap(probdata);
+    const auto& agent_vars = SCIPprobdataGetAgentVars(probdata);
+
+    // Open the log.
+    if (!writer)
+    {
+        writer = std::make_unique<SeparationLogWriter>(map, N, record_file);
+    }
+
+    // Get the columns with positive value in the order of the variables of each agent.
+    Vector<Vector<SeparationColumn>> columns(N);
+    for (Agent a = 0; a < N; ++a)
+        for (const auto& [var, var_val] : agent_vars[a])
+            if (SCIPisPositive(scip, var_val))
+            {
+                const auto vardata = SCIPvarGetData(var);
+                const auto path_length = SCIPvardataGetPathLength(vardata);
+                const auto path = SCIPvardataGetPath(vardata);
+                columns[a].push_back({var_val, Vector<Edge>(path, path + path_length)});
+            }
+
+    // Write.
+    writer->write(node,
+                  round,
+                  SCIPsumepsilon(scip),
+                  SCIPprobdataGetFractionalEdges(probdata),
+                  SCIPprobdataGetPositiveMoveEdges(probdata),
+                  columns);
+
+    // Done.
+    return SCIP_OKAY;
+}
@@ -0,0 +1,121 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+
+#ifndef MAPF_SEPARATIONLOG_H
+#define MAPF_SEPARATIONLOG_H
+
+#include "Includes.h"
+#include "Coordinates.h"
+#include "AgentValues.h"
+#include "trufflehog/Map.h"
+#include <filesystem>
+#include <fstream>
+
+#define SEPARATION_RECORD_FILE_PARAM "separating/mapf/recordfile"
+#define SEPARATION_RECORD_NODE_PARAM "separating/mapf/recordnode"
+#define SEPARATION_RECORD_ROUNDS_PARAM "separating/mapf/recordrounds"
+
+// Column with positive value in the LP solution
+struct SeparationColumn
+{
+    SCIP_Real val;        // Value of the column
+    Vector<Edge> path;    // Path of the column
+};
+
+// Input of the separators in one separation round recorded from the solver
+struct SeparationRound
+{
+    int64_t node;                                                      // Number of the branch-and-bound node
+    Int round;                                                         // Separation round in the node
+    SCIP_Real epsilon;                                                 // Tolerance of sums
+    Vector<HashTable<EdgeTime, SCIP_Real>> fractional_edges;           // Edges fractionally used by each agent
+    Vector<HashTable<EdgeTime, SCIP_Real>> positive_move_edges;        // Non-wait edges used by each agent
+    Vector<Vector<SeparationColumn>> columns;                          // Columns of each agent with positive value
+
+    // Fractional edges organised by edge-time, filled by index_fractional_edges after reading. The values point into
+    // fractional_edges_entries and fractional_edges_vals so they must be rebuilt after the round is copied.
+    HashTable<EdgeTime, AgentValues> fractional_edges_vec;
+    Vector<AgentValue> fractional_edges_entries;
+    Vector<SCIP_Real> fractional_edges_vals;
+    HashTable<NodeTime, Vector<Agent>> fractional_agents;
+};
+
+// Read a log of separation rounds
+class SeparationLogReader
+{
+    const Map& map_;
+    std::ifstream file_;
+    Agent N_;
+
+  public:
+    // Constructors
+    SeparationLogReader() = delete;
+    SeparationLogReader(const Map& map, const std::filesystem::path& path);
+    SeparationLogReader(const SeparationLogReader&) = delete;
+    SeparationLogReader(SeparationLogReader&&) = delete;
+    SeparationLogReader& operator=(const SeparationLogReader&) = delete;
+    SeparationLogReader& operator=(SeparationLogReader&&) = delete;
+    ~SeparationLogReader() = default;
+
+    // Getters
+    inline Agent N() const { return N_; }
+
+    // Read the next round. Returns false at the end of the log.
+    bool read(SeparationRound& round);
+};
+
+// Write a log of separation rounds
+class SeparationLogWriter
+{
+    const Map& map_;
+    std::ofstream file_;
+
+  public:
+    // Constructors
+    SeparationLogWriter() = delete;
+    SeparationLogWriter(const Map& map, const Agent N, const std::filesystem::path& path);
+    SeparationLogWriter(const SeparationLogWriter&) = delete;
+    SeparationLogWriter(SeparationLogWriter&&) = delete;
+    SeparationLogWriter& operator=(const SeparationLogWriter&) = delete;
+    SeparationLogWriter& operator=(SeparationLogWriter&&) = delete;
+    ~SeparationLogWriter() = default;
+
+    // Write a round
+    void write(const int64_t node,
+               const Int round,
+               const SCIP_Real epsilon,
+               const Vector<HashTable<EdgeTime, SCIP_Real>>& fractional_edges,
+               const Vector<HashTable<EdgeTime, SCIP_Real>>& positive_move_edges,
+               const Vector<Vector<SeparationColumn>>& columns);
+};
+
+// Add the parameters for recording the input of the separators
+SCIP_RETCODE SCIPaddParamsSeparationLog(
+    SCIP* scip    // SCIP
+);
+
+// Record the input of the separators in the current separation round if it is selected by the parameters. The
+// writer is opened on the first recorded round.
+SCIP_RETCODE record_separation_round(
+    SCIP* scip,                                // SCIP
+    UniquePtr<SeparationLogWriter>& writer     // Log of the separation rounds
+);
+
+#endif
@@ -0,0 +1,234 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+
+// Benchmark of the separators on separation rounds recorded from bcp-mapf
+
+#include "Includes.h"
+#include "Coordinates.h"
+#include "ProblemData.h"
+#include "SeparationLog.h"
+#include "Separator_CorridorConflicts.h"
+#include "Separator_RectangleKnapsackConflicts.h"
+#include "trufflehog/Instance.h"
+#include <chrono>
+
+struct ReplayResult
+{
+    Int nb_candidates;    // Number of candidate cuts found
+    double seconds;       // Total run time
+};
+
+// Run a separator on a round and collect statistics
+template<class F>
+static ReplayResult run_separator(const Int nb_repeats, F find_candidates)
+{
+    ReplayResult result{};
+    for (Int repeat = 0; repeat < nb_repeats; ++repeat)
+    {
+        const auto start_time = std::chrono::steady_clock::now();
+        result.nb_candidates = find_candidates();
+        const auto end_time = std::chrono::steady_clock::now();
+        result.seconds += std::chrono::duration<double>(end_time - start_time).count();
+    }
+    return result;
+}
+
+#if defined(USE_CORRIDOR_CONFLICTS) || defined(USE_WAITCORRIDOR_CONFLICTS)
+// Find the candidates of the separator for corridor conflicts
+static Int find_corridor_candidates(const Map& map, const SeparationRound& round)
+{
+    const Agent N = round.fractional_edges.size();
+    Vector<CorridorConflictData> cuts;
+    for (Agent a1 = 0; a1 < N - 1; ++a1)
+    {
+        find_corridor_conflicts(map,
+                                round.fractional_edges[a1],
+                                round.fractional_edges_vec,
+                                round.fractional_agents,
+                                a1,
+                                round.epsilon,
+                                cuts);
+    }
+    return cuts.size();
+}
+#endif
+
+#ifdef USE_RECTANGLE_KNAPSACK_CONFLICTS
+// Find the candidates of the separator for rectangle knapsack conflicts. The loop over the paths is the same as in
+// the separator.
+static Int find_rectangle_candidates(const Map& map, const SeparationRound& round)
+{
+    const Agent N = round.columns.size();
+    Int nb_candidates = 0;
+    Vector<EdgeTime> rectangle_edges;
+    Int a1_out_edges_begin;
+    Int a2_in_edges_begin;
+    Int a2_out_edges_begin;
+#if defined(DEBUG) or defined(PRINT_DEBUG)
+    Position a1_start_x;
+    Position a1_start_y;
+    Time a1_start_t;
+    Position a2_start_x;
+    Position a2_start_y;
+    Time a2_start_t;
+    Position a1_end_x;
+    Position a1_end_y;
+    Time a1_end_t;
+    Position a2_end_x;
+    Position a2_end_y;
+    Time a2_end_t;
+    SCIP_Real lhs;
+#endif
+    for (Agent a1 = 0; a1 < N - 1; ++a1)
+        for (auto it1 = round.columns[a1].crbegin(); it1 != round.columns[a1].crend(); ++it1)
+        {
+            const auto& a1_path = it1->path;
+            for (Agent a2 = a1 + 1; a2 < N; ++a2)
+            {
+                Int count = 0;
+                for (auto it2 = round.columns[a2].crbegin(); it2 != round.columns[a2].crend(); ++it2)
+                {
+                    // Find a vertex conflict and search outward to find a rectangle conflict.
+                    const auto& a2_path = it2->path;
+                    const Int min_path_length = std::min(a1_path.size(), a2_path.size());
+                    for (Time conflict_time = 1; conflict_time < min_path_length - 1; ++conflict_time)
+                        if (a1_path[conflict_time].n == a2_path[conflict_time].n &&
+                            find_rectangle_conflict(round.epsilon,
+                                                    map,
+                                                    round.positive_move_edges[a1],
+                                                    round.positive_move_edges[a2],
+                                                    conflict_time,
+                                                    a1_path.data(),
+                                                    a2_path.data(),
+                                                    min_path_length,
+                                                    rectangle_edges,
+                                                    a1_out_edges_begin,
+                                                    a2_in_edges_begin,
+                                                    a2_out_edges_begin
+#if defined(DEBUG) or defined(PRINT_DEBUG)
+                                                  , a1,
+                                                    a2,
+                                                    a1_start_x, a1_start_y, a1_start_t,
+                                                    a2_start_x, a2_start_y, a2_start_t,
+                                                    a1_end_x, a1_end_y, a1_end_t,
+                                                    a2_end_x, a2_end_y, a2_end_t,
+                                                    lhs
+#endif
+                                                   ))
+                        {
+                            ++nb_candidates;
+                            goto NEXT_AGENT_PAIR;
+                        }
+
+                    // Stop if checked enough paths.
+                    ++count;
+                    if (count >= 50)
+                    {
+                        goto NEXT_AGENT_PAIR;
+                    }
+                }
+                NEXT_AGENT_PAIR:;
+            }
+        }
+    return nb_candidates;
+}
+#endif
+
+int main(int argc, char** argv)
+{
+    // Read arguments.
+    if (argc < 3 || argc > 4)
+    {
+        fmt::print(stderr, "Usage: {} <scenario file> <separation log> [repeats]\n", argv[0]);
+        return 1;
+    }
+    const std::filesystem::path scenario_path = argv[1];
+    const std::filesystem::path log_path = argv[2];
+    const Int nb_repeats = argc == 4 ? std::atoi(argv[3]) : 1;
+    release_assert(nb_repeats >= 1, "Invalid number of repeats {}", argv[3]);
+
+    // Load instance.
+    const auto instance = Instance(scenario_path);
+    const auto& map = instance.map;
+
+    // Read the separation rounds. The fractional edges are organised by edge-time after all rounds are read since
+    // the tables point into the storage of each round.
+    Vector<SeparationRound> rounds;
+    {
+        SeparationLogReader reader(map, log_path);
+        SeparationRound round;
+        while (reader.read(round))
+        {
+            rounds.push_back(std::move(round));
+        }
+    }
+    for (auto& round : rounds)
+    {
+        index_fractional_edges(map,
+                               round.fractional_edges,
+                               round.fractional_edges_vec,
+                               round.fractional_edges_entries,
+                               round.fractional_edges_vals,
+                               round.fractional_agents);
+    }
+    println("Read {} separation rounds from {}", rounds.size(), log_path.string());
+
+    // Run.
+    println("{:>8} {:>6} {:>12} {:>12} {:>12} {:>12}",
+            "Node",
+            "Round",
+            "Corridor",
+            "Time (ms)",
+            "Rectangle",
+            "Time (ms)");
+    ReplayResult corridor_total{};
+    ReplayResult rectangle_total{};
+    for (const auto& round : rounds)
+    {
+        ReplayResult corridor_result{};
+        ReplayResult rectangle_result{};
+#if defined(USE_CORRIDOR_CONFLICTS) || defined(USE_WAITCORRIDOR_CONFLICTS)
+        corridor_result = run_separator(nb_repeats, [&]() { return find_corridor_candidates(map, round); });
+#endif
+#ifdef USE_RECTANGLE_KNAPSACK_CONFLICTS
+        rectangle_result = run_separator(nb_repeats, [&]() { return find_rectangle_candidates(map, round); });
+#endif
+        println("{:>8} {:>6} {:>12} {:>12.3f} {:>12} {:>12.3f}",
+                round.node,
+                round.round,
+                corridor_result.nb_candidates,
+                1e3 * corridor_result.seconds / nb_repeats,
+                rectangle_result.nb_candidates,
+                1e3 * rectangle_result.seconds / nb_repeats);
+        corridor_total.nb_candidates += corridor_result.nb_candidates;
+        corridor_total.seconds += corridor_result.seconds;
+        rectangle_total.nb_candidates += rectangle_result.nb_candidates;
+        rectangle_total.seconds += rectangle_result.seconds;
+    }
+    println("{:>15} {:>12} {:>12.3f} {:>12} {:>12.3f}",
+            "Total",
+            corridor_total.nb_candidates,
+            1e3 * corridor_total.seconds / nb_repeats,
+            rectangle_total.nb_candidates,
+            1e3 * rectangle_total.seconds / nb_repeats);
+
+    // Done.
+    return 0;
+}
@@ -23,6 +23,17 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Includes.h"
 #include "Coordinates.h"
 
+struct SeparatorSchedule
+{
+    SCIP_Longint last_nb_cuts;    // Number of cuts found by the separator before its last call
+    SCIP_Real last_time;          // Time spent in the separator before its last call
+    bool running;                 // Indicates whether the last call searched for cuts
+    Int nb_unproductive;          // Number of consecutive expensive calls without cuts
+    Int nb_skip;                  // Number of upcoming calls to skip
+    SCIP_Longint nb_candidates;   // Number of cuts of the separator offered to the cut selection
+};
+
+// Two-agent robust cut seen by one of its agents. The edge-times point into storage shared by all cuts of the agent.
 struct AgentRobustCut
 {
     SCIP_ROW* row;
@@ -32,14 +43,12 @@ struct AgentRobustCut
 
 class TwoAgentRobustCut
 {
-#ifdef DEBUG
-    String name_;
-#endif
     SCIP_ROW* row_;
     Agent a1_;
     Agent a2_;
     Int a1_end;
     Int a2_end_;
+    Int age_;
     EdgeTime* ets_;
 
   public:
@@ -50,31 +59,24 @@ class TwoAgentRobustCut
         const Agent a2,
         const Int nb_a1_edgetimes,
         const Int nb_a2_edgetimes
-#ifdef DEBUG
-      , String&& name
-#endif
     ) :
-#ifdef DEBUG
-        name_(std::move(name)),
-#endif
         row_(nullptr),
         a1_(a1),
         a2_(a2),
         a1_end(nb_a1_edgetimes),
-        a2_end_(nb_a1_edgetimes + nb_a2_edgetimes)
+        a2_end_(nb_a1_edgetimes + nb_a2_edgetimes),
+        age_(0)
     {
         scip_assert(SCIPallocBlockMemoryArray(scip, &ets_, a2_end_));
     }
 
     // Getters
-#ifdef DEBUG
-    inline const auto& name() const { return name_; }
-#endif
     inline auto row() const { return row_; }
     inline auto a1() const { return a1_; }
     inline auto a2() const { return a2_; }
     inline auto begin() const { return ets_; }
     inline auto size() const { return a2_end_; }
+    inline auto age() const { return age_; }
     inline const EdgeTime* a1_edge_times_begin() const { return &ets_[0]; }
     inline const EdgeTime* a1_edge_times_end() const { return &ets_[a1_end]; }
     inline const EdgeTime* a2_edge_times_begin() const { return &ets_[a1_end]; }
@@ -101,8 +103,18 @@ class TwoAgentRobustCut
 
     // Setters
     inline void set_row(SCIP_ROW* row) { row_ = row; }
+    inline void set_age(const Int age) { age_ = age; }
     inline EdgeTime& a1_edge_time(const Int idx) { return ets_[idx]; }
     inline EdgeTime& a2_edge_time(const Int idx) { return ets_[a1_end + idx]; }
 };
 
+// Two-agent robust cut waiting for the cut selection at the end of the separation round
+struct RobustCutCandidate
+{
+    SCIP_SEPA* sepa;           // Separator that found the cut
+    TwoAgentRobustCut cut;     // Data for the cut
+    SCIP_Real rhs;             // RHS
+    SCIP_Real efficacy;        // Violation divided by the norm of the cut over its edge-times
+};
+
 #endif
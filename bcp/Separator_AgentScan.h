@@ -0,0 +1,86 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#ifndef MAPF_SEPARATOR_AGENTSCAN_H
+#define MAPF_SEPARATOR_AGENTSCAN_H
+
+#include "Includes.h"
+#include "AgentValues.h"
+
+// Call a function on every candidate second agent whose LHS is violated. The LHS of an agent is the base value plus
+// the value of the agent in each of the edges of SCIPprobdataGetFractionalEdgesVec. Missing edges are given as
+// nullptr and skipped, so callers do not need an array of zeros. The candidates are usually a list from
+// SCIPprobdataGetFractionalAgents since other agents have no value in any of the arrays. The LHS is compared using
+// the given tolerance so that separation logs can be scanned without SCIP.
+template<size_t K, class Iterator, class F>
+inline void scan_violated_agents(
+    const SCIP_Real epsilon,                      // Tolerance of sums
+    const Array<AgentValues, K>& arrays,          // Values of each edge by agent
+    const Int nb_arrays,                          // Number of arrays used
+    const SCIP_Real base,                         // Value of the LHS shared by all agents
+    const Iterator begin,                         // First candidate agent
+    const Iterator end,                           // One past the last candidate agent
+    const Agent skip,                             // Agent excluded from the candidates
+    F&& f                                         // Function called with the agent and the LHS
+)
+{
+    // Remove missing arrays.
+    debug_assert(nb_arrays <= static_cast<Int>(K));
+    Array<AgentValues, K> vals;
+    Int nb_vals = 0;
+    for (Int idx = 0; idx < nb_arrays; ++idx)
+        if (arrays[idx])
+        {
+            vals[nb_vals] = arrays[idx];
+            ++nb_vals;
+        }
+
+    // Check the agents.
+    for (auto it = begin; it != end; ++it)
+        if (const Agent a2 = *it; a2 != skip)
+        {
+            SCIP_Real lhs = base;
+            for (Int idx = 0; idx < nb_vals; ++idx)
+            {
+                lhs += vals[idx][a2];
+            }
+            if (lhs - (1.0 + CUT_VIOLATION) > epsilon)
+            {
+                f(a2, lhs);
+            }
+        }
+}
+
+// Call a function on every candidate second agent whose LHS is violated using the tolerance of SCIP
+template<size_t K, class Iterator, class F>
+inline void scan_violated_agents(
+    SCIP* scip,                                   // SCIP
+    const Array<AgentValues, K>& arrays,          // Values of each edge by agent
+    const Int nb_arrays,                          // Number of arrays used
+    const SCIP_Real base,                         // Value of the LHS shared by all agents
+    const Iterator begin,                         // First candidate agent
+    const Iterator end,                           // One past the last candidate agent
+    const Agent skip,                             // Agent excluded from the candidates
+    F&& f                                         // Function called with the agent and the LHS
+)
+{
+    scan_violated_agents<K>(SCIPsumepsilon(scip), arrays, nb_arrays, base, begin, end, skip, std::forward<F>(f));
+}
+
+#endif
@@ -24,6 +24,8 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Separator_AgentWaitEdgeConflicts.h"
 #include "ProblemData.h"
 #include "VariableData.h"
+#include "Trace.h"
+#include "Separator_Scheduling.h"
 
 #define SEPA_NAME         "agent_wait_edge"
 #define SEPA_DESC         "Separator for agent wait edge conflicts"
@@ -36,9 +38,9 @@ Author: Edward Lam <ed@ed-lam.com>
 struct AgentWaitEdgeConflictCandidate
 {
     EdgeTime a1_et2;
-    SCIP_Real* a1_et2_vals;
+    AgentValues a1_et2_vals;
     Array<EdgeTime, 5> a2_et23456s;
-    Array<SCIP_Real*, 5> a2_et23456_vals;
+    Array<AgentValues, 5> a2_et23456_vals;
 };
 
 struct AgentWaitEdgeConflictData
@@ -71,62 +73,8 @@ SCIP_RETCODE agentwaitedge_conflicts_create_cut(
     SCIP_Result* result         // Output result
 )
 {
-    // Create constraint name.
-#ifdef DEBUG
-    const auto& map = SCIPprobdataGetMap(probdata);
-
-    const auto [a1_et1_x1, a1_et1_y1] = map.get_xy(a1_et1.n);
-    const auto [a1_et1_x2, a1_et1_y2] = map.get_destination_xy(a1_et1);
-
-    const auto [a1_et2_x1, a1_et2_y1] = map.get_xy(a1_et2.n);
-    const auto [a1_et2_x2, a1_et2_y2] = map.get_destination_xy(a1_et2);
-
-    const auto [a2_et1_x1, a2_et1_y1] = map.get_xy(a2_et1.n);
-    const auto [a2_et1_x2, a2_et1_y2] = map.get_destination_xy(a2_et1);
-
-    const auto [a2_et2_x1, a2_et2_y1] = map.get_xy(a2_et2.n);
-    const auto [a2_et2_x2, a2_et2_y2] = map.get_destination_xy(a2_et2);
-
-    const auto [a2_et3_x1, a2_et3_y1] = map.get_xy(a2_et3.n);
-    const auto [a2_et3_x2, a2_et3_y2] = map.get_destination_xy(a2_et3);
-
-    const auto [a2_et4_x1, a2_et4_y1] = map.get_xy(a2_et4.n);
-    const auto [a2_et4_x2, a2_et4_y2] = map.get_destination_xy(a2_et4);
-
-    const auto [a2_et5_x1, a2_et5_y1] = map.get_xy(a2_et5.n);
-    const auto [a2_et5_x2, a2_et5_y2] = map.get_destination_xy(a2_et5);
-
-    const auto [a2_et6_x1, a2_et6_y1] = map.get_xy(a2_et6.n);
-    const auto [a2_et6_x2, a2_et6_y2] = map.get_destination_xy(a2_et6);
-
-    auto name = fmt::format("agentwaitedge_conflict("
-                            "{},{},"
-                            "(({},{}),({},{}),{}),"
-                            "(({},{}),({},{}),{}),"
-                            "(({},{}),({},{}),{}),"
-                            "(({},{}),({},{}),{}),"
-                            "(({},{}),({},{}),{}),"
-                            "(({},{}),({},{}),{}),"
-                            "(({},{}),({},{}),{}),"
-                            "(({},{}),({},{}),{})"
-                            ")",
-                            a1, a2,
-                            a1_et1_x1, a1_et1_y1, a1_et1_x2, a1_et1_y2, a1_et1.t,
-                            a1_et2_x1, a1_et2_y1, a1_et2_x2, a1_et2_y2, a1_et2.t,
-                            a2_et1_x1, a2_et1_y1, a2_et1_x2, a2_et1_y2, a2_et1.t,
-                            a2_et2_x1, a2_et2_y1, a2_et2_x2, a2_et2_y2, a2_et2.t,
-                            a2_et3_x1, a2_et3_y1, a2_et3_x2, a2_et3_y2, a2_et3.t,
-                            a2_et4_x1, a2_et4_y1, a2_et4_x2, a2_et4_y2, a2_et4.t,
-                            a2_et5_x1, a2_et5_y1, a2_et5_x2, a2_et5_y2, a2_et5.t,
-                            a2_et6_x1, a2_et6_y1, a2_et6_x2, a2_et6_y2, a2_et6.t);
-#endif
-
     // Create data for the cut.
-    TwoAgentRobustCut cut(scip, a1, a2, 2, 6
-#ifdef DEBUG
-        , std::move(name)
-#endif
-    );
+    TwoAgentRobustCut cut(scip, a1, a2, 2, 6);
     cut.a1_edge_time(0) = a1_et1;
     cut.a1_edge_time(1) = a1_et2;
     cut.a2_edge_time(0) = a2_et1;
@@ -146,7 +94,7 @@ SCIP_RETCODE agentwaitedge_conflicts_create_cut(
 Vector<AgentWaitEdgeConflictCandidate> get_candidates(
     const EdgeTime a1_et1,
     const EdgeTime a2_et1,
-    const HashTable<EdgeTime, SCIP_Real*>& fractional_edges_vec,
+    const HashTable<EdgeTime, AgentValues>& fractional_edges_vec,
     const Map& map
 )
 {
@@ -354,9 +302,8 @@ SCIP_RETCODE agentwaitedge_conflicts_separate(
     const auto N = SCIPprobdataGetN(probdata);
     const auto& map = SCIPprobdataGetMap(probdata);
 
-    // Skip this separator if an earlier separator found cuts.
-    auto& found_cuts = SCIPprobdataGetFoundCutsIndicator(probdata);
-    if (found_cuts)
+    // Skip this separator if an earlier separator found cuts or if its recent calls did not pay off.
+    if (!separator_should_run(scip, sepa))
     {
         return SCIP_OKAY;
     }
@@ -364,6 +311,9 @@ SCIP_RETCODE agentwaitedge_conflicts_separate(
     // Get the edges fractionally used by each agent.
     const auto& fractional_edges_vec = SCIPprobdataGetFractionalEdgesVec(probdata);
 
+    // Get the agents with a fractional edge or meeting a fractional edge.
+    const auto& active_agents = SCIPprobdataGetActiveAgents(probdata);
+
     // Find conflicts.
     Vector<AgentWaitEdgeConflictData> cuts;
     for (const auto& [a1_et1, a1_et1_vals] : fractional_edges_vec)
@@ -381,13 +331,13 @@ SCIP_RETCODE agentwaitedge_conflicts_separate(
             // Loop through the cut candidates.
             const auto candidates = get_candidates(a1_et1, a2_et1, fractional_edges_vec, map);
             for (const auto& [a1_et2, a1_et2_vals, a2_et23456s, a2_et23456_vals] : candidates)
-                for (Agent a1 = 0; a1 < N; ++a1)
+                for (const auto a1 : active_agents)
                 {
                     const auto a1_et1_val = a1_et1_vals[a1];
                     const auto a1_et2_val = a1_et2_vals[a1];
                     if (a1_et1_val > 0 && a1_et2_val > 0)
                     {
-                        for (Agent a2 = 0; a2 < N; ++a2)
+                        for (const auto a2 : active_agents)
                             if (a2 != a1)
                             {
                                 const auto a2_et1_val = a2_et1_vals[a2];
@@ -533,6 +483,9 @@ SCIP_DECL_SEPACOPY(sepaCopyAgentWaitEdgeConflicts)
 static
 SCIP_DECL_SEPAEXECLP(sepaExeclpAgentWaitEdgeConflicts)
 {
+    // Trace.
+    const TraceScope trace(SEPA_NAME);
+
     // Check.
     debug_assert(scip);
     debug_assert(sepa);
@@ -24,6 +24,8 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Separator_CliqueConflicts.h"
 #include "ProblemData.h"
 #include "VariableData.h"
+#include "Trace.h"
+#include "Separator_Scheduling.h"
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wsign-compare"
@@ -44,6 +46,7 @@ extern "C" {
 #define MIN_CLIQUE_SIZE                                                  3
 #define MAX_CLIQUE_SIZE                                                  6
 #define MAX_CLIQUES                                                  20000
+#define CLIQUE_TIME_LIMIT                                              0.5    // Seconds for enumerating cliques
 
 struct CliqueItem
 {
@@ -118,6 +121,12 @@ struct CliquerUserData
     size_t nb_cliques;
 };
 
+// Stop Cliquer once the time limit is reached
+boolean cliquer_time_limit(int, int, int, int, double, double real_time, clique_options*)
+{
+    return real_time < CLIQUE_TIME_LIMIT;
+}
+
 bool incompatible(const CliqueItem item1, const CliqueItem item2)
 {
     if (item1.a == item2.a)
@@ -222,44 +231,12 @@ SCIP_RETCODE clique_conflicts_create_cut(
         }
     }
 
-    // Create constraint name.
-#ifdef DEBUG
-    String str1;
-    String str2;
-    for (auto it = clique_items.begin(); it != clique_items.end(); ++it)
-    {
-        const auto& item = *it;
-        auto& str = item.a == a1 ? str1 : str2;
-        if (item.is_vertex())
-        {
-            if (!str.empty())
-            {
-                str += ", ";
-            }
-            str += fmt::format("(({},{}),{})", item.x1, item.y1, item.t);
-        }
-        else
-        {
-            if (!str.empty())
-            {
-                str += ", ";
-            }
-            str += fmt::format("(({},{}),({},{}),{})", item.x1, item.y1, item.x2, item.y2, item.t);
-        }
-    }
-    auto name = fmt::format("clique_conflict({},{},({}),({}))", a1, a2, str1, str2);
-#endif
-
     // Create data for the cut.
     TwoAgentRobustCut cut(scip,
                           a1,
                           a2,
                           ets1.size(),
-                          ets2.size()
-#ifdef DEBUG
-                        , std::move(name)
-#endif
-    );
+                          ets2.size());
     for (Int idx = 0; idx < static_cast<Int>(ets1.size()); ++idx)
     {
         cut.a1_edge_time(idx) = ets1[idx];
@@ -391,7 +368,7 @@ boolean cliquer_callback(set_t clique, graph_t*, clique_options* opts)
         }
 //#endif
         nb_cliques++;
-        return nb_cliques >= MAX_CLIQUES;
+        return nb_cliques < MAX_CLIQUES;
     }
     else
     {
@@ -421,9 +398,8 @@ SCIP_RETCODE clique_conflicts_separate(
     const auto N = SCIPprobdataGetN(probdata);
     const auto& map = SCIPprobdataGetMap(probdata);
 
-    // Skip this separator if an earlier separator found cuts.
-    auto& found_cuts = SCIPprobdataGetFoundCutsIndicator(probdata);
-    if (found_cuts)
+    // Skip this separator if an earlier separator found cuts or if its recent calls did not pay off.
+    if (!separator_should_run(scip, sepa))
     {
         return SCIP_OKAY;
     }
@@ -506,7 +482,7 @@ SCIP_RETCODE clique_conflicts_separate(
 
     // Create the data for each node in the conflict graph.
     Vector<CliqueItem> items;
-    for (const auto [nt, agents] : vertex_agents)
+    for (const auto& [nt, agents] : vertex_agents)
     {
 #ifdef RUN_ONLY_ON_MULTI_AGENT_RESOURCES
         Agent nb_agents = 0;
@@ -531,7 +507,7 @@ SCIP_RETCODE clique_conflicts_separate(
                 }
         }
     }
-    for (const auto [et, agents] : edge_agents)
+    for (const auto& [et, agents] : edge_agents)
     {
 #ifdef RUN_ONLY_ON_MULTI_AGENT_RESOURCES
         Agent nb_agents = 0;
@@ -560,26 +536,70 @@ SCIP_RETCODE clique_conflicts_separate(
     // Find cliques.
     if (!items.empty())
     {
-        // Create the conflict graph.
+        // Group the items. Items of different agents can only be incompatible if they occupy the same node-time or
+        // cross the same edge in opposite directions.
+        Vector<Vector<Int>> agent_items(N);
+        HashTable<NodeTime, Vector<Int>> node_time_items;
+        HashTable<EdgeTime, Vector<Int>> edge_time_items;
+        for (Int i = 0; i < static_cast<Int>(items.size()); ++i)
+        {
+            const auto& item = items[i];
+            agent_items[item.a].push_back(i);
+            if (item.is_vertex())
+            {
+                node_time_items[item.nt].push_back(i);
+            }
+            else
+            {
+                node_time_items[NodeTime{item.et.n, item.t}].push_back(i);
+                node_time_items[NodeTime{map.get_destination(item.et), item.t + 1}].push_back(i);
+                edge_time_items[EdgeTime{map.get_undirected_edge(item.et.et.e), item.t}].push_back(i);
+            }
+        }
+
+        // Create the conflict graph. Items of the same agent are compared exhaustively since most of them are
+        // incompatible in time. Items of different agents are only compared within a group.
         auto graph = graph_new(items.size());
         for (size_t i = 0; i < items.size(); ++i)
         {
             graph->weights[i] = items[i].val * 100;
-
-            for (size_t j = i + 1; j < items.size(); ++j)
-                if (incompatible(items[i], items[j]))
+        }
+        const auto add_edges = [&](const Vector<Int>& group, const bool same_agent)
+        {
+            for (auto it1 = group.begin(); it1 != group.end(); ++it1)
+                for (auto it2 = it1 + 1; it2 != group.end(); ++it2)
                 {
-                    GRAPH_ADD_EDGE(graph, i, j);
+                    const auto i = *it1;
+                    const auto j = *it2;
+                    if ((items[i].a == items[j].a) == same_agent && !GRAPH_IS_EDGE(graph, i, j) &&
+                        incompatible(items[i], items[j]))
+                    {
+                        GRAPH_ADD_EDGE(graph, i, j);
+                    }
                 }
+        };
+        for (const auto& group : agent_items)
+        {
+            add_edges(group, true);
+        }
+        for (const auto& [_, group] : node_time_items)
+        {
+            add_edges(group, false);
+        }
+        for (const auto& [_, group] : edge_time_items)
+        {
+            add_edges(group, false);
         }
 
-        // Run Cliquer.
+        // Run Cliquer with a time limit.
         CliquerUserData user_data{scip, sepa, result, items, 0};
-        clique_default_options->user_data = static_cast<void*>(&user_data);
-        clique_default_options->user_function = cliquer_callback;
-        clique_default_options->time_function = nullptr;
-//        clique_unweighted_find_all(graph, MIN_CLIQUE_SIZE, MAX_CLIQUE_SIZE, false, nullptr);
-        clique_find_all(graph, 1.1 * 100.0, 0, false, nullptr);
+        clique_options opts = *clique_default_options;
+        opts.user_data = static_cast<void*>(&user_data);
+        opts.user_function = cliquer_callback;
+        opts.time_function = cliquer_time_limit;
+//        clique_unweighted_find_all(graph, MIN_CLIQUE_SIZE, MAX_CLIQUE_SIZE, false, &opts);
+        clique_find_all(graph, 1.1 * 100.0, 0, false, &opts);
+        graph_free(graph);
     }
 
     // Done.
@@ -611,6 +631,9 @@ SCIP_DECL_SEPACOPY(sepaCopyCliqueConflicts)
 static
 SCIP_DECL_SEPAEXECLP(sepaExeclpCliqueConflicts)
 {
+    // Trace.
+    const TraceScope trace(SEPA_NAME);
+
     // Check.
     debug_assert(scip);
     debug_assert(sepa);
@@ -24,6 +24,10 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Separator_CorridorConflicts.h"
 #include "ProblemData.h"
 #include "VariableData.h"
+#include "Trace.h"
+#include "Separator_Parallel.h"
+#include "Separator_AgentScan.h"
+#include "Separator_Scheduling.h"
 
 #ifdef USE_WAITCORRIDOR_CONFLICTS
 #define SEPA_NAME         "wait_corridor"
@@ -37,21 +41,6 @@ Author: Edward Lam <ed@ed-lam.com>
 #define SEPA_USESSUBSCIP  FALSE    // does the separator use a secondary SCIP instance? */
 #define SEPA_DELAY        FALSE    // should separation method be delayed, if other separators found cuts? */
 
-struct CorridorConflictData
-{
-    SCIP_Real lhs;
-    Agent a1;
-    Agent a2;
-    EdgeTime a1_et1;
-    EdgeTime a1_et2;
-#ifdef USE_WAITCORRIDOR_CONFLICTS
-    EdgeTime a1_et3;
-    EdgeTime a1_et4;
-#endif
-    EdgeTime a2_et1;
-    EdgeTime a2_et2;
-};
-
 #define MATRIX(i,j) (i * N + j)
 
 SCIP_RETCODE corridor_conflicts_create_cut(
@@ -71,20 +60,6 @@ SCIP_RETCODE corridor_conflicts_create_cut(
     SCIP_Result* result         // Output result
 )
 {
-    // Create constraint name.
-#ifdef DEBUG
-    const auto& map = SCIPprobdataGetMap(probdata);
-    const auto [a1_x1, a1_y1] = map.get_xy(a1_et1.n);
-    const auto [a1_x2, a1_y2] = map.get_xy(a1_et2.n);
-    const auto [a2_x1, a2_y1] = map.get_xy(a2_et1.n);
-    const auto [a2_x2, a2_y2] = map.get_xy(a2_et2.n);
-    auto name = fmt::format("corridor_conflict("
-                            "{},(({},{}),({},{}),{}),"
-                            "{},(({},{}),({},{}),{}))",
-                            a1, a1_x1, a1_y1, a1_x2, a1_y2, a1_et1.t,
-                            a2, a2_x1, a2_y1, a2_x2, a2_y2, a2_et1.t);
-#endif
-
     // Create data for the cut.
     TwoAgentRobustCut cut(scip,
                           a1,
@@ -94,11 +69,7 @@ SCIP_RETCODE corridor_conflicts_create_cut(
 #else
                           2,
 #endif
-                          2
-#ifdef DEBUG
-                        , std::move(name)
-#endif
-    );
+                          2);
     cut.a1_edge_time(0) = a1_et1;
     cut.a1_edge_time(1) = a1_et2;
 #ifdef USE_WAITCORRIDOR_CONFLICTS
@@ -115,6 +86,98 @@ SCIP_RETCODE corridor_conflicts_create_cut(
     return SCIP_OKAY;
 }
 
+// Find the violated corridor conflicts of an agent
+void find_corridor_conflicts(
+    const Map& map,                                                   // Map
+    const HashTable<EdgeTime, SCIP_Real>& fractional_edges_a1,        // Edges fractionally used by agent 1
+    const HashTable<EdgeTime, AgentValues>& fractional_edges_vec,     // Values of each edge by agent
+    const HashTable<NodeTime, Vector<Agent>>& fractional_agents,      // Agents at each node-time
+    const Agent a1,                                                   // Agent 1
+    const SCIP_Real epsilon,                                          // Tolerance of sums
+    Vector<CorridorConflictData>& agent_cuts                          // Output candidate cuts
+)
+{
+    // Find the agents at a node-time.
+    static const Vector<Agent> no_agents;
+    const auto get_fractional_agents = [&](const NodeTime nt) -> const Vector<Agent>&
+    {
+        const auto it = fractional_agents.find(nt);
+        return it != fractional_agents.end() ? it->second : no_agents;
+    };
+
+    // Loop through the first edge of agent 1.
+    Vector<Agent> a2_candidates;
+    for (const auto& [a1_et1, a1_et1_val] : fractional_edges_a1)
+        if (a1_et1.d != Direction::WAIT)
+        {
+            const auto t = a1_et1.t;
+
+            // Get the second edge of agent 1.
+            const EdgeTime a1_et2{a1_et1.et.e, a1_et1.t + 1};
+            const auto a1_et2_it = fractional_edges_a1.find(a1_et2);
+            const auto a1_et2_val = a1_et2_it != fractional_edges_a1.end() ? a1_et2_it->second : 0.0;
+
+            // Get the first edge of agent 2.
+            const EdgeTime a2_et1{map.get_opposite_edge(a1_et1.et.e), t};
+            const auto a2_et1_it = fractional_edges_vec.find(a2_et1);
+            const AgentValues a2_et1_vals = a2_et1_it != fractional_edges_vec.end() ? a2_et1_it->second : nullptr;
+
+            // Get the second edge of agent 2.
+            const EdgeTime a2_et2{a2_et1.et.e, a2_et1.t + 1};
+            const auto a2_et2_it = fractional_edges_vec.find(a2_et2);
+            const AgentValues a2_et2_vals = a2_et2_it != fractional_edges_vec.end() ? a2_et2_it->second : nullptr;
+
+#ifdef USE_WAITCORRIDOR_CONFLICTS
+            // Get the third edge of agent 1.
+            const EdgeTime a1_et3{a2_et1.n, Direction::WAIT, a2_et1.t};
+            const auto a1_et3_it = fractional_edges_a1.find(a1_et3);
+            const auto a1_et3_val = a1_et3_it != fractional_edges_a1.end() ? a1_et3_it->second : 0.0;
+
+            // Get the fourth edge of agent 1.
+            const EdgeTime a1_et4{a1_et2.n, Direction::WAIT, a1_et2.t};
+            const auto a1_et4_it = fractional_edges_a1.find(a1_et4);
+            const auto a1_et4_val = a1_et4_it != fractional_edges_a1.end() ? a1_et4_it->second : 0.0;
+#endif
+
+            // Get the agents using an edge at the start vertex of the edges of agent 1. Other agents have no
+            // fractional value on any edge of the cut.
+            const auto& a2_candidates_t1 = get_fractional_agents(a1_et1.nt());
+            const auto& a2_candidates_t2 = get_fractional_agents(a1_et2.nt());
+            a2_candidates.clear();
+            std::set_union(a2_candidates_t1.begin(), a2_candidates_t1.end(),
+                           a2_candidates_t2.begin(), a2_candidates_t2.end(),
+                           std::back_inserter(a2_candidates));
+
+            // Store a cut for every second agent with a violated LHS.
+            const auto a1_lhs = a1_et1_val + a1_et2_val
+#ifdef USE_WAITCORRIDOR_CONFLICTS
+                              + a1_et3_val + a1_et4_val
+#endif
+                              ;
+            scan_violated_agents<2>(epsilon,
+                                    {a2_et1_vals, a2_et2_vals},
+                                    2,
+                                    a1_lhs,
+                                    a2_candidates.begin(),
+                                    a2_candidates.end(),
+                                    a1,
+                                    [&](const Agent a2, const SCIP_Real lhs)
+            {
+                agent_cuts.emplace_back(CorridorConflictData{lhs,
+                                                             a1,
+                                                             a2,
+                                                             a1_et1,
+                                                             a1_et2,
+#ifdef USE_WAITCORRIDOR_CONFLICTS
+                                                             a1_et3,
+                                                             a1_et4,
+#endif
+                                                             a2_et1,
+                                                             a2_et2});
+            });
+        }
+}
+
 // Separator
 static
 SCIP_RETCODE corridor_conflicts_separate(
@@ -137,9 +200,9 @@ SCIP_RETCODE corridor_conflicts_separate(
     const auto N = SCIPprobdataGetN(probdata);
     const auto& map = SCIPprobdataGetMap(probdata);
 
-    // Skip this separator if an earlier separator found cuts.
+    // Skip this separator if an earlier separator found cuts or if its recent calls did not pay off.
     auto& found_cuts = SCIPprobdataGetFoundCutsIndicator(probdata);
-    if (found_cuts)
+    if (!separator_should_run(scip, sepa))
     {
         return SCIP_OKAY;
     }
@@ -147,81 +210,23 @@ SCIP_RETCODE corridor_conflicts_separate(
     // Get the edges fractionally used by each agent.
     const auto& fractional_edges = SCIPprobdataGetFractionalEdges(probdata);
     const auto& fractional_edges_vec = SCIPprobdataGetFractionalEdgesVec(probdata);
+    const auto& fractional_agents = SCIPprobdataGetFractionalAgentsByNodeTime(probdata);
 
     // Find conflicts.
-    Vector<CorridorConflictData> cuts;
-    auto zeros = std::make_unique<SCIP_Real[]>(N);
-    for (Agent a1 = 0; a1 < N - 1; ++a1)
+    const auto epsilon = SCIPsumepsilon(scip);
+    auto cuts = find_cuts_in_parallel<CorridorConflictData>(scip,
+                                                            0,
+                                                            N - 1,
+                                                            [&](const Agent a1, Vector<CorridorConflictData>& agent_cuts)
     {
-        // Get the edges of agent 1.
-        const auto& fractional_edges_a1 = fractional_edges[a1];
-
-        // Loop through the first edge of agent 1.
-        for (const auto& [a1_et1, a1_et1_val] : fractional_edges_a1)
-            if (a1_et1.d != Direction::WAIT)
-            {
-                const auto t = a1_et1.t;
-
-                // Get the second edge of agent 1.
-                const EdgeTime a1_et2{a1_et1.et.e, a1_et1.t + 1};
-                const auto a1_et2_it = fractional_edges_a1.find(a1_et2);
-                const auto a1_et2_val = a1_et2_it != fractional_edges_a1.end() ? a1_et2_it->second : 0.0;
-
-                // Get the first edge of agent 2.
-                const EdgeTime a2_et1{map.get_opposite_edge(a1_et1.et.e), t};
-                const auto a2_et1_it = fractional_edges_vec.find(a2_et1);
-                const auto a2_et1_vals = a2_et1_it != fractional_edges_vec.end() ? a2_et1_it->second : zeros.get();
-
-                // Get the second edge of agent 2.
-                const EdgeTime a2_et2{a2_et1.et.e, a2_et1.t + 1};
-                const auto a2_et2_it = fractional_edges_vec.find(a2_et2);
-                const auto a2_et2_vals = a2_et2_it != fractional_edges_vec.end() ? a2_et2_it->second : zeros.get();
-
-#ifdef USE_WAITCORRIDOR_CONFLICTS
-                // Get the third edge of agent 1.
-                const EdgeTime a1_et3{a2_et1.n, Direction::WAIT, a2_et1.t};
-                const auto a1_et3_it = fractional_edges_a1.find(a1_et3);
-                const auto a1_et3_val = a1_et3_it != fractional_edges_a1.end() ? a1_et3_it->second : 0.0;
-
-                // Get the fourth edge of agent 1.
-                const EdgeTime a1_et4{a1_et2.n, Direction::WAIT, a1_et2.t};
-                const auto a1_et4_it = fractional_edges_a1.find(a1_et4);
-                const auto a1_et4_val = a1_et4_it != fractional_edges_a1.end() ? a1_et4_it->second : 0.0;
-#endif
-
-                // Loop through the second agent.
-                for (Agent a2 = 0; a2 < N; ++a2)
-                    if (a2 != a1)
-                    {
-                        // Get values of the edges of agent 2.
-                        const auto a2_et1_val = a2_et1_vals[a2];
-                        const auto a2_et2_val = a2_et2_vals[a2];
-
-                        // Compute the LHS.
-                        const auto lhs = a1_et1_val + a1_et2_val +
-#ifdef USE_WAITCORRIDOR_CONFLICTS
-                                         a1_et3_val + a1_et4_val +
-#endif
-                                         a2_et1_val + a2_et2_val;
-
-                        // Store a cut if violated.
-                        if (SCIPisSumGT(scip, lhs, 1.0 + CUT_VIOLATION))
-                        {
-                            cuts.emplace_back(CorridorConflictData{lhs,
-                                                                   a1,
-                                                                   a2,
-                                                                   a1_et1,
-                                                                   a1_et2,
-#ifdef USE_WAITCORRIDOR_CONFLICTS
-                                                                   a1_et3,
-                                                                   a1_et4,
-#endif
-                                                                   a2_et1,
-                                                                   a2_et2});
-                        }
-                    }
-            }
-    }
+        find_corridor_conflicts(map,
+                                fractional_edges[a1],
+                                fractional_edges_vec,
+                                fractional_agents,
+                                a1,
+                                epsilon,
+                                agent_cuts);
+    });
 
     // Create the most violated cuts.
     Vector<Int> agent_nb_cuts(N * N);
@@ -339,6 +344,9 @@ SCIP_DECL_SEPACOPY(sepaCopyCorridorConflicts)
 static
 SCIP_DECL_SEPAEXECLP(sepaExeclpCorridorConflicts)
 {
+    // Trace.
+    const TraceScope trace(SEPA_NAME);
+
     // Check.
     debug_assert(scip);
     debug_assert(sepa);
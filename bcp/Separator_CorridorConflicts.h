@@ -23,6 +23,36 @@ Author: Edward Lam <ed@ed-lam.com>
 #define MAPF_SEPARATOR_CORRIDORCONFLICTS_H
 
 #include "Includes.h"
+#include "Coordinates.h"
+#include "AgentValues.h"
+#include "trufflehog/Map.h"
+
+struct CorridorConflictData
+{
+    SCIP_Real lhs;
+    Agent a1;
+    Agent a2;
+    EdgeTime a1_et1;
+    EdgeTime a1_et2;
+#ifdef USE_WAITCORRIDOR_CONFLICTS
+    EdgeTime a1_et3;
+    EdgeTime a1_et4;
+#endif
+    EdgeTime a2_et1;
+    EdgeTime a2_et2;
+};
+
+// Find the violated corridor conflicts of an agent. The search only reads the fractional edges so it can also run on
+// a separation log without SCIP.
+void find_corridor_conflicts(
+    const Map& map,                                                   // Map
+    const HashTable<EdgeTime, SCIP_Real>& fractional_edges_a1,        // Edges fractionally used by agent 1
+    const HashTable<EdgeTime, AgentValues>& fractional_edges_vec,     // Values of each edge by agent
+    const HashTable<NodeTime, Vector<Agent>>& fractional_agents,      // Agents at each node-time
+    const Agent a1,                                                   // Agent 1
+    const SCIP_Real epsilon,                                          // Tolerance of sums
+    Vector<CorridorConflictData>& agent_cuts                          // Output candidate cuts
+);
 
 // Create separator for corridor conflicts and include it
 SCIP_RETCODE SCIPincludeSepaCorridorConflicts(
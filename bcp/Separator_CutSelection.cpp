@@ -0,0 +1,137 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+
+// #define PRINT_DEBUG
+
+#include "Separator_CutSelection.h"
+#include "ProblemData.h"
+#include "Trace.h"
+
+#define SEPA_NAME         "cut_selection"
+#define SEPA_DESC         "Separator for selecting the two-agent robust cuts found in the round"
+#define SEPA_PRIORITY     -1000000 // priority of the constraint handler for separation
+#define SEPA_FREQ         1        // frequency for separating cuts; zero means to separate only in the root node
+#define SEPA_MAXBOUNDDIST 1.0
+#define SEPA_USESSUBSCIP  FALSE    // does the separator use a secondary SCIP instance? */
+#define SEPA_DELAY        FALSE    // should separation method be delayed, if other separators found cuts? */
+
+#define DEFAULT_CUT_SELECTION_MAX_CUTS -1           // Maximum number of cuts added in a round (0: no limit, -1: add every cut when found)
+#define DEFAULT_CUT_SELECTION_MAX_PARALLELISM 0.8   // Maximum parallelism of a cut with the cuts selected before it
+
+// Copy method for separator
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_SEPACOPY(sepaCopyCutSelection)
+{
+    // Check.
+    debug_assert(scip);
+    debug_assert(sepa);
+    debug_assert(strcmp(SCIPsepaGetName(sepa), SEPA_NAME) == 0);
+
+    // Include separator.
+    SCIP_CALL(SCIPincludeSepaCutSelection(scip));
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Separation method for LP solutions
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_SEPAEXECLP(sepaExeclpCutSelection)
+{
+    // Trace.
+    const TraceScope trace(SEPA_NAME);
+
+    // Check.
+    debug_assert(scip);
+    debug_assert(sepa);
+    debug_assert(strcmp(SCIPsepaGetName(sepa), SEPA_NAME) == 0);
+    debug_assert(result);
+
+    // Start.
+    *result = SCIP_DIDNOTFIND;
+
+    // Add the selected cuts.
+    auto probdata = SCIPgetProbData(scip);
+    SCIP_CALL(SCIPprobdataAddSelectedTwoAgentRobustCuts(scip, probdata, result));
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Create separator for selecting the two-agent robust cuts and include it in SCIP
+SCIP_RETCODE SCIPincludeSepaCutSelection(
+    SCIP* scip    // SCIP
+)
+{
+    // Check.
+    debug_assert(scip);
+
+    // Include separator.
+    SCIP_Sepa* sepa = nullptr;
+    SCIP_CALL(SCIPincludeSepaBasic(scip,
+                                   &sepa,
+                                   SEPA_NAME,
+                                   SEPA_DESC,
+                                   SEPA_PRIORITY,
+                                   SEPA_FREQ,
+                                   SEPA_MAXBOUNDDIST,
+                                   SEPA_USESSUBSCIP,
+                                   SEPA_DELAY,
+                                   sepaExeclpCutSelection,
+                                   nullptr,
+                                   nullptr));
+    debug_assert(sepa);
+
+    // Set callbacks.
+    SCIP_CALL(SCIPsetSepaCopy(scip, sepa, sepaCopyCutSelection));
+
+    // Add parameters.
+    SCIP_CALL(SCIPaddIntParam(scip,
+                              CUT_SELECTION_MAX_CUTS_PARAM,
+                              "maximum number of two-agent robust cuts added in a separation round, chosen by efficacy "
+                              "and parallelism (0: no limit, -1: add every cut when found without selection)",
+                              nullptr,
+                              FALSE,
+                              DEFAULT_CUT_SELECTION_MAX_CUTS,
+                              -1,
+                              std::numeric_limits<int>::max(),
+                              nullptr,
+                              nullptr));
+    SCIP_CALL(SCIPaddRealParam(scip,
+                               CUT_SELECTION_MAX_PARALLELISM_PARAM,
+                               "maximum parallelism over the edge-times of a selected two-agent robust cut with the "
+                               "cuts selected before it",
+                               nullptr,
+                               FALSE,
+                               DEFAULT_CUT_SELECTION_MAX_PARALLELISM,
+                               0.0,
+                               1.0,
+                               nullptr,
+                               nullptr));
+
+    // Done.
+    return SCIP_OKAY;
+}
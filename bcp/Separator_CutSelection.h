@@ -0,0 +1,35 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+
+#ifndef MAPF_SEPARATOR_CUTSELECTION_H
+#define MAPF_SEPARATOR_CUTSELECTION_H
+
+#include "Includes.h"
+
+#define CUT_SELECTION_MAX_CUTS_PARAM "separating/mapf/maxcuts"
+#define CUT_SELECTION_MAX_PARALLELISM_PARAM "separating/mapf/maxparallelism"
+
+// Create the separator that runs last in every separation round and adds the best of the two-agent robust cuts found
+// by the other separators in the round, and include it
+SCIP_RETCODE SCIPincludeSepaCutSelection(
+    SCIP* scip    // SCIP
+);
+
+#endif
@@ -24,6 +24,9 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Separator_ExitEntryConflicts.h"
 #include "ProblemData.h"
 #include "VariableData.h"
+#include "Trace.h"
+#include "Separator_AgentScan.h"
+#include "Separator_Scheduling.h"
 
 #define SEPA_NAME         "exit_entry"
 #define SEPA_DESC         "Separator for exit entry conflicts"
@@ -59,17 +62,8 @@ SCIP_RETCODE exitentry_conflicts_create_cut(
     SCIP_Result* result              // Output result
 )
 {
-    // Create constraint name.
-#ifdef DEBUG
-    auto name = fmt::format("exitentry_conflict({},{},{})", t, a1, a2);
-#endif
-
     // Create data for the cut.
-    TwoAgentRobustCut cut{scip, a1, a2, 1, a2_es_size
-#ifdef DEBUG
-        , std::move(name)
-#endif
-    };
+    TwoAgentRobustCut cut{scip, a1, a2, 1, a2_es_size};
     cut.a1_edge_time(0) = EdgeTime{a1_e, t};
     for (Int idx = 0; idx < a2_es_size; ++idx)
     {
@@ -106,9 +100,9 @@ SCIP_RETCODE exitentry_conflicts_separate(
     const auto N = SCIPprobdataGetN(probdata);
     const auto& map = SCIPprobdataGetMap(probdata);
 
-    // Skip this separator if an earlier separator found cuts.
+    // Skip this separator if an earlier separator found cuts or if its recent calls did not pay off.
     auto& found_cuts = SCIPprobdataGetFoundCutsIndicator(probdata);
-    if (found_cuts)
+    if (!separator_should_run(scip, sepa))
     {
         return SCIP_OKAY;
     }
@@ -117,9 +111,13 @@ SCIP_RETCODE exitentry_conflicts_separate(
     const auto& fractonal_move_edges = SCIPprobdataGetFractionalMoveEdges(probdata);
     const auto& fractional_edges_vec = SCIPprobdataGetFractionalEdgesVec(probdata);
 
+    // Get the agents with a fractional edge or meeting a fractional edge.
+    const auto& active_agents = SCIPprobdataGetActiveAgents(probdata);
+
     // Find conflicts.
     Vector<ExitEntryConflictData> cuts;
-    for (Agent a1 = 0; a1 < N; ++a1)
+    Vector<Agent> a2_candidates;
+    for (const auto a1 : active_agents)
     {
         // Get the edges of agent 1.
         const auto& fractional_move_edges_a1 = fractonal_move_edges[a1];
@@ -168,37 +166,40 @@ SCIP_RETCODE exitentry_conflicts_separate(
                 ++a2_es_size;
             }
 
+            // Remove the edges into or out of obstacles since no path can use them.
+            a2_es_size = std::remove_if(a2_es.begin(), a2_es.begin() + a2_es_size,
+                                        [&](const Edge e) { return !map.is_passable(e); }) - a2_es.begin();
+
             // Get the values of those edges.
-            Array<SCIP_Real*, 11> a2_es_vals{nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
-                                             nullptr, nullptr, nullptr, nullptr, nullptr};
-            Int a2_es_vals_size = 0;
+            Array<AgentValues, 11> a2_es_vals;
             for (Int idx = 0; idx < a2_es_size; ++idx)
             {
                 const auto e = a2_es[idx];
-                if (auto it = fractional_edges_vec.find(EdgeTime{e, t}); it != fractional_edges_vec.end())
-                {
-                    a2_es_vals[a2_es_vals_size] = it->second;
-                    ++a2_es_vals_size;
-                }
+                const auto it = fractional_edges_vec.find(EdgeTime{e, t});
+                a2_es_vals[idx] = it != fractional_edges_vec.end() ? it->second : nullptr;
             }
 
-            // Loop through the second agent.
-            for (Agent a2 = 0; a2 < N; ++a2)
-                if (a2 != a1)
-                {
-                    // Compute the LHS.
-                    SCIP_Real lhs = a1_et_val;
-                    for (Int idx = 0; idx < a2_es_vals_size; ++idx)
-                    {
-                        lhs += a2_es_vals[idx][a2];
-                    }
-
-                    // Store a cut if violated.
-                    if (SCIPisSumGT(scip, lhs, 1.0 + CUT_VIOLATION))
-                    {
-                        cuts.emplace_back(ExitEntryConflictData{lhs, a1, a2, a1_e, a2_es_size, a2_es, t});
-                    }
-                }
+            // Get the agents using an edge at either vertex. Other agents have no fractional value on any edge of
+            // the cut.
+            const auto& a2_candidates_n1 = SCIPprobdataGetFractionalAgents(probdata, NodeTime{n1, t});
+            const auto& a2_candidates_n2 = SCIPprobdataGetFractionalAgents(probdata, NodeTime{n2, t});
+            a2_candidates.clear();
+            std::set_union(a2_candidates_n1.begin(), a2_candidates_n1.end(),
+                           a2_candidates_n2.begin(), a2_candidates_n2.end(),
+                           std::back_inserter(a2_candidates));
+
+            // Store a cut for every second agent with a violated LHS.
+            scan_violated_agents(scip,
+                                 a2_es_vals,
+                                 a2_es_size,
+                                 a1_et_val,
+                                 a2_candidates.begin(),
+                                 a2_candidates.end(),
+                                 a1,
+                                 [&](const Agent a2, const SCIP_Real lhs)
+            {
+                cuts.emplace_back(ExitEntryConflictData{lhs, a1, a2, a1_e, a2_es_size, a2_es, t});
+            });
         }
     }
 
@@ -279,6 +280,9 @@ SCIP_DECL_SEPACOPY(sepaCopyExitEntryConflicts)
 static
 SCIP_DECL_SEPAEXECLP(sepaExeclpExitEntryConflicts)
 {
+    // Trace.
+    const TraceScope trace(SEPA_NAME);
+
     // Check.
     debug_assert(scip);
     debug_assert(sepa);
@@ -24,6 +24,8 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Separator_FiveEdgeConflicts.h"
 #include "ProblemData.h"
 #include "VariableData.h"
+#include "Trace.h"
+#include "Separator_Scheduling.h"
 
 #define SEPA_NAME         "five_edge"
 #define SEPA_DESC         "Separator for five edge conflicts"
@@ -47,47 +49,8 @@ SCIP_RETCODE fiveedge_conflicts_create_cut(
     SCIP_Result* result         // Output result
 )
 {
-    // Create constraint name.
-#ifdef DEBUG
-    const auto& map = SCIPprobdataGetMap(probdata);
-
-    const auto [a1_et1_x1, a1_et1_y1] = map.get_xy(a1_et1.n);
-    const auto [a1_et1_x2, a1_et1_y2] = map.get_destination_xy(a1_et1);
-
-    const auto [a1_et2_x1, a1_et2_y1] = map.get_xy(a1_et2.n);
-    const auto [a1_et2_x2, a1_et2_y2] = map.get_destination_xy(a1_et2);
-
-    const auto [a1_et3_x1, a1_et3_y1] = map.get_xy(a1_et3.n);
-    const auto [a1_et3_x2, a1_et3_y2] = map.get_destination_xy(a1_et3);
-
-    const auto [a2_et1_x1, a2_et1_y1] = map.get_xy(a2_et1.n);
-    const auto [a2_et1_x2, a2_et1_y2] = map.get_destination_xy(a2_et1);
-
-    const auto [a2_et2_x1, a2_et2_y1] = map.get_xy(a2_et2.n);
-    const auto [a2_et2_x2, a2_et2_y2] = map.get_destination_xy(a2_et2);
-
-    auto name = fmt::format("fiveedge_conflict("
-                            "{},{},"
-                            "(({},{}),({},{}),{}),"
-                            "(({},{}),({},{}),{}),"
-                            "(({},{}),({},{}),{}),"
-                            "(({},{}),({},{}),{}),"
-                            "(({},{}),({},{}),{})"
-                            ")",
-                            a1, a2,
-                            a1_et1_x1, a1_et1_y1, a1_et1_x2, a1_et1_y2, a1_et1.t,
-                            a1_et2_x1, a1_et2_y1, a1_et2_x2, a1_et2_y2, a1_et2.t,
-                            a1_et3_x1, a1_et3_y1, a1_et3_x2, a1_et3_y2, a1_et3.t,
-                            a2_et1_x1, a2_et1_y1, a2_et1_x2, a2_et1_y2, a2_et1.t,
-                            a2_et2_x1, a2_et2_y1, a2_et2_x2, a2_et2_y2, a2_et2.t);
-#endif
-
     // Create data for the cut.
-    TwoAgentRobustCut cut(scip, a1, a2, 3, 2
-#ifdef DEBUG
-        , std::move(name)
-#endif
-    );
+    TwoAgentRobustCut cut(scip, a1, a2, 3, 2);
     cut.a1_edge_time(0) = a1_et1;
     cut.a1_edge_time(1) = a1_et2;
     cut.a1_edge_time(2) = a1_et3;
@@ -120,12 +83,11 @@ SCIP_RETCODE fiveedge_conflicts_separate(
 
     // Get problem data.
     auto probdata = SCIPgetProbData(scip);
-    const auto N = SCIPprobdataGetN(probdata);
     const auto& map = SCIPprobdataGetMap(probdata);
 
-    // Skip this separator if an earlier separator found cuts.
+    // Skip this separator if an earlier separator found cuts or if its recent calls did not pay off.
     auto& found_cuts = SCIPprobdataGetFoundCutsIndicator(probdata);
-    if (found_cuts)
+    if (!separator_should_run(scip, sepa))
     {
         return SCIP_OKAY;
     }
@@ -133,8 +95,11 @@ SCIP_RETCODE fiveedge_conflicts_separate(
     // Get the edges fractionally used by each agent.
     const auto& fractional_move_edges = SCIPprobdataGetFractionalMoveEdges(probdata);
 
+    // Get the agents with a fractional edge or meeting a fractional edge.
+    const auto& active_agents = SCIPprobdataGetActiveAgents(probdata);
+
     // Find conflicts.
-    for (Agent a1 = 0; a1 < N; ++a1)
+    for (const auto a1 : active_agents)
     {
         // Get the edges of agent 1.
         const auto& fractional_move_edges_a1 = fractional_move_edges[a1];
@@ -168,7 +133,7 @@ SCIP_RETCODE fiveedge_conflicts_separate(
                                 const EdgeTime a2_et2{map.get_opposite_edge(a1_et2.et.e), a1_et2.t};
 
                                 // Loop through the second agent.
-                                for (Agent a2 = 0; a2 < N; ++a2)
+                                for (const auto a2 : active_agents)
                                     if (a2 != a1)
                                     {
                                         // Get the edges of agent 2.
@@ -275,6 +240,9 @@ SCIP_DECL_SEPACOPY(sepaCopyFiveEdgeConflicts)
 static
 SCIP_DECL_SEPAEXECLP(sepaExeclpFiveEdgeConflicts)
 {
+    // Trace.
+    const TraceScope trace(SEPA_NAME);
+
     // Check.
     debug_assert(scip);
     debug_assert(sepa);
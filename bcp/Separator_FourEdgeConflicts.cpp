@@ -24,6 +24,8 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Separator_FourEdgeConflicts.h"
 #include "ProblemData.h"
 #include "VariableData.h"
+#include "Trace.h"
+#include "Separator_Scheduling.h"
 
 #define SEPA_NAME         "four_edge"
 #define SEPA_DESC         "Separator for four edge conflicts"
@@ -46,42 +48,8 @@ SCIP_RETCODE fouredge_conflicts_create_cut(
     SCIP_Result* result         // Output result
 )
 {
-    // Create constraint name.
-#ifdef DEBUG
-    const auto& map = SCIPprobdataGetMap(probdata);
-
-    const auto [a1_et1_x1, a1_et1_y1] = map.get_xy(a1_et1.n);
-    const auto [a1_et1_x2, a1_et1_y2] = map.get_destination_xy(a1_et1);
-
-    const auto [a1_et2_x1, a1_et2_y1] = map.get_xy(a1_et2.n);
-    const auto [a1_et2_x2, a1_et2_y2] = map.get_destination_xy(a1_et2);
-
-    const auto [a2_et1_x1, a2_et1_y1] = map.get_xy(a2_et1.n);
-    const auto [a2_et1_x2, a2_et1_y2] = map.get_destination_xy(a2_et1);
-
-    const auto [a2_et2_x1, a2_et2_y1] = map.get_xy(a2_et2.n);
-    const auto [a2_et2_x2, a2_et2_y2] = map.get_destination_xy(a2_et2);
-
-    auto name = fmt::format("fouredge_conflict("
-                            "{},{},"
-                            "(({},{}),({},{}),{}),"
-                            "(({},{}),({},{}),{}),"
-                            "(({},{}),({},{}),{}),"
-                            "(({},{}),({},{}),{})"
-                            ")",
-                            a1, a2,
-                            a1_et1_x1, a1_et1_y1, a1_et1_x2, a1_et1_y2, a1_et1.t,
-                            a1_et2_x1, a1_et2_y1, a1_et2_x2, a1_et2_y2, a1_et2.t,
-                            a2_et1_x1, a2_et1_y1, a2_et1_x2, a2_et1_y2, a2_et1.t,
-                            a2_et2_x1, a2_et2_y1, a2_et2_x2, a2_et2_y2, a2_et2.t);
-#endif
-
     // Create data for the cut.
-    TwoAgentRobustCut cut(scip, a1, a2, 2, 2
-#ifdef DEBUG
-        , std::move(name)
-#endif
-    );
+    TwoAgentRobustCut cut(scip, a1, a2, 2, 2);
     cut.a1_edge_time(0) = a1_et1;
     cut.a1_edge_time(1) = a1_et2;
     cut.a2_edge_time(0) = a2_et1;
@@ -113,12 +81,11 @@ SCIP_RETCODE fouredge_conflicts_separate(
 
     // Get problem data.
     auto probdata = SCIPgetProbData(scip);
-    const auto N = SCIPprobdataGetN(probdata);
     const auto& map = SCIPprobdataGetMap(probdata);
 
-    // Skip this separator if an earlier separator found cuts.
+    // Skip this separator if an earlier separator found cuts or if its recent calls did not pay off.
     auto& found_cuts = SCIPprobdataGetFoundCutsIndicator(probdata);
-    if (found_cuts)
+    if (!separator_should_run(scip, sepa))
     {
         return SCIP_OKAY;
     }
@@ -126,6 +93,9 @@ SCIP_RETCODE fouredge_conflicts_separate(
     // Get the edges fractionally used by each agent.
     const auto& fractional_move_edges = SCIPprobdataGetFractionalEdges(probdata);
 
+    // Get the agents with a fractional edge or meeting a fractional edge.
+    const auto& active_agents = SCIPprobdataGetActiveAgents(probdata);
+
 //
 //    Found incompatible subset (
 //        (46, ((218, 167), (219, 167)), 109)
@@ -137,7 +107,7 @@ SCIP_RETCODE fouredge_conflicts_separate(
 
 
     // Find conflicts.
-    for (Agent a1 = 0; a1 < N; ++a1)
+    for (const auto a1 : active_agents)
     {
         // Get the edges of agent 1.
         const auto& fractional_move_edges_a1 = fractional_move_edges[a1];
@@ -149,9 +119,11 @@ SCIP_RETCODE fouredge_conflicts_separate(
             const auto a1_et1_dest = map.get_destination(a1_et1);
 
             // Loop through the second agent.
-            for (Agent a2 = a1 + 1; a2 < N; ++a2)
+            const auto a2_begin = std::upper_bound(active_agents.begin(), active_agents.end(), a1);
+            for (auto a2_it = a2_begin; a2_it != active_agents.end(); ++a2_it)
             {
                 // Get the edges of agent 2.
+                const auto a2 = *a2_it;
                 const auto& fractional_move_edges_a2 = fractional_move_edges[a2];
 
                 // Loop through the first edge of agent 2.
@@ -265,6 +237,9 @@ SCIP_DECL_SEPACOPY(sepaCopyFourEdgeConflicts)
 static
 SCIP_DECL_SEPAEXECLP(sepaExeclpFourEdgeConflicts)
 {
+    // Trace.
+    const TraceScope trace(SEPA_NAME);
+
     // Check.
     debug_assert(scip);
     debug_assert(sepa);
@@ -24,6 +24,7 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Separator_GoalConflicts.h"
 #include "ProblemData.h"
 #include "VariableData.h"
+#include "Trace.h"
 
 #define SEPA_NAME         "goal"
 #define SEPA_DESC         "Separator for goal conflicts"
@@ -273,10 +274,20 @@ SCIP_RETCODE goal_conflicts_separate(
         }
     }
 
-    // Find conflicts.
+    // Find conflicts. The paths of other agents visiting a goal are looked up in the index of goal crossings.
+    const auto& vars = SCIPprobdataGetVars(probdata);
+    const auto& goal_crossings = SCIPprobdataGetGoalCrossings(probdata);
+    Vector<SCIP_Real> lhs2s(N);
     Vector<GoalConflictData> cuts;
     for (Agent a1 = 0; a1 < N; ++a1)
     {
+        // Skip if no path of another agent visits the goal.
+        const auto& crossings = goal_crossings[a1];
+        if (crossings.empty())
+        {
+            continue;
+        }
+
         const auto conflict_node = agents[a1].goal;
         for (const auto& [conflict_time, lhs1] : finish_times[a1])
         {
@@ -308,36 +319,24 @@ SCIP_RETCODE goal_conflicts_separate(
             debug_assert(SCIPisEQ(scip, lhs1, check_lhs1));
 #endif
 
-            // Check if any agent is trying to cross the goal.
-            for (Agent a2 = 0; a2 < N; ++a2)
-                if (a2 != a1)
+            // Sum paths of other agents crossing the goal at or after the conflict time.
+            std::fill(lhs2s.begin(), lhs2s.end(), 0.0);
+            for (const auto& [v, a2, t] : crossings)
+                if (t >= nt.t)
                 {
-                    // Sum paths belonging to the agent trying to cross the goal.
-                    SCIP_Real lhs2 = 0.0;
-                    for (const auto& [var, var_val] : agent_vars[a2])
+                    const auto& [var, var_val] = vars[v];
+                    debug_assert(var_val == SCIPgetSolVal(scip, nullptr, var));
+                    if (SCIPisPositive(scip, var_val))
                     {
-                        // Only check paths in use.
-                        debug_assert(var);
-                        debug_assert(var_val == SCIPgetSolVal(scip, nullptr, var));
-                        if (SCIPisPositive(scip, var_val))
-                        {
-                            // Get the path.
-                            auto vardata = SCIPvarGetData(var);
-                            debug_assert(a2 == SCIPvardataGetAgent(vardata));
-                            const auto path_length = SCIPvardataGetPathLength(vardata);
-                            const auto path = SCIPvardataGetPath(vardata);
-
-                            // Check for conflicts.
-                            for (Time t = nt.t; t < path_length - 1; ++t)
-                                if (path[t].n == nt.n)
-                                {
-                                    lhs2 += var_val;
-                                    break;
-                                }
-                        }
+                        lhs2s[a2] += var_val;
                     }
+                }
 
-                    // Store a cut if violated.
+            // Store a cut for every agent trying to cross the goal if violated.
+            for (Agent a2 = 0; a2 < N; ++a2)
+                if (a2 != a1)
+                {
+                    const auto lhs2 = lhs2s[a2];
                     const auto lhs = lhs1 + lhs2;
                     if (SCIPisSumGT(scip, lhs, 1.0 + CUT_VIOLATION) && SCIPisSumGT(scip, lhs2, 0))
                     {
@@ -412,6 +411,9 @@ SCIP_DECL_SEPACOPY(sepaCopyGoalConflicts)
 static
 SCIP_DECL_SEPAEXECLP(sepaExeclpGoalConflicts)
 {
+    // Trace.
+    const TraceScope trace(SEPA_NAME);
+
     // Check.
     debug_assert(scip);
     debug_assert(sepa);
@@ -0,0 +1,53 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#include "Separator_Parallel.h"
+
+#define DEFAULT_SEPARATION_THREADS 1    // Number of threads for finding cuts in parallel
+
+// Add the parameter for the number of threads used to find cuts
+SCIP_RETCODE SCIPaddParamSeparationThreads(
+    SCIP* scip    // SCIP
+)
+{
+    SCIP_CALL(SCIPaddIntParam(scip,
+                              SEPARATION_THREADS_PARAM,
+                              "number of threads for indexing the LP solution and finding cuts in parallel",
+                              nullptr,
+                              FALSE,
+                              DEFAULT_SEPARATION_THREADS,
+                              1,
+                              1024,
+                              nullptr,
+                              nullptr));
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Get the number of threads used to find cuts
+Int SCIPgetSeparationThreads(
+    SCIP* scip    // SCIP
+)
+{
+    int nb_threads;
+    scip_assert(SCIPgetIntParam(scip, SEPARATION_THREADS_PARAM, &nb_threads));
+    debug_assert(nb_threads >= 1);
+    return nb_threads;
+}
@@ -0,0 +1,130 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#ifndef MAPF_SEPARATOR_PARALLEL_H
+#define MAPF_SEPARATOR_PARALLEL_H
+
+#include "Includes.h"
+#include <thread>
+#include <atomic>
+
+#define SEPARATION_THREADS_PARAM "separating/mapf/threads"
+
+// Add the parameter for the number of threads used to find cuts
+SCIP_RETCODE SCIPaddParamSeparationThreads(
+    SCIP* scip    // SCIP
+);
+
+// Get the number of threads used to find cuts
+Int SCIPgetSeparationThreads(
+    SCIP* scip    // SCIP
+);
+
+// Call a function on every agent in [begin, end) using the threads for finding cuts. Each thread takes the next
+// unvisited agent, so the function must only modify the data of its agent and must not modify SCIP.
+template<class F>
+void for_each_agent_in_parallel(
+    SCIP* scip,           // SCIP
+    const Agent begin,    // First agent
+    const Agent end,      // One past the last agent
+    F&& f                 // Function called with each agent
+)
+{
+    // Run serially.
+    const auto nb_workers = std::min<Int>(SCIPgetSeparationThreads(scip), end - begin);
+    if (nb_workers <= 1)
+    {
+        for (Agent a = begin; a < end; ++a)
+        {
+            f(a);
+        }
+        return;
+    }
+
+    // Run in parallel.
+    std::atomic<Agent> next_a(begin);
+    const auto worker = [&]()
+    {
+        for (Agent a = next_a++; a < end; a = next_a++)
+        {
+            f(a);
+        }
+    };
+    Vector<std::thread> threads;
+    threads.reserve(nb_workers - 1);
+    for (Int idx = 1; idx < nb_workers; ++idx)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+// Find candidate cuts of every first agent in [begin, end) using multiple threads. The candidate search must only
+// read the LP solution and must not modify SCIP. The candidates of each agent are concatenated in order of the
+// agent so the output is identical to a serial loop regardless of the number of threads. The caller then sorts,
+// filters and adds the cuts to SCIP on the main thread.
+template<class CutData, class F>
+Vector<CutData> find_cuts_in_parallel(
+    SCIP* scip,           // SCIP
+    const Agent begin,    // First agent
+    const Agent end,      // One past the last agent
+    F&& find_cuts         // Function appending the candidates of one agent
+)
+{
+    // Check.
+    Vector<CutData> cuts;
+    if (begin >= end)
+    {
+        return cuts;
+    }
+
+    // Find candidates serially.
+    const auto nb_workers = std::min<Int>(SCIPgetSeparationThreads(scip), end - begin);
+    if (nb_workers == 1)
+    {
+        for (Agent a1 = begin; a1 < end; ++a1)
+        {
+            find_cuts(a1, cuts);
+        }
+        return cuts;
+    }
+
+    // Find candidates in parallel.
+    Vector<Vector<CutData>> agent_cuts(end - begin);
+    for_each_agent_in_parallel(scip, begin, end, [&](const Agent a1) { find_cuts(a1, agent_cuts[a1 - begin]); });
+
+    // Merge the candidates.
+    size_t nb_cuts = 0;
+    for (const auto& candidates : agent_cuts)
+    {
+        nb_cuts += candidates.size();
+    }
+    cuts.reserve(nb_cuts);
+    for (auto& candidates : agent_cuts)
+    {
+        std::move(candidates.begin(), candidates.end(), std::back_inserter(cuts));
+    }
+    return cuts;
+}
+
+#endif
@@ -24,6 +24,7 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Separator_PathLengthNogoods.h"
 #include "ProblemData.h"
 #include "VariableData.h"
+#include "Trace.h"
 
 #define SEPA_NAME         "path_length_nogoods"
 #define SEPA_DESC         "Separator for path length nogoods"
@@ -34,12 +35,12 @@ Author: Edward Lam <ed@ed-lam.com>
 #define SEPA_DELAY        FALSE    // should separation method be delayed, if other separators found cuts? */
 
 SCIP_RETCODE path_length_nogoods_create_cut(
-    SCIP* scip,                                              // SCIP
-    SCIP_SEPA* sepa,                                         // Separator
-    const Vector<Vector<SCIP_VAR*>>& agent_vars,             // Variables for each agent
-    Vector<PathLengthNogood>& path_length_nogoods,           // Existing nogoods
-    const Vector<Pair<Agent, Time>>& latest_finish_times,    // New nogood
-    SCIP_Result* result                                      // Output result
+    SCIP* scip,                                                      // SCIP
+    SCIP_SEPA* sepa,                                                 // Separator
+    const Vector<Vector<Pair<SCIP_VAR*, SCIP_Real>>>& agent_vars,    // Variables for each agent
+    Vector<PathLengthNogood>& path_length_nogoods,                   // Existing nogoods
+    const Vector<Pair<Agent, Time>>& latest_finish_times,            // New nogood
+    SCIP_Result* result                                              // Output result
 )
 {
     // Create constraint name.
@@ -112,6 +113,15 @@ SCIP_RETCODE path_length_nogoods_create_cut(
         *result = SCIP_SEPARATED;
     }
 
+    // Store the constraint by agent.
+    {
+        auto& agent_path_length_nogoods = SCIPprobdataGetAgentPathLengthNogoods(SCIPgetProbData(scip));
+        for (const auto& [a, t] : latest_finish_times)
+        {
+            agent_path_length_nogoods[a].push_back({t, row});
+        }
+    }
+
     // Store the constraint.
     path_length_nogoods.push_back({row, latest_finish_times});
 
@@ -242,6 +252,9 @@ SCIP_DECL_SEPACOPY(sepaCopyPathLengthNogoods)
 static
 SCIP_DECL_SEPAEXECLP(sepaExeclpPathLengthNogoods)
 {
+    // Trace.
+    const TraceScope trace(SEPA_NAME);
+
     // Check.
     debug_assert(scip);
     debug_assert(sepa);
@@ -291,11 +304,10 @@ SCIP_RETCODE SCIPincludeSepaPathLengthNogoods(
 }
 
 SCIP_RETCODE path_length_nogoods_add_var(
-    SCIP* scip,                                       // SCIP
-    Vector<PathLengthNogood>& path_length_nogoods,    // Data for the nogoods
-    SCIP_VAR* var,                                    // Variable
-    const Agent a,                                    // Agent
-    const Time path_length                            // Path length
+    SCIP* scip,                                                        // SCIP
+    const Vector<Pair<Time, SCIP_ROW*>>& agent_path_length_nogoods,    // Nogoods of the agent of the variable
+    SCIP_VAR* var,                                                     // Variable
+    const Time path_length                                             // Path length
 )
 {
     // Check.
@@ -303,12 +315,11 @@ SCIP_RETCODE path_length_nogoods_add_var(
     debug_assert(SCIPvarIsTransformed(var));
 
     // Add variable to constraints.
-    for (const auto& [row, latest_finish_times] : path_length_nogoods)
-        for (const auto& [nogood_a, nogood_t] : latest_finish_times)
-            if (a == nogood_a && path_length - 1 <= nogood_t)
-            {
-                SCIP_CALL(SCIPaddVarToRow(scip, row, var, 1.0));
-            }
+    for (const auto& [nogood_t, row] : agent_path_length_nogoods)
+        if (path_length - 1 <= nogood_t)
+        {
+            SCIP_CALL(SCIPaddVarToRow(scip, row, var, 1.0));
+        }
 
     // Return.
     return SCIP_OKAY;
@@ -32,11 +32,10 @@ SCIP_RETCODE SCIPincludeSepaPathLengthNogoods(
 );
 
 SCIP_RETCODE path_length_nogoods_add_var(
-    SCIP* scip,                                       // SCIP
-    Vector<PathLengthNogood>& path_length_nogoods,    // Data for the nogoods
-    SCIP_VAR* var,                                    // Variable
-    const Agent a,                                    // Agent
-    const Time path_length                            // Path length
+    SCIP* scip,                                                        // SCIP
+    const Vector<Pair<Time, SCIP_ROW*>>& agent_path_length_nogoods,    // Nogoods of the agent of the variable
+    SCIP_VAR* var,                                                     // Variable
+    const Time path_length                                             // Path length
 );
 
 #endif
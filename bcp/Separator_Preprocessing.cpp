@@ -22,6 +22,8 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Separator_Preprocessing.h"
 #include "ProblemData.h"
 #include "VariableData.h"
+#include "Trace.h"
+#include "SeparationLog.h"
 
 #define SEPA_NAME         "preprocessing"
 #define SEPA_DESC         "Separator for preprocessing dummy constraint"
@@ -31,6 +33,11 @@ Author: Edward Lam <ed@ed-lam.com>
 #define SEPA_USESSUBSCIP  FALSE    // does the separator use a secondary SCIP instance? */
 #define SEPA_DELAY        FALSE    // should separation method be delayed, if other separators found cuts? */
 
+struct PreprocessingSepaData
+{
+    UniquePtr<SeparationLogWriter> recorder;    // Log of the input of the separators
+};
+
 // Copy method for separator
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-parameter"
@@ -50,12 +57,36 @@ SCIP_DECL_SEPACOPY(sepaCopyPreprocessing)
 }
 #pragma GCC diagnostic pop
 
+// Free separator data
+static
+SCIP_DECL_SEPAFREE(sepaFreePreprocessing)
+{
+    // Check.
+    debug_assert(scip);
+    debug_assert(sepa);
+    debug_assert(strcmp(SCIPsepaGetName(sepa), SEPA_NAME) == 0);
+
+    // Get separator data.
+    auto sepadata = reinterpret_cast<PreprocessingSepaData*>(SCIPsepaGetData(sepa));
+    debug_assert(sepadata);
+
+    // Free memory.
+    sepadata->~PreprocessingSepaData();
+    SCIPfreeBlockMemory(scip, &sepadata);
+
+    // Done.
+    return SCIP_OKAY;
+}
+
 // Separation method for LP solutions
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-parameter"
 static
 SCIP_DECL_SEPAEXECLP(sepaExeclpPreprocessing)
 {
+    // Trace.
+    const TraceScope trace(SEPA_NAME);
+
     // Check.
     debug_assert(scip);
     debug_assert(sepa);
@@ -77,11 +108,19 @@ SCIP_DECL_SEPAEXECLP(sepaExeclpPreprocessing)
     // Update database of fractional vertices and edges before separators start.
     update_fractional_vertices_and_edges(scip);
 
+    // Record the input of the separators.
+    auto sepadata = reinterpret_cast<PreprocessingSepaData*>(SCIPsepaGetData(sepa));
+    debug_assert(sepadata);
+    SCIP_CALL(record_separation_round(scip, sepadata->recorder));
+
     // Reset found cuts indicator.
     auto probdata = SCIPgetProbData(scip);
     auto& found_cuts = SCIPprobdataGetFoundCutsIndicator(probdata);
     found_cuts = false;
 
+    // Discard the cuts of an earlier round that did not reach the cut selection.
+    SCIPprobdataClearTwoAgentRobustCutCandidates(scip, probdata);
+
     // Done.
     return SCIP_OKAY;
 }
@@ -95,6 +134,12 @@ SCIP_RETCODE SCIPincludeSepaPreprocessing(
     // Check.
     debug_assert(scip);
 
+    // Create separator data.
+    PreprocessingSepaData* sepadata = nullptr;
+    SCIP_CALL(SCIPallocBlockMemory(scip, &sepadata));
+    debug_assert(sepadata);
+    new(sepadata) PreprocessingSepaData;
+
     // Include separator.
     SCIP_Sepa* sepa = nullptr;
     SCIP_CALL(SCIPincludeSepaBasic(scip,
@@ -108,11 +153,12 @@ SCIP_RETCODE SCIPincludeSepaPreprocessing(
                                    SEPA_DELAY,
                                    sepaExeclpPreprocessing,
                                    nullptr,
-                                   nullptr));
+                                   reinterpret_cast<SCIP_SEPADATA*>(sepadata)));
     debug_assert(sepa);
 
     // Set callbacks.
     SCIP_CALL(SCIPsetSepaCopy(scip, sepa, sepaCopyPreprocessing));
+    SCIP_CALL(SCIPsetSepaFree(scip, sepa, sepaFreePreprocessing));
 
     // Done.
     return SCIP_OKAY;
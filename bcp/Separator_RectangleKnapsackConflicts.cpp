@@ -25,6 +25,9 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Separator_RectangleConflicts.h"
 #include "ProblemData.h"
 #include "VariableData.h"
+#include "Trace.h"
+#include "Separator_Parallel.h"
+#include "Separator_Scheduling.h"
 
 #define SEPA_NAME         "rectangle_knapsack"
 #define SEPA_DESC         "Separator for rectangle knapsack conflicts"
@@ -44,6 +47,35 @@ inline T signum(const T val)
 struct RectangleKnapsackSepaData
 {
     Vector<RectangleKnapsackCut> cuts;
+    SCIP_Longint cache_node = -1;                                     // Node of the cached results of the last round
+    Vector<Vector<Pair<SCIP_VAR*, SCIP_Real>>> agent_positive_vars;    // Columns with positive value of each agent
+    Vector<uint8_t> no_conflict;                                      // Indicates if no conflict is found for each pair
+};
+
+// Candidate rectangle knapsack cut found by the search
+struct RectangleKnapsackConflictData
+{
+    Agent a1;
+    Agent a2;
+    Int a1_out_edges_begin;
+    Int a2_in_edges_begin;
+    Int a2_out_edges_begin;
+    Vector<EdgeTime> rectangle_edges;
+#if defined(DEBUG) or defined(PRINT_DEBUG)
+    Position a1_start_x;
+    Position a1_start_y;
+    Time a1_start_t;
+    Position a1_end_x;
+    Position a1_end_y;
+    Time a1_end_t;
+    Position a2_start_x;
+    Position a2_start_y;
+    Time a2_start_t;
+    Position a2_end_x;
+    Position a2_end_y;
+    Time a2_end_t;
+    SCIP_Real lhs;
+#endif
 };
 
 inline void append_edge(
@@ -137,39 +169,11 @@ SCIP_RETCODE rectangle_knapsack_conflicts_create_cut(
     const Int a2_in_edges_begin,                // First index of edges of arrival boundary for agent 2
     const Int a2_out_edges_begin,               // First index of edges of departure boundary for agent 2
     const Vector<EdgeTime>& rectangle_edges,    // Edges of the rectangle
-#if defined(DEBUG) or defined(PRINT_DEBUG)
-    const Position a1_start_x,                  // Coordinate of agent 1 used to derive the rectangle
-    const Position a1_start_y,                  // Coordinate of agent 1 used to derive the rectangle
-    const Time a1_start_t,                      // Time of agent 1 used to derive the rectangle
-    const Position a1_end_x,                    // Coordinate of agent 1 used to derive the rectangle
-    const Position a1_end_y,                    // Coordinate of agent 1 used to derive the rectangle
-    const Time a1_end_t,                        // Time of agent 1 used to derive the rectangle
-    const Position a2_start_x,                  // Coordinate of agent 2 used to derive the rectangle
-    const Position a2_start_y,                  // Coordinate of agent 2 used to derive the rectangle
-    const Time a2_start_t,                      // Time of agent 2 used to derive the rectangle
-    const Position a2_end_x,                    // Coordinate of agent 2 used to derive the rectangle
-    const Position a2_end_y,                    // Coordinate of agent 2 used to derive the rectangle
-    const Time a2_end_t,                        // Time of agent 2 used to derive the rectangle
-#endif
     SCIP_Result* result                         // Output result
 )
 {
-    // Create constraint name.
-#ifdef DEBUG
-    auto name = fmt::format("rectangle_knapsack_conflict("
-                            "{},(({},{}),{}),(({},{}),{})"
-                            "{},(({},{}),{}),(({},{}),{})"
-                            ")",
-                            a1, a1_start_x, a1_start_y, a1_start_t, a1_end_x, a1_end_y, a1_end_t,
-                            a2, a2_start_x, a2_start_y, a2_start_t, a2_end_x, a2_end_y, a2_end_t);
-#endif
-
     // Create data for the cut.
-    TwoAgentRobustCut cut(scip, a1, a2, a2_in_edges_begin, rectangle_edges.size() - a2_in_edges_begin
-#ifdef DEBUG
-                        , std::move(name)
-#endif
-    );
+    TwoAgentRobustCut cut(scip, a1, a2, a2_in_edges_begin, rectangle_edges.size() - a2_in_edges_begin);
     std::copy(rectangle_edges.begin(), rectangle_edges.end(), &cut.a1_edge_time(0));
 
     // Store the cut.
@@ -187,8 +191,9 @@ SCIP_RETCODE rectangle_knapsack_conflicts_create_cut(
     return SCIP_OKAY;
 }
 
+// Find a rectangle conflict around a vertex conflict of two paths
 bool find_rectangle_conflict(
-    SCIP* scip,                                                      // SCIP
+    const SCIP_Real epsilon,                                         // Tolerance of sums
     const Map& map,                                                  // Map
     const HashTable<EdgeTime, SCIP_Real>& a1_positive_move_edges,    // Edge weights for each agent
     const HashTable<EdgeTime, SCIP_Real>& a2_positive_move_edges,    // Edge weights for each agent
@@ -494,7 +499,7 @@ bool find_rectangle_conflict(
             lhs += it->second;
         }
     }
-    debug_assert(SCIPisSumLE(scip, lhs, 4.0));
+    debug_assert(lhs - 4.0 <= epsilon);
     // debugln("    LHS: {:.4f}", lhs);
 
     // Store outputs.
@@ -515,7 +520,7 @@ bool find_rectangle_conflict(
 #endif
 
     // Check if the cut is violated.
-    return SCIPisSumGT(scip, lhs, 3.0 + CUT_VIOLATION);
+    return lhs - (3.0 + CUT_VIOLATION) > epsilon;
 }
 
 // bool find_rectangle_conflict_new(
@@ -972,7 +977,7 @@ bool find_rectangle_conflict(
 //             }
 //         }
 //     }
-//     debug_assert(SCIPisSumLE(scip, lhs, 4.0));
+//     debug_assert(lhs - 4.0 <= epsilon);
 //     // debugln("    LHS: {:.4f}", lhs);
 //
 //     // Store outputs.
@@ -993,7 +998,7 @@ bool find_rectangle_conflict(
 // #endif
 //
 //     // Check if the cut is violated.
-//     return SCIPisSumGT(scip, lhs, 3.0 + CUT_VIOLATION);
+//     return lhs - (3.0 + CUT_VIOLATION) > epsilon;
 // }
 
 // Separator
@@ -1017,9 +1022,9 @@ SCIP_RETCODE rectangle_knapsack_conflicts_separate(
     const auto N = SCIPprobdataGetN(probdata);
     const auto& map = SCIPprobdataGetMap(probdata);
 
-    // Skip this separator if an earlier separator found cuts.
+    // Skip this separator if an earlier separator found cuts or if its recent calls did not pay off.
     auto& found_cuts = SCIPprobdataGetFoundCutsIndicator(probdata);
-    if (found_cuts)
+    if (!separator_should_run(scip, sepa))
     {
         return SCIP_OKAY;
     }
@@ -1035,27 +1040,76 @@ SCIP_RETCODE rectangle_knapsack_conflicts_separate(
     // Get variables.
     const auto& agent_vars = SCIPprobdataGetAgentVars(probdata);
 
+    // Clear the cached results when moving to another node.
+    const auto node = SCIPnodeGetNumber(SCIPgetCurrentNode(scip));
+    auto& cached_positive_vars = sepadata->agent_positive_vars;
+    auto& no_conflict = sepadata->no_conflict;
+    if (node != sepadata->cache_node || static_cast<Agent>(cached_positive_vars.size()) != N)
+    {
+        sepadata->cache_node = node;
+        cached_positive_vars.assign(N, {});
+        no_conflict.assign(static_cast<size_t>(N) * N, false);
+    }
+
+    // Find the agents whose columns with positive value changed since the last round. The conflicts of two agents are
+    // found from these columns and the positive move edges summed over them, so a pair without a conflict in the last
+    // round has none again if neither agent changed.
+    Vector<bool> agent_changed(N);
+    {
+        Vector<Pair<SCIP_VAR*, SCIP_Real>> positive_vars;
+        for (Agent a = 0; a < N; ++a)
+        {
+            positive_vars.clear();
+            for (const auto& [var, var_val] : agent_vars[a])
+                if (SCIPisPositive(scip, var_val))
+                {
+                    positive_vars.emplace_back(var, var_val);
+                }
+            agent_changed[a] = (positive_vars != cached_positive_vars[a]);
+            if (agent_changed[a])
+            {
+                std::swap(cached_positive_vars[a], positive_vars);
+            }
+        }
+    }
+
     // Find conflicts.
-    Vector<EdgeTime> rectangle_edges;
-    Int a1_out_edges_begin;
-    Int a2_in_edges_begin;
-    Int a2_out_edges_begin;
+    const auto epsilon = SCIPsumepsilon(scip);
+    auto cuts = find_cuts_in_parallel<RectangleKnapsackConflictData>(scip,
+                                                                     0,
+                                                                     N - 1,
+                                                                     [&](const Agent a1,
+                                                                         Vector<RectangleKnapsackConflictData>& agent_cuts)
+    {
+        // Find the second agents to check. Every pair is marked as without a conflict until one is found. Only the
+        // entries of the first agent are written so the agents can run in parallel.
+        const auto a1_no_conflict = no_conflict.data() + static_cast<size_t>(a1) * N;
+        Vector<bool> check_a2(N, false);
+        for (Agent a2 = a1 + 1; a2 < N; ++a2)
+        {
+            check_a2[a2] = !a1_no_conflict[a2] || agent_changed[a1] || agent_changed[a2];
+            a1_no_conflict[a2] = true;
+        }
+
+        Vector<EdgeTime> rectangle_edges;
+        Int a1_out_edges_begin;
+        Int a2_in_edges_begin;
+        Int a2_out_edges_begin;
 #if defined(DEBUG) or defined(PRINT_DEBUG)
-    Position a1_start_x;
-    Position a1_start_y;
-    Time a1_start_t;
-    Position a2_start_x;
-    Position a2_start_y;
-    Time a2_start_t;
-    Position a1_end_x;
-    Position a1_end_y;
-    Time a1_end_t;
-    Position a2_end_x;
-    Position a2_end_y;
-    Time a2_end_t;
-    SCIP_Real lhs;
+        Position a1_start_x;
+        Position a1_start_y;
+        Time a1_start_t;
+        Position a2_start_x;
+        Position a2_start_y;
+        Time a2_start_t;
+        Position a1_end_x;
+        Position a1_end_y;
+        Time a1_end_t;
+        Position a2_end_x;
+        Position a2_end_y;
+        Time a2_end_t;
+        SCIP_Real lhs;
 #endif
-    for (Agent a1 = 0; a1 < N - 1; ++a1)
         for (auto it1 = agent_vars[a1].crbegin(); it1 != agent_vars[a1].crend(); ++it1)
         {
             const auto& [a1_var, a1_var_val] = *it1;
@@ -1070,6 +1124,13 @@ SCIP_RETCODE rectangle_knapsack_conflicts_separate(
                 // Loop through the second agent.
                 for (Agent a2 = a1 + 1; a2 < N; ++a2)
                 {
+                    // Skip the pair if it had no conflict in the last round and neither agent changed.
+                    if (!check_a2[a2])
+                    {
+                        continue;
+                    }
+
+                    // Loop through the columns of agent 2.
                     Int count = 0;
                     for (auto it2 = agent_vars[a2].crbegin(); it2 != agent_vars[a2].crend(); ++it2)
                     {
@@ -1086,7 +1147,7 @@ SCIP_RETCODE rectangle_knapsack_conflicts_separate(
                             const auto min_path_length = std::min(a1_path_length, a2_path_length);
                             for (Time conflict_time = 1; conflict_time < min_path_length - 1; ++conflict_time)
                                 if (a1_path[conflict_time].n == a2_path[conflict_time].n &&
-                                    find_rectangle_conflict(scip,
+                                    find_rectangle_conflict(epsilon,
                                                                 map,
                                                                 positive_move_edges[a1],
                                                                 positive_move_edges[a2],
@@ -1109,89 +1170,30 @@ SCIP_RETCODE rectangle_knapsack_conflicts_separate(
 #endif
                                                                ))
                                 {
-                                    // Print.
-#ifdef PRINT_DEBUG
-                                    {
-                                        const auto& map = SCIPprobdataGetMap(probdata);
-                                        String a1_in_str;
-                                        String a1_out_str;
-                                        String a2_in_str;
-                                        String a2_out_str;
-                                        {
-                                            Int idx = 0;
-                                            for (; idx < a1_out_edges_begin; ++idx)
-                                            {
-                                                const auto& [e, t] = rectangle_edges[idx].et;
-                                                const auto [x1, y1] = map.get_xy(e.n);
-                                                const auto [x2, y2] = map.get_destination_xy(e);
-                                                a1_in_str += fmt::format("(({},{}),({},{}),{}) ", x1, y1, x2, y2, t);
-                                            }
-                                            a1_in_str.pop_back();
-                                            for (; idx < a2_in_edges_begin; ++idx)
-                                            {
-                                                const auto& [e, t] = rectangle_edges[idx].et;
-                                                const auto [x1, y1] = map.get_xy(e.n);
-                                                const auto [x2, y2] = map.get_destination_xy(e);
-                                                a1_out_str += fmt::format("(({},{}),({},{}),{}) ", x1, y1, x2, y2, t);
-                                            }
-                                            a1_out_str.pop_back();
-                                            for (; idx < a2_out_edges_begin; ++idx)
-                                            {
-                                                const auto& [e, t] = rectangle_edges[idx].et;
-                                                const auto [x1, y1] = map.get_xy(e.n);
-                                                const auto [x2, y2] = map.get_destination_xy(e);
-                                                a2_in_str += fmt::format("(({},{}),({},{}),{}) ", x1, y1, x2, y2, t);
-                                            }
-                                            a2_in_str.pop_back();
-                                            for (; idx < static_cast<Int>(rectangle_edges.size()); ++idx)
-                                            {
-                                                const auto& [e, t] = rectangle_edges[idx].et;
-                                                const auto [x1, y1] = map.get_xy(e.n);
-                                                const auto [x2, y2] = map.get_destination_xy(e);
-                                                a2_out_str += fmt::format("(({},{}),({},{}),{}) ", x1, y1, x2, y2, t);
-                                            }
-                                            a2_out_str.pop_back();
-                                        }
-                                        println("    Creating rectangle knapsack cut for agents {} and {} with "
-                                                "value {} in branch-and-bound node {}:",
-                                                a1,
-                                                a2,
-                                                lhs,
-                                                SCIPnodeGetNumber(SCIPgetCurrentNode(scip)));
-                                        println("      Agent {} in: {}", a1, a1_in_str);
-                                        println("      Agent {} out: {}", a1, a1_out_str);
-                                        println("      Agent {} in: {}", a2, a2_in_str);
-                                        println("      Agent {} out: {}", a2, a2_out_str);
-                                    }
-#endif
-
-                                    // Create cut.
-                                    SCIP_CALL(rectangle_knapsack_conflicts_create_cut(scip,
-                                                                                      probdata,
-                                                                                      sepa,
-                                                                                      *sepadata,
-                                                                                      a1,
-                                                                                      a2,
-                                                                                      a1_out_edges_begin,
-                                                                                      a2_in_edges_begin,
-                                                                                      a2_out_edges_begin,
-                                                                                      rectangle_edges,
+                                    // Store the candidate.
+                                    agent_cuts.push_back({a1,
+                                                          a2,
+                                                          a1_out_edges_begin,
+                                                          a2_in_edges_begin,
+                                                          a2_out_edges_begin,
+                                                          rectangle_edges
 #if defined(DEBUG) or defined(PRINT_DEBUG)
-                                                                                      a1_start_x,
-                                                                                      a1_start_y,
-                                                                                      a1_start_t,
-                                                                                      a1_end_x,
-                                                                                      a1_end_y,
-                                                                                      a1_end_t,
-                                                                                      a2_start_x,
-                                                                                      a2_start_y,
-                                                                                      a2_start_t,
-                                                                                      a2_end_x,
-                                                                                      a2_end_y,
-                                                                                      a2_end_t,
+                                                        , a1_start_x,
+                                                          a1_start_y,
+                                                          a1_start_t,
+                                                          a1_end_x,
+                                                          a1_end_y,
+                                                          a1_end_t,
+                                                          a2_start_x,
+                                                          a2_start_y,
+                                                          a2_start_t,
+                                                          a2_end_x,
+                                                          a2_end_y,
+                                                          a2_end_t,
+                                                          lhs
 #endif
-                                                                                      result));
-                                    found_cuts = true;
+                                                         });
+                                    a1_no_conflict[a2] = false;
                                     goto NEXT_AGENT_PAIR;
                                 }
 
@@ -1207,6 +1209,101 @@ SCIP_RETCODE rectangle_knapsack_conflicts_separate(
                 }
             }
         }
+    });
+
+    // Create the cuts.
+    for (const auto& [a1,
+                      a2,
+                      a1_out_edges_begin,
+                      a2_in_edges_begin,
+                      a2_out_edges_begin,
+                      rectangle_edges
+#if defined(DEBUG) or defined(PRINT_DEBUG)
+                    , a1_start_x,
+                      a1_start_y,
+                      a1_start_t,
+                      a1_end_x,
+                      a1_end_y,
+                      a1_end_t,
+                      a2_start_x,
+                      a2_start_y,
+                      a2_start_t,
+                      a2_end_x,
+                      a2_end_y,
+                      a2_end_t,
+                      lhs
+#endif
+                     ] : cuts)
+    {
+        // Print.
+#ifdef PRINT_DEBUG
+        {
+            String a1_in_str;
+            String a1_out_str;
+            String a2_in_str;
+            String a2_out_str;
+            {
+                Int idx = 0;
+                for (; idx < a1_out_edges_begin; ++idx)
+                {
+                    const auto& [e, t] = rectangle_edges[idx].et;
+                    const auto [x1, y1] = map.get_xy(e.n);
+                    const auto [x2, y2] = map.get_destination_xy(e);
+                    a1_in_str += fmt::format("(({},{}),({},{}),{}) ", x1, y1, x2, y2, t);
+                }
+                a1_in_str.pop_back();
+                for (; idx < a2_in_edges_begin; ++idx)
+                {
+                    const auto& [e, t] = rectangle_edges[idx].et;
+                    const auto [x1, y1] = map.get_xy(e.n);
+                    const auto [x2, y2] = map.get_destination_xy(e);
+                    a1_out_str += fmt::format("(({},{}),({},{}),{}) ", x1, y1, x2, y2, t);
+                }
+                a1_out_str.pop_back();
+                for (; idx < a2_out_edges_begin; ++idx)
+                {
+                    const auto& [e, t] = rectangle_edges[idx].et;
+                    const auto [x1, y1] = map.get_xy(e.n);
+                    const auto [x2, y2] = map.get_destination_xy(e);
+                    a2_in_str += fmt::format("(({},{}),({},{}),{}) ", x1, y1, x2, y2, t);
+                }
+                a2_in_str.pop_back();
+                for (; idx < static_cast<Int>(rectangle_edges.size()); ++idx)
+                {
+                    const auto& [e, t] = rectangle_edges[idx].et;
+                    const auto [x1, y1] = map.get_xy(e.n);
+                    const auto [x2, y2] = map.get_destination_xy(e);
+                    a2_out_str += fmt::format("(({},{}),({},{}),{}) ", x1, y1, x2, y2, t);
+                }
+                a2_out_str.pop_back();
+            }
+            println("    Creating rectangle knapsack cut for agents {} and {} with "
+                    "value {} in branch-and-bound node {}:",
+                    a1,
+                    a2,
+                    lhs,
+                    SCIPnodeGetNumber(SCIPgetCurrentNode(scip)));
+            println("      Agent {} in: {}", a1, a1_in_str);
+            println("      Agent {} out: {}", a1, a1_out_str);
+            println("      Agent {} in: {}", a2, a2_in_str);
+            println("      Agent {} out: {}", a2, a2_out_str);
+        }
+#endif
+
+        // Create cut.
+        SCIP_CALL(rectangle_knapsack_conflicts_create_cut(scip,
+                                                          probdata,
+                                                          sepa,
+                                                          *sepadata,
+                                                          a1,
+                                                          a2,
+                                                          a1_out_edges_begin,
+                                                          a2_in_edges_begin,
+                                                          a2_out_edges_begin,
+                                                          rectangle_edges,
+                                                          result));
+        found_cuts = true;
+    }
 
     // Done.
     return SCIP_OKAY;
@@ -1259,6 +1356,9 @@ SCIP_DECL_SEPAFREE(sepaFreeRectangleKnapsackConflicts)
 static
 SCIP_DECL_SEPAEXECLP(sepaExeclpRectangleKnapsackConflicts)
 {
+    // Trace.
+    const TraceScope trace(SEPA_NAME);
+
     // Check.
     debug_assert(scip);
     debug_assert(sepa);
@@ -1327,4 +1427,29 @@ const Vector<RectangleKnapsackCut>& rectangle_knapsack_get_cuts(
     return sepadata->cuts;
 }
 
+// Update the indices of rectangle knapsack cuts after two-agent robust cuts are removed
+void rectangle_knapsack_remap_cuts(
+    SCIP_ProbData* probdata,        // Problem data
+    const Vector<Int>& new_idx      // New index of every two-agent robust cut
+)
+{
+    auto sepa = SCIPprobdataGetRectangleKnapsackConflictsSepa(probdata);
+    debug_assert(sepa);
+    auto sepadata = reinterpret_cast<RectangleKnapsackSepaData*>(SCIPsepaGetData(sepa));
+    debug_assert(sepadata);
+    auto& cuts = sepadata->cuts;
+    Int nb_kept = 0;
+    for (const auto& cut : cuts)
+    {
+        debug_assert(cut.idx < static_cast<Int>(new_idx.size()));
+        if (new_idx[cut.idx] >= 0)
+        {
+            cuts[nb_kept] = cut;
+            cuts[nb_kept].idx = new_idx[cut.idx];
+            ++nb_kept;
+        }
+    }
+    cuts.resize(nb_kept);
+}
+
 #endif
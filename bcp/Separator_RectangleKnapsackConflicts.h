@@ -23,6 +23,8 @@ Author: Edward Lam <ed@ed-lam.com>
 #define MAPF_SEPARATOR_RECTANGLEKNAPSACKCONFLICTS_H
 
 #include "Includes.h"
+#include "Coordinates.h"
+#include "trufflehog/Map.h"
 
 struct RectangleKnapsackCut
 {
@@ -32,6 +34,41 @@ struct RectangleKnapsackCut
     Int out2_begin;    // Index of the first out edge for agent 2
 };
 
+// Find a rectangle conflict around a vertex conflict of two paths. Returns true if the rectangle knapsack cut is
+// violated by the positive edges of the two agents. The search does not use SCIP so it can also run on a separation
+// log.
+bool find_rectangle_conflict(
+    const SCIP_Real epsilon,                                         // Tolerance of sums
+    const Map& map,                                                  // Map
+    const HashTable<EdgeTime, SCIP_Real>& a1_positive_move_edges,    // Edge weights for each agent
+    const HashTable<EdgeTime, SCIP_Real>& a2_positive_move_edges,    // Edge weights for each agent
+    const Time conflict_time,                                        // Time of the conflict
+    const Edge* a1_path,                                             // Path of agent 1
+    const Edge* a2_path,                                             // Path of agent 1
+    const Int min_path_length,                                       // Length of the shorter path
+    Vector<EdgeTime>& rectangle_edges,                               // Edges of the rectangle
+    Int& a1_out_edges_begin,                                         // First index of edges of departure boundary for agent 1
+    Int& a2_in_edges_begin,                                          // First index of edges of arrival boundary for agent 2
+    Int& a2_out_edges_begin                                          // First index of edges of departure boundary for agent 2
+#if defined(DEBUG) or defined(PRINT_DEBUG)
+  , const Agent a1,                                                  // Agent 1
+    const Agent a2,                                                  // Agent 2
+    Position& output_a1_start_x,                                     // Start coordinate of agent 1
+    Position& output_a1_start_y,                                     // Start coordinate of agent 1
+    Time& output_a1_start_t,                                         // Time of agent 1
+    Position& output_a2_start_x,                                     // Start coordinate of agent 2
+    Position& output_a2_start_y,                                     // Start coordinate of agent 2
+    Time& output_a2_start_t,                                         // Time of agent 2
+    Position& output_a1_end_x,                                       // End coordinate of agent 1
+    Position& output_a1_end_y,                                       // End coordinate of agent 1
+    Time& output_a1_end_t,                                           // Time of agent 1
+    Position& output_a2_end_x,                                       // End coordinate of agent 2
+    Position& output_a2_end_y,                                       // End coordinate of agent 2
+    Time& output_a2_end_t,                                           // Time of agent 2
+    SCIP_Real& output_lhs                                            // LHS
+#endif
+);
+
 // Create separator for rectangle knapsack conflicts and include it
 SCIP_RETCODE SCIPincludeSepaRectangleKnapsackConflicts(
     SCIP* scip,         // SCIP
@@ -43,6 +80,13 @@ const Vector<RectangleKnapsackCut>& rectangle_knapsack_get_cuts(
     SCIP_ProbData* probdata    // Problem data
 );
 
+// Update the indices of rectangle knapsack cuts after two-agent robust cuts are removed. Cuts whose new index is -1
+// are dropped.
+void rectangle_knapsack_remap_cuts(
+    SCIP_ProbData* probdata,        // Problem data
+    const Vector<Int>& new_idx      // New index of every two-agent robust cut
+);
+
 #endif
 
 #endif
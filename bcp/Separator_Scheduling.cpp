@@ -0,0 +1,105 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#include "Separator_Scheduling.h"
+#include "ProblemData.h"
+
+#define DEFAULT_SEPARATION_ADAPTIVE FALSE    // Skip separators that rarely find cuts?
+#define SEPARATION_EXPENSIVE_TIME 0.01       // Time in seconds of a call that is worth skipping if it finds no cuts
+#define SEPARATION_MAX_SKIP 64               // Maximum number of calls to skip after unproductive calls
+
+// Add the parameter for skipping separators that rarely find cuts
+SCIP_RETCODE SCIPaddParamSeparationScheduling(
+    SCIP* scip    // SCIP
+)
+{
+    SCIP_CALL(SCIPaddBoolParam(scip,
+                               SEPARATION_ADAPTIVE_PARAM,
+                               "skip separators whose recent calls took long without finding cuts?",
+                               nullptr,
+                               FALSE,
+                               DEFAULT_SEPARATION_ADAPTIVE,
+                               nullptr,
+                               nullptr));
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Check if a separator should search for cuts
+bool separator_should_run(
+    SCIP* scip,        // SCIP
+    SCIP_SEPA* sepa    // Separator
+)
+{
+    // Check.
+    debug_assert(scip);
+    debug_assert(sepa);
+
+    // Get problem data.
+    auto probdata = SCIPgetProbData(scip);
+    const auto found_cuts = SCIPprobdataGetFoundCutsIndicator(probdata);
+
+    // Check if adaptive scheduling is enabled.
+    SCIP_Bool adaptive;
+    scip_assert(SCIPgetBoolParam(scip, SEPARATION_ADAPTIVE_PARAM, &adaptive));
+    if (!adaptive)
+    {
+        return !found_cuts;
+    }
+
+    // Measure the last call from the statistics of SCIP. Cuts waiting for the cut selection are added by the cut
+    // selection separator, so they are counted separately.
+    auto& schedule = SCIPprobdataGetSeparatorSchedules(probdata)[sepa];
+    if (schedule.running)
+    {
+        const auto nb_cuts = SCIPsepaGetNCutsFound(sepa) + schedule.nb_candidates - schedule.last_nb_cuts;
+        const auto time = SCIPsepaGetTime(sepa) - schedule.last_time;
+        if (nb_cuts > 0)
+        {
+            schedule.nb_unproductive = 0;
+        }
+        else if (time >= SEPARATION_EXPENSIVE_TIME)
+        {
+            ++schedule.nb_unproductive;
+            schedule.nb_skip = std::min<Int>((1 << std::min<Int>(schedule.nb_unproductive, 6)) - 1,
+                                             SEPARATION_MAX_SKIP);
+        }
+        schedule.running = false;
+    }
+
+    // Skip if an earlier separator found cuts.
+    if (found_cuts)
+    {
+        return false;
+    }
+
+    // Skip if the recent calls did not pay off. The skipped calls are not measured.
+    if (schedule.nb_skip > 0)
+    {
+        --schedule.nb_skip;
+        return false;
+    }
+
+    // Run.
+    schedule.last_nb_cuts = SCIPsepaGetNCutsFound(sepa) + schedule.nb_candidates;
+    schedule.last_time = SCIPsepaGetTime(sepa);
+    schedule.running = true;
+    return true;
+}
@@ -0,0 +1,40 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#ifndef MAPF_SEPARATOR_SCHEDULING_H
+#define MAPF_SEPARATOR_SCHEDULING_H
+
+#include "Includes.h"
+
+#define SEPARATION_ADAPTIVE_PARAM "separating/mapf/adaptive"
+
+// Add the parameter for skipping separators that rarely find cuts
+SCIP_RETCODE SCIPaddParamSeparationScheduling(
+    SCIP* scip    // SCIP
+);
+
+// Check if a separator should search for cuts. A separator is skipped if an earlier separator found cuts in this
+// round. With adaptive scheduling, a separator whose recent calls took long without finding cuts is also skipped for
+// exponentially more calls until it pays off again.
+bool separator_should_run(
+    SCIP* scip,        // SCIP
+    SCIP_SEPA* sepa    // Separator
+);
+
+#endif
@@ -0,0 +1,167 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#include "Separator_Selection.h"
+#include "ProblemData.h"
+#include <algorithm>
+
+#define MIN_OPEN_FRACTION 0.02        // Minimum fraction of cells with four passable neighbours to find rectangle conflicts
+#define MIN_CORRIDOR_FRACTION 0.02    // Minimum fraction of cells with two passable neighbours to find corridor conflicts
+
+// Separators of conflicts between the agents. Only the ones compiled into the solver are found in SCIP.
+static const char* model_separators[] = {
+    "rectangle_knapsack",
+    "rectangle_clique",
+    "corridor",
+    "wait_corridor",
+    "step_aside",
+    "wait_delay",
+    "exit_entry",
+    "two_edge",
+    "wait_two_edge",
+    "two_vertex",
+    "three_vertex",
+    "four_edge",
+    "five_edge",
+    "six_edge",
+    "agent_wait_edge",
+    "vertex_four_edge",
+    "vertex_edge_clique",
+    "goal",
+    "path_length_nogoods",
+};
+
+// Turn off a separator
+static SCIP_RETCODE disable_separator(
+    SCIP* scip,             // SCIP
+    const char* name        // Name of the separator
+)
+{
+    const auto param_name = fmt::format("separating/{}/freq", name);
+    SCIP_CALL(SCIPsetIntParam(scip, param_name.c_str(), -1));
+    return SCIP_OKAY;
+}
+
+// Check that a separator is compiled into the solver
+static void check_separator(
+    SCIP* scip,                // SCIP
+    const String& name         // Name of the separator
+)
+{
+    if (!SCIPfindSepa(scip, name.c_str()))
+    {
+        err("Separator {} is unknown or not compiled into the solver", name);
+    }
+}
+
+// Turn off every separator of the model except the given ones
+SCIP_RETCODE SCIPenableSeparatorsOnly(
+    SCIP* scip,                      // SCIP
+    const Vector<String>& names      // Names of the separators to keep
+)
+{
+    // Check.
+    for (const auto& name : names)
+    {
+        check_separator(scip, name);
+    }
+
+    // Turn off the other separators.
+    for (const auto name : model_separators)
+    {
+        if (SCIPfindSepa(scip, name) && std::find(names.begin(), names.end(), name) == names.end())
+        {
+            SCIP_CALL(disable_separator(scip, name));
+        }
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Turn off the given separators
+SCIP_RETCODE SCIPdisableSeparators(
+    SCIP* scip,                      // SCIP
+    const Vector<String>& names      // Names of the separators to turn off
+)
+{
+    for (const auto& name : names)
+    {
+        check_separator(scip, name);
+        release_assert(name != "preprocessing" && name != "cut_selection", "Cannot turn off the {} separator", name);
+        SCIP_CALL(disable_separator(scip, name.c_str()));
+    }
+    return SCIP_OKAY;
+}
+
+// Turn off the separators that are unlikely to find cuts on the map of the instance
+SCIP_RETCODE SCIPapplyAutomaticSeparatorProfile(
+    SCIP* scip    // SCIP
+)
+{
+    // Get the map.
+    auto probdata = SCIPgetProbData(scip);
+    const auto& map = SCIPprobdataGetMap(probdata);
+
+    // Count the open cells and the corridor cells.
+    Int nb_passable = 0;
+    Int nb_open = 0;
+    Int nb_corridor = 0;
+    for (Node n = 0; n < map.size(); ++n)
+    {
+        if (map[n])
+        {
+            const auto nb_neighbours = __builtin_popcount(map.neighbours(n) & 0b1111);
+            ++nb_passable;
+            nb_open += (nb_neighbours == 4);
+            nb_corridor += (nb_neighbours == 2);
+        }
+    }
+    const auto open_fraction = static_cast<SCIP_Real>(nb_open) / std::max<Int>(nb_passable, 1);
+    const auto corridor_fraction = static_cast<SCIP_Real>(nb_corridor) / std::max<Int>(nb_passable, 1);
+    debugln("Map has {} passable cells, {:.3f} open and {:.3f} corridor",
+            nb_passable, open_fraction, corridor_fraction);
+
+    // Turn off rectangle conflicts on maps without open areas.
+    if (open_fraction < MIN_OPEN_FRACTION)
+    {
+        for (const auto name : {"rectangle_knapsack", "rectangle_clique"})
+        {
+            if (SCIPfindSepa(scip, name))
+            {
+                SCIP_CALL(disable_separator(scip, name));
+            }
+        }
+    }
+
+    // Turn off corridor conflicts on maps without corridors.
+    if (corridor_fraction < MIN_CORRIDOR_FRACTION)
+    {
+        for (const auto name : {"corridor", "wait_corridor"})
+        {
+            if (SCIPfindSepa(scip, name))
+            {
+                SCIP_CALL(disable_separator(scip, name));
+            }
+        }
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
@@ -0,0 +1,45 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#ifndef MAPF_SEPARATOR_SELECTION_H
+#define MAPF_SEPARATOR_SELECTION_H
+
+#include "Includes.h"
+
+// Turn off every separator of the model except the given ones. The preprocessing separator is always kept because it
+// only removes the dummy constraint. Names must be of separators compiled into the solver.
+SCIP_RETCODE SCIPenableSeparatorsOnly(
+    SCIP* scip,                      // SCIP
+    const Vector<String>& names      // Names of the separators to keep
+);
+
+// Turn off the given separators. Names must be of separators compiled into the solver.
+SCIP_RETCODE SCIPdisableSeparators(
+    SCIP* scip,                      // SCIP
+    const Vector<String>& names      // Names of the separators to turn off
+);
+
+// Turn off the separators that are unlikely to find cuts on the map of the instance. Rectangle conflicts need two
+// agents crossing an open area and corridor conflicts need two agents swapping through a corridor, so these
+// separators are turned off on maps with very few open cells or corridor cells respectively.
+SCIP_RETCODE SCIPapplyAutomaticSeparatorProfile(
+    SCIP* scip    // SCIP
+);
+
+#endif
@@ -24,6 +24,8 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Separator_SixEdgeConflicts.h"
 #include "ProblemData.h"
 #include "VariableData.h"
+#include "Trace.h"
+#include "Separator_Scheduling.h"
 
 #define SEPA_NAME         "six_edge"
 #define SEPA_DESC         "Separator for six edge conflicts"
@@ -48,52 +50,8 @@ SCIP_RETCODE sixedge_conflicts_create_cut(
     SCIP_Result* result         // Output result
 )
 {
-    // Create constraint name.
-#ifdef DEBUG
-    const auto& map = SCIPprobdataGetMap(probdata);
-
-    const auto [a1_et1_x1, a1_et1_y1] = map.get_xy(a1_et1.n);
-    const auto [a1_et1_x2, a1_et1_y2] = map.get_destination_xy(a1_et1);
-
-    const auto [a1_et2_x1, a1_et2_y1] = map.get_xy(a1_et2.n);
-    const auto [a1_et2_x2, a1_et2_y2] = map.get_destination_xy(a1_et2);
-
-    const auto [a1_et3_x1, a1_et3_y1] = map.get_xy(a1_et3.n);
-    const auto [a1_et3_x2, a1_et3_y2] = map.get_destination_xy(a1_et3);
-
-    const auto [a2_et1_x1, a2_et1_y1] = map.get_xy(a2_et1.n);
-    const auto [a2_et1_x2, a2_et1_y2] = map.get_destination_xy(a2_et1);
-
-    const auto [a2_et2_x1, a2_et2_y1] = map.get_xy(a2_et2.n);
-    const auto [a2_et2_x2, a2_et2_y2] = map.get_destination_xy(a2_et2);
-
-    const auto [a2_et3_x1, a2_et3_y1] = map.get_xy(a2_et3.n);
-    const auto [a2_et3_x2, a2_et3_y2] = map.get_destination_xy(a2_et3);
-
-    auto name = fmt::format("sixedge_conflict("
-                            "{},{},"
-                            "(({},{}),({},{}),{}),"
-                            "(({},{}),({},{}),{}),"
-                            "(({},{}),({},{}),{}),"
-                            "(({},{}),({},{}),{}),"
-                            "(({},{}),({},{}),{}),"
-                            "(({},{}),({},{}),{}),"
-                            ")",
-                            a1, a2,
-                            a1_et1_x1, a1_et1_y1, a1_et1_x2, a1_et1_y2, a1_et1.t,
-                            a1_et2_x1, a1_et2_y1, a1_et2_x2, a1_et2_y2, a1_et2.t,
-                            a1_et3_x1, a1_et3_y1, a1_et3_x2, a1_et3_y2, a1_et3.t,
-                            a2_et1_x1, a2_et1_y1, a2_et1_x2, a2_et1_y2, a2_et1.t,
-                            a2_et2_x1, a2_et2_y1, a2_et2_x2, a2_et2_y2, a2_et2.t,
-                            a2_et3_x1, a2_et3_y1, a2_et3_x2, a2_et3_y2, a2_et3.t);
-#endif
-
     // Create data for the cut.
-    TwoAgentRobustCut cut(scip, a1, a2, 3, 3
-#ifdef DEBUG
-        , std::move(name)
-#endif
-    );
+    TwoAgentRobustCut cut(scip, a1, a2, 3, 3);
     cut.a1_edge_time(0) = a1_et1;
     cut.a1_edge_time(1) = a1_et2;
     cut.a1_edge_time(2) = a1_et3;
@@ -127,12 +85,11 @@ SCIP_RETCODE sixedge_conflicts_separate(
 
     // Get problem data.
     auto probdata = SCIPgetProbData(scip);
-    const auto N = SCIPprobdataGetN(probdata);
     const auto& map = SCIPprobdataGetMap(probdata);
 
-    // Skip this separator if an earlier separator found cuts.
+    // Skip this separator if an earlier separator found cuts or if its recent calls did not pay off.
     auto& found_cuts = SCIPprobdataGetFoundCutsIndicator(probdata);
-    if (found_cuts)
+    if (!separator_should_run(scip, sepa))
     {
         return SCIP_OKAY;
     }
@@ -141,8 +98,11 @@ SCIP_RETCODE sixedge_conflicts_separate(
     const auto& fractional_move_edges = SCIPprobdataGetFractionalMoveEdges(probdata);
     const auto& fractional_edges = SCIPprobdataGetFractionalEdges(probdata);
 
+    // Get the agents with a fractional edge or meeting a fractional edge.
+    const auto& active_agents = SCIPprobdataGetActiveAgents(probdata);
+
     // Find conflicts.
-    for (Agent a1 = 0; a1 < N; ++a1)
+    for (const auto a1 : active_agents)
     {
         // Get the edges of agent 1.
         const auto& fractional_move_edges_a1 = fractional_move_edges[a1];
@@ -164,7 +124,7 @@ SCIP_RETCODE sixedge_conflicts_separate(
                 const EdgeTime a2_et2{map.get_opposite_edge(a1_et2.et.e), a1_et2.t};
 
                 // Loop through the second agent.
-                for (Agent a2 = 0; a2 < N; ++a2)
+                for (const auto a2 : active_agents)
                     if (a2 != a1)
                     {
                         // Get the edges of agent 2.
@@ -284,6 +244,9 @@ SCIP_DECL_SEPACOPY(sepaCopySixEdgeConflicts)
 static
 SCIP_DECL_SEPAEXECLP(sepaExeclpSixEdgeConflicts)
 {
+    // Trace.
+    const TraceScope trace(SEPA_NAME);
+
     // Check.
     debug_assert(scip);
     debug_assert(sepa);
@@ -24,6 +24,8 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Separator_StepAsideConflicts.h"
 #include "ProblemData.h"
 #include "VariableData.h"
+#include "Trace.h"
+#include "Separator_Scheduling.h"
 
 #define SEPA_NAME         "step_aside"
 #define SEPA_DESC         "Separator for step aside conflicts"
@@ -55,33 +57,8 @@ SCIP_RETCODE stepaside_conflicts_create_cut(
     SCIP_Result* result                  // Output result
 )
 {
-    // Create constraint name.
-#ifdef DEBUG
-    const auto& map = SCIPprobdataGetMap(probdata);
-
-    const auto a1_et1 = a1_ets[0];
-    const auto [a1_x1, a1_y1] = map.get_xy(a1_et1.n);
-    const auto [a1_x2, a1_y2] = map.get_destination_xy(a1_et1);
-
-    const auto a2_et1 = a2_ets[2];
-    const auto [a2_x1, a2_y1] = map.get_xy(a2_et1.n);
-    const auto [a2_x2, a2_y2] = map.get_destination_xy(a2_et1);
-
-    auto name = fmt::format("stepaside_conflict("
-                            "{},{},"
-                            "(({},{}),({},{}),{}),"
-                            "(({},{}),({},{}),{}))",
-                            a1, a2,
-                            a1_x1, a1_y1, a1_x2, a1_y2, a1_et1.t,
-                            a2_x1, a2_y1, a2_x2, a2_y2, a2_et1.t);
-#endif
-
     // Create data for the cut.
-    TwoAgentRobustCut cut(scip, a1, a2, 4, 4
-#ifdef DEBUG
-        , std::move(name)
-#endif
-    );
+    TwoAgentRobustCut cut(scip, a1, a2, 4, 4);
     std::copy(a1_ets.begin(), a1_ets.end(), &cut.a1_edge_time(0));
     std::copy(a2_ets.begin(), a2_ets.end(), &cut.a2_edge_time(0));
 
@@ -121,9 +98,9 @@ SCIP_RETCODE stepaside_conflicts_separate(
     const auto N = SCIPprobdataGetN(probdata);
     const auto& map = SCIPprobdataGetMap(probdata);
 
-    // Skip this separator if an earlier separator found cuts.
+    // Skip this separator if an earlier separator found cuts or if its recent calls did not pay off.
     auto& found_cuts = SCIPprobdataGetFoundCutsIndicator(probdata);
-    if (found_cuts)
+    if (!separator_should_run(scip, sepa))
     {
         return SCIP_OKAY;
     }
@@ -244,9 +221,15 @@ SCIP_RETCODE stepaside_conflicts_separate(
                             const auto a2_et4_it = a2_dir_edges.find(a2_et4);
                             const auto a2_et4_val = a2_et4_it != a2_dir_edges.end() ? a2_et4_it->second : 0.0;
 
-                            // Compute the end of the corridor.
+                            // Compute the end of the corridor. Agent 1 can only use the first and third edges
+                            // together if the straight line between them is free of obstacles, so the cut cannot be
+                            // violated otherwise.
                             const auto h = a2_et3.t - a1_et1.t;
                             debug_assert(h > 0);
+                            if (h >= map.extent(a1_et1.n, d1))
+                            {
+                                continue;
+                            }
                             auto [x, y] = map.get_xy(a1_et1.n);
                             switch (d1)
                             {
@@ -256,10 +239,6 @@ SCIP_RETCODE stepaside_conflicts_separate(
                                 case Direction::WEST: x -= h; break;
                                 default: unreachable();
                             }
-                            if (!(0 <= x && x < map.width() && 0 <= y && y < map.height()))
-                            {
-                                continue;
-                            }
 
                             // Get the third edge of agent 1.
                             const auto a1_et3_orig = map.get_id(x, y);
@@ -403,6 +382,9 @@ SCIP_DECL_SEPACOPY(sepaCopyStepAsideConflicts)
 static
 SCIP_DECL_SEPAEXECLP(sepaExeclpStepAsideConflicts)
 {
+    // Trace.
+    const TraceScope trace(SEPA_NAME);
+
     // Check.
     debug_assert(scip);
     debug_assert(sepa);
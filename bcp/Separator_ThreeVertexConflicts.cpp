@@ -24,6 +24,8 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Separator_ThreeVertexConflicts.h"
 #include "ProblemData.h"
 #include "VariableData.h"
+#include "Trace.h"
+#include "Separator_Scheduling.h"
 
 #define SEPA_NAME         "three_vertex"
 #define SEPA_DESC         "Separator for three vertex conflicts"
@@ -50,40 +52,8 @@ SCIP_RETCODE threevertex_conflicts_create_cut(
     // Get problem data.
     const auto& map = SCIPprobdataGetMap(probdata);
 
-    // Create constraint name.
-#ifdef DEBUG
-    const auto [a1_et1_x1, a1_et1_y1] = map.get_xy(a1_et1.n);
-    const auto [a1_et1_x2, a1_et1_y2] = map.get_destination_xy(a1_et1);
-
-    const auto [a1_et2_x1, a1_et2_y1] = map.get_xy(a1_et2.n);
-    const auto [a1_et2_x2, a1_et2_y2] = map.get_destination_xy(a1_et2);
-
-    const auto [a2_v1_x, a2_v1_y] = map.get_xy(a2_v1.n);
-    const auto [a2_v2_x, a2_v2_y] = map.get_xy(a2_v2.n);
-    const auto [a2_v3_x, a2_v3_y] = map.get_xy(a2_v3.n);
-
-    auto name = fmt::format("threevertex_conflict("
-                            "{},{},"
-                            "(({},{}),({},{}),{}),"
-                            "(({},{}),({},{}),{}),"
-                            "(({},{}),{}),"
-                            "(({},{}),{}),"
-                            "(({},{}),{})"
-                            ")",
-                            a1, a2,
-                            a1_et1_x1, a1_et1_y1, a1_et1_x2, a1_et1_y2, a1_et1.t,
-                            a1_et2_x1, a1_et2_y1, a1_et2_x2, a1_et2_y2, a1_et2.t,
-                            a2_v1_x, a2_v1_y, a2_v1.t,
-                            a2_v2_x, a2_v2_y, a2_v2.t,
-                            a2_v3_x, a2_v3_y, a2_v3.t);
-#endif
-
     // Create data for the cut.
-    TwoAgentRobustCut cut(scip, a1, a2, 2, 15
-#ifdef DEBUG
-        , std::move(name)
-#endif
-    );
+    TwoAgentRobustCut cut(scip, a1, a2, 2, 15);
     cut.a1_edge_time(0) = a1_et1;
     cut.a1_edge_time(1) = a1_et2;
     {
@@ -140,12 +110,11 @@ SCIP_RETCODE threevertex_conflicts_separate(
 
     // Get problem data.
     auto probdata = SCIPgetProbData(scip);
-    const auto N = SCIPprobdataGetN(probdata);
     const auto& map = SCIPprobdataGetMap(probdata);
 
-    // Skip this separator if an earlier separator found cuts.
+    // Skip this separator if an earlier separator found cuts or if its recent calls did not pay off.
     auto& found_cuts = SCIPprobdataGetFoundCutsIndicator(probdata);
-    if (found_cuts)
+    if (!separator_should_run(scip, sepa))
     {
         return SCIP_OKAY;
     }
@@ -154,8 +123,11 @@ SCIP_RETCODE threevertex_conflicts_separate(
     const auto& fractional_vertices = SCIPprobdataGetFractionalVertices(probdata);
     const auto& fractional_move_edges = SCIPprobdataGetFractionalMoveEdges(probdata);
 
+    // Get the agents with a fractional edge or meeting a fractional edge.
+    const auto& active_agents = SCIPprobdataGetActiveAgents(probdata);
+
     // Find conflicts.
-    for (Agent a1 = 0; a1 < N; ++a1)
+    for (const auto a1 : active_agents)
     {
         // Get the edges of agent 1.
         const auto& fractional_move_edges_a1 = fractional_move_edges[a1];
@@ -180,7 +152,7 @@ SCIP_RETCODE threevertex_conflicts_separate(
                 if (a1_et2.t == a1_et1.t + 1 && a1_et2_orig != a1_et1_dest)
                 {
                     // Loop through the second agent.
-                    for (Agent a2 = 0; a2 < N; ++a2)
+                    for (const auto a2 : active_agents)
                         if (a1 != a2)
                         {
                             // Get the vertices of agent 2.
@@ -313,6 +285,9 @@ SCIP_DECL_SEPACOPY(sepaCopyThreeVertexConflicts)
 static
 SCIP_DECL_SEPAEXECLP(sepaExeclpThreeVertexConflicts)
 {
+    // Trace.
+    const TraceScope trace(SEPA_NAME);
+
     // Check.
     debug_assert(scip);
     debug_assert(sepa);
@@ -24,6 +24,10 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Separator_TwoEdgeConflicts.h"
 #include "ProblemData.h"
 #include "VariableData.h"
+#include "Trace.h"
+#include "Separator_Parallel.h"
+#include "Separator_AgentScan.h"
+#include "Separator_Scheduling.h"
 
 #ifdef USE_WAITTWOEDGE_CONFLICTS
 #define SEPA_NAME         "wait_two_edge"
@@ -77,35 +81,12 @@ SCIP_RETCODE twoedge_conflicts_create_cut(
     SCIP_Result* result         // Output result
 )
 {
-    // Create constraint name.
-#ifdef DEBUG
-    const auto& map = SCIPprobdataGetMap(probdata);
-    const auto [x1, y1] = map.get_xy(a1_e1.n);
-    const auto [x2, y2] = map.get_destination_xy(a1_e1);
-
-    const auto [x3, y3] = map.get_xy(a1_e2.n);
-    const auto [x4, y4] = map.get_destination_xy(a1_e2);
-
-    auto name = fmt::format("twoedge_conflict("
-                            "{},{},"
-                            "(({},{}),({},{})),"
-                            "(({},{}),({},{})),"
-                            "{})",
-                            a1, a2,
-                            x1, y1, x2, y2,
-                            x3, y3, x4, y4,
-                            t);
-#endif
-
     // Create data for the cut.
     TwoAgentRobustCut cut(scip, a1, a2,
 #ifdef USE_WAITTWOEDGE_CONFLICTS
                           3, 3
 #else
                           2, 2
-#endif
-#ifdef DEBUG
-                          , std::move(name)
 #endif
     );
     cut.a1_edge_time(0) = EdgeTime{a1_e1, t};
@@ -148,9 +129,9 @@ SCIP_RETCODE twoedge_conflicts_separate(
     const auto N = SCIPprobdataGetN(probdata);
     const auto& map = SCIPprobdataGetMap(probdata);
 
-    // Skip this separator if an earlier separator found cuts.
+    // Skip this separator if an earlier separator found cuts or if its recent calls did not pay off.
     auto& found_cuts = SCIPprobdataGetFoundCutsIndicator(probdata);
-    if (found_cuts)
+    if (!separator_should_run(scip, sepa))
     {
         return SCIP_OKAY;
     }
@@ -160,9 +141,10 @@ SCIP_RETCODE twoedge_conflicts_separate(
     const auto& fractional_edges_vec = SCIPprobdataGetFractionalEdgesVec(probdata);
 
     // Find conflicts.
-    Vector<TwoEdgeConflictData> cuts;
-    auto zeros = std::make_unique<SCIP_Real[]>(N);
-    for (Agent a1 = 0; a1 < N - 1; ++a1)
+    auto cuts = find_cuts_in_parallel<TwoEdgeConflictData>(scip,
+                                                           0,
+                                                           N - 1,
+                                                           [&](const Agent a1, Vector<TwoEdgeConflictData>& agent_cuts)
     {
         // Get the edges of agent 1.
         const auto& fractional_move_edges_a1 = fractional_move_edges[a1];
@@ -175,7 +157,7 @@ SCIP_RETCODE twoedge_conflicts_separate(
             // Get the first edge of agent 2.
             const EdgeTime a2_et1{map.get_opposite_edge(a1_et1.et.e), t};
             const auto a2_et1_it = fractional_edges_vec.find(a2_et1);
-            const auto a2_et1_vals = a2_et1_it != fractional_edges_vec.end() ? a2_et1_it->second : zeros.get();
+            const AgentValues a2_et1_vals = a2_et1_it != fractional_edges_vec.end() ? a2_et1_it->second : nullptr;
 
             // Get the second edge of agent 1.
             const auto a1_e2_orig = map.get_destination(a1_et1);
@@ -202,11 +184,16 @@ SCIP_RETCODE twoedge_conflicts_separate(
                 ++a1_e2_size;
             }
 
+            // Get the agents using an edge at the middle vertex.
+            const auto& a2_candidates = SCIPprobdataGetFractionalAgents(probdata, NodeTime{a1_e2_orig, t});
+            const auto a2_candidates_begin = std::upper_bound(a2_candidates.begin(), a2_candidates.end(), a1);
+
             // Get the wait edge of both agents.
 #ifdef USE_WAITTWOEDGE_CONFLICTS
             const EdgeTime a12_et3{a1_e2_orig, Direction::WAIT, t};
             const auto a12_et3_it = fractional_edges_vec.find(a12_et3);
-            const auto a12_et3_vals = a12_et3_it != fractional_edges_vec.end() ? a12_et3_it->second : zeros.get();
+            const AgentValues a12_et3_vals = a12_et3_it != fractional_edges_vec.end() ? a12_et3_it->second : nullptr;
+            const auto a1_et3_val = a12_et3_vals ? a12_et3_vals[a1] : 0.0;
 #endif
 
             // Loop through the second edge of agent 1.
@@ -220,38 +207,44 @@ SCIP_RETCODE twoedge_conflicts_separate(
                 // Get the second edge of agent 2.
                 const EdgeTime a2_et2{map.get_opposite_edge(a1_et2.et.e), t};
                 const auto a2_et2_it = fractional_edges_vec.find(a2_et2);
-                const auto a2_et2_vals = a2_et2_it != fractional_edges_vec.end() ? a2_et2_it->second : zeros.get();
+                const AgentValues a2_et2_vals = a2_et2_it != fractional_edges_vec.end() ? a2_et2_it->second : nullptr;
 
-                // Loop through the second agent.
-                for (Agent a2 = a1 + 1; a2 < N; ++a2)
-                {
-                    // Store a cut if violated.
-                    const auto lhs = a1_et1_val + a1_et2_val + a2_et1_vals[a2] + a2_et2_vals[a2]
+                // Store a cut for every second agent with a violated LHS. Other agents have no fractional value on
+                // any edge of the cut.
 #ifdef USE_WAITTWOEDGE_CONFLICTS
-                                     + a12_et3_vals[a1] + a12_et3_vals[a2]
+                const auto a1_lhs = a1_et1_val + a1_et2_val + a1_et3_val;
+                const Array<AgentValues, 3> a2_vals{a2_et1_vals, a2_et2_vals, a12_et3_vals};
+#else
+                const auto a1_lhs = a1_et1_val + a1_et2_val;
+                const Array<AgentValues, 2> a2_vals{a2_et1_vals, a2_et2_vals};
 #endif
-                                     ;
-                    if (SCIPisSumGT(scip, lhs, 1.0 + CUT_VIOLATION))
-                    {
-                        cuts.emplace_back(TwoEdgeConflictData{lhs,
-                                                              a1,
-                                                              a2,
-                                                              a1_et1.et.e,
-                                                              a1_et2.et.e,
+                scan_violated_agents(scip,
+                                     a2_vals,
+                                     a2_vals.size(),
+                                     a1_lhs,
+                                     a2_candidates_begin,
+                                     a2_candidates.end(),
+                                     a1,
+                                     [&](const Agent a2, const SCIP_Real lhs)
+                {
+                    agent_cuts.emplace_back(TwoEdgeConflictData{lhs,
+                                                                a1,
+                                                                a2,
+                                                                a1_et1.et.e,
+                                                                a1_et2.et.e,
 #ifdef USE_WAITTWOEDGE_CONFLICTS
-                                                              a12_et3.et.e,
+                                                                a12_et3.et.e,
 #endif
-                                                              a2_et1.et.e,
-                                                              a2_et2.et.e,
+                                                                a2_et1.et.e,
+                                                                a2_et2.et.e,
 #ifdef USE_WAITTWOEDGE_CONFLICTS
-                                                              a12_et3.et.e,
+                                                                a12_et3.et.e,
 #endif
-                                                              t});
-                    }
-                }
+                                                                t});
+                });
             }
         }
-    }
+    });
 
     // Create the most violated cuts.
     Vector<Int> agent_nb_cuts(N * N);
@@ -387,6 +380,9 @@ SCIP_DECL_SEPACOPY(sepaCopyTwoEdgeConflicts)
 static
 SCIP_DECL_SEPAEXECLP(sepaExeclpTwoEdgeConflicts)
 {
+    // Trace.
+    const TraceScope trace(SEPA_NAME);
+
     // Check.
     debug_assert(scip);
     debug_assert(sepa);
@@ -24,6 +24,8 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Separator_TwoVertexConflicts.h"
 #include "ProblemData.h"
 #include "VariableData.h"
+#include "Trace.h"
+#include "Separator_Scheduling.h"
 
 #define SEPA_NAME         "two_vertex"
 #define SEPA_DESC         "Separator for two vertex conflicts"
@@ -57,37 +59,8 @@ SCIP_RETCODE twovertex_conflicts_create_cut(
     SCIP_Result* result         // Output result
 )
 {
-    // Create constraint name.
-#ifdef DEBUG
-    const auto& map = SCIPprobdataGetMap(probdata);
-
-    const auto [a1_et_x1, a1_et_y1] = map.get_xy(a1_et.n);
-    const auto [a1_et_x2, a1_et_y2] = map.get_destination_xy(a1_et);
-
-    const auto [a2_et1_x1, a2_et1_y1] = map.get_xy(a2_et1.n);
-    const auto [a2_et1_x2, a2_et1_y2] = map.get_destination_xy(a2_et1);
-
-    const auto [a2_et2_x1, a2_et2_y1] = map.get_xy(a2_et2.n);
-    const auto [a2_et2_x2, a2_et2_y2] = map.get_destination_xy(a2_et2);
-
-    auto name = fmt::format("twovertex_conflict("
-                            "{},{},"
-                            "(({},{}),({},{}),{}),"
-                            "(({},{}),({},{}),{}),"
-                            "(({},{}),({},{}),{}),"
-                            ")",
-                            a1, a2,
-                            a1_et_x1, a1_et_y1, a1_et_x2, a1_et_y2, a1_et.t,
-                            a2_et1_x1, a2_et1_y1, a2_et1_x2, a2_et1_y2, a2_et1.t,
-                            a2_et2_x1, a2_et2_y1, a2_et2_x2, a2_et2_y2, a2_et2.t);
-#endif
-
     // Create data for the cut.
-    TwoAgentRobustCut cut(scip, a1, a2, 1, 2
-#ifdef DEBUG
-        , std::move(name)
-#endif
-    );
+    TwoAgentRobustCut cut(scip, a1, a2, 1, 2);
     cut.a1_edge_time(0) = a1_et;
     cut.a2_edge_time(0) = a2_et1;
     cut.a2_edge_time(1) = a2_et2;
@@ -121,9 +94,9 @@ SCIP_RETCODE twovertex_conflicts_separate(
     const auto N = SCIPprobdataGetN(probdata);
     const auto& map = SCIPprobdataGetMap(probdata);
 
-    // Skip this separator if an earlier separator found cuts.
+    // Skip this separator if an earlier separator found cuts or if its recent calls did not pay off.
     auto& found_cuts = SCIPprobdataGetFoundCutsIndicator(probdata);
-    if (found_cuts)
+    if (!separator_should_run(scip, sepa))
     {
         return SCIP_OKAY;
     }
@@ -132,9 +105,12 @@ SCIP_RETCODE twovertex_conflicts_separate(
     const auto& fractional_move_edges = SCIPprobdataGetFractionalEdges(probdata);
     const auto& fractional_edges_vec = SCIPprobdataGetFractionalEdgesVec(probdata);
 
+    // Get the agents with a fractional edge or meeting a fractional edge.
+    const auto& active_agents = SCIPprobdataGetActiveAgents(probdata);
+
     // Find conflicts.
     Vector<TwoVertexConflictData> cuts;
-    for (Agent a1 = 0; a1 < N; ++a1)
+    for (const auto a1 : active_agents)
     {
         // Get the edges of agent 1.
         const auto& fractional_move_edges_a1 = fractional_move_edges[a1];
@@ -144,7 +120,7 @@ SCIP_RETCODE twovertex_conflicts_separate(
         {
             // Get all potential first edge of agent 2.
             Array<EdgeTime, 5> a2_et1s;
-            Array<SCIP_Real*, 5> a2_et1_vals;
+            Array<AgentValues, 5> a2_et1_vals;
             Int a2_et1_size = 0;
             {
                 const EdgeTime et{a1_et.n, Direction::NORTH, a1_et.t};
@@ -194,7 +170,7 @@ SCIP_RETCODE twovertex_conflicts_separate(
 
             // Get all potential second edge of agent 2.
             Array<EdgeTime, 5> a2_et2s;
-            Array<SCIP_Real*, 5> a2_et2_vals;
+            Array<AgentValues, 5> a2_et2_vals;
             Int a2_et2_size = 0;
             {
                 const auto a2_et2_dest = map.get_destination(a1_et);
@@ -257,7 +233,7 @@ SCIP_RETCODE twovertex_conflicts_separate(
                     debug_assert(a2_et1s[a2_et1_idx] != a2_et2s[a2_et2_idx]);
 
             // Loop through the second agent.
-            for (Agent a2 = 0; a2 < N; ++a2)
+            for (const auto a2 : active_agents)
                 if (a2 != a1)
                 {
                     // Loop through the two edges of agent 2.
@@ -362,6 +338,9 @@ SCIP_DECL_SEPACOPY(sepaCopyTwoVertexConflicts)
 static
 SCIP_DECL_SEPAEXECLP(sepaExeclpTwoVertexConflicts)
 {
+    // Trace.
+    const TraceScope trace(SEPA_NAME);
+
     // Check.
     debug_assert(scip);
     debug_assert(sepa);
@@ -24,6 +24,8 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Separator_VertexFourEdgeConflicts.h"
 #include "ProblemData.h"
 #include "VariableData.h"
+#include "Trace.h"
+#include "Separator_Scheduling.h"
 
 #define SEPA_NAME         "vertex_four_edge"
 #define SEPA_DESC         "Separator for vertex four edge conflicts"
@@ -50,45 +52,12 @@ SCIP_RETCODE vertexfouredge_conflicts_create_cut(
     // Get map.
     const auto& map = SCIPprobdataGetMap(probdata);
 
-    // Create constraint name.
-#ifdef DEBUG
-    const auto [a1_et1_x1, a1_et1_y1] = map.get_xy(a1_et1.n);
-    const auto [a1_et1_x2, a1_et1_y2] = map.get_destination_xy(a1_et1);
-
-    const auto [a1_et2_x1, a1_et2_y1] = map.get_xy(a1_et2.n);
-    const auto [a1_et2_x2, a1_et2_y2] = map.get_destination_xy(a1_et2);
-
-    const auto a1_nt = a1_nts.front();
-    const auto [a1_nt_x1, a1_nt_y1] = map.get_xy(a1_nt.n);
-
-    const auto [a2_et1_x1, a2_et1_y1] = map.get_xy(a2_et1.n);
-    const auto [a2_et1_x2, a2_et1_y2] = map.get_destination_xy(a2_et1);
-
-    const auto [a2_et2_x1, a2_et2_y1] = map.get_xy(a2_et2.n);
-    const auto [a2_et2_x2, a2_et2_y2] = map.get_destination_xy(a2_et2);
-
-    auto name = fmt::format("vertexfouredge_conflict("
-                            "{},(({},{}),({},{}),{}),(({},{}),({},{}),{}),(({},{}),{}),"
-                            "{},(({},{}),({},{}),{}),(({},{}),({},{}),{}))",
-                            a1,
-                            a1_et1_x1, a1_et1_y1, a1_et1.t, a1_et1_x2, a1_et1_y2,
-                            a1_et2_x1, a1_et2_y1, a1_et2.t, a1_et2_x2, a1_et2_y2,
-                            a1_nt_x1, a1_nt_y1, a1_nt.t,
-                            a2,
-                            a2_et1_x1, a2_et1_y1, a2_et1.t, a2_et1_x2, a2_et1_y2,
-                            a2_et2_x1, a2_et2_y1, a2_et2.t, a2_et2_x2, a2_et2_y2);
-#endif
-
     // Create data for the cut.
     TwoAgentRobustCut cut(scip,
                           a1,
                           a2,
                           2 + 5 * a1_nts.size(),
-                          2
-#ifdef DEBUG
-                        , std::move(name)
-#endif
-    );
+                          2);
     cut.a1_edge_time(0) = a1_et1;
     cut.a1_edge_time(1) = a1_et2;
     {
@@ -134,12 +103,11 @@ SCIP_RETCODE vertexfouredge_conflicts_separate(
 
     // Get problem data.
     auto probdata = SCIPgetProbData(scip);
-    const auto N = SCIPprobdataGetN(probdata);
     const auto& map = SCIPprobdataGetMap(probdata);
 
-    // Skip this separator if an earlier separator found cuts.
+    // Skip this separator if an earlier separator found cuts or if its recent calls did not pay off.
     auto& found_cuts = SCIPprobdataGetFoundCutsIndicator(probdata);
-    if (found_cuts)
+    if (!separator_should_run(scip, sepa))
     {
         return SCIP_OKAY;
     }
@@ -149,8 +117,11 @@ SCIP_RETCODE vertexfouredge_conflicts_separate(
     const auto& fractional_move_edges = SCIPprobdataGetFractionalMoveEdges(probdata);
     const auto& fractional_edges = SCIPprobdataGetFractionalEdges(probdata);
 
+    // Get the agents with a fractional edge or meeting a fractional edge.
+    const auto& active_agents = SCIPprobdataGetActiveAgents(probdata);
+
     // Find conflicts.
-    for (Agent a1 = 0; a1 < N; ++a1)
+    for (const auto a1 : active_agents)
     {
         // Get the vertices and edges of agent 1.
         const auto& fractional_vertices_a1 = fractional_vertices[a1];
@@ -183,7 +154,7 @@ SCIP_RETCODE vertexfouredge_conflicts_separate(
                         if (a2_et2.n != a1_et1.n)
                         {
                             // Found the four edges. Look for an agent 2 that uses these edges.
-                            for (Agent a2 = 0; a2 < N; ++a2)
+                            for (const auto a2 : active_agents)
                                 if (a1 != a2)
                                 {
                                     // Get the value of the edges of agent 2.
@@ -281,7 +252,7 @@ SCIP_RETCODE vertexfouredge_conflicts_separate(
                         const EdgeTime a2_et2{a2_et1.n, Direction::WAIT, a2_et1.t + 1};
 
                         // Found the four edges. Look for an agent 2 that uses these edges.
-                        for (Agent a2 = 0; a2 < N; ++a2)
+                        for (const auto a2 : active_agents)
                             if (a1 != a2)
                             {
                                 // Get the value of the edges of agent 2.
@@ -400,6 +371,9 @@ SCIP_DECL_SEPACOPY(sepaCopyVertexFourEdgeConflicts)
 static
 SCIP_DECL_SEPAEXECLP(sepaExeclpVertexFourEdgeConflicts)
 {
+    // Trace.
+    const TraceScope trace(SEPA_NAME);
+
     // Check.
     debug_assert(scip);
     debug_assert(sepa);
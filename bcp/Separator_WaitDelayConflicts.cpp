@@ -24,6 +24,10 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Separator_WaitDelayConflicts.h"
 #include "ProblemData.h"
 #include "VariableData.h"
+#include "Trace.h"
+#include "Separator_Parallel.h"
+#include "Separator_AgentScan.h"
+#include "Separator_Scheduling.h"
 
 #define SEPA_NAME         "wait_delay"
 #define SEPA_DESC         "Separator for wait delay conflicts"
@@ -53,27 +57,13 @@ SCIP_RETCODE waitdelay_conflicts_create_cut(
     SCIP_SEPA* sepa,                     // Separator
     const Agent a1,                      // Agent 1
     const Agent a2,                      // Agent 2
-#ifdef DEBUG
-    const NodeTime nt,                   // Node-time of the conflict
-#endif
     const Array<EdgeTime, 9>& a1_ets,    // Edge-times of agent 1
     const EdgeTime a2_et,                // Edge-time of the wait by agent 2
     SCIP_Result* result                  // Output result
 )
 {
-    // Create constraint name.
-#ifdef DEBUG
-    const auto& map = SCIPprobdataGetMap(probdata);
-    const auto [x, y] = map.get_xy(nt.n);
-    auto name = fmt::format("waitdelay_conflict({},{},({},{}),{})", a1, a2, x, y, nt.t);
-#endif
-
     // Create data for the cut.
-    TwoAgentRobustCut cut{scip, a1, a2, 9, 1
-#ifdef DEBUG
-        , std::move(name)
-#endif
-    };
+    TwoAgentRobustCut cut{scip, a1, a2, 9, 1};
     std::copy(a1_ets.begin(), a1_ets.end(), &cut.a1_edge_time(0));
     cut.a2_edge_time(0) = a2_et;
 
@@ -106,77 +96,102 @@ SCIP_RETCODE waitdelay_conflicts_separate(
     const auto N = SCIPprobdataGetN(probdata);
     const auto& map = SCIPprobdataGetMap(probdata);
 
-    // Skip this separator if an earlier separator found cuts.
+    // Skip this separator if an earlier separator found cuts or if its recent calls did not pay off.
     auto& found_cuts = SCIPprobdataGetFoundCutsIndicator(probdata);
-    if (found_cuts)
+    if (!separator_should_run(scip, sepa))
     {
         return SCIP_OKAY;
     }
 
     // Get the edges fractionally used by each agent.
     const auto& fractional_edges = SCIPprobdataGetFractionalEdges(probdata);
+    const auto& fractional_edges_vec = SCIPprobdataGetFractionalEdgesVec(probdata);
 
     // Find conflicts.
-    Vector<WaitDelayConflictData> cuts;
-    for (Agent a1 = 0; a1 < N; ++a1)
+    auto cuts = find_cuts_in_parallel<WaitDelayConflictData>(scip,
+                                                             0,
+                                                             N,
+                                                             [&](const Agent a1, Vector<WaitDelayConflictData>& agent_cuts)
     {
         // Get the edges of agent 1.
         const auto& fractional_edges_a1 = fractional_edges[a1];
 
-        // Loop through the second agent.
-        for (Agent a2 = 0; a2 < N; ++a2)
-            if (a2 != a1)
+        // Find the node-times n at t where agent 1 is at n at t or enters n at t+1. A cut can only be violated at
+        // these node-times because the LHS of agent 2 waiting at n from t is at most 1.
+        Vector<NodeTime> nts;
+        for (const auto& [a1_et, _] : fractional_edges_a1)
+        {
+            const auto n = map.get_destination(a1_et);
+            nts.push_back(NodeTime{n, a1_et.t + 1});
+            if (a1_et.d != Direction::WAIT && a1_et.t > 0)
             {
-                // Get the edges of agent 2.
-                const auto& fractional_edges_a2 = fractional_edges[a2];
-
-                // Loop through all waits of agent 2.
-                for (const auto& [a2_et, a2_et_val] : fractional_edges_a2)
-                    if (a2_et.d == Direction::WAIT && a2_et.t > 0)
-                    {
-                        // Store the edges for a1 being at n at time t.
-                        const auto nt = a2_et.nt();
-                        Array<EdgeTime, 9> a1_ets;
-                        a1_ets[0] = EdgeTime(map.get_south(nt.n), Direction::NORTH, nt.t - 1);
-                        a1_ets[1] = EdgeTime(map.get_north(nt.n), Direction::SOUTH, nt.t - 1);
-                        a1_ets[2] = EdgeTime(map.get_west(nt.n), Direction::EAST, nt.t - 1);
-                        a1_ets[3] = EdgeTime(map.get_east(nt.n), Direction::WEST, nt.t - 1);
-                        a1_ets[4] = EdgeTime(map.get_wait(nt.n), Direction::WAIT, nt.t - 1);
-
-                        // Store the edges for a1 being at n at time t+1.
-                        a1_ets[5] = EdgeTime(map.get_south(nt.n), Direction::NORTH, nt.t);
-                        a1_ets[6] = EdgeTime(map.get_north(nt.n), Direction::SOUTH, nt.t);
-                        a1_ets[7] = EdgeTime(map.get_west(nt.n), Direction::EAST, nt.t);
-                        a1_ets[8] = EdgeTime(map.get_east(nt.n), Direction::WEST, nt.t);
-
-                        // Calculate the LHS.
-                        debug_assert(a2_et_val > 0);
-                        SCIP_Real lhs = a2_et_val;
-                        for (const auto et : a1_ets)
-                        {
-                            auto it = fractional_edges_a1.find(et);
-                            if (it != fractional_edges_a1.end())
-                            {
-                                lhs += it->second;
-                            }
-                        }
-
-                        // Store a cut if violated.
-                        if (SCIPisSumGT(scip, lhs, 1.0 + CUT_VIOLATION))
-                        {
-                            cuts.emplace_back(WaitDelayConflictData{lhs,
-                                                                    a1,
-                                                                    a2,
-                                                                    a1_ets,
-                                                                    a2_et
+                nts.push_back(NodeTime{n, a1_et.t});
+            }
+        }
+        std::sort(nts.begin(), nts.end(), [](const NodeTime a, const NodeTime b) { return a.nt < b.nt; });
+        nts.erase(std::unique(nts.begin(), nts.end()), nts.end());
+
+        // Loop through the waits of agent 2.
+        for (const auto nt : nts)
+        {
+            // Get the values of the agents waiting at n from t.
+            const EdgeTime a2_et(nt.n, Direction::WAIT, nt.t);
+            const auto a2_et_it = fractional_edges_vec.find(a2_et);
+            if (a2_et_it == fractional_edges_vec.end())
+            {
+                continue;
+            }
+            const AgentValues a2_et_vals = a2_et_it->second;
+
+            // Store the edges for a1 being at n at time t.
+            Array<EdgeTime, 9> a1_ets;
+            a1_ets[0] = EdgeTime(map.get_south(nt.n), Direction::NORTH, nt.t - 1);
+            a1_ets[1] = EdgeTime(map.get_north(nt.n), Direction::SOUTH, nt.t - 1);
+            a1_ets[2] = EdgeTime(map.get_west(nt.n), Direction::EAST, nt.t - 1);
+            a1_ets[3] = EdgeTime(map.get_east(nt.n), Direction::WEST, nt.t - 1);
+            a1_ets[4] = EdgeTime(map.get_wait(nt.n), Direction::WAIT, nt.t - 1);
+
+            // Store the edges for a1 being at n at time t+1.
+            a1_ets[5] = EdgeTime(map.get_south(nt.n), Direction::NORTH, nt.t);
+            a1_ets[6] = EdgeTime(map.get_north(nt.n), Direction::SOUTH, nt.t);
+            a1_ets[7] = EdgeTime(map.get_west(nt.n), Direction::EAST, nt.t);
+            a1_ets[8] = EdgeTime(map.get_east(nt.n), Direction::WEST, nt.t);
+
+            // Calculate the LHS of agent 1.
+            SCIP_Real a1_lhs = 0.0;
+            for (const auto et : a1_ets)
+            {
+                auto it = fractional_edges_a1.find(et);
+                if (it != fractional_edges_a1.end())
+                {
+                    a1_lhs += it->second;
+                }
+            }
+
+            // Store a cut for every second agent with a violated LHS. Only the agents using an edge at n from t can
+            // wait at n.
+            const auto& a2_candidates = SCIPprobdataGetFractionalAgents(probdata, nt);
+            scan_violated_agents<1>(scip,
+                                    {a2_et_vals},
+                                    1,
+                                    a1_lhs,
+                                    a2_candidates.begin(),
+                                    a2_candidates.end(),
+                                    a1,
+                                    [&](const Agent a2, const SCIP_Real lhs)
+            {
+                agent_cuts.emplace_back(WaitDelayConflictData{lhs,
+                                                              a1,
+                                                              a2,
+                                                              a1_ets,
+                                                              a2_et
 #ifdef DEBUG
-                                                                  , nt
+                                                            , nt
 #endif
-                            });
-                        }
-                    }
-            }
-    }
+                });
+            });
+        }
+    });
 
     // Create the most violated cuts.
     Vector<Int> agent_nb_cuts(N * N);
@@ -211,9 +226,6 @@ SCIP_RETCODE waitdelay_conflicts_separate(
                                                      sepa,
                                                      a1,
                                                      a2,
-#ifdef DEBUG
-                                                     nt,
-#endif
                                                      a1_ets,
                                                      a2_et,
                                                      result));
@@ -251,6 +263,9 @@ SCIP_DECL_SEPACOPY(sepaCopyWaitDelayConflicts)
 static
 SCIP_DECL_SEPAEXECLP(sepaExeclpWaitDelayConflicts)
 {
+    // Trace.
+    const TraceScope trace(SEPA_NAME);
+
     // Check.
     debug_assert(scip);
     debug_assert(sepa);
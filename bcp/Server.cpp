@@ -0,0 +1,317 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#include "Server.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+
+// Largest map side and number of agents accepted in a request
+#define MAX_MAP_SIDE 16384
+#define MAX_AGENTS 65536
+#define MAX_NAME_LENGTH 4096
+
+// Data shared by the worker threads
+struct ServerData
+{
+    const SolverOptions& options;        // Solver options
+    SharedInstanceData shared;           // Maps and lower bounds shared by the requests
+    std::mutex maps_mutex;               // Lock for the maps
+    HashTable<String, Map> maps;         // Map last sent with each name
+};
+
+// Read exactly a number of bytes from a socket
+static bool read_bytes(const int fd, void* data, size_t size)
+{
+    auto ptr = reinterpret_cast<char*>(data);
+    while (size > 0)
+    {
+        const auto nb_read = recv(fd, ptr, size, 0);
+        if (nb_read < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (nb_read <= 0)
+        {
+            return false;
+        }
+        ptr += nb_read;
+        size -= nb_read;
+    }
+    return true;
+}
+
+// Write exactly a number of bytes to a socket
+static bool write_bytes(const int fd, const void* data, size_t size)
+{
+    auto ptr = reinterpret_cast<const char*>(data);
+    while (size > 0)
+    {
+        const auto nb_written = send(fd, ptr, size, MSG_NOSIGNAL);
+        if (nb_written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (nb_written <= 0)
+        {
+            return false;
+        }
+        ptr += nb_written;
+        size -= nb_written;
+    }
+    return true;
+}
+
+// Read or write a value
+template<class T>
+static bool read_value(const int fd, T& value)
+{
+    return read_bytes(fd, &value, sizeof(T));
+}
+template<class T>
+static bool write_value(const int fd, const T value)
+{
+    return write_bytes(fd, &value, sizeof(T));
+}
+
+// Write the reply of a request that is not solved or invalid
+static bool write_failure(const int fd, const int32_t status)
+{
+    return write_value<int32_t>(fd, status) &&
+           write_value<double>(fd, -1) &&
+           write_value<double>(fd, -1) &&
+           write_value<int32_t>(fd, 0);
+}
+
+// Read a request, solve it and write the reply. Returns false if the connection is closed.
+static bool serve_request(
+    const int fd,          // Socket of the connection
+    ServerData& data       // Data shared by the worker threads
+)
+{
+    // Read the map.
+    int32_t name_length;
+    if (!read_value(fd, name_length) || name_length < 0 || name_length > MAX_NAME_LENGTH)
+    {
+        return false;
+    }
+    String name(name_length, '\0');
+    int32_t width;
+    int32_t height;
+    int8_t has_grid;
+    if (!read_bytes(fd, name.data(), name_length) ||
+        !read_value(fd, width) ||
+        !read_value(fd, height) ||
+        !read_value(fd, has_grid) ||
+        width <= 0 || width > MAX_MAP_SIDE ||
+        height <= 0 || height > MAX_MAP_SIDE)
+    {
+        return false;
+    }
+    Vector<bool> passable;
+    if (has_grid)
+    {
+        Vector<uint8_t> grid(static_cast<size_t>(width) * height);
+        if (!read_bytes(fd, grid.data(), grid.size()))
+        {
+            return false;
+        }
+        passable.assign(grid.begin(), grid.end());
+    }
+
+    // Read the agents.
+    double time_limit;
+    int32_t N;
+    if (!read_value(fd, time_limit) || !read_value(fd, N) || N < 0 || N > MAX_AGENTS)
+    {
+        return false;
+    }
+    Vector<Array<Position, 4>> agent_coordinates(N);
+    for (auto& coordinates : agent_coordinates)
+        for (auto& coordinate : coordinates)
+        {
+            int32_t value;
+            if (!read_value(fd, value))
+            {
+                return false;
+            }
+            coordinate = value;
+        }
+
+    // Get the map from the request or from the map last sent with the same name.
+    auto instance = std::make_shared<Instance>();
+    instance->map_path = name;
+    if (has_grid)
+    {
+        instance->map.resize(width + 2, height + 2);
+        for (Position y = 0; y < height; ++y)
+            for (Position x = 0; x < width; ++x)
+                if (passable[y * width + x])
+                {
+                    instance->map.set_passable(instance->map.get_id(x + 1, y + 1));
+                }
+        instance->map.compute_neighbours();
+        instance->map.compute_extents();
+        std::lock_guard<std::mutex> lock(data.maps_mutex);
+        data.maps[name] = instance->map;
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(data.maps_mutex);
+        const auto it = data.maps.find(name);
+        if (it == data.maps.end() || it->second.width() != width + 2 || it->second.height() != height + 2)
+        {
+            return write_failure(fd, -1);
+        }
+        instance->map = it->second;
+    }
+
+    // Add the agents with padding.
+    const auto& map = instance->map;
+    for (const auto [start_x, start_y, goal_x, goal_y] : agent_coordinates)
+    {
+        const auto is_passable = [&](const Position x, const Position y)
+        {
+            return 0 <= x && x < width && 0 <= y && y < height && map[map.get_id(x + 1, y + 1)];
+        };
+        if (!is_passable(start_x, start_y) || !is_passable(goal_x, goal_y))
+        {
+            return write_failure(fd, -1);
+        }
+        instance->agents.add_agent(start_x + 1, start_y + 1, goal_x + 1, goal_y + 1, map);
+    }
+    if (instance->agents.empty())
+    {
+        return write_failure(fd, -1);
+    }
+
+    // Solve.
+    auto request_options = data.options;
+    request_options.time_limit = time_limit > 0 ? time_limit : data.options.time_limit;
+    Vector<Vector<Edge>> paths;
+    SCIP_Real cost = -1;
+    SCIP_Real lower_bound = -1;
+    bool solved = false;
+    const auto retcode = solve_instance(request_options,
+                                        instance,
+                                        name.empty() ? "server" : name,
+                                        &data.shared,
+                                        [&](const Vector<Vector<Edge>>& solution_paths,
+                                            const SCIP_Real solution_cost,
+                                            const SCIP_Real solution_lower_bound)
+                                        {
+                                            paths = solution_paths;
+                                            cost = solution_cost;
+                                            lower_bound = solution_lower_bound;
+                                        },
+                                        solved);
+    if (retcode != SCIP_OKAY)
+    {
+        SCIPprintError(retcode);
+        return write_failure(fd, -1);
+    }
+    if (!solved || paths.empty())
+    {
+        return write_failure(fd, 0);
+    }
+
+    // Write the paths without padding.
+    Vector<int32_t> reply;
+    reply.push_back(paths.size());
+    for (const auto& path : paths)
+    {
+        reply.push_back(path.size());
+        for (const auto e : path)
+        {
+            const auto [x, y] = map.get_xy(e.n);
+            reply.push_back(x - 1);
+            reply.push_back(y - 1);
+        }
+    }
+    return write_value<int32_t>(fd, 1) &&
+           write_value<double>(fd, cost) &&
+           write_value<double>(fd, lower_bound) &&
+           write_bytes(fd, reply.data(), reply.size() * sizeof(int32_t));
+}
+
+// Serve solve requests over a Unix domain socket
+SCIP_RETCODE run_server(
+    const SolverOptions& options,                 // Solver options used for every request
+    const std::filesystem::path& socket_path,     // Path of the socket to listen on
+    const Int nb_threads                          // Number of requests solved at the same time
+)
+{
+    // Check.
+    release_assert(nb_threads > 0, "Cannot serve requests with {} threads", nb_threads);
+
+    // Open the socket.
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    release_assert(socket_path.string().size() < sizeof(address.sun_path),
+                   "Socket path {} is too long", socket_path.string());
+    std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+    const auto listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    release_assert(listen_fd >= 0, "Failed to create socket: {}", std::strerror(errno));
+    unlink(socket_path.c_str());
+    release_assert(bind(listen_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0,
+                   "Failed to bind socket {}: {}", socket_path.string(), std::strerror(errno));
+    release_assert(listen(listen_fd, nb_threads) == 0, "Failed to listen on socket {}: {}",
+                   socket_path.string(), std::strerror(errno));
+    println("Serving requests on {} with {} threads", socket_path.string(), nb_threads);
+
+    // Serve the connections. Each thread takes the next connection.
+    auto request_options = options;
+    request_options.quiet = options.quiet || nb_threads > 1;
+    ServerData data{request_options, {}, {}, {}};
+    const auto worker = [&]()
+    {
+        while (true)
+        {
+            const auto fd = accept(listen_fd, nullptr, nullptr);
+            if (fd < 0)
+            {
+                if (errno == EINTR || errno == ECONNABORTED)
+                {
+                    continue;
+                }
+                err("Failed to accept connection: {}", std::strerror(errno));
+            }
+            while (serve_request(fd, data));
+            close(fd);
+        }
+    };
+    Vector<std::thread> threads;
+    for (Int thread_idx = 1; thread_idx < nb_threads; ++thread_idx)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    // Done.
+    close(listen_fd);
+    unlink(socket_path.c_str());
+    return SCIP_OKAY;
+}
@@ -0,0 +1,53 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#ifndef MAPF_SERVER_H
+#define MAPF_SERVER_H
+
+#include "Includes.h"
+#include "Solver.h"
+#include <filesystem>
+
+// Serve solve requests over a Unix domain socket until the process is stopped. A pool of worker threads each serves
+// one connection at a time and a connection can send any number of requests. The parsed maps and the lower bounds of
+// the low-level solver are kept across requests for maps with the same name.
+//
+// Integers are 32-bit signed integers and reals are 64-bit floating-point numbers, both in host byte order. Coordinates
+// are in the format of the scenario files.
+//
+// A request has:
+//  - the length of the map name followed by the characters of the name
+//  - the width and the height of the map
+//  - 1 followed by width * height bytes with 1 for passable cells and 0 for obstacles in row-major order, or 0 to
+//    reuse the map last sent with the same name
+//  - the time limit in seconds as a real (0 for no limit)
+//  - the number of agents followed by the start x, start y, goal x and goal y of every agent
+//
+// A reply has:
+//  - the status: 1 if solved, 0 if not solved or -1 if the request is invalid
+//  - the cost and the lower bound as reals
+//  - the number of paths followed by every path as its length and the x and y of every timestep, or no paths if not
+//    solved
+SCIP_RETCODE run_server(
+    const SolverOptions& options,                 // Solver options used for every request
+    const std::filesystem::path& socket_path,     // Path of the socket to listen on
+    const Int nb_threads                          // Number of requests solved at the same time
+);
+
+#endif
@@ -0,0 +1,259 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#include "SolutionStream.h"
+#include "ProblemData.h"
+#include "VariableData.h"
+#include <cstdio>
+
+#define EVENTHDLR_NAME "mapf_solution_stream"
+#define EVENTHDLR_DESC "Stream of the incumbents and the bounds"
+
+#define DEFAULT_SOLUTION_STREAM_FILE ""    // File or pipe to append the incumbents to (empty to disable)
+
+struct SolutionStreamData
+{
+    FILE* f;    // Output file
+};
+
+// Format a real number in JSON
+static String format_json_real(
+    SCIP* scip,              // SCIP
+    const SCIP_Real value    // Value
+)
+{
+    return SCIPisInfinity(scip, REALABS(value)) ? String("null") : fmt::format("{:.6f}", value);
+}
+
+// Write one line with the progress of the solve and the paths of a solution
+static SCIP_RETCODE write_solution_line(
+    SCIP* scip,              // SCIP
+    FILE* f,                 // Output file
+    const char* event,       // Name of the event
+    SCIP_SOL* sol            // Solution or null for none
+)
+{
+    // Get problem data.
+    auto probdata = SCIPgetProbData(scip);
+    const auto N = SCIPprobdataGetN(probdata);
+    const auto& agent_vars = SCIPprobdataGetAgentVars(probdata);
+
+    // Write the progress.
+    fmt::print(f,
+               "{{\"event\": \"{}\", \"instance\": \"{}\", \"time\": {:.6f}, \"nodes\": {}, "
+               "\"bound\": {}, \"gap\": {}",
+               event,
+               SCIPgetProbName(scip),
+               SCIPgetSolvingTime(scip),
+               SCIPgetNNodes(scip),
+               format_json_real(scip, SCIPgetDualbound(scip)),
+               format_json_real(scip, SCIPgetGap(scip)));
+
+    // Write the paths.
+    if (sol)
+    {
+        fmt::print(f, ", \"obj\": {:.0f}, \"paths\": [", SCIPround(scip, SCIPgetSolOrigObj(scip, sol)));
+        for (Agent a = 0; a < N; ++a)
+        {
+            for (const auto& [var, _] : agent_vars[a])
+            {
+                debug_assert(var);
+                if (SCIPisPositive(scip, SCIPgetSolVal(scip, sol, var)))
+                {
+                    auto vardata = SCIPvarGetData(var);
+                    const auto path_length = SCIPvardataGetPathLength(vardata);
+                    const auto path = SCIPvardataGetPath(vardata);
+                    fmt::print(f, "{}\"{}\"", a == 0 ? "" : ", ", format_path(probdata, path_length, path));
+                    break;
+                }
+            }
+        }
+        fmt::print(f, "]");
+    }
+    fmt::print(f, "}}\n");
+
+    // Flush so that readers receive the line immediately.
+    fflush(f);
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Check if a solution uses an artificial variable and is therefore not a plan
+static bool is_artificial_solution(
+    SCIP* scip,      // SCIP
+    SCIP_SOL* sol    // Solution
+)
+{
+    if (SCIPgetSolOrigObj(scip, sol) >= ARTIFICIAL_VAR_COST)
+    {
+        return true;
+    }
+    const auto& dummy_vars = SCIPprobdataGetDummyVars(SCIPgetProbData(scip));
+    for (auto var : dummy_vars)
+    {
+        debug_assert(var);
+        if (SCIPisPositive(scip, SCIPgetSolVal(scip, sol, var)))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Open the stream at the start of the solve
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_EVENTINITSOL(eventInitsolSolutionStream)
+{
+    // Get event handler data.
+    auto eventhdlrdata = reinterpret_cast<SolutionStreamData*>(SCIPeventhdlrGetData(eventhdlr));
+    debug_assert(eventhdlrdata);
+    debug_assert(!eventhdlrdata->f);
+
+    // Open the file in append mode so that the lines of earlier solves are kept. Opening a pipe waits for a reader.
+    char* filename;
+    SCIP_CALL(SCIPgetStringParam(scip, SOLUTION_STREAM_FILE_PARAM, &filename));
+    if (filename[0] != '\0')
+    {
+        eventhdlrdata->f = fopen(filename, "a");
+        release_assert(eventhdlrdata->f, "Failed to open file {} to stream solutions", filename);
+
+        // Write the incumbent found before the solve, such as from a warm start.
+        auto sol = SCIPgetBestSol(scip);
+        if (sol && !is_artificial_solution(scip, sol))
+        {
+            SCIP_CALL(write_solution_line(scip, eventhdlrdata->f, "incumbent", sol));
+        }
+
+        // Catch every new incumbent.
+        SCIP_CALL(SCIPcatchEvent(scip, SCIP_EVENTTYPE_BESTSOLFOUND, eventhdlr, nullptr, nullptr));
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Write the final bounds and close the stream at the end of the solve
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_EVENTEXITSOL(eventExitsolSolutionStream)
+{
+    // Get event handler data.
+    auto eventhdlrdata = reinterpret_cast<SolutionStreamData*>(SCIPeventhdlrGetData(eventhdlr));
+    debug_assert(eventhdlrdata);
+
+    // Write the final line and close the file.
+    if (eventhdlrdata->f)
+    {
+        SCIP_CALL(SCIPdropEvent(scip, SCIP_EVENTTYPE_BESTSOLFOUND, eventhdlr, nullptr, -1));
+        SCIP_CALL(write_solution_line(scip, eventhdlrdata->f, "done", nullptr));
+        fclose(eventhdlrdata->f);
+        eventhdlrdata->f = nullptr;
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Write a new incumbent
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_EVENTEXEC(eventExecSolutionStream)
+{
+    // Get event handler data.
+    auto eventhdlrdata = reinterpret_cast<SolutionStreamData*>(SCIPeventhdlrGetData(eventhdlr));
+    debug_assert(eventhdlrdata);
+    debug_assert(eventhdlrdata->f);
+    debug_assert(SCIPeventGetType(event) == SCIP_EVENTTYPE_BESTSOLFOUND);
+
+    // Write the incumbent if it is a plan for every agent.
+    auto sol = SCIPeventGetSol(event);
+    debug_assert(sol);
+    if (!is_artificial_solution(scip, sol))
+    {
+        SCIP_CALL(write_solution_line(scip, eventhdlrdata->f, "incumbent", sol));
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Free event handler
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_EVENTFREE(eventFreeSolutionStream)
+{
+    auto eventhdlrdata = reinterpret_cast<SolutionStreamData*>(SCIPeventhdlrGetData(eventhdlr));
+    debug_assert(eventhdlrdata);
+    debug_assert(!eventhdlrdata->f);
+    SCIPfreeBlockMemory(scip, &eventhdlrdata);
+    SCIPeventhdlrSetData(eventhdlr, nullptr);
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Include the solution stream event handler
+SCIP_RETCODE SCIPincludeEventhdlrSolutionStream(
+    SCIP* scip    // SCIP
+)
+{
+    // Create event handler data.
+    SolutionStreamData* eventhdlrdata = nullptr;
+    SCIP_CALL(SCIPallocBlockMemory(scip, &eventhdlrdata));
+    debug_assert(eventhdlrdata);
+    eventhdlrdata->f = nullptr;
+
+    // Include event handler.
+    SCIP_EVENTHDLR* eventhdlr = nullptr;
+    SCIP_CALL(SCIPincludeEventhdlrBasic(scip,
+                                        &eventhdlr,
+                                        EVENTHDLR_NAME,
+                                        EVENTHDLR_DESC,
+                                        eventExecSolutionStream,
+                                        reinterpret_cast<SCIP_EVENTHDLRDATA*>(eventhdlrdata)));
+    debug_assert(eventhdlr);
+
+    // Set callbacks.
+    SCIP_CALL(SCIPsetEventhdlrInitsol(scip, eventhdlr, eventInitsolSolutionStream));
+    SCIP_CALL(SCIPsetEventhdlrExitsol(scip, eventhdlr, eventExitsolSolutionStream));
+    SCIP_CALL(SCIPsetEventhdlrFree(scip, eventhdlr, eventFreeSolutionStream));
+
+    // Add parameters.
+    SCIP_CALL(SCIPaddStringParam(scip,
+                                 SOLUTION_STREAM_FILE_PARAM,
+                                 "file or pipe to append every new incumbent to (empty to disable)",
+                                 nullptr,
+                                 FALSE,
+                                 DEFAULT_SOLUTION_STREAM_FILE,
+                                 nullptr,
+                                 nullptr));
+
+    // Done.
+    return SCIP_OKAY;
+}
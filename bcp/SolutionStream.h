@@ -0,0 +1,34 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#ifndef MAPF_SOLUTIONSTREAM_H
+#define MAPF_SOLUTIONSTREAM_H
+
+#include "Includes.h"
+
+#define SOLUTION_STREAM_FILE_PARAM "mapf/solutionstream/file"
+
+// Include the event handler that appends every new incumbent to a file or a pipe as soon as it is found. Each
+// line is a JSON object with the paths of the incumbent and the global bound and gap at the time. A last line is
+// written at the end of the solve.
+SCIP_RETCODE SCIPincludeEventhdlrSolutionStream(
+    SCIP* scip    // SCIP
+);
+
+#endif
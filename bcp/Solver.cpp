@@ -0,0 +1,684 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#include "Solver.h"
+#include "Output.h"
+#include "Pricer_TruffleHog.h"
+#include "SolutionStream.h"
+#include "NodeLog.h"
+#include "Anytime.h"
+#include "Subtree.h"
+#include "NodeSelector_Hybrid.h"
+#include "ProblemData.h"
+#include "Separator_Selection.h"
+#ifdef USE_EECBS_PRIMAL_HEURISTIC
+#include "Heuristic_EECBS.h"
+#endif
+
+#include "scip/scipshell.h"
+#include "scip/scipdefplugins.h"
+#include "scip/clock.h"
+
+#include <fstream>
+
+// Lock for the statistics file and the log shared by the instances solved at the same time
+std::mutex output_mutex;
+
+// Solve one instance
+SCIP_RETCODE solve_instance(
+    const SolverOptions& options,    // Program options
+    const String& instance_file,     // Path to instance
+    SharedInstanceData* shared,      // Data shared with other instances in batch mode
+    bool& solved,                    // Indicates if the instance is solved
+    AgentSweepData* sweep,           // Columns of the problem with fewer agents
+    AgentGroup* group,               // Agents solved alone in independence detection
+    RaceData* race                   // Incumbents shared with the other racers in racing mode
+)
+{
+    // Initialize SCIP.
+    SCIP* scip = nullptr;
+    SCIP_CALL(SCIPcreate(&scip));
+
+    // Hide the log when several instances are solved at the same time.
+    if (options.quiet)
+    {
+        SCIP_CALL(SCIPsetIntParam(scip, "display/verblevel", 0));
+    }
+
+    // Set up plugins.
+    {
+        // Include some default SCIP plugins.
+        {
+            SCIP_CALL( SCIPincludeConshdlrLinear(scip) ); /* linear must be before its specializations due to constraint upgrading */
+            SCIP_CALL( SCIPincludeConshdlrIndicator(scip) );
+            SCIP_CALL( SCIPincludeConshdlrIntegral(scip) );
+            SCIP_CALL( SCIPincludeConshdlrKnapsack(scip) );
+            SCIP_CALL( SCIPincludeConshdlrSetppc(scip) );
+
+            SCIP_CALL( SCIPincludeNodeselBfs(scip) );
+            SCIP_CALL( SCIPincludeNodeselBreadthfirst(scip) );
+            SCIP_CALL( SCIPincludeNodeselDfs(scip) );
+            SCIP_CALL( SCIPincludeNodeselEstimate(scip) );
+            SCIP_CALL( SCIPincludeNodeselHybridestim(scip) );
+            SCIP_CALL( SCIPincludeNodeselRestartdfs(scip) );
+            SCIP_CALL( SCIPincludeNodeselUct(scip) );
+            SCIP_CALL( SCIPincludeNodeselHybrid(scip) );
+
+            SCIP_CALL( SCIPincludeEventHdlrEstim(scip) );
+            SCIP_CALL( SCIPincludeEventHdlrSolvingphase(scip) );
+
+            SCIP_CALL( SCIPincludeHeurActconsdiving(scip) );
+            SCIP_CALL( SCIPincludeHeurAdaptivediving(scip) );
+            SCIP_CALL( SCIPincludeHeurBound(scip) );
+            SCIP_CALL( SCIPincludeHeurClique(scip) );
+            SCIP_CALL( SCIPincludeHeurCoefdiving(scip) );
+            SCIP_CALL( SCIPincludeHeurCompletesol(scip) );
+            SCIP_CALL( SCIPincludeHeurConflictdiving(scip) );
+            SCIP_CALL( SCIPincludeHeurCrossover(scip) );
+            SCIP_CALL( SCIPincludeHeurDins(scip) );
+            SCIP_CALL( SCIPincludeHeurDistributiondiving(scip) );
+            SCIP_CALL( SCIPincludeHeurDualval(scip) );
+            SCIP_CALL( SCIPincludeHeurFarkasdiving(scip) );
+            SCIP_CALL( SCIPincludeHeurFeaspump(scip) );
+            SCIP_CALL( SCIPincludeHeurFixandinfer(scip) );
+            SCIP_CALL( SCIPincludeHeurFracdiving(scip) );
+            SCIP_CALL( SCIPincludeHeurGins(scip) );
+            SCIP_CALL( SCIPincludeHeurGuideddiving(scip) );
+            SCIP_CALL( SCIPincludeHeurZeroobj(scip) );
+            SCIP_CALL( SCIPincludeHeurIndicator(scip) );
+            SCIP_CALL( SCIPincludeHeurIntdiving(scip) );
+            SCIP_CALL( SCIPincludeHeurIntshifting(scip) );
+            SCIP_CALL( SCIPincludeHeurLinesearchdiving(scip) );
+            SCIP_CALL( SCIPincludeHeurLocalbranching(scip) );
+            SCIP_CALL( SCIPincludeHeurLocks(scip) );
+            SCIP_CALL( SCIPincludeHeurLpface(scip) );
+            SCIP_CALL( SCIPincludeHeurAlns(scip) );
+            SCIP_CALL( SCIPincludeHeurNlpdiving(scip) );
+            SCIP_CALL( SCIPincludeHeurMutation(scip) );
+            SCIP_CALL( SCIPincludeHeurMultistart(scip) );
+            SCIP_CALL( SCIPincludeHeurMpec(scip) );
+            SCIP_CALL( SCIPincludeHeurObjpscostdiving(scip) );
+            SCIP_CALL( SCIPincludeHeurOctane(scip) );
+            SCIP_CALL( SCIPincludeHeurOfins(scip) );
+            SCIP_CALL( SCIPincludeHeurOneopt(scip) );
+            SCIP_CALL( SCIPincludeHeurPADM(scip) );
+            SCIP_CALL( SCIPincludeHeurProximity(scip) );
+            SCIP_CALL( SCIPincludeHeurPscostdiving(scip) );
+            SCIP_CALL( SCIPincludeHeurRandrounding(scip) );
+            SCIP_CALL( SCIPincludeHeurRens(scip) );
+            SCIP_CALL( SCIPincludeHeurReoptsols(scip) );
+            SCIP_CALL( SCIPincludeHeurRepair(scip) );
+            SCIP_CALL( SCIPincludeHeurRins(scip) );
+            SCIP_CALL( SCIPincludeHeurRootsoldiving(scip) );
+            SCIP_CALL( SCIPincludeHeurRounding(scip) );
+            SCIP_CALL( SCIPincludeHeurShiftandpropagate(scip) );
+            SCIP_CALL( SCIPincludeHeurShifting(scip) );
+            SCIP_CALL( SCIPincludeHeurSimplerounding(scip) );
+            SCIP_CALL( SCIPincludeHeurSubNlp(scip) );
+            SCIP_CALL( SCIPincludeHeurTrivial(scip) );
+            SCIP_CALL( SCIPincludeHeurTrivialnegation(scip) );
+            SCIP_CALL( SCIPincludeHeurTrustregion(scip) );
+            SCIP_CALL( SCIPincludeHeurTrySol(scip) );
+            SCIP_CALL( SCIPincludeHeurTwoopt(scip) );
+            SCIP_CALL( SCIPincludeHeurUndercover(scip) );
+            SCIP_CALL( SCIPincludeHeurVbounds(scip) );
+            SCIP_CALL( SCIPincludeHeurVeclendiving(scip) );
+            SCIP_CALL( SCIPincludeHeurZirounding(scip) );
+
+            SCIP_CALL( SCIPincludeDispDefault(scip) );
+            SCIP_CALL( SCIPincludeTableDefault(scip) );
+
+            SCIP_CALL( SCIPincludeConcurrentScipSolvers(scip) );
+        }
+        // SCIP_CALL(SCIPincludeDefaultPlugins(scip));
+
+        // Disable parallel solve.
+        SCIP_CALL(SCIPsetIntParam(scip, "parallel/maxnthreads", 1));
+        SCIP_CALL(SCIPsetIntParam(scip, "lp/threads", 1));
+
+        // Set parameters.
+        SCIP_CALL(SCIPsetIntParam(scip, "presolving/maxrounds", 0));
+        // SCIP_CALL(SCIPsetIntParam(scip, "propagating/rootredcost/freq", -1));
+        SCIP_CALL(SCIPsetIntParam(scip, "separating/maxaddrounds", -1));
+        SCIP_CALL(SCIPsetIntParam(scip, "separating/maxstallrounds", 5));
+        SCIP_CALL(SCIPsetIntParam(scip, "separating/maxstallroundsroot", 20));
+        SCIP_CALL(SCIPsetIntParam(scip, "separating/cutagelimit", -1));
+
+        // Turn off all separation algorithms.
+        SCIP_CALL(SCIPsetSeparating(scip, SCIP_PARAMSETTING_OFF, TRUE));
+
+        // Set node selection rule.
+        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/bfs/stdpriority", 0));
+        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/bfs/memsavepriority", 0));
+        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/breadthfirst/stdpriority", 0));
+        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/breadthfirst/memsavepriority", 0));
+        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/dfs/stdpriority", 0));
+        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/dfs/memsavepriority", 0));
+        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/estimate/stdpriority", 0));
+        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/estimate/memsavepriority", 0));
+        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/hybridestim/stdpriority", 0));
+        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/hybridestim/memsavepriority", 0));
+        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/restartdfs/stdpriority", 0));
+        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/restartdfs/memsavepriority", 0));
+        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/uct/stdpriority", 0));
+        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/uct/memsavepriority", 0));
+        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/mapf_hybrid/stdpriority", 0));
+        SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/mapf_hybrid/memsavepriority", 0));
+        if (options.node_selection == "hybrid")
+        {
+            // Fall back to depth-first search when the memory limit is approached.
+            SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/mapf_hybrid/stdpriority", 500000));
+            SCIP_CALL(SCIPsetIntParam(scip, "nodeselection/dfs/memsavepriority", 500000));
+        }
+        else if (options.node_selection == "bfs" ||
+                 options.node_selection == "dfs" ||
+                 options.node_selection == "estimate" ||
+                 options.node_selection == "hybridestim" ||
+                 options.node_selection == "restartdfs")
+        {
+            const auto param = fmt::format("nodeselection/{}/", options.node_selection);
+            SCIP_CALL(SCIPsetIntParam(scip, (param + "stdpriority").c_str(), 500000));
+            SCIP_CALL(SCIPsetIntParam(scip, (param + "memsavepriority").c_str(), 500000));
+        }
+        else
+        {
+            err("Invalid node selection rule {}", options.node_selection);
+        }
+
+        // Turn on aggressive primal heuristics.
+        SCIP_CALL(SCIPsetHeuristics(scip, SCIP_PARAMSETTING_AGGRESSIVE, TRUE));
+
+        // Turn off some primal heuristics.
+        {
+            const auto nheurs = SCIPgetNHeurs(scip);
+            auto heurs = SCIPgetHeurs(scip);
+            for (Int idx = 0; idx < nheurs; ++idx)
+            {
+                auto heur = heurs[idx];
+                const String name(SCIPheurGetName(heur));
+                if (name == "alns" ||
+                    name == "bound" ||
+                    name == "coefdiving" ||
+                    name == "crossover" ||
+                    name == "dins" ||
+                    name == "fixandinfer" ||
+                    name == "gins" ||
+                    name == "guideddiving" ||
+                    name == "intdiving" ||
+                    name == "localbranching" ||
+                    name == "locks" ||
+                    name == "mutation" ||
+                    name == "oneopt" ||
+                    name == "rens" ||
+                    name == "repair" ||
+                    name == "rins" ||
+                    name == "trivial" ||
+                    name == "zeroobj" ||
+                    name == "zirounding" ||
+                    name == "proximity" || // Buggy
+                    name == "twoopt")      // Buggy
+                {
+                    SCIPheurSetFreq(heur, -1);
+                }
+            }
+        }
+    }
+
+    // Read instance.
+    release_assert(options.agent_limit > 0, "Cannot limit to {} number of agents", options.agent_limit);
+    if (group)
+    {
+        SCIP_CALL(read_instance(scip,
+                                group->instance,
+                                fmt::format("{}-group{}",
+                                            std::filesystem::path(instance_file).stem().string(),
+                                            group->agents.front()),
+                                options.heuristic_cache_dir,
+                                static_cast<size_t>(options.heuristic_memory) * 1024 * 1024,
+                                shared));
+    }
+    else
+    {
+        SCIP_CALL(read_instance(scip,
+                                instance_file.c_str(),
+                                options.agent_limit,
+                                options.heuristic_cache_dir,
+                                options.map_cache,
+                                static_cast<size_t>(options.heuristic_memory) * 1024 * 1024,
+                                shared));
+    }
+
+    // Share the incumbents with the other racers.
+    if (race)
+    {
+        SCIP_CALL(SCIPincludeHeurRacing(scip, race));
+    }
+
+    // Add the paths of a previous run as initial columns and an initial solution.
+    if (!options.warm_start_file.empty())
+    {
+        SCIP_CALL(read_warm_start(scip, options.warm_start_file));
+    }
+
+    // Resume from a checkpoint.
+    if (!options.resume_file.empty())
+    {
+        SCIP_CALL(read_checkpoint(scip, options.resume_file));
+    }
+
+    // Restrict the search to a subtree handed out by a coordinator.
+    if (!options.subtree_file.empty())
+    {
+        SCIP_CALL(read_subtree(scip, options.subtree_file));
+    }
+
+    // Prune nodes that cannot improve on an incumbent found elsewhere.
+    if (options.cutoff > 0)
+    {
+        SCIP_CALL(SCIPsetObjlimit(scip, options.cutoff));
+    }
+
+    // Add the columns of the problem with fewer agents.
+    if (sweep)
+    {
+        SCIP_CALL(restore_columns(scip, sweep->columns));
+        sweep->columns.clear();
+    }
+
+    // Seed the columns with the solutions of EECBS. The EECBS instance is read from the scenario file so groups are
+    // not seeded.
+#ifdef USE_EECBS_PRIMAL_HEURISTIC
+    if (!group)
+    {
+        SCIP_CALL(add_eecbs_columns(scip));
+    }
+#endif
+
+    // Add the paths of the group as initial columns and an initial solution. The paths of merged groups are cleared
+    // so these are the paths kept from the previous window or replan. SCIP discards the solution when the problem is
+    // transformed if the paths collide.
+    if (group && !group->paths.empty())
+    {
+        auto probdata = SCIPgetProbData(scip);
+        SCIP_SOL* sol;
+        SCIP_CALL(SCIPcreateSol(scip, &sol, nullptr));
+        for (Agent a = 0; a < static_cast<Agent>(group->paths.size()); ++a)
+        {
+            const auto& path = group->paths[a];
+            SCIP_VAR* var = nullptr;
+            SCIP_CALL(SCIPprobdataAddInitialVar(scip, probdata, a, path.size(), path.data(), &var));
+            debug_assert(var);
+            SCIP_CALL(SCIPsetSolVal(scip, sol, var, 1.0));
+        }
+        SCIP_Bool stored;
+        SCIP_CALL(SCIPaddSolFree(scip, &sol, &stored));
+    }
+
+    // Set checkpoint file.
+    if (!options.checkpoint_file.empty())
+    {
+        SCIP_CALL(SCIPsetStringParam(scip, CHECKPOINT_FILE_PARAM, options.checkpoint_file.c_str()));
+    }
+    if (options.checkpoint_interval > 0)
+    {
+        SCIP_CALL(SCIPsetRealParam(scip, CHECKPOINT_INTERVAL_PARAM, options.checkpoint_interval));
+    }
+
+    // Set interval between samples of the memory usage.
+    if (options.memory_interval >= 0)
+    {
+        SCIP_CALL(SCIPsetRealParam(scip, MEMORY_USAGE_INTERVAL_PARAM, options.memory_interval));
+    }
+
+    // Set file to stream the incumbents to.
+    if (!options.solution_stream_file.empty())
+    {
+        SCIP_CALL(SCIPsetStringParam(scip, SOLUTION_STREAM_FILE_PARAM, options.solution_stream_file.c_str()));
+    }
+
+    // Set file to log the nodes to.
+    if (!options.node_log_file.empty())
+    {
+        SCIP_CALL(SCIPsetStringParam(scip, NODE_LOG_FILE_PARAM, options.node_log_file.c_str()));
+    }
+
+    // Set time limit.
+    if (options.time_limit > 0)
+    {
+        SCIP_CALL(SCIPsetRealParam(scip, "limits/time", options.time_limit));
+    }
+
+    // Set node limit.
+    if (options.node_limit > 0)
+    {
+        SCIP_CALL(SCIPsetLongintParam(scip, "limits/nodes", options.node_limit));
+    }
+
+    // Set the random seeds.
+    if (options.seed != 0)
+    {
+        SCIP_CALL(SCIPsetIntParam(scip, "randomization/randomseedshift", options.seed));
+    }
+
+    // Set optimality gap limit.
+    if (options.gap_limit > 0)
+    {
+        SCIP_CALL(SCIPsetRealParam(scip, "limits/gap", options.gap_limit));
+    }
+
+    // Set schedule of gap limits.
+    if (!options.anytime_schedule.empty())
+    {
+        SCIP_CALL(SCIPsetStringParam(scip, ANYTIME_SCHEDULE_PARAM, options.anytime_schedule.c_str()));
+    }
+
+    // Set number of pricing threads.
+    release_assert(options.pricing_threads > 0, "Cannot price with {} threads", options.pricing_threads);
+    SCIP_CALL(SCIPsetIntParam(scip, "pricers/trufflehog/threads", options.pricing_threads));
+    release_assert(options.pricing_columns > 0, "Cannot add {} columns per agent", options.pricing_columns);
+    SCIP_CALL(SCIPsetIntParam(scip, "pricers/trufflehog/columns", options.pricing_columns));
+
+    // Set weight of the stability center for pricing.
+    release_assert(options.pricing_smoothing >= 0 && options.pricing_smoothing <= 0.99,
+                   "Invalid weight {} of the stability center for pricing", options.pricing_smoothing);
+    SCIP_CALL(SCIPsetRealParam(scip, "pricers/trufflehog/smoothing", options.pricing_smoothing));
+
+    // Set adaptive number of agents to price.
+    SCIP_CALL(SCIPsetBoolParam(scip, "pricers/trufflehog/adaptivebatch", options.adaptive_pricing));
+
+    // Set pruning of labels backward from the goal for constrained agents.
+    SCIP_CALL(SCIPsetBoolParam(scip, "pricers/trufflehog/backwardpruning", options.backward_pruning));
+
+    // Set the bound on the unavoidable edge penalties in the heuristic for constrained agents.
+    SCIP_CALL(SCIPsetBoolParam(scip, "pricers/trufflehog/penaltyheuristic", options.penalty_heuristic));
+
+    // Set sharing of the pricing problem of interchangeable agents.
+    SCIP_CALL(SCIPsetBoolParam(scip, "pricers/trufflehog/symmetry", options.symmetric_pricing));
+    SCIP_CALL(SCIPsetBoolParam(scip, "pricers/trufflehog/redcostfixing", options.reduced_cost_fixing));
+
+    // Set the number of labels expanded for an agent before pricing exactly.
+    release_assert(options.label_budget >= 0, "Invalid label budget {}", options.label_budget);
+    SCIP_CALL(SCIPsetIntParam(scip, "pricers/trufflehog/labelbudget", options.label_budget));
+
+    // Set the weight of the lower bound in the search before pricing exactly.
+    release_assert(options.focal_weight >= 1.0, "Invalid focal weight {}", options.focal_weight);
+    SCIP_CALL(SCIPsetRealParam(scip, "pricers/trufflehog/focalweight", options.focal_weight));
+
+    // Set memory for the labels of the pricer.
+    if (options.label_block_size != 0)
+    {
+        release_assert(options.label_block_size > 0, "Invalid label block size {} MB", options.label_block_size);
+        SCIP_CALL(SCIPsetIntParam(scip, "pricers/trufflehog/labelblocksize", options.label_block_size));
+    }
+    SCIP_CALL(SCIPsetBoolParam(scip, "pricers/trufflehog/hugepages", options.huge_pages));
+
+    // Set placement of the pricing threads on the NUMA nodes.
+    SCIP_CALL(SCIPsetBoolParam(scip, "pricers/trufflehog/pinthreads", options.pin_threads));
+    SCIP_CALL(SCIPsetBoolParam(scip, "pricers/trufflehog/numareplicate", options.numa_replicate));
+    SCIP_CALL(SCIPsetIntParam(scip, "pricers/trufflehog/heuristicthreads", options.heuristic_threads));
+    release_assert(options.frontier_budget >= 0, "Invalid frontier budget {} MB", options.frontier_budget);
+    SCIP_CALL(SCIPsetIntParam(scip, "pricers/trufflehog/frontierbudget", options.frontier_budget));
+
+    // Set low-level solver of the pricer.
+    if (!options.pricer_low_level_solver.empty())
+    {
+        auto low_level_solver = PricerLowLevelSolver::AStar;
+        if (options.pricer_low_level_solver == "astar")
+        {
+            low_level_solver = PricerLowLevelSolver::AStar;
+        }
+        else if (options.pricer_low_level_solver == "sipp")
+        {
+            low_level_solver = PricerLowLevelSolver::SIPP;
+        }
+        else if (options.pricer_low_level_solver == "auto")
+        {
+            low_level_solver = PricerLowLevelSolver::Auto;
+        }
+        else
+        {
+            err("Invalid low-level solver {} for the pricer", options.pricer_low_level_solver);
+        }
+        SCIP_CALL(SCIPsetIntParam(scip, "pricers/trufflehog/lowlevel", static_cast<int>(low_level_solver)));
+    }
+    if (!options.pricing_record_file.empty())
+    {
+        SCIP_CALL(SCIPsetStringParam(scip, "pricers/trufflehog/recordfile", options.pricing_record_file.c_str()));
+    }
+
+    // Set recording of the input of the separators.
+    if (!options.separation_record_file.empty())
+    {
+        SCIP_CALL(SCIPsetStringParam(scip, "separating/mapf/recordfile", options.separation_record_file.c_str()));
+        SCIP_CALL(SCIPsetIntParam(scip, "separating/mapf/recordnode", options.separation_record_node));
+        SCIP_CALL(SCIPsetIntParam(scip, "separating/mapf/recordrounds", options.separation_record_rounds));
+    }
+
+    // Set number of separation threads.
+    release_assert(options.separation_threads > 0, "Cannot separate with {} threads", options.separation_threads);
+    SCIP_CALL(SCIPsetIntParam(scip, "separating/mapf/threads", options.separation_threads));
+
+    // Set skipping of separators that rarely find cuts.
+    SCIP_CALL(SCIPsetBoolParam(scip, "separating/mapf/adaptive", options.adaptive_separation));
+
+    // Choose the separators to run.
+    if (options.separator_profile == "auto")
+    {
+        SCIP_CALL(SCIPapplyAutomaticSeparatorProfile(scip));
+    }
+    else if (!options.separator_profile.empty() && options.separator_profile != "all")
+    {
+        err("Invalid separator profile {}", options.separator_profile);
+    }
+    if (!options.separators.empty())
+    {
+        SCIP_CALL(SCIPenableSeparatorsOnly(scip, options.separators));
+    }
+    SCIP_CALL(SCIPdisableSeparators(scip, options.disabled_separators));
+
+    // Set number of branching candidates evaluated by re-pricing.
+    release_assert(options.branching_lookahead >= 0, "Invalid branching look-ahead {}", options.branching_lookahead);
+    SCIP_CALL(SCIPsetIntParam(scip, "branching/mapf/lookahead", options.branching_lookahead));
+
+    // Set number of observations for the pseudocosts of a branching decision to be reliable.
+    release_assert(options.branching_reliability >= 0,
+                   "Invalid branching reliability {}", options.branching_reliability);
+    SCIP_CALL(SCIPsetIntParam(scip, "branching/mapf/reliability", options.branching_reliability));
+
+    // Set whether to branch on waits before vertices.
+    SCIP_CALL(SCIPsetBoolParam(scip, "branching/mapf/wait", options.wait_branching));
+
+    // Delete columns that have aged out of the LP. SCIP only deletes columns created at the node being solved, which
+    // keeps the branching decisions of the other nodes valid.
+    release_assert(options.column_age_limit >= 0, "Invalid column age limit {}", options.column_age_limit);
+    if (options.column_age_limit > 0)
+    {
+        SCIP_CALL(SCIPsetIntParam(scip, "lp/colagelimit", options.column_age_limit));
+        SCIP_CALL(SCIPsetBoolParam(scip, "pricing/delvars", TRUE));
+        SCIP_CALL(SCIPsetBoolParam(scip, "pricing/delvarsroot", TRUE));
+    }
+
+    // Remove two-agent robust cuts that have aged out. The rows become removable so SCIP also drops them from the LP.
+    release_assert(options.cut_age_limit >= 0, "Invalid cut age limit {}", options.cut_age_limit);
+    if (options.cut_age_limit > 0)
+    {
+        SCIP_CALL(SCIPsetIntParam(scip, ROBUST_CUT_AGE_LIMIT_PARAM, options.cut_age_limit));
+        SCIP_CALL(SCIPsetIntParam(scip, "lp/rowagelimit", options.cut_age_limit));
+    }
+
+    // Only resolve the conflicts in the next timesteps of a window.
+    release_assert(options.window >= 0, "Invalid window {}", options.window);
+    if (options.window > 0)
+    {
+        SCIP_CALL(SCIPsetIntParam(scip, CONFLICT_HORIZON_PARAM, options.window));
+    }
+
+    // Set the LP algorithms. The initial LP is only solved without a basis at the root. The master problem is highly
+    // degenerate so the barrier method can be faster there, and the primal simplex stays feasible after adding columns.
+    {
+        const auto get_lp_algorithm = [](const String& name)
+        {
+            if (name == "auto")
+                return 's';
+            else if (name == "primal")
+                return 'p';
+            else if (name == "dual")
+                return 'd';
+            else if (name == "barrier")
+                return 'b';
+            else if (name == "barrier-crossover")
+                return 'c';
+            err("Invalid LP algorithm {}", name);
+        };
+        SCIP_CALL(SCIPsetCharParam(scip, "lp/initalgorithm", get_lp_algorithm(options.root_lp_algorithm)));
+        SCIP_CALL(SCIPsetCharParam(scip, "lp/resolvealgorithm", get_lp_algorithm(options.resolve_lp_algorithm)));
+    }
+
+    // Solve.
+    SCIP_CALL(SCIPsolve(scip));
+    
+    solved = scip->set->stage == 10;
+
+    // Keep the columns for the problem with more agents.
+    if (sweep)
+    {
+        sweep->columns = save_columns(scip);
+        sweep->nb_agents = SCIPprobdataGetN(SCIPgetProbData(scip));
+    }
+
+    // Keep the paths of the group. The groups are written together once independence detection finishes.
+    if (group)
+    {
+        group->paths = solved ? get_best_solution_paths(scip) : Vector<Vector<Edge>>{};
+        group->cost = SCIPgetPrimalbound(scip);
+        group->lower_bound = SCIPgetDualbound(scip);
+        solved = solved && !group->paths.empty();
+    }
+
+    // Output.
+    if (!group)
+    {
+        // Print.
+        // println("");
+        // SCIP_CALL(SCIPprintStatistics(scip, NULL));
+
+        double solvingtime = SCIPclockGetTime(scip->stat->solvingtime);
+        int solvingnodes = scip->stat->nnodes;
+        double upper_bound = SCIPgetPrimalbound(scip);
+        double lower_bound = SCIPgetDualbound(scip);
+        
+        std::unique_lock<std::mutex> output_lock(output_mutex);
+        std::ifstream infile(options.output_file);
+        bool exist = infile.good();
+        infile.close();
+        if (!exist)
+        {
+            std::ofstream addHeads(options.output_file);
+            addHeads << "runtime,solution cost,lower bound,upper bound," <<
+                    "nodes," << "instance name, #agents" << std::endl;
+            addHeads.close();
+        }
+        std::ofstream stats(options.output_file, std::ios::app);
+        stats <<solvingtime <<"," << (solved?upper_bound:-1) << "," << lower_bound <<"," <<upper_bound <<","<< instance_file <<","<<options.agent_limit  <<std::endl;
+        stats.close();
+        output_lock.unlock();
+
+        // Write pricing and plugin statistics next to the statistics file.
+        if (!options.statistics_file.empty())
+        {
+            SCIP_CALL(write_pricing_statistics(scip, fmt::format("{}.pricing.csv", options.statistics_file)));
+            SCIP_CALL(write_plugin_statistics(scip, fmt::format("{}.plugins.json", options.statistics_file)));
+        }
+
+        // Write best solution to file.
+        if (options.binary_path)
+        {
+            SCIP_CALL(write_path_binary(scip, options.path_file));
+        }
+        else
+        {
+            SCIP_CALL(write_path(scip, options.path_file));
+        }
+    }
+
+    // Free memory.
+    SCIP_CALL(SCIPfree(&scip));
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Append a line of statistics in the format of solve_instance to the output file
+void append_statistics(
+    const SolverOptions& options,    // Program options
+    const String& instance_file,     // Path to instance
+    const SCIP_Real run_time,        // Run time in seconds
+    const bool solved,               // Indicates if the instance is solved
+    const SCIP_Real upper_bound,     // Cost of the solution
+    const SCIP_Real lower_bound      // Lower bound
+)
+{
+    std::lock_guard<std::mutex> output_lock(output_mutex);
+    std::ifstream infile(options.output_file);
+    bool exist = infile.good();
+    infile.close();
+    if (!exist)
+    {
+        std::ofstream addHeads(options.output_file);
+        addHeads << "runtime,solution cost,lower bound,upper bound," <<
+                "nodes," << "instance name, #agents" << std::endl;
+        addHeads.close();
+    }
+    std::ofstream stats(options.output_file, std::ios::app);
+    stats << run_time << "," << (solved ? upper_bound : -1) << "," << lower_bound << ","
+          << upper_bound << "," << instance_file << "," << options.agent_limit << std::endl;
+    stats.close();
+}
+
+// Solve an instance held in memory
+SCIP_RETCODE solve_instance(
+    const SolverOptions& options,          // Solver options
+    const SharedPtr<Instance>& instance,   // Instance
+    const String& name,                    // Name of the instance
+    SharedInstanceData* shared,            // Data shared with other instances, or nullptr
+    const SolutionCallback& callback,      // Function receiving the solution
+    bool& solved                           // Indicates if the instance is solved
+)
+{
+    // Check.
+    release_assert(instance && !instance->agents.empty(), "Cannot solve an instance without agents");
+
+    // Solve every agent as one group so the instance is not read from file and no output is written.
+    AgentGroup group;
+    group.instance = instance;
+    for (Agent a = 0; a < instance->agents.size(); ++a)
+    {
+        group.agents.push_back(a);
+    }
+    SCIP_CALL(solve_instance(options, name, shared, solved, nullptr, &group));
+
+    // Pass on the solution.
+    if (callback)
+    {
+        callback(group.paths, group.cost, group.lower_bound);
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
@@ -0,0 +1,147 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#ifndef MAPF_SOLVER_H
+#define MAPF_SOLVER_H
+
+#include "Includes.h"
+#include "Reader.h"
+#include "Checkpoint.h"
+#include "IndependenceDetection.h"
+#include "Racing.h"
+#include <functional>
+#include <mutex>
+
+// Solver options
+struct SolverOptions
+{
+    Agent agent_limit = std::numeric_limits<Agent>::max();
+    String path_file;
+    bool binary_path = false;
+    String output_file;
+    String statistics_file;
+    SCIP_Real time_limit = 0;
+    SCIP_Longint node_limit = 0;
+    Int seed = 0;
+    SCIP_Real gap_limit = 0;
+    String anytime_schedule;
+    String node_selection = "bfs";
+    Int pricing_threads = 1;
+    Int pricing_columns = 1;
+    SCIP_Real pricing_smoothing = 0;
+    bool adaptive_pricing = false;
+    bool backward_pruning = false;
+    bool penalty_heuristic = false;
+    bool symmetric_pricing = false;
+    bool reduced_cost_fixing = false;
+    Int label_budget = 0;
+    Float focal_weight = 1.0;
+    Int label_block_size = 0;
+    bool huge_pages = false;
+    bool pin_threads = false;
+    bool numa_replicate = false;
+    Int frontier_budget = 64;
+    String pricer_low_level_solver;
+    String heuristic_cache_dir;
+    Int heuristic_memory = 0;
+    Int heuristic_threads = 0;
+    bool map_cache = false;
+    String pricing_record_file;
+    String separation_record_file;
+    Int separation_record_node = 1;
+    Int separation_record_rounds = -1;
+    Int separation_threads = 1;
+    bool adaptive_separation = false;
+    Vector<String> separators;
+    Vector<String> disabled_separators;
+    String separator_profile;
+    Int column_age_limit = 0;
+    Int cut_age_limit = 0;
+    String root_lp_algorithm = "auto";
+    String resolve_lp_algorithm = "auto";
+    Int branching_lookahead = 0;
+    Int branching_reliability = 0;
+    bool wait_branching = false;
+    String warm_start_file;
+    String checkpoint_file;
+    SCIP_Real checkpoint_interval = 0;
+    SCIP_Real memory_interval = -1;
+    String solution_stream_file;
+    String node_log_file;
+    String resume_file;
+    Agent agent_step = 0;
+    Int independence_threads = 0;
+    Int racing_threads = 0;
+    Time window = 0;
+    Time window_step = 0;
+    String replan_file;
+    String subtree_file;
+    SCIP_Real cutoff = 0;
+    bool quiet = false;
+};
+
+// Lock for the statistics file and the log shared by the instances solved at the same time
+extern std::mutex output_mutex;
+
+// Data carried from one problem to the next when agents are added incrementally
+struct AgentSweepData
+{
+    Vector<CheckpointColumn> columns;    // Columns of the previous problem
+    Agent nb_agents = 0;                 // Number of agents read in the previous problem
+};
+
+// Solve one instance
+SCIP_RETCODE solve_instance(
+    const SolverOptions& options,    // Program options
+    const String& instance_file,     // Path to instance
+    SharedInstanceData* shared,      // Data shared with other instances in batch mode
+    bool& solved,                    // Indicates if the instance is solved
+    AgentSweepData* sweep = nullptr, // Columns of the problem with fewer agents
+    AgentGroup* group = nullptr,     // Agents solved alone in independence detection
+    RaceData* race = nullptr         // Incumbents shared with the other racers in racing mode
+);
+
+// Append a line of statistics in the format of solve_instance to the output file
+void append_statistics(
+    const SolverOptions& options,    // Program options
+    const String& instance_file,     // Path to instance
+    const SCIP_Real run_time,        // Run time in seconds
+    const bool solved,               // Indicates if the instance is solved
+    const SCIP_Real upper_bound,     // Cost of the solution
+    const SCIP_Real lower_bound      // Lower bound
+);
+
+// Function receiving the path of every agent, the cost and the lower bound of the best solution. The paths are empty
+// if no solution is found.
+using SolutionCallback = std::function<void(const Vector<Vector<Edge>>& paths,
+                                            const SCIP_Real cost,
+                                            const SCIP_Real lower_bound)>;
+
+// Solve an instance held in memory, e.g., made from arrays by the constructor of Instance, without reading or writing
+// files. The name identifies the instance in the lower bounds shared with other instances and in the cache directory.
+SCIP_RETCODE solve_instance(
+    const SolverOptions& options,          // Solver options
+    const SharedPtr<Instance>& instance,   // Instance
+    const String& name,                    // Name of the instance
+    SharedInstanceData* shared,            // Data shared with other instances, or nullptr
+    const SolutionCallback& callback,      // Function receiving the solution
+    bool& solved                           // Indicates if the instance is solved
+);
+
+#endif
@@ -0,0 +1,140 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#ifndef MAPF_SUBMISSIONQUEUE_H
+#define MAPF_SUBMISSIONQUEUE_H
+
+#include "Includes.h"
+#include <atomic>
+
+// Bounded queue through which worker threads hand their results to the main thread without locking. Any number of
+// threads can push but only one thread can pop. Each slot has a sequence number telling whether it is free for the
+// producer at a position or filled for the consumer at a position, so producers only contend on the position counter.
+template<class T>
+class SubmissionQueue
+{
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    UniquePtr<Slot[]> slots_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> push_pos_;
+    alignas(64) size_t pop_pos_;
+
+  public:
+    // Constructors
+    SubmissionQueue(const size_t capacity) :
+        slots_(),
+        mask_(0),
+        push_pos_(0),
+        pop_pos_(0)
+    {
+        // Round up the capacity to a power of two.
+        size_t size = 1;
+        while (size < capacity)
+        {
+            size *= 2;
+        }
+        mask_ = size - 1;
+
+        // Mark every slot free for the first round of positions.
+        slots_ = std::make_unique<Slot[]>(size);
+        for (size_t idx = 0; idx < size; ++idx)
+        {
+            slots_[idx].sequence.store(idx, std::memory_order_relaxed);
+        }
+    }
+    SubmissionQueue() = delete;
+    SubmissionQueue(const SubmissionQueue&) = delete;
+    SubmissionQueue(SubmissionQueue&&) = delete;
+    SubmissionQueue& operator=(const SubmissionQueue&) = delete;
+    SubmissionQueue& operator=(SubmissionQueue&&) = delete;
+    ~SubmissionQueue() = default;
+
+    // Getters
+    inline size_t capacity() const { return mask_ + 1; }
+
+    // Push a value from any thread. Returns false if the queue is full, in which case the value is not moved from.
+    bool push(T&& value)
+    {
+        // Claim the slot at the next position.
+        auto pos = push_pos_.load(std::memory_order_relaxed);
+        Slot* slot;
+        while (true)
+        {
+            slot = &slots_[pos & mask_];
+            const auto sequence = slot->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0)
+            {
+                if (push_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = push_pos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        // Fill the slot and publish it to the consumer.
+        slot->value = std::move(value);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Pop a value from the consumer thread. Returns false if the queue is empty.
+    bool pop(T& value)
+    {
+        // Check if the slot at the next position is filled.
+        auto& slot = slots_[pop_pos_ & mask_];
+        if (slot.sequence.load(std::memory_order_acquire) != pop_pos_ + 1)
+        {
+            return false;
+        }
+
+        // Take the value and free the slot for the next round of positions.
+        value = std::move(slot.value);
+        slot.value = T();
+        slot.sequence.store(pop_pos_ + capacity(), std::memory_order_release);
+        ++pop_pos_;
+        return true;
+    }
+
+    // Pop every value from the consumer thread
+    template<class F>
+    void drain(F&& f)
+    {
+        T value;
+        while (pop(value))
+        {
+            f(std::move(value));
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,242 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#include "Subtree.h"
+#include "ProblemData.h"
+#include "Constraint_VertexBranching.h"
+#include "Constraint_LengthBranching.h"
+#include <fstream>
+#include <sstream>
+
+#define EVENTHDLR_NAME "mapf_subtree"
+#define EVENTHDLR_DESC "Restriction of the search to a subtree"
+
+// Branching decision of a subtree
+struct SubtreeDecision
+{
+    bool is_vertex;    // Vertex branching or length branching
+    bool dir;          // Use or geq if true, forbid or leq if false
+    Agent a;           // Agent
+    NodeTime nt;       // Node-time
+};
+
+struct SubtreeData
+{
+    Vector<SubtreeDecision> decisions;    // Branching decisions of the subtree
+};
+
+// Read the branching decisions of a subtree from file
+SCIP_RETCODE read_subtree(
+    SCIP* scip,                                // SCIP
+    const std::filesystem::path& filename      // Input file
+)
+{
+    // Check.
+    debug_assert(scip);
+    debug_assert(SCIPgetStage(scip) == SCIP_STAGE_PROBLEM);
+
+    // Get problem data.
+    auto probdata = SCIPgetProbData(scip);
+    const auto N = SCIPprobdataGetN(probdata);
+    const auto& map = SCIPprobdataGetMap(probdata);
+
+    // Get event handler data.
+    auto eventhdlr = SCIPfindEventhdlr(scip, EVENTHDLR_NAME);
+    debug_assert(eventhdlr);
+    auto eventhdlrdata = reinterpret_cast<SubtreeData*>(SCIPeventhdlrGetData(eventhdlr));
+    debug_assert(eventhdlrdata);
+
+    // Read decisions.
+    std::ifstream file(filename);
+    release_assert(file.good(), "Cannot open subtree file {}", filename.string());
+    String line;
+    while (std::getline(file, line))
+    {
+        // Skip empty lines.
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (line.empty())
+        {
+            continue;
+        }
+
+        // Parse the decision.
+        std::istringstream stream(line);
+        String type, dir;
+        Agent a;
+        Position x, y;
+        Time t;
+        stream >> type >> dir >> a >> x >> y >> t;
+        release_assert(stream && (type == "vertex" || type == "length"), "Invalid subtree decision {}", line);
+        const bool is_vertex = type == "vertex";
+        release_assert(is_vertex ? dir == "use" || dir == "forbid" : dir == "geq" || dir == "leq",
+                       "Invalid subtree decision {}", line);
+        release_assert(0 <= a && a < N, "Invalid agent in subtree decision {}", line);
+
+        // Coordinates are written without the padding around the map.
+        ++x;
+        ++y;
+        release_assert(0 < x && x < map.width() && 0 < y && y < map.height() && map[map.get_id(x, y)] && t >= 0,
+                       "Invalid node-time in subtree decision {}", line);
+
+        // Store.
+        eventhdlrdata->decisions.push_back({is_vertex, dir == "use" || dir == "geq", a, NodeTime(map.get_id(x, y), t)});
+    }
+    debugln("Read {} branching decisions of a subtree from {}", eventhdlrdata->decisions.size(), filename.string());
+
+    // Done.
+    return SCIP_OKAY;
+}
+
+// Initialize event handler at the start of the solve
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_EVENTINITSOL(eventInitsolSubtree)
+{
+    // Catch the root node if the search is restricted.
+    auto eventhdlrdata = reinterpret_cast<SubtreeData*>(SCIPeventhdlrGetData(eventhdlr));
+    debug_assert(eventhdlrdata);
+    if (!eventhdlrdata->decisions.empty())
+    {
+        SCIP_CALL(SCIPcatchEvent(scip, SCIP_EVENTTYPE_NODEFOCUSED, eventhdlr, nullptr, nullptr));
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Deinitialize event handler at the end of the solve
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_EVENTEXITSOL(eventExitsolSubtree)
+{
+    // Stop catching nodes if the root node was never solved.
+    auto eventhdlrdata = reinterpret_cast<SubtreeData*>(SCIPeventhdlrGetData(eventhdlr));
+    debug_assert(eventhdlrdata);
+    if (!eventhdlrdata->decisions.empty())
+    {
+        SCIP_CALL(SCIPdropEvent(scip, SCIP_EVENTTYPE_NODEFOCUSED, eventhdlr, nullptr, -1));
+        eventhdlrdata->decisions.clear();
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Add the branching decisions to the root node
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_EVENTEXEC(eventExecSubtree)
+{
+    // Get event handler data.
+    auto eventhdlrdata = reinterpret_cast<SubtreeData*>(SCIPeventhdlrGetData(eventhdlr));
+    debug_assert(eventhdlrdata);
+
+    // Add the decisions as branching constraints of the root node. They are local to the root so the constraint
+    // handlers propagate and repropagate them exactly like decisions of the branching rule.
+    auto node = SCIPgetCurrentNode(scip);
+    debug_assert(SCIPnodeGetDepth(node) == 0);
+    for (const auto& [is_vertex, dir, a, nt] : eventhdlrdata->decisions)
+    {
+        SCIP_CONS* cons;
+        if (is_vertex)
+        {
+            SCIP_CALL(SCIPcreateConsVertexBranching(scip,
+                                                    &cons,
+                                                    "",
+                                                    dir ? VertexBranchDirection::Use : VertexBranchDirection::Forbid,
+                                                    a,
+                                                    nt,
+                                                    node,
+                                                    TRUE));
+        }
+        else
+        {
+            SCIP_CALL(SCIPcreateConsLengthBranching(scip,
+                                                    &cons,
+                                                    "",
+                                                    dir ? LengthBranchDirection::GEq : LengthBranchDirection::LEq,
+                                                    a,
+                                                    nt,
+                                                    node,
+                                                    TRUE));
+        }
+        SCIP_CALL(SCIPaddConsNode(scip, node, cons, nullptr));
+        SCIP_CALL(SCIPreleaseCons(scip, &cons));
+    }
+    eventhdlrdata->decisions.clear();
+
+    // Stop catching nodes.
+    SCIP_CALL(SCIPdropEvent(scip, SCIP_EVENTTYPE_NODEFOCUSED, eventhdlr, nullptr, -1));
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Free event handler
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_EVENTFREE(eventFreeSubtree)
+{
+    auto eventhdlrdata = reinterpret_cast<SubtreeData*>(SCIPeventhdlrGetData(eventhdlr));
+    debug_assert(eventhdlrdata);
+    eventhdlrdata->~SubtreeData();
+    SCIPfreeBlockMemory(scip, &eventhdlrdata);
+    SCIPeventhdlrSetData(eventhdlr, nullptr);
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Include the subtree event handler
+SCIP_RETCODE SCIPincludeEventhdlrSubtree(
+    SCIP* scip    // SCIP
+)
+{
+    // Create event handler data.
+    SubtreeData* eventhdlrdata = nullptr;
+    SCIP_CALL(SCIPallocBlockMemory(scip, &eventhdlrdata));
+    debug_assert(eventhdlrdata);
+    new (eventhdlrdata) SubtreeData;
+
+    // Include event handler.
+    SCIP_EVENTHDLR* eventhdlr = nullptr;
+    SCIP_CALL(SCIPincludeEventhdlrBasic(scip,
+                                        &eventhdlr,
+                                        EVENTHDLR_NAME,
+                                        EVENTHDLR_DESC,
+                                        eventExecSubtree,
+                                        reinterpret_cast<SCIP_EVENTHDLRDATA*>(eventhdlrdata)));
+    debug_assert(eventhdlr);
+
+    // Set callbacks.
+    SCIP_CALL(SCIPsetEventhdlrInitsol(scip, eventhdlr, eventInitsolSubtree));
+    SCIP_CALL(SCIPsetEventhdlrExitsol(scip, eventhdlr, eventExitsolSubtree));
+    SCIP_CALL(SCIPsetEventhdlrFree(scip, eventhdlr, eventFreeSubtree));
+
+    // Done.
+    return SCIP_OKAY;
+}
@@ -0,0 +1,39 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#ifndef MAPF_SUBTREE_H
+#define MAPF_SUBTREE_H
+
+#include "Includes.h"
+#include <filesystem>
+
+// Include the event handler that restricts the search to a subtree given by a list of branching decisions
+SCIP_RETCODE SCIPincludeEventhdlrSubtree(
+    SCIP* scip    // SCIP
+);
+
+// Read the branching decisions of a subtree from file. Each line is one decision in the format
+// <vertex|length> <use|forbid|geq|leq> <agent> <x> <y> <time>, with coordinates as in the scenario file. The
+// decisions are added to the root node when the solve starts.
+SCIP_RETCODE read_subtree(
+    SCIP* scip,                                // SCIP
+    const std::filesystem::path& filename      // Input file
+);
+
+#endif
@@ -0,0 +1,117 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#include "ThreadPlacement.h"
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#ifdef __linux__
+// Parse a CPU list such as 0-3,8-11
+static Vector<Int> parse_cpu_list(const String& list)
+{
+    Vector<Int> cpus;
+    size_t pos = 0;
+    while (pos < list.size())
+    {
+        auto end = list.find(',', pos);
+        if (end == String::npos)
+        {
+            end = list.size();
+        }
+        const auto range = list.substr(pos, end - pos);
+        if (!range.empty())
+        {
+            const auto dash = range.find('-');
+            const auto first = std::stoi(range.substr(0, dash));
+            const auto last = dash == String::npos ? first : std::stoi(range.substr(dash + 1));
+            for (Int cpu = first; cpu <= last; ++cpu)
+            {
+                cpus.push_back(cpu);
+            }
+        }
+        pos = end + 1;
+    }
+    return cpus;
+}
+#endif
+
+ThreadPlacement::ThreadPlacement() :
+    cpus_(),
+    cpu_node_(),
+    nb_nodes_(0)
+{
+#ifdef __linux__
+    // Read the CPUs of each node available to the process.
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    const bool has_allowed = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+    const std::filesystem::path nodes_dir("/sys/devices/system/node");
+    for (Int node = 0;; ++node)
+    {
+        std::ifstream file(nodes_dir / fmt::format("node{}", node) / "cpulist");
+        if (!file.good())
+        {
+            break;
+        }
+        String list;
+        std::getline(file, list);
+        bool used = false;
+        for (const auto cpu : parse_cpu_list(list))
+            if (!has_allowed || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed)))
+            {
+                cpus_.push_back(cpu);
+                cpu_node_.push_back(nb_nodes_);
+                used = true;
+            }
+        nb_nodes_ += used;
+    }
+#endif
+
+    // Treat the machine as one node if the nodes are unknown.
+    if (cpus_.empty())
+    {
+        nb_nodes_ = 1;
+        const auto nb_cpus = std::max<Int>(std::thread::hardware_concurrency(), 1);
+        for (Int cpu = 0; cpu < nb_cpus; ++cpu)
+        {
+            cpus_.push_back(cpu);
+            cpu_node_.push_back(0);
+        }
+    }
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+bool ThreadPlacement::pin(const Int thread_idx) const
+{
+#ifdef __linux__
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpus_[thread_idx % static_cast<Int>(cpus_.size())], &cpu_set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+#else
+    return false;
+#endif
+}
+#pragma GCC diagnostic pop
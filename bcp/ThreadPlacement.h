@@ -0,0 +1,55 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#ifndef MAPF_THREADPLACEMENT_H
+#define MAPF_THREADPLACEMENT_H
+
+#include "Includes.h"
+
+// Placement of worker threads on the CPUs of the NUMA nodes of the machine. Thread i runs on the i-th CPU in the order
+// of the nodes, so the first threads share a node before the next node is used. Memory is placed on the node of the
+// thread that first touches it, so a pinned thread that allocates its own data keeps it in local memory. Without
+// NUMA information, the machine is one node with every CPU.
+class ThreadPlacement
+{
+    Vector<Int> cpus_;          // CPUs in the order of the nodes
+    Vector<Int> cpu_node_;      // Node of each CPU in the order
+    Int nb_nodes_;              // Number of nodes
+
+  public:
+    // Constructors
+    ThreadPlacement();
+    ThreadPlacement(const ThreadPlacement&) = default;
+    ThreadPlacement(ThreadPlacement&&) = default;
+    ThreadPlacement& operator=(const ThreadPlacement&) = default;
+    ThreadPlacement& operator=(ThreadPlacement&&) = default;
+    ~ThreadPlacement() = default;
+
+    // Getters
+    inline Int nb_nodes() const { return nb_nodes_; }
+    inline Int thread_node(const Int thread_idx) const
+    {
+        return cpus_.empty() ? 0 : cpu_node_[thread_idx % static_cast<Int>(cpus_.size())];
+    }
+
+    // Pin the calling thread to the CPU of a thread index. Returns false if the thread cannot be pinned.
+    bool pin(const Int thread_idx) const;
+};
+
+#endif
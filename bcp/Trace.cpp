@@ -0,0 +1,314 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+
+#include "Trace.h"
+#include "Clock.h"
+#include <mutex>
+
+#define EVENTHDLR_NAME "mapf_trace"
+#define EVENTHDLR_DESC "Recording of the LP solves in the trace"
+
+struct TraceEvent
+{
+    const char* name;        // Name of the event
+    const char* arg_name;    // Name of the integer argument (nullptr for none)
+    int64_t arg;             // Integer argument
+    int64_t start;           // Nanoseconds from the start of the trace to the start of the event
+    int64_t duration;        // Nanoseconds from the start to the end of the event
+};
+
+struct TraceBuffer
+{
+    Vector<TraceEvent> events;    // Ring buffer of events
+    uint64_t nb_recorded;         // Number of events recorded, including the overwritten ones
+    bool in_use;                  // Indicates if a thread is recording into the buffer
+};
+
+struct TraceEventhdlrData
+{
+    SCIP_Real lp_time;            // Total time of the LP solves at the last LP solve
+    bool catching;                // Indicates if the LP solves are caught
+};
+
+std::atomic<bool> trace_is_enabled{false};
+
+// Buffers of the threads indexed by lane. A buffer is released when its thread exits and is reused by the next new
+// thread, so the short-lived worker threads of the pricer share a few buffers and appear as a few lanes in the trace.
+static std::mutex buffers_mutex;
+static Vector<UniquePtr<TraceBuffer>> buffers;
+static size_t trace_buffer_size = 0;
+static std::chrono::steady_clock::time_point trace_origin;
+
+// Buffer of the current thread
+struct ThreadTraceBuffer
+{
+    TraceBuffer* buffer = nullptr;
+
+    ~ThreadTraceBuffer()
+    {
+        if (buffer)
+        {
+            std::lock_guard<std::mutex> lock(buffers_mutex);
+            buffer->in_use = false;
+        }
+    }
+};
+static thread_local ThreadTraceBuffer thread_trace_buffer;
+
+// Get an unused buffer or create one
+static TraceBuffer* acquire_trace_buffer()
+{
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    for (auto& buffer : buffers)
+        if (!buffer->in_use)
+        {
+            buffer->in_use = true;
+            return buffer.get();
+        }
+    auto& buffer = buffers.emplace_back(std::make_unique<TraceBuffer>());
+    buffer->events.resize(trace_buffer_size);
+    buffer->nb_recorded = 0;
+    buffer->in_use = true;
+    return buffer.get();
+}
+
+// Start recording events with room for the given number of events per thread
+void trace_start(
+    const size_t buffer_size    // Number of events kept by each thread
+)
+{
+    release_assert(buffer_size > 0, "Cannot trace with a buffer of {} events", buffer_size);
+    release_assert(!trace_enabled() && buffers.empty(), "Trace is already started");
+    trace_buffer_size = buffer_size;
+    trace_origin = std::chrono::steady_clock::now();
+    trace_is_enabled.store(true, std::memory_order_release);
+}
+
+// Record an event that completes now
+void trace_record(
+    const char* name,                                       // Name of the event
+    const std::chrono::steady_clock::time_point start,      // Start time
+    const char* arg_name,                                   // Name of an integer argument (nullptr for none)
+    const int64_t arg                                       // Integer argument
+)
+{
+    // Get the buffer of the thread.
+    const auto end = std::chrono::steady_clock::now();
+    auto& buffer = thread_trace_buffer.buffer;
+    if (!buffer)
+    {
+        buffer = acquire_trace_buffer();
+    }
+
+    // Record.
+    auto& event = buffer->events[buffer->nb_recorded % buffer->events.size()];
+    event.name = name;
+    event.arg_name = arg_name;
+    event.arg = arg;
+    event.start = std::chrono::duration_cast<std::chrono::nanoseconds>(start - trace_origin).count();
+    event.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    ++buffer->nb_recorded;
+}
+
+// Stop recording and write the events of every thread
+void trace_write(
+    const String& filename    // Output file
+)
+{
+    // Stop.
+    trace_is_enabled.store(false, std::memory_order_release);
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+
+    // Open file.
+    auto f = fopen(filename.c_str(), "w");
+    release_assert(f, "Failed to create file {} to write the trace", filename);
+
+    // Write the name of every lane and then its events from the oldest. The times are in microseconds.
+    fmt::print(f, "{{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+    bool first = true;
+    for (size_t lane = 0; lane < buffers.size(); ++lane)
+    {
+        const auto& buffer = *buffers[lane];
+        fmt::print(f,
+                   "{}\n{{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": {}, "
+                   "\"args\": {{\"name\": \"{}\"}}}}",
+                   first ? "" : ",",
+                   lane,
+                   fmt::format("thread {}", lane));
+        first = false;
+
+        const auto nb_events = std::min<uint64_t>(buffer.nb_recorded, buffer.events.size());
+        for (uint64_t idx = buffer.nb_recorded - nb_events; idx < buffer.nb_recorded; ++idx)
+        {
+            const auto& event = buffer.events[idx % buffer.events.size()];
+            fmt::print(f,
+                       ",\n{{\"name\": \"{}\", \"ph\": \"X\", \"pid\": 1, \"tid\": {}, \"ts\": {:.3f}, "
+                       "\"dur\": {:.3f}",
+                       event.name,
+                       lane,
+                       event.start / 1e3,
+                       event.duration / 1e3);
+            if (event.arg_name)
+            {
+                fmt::print(f, ", \"args\": {{\"{}\": {}}}", event.arg_name, event.arg);
+            }
+            fmt::print(f, "}}");
+        }
+        if (buffer.nb_recorded > buffer.events.size())
+        {
+            println("Trace dropped the {} oldest events of lane {}", buffer.nb_recorded - nb_events, lane);
+        }
+    }
+    fmt::print(f, "\n]}}\n");
+
+    // Close file.
+    fclose(f);
+}
+
+// Get the total time of the LP solves
+static SCIP_Real get_lp_time(
+    SCIP* scip    // SCIP
+)
+{
+    return SCIPclockGetTime(scip->stat->primallptime) +
+           SCIPclockGetTime(scip->stat->duallptime) +
+           SCIPclockGetTime(scip->stat->lexduallptime) +
+           SCIPclockGetTime(scip->stat->barrierlptime);
+}
+
+// Initialize event handler at the start of the solve
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_EVENTINITSOL(eventInitsolTrace)
+{
+    // Get event handler data.
+    auto eventhdlrdata = reinterpret_cast<TraceEventhdlrData*>(SCIPeventhdlrGetData(eventhdlr));
+    debug_assert(eventhdlrdata);
+
+    // Catch the LP solves if tracing.
+    eventhdlrdata->lp_time = get_lp_time(scip);
+    eventhdlrdata->catching = trace_enabled();
+    if (eventhdlrdata->catching)
+    {
+        SCIP_CALL(SCIPcatchEvent(scip, SCIP_EVENTTYPE_LPSOLVED, eventhdlr, nullptr, nullptr));
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Deinitialize event handler at the end of the solve
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_EVENTEXITSOL(eventExitsolTrace)
+{
+    // Get event handler data.
+    auto eventhdlrdata = reinterpret_cast<TraceEventhdlrData*>(SCIPeventhdlrGetData(eventhdlr));
+    debug_assert(eventhdlrdata);
+
+    // Drop the LP solves.
+    if (eventhdlrdata->catching)
+    {
+        SCIP_CALL(SCIPdropEvent(scip, SCIP_EVENTTYPE_LPSOLVED, eventhdlr, nullptr, -1));
+        eventhdlrdata->catching = false;
+    }
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Record the LP solve that just finished. The LP is solved inside SCIP, so its start is found from the LP clocks.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_EVENTEXEC(eventExecTrace)
+{
+    // Get event handler data.
+    auto eventhdlrdata = reinterpret_cast<TraceEventhdlrData*>(SCIPeventhdlrGetData(eventhdlr));
+    debug_assert(eventhdlrdata);
+
+    // Record.
+    const auto lp_time = get_lp_time(scip);
+    if (trace_enabled())
+    {
+        const auto duration = std::chrono::duration<SCIP_Real>(lp_time - eventhdlrdata->lp_time);
+        trace_record("lp",
+                     std::chrono::steady_clock::now() -
+                     std::chrono::duration_cast<std::chrono::steady_clock::duration>(duration),
+                     "node",
+                     SCIPnodeGetNumber(SCIPgetCurrentNode(scip)));
+    }
+    eventhdlrdata->lp_time = lp_time;
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Free event handler
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static
+SCIP_DECL_EVENTFREE(eventFreeTrace)
+{
+    auto eventhdlrdata = reinterpret_cast<TraceEventhdlrData*>(SCIPeventhdlrGetData(eventhdlr));
+    debug_assert(eventhdlrdata);
+    SCIPfreeBlockMemory(scip, &eventhdlrdata);
+    SCIPeventhdlrSetData(eventhdlr, nullptr);
+
+    // Done.
+    return SCIP_OKAY;
+}
+#pragma GCC diagnostic pop
+
+// Include the event handler that records the LP solves
+SCIP_RETCODE SCIPincludeEventhdlrTrace(
+    SCIP* scip    // SCIP
+)
+{
+    // Create event handler data.
+    TraceEventhdlrData* eventhdlrdata = nullptr;
+    SCIP_CALL(SCIPallocBlockMemory(scip, &eventhdlrdata));
+    debug_assert(eventhdlrdata);
+    eventhdlrdata->lp_time = 0.0;
+    eventhdlrdata->catching = false;
+
+    // Include event handler.
+    SCIP_EVENTHDLR* eventhdlr = nullptr;
+    SCIP_CALL(SCIPincludeEventhdlrBasic(scip,
+                                        &eventhdlr,
+                                        EVENTHDLR_NAME,
+                                        EVENTHDLR_DESC,
+                                        eventExecTrace,
+                                        reinterpret_cast<SCIP_EVENTHDLRDATA*>(eventhdlrdata)));
+    debug_assert(eventhdlr);
+
+    // Set callbacks.
+    SCIP_CALL(SCIPsetEventhdlrInitsol(scip, eventhdlr, eventInitsolTrace));
+    SCIP_CALL(SCIPsetEventhdlrExitsol(scip, eventhdlr, eventExitsolTrace));
+    SCIP_CALL(SCIPsetEventhdlrFree(scip, eventhdlr, eventFreeTrace));
+
+    // Done.
+    return SCIP_OKAY;
+}
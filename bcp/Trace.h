@@ -0,0 +1,96 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+
+#ifndef MAPF_TRACE_H
+#define MAPF_TRACE_H
+
+#include "Includes.h"
+#include <atomic>
+#include <chrono>
+
+// Timeline of the phases of the solver written in the Chrome trace format, which can be opened in Perfetto or
+// chrome://tracing. Events are only recorded after trace_start() and each thread records into its own ring buffer
+// without locking, so the oldest events of a thread are overwritten when its buffer is full.
+
+// Indicates if events are recorded
+extern std::atomic<bool> trace_is_enabled;
+
+// Check if events are recorded
+inline bool trace_enabled()
+{
+    return trace_is_enabled.load(std::memory_order_relaxed);
+}
+
+// Start recording events with room for the given number of events per thread
+void trace_start(
+    const size_t buffer_size    // Number of events kept by each thread
+);
+
+// Stop recording and write the events of every thread. Threads must not record while the events are written.
+void trace_write(
+    const String& filename    // Output file
+);
+
+// Record an event that completes now
+void trace_record(
+    const char* name,                                       // Name of the event
+    const std::chrono::steady_clock::time_point start,      // Start time
+    const char* arg_name = nullptr,                         // Name of an integer argument (nullptr for none)
+    const int64_t arg = 0                                   // Integer argument
+);
+
+// Record an event around a scope. The names must be string literals or outlive the trace.
+class TraceScope
+{
+    const char* name_;
+    const char* arg_name_;
+    int64_t arg_;
+    std::chrono::steady_clock::time_point start_;
+
+  public:
+    // Constructors and destructor
+    TraceScope(const char* name, const char* arg_name = nullptr, const int64_t arg = 0) :
+        name_(trace_enabled() ? name : nullptr),
+        arg_name_(arg_name),
+        arg_(arg),
+        start_()
+    {
+        if (name_)
+        {
+            start_ = std::chrono::steady_clock::now();
+        }
+    }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+    ~TraceScope()
+    {
+        if (name_)
+        {
+            trace_record(name_, start_, arg_name_, arg_);
+        }
+    }
+};
+
+// Include the event handler that records the LP solves
+SCIP_RETCODE SCIPincludeEventhdlrTrace(
+    SCIP* scip    // SCIP
+);
+
+#endif
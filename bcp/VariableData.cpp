@@ -20,7 +20,8 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "VariableData.h"
 #include "ProblemData.h"
 
-// Struct has undefined size - cannot use sizeof(SCIP_VarData)
+// Struct has undefined size - cannot use sizeof(SCIP_VarData). It is stored in the path pool of the problem data so
+// the columns are contiguous in memory.
 struct SCIP_VarData
 {
     Agent a;             // Agent of the path
@@ -40,7 +41,8 @@ SCIP_RETCODE SCIPvardataCreate(
     // Allocate memory.
     debug_assert(vardata);
     const auto size = sizeof(**vardata) + sizeof(*path) * path_length;
-    SCIP_CALL(SCIPallocBlockMemorySize(scip, vardata, size));
+    auto& path_pool = SCIPprobdataGetPathPool(SCIPgetProbData(scip));
+    *vardata = reinterpret_cast<SCIP_VARDATA*>(path_pool.allocate(size));
     debug_assert(*vardata);
 
     // Copy data about the agent.
@@ -88,24 +90,17 @@ SCIP_RETCODE SCIPvardataCreate(
     return SCIP_OKAY;
 }
 
-// Free variable data of transformed variable
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wunused-parameter"
-static
-SCIP_DECL_VARDELTRANS(vardataDelTrans)
+// Free variable data of a deleted column for reuse by later columns
+void SCIPvardataFree(
+    SCIP* scip,               // SCIP
+    SCIP_VARDATA* vardata     // Variable data
+)
 {
-    // Free memory.
     debug_assert(vardata);
-    if (*vardata)
-    {
-        const auto size = sizeof(**vardata) + sizeof(*(*vardata)->path) * (*vardata)->path_length;
-        SCIPfreeBlockMemorySize(scip, vardata, size);
-    }
-
-    // Done.
-    return SCIP_OKAY;
+    const auto size = sizeof(*vardata) + sizeof(*vardata->path) * vardata->path_length;
+    auto& path_pool = SCIPprobdataGetPathPool(SCIPgetProbData(scip));
+    path_pool.deallocate(vardata, size);
 }
-#pragma GCC diagnostic pop
 
 // Create variable
 SCIP_RETCODE SCIPcreateVar(
@@ -132,7 +127,7 @@ SCIP_RETCODE SCIPcreateVar(
                             TRUE,
                             nullptr,
                             nullptr,
-                            vardataDelTrans,
+                            nullptr,
                             nullptr,
                             vardata));
     debug_assert(*var);
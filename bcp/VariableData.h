@@ -31,6 +31,12 @@ SCIP_RETCODE SCIPvardataCreate(
     SCIP_VARDATA** vardata     // Output variable data
 );
 
+// Free variable data of a deleted column for reuse by later columns
+void SCIPvardataFree(
+    SCIP* scip,               // SCIP
+    SCIP_VARDATA* vardata     // Variable data
+);
+
 // Create variable
 SCIP_RETCODE SCIPcreateVar(
     SCIP* scip,                // SCIP
@@ -0,0 +1,163 @@
+#!/usr/bin/env python3
+#
+# This file is part of BCP-MAPF.
+#
+# BCP-MAPF is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# BCP-MAPF is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+# Generate synthetic maps and scenarios at a grid of sizes and agent counts to measure how the solver scales. Every map
+# is written in the Moving AI format next to its scenarios, and a suite file in the format of bench/suite.txt lists
+# every scenario with each agent count, so the grid is solved by run_benchmarks.py and plotted by plot_scaling.py.
+
+import argparse
+import collections
+import os
+import random
+import sys
+
+FAMILIES = ("open", "random", "warehouse")
+DEFAULT_SIZES = (64, 128, 256, 512, 1024, 2048)
+DEFAULT_AGENTS = (10, 50, 100, 500, 1000, 5000)
+
+# Obstacle density of the random maps
+RANDOM_DENSITY = 0.2
+
+# Layout of the warehouse maps. Shelves are blocks of cells separated by aisles, surrounded by a margin of free cells.
+SHELF_LENGTH = 10
+SHELF_DEPTH = 2
+AISLE_WIDTH = 1
+CROSS_AISLE_WIDTH = 3
+MARGIN = 4
+
+
+def make_open(size, rng):
+    """Make a map without obstacles."""
+    return [[True] * size for _ in range(size)]
+
+
+def make_random(size, rng):
+    """Make a map with obstacles placed uniformly at random."""
+    return [[rng.random() >= RANDOM_DENSITY for _ in range(size)] for _ in range(size)]
+
+
+def make_warehouse(size, rng):
+    """Make a map with rows of shelves separated by aisles, like the instances in instances/warehouse."""
+    grid = [[True] * size for _ in range(size)]
+    y = MARGIN
+    while y + SHELF_DEPTH <= size - MARGIN:
+        x = MARGIN
+        while x + SHELF_LENGTH <= size - MARGIN:
+            for dy in range(SHELF_DEPTH):
+                for dx in range(SHELF_LENGTH):
+                    grid[y + dy][x + dx] = False
+            x += SHELF_LENGTH + CROSS_AISLE_WIDTH
+        y += SHELF_DEPTH + AISLE_WIDTH
+    return grid
+
+
+def largest_component(grid):
+    """Find the passable cells in the largest 4-connected component so that every agent can reach its goal."""
+    size = len(grid)
+    component = [[-1] * size for _ in range(size)]
+    best_id, best_cells = -1, []
+    next_id = 0
+    for y0 in range(size):
+        for x0 in range(size):
+            if not grid[y0][x0] or component[y0][x0] >= 0:
+                continue
+            cells = [(x0, y0)]
+            component[y0][x0] = next_id
+            queue = collections.deque(cells)
+            while queue:
+                x, y = queue.popleft()
+                for nx, ny in ((x + 1, y), (x - 1, y), (x, y + 1), (x, y - 1)):
+                    if 0 <= nx < size and 0 <= ny < size and grid[ny][nx] and component[ny][nx] < 0:
+                        component[ny][nx] = next_id
+                        cells.append((nx, ny))
+                        queue.append((nx, ny))
+            if len(cells) > len(best_cells):
+                best_id, best_cells = next_id, cells
+            next_id += 1
+    return best_cells
+
+
+def write_map(path, grid):
+    """Write a map in the Moving AI format read by read_map."""
+    size = len(grid)
+    with open(path, "w") as f:
+        f.write(f"type octile\nheight {size}\nwidth {size}\nmap\n")
+        for row in grid:
+            f.write("".join("." if passable else "@" for passable in row))
+            f.write("\n")
+
+
+def write_scenario(path, map_name, size, starts, goals):
+    """Write a scenario in the Moving AI format read by Instance. The last column is the Manhattan distance, which the
+    solver does not read."""
+    with open(path, "w") as f:
+        f.write("version 1\n")
+        for (sx, sy), (gx, gy) in zip(starts, goals):
+            f.write(f"0\t{map_name}\t{size}\t{size}\t{sx}\t{sy}\t{gx}\t{gy}\t{abs(sx - gx) + abs(sy - gy)}\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate maps and scenarios for measuring scaling")
+    parser.add_argument("--output", required=True, help="Directory to write the maps, scenarios and suite to")
+    parser.add_argument("--families", nargs="+", choices=FAMILIES, default=list(FAMILIES), help="Kinds of maps")
+    parser.add_argument("--sizes", nargs="+", type=int, default=list(DEFAULT_SIZES), help="Widths of the square maps")
+    parser.add_argument("--agents", nargs="+", type=int, default=list(DEFAULT_AGENTS), help="Numbers of agents")
+    parser.add_argument("--scenarios", type=int, default=1, help="Number of scenarios of every map")
+    parser.add_argument("--seed", type=int, default=1, help="Seed of the random number generator")
+    parser.add_argument("--time-limit", type=float, default=600, help="Time limit in seconds of every run")
+    parser.add_argument("--max-density", type=float, default=0.25,
+                        help="Skip agent counts above this fraction of the reachable cells of a map")
+    args = parser.parse_args()
+
+    # Generate every map and its scenarios. A scenario has the largest number of agents for the map, and the suite
+    # solves its first agents for every smaller count.
+    makers = {"open": make_open, "random": make_random, "warehouse": make_warehouse}
+    os.makedirs(args.output, exist_ok=True)
+    suite = []
+    for family in args.families:
+        for size in sorted(args.sizes):
+            rng = random.Random(f"{args.seed}-{family}-{size}")
+            grid = makers[family](size, rng)
+            cells = largest_component(grid)
+            agent_counts = [n for n in sorted(args.agents) if n <= args.max_density * len(cells)]
+            if not agent_counts:
+                print(f"Skipping {family} map of size {size} with {len(cells)} reachable cells", flush=True)
+                continue
+            map_name = f"{family}-{size}-{size}.map"
+            write_map(os.path.join(args.output, map_name), grid)
+            for scenario in range(1, args.scenarios + 1):
+                nb_agents = agent_counts[-1]
+                starts = rng.sample(cells, nb_agents)
+                goals = rng.sample(cells, nb_agents)
+                scenario_name = f"{family}-{size}-{size}-{scenario}.scen"
+                write_scenario(os.path.join(args.output, scenario_name), map_name, size, starts, goals)
+                suite.extend((scenario_name, n) for n in agent_counts)
+            print(f"Generated {family} map of size {size} with {len(cells)} reachable cells", flush=True)
+
+    # Write the suite.
+    suite_path = os.path.join(args.output, "suite.txt")
+    with open(suite_path, "w") as f:
+        f.write("# Scaling suite written by generate_scaling.py. Each line has a scenario relative to this directory, "
+                "the number of\n# agents and the time limit in seconds.\n")
+        for scenario_name, nb_agents in suite:
+            f.write(f"{scenario_name} {nb_agents} {args.time_limit:g}\n")
+    print(f"Wrote {len(suite)} instances to {suite_path}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+#
+# This file is part of BCP-MAPF.
+#
+# BCP-MAPF is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# BCP-MAPF is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+# Plot the running time and the peak memory against the number of agents for every map of a scaling suite, reading the
+# results written by run_benchmarks.py for a suite written by generate_scaling.py. The curves are printed as a table if
+# matplotlib is not installed.
+
+import argparse
+import collections
+import json
+import os
+import sys
+
+METRICS = ("wall time", "peak memory (MB)")
+
+
+def read_curves(results_path):
+    """Group the median of every metric by family and map size, ordered by the number of agents."""
+    with open(results_path) as f:
+        report = json.load(f)
+    curves = {metric: collections.defaultdict(list) for metric in METRICS}
+    for instance in report["instances"]:
+        family, size = os.path.basename(instance["scenario"]).split("-")[:2]
+        for metric in METRICS:
+            value = instance["summary"].get(metric)
+            if value is not None:
+                curves[metric][(family, int(size))].append((instance["agents"], value["median"],
+                                                            instance["summary"]["solved"]))
+    for metric in METRICS:
+        for points in curves[metric].values():
+            points.sort()
+    return curves
+
+
+def print_curves(curves):
+    """Print the curves as a table. Unsolved runs are marked with an asterisk."""
+    for metric, metric_curves in curves.items():
+        print(metric)
+        for (family, size), points in sorted(metric_curves.items()):
+            values = ", ".join(f"{agents}: {value:.4g}{'' if solved else '*'}" for agents, value, solved in points)
+            print(f"    {family} {size}x{size}: {values}")
+
+
+def plot_curves(curves, output_path):
+    """Plot every metric in a log-log panel with a curve for every map. Unsolved runs are drawn hollow."""
+    import matplotlib
+    matplotlib.use("Agg")
+    import matplotlib.pyplot as plt
+
+    fig, axes = plt.subplots(1, len(curves), figsize=(6 * len(curves), 5))
+    for ax, (metric, metric_curves) in zip(axes, curves.items()):
+        for (family, size), points in sorted(metric_curves.items()):
+            agents = [agents for agents, _, _ in points]
+            values = [value for _, value, _ in points]
+            line, = ax.plot(agents, values, label=f"{family} {size}x{size}")
+            unsolved = [(agents, value) for agents, value, solved in points if not solved]
+            ax.scatter([p[0] for p in unsolved], [p[1] for p in unsolved], facecolors="none",
+                       edgecolors=line.get_color())
+        ax.set_xscale("log")
+        ax.set_yscale("log")
+        ax.set_xlabel("agents")
+        ax.set_ylabel(metric)
+        ax.grid(True, which="both", alpha=0.3)
+    axes[-1].legend(fontsize="small")
+    fig.tight_layout()
+    fig.savefig(output_path)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Plot the results of a scaling suite")
+    parser.add_argument("results", help="Results written by run_benchmarks.py")
+    parser.add_argument("--output", default="scaling.png", help="Image to write the plot to")
+    args = parser.parse_args()
+
+    curves = read_curves(args.results)
+    print_curves(curves)
+    try:
+        plot_curves(curves, args.output)
+    except ImportError:
+        print("Install matplotlib to plot the curves")
+        return 0
+    print(f"Wrote plot to {args.output}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,200 @@
+#!/usr/bin/env python3
+#
+# This file is part of BCP-MAPF.
+#
+# BCP-MAPF is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# BCP-MAPF is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+# Run the benchmark suite, write the results to JSON and compare them against a baseline written by a previous run.
+# Every instance is solved in a separate process with a fixed seed. A metric regresses if its median is worse than the
+# median of the baseline by more than a relative threshold, an absolute threshold and the spread of the baseline runs.
+
+import argparse
+import json
+import os
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+# Metrics compared against the baseline with their absolute thresholds. Lower is better for every metric.
+METRICS = {
+    "wall time": 0.5,
+    "nodes": 2,
+    "columns": 50,
+    "cuts": 50,
+    "root gap": 0.001,
+    "peak memory (MB)": 16,
+}
+
+
+def read_suite(suite_path):
+    """Read the scenarios, the number of agents and the time limits of the suite."""
+    suite = []
+    with open(suite_path) as f:
+        for line in f:
+            line = line.strip()
+            if not line or line.startswith("#"):
+                continue
+            scenario, agents, time_limit = line.split()
+            suite.append({"scenario": scenario, "agents": int(agents), "time limit": float(time_limit)})
+    return suite
+
+
+def stage_scenario(scenario, work_dir):
+    """Link the scenario and its map into the layout expected by the solver, with the map in ../map/."""
+    scenario = os.path.abspath(scenario)
+    with open(scenario) as f:
+        f.readline()
+        map_name = f.readline().split()[1]
+    scen_dir = os.path.join(work_dir, "scen")
+    map_dir = os.path.join(work_dir, "map")
+    os.makedirs(scen_dir, exist_ok=True)
+    os.makedirs(map_dir, exist_ok=True)
+    staged_scenario = os.path.join(scen_dir, os.path.basename(scenario))
+    staged_map = os.path.join(map_dir, map_name)
+    for source, target in ((scenario, staged_scenario), (os.path.join(os.path.dirname(scenario), map_name), staged_map)):
+        if not os.path.exists(target):
+            os.symlink(source, target)
+    return staged_scenario
+
+
+def run_instance(solver, instance, seed, work_dir, extra_args):
+    """Solve an instance and collect the statistics of the run."""
+    scenario = stage_scenario(instance["scenario"], work_dir)
+    name = os.path.splitext(os.path.basename(scenario))[0]
+    output = os.path.join(work_dir, f"{name}-{seed}.csv")
+    for path in (output, output + ".plugins.json"):
+        if os.path.exists(path):
+            os.remove(path)
+    command = [solver,
+               "--agent-limit", str(instance["agents"]),
+               "--time-limit", str(instance["time limit"]),
+               "--seed", str(seed),
+               "-o", output,
+               "-p", os.path.join(work_dir, f"{name}-{seed}.path"),
+               *extra_args,
+               scenario]
+
+    # Solve. The peak memory is measured by the operating system for this process only.
+    start = time.monotonic()
+    process = subprocess.Popen(command, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    _, status, usage = os.wait4(process.pid, 0)
+    wall_time = time.monotonic() - start
+    run = {"wall time": wall_time, "exit status": os.waitstatus_to_exitcode(status),
+           "peak memory (MB)": usage.ru_maxrss / 1024.0}
+
+    # Read the statistics written by the solver.
+    try:
+        with open(output + ".plugins.json") as f:
+            plugins = json.load(f)
+    except (OSError, json.JSONDecodeError):
+        run["error"] = "no statistics"
+        return run
+    summary = plugins.pop("summary")
+    run["memory (MB)"] = plugins.pop("memory (MB)", {})
+    run.update({key: summary[key] for key in ("nodes", "columns", "cuts", "root gap",
+                                              "lower bound", "upper bound", "solving time")})
+    run["solved"] = summary["upper bound"] is not None and summary["lower bound"] is not None and \
+                    summary["upper bound"] - summary["lower bound"] < 1e-6
+    run["plugin times"] = {f"{kind}/{row['name']}": row["time"] for kind, rows in plugins.items() for row in rows}
+    return run
+
+
+def summarize(runs):
+    """Find the median and the spread of every metric over the runs."""
+    summary = {}
+    for metric in METRICS:
+        values = [run[metric] for run in runs if run.get(metric) is not None]
+        if values:
+            summary[metric] = {"median": statistics.median(values), "spread": max(values) - min(values)}
+    summary["solved"] = all(run.get("solved", False) for run in runs)
+    return summary
+
+
+def compare(report, baseline, relative_threshold):
+    """Find the metrics that regress against the baseline."""
+    regressions = []
+    baseline_instances = {(instance["scenario"], instance["agents"]): instance for instance in baseline["instances"]}
+    for instance in report["instances"]:
+        key = (instance["scenario"], instance["agents"])
+        if key not in baseline_instances:
+            continue
+        old = baseline_instances[key]["summary"]
+        new = instance["summary"]
+        if old["solved"] and not new["solved"]:
+            regressions.append(f"{instance['scenario']} ({instance['agents']} agents): no longer solved")
+        for metric, absolute_threshold in METRICS.items():
+            if metric not in old or metric not in new:
+                continue
+            old_value = old[metric]["median"]
+            new_value = new[metric]["median"]
+            difference = new_value - old_value
+            if difference > max(relative_threshold * abs(old_value), absolute_threshold, old[metric]["spread"]):
+                regressions.append(f"{instance['scenario']} ({instance['agents']} agents): {metric} "
+                                   f"{old_value:.4g} -> {new_value:.4g}")
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Run the benchmark suite and compare against a baseline")
+    parser.add_argument("--solver", required=True, help="Path to the bcp-mapf executable")
+    parser.add_argument("--suite", default=os.path.join(os.path.dirname(__file__), "suite.txt"),
+                        help="File listing the scenarios, the number of agents and the time limits")
+    parser.add_argument("--root", default=os.path.join(os.path.dirname(__file__), ".."),
+                        help="Directory the scenarios of the suite are relative to")
+    parser.add_argument("--output", default="benchmark.json", help="File to write the results to")
+    parser.add_argument("--baseline", help="Results of a previous run to compare against")
+    parser.add_argument("--repeats", type=int, default=3, help="Number of runs of every instance")
+    parser.add_argument("--seed", type=int, default=1, help="Seed of the first run, incremented for every repeat")
+    parser.add_argument("--threshold", type=float, default=0.1, help="Relative worsening reported as a regression")
+    parser.add_argument("solver_args", nargs="*", help="Extra options passed to the solver after --")
+    args = parser.parse_args()
+
+    # Run.
+    suite = read_suite(args.suite)
+    report = {"suite": os.path.abspath(args.suite), "repeats": args.repeats, "seed": args.seed,
+              "solver args": args.solver_args, "instances": []}
+    with tempfile.TemporaryDirectory(prefix="bcp-mapf-bench-") as work_dir:
+        for instance in suite:
+            instance = dict(instance, scenario=os.path.normpath(os.path.join(args.root, instance["scenario"])))
+            runs = [run_instance(args.solver, instance, args.seed + repeat, work_dir, args.solver_args)
+                    for repeat in range(args.repeats)]
+            summary = summarize(runs)
+            print(f"{os.path.basename(instance['scenario'])} ({instance['agents']} agents): "
+                  f"{summary.get('wall time', {}).get('median', float('nan')):.2f} s, "
+                  f"{'solved' if summary['solved'] else 'not solved'}", flush=True)
+            report["instances"].append({"scenario": os.path.relpath(instance["scenario"], args.root),
+                                        "agents": instance["agents"],
+                                        "time limit": instance["time limit"],
+                                        "runs": runs,
+                                        "summary": summary})
+    with open(args.output, "w") as f:
+        json.dump(report, f, indent=4)
+    print(f"Wrote results to {args.output}")
+
+    # Compare.
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        regressions = compare(report, baseline, args.threshold)
+        for regression in regressions:
+            print(f"Regression: {regression}")
+        print(f"Found {len(regressions)} regressions against {args.baseline}")
+        return 1 if regressions else 0
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -21,6 +21,8 @@ Author: Edward Lam <ed@ed-lam.com>
 
 #include "AStar.h"
 #include <cstddef>
+#include <chrono>
+#include <queue>
 
 #define EPS (1e-6)
 #define isEQ(x, y) (std::abs((x)-(y)) <= (EPS))
@@ -57,6 +59,56 @@ static inline void set_bitset(std::byte* const bitset, const Int i)
 //    bitset[idx] &= ~mask;
 //}
 
+// Number of 64-bit words storing a bitset
+static inline Int get_nb_bitset_words(const Int nb_bits)
+{
+    return (nb_bits + 63) / 64;
+}
+
+// Get a 64-bit word of a bitset. Bit i of the bitset is bit i % 64 of word i / 64 on little-endian machines.
+static inline uint64_t get_bitset_word(const std::byte* const bitset, const Int w)
+{
+    uint64_t word;
+    memcpy(&word, bitset + w * sizeof(uint64_t), sizeof(uint64_t));
+    return word;
+}
+
+#ifdef USE_GOAL_CONFLICTS
+// Tabulate the total cost of the goal penalties set in every bit pattern of each byte of the label state
+static void make_goal_penalty_byte_costs(
+    const GoalPenalties& goal_penalties,    // Goal penalties
+    Vector<Cost>& byte_costs                // Output table of 256 costs per byte of the label state
+)
+{
+    const auto nb_bytes = get_nb_bitset_words(goal_penalties.size()) * sizeof(uint64_t);
+    byte_costs.assign(nb_bytes * 256, 0);
+    for (Int idx = 0; idx < goal_penalties.size(); ++idx)
+    {
+        auto costs = &byte_costs[(idx / CHAR_BIT) * 256];
+        const auto bit = idx % CHAR_BIT;
+        for (Int pattern = 0; pattern < 256; ++pattern)
+            if ((pattern >> bit) & 1)
+            {
+                costs[pattern] += goal_penalties[idx].cost;
+            }
+    }
+}
+
+// Calculate the total cost of the goal penalties set in a 64-bit word of the label state
+static inline Cost get_goal_penalty_word_cost(
+    const Cost* byte_costs,    // Table of costs of the first byte of the word
+    uint64_t word              // Bits of the word
+)
+{
+    Cost cost = 0;
+    for (; word; word >>= CHAR_BIT, byte_costs += 256)
+    {
+        cost += byte_costs[word & 0xFF];
+    }
+    return cost;
+}
+#endif
+
 #ifdef DEBUG
 String make_goal_state_string(const std::byte* const state, const Int nb_goal_crossings)
 {
@@ -73,9 +125,26 @@ String make_goal_state_string(const std::byte* const state, const Int nb_goal_cr
 }
 #endif
 
-bool AStar::Data::can_be_better(const Data& previous_data)
+#ifdef USE_ASTAR_SOLUTION_CACHING
+// Get the latest visit time of a node in a list of restrictions or the maximum time if the node is not restricted
+static Time find_latest_visit_time(
+    const Vector<Pair<Node, Time>>& latest_visit_time,    // Restricted nodes
+    const Node n                                          // Node
+)
+{
+    Time t = std::numeric_limits<Time>::max();
+    for (const auto& [restricted_n, restricted_t] : latest_visit_time)
+        if (restricted_n == n)
+        {
+            t = std::min(t, restricted_t);
+        }
+    return t;
+}
+
+bool AStar::Data::can_be_better(const CachedData& previous_data) const
 {
-    if (cost_offset < previous_data.cost_offset ||
+    if (!previous_data.valid ||
+        cost_offset < previous_data.cost_offset ||
         waypoints != previous_data.waypoints ||
         latest_goal_time != previous_data.latest_goal_time ||
         earliest_goal_time != previous_data.earliest_goal_time)
@@ -83,33 +152,33 @@ bool AStar::Data::can_be_better(const Data& previous_data)
         return true;
     }
 
-    for (const auto& [nt, previous_edge_costs] : previous_data.edge_penalties)
-        if (previous_edge_costs.used)
+    for (const auto& [nt, previous_edge_costs] : previous_data.used_edge_penalties)
+    {
+        const auto current_edge_costs_ptr = edge_penalties.find_edge_penalties(nt);
+        if (!current_edge_costs_ptr)
         {
-            const auto it = edge_penalties.find(nt);
-            if (it == edge_penalties.end())
-            {
-                return true;
-            }
-            const auto& current_edge_costs = it->second;
-            if (current_edge_costs.north < previous_edge_costs.north ||
-                current_edge_costs.south < previous_edge_costs.south ||
-                current_edge_costs.east < previous_edge_costs.east ||
-                current_edge_costs.west < previous_edge_costs.west ||
-                current_edge_costs.wait < previous_edge_costs.wait)
-            {
-                return true;
-            }
+            return true;
         }
+        const auto& current_edge_costs = *current_edge_costs_ptr;
+        if (current_edge_costs.north < previous_edge_costs.north ||
+            current_edge_costs.south < previous_edge_costs.south ||
+            current_edge_costs.east < previous_edge_costs.east ||
+            current_edge_costs.west < previous_edge_costs.west ||
+            current_edge_costs.wait < previous_edge_costs.wait)
+        {
+            return true;
+        }
+    }
 
-    debug_assert(latest_visit_time.size() == previous_data.latest_visit_time.size());
-    for (Node n = 0; n < static_cast<Node>(latest_visit_time.size()); ++n)
-        if (latest_visit_time[n] > previous_data.latest_visit_time[n])
+    // The latest visit times only decrease from the map, so a node can only be open for longer than in the previous
+    // run if the previous run restricted it.
+    for (const auto& [n, previous_latest_visit_time] : previous_data.latest_visit_time)
+        if (find_latest_visit_time(latest_visit_time, n) > previous_latest_visit_time)
         {
             return true;
         }
 
-    if (finish_time_penalties.size() != previous_data.finish_time_penalties.size())
+    if (finish_time_penalties.size() != static_cast<Time>(previous_data.finish_time_penalties.size()))
     {
         return true;
     }
@@ -120,7 +189,7 @@ bool AStar::Data::can_be_better(const Data& previous_data)
         }
 
 #ifdef USE_GOAL_CONFLICTS
-    if (goal_penalties.size() != previous_data.goal_penalties.size())
+    if (goal_penalties.size() != static_cast<Int>(previous_data.goal_penalties.size()))
     {
         return true;
     }
@@ -135,6 +204,90 @@ bool AStar::Data::can_be_better(const Data& previous_data)
     return false;
 }
 
+// Every node-time with f value less than the previous optimal cost was expanded in the previous run. So the new
+// optimal path either stays within the node-times expanded previously or leaves them at a node-time whose previous f
+// value is at least the previous optimal cost. Since the h values only decrease by the finish time penalties, the
+// new optimal cost is at least the previous optimal cost minus the decrease in the penalties of the expanded
+// node-times, the finish time penalties and the cost offset.
+Cost AStar::Data::max_improvement(const CachedData& previous_data) const
+{
+    // Cannot bound if the search space has changed.
+    constexpr auto inf = std::numeric_limits<Cost>::infinity();
+    if (!previous_data.valid ||
+        waypoints != previous_data.waypoints ||
+        latest_goal_time != previous_data.latest_goal_time ||
+        earliest_goal_time != previous_data.earliest_goal_time)
+    {
+        return inf;
+    }
+    for (const auto& [n, previous_latest_visit_time] : previous_data.latest_visit_time)
+        if (find_latest_visit_time(latest_visit_time, n) > previous_latest_visit_time)
+        {
+            return inf;
+        }
+
+    // Cannot bound if labels have resources because dominance no longer depends only on the node-time.
+#ifdef USE_GOAL_CONFLICTS
+    if (!goal_penalties.empty() || !previous_data.goal_penalties.empty())
+    {
+        return inf;
+    }
+#endif
+
+    // Sum the decrease in the penalties.
+    Cost improvement = previous_data.cost_offset - cost_offset;
+    for (const auto& [nt, previous_edge_costs] : previous_data.used_edge_penalties)
+    {
+        const auto current_edge_costs_ptr = edge_penalties.find_edge_penalties(nt);
+        const EdgeCosts current_edge_costs = current_edge_costs_ptr ? *current_edge_costs_ptr : EdgeCosts();
+        Cost max_decrease = 0;
+        for (Int d = 0; d < 5; ++d)
+            if (previous_edge_costs.d[d] > current_edge_costs.d[d])
+            {
+                max_decrease = std::max(max_decrease, previous_edge_costs.d[d] - current_edge_costs.d[d]);
+            }
+        improvement += max_decrease;
+    }
+    {
+        Cost max_decrease = 0;
+        for (Time t = 0; t < static_cast<Time>(previous_data.finish_time_penalties.size()); ++t)
+        {
+            const auto decrease = previous_data.finish_time_penalties[t] - finish_time_penalties.get_penalty(t);
+            max_decrease = std::max(max_decrease, decrease);
+        }
+        improvement += max_decrease;
+    }
+    return improvement;
+}
+
+// Keep the inputs of the last run that can change its optimal path
+void AStar::cache_data(CachedData& cache) const
+{
+    cache.valid = true;
+    cache.waypoints = data_.waypoints;
+    cache.earliest_goal_time = data_.earliest_goal_time;
+    cache.latest_goal_time = data_.latest_goal_time;
+    cache.cost_offset = data_.cost_offset;
+
+    // Copy the edge penalties read by the search.
+    cache.used_edge_penalties.clear();
+    cache.used_edge_penalties.reserve(data_.edge_penalties.nb_used());
+    data_.edge_penalties.for_each_used([&](const NodeTime nt, const EdgeCosts& edge_costs)
+    {
+        cache.used_edge_penalties.emplace_back(nt, edge_costs);
+    });
+
+    // Copy the latest visit times that differ from the map.
+    cache.latest_visit_time = data_.latest_visit_time;
+
+    // Copy the finish time and goal penalties.
+    cache.finish_time_penalties = data_.finish_time_penalties.data();
+#ifdef USE_GOAL_CONFLICTS
+    cache.goal_penalties = data_.goal_penalties.data();
+#endif
+}
+#endif
+
 AStar::AStar(const Map& map) :
     map_(map),
 
@@ -143,17 +296,37 @@ AStar::AStar(const Map& map) :
     h_node_to_waypoint_(nullptr),
     h_waypoint_to_goal_(),
     heuristic_(map),
+    backward_pruning_(false),
+    latest_reach_time_(),
+    waypoint_cache_(nullptr),
+    penalty_heuristic_(false),
+    h_penalty_(),
+    cost_threshold_(-EPS),
+    h_time_weight_(1),
+    latest_visit_time_(),
+    restricted_nodes_(),
+    label_budget_(0),
+    truncated_(false),
+    min_pruned_f_(std::numeric_limits<Cost>::infinity()),
     label_pool_(),
 #ifdef USE_RESERVATION_TABLE
-    open_(map.size()),
+    open_(map),
 #else
     open_(),
 #endif
     frontier_without_resources_(),
+    dense_frontier_(),
+    frontier_memory_budget_(0),
+    use_dense_frontier_(false),
     frontier_with_resources_(),
+    found_goal_labels_(),
+    penalty_horizon_(0),
+    macro_waits_(false),
+    tail_(),
 #ifdef DEBUG
     nb_labels_(0),
 #endif
+    statistics_(),
 
     sipp_intervals_(map)
 {
@@ -193,9 +366,16 @@ void AStar::generate_start()
     debug_assert(h_waypoint_to_goal >= 0);
     debug_assert(h_goal_to_finish >= 0);
     new_label->g = cost_offset;
-    new_label->f = cost_offset + h;
+    new_label->f = cost_offset + h_time_weight_ * h + get_h_penalty(start);
     new_label->nt = NodeTime{start, start_time}.nt;
 
+    // Stop if no path can cost less than the threshold.
+    if (new_label->f >= cost_threshold_)
+    {
+        min_pruned_f_ = std::min(min_pruned_f_, new_label->f);
+        return;
+    }
+
     // Store the label.
     debug_assert(open_.empty());
     if constexpr (has_resources)
@@ -264,7 +444,9 @@ void AStar::generate_early_segment(Label* const current,
     const auto h_waypoint_to_goal = h_waypoint_to_goal_[w];
     debug_assert(h_node_to_waypoint >= 0);
     debug_assert(h_waypoint_to_goal >= 0);
-    if (next_t + h_node_to_waypoint > waypoint_time || next_t + h_node_to_waypoint + h_waypoint_to_goal > latest_goal_time)
+    if (next_t + h_node_to_waypoint > waypoint_time ||
+        next_t + h_node_to_waypoint + h_waypoint_to_goal > latest_goal_time ||
+        (backward_pruning_ && next_t > latest_reach_time_[next_n]))
     {
         // Print.
 #ifdef DEBUG
@@ -298,10 +480,10 @@ void AStar::generate_early_segment(Label* const current,
         const auto n = current->n;
         for (Time t = current->t + 1; t < next_t; ++t)
         {
-            next_label->reserves += reservation_table().is_reserved(NodeTime{n, t});
+            next_label->reserves += reservation_table().vertex_weight(NodeTime{n, t});
         }
     }
-    next_label->reserves += reservation_table().is_reserved(next_nt);
+    next_label->reserves += get_reservation_weight(current->n, next_nt.n, next_nt.t);
 #endif
 
     // Check all goal crossings.
@@ -324,13 +506,14 @@ void AStar::generate_early_segment(Label* const current,
     // Compute f.
     const auto h_goal_to_finish = finish_time_penalties.get_h(next_t + h_node_to_waypoint + h_waypoint_to_goal);
     const auto h = std::max(h_node_to_waypoint, waypoint_time - next_t) + h_waypoint_to_goal + h_goal_to_finish;
-    next_label->f = next_label->g + h;
-    debug_assert(isGE(next_label->g, current->g + 1));
+    next_label->f = next_label->g + h_time_weight_ * h + get_h_penalty(next_n);
+    debug_assert(isGE(next_label->g, current->g + h_time_weight_));
     debug_assert(isGE(next_label->f, current->f));
 
     // Check if cost-infeasible.
-    if (isGE(next_label->f, 0))
+    if (next_label->f >= cost_threshold_)
     {
+        min_pruned_f_ = std::min(min_pruned_f_, next_label->f);
         // Print.
 #ifdef DEBUG
         if (verbose)
@@ -364,6 +547,8 @@ void AStar::generate_early_segment(Label* const current,
     auto next_label_copy = next_label;
 #endif
     next_label = dominated<has_resources>(next_label);
+    statistics_.nb_labels_generated++;
+    statistics_.nb_labels_dominated += !next_label;
 
     // Print.
 #ifdef DEBUG
@@ -413,9 +598,14 @@ void AStar::generate_early_segment(Label* const current,
 #endif
 }
 
-template<bool is_sipp, bool has_resources>
+template<bool is_sipp, bool has_resources, AStar::Features features>
 void AStar::generate_last_segment(Label* const current, const Node next_n, const Time next_t, const Cost cost)
 {
+    // Get the features of the input.
+    constexpr bool has_finish_time_penalties = features & HAS_FINISH_TIME_PENALTIES;
+    constexpr bool has_penalty_heuristic = features & HAS_PENALTY_HEURISTIC;
+    constexpr bool has_backward_pruning = features & HAS_BACKWARD_PRUNING;
+
     // Get data.
     const auto& [start,
                  waypoints,
@@ -437,7 +627,8 @@ void AStar::generate_last_segment(Label* const current, const Node next_n, const
     // Check if time-infeasible.
     const auto h_node_to_waypoint = std::max((*h_node_to_waypoint_)[next_nt.n], earliest_goal_time - next_t);
     debug_assert(h_node_to_waypoint >= 0);
-    if (next_t + h_node_to_waypoint > latest_goal_time)
+    if (next_t + h_node_to_waypoint > latest_goal_time ||
+        (has_backward_pruning && backward_pruning_ && next_t > latest_reach_time_[next_n]))
     {
         // Print.
 #ifdef DEBUG
@@ -471,10 +662,10 @@ void AStar::generate_last_segment(Label* const current, const Node next_n, const
         const auto n = current->n;
         for (Time t = current->t + 1; t < next_t; ++t)
         {
-            next_label->reserves += reservation_table().is_reserved(NodeTime{n, t});
+            next_label->reserves += reservation_table().vertex_weight(NodeTime{n, t});
         }
     }
-    next_label->reserves += reservation_table().is_reserved(next_nt);
+    next_label->reserves += get_reservation_weight(current->n, next_nt.n, next_nt.t);
 #endif
 
     // Check all goal crossings.
@@ -495,15 +686,17 @@ void AStar::generate_last_segment(Label* const current, const Node next_n, const
 #endif
 
     // Compute f.
-    const auto h_goal_to_finish = finish_time_penalties.get_h(next_t + h_node_to_waypoint);
+    const auto h_goal_to_finish = has_finish_time_penalties ? finish_time_penalties.get_h(next_t + h_node_to_waypoint) :
+                                                              0.0;
     const auto h = std::max(h_node_to_waypoint, earliest_goal_time - next_t) + h_goal_to_finish;
-    next_label->f = next_label->g + h;
-    debug_assert(isGE(next_label->g, current->g + 1));
+    next_label->f = next_label->g + h_time_weight_ * h + (has_penalty_heuristic ? get_h_penalty(next_n) : 0.0);
+    debug_assert(isGE(next_label->g, current->g + h_time_weight_));
     debug_assert(isGE(next_label->f, current->f));
 
     // Check if cost-infeasible.
-    if (isGE(next_label->f, 0))
+    if (next_label->f >= cost_threshold_)
     {
+        min_pruned_f_ = std::min(min_pruned_f_, next_label->f);
         // Print.
 #ifdef DEBUG
         if (verbose)
@@ -537,6 +730,8 @@ void AStar::generate_last_segment(Label* const current, const Node next_n, const
     auto next_label_copy = next_label;
 #endif
     next_label = dominated<has_resources>(next_label);
+    statistics_.nb_labels_generated++;
+    statistics_.nb_labels_dominated += !next_label;
 
     // Print.
 #ifdef DEBUG
@@ -586,11 +781,81 @@ void AStar::generate_last_segment(Label* const current, const Node next_n, const
 #endif
 }
 
-template<IntCost default_cost, bool has_resources, bool is_last_segment, class... WaypointArgs>
+// A label at a node without edge penalties can wait until the node or one of its neighbours has edge penalties in
+// one step. Leaving the node to a neighbour during the skipped times costs the same as moving to the neighbour
+// immediately and waiting there, so no path is lost.
+template<bool is_last_segment, AStar::Features features, class... WaypointArgs>
+Time AStar::get_macro_wait_end(const Label* const current, WaypointArgs... waypoint_args) const
+{
+    // Get the features of the input.
+    constexpr bool has_latest_visit_time = features & HAS_LATEST_VISIT_TIME;
+    constexpr bool has_backward_pruning = features & HAS_BACKWARD_PRUNING;
+
+    // Get data.
+    const auto& [start,
+                 waypoints,
+                 goal,
+                 earliest_goal_time,
+                 latest_goal_time,
+                 cost_offset,
+                 latest_visit_time,
+                 edge_penalties,
+                 finish_time_penalties
+#ifdef USE_GOAL_CONFLICTS
+               , goal_penalties
+#endif
+    ] = data_;
+
+    // Find the target of the segment and the latest time at which the node can still reach it.
+    const auto n = current->n;
+    Node target;
+    Time end_t;
+    if constexpr (is_last_segment)
+    {
+        target = goal;
+        end_t = latest_goal_time - (*h_node_to_waypoint_)[n];
+    }
+    else
+    {
+        const auto [w, waypoint_time] = std::make_tuple(waypoint_args...);
+        target = waypoints[w].n;
+        end_t = std::min<Time>(waypoint_time - (*h_node_to_waypoint_)[n],
+                               latest_goal_time - (*h_node_to_waypoint_)[n] - h_waypoint_to_goal_[w]);
+    }
+    if (has_latest_visit_time)
+    {
+        end_t = std::min(end_t, latest_visit_time_[n]);
+    }
+    if (has_backward_pruning && backward_pruning_)
+    {
+        end_t = std::min(end_t, latest_reach_time_[n]);
+    }
+    if (n == target || end_t <= current->t + 1 || edge_penalties.find_edge_penalties(current->nt))
+    {
+        return current->t + 1;
+    }
+
+    // Stop at the first time at which the node or a neighbour has edge penalties. None remain after the horizon.
+    const auto mask = map_.neighbours(n);
+    for (Time t = current->t + 1; t < std::min(end_t, penalty_horizon_); ++t)
+        for (auto m = mask; m; m &= m - 1)
+            if (edge_penalties.find_edge_penalties(NodeTime{map_.get_neighbour(n, __builtin_ctz(m)), t}))
+            {
+                return t;
+            }
+    return end_t;
+}
+
+template<IntCost default_cost, bool has_resources, bool is_last_segment, AStar::Features features,
+         class... WaypointArgs>
 void AStar::generate_neighbours(Label* const current, WaypointArgs... waypoint_args)
 {
     constexpr bool is_sipp = false;
 
+    // Get the features of the input. The latest visit times of the map only exclude the obstacles, which are not
+    // neighbours, so they are only checked if the input restricts some nodes.
+    constexpr bool has_latest_visit_time = features & HAS_LATEST_VISIT_TIME;
+
     // Get data.
     auto& [start,
            waypoints,
@@ -630,56 +895,57 @@ void AStar::generate_neighbours(Label* const current, WaypointArgs... waypoint_a
     }
 #endif
 
-    // Expand in five directions.
+    // Expand in five directions to passable nodes.
     const auto edge_costs = edge_penalties.get_edge_costs<default_cost>(current->nt);
+    statistics_.nb_penalty_lookups++;
     const auto current_n = current->n;
     const auto next_t = current->t + 1;
-    if (const auto next_n = map_.get_north(current_n);
-        latest_visit_time[next_n] >= next_t && edge_costs.north < std::numeric_limits<Cost>::infinity())
-    {
-        generate<is_sipp, has_resources, is_last_segment>(current, next_n, next_t, edge_costs.north, waypoint_args...);
-    }
-    if (const auto next_n = map_.get_south(current_n);
-        latest_visit_time[next_n] >= next_t && edge_costs.south < std::numeric_limits<Cost>::infinity())
+    for (uint8_t mask = map_.neighbours(current_n); mask; mask &= mask - 1)
     {
-        generate<is_sipp, has_resources, is_last_segment>(current, next_n, next_t, edge_costs.south, waypoint_args...);
-    }
-    if (const auto next_n = map_.get_east(current_n);
-        latest_visit_time[next_n] >= next_t && edge_costs.east < std::numeric_limits<Cost>::infinity())
-    {
-        generate<is_sipp, has_resources, is_last_segment>(current, next_n, next_t, edge_costs.east, waypoint_args...);
-    }
-    if (const auto next_n = map_.get_west(current_n);
-        latest_visit_time[next_n] >= next_t && edge_costs.west < std::numeric_limits<Cost>::infinity())
-    {
-        generate<is_sipp, has_resources, is_last_segment>(current, next_n, next_t, edge_costs.west, waypoint_args...);
-    }
-    if (const auto next_n = map_.get_wait(current_n);
-        latest_visit_time[next_n] >= next_t && edge_costs.wait < std::numeric_limits<Cost>::infinity())
-    {
-        generate<is_sipp, has_resources, is_last_segment>(current, next_n, next_t, edge_costs.wait, waypoint_args...);
+        const auto d = __builtin_ctz(mask);
+        if (const auto next_n = map_.get_neighbour(current_n, d);
+            (!has_latest_visit_time || latest_visit_time_[next_n] >= next_t) &&
+            edge_costs.d[d] < std::numeric_limits<Cost>::infinity())
+        {
+            // Wait over the times without penalties in one label. The label accumulates the reservations of the skipped
+            // times like a SIPP wait.
+            if constexpr (!has_resources)
+            {
+                if (d == Direction::WAIT && macro_waits_)
+                {
+                    if (const auto wait_end = get_macro_wait_end<is_last_segment, features>(current, waypoint_args...);
+                        wait_end > next_t)
+                    {
+                        statistics_.nb_macro_waits++;
+                        generate<true, has_resources, is_last_segment, features>(current,
+                                                                                 current_n,
+                                                                                 wait_end,
+                                                                                 (wait_end - current->t) * default_cost,
+                                                                                 waypoint_args...);
+                        continue;
+                    }
+                }
+            }
+
+            generate<is_sipp, has_resources, is_last_segment, features>(current,
+                                                                        next_n,
+                                                                        next_t,
+                                                                        edge_costs.d[d],
+                                                                        waypoint_args...);
+        }
     }
 }
 
-template<IntCost default_cost, bool has_resources, bool is_last_segment, class... WaypointArgs>
+template<IntCost default_cost, bool has_resources, bool is_last_segment, AStar::Features features,
+         class... WaypointArgs>
 void AStar::generate_neighbours_sipp(Label* const current, WaypointArgs... waypoint_args)
 {
     constexpr bool is_sipp = true;
 
     // Get data.
-    auto& [start,
-           waypoints,
-           goal,
-           earliest_goal_time,
-           latest_goal_time,
-           cost_offset,
-           latest_visit_time,
-           edge_penalties,
-           finish_time_penalties
-#ifdef USE_GOAL_CONFLICTS
-         , goal_penalties
+#if defined(DEBUG) && defined(USE_GOAL_CONFLICTS)
+    const auto& goal_penalties = data_.goal_penalties;
 #endif
-    ] = data_;
 
     // Get constant.
     constexpr auto inf_cost = std::numeric_limits<Cost>::infinity();
@@ -717,6 +983,7 @@ void AStar::generate_neighbours_sipp(Label* const current, WaypointArgs... waypo
     Time wait_start = max_time;
     Time wait_end = max_time;
     Cost wait_penalty = 0;
+    statistics_.nb_penalty_lookups++;
     for (auto [it, end] = sipp_intervals_.get_intervals(n, Direction::WAIT); it != end; ++it)
     {
         const auto& interval = *it;
@@ -733,9 +1000,13 @@ void AStar::generate_neighbours_sipp(Label* const current, WaypointArgs... waypo
             const Cost cost = (default_cost)                * std::max(wait_start - t, 0) +
                               (default_cost + wait_penalty) * (wait_end - wait_start);
             debug_assert(next_t == t + std::max(wait_start - t, 0) + (wait_end - wait_start));
-            if (cost < inf_cost && latest_visit_time[n] >= next_t - 1 && latest_visit_time[next_n] >= next_t)
+            if (cost < inf_cost && latest_visit_time_[n] >= next_t - 1 && latest_visit_time_[next_n] >= next_t)
             {
-                generate<is_sipp, has_resources, is_last_segment>(current, next_n, next_t, cost, waypoint_args...);
+                generate<is_sipp, has_resources, is_last_segment, features>(current,
+                                                                            next_n,
+                                                                            next_t,
+                                                                            cost,
+                                                                            waypoint_args...);
             }
 
             // Only expand to the first of the upcoming wait intervals.
@@ -743,17 +1014,19 @@ void AStar::generate_neighbours_sipp(Label* const current, WaypointArgs... waypo
         }
     }
 
-    // Expand in the move directions.
-    for (Int d = 0; d < 4; ++d)
+    // Expand in the move directions to passable nodes.
+    for (uint8_t mask = map_.neighbours(n) & 0b1111; mask; mask &= mask - 1)
     {
         // Get the destination node.
-        const auto next_n = map_.get_destination(n, static_cast<Direction>(d));
+        const Int d = __builtin_ctz(mask);
+        const auto next_n = map_.get_neighbour(n, d);
 
         // Get the outgoing intervals at the current node and the wait intervals at the destination.
         auto [interval, intervals_end] = sipp_intervals_.get_intervals(n, static_cast<Direction>(d));
 
         // Advance to the first wait interval after the curren time.
         auto [wait_interval, dest_wait_intervals_end] = sipp_intervals_.get_intervals(next_n, Direction::WAIT);
+        statistics_.nb_penalty_lookups += 2;
         for (; wait_interval != dest_wait_intervals_end && wait_interval->end <= t + 1; ++wait_interval)
         ;
         debug_assert(wait_interval == dest_wait_intervals_end || wait_interval->end > t + 1);
@@ -769,17 +1042,17 @@ void AStar::generate_neighbours_sipp(Label* const current, WaypointArgs... waypo
             if (interval_end > t)
             {
                 debug_assert(interval_start < wait_end);
-                generate_neighbours_one_interval_sipp<default_cost, has_resources, is_last_segment>(current,
-                                                                                                    wait_start,
-                                                                                                    wait_end,
-                                                                                                    wait_penalty,
-                                                                                                    next_n,
-                                                                                                    interval_start,
-                                                                                                    interval_end,
-                                                                                                    interval_penalty,
-                                                                                                    dest_wait_intervals_end,
-                                                                                                    wait_interval,
-                                                                                                    waypoint_args...);
+                generate_neighbours_one_interval_sipp<default_cost, has_resources, is_last_segment, features>(current,
+                                                                                                              wait_start,
+                                                                                                              wait_end,
+                                                                                                              wait_penalty,
+                                                                                                              next_n,
+                                                                                                              interval_start,
+                                                                                                              interval_end,
+                                                                                                              interval_penalty,
+                                                                                                              dest_wait_intervals_end,
+                                                                                                              wait_interval,
+                                                                                                              waypoint_args...);
             }
         }
         if (!intervals_empty)
@@ -794,17 +1067,17 @@ void AStar::generate_neighbours_sipp(Label* const current, WaypointArgs... waypo
                     // Expand at the interval.
                     {
                         const auto [interval_start, interval_end, interval_penalty] = *interval;
-                        generate_neighbours_one_interval_sipp<default_cost, has_resources, is_last_segment>(current,
-                                                                                                            wait_start,
-                                                                                                            wait_end,
-                                                                                                            wait_penalty,
-                                                                                                            next_n,
-                                                                                                            interval_start,
-                                                                                                            interval_end,
-                                                                                                            interval_penalty,
-                                                                                                            dest_wait_intervals_end,
-                                                                                                            wait_interval,
-                                                                                                            waypoint_args...);
+                        generate_neighbours_one_interval_sipp<default_cost, has_resources, is_last_segment, features>(current,
+                                                                                                                      wait_start,
+                                                                                                                      wait_end,
+                                                                                                                      wait_penalty,
+                                                                                                                      next_n,
+                                                                                                                      interval_start,
+                                                                                                                      interval_end,
+                                                                                                                      interval_penalty,
+                                                                                                                      dest_wait_intervals_end,
+                                                                                                                      wait_interval,
+                                                                                                                      waypoint_args...);
                     }
                 }
             }
@@ -820,24 +1093,25 @@ void AStar::generate_neighbours_sipp(Label* const current, WaypointArgs... waypo
                 debug_assert(interval_end > t);
                 if (interval_start < wait_end)
                 {
-                    generate_neighbours_one_interval_sipp<default_cost, has_resources, is_last_segment>(current,
-                                                                                                        wait_start,
-                                                                                                        wait_end,
-                                                                                                        wait_penalty,
-                                                                                                        next_n,
-                                                                                                        interval_start,
-                                                                                                        interval_end,
-                                                                                                        interval_penalty,
-                                                                                                        dest_wait_intervals_end,
-                                                                                                        wait_interval,
-                                                                                                        waypoint_args...);
+                    generate_neighbours_one_interval_sipp<default_cost, has_resources, is_last_segment, features>(current,
+                                                                                                                  wait_start,
+                                                                                                                  wait_end,
+                                                                                                                  wait_penalty,
+                                                                                                                  next_n,
+                                                                                                                  interval_start,
+                                                                                                                  interval_end,
+                                                                                                                  interval_penalty,
+                                                                                                                  dest_wait_intervals_end,
+                                                                                                                  wait_interval,
+                                                                                                                  waypoint_args...);
                 }
             }
         }
     }
 }
 
-template<IntCost default_cost, bool has_resources, bool is_last_segment, class... WaypointArgs>
+template<IntCost default_cost, bool has_resources, bool is_last_segment, AStar::Features features,
+         class... WaypointArgs>
 void AStar::generate_neighbours_one_interval_sipp(Label* const current,
                                                   const Time wait_start,
                                                   const Time wait_end,
@@ -852,21 +1126,6 @@ void AStar::generate_neighbours_one_interval_sipp(Label* const current,
 {
     constexpr bool is_sipp = true;
 
-    // Get data.
-    const auto& [start,
-                 waypoints,
-                 goal,
-                 earliest_goal_time,
-                 latest_goal_time,
-                 cost_offset,
-                 latest_visit_time,
-                 edge_penalties,
-                 finish_time_penalties
-#ifdef USE_GOAL_CONFLICTS
-               , goal_penalties
-#endif
-    ] = data_;
-
     // Get constant.
     constexpr auto inf_cost = std::numeric_limits<Cost>::infinity();
 
@@ -891,9 +1150,13 @@ void AStar::generate_neighbours_one_interval_sipp(Label* const current,
                    (default_cost + interval_penalty) * 1;
             debug_assert(next_t == t + std::max(wait_start - t, 0) + (interval_start - wait_start) + 1);
         }
-        if (cost < inf_cost && latest_visit_time[n] >= next_t - 1 && latest_visit_time[next_n] >= next_t)
+        if (cost < inf_cost && latest_visit_time_[n] >= next_t - 1 && latest_visit_time_[next_n] >= next_t)
         {
-            generate<is_sipp, has_resources, is_last_segment>(current, next_n, next_t, cost, waypoint_args...);
+            generate<is_sipp, has_resources, is_last_segment, features>(current,
+                                                                        next_n,
+                                                                        next_t,
+                                                                        cost,
+                                                                        waypoint_args...);
         }
     }
 
@@ -921,9 +1184,13 @@ void AStar::generate_neighbours_one_interval_sipp(Label* const current,
                        (default_cost + interval_penalty) * 1;
                 debug_assert(next_t == t + std::max(wait_start - t, 0) + (depart - wait_start) + 1);
             }
-            if (cost < inf_cost && latest_visit_time[n] >= next_t - 1 && latest_visit_time[next_n] >= next_t)
+            if (cost < inf_cost && latest_visit_time_[n] >= next_t - 1 && latest_visit_time_[next_n] >= next_t)
             {
-                generate<is_sipp, has_resources, is_last_segment>(current, next_n, next_t, cost, waypoint_args...);
+                generate<is_sipp, has_resources, is_last_segment, features>(current,
+                                                                            next_n,
+                                                                            next_t,
+                                                                            cost,
+                                                                            waypoint_args...);
             }
         }
     }
@@ -959,8 +1226,9 @@ void AStar::generate_end(Label* const current)
     new_label->n = -1;
 
     // Check if cost-infeasible.
-    if (isGE(new_label->f, 0))
+    if (new_label->f >= cost_threshold_)
     {
+        min_pruned_f_ = std::min(min_pruned_f_, new_label->f);
         // Print.
 #ifdef DEBUG
         if (verbose)
@@ -986,6 +1254,7 @@ void AStar::generate_end(Label* const current)
     // Store the label.
     label_pool_.commit_latest_label();
     open_.push(new_label);
+    statistics_.nb_heap_pushes++;
 
     // Print.
 #ifdef DEBUG
@@ -1006,6 +1275,144 @@ void AStar::generate_end(Label* const current)
 #endif
 }
 
+// Close the path of a label along the lower bounds to the goal. After the penalty horizon every edge costs the
+// default cost so a path that follows the lower bounds is a cheapest completion of the label if no node on it is
+// blocked and it crosses no goal of another agent that the label has not already paid for.
+template<IntCost default_cost>
+bool AStar::generate_tail(Label* const current)
+{
+    // Get data.
+    const auto& [start,
+                 waypoints,
+                 goal,
+                 earliest_goal_time,
+                 latest_goal_time,
+                 cost_offset,
+                 latest_visit_time,
+                 edge_penalties,
+                 finish_time_penalties
+#ifdef USE_GOAL_CONFLICTS
+               , goal_penalties
+#endif
+    ] = data_;
+    const auto& h = *h_node_to_waypoint_;
+
+    // Check if the lower bounds reach the goal between the earliest and the latest goal times. Waiting is not
+    // handled.
+    Node n = current->n;
+    Time t = current->t;
+    if (t + h[n] < earliest_goal_time || t + h[n] > latest_goal_time)
+    {
+        return false;
+    }
+
+    // Follow the lower bounds to the goal.
+    auto& tail = tail_;
+    tail.clear();
+    while (h[n] > 0)
+    {
+        const auto next_t = t + 1;
+        Node next_n = -1;
+        for (uint8_t mask = map_.neighbours(n); mask; mask &= mask - 1)
+        {
+            const auto d = __builtin_ctz(mask);
+            const auto candidate = map_.get_neighbour(n, d);
+            if (h[candidate] + 1 != h[n] ||
+                latest_visit_time_[candidate] < next_t ||
+                (backward_pruning_ && next_t > latest_reach_time_[candidate]))
+            {
+                continue;
+            }
+#ifdef USE_GOAL_CONFLICTS
+            bool crosses_goal = false;
+            for (Int idx = 0; idx < goal_penalties.size() && !crosses_goal; ++idx)
+            {
+                const auto goal_nt = goal_penalties[idx].nt;
+                crosses_goal = !get_bitset(current->state_, idx) && candidate == goal_nt.n && next_t >= goal_nt.t;
+            }
+            if (crosses_goal)
+            {
+                continue;
+            }
+#endif
+            next_n = candidate;
+            break;
+        }
+        if (next_n < 0)
+        {
+            return false;
+        }
+        tail.push_back(next_n);
+        n = next_n;
+        t = next_t;
+    }
+    if (n != goal)
+    {
+        // The lower bounds are zero outside the component of the goal.
+        return false;
+    }
+    debug_assert(t <= latest_goal_time);
+
+    // Create a label at every node of the tail without searching.
+    auto label = current;
+    for (const auto next_n : tail)
+    {
+        auto next_label = reinterpret_cast<Label*>(label_pool_.get_label_buffer());
+        memcpy(next_label, label, label_pool_.label_size());
+#ifdef DEBUG
+        next_label->label_id = nb_labels_++;
+#endif
+        next_label->parent = label;
+        next_label->g = label->g + default_cost;
+        next_label->nt = NodeTime{next_n, label->t + 1}.nt;
+#ifdef USE_RESERVATION_TABLE
+        next_label->reserves += get_reservation_weight(label->n, next_n, label->t + 1);
+#endif
+        next_label->f = next_label->g + h_time_weight_ * h[next_n];
+        label_pool_.commit_latest_label();
+        label = next_label;
+    }
+    statistics_.nb_tail_shortcuts++;
+
+    // Finish at the goal.
+    generate_end(label);
+    return true;
+}
+
+#ifdef USE_ASTAR_PREFETCH
+void AStar::prefetch_next_expansion()
+{
+    // Check.
+    if (open_.empty())
+    {
+        return;
+    }
+
+    // Prefetch the lower bounds, latest visit times and frontier entries of the neighbours of the next label so they
+    // arrive while the current label is expanded. The next label itself is usually already in the cache because it
+    // was prefetched when the previous label was expanded.
+    const auto next = open_.top();
+    if (const NodeTime nt{next->nt}; nt.n >= 0)
+    {
+        data_.edge_penalties.prefetch(nt);
+        const auto& h = *h_node_to_waypoint_;
+        for (uint8_t mask = map_.neighbours(nt.n); mask; mask &= mask - 1)
+        {
+            const auto next_n = map_.get_neighbour(nt.n, __builtin_ctz(mask));
+            __builtin_prefetch(&h[next_n]);
+            __builtin_prefetch(&latest_visit_time_[next_n]);
+            if (use_dense_frontier_)
+            {
+                dense_frontier_.prefetch(NodeTime{next_n, nt.t + 1});
+            }
+        }
+    }
+
+    // Prefetch the labels that can be expanded after the next label.
+    open_.prefetch_next();
+}
+#endif
+
 template<>
 AStar::Label* AStar::dominated<false>(Label* const new_label)
 {
@@ -1021,13 +1428,24 @@ AStar::Label* AStar::dominated<false>(Label* const new_label)
     // Check.
     debug_assert(data_.goal_penalties.empty());
 
-    // Try to put in the new label.
-    auto [it, success] = frontier_without_resources_.try_emplace(NodeTime{new_label->nt}, new_label);
+    // Try to put in the new label. Node-times after the horizon of the dense frontier fall back to the hash table.
+    Label** entry;
+    bool success;
+    if (const NodeTime nt{new_label->nt}; use_dense_frontier_ && dense_frontier_.covers(nt))
+    {
+        std::tie(entry, success) = dense_frontier_.try_emplace(nt, new_label);
+    }
+    else
+    {
+        auto [it, inserted] = frontier_without_resources_.try_emplace(nt, new_label);
+        entry = &it->second;
+        success = inserted;
+    }
 
     // Check for dominance if a label already exists.
     if (!success)
     {
-        auto existing_label = it->second;
+        auto existing_label = *entry;
         debug_assert(existing_label->nt == new_label->nt);
         if (isLE(existing_label->f, new_label->f))
         {
@@ -1040,7 +1458,6 @@ AStar::Label* AStar::dominated<false>(Label* const new_label)
         else
         {
             // New label dominates existing label.
-            debug_assert(it == frontier_without_resources_.find(new_label->nt));
             debug_assert(!isLE(existing_label->g, new_label->g));
 
             // Replace the existing label with the new label.
@@ -1066,6 +1483,7 @@ AStar::Label* AStar::dominated<false>(Label* const new_label)
         // Store the label.
         label_pool_.commit_latest_label();
         open_.push(new_label);
+        statistics_.nb_heap_pushes++;
 
         // Not dominated.
         return new_label;
@@ -1102,35 +1520,42 @@ AStar::Label* AStar::dominated<true>(Label* const new_label)
     bool dominates = false;
 #endif
     debug_assert(nb_goal_penalties > 0 || existing_labels.size() <= 1);
+    const auto nb_words = get_nb_bitset_words(nb_goal_penalties);
     for (size_t idx = 0; idx < existing_labels.size();)
     {
-        // Check if the new label is dominated by the existing label.
         auto& existing_label = existing_labels[idx];
+
+        // Calculate the maximum cost of each label if it incurred the penalties of the other label but not its own.
+        // Stop early once neither label can dominate the other.
+        auto existing_label_potential_cost = existing_label->f;
+        auto new_label_potential_cost = new_label->f;
+        for (Int w = 0; w < nb_words; ++w)
         {
-            // Calculate the maximum cost of the existing label if it incurred the same penalties as the new label.
-            auto existing_label_potential_cost = existing_label->f;
-            for (Int idx = 0; idx < nb_goal_penalties; ++idx)
-                if (get_bitset(new_label->state_, idx) > get_bitset(existing_label->state_, idx))
+            const auto new_word = get_bitset_word(new_label->state_, w);
+            const auto existing_word = get_bitset_word(existing_label->state_, w);
+            if (new_word != existing_word)
+            {
+                const auto byte_costs = &goal_penalty_byte_costs_[w * sizeof(uint64_t) * 256];
+                existing_label_potential_cost += get_goal_penalty_word_cost(byte_costs, new_word & ~existing_word);
+                new_label_potential_cost += get_goal_penalty_word_cost(byte_costs, existing_word & ~new_word);
+                if (isGT(existing_label_potential_cost, new_label->f) &&
+                    isGT(new_label_potential_cost, existing_label->f))
                 {
-                    existing_label_potential_cost += goal_penalties[idx].cost;
+                    break;
                 }
-            // If the existing label still costs less than or equal to the new label, even after incurring these
-            // penalties, then the new label is dominated.
-            if (isLE(existing_label_potential_cost, new_label->f))
-            {
-                debug_assert(!dominates);
-                return nullptr;
             }
         }
 
+        // Check if the new label is dominated by the existing label. If the existing label still costs less than or
+        // equal to the new label, even after incurring these penalties, then the new label is dominated.
+        if (isLE(existing_label_potential_cost, new_label->f))
+        {
+            debug_assert(!dominates);
+            return nullptr;
+        }
+
         // Check if the existing label is dominated by the new label.
         {
-            auto new_label_potential_cost = new_label->f;
-            for (Int idx = 0; idx < nb_goal_penalties; ++idx)
-                if (get_bitset(existing_label->state_, idx) > get_bitset(new_label->state_, idx))
-                {
-                    new_label_potential_cost += goal_penalties[idx].cost;
-                }
             if (isLE(new_label_potential_cost, existing_label->f))
             {
                 // If the existing label is not yet expanded, use its memory to store the new label.
@@ -1176,6 +1601,7 @@ AStar::Label* AStar::dominated<true>(Label* const new_label)
     {
         label_pool_.commit_latest_label();
         open_.push(new_label);
+        statistics_.nb_heap_pushes++;
         debug_assert(new_label->pqueue_index >= 0);
 
         existing_labels.push_back(new_label);
@@ -1186,73 +1612,424 @@ AStar::Label* AStar::dominated<true>(Label* const new_label)
 #endif
 }
 
-void AStar::preprocess_input()
+// Restrict the latest visit times of the nodes in the input. Only the nodes restricted in the previous run are
+// restored from the map so the cost depends on the number of restricted nodes rather than the size of the map.
+void AStar::apply_latest_visit_time()
 {
-    // Get data.
-    auto& [start,
-           waypoints,
-           goal,
-           earliest_goal_time,
-           latest_goal_time,
-           cost_offset,
-           latest_visit_time,
-           edge_penalties,
-           finish_time_penalties
-#ifdef USE_GOAL_CONFLICTS
-         , goal_penalties
-#endif
-    ] = data_;
+    // Restore the nodes restricted in the previous run.
+    const auto& map_latest_visit_time = map_.latest_visit_time();
+    if (latest_visit_time_.size() != map_latest_visit_time.size())
+    {
+        latest_visit_time_ = map_latest_visit_time;
+        restricted_nodes_.clear();
+    }
+    for (const auto n : restricted_nodes_)
+    {
+        latest_visit_time_[n] = map_latest_visit_time[n];
+    }
+    restricted_nodes_.clear();
 
-    // Append the goal as a waypoint.
-    debug_assert(earliest_goal_time <= latest_goal_time);
-    waypoints.push_back(NodeTime{goal, earliest_goal_time});
-}
+    // Restrict the nodes of this run.
+    for (const auto& [n, t] : data_.latest_visit_time)
+    {
+        debug_assert(0 <= n && n < map_.size());
+        if (t < latest_visit_time_[n])
+        {
+            latest_visit_time_[n] = t;
+            restricted_nodes_.push_back(n);
+        }
+    }
+}
+
+// Search backward in time from the goal. A node can be occupied until one time step before a neighbour that can
+// still reach the goal, but not after its own latest visit time. Waiting is always allowed up to this time, so a label
+// at a node after it can never finish by the latest goal time. Edge penalties and waypoints are ignored, so the times
+// are only upper bounds.
+void AStar::compute_latest_reach_time()
+{
+    // Get data.
+    const auto goal = data_.goal;
+    const auto latest_goal_time = data_.latest_goal_time;
+    const auto& latest_visit_time = latest_visit_time_;
+
+    // Start at the goal.
+    latest_reach_time_.assign(map_.size(), -1);
+    std::priority_queue<Pair<Time, Node>> open;
+    latest_reach_time_[goal] = std::min(latest_goal_time, latest_visit_time[goal]);
+    open.emplace(latest_reach_time_[goal], goal);
+
+    // Extend to the neighbours in decreasing order of time.
+    while (!open.empty())
+    {
+        const auto [t, n] = open.top();
+        open.pop();
+        if (t < latest_reach_time_[n])
+        {
+            continue;
+        }
+
+        const auto neighbours = map_.neighbours(n);
+        for (Int d = 0; d < 4; ++d)
+            if ((neighbours >> d) & 1)
+            {
+                const auto prev_n = map_.get_neighbour(n, d);
+                const auto prev_t = std::min(t - 1, latest_visit_time[prev_n]);
+                if (prev_t > latest_reach_time_[prev_n])
+                {
+                    latest_reach_time_[prev_n] = prev_t;
+                    open.emplace(prev_t, prev_n);
+                }
+            }
+    }
+}
+
+bool AStar::prepare_waypoints()
+{
+    // Get data.
+    const auto& waypoints = data_.waypoints;
+
+    // Reuse the preprocessed waypoints if the branching decisions of the agent are unchanged.
+    auto cache = waypoint_cache_;
+    if (cache && cache->valid &&
+        cache->goal == data_.goal &&
+        cache->latest_goal_time == data_.latest_goal_time &&
+        cache->backward_pruning == backward_pruning_ &&
+        cache->waypoints == waypoints &&
+        cache->latest_visit_time == data_.latest_visit_time)
+    {
+        h_waypoint_to_goal_ = cache->h_waypoint_to_goal;
+        if (backward_pruning_)
+        {
+            latest_reach_time_ = cache->latest_reach_time;
+        }
+        return cache->feasible;
+    }
+
+    // Compute minimum time between each waypoint.
+    bool feasible = true;
+    h_waypoint_to_goal_.resize(waypoints.size());
+    h_waypoint_to_goal_.back() = 0;
+    for (Waypoint w = waypoints.size() - 2; w >= 0; --w)
+    {
+        const auto h = heuristic_.get_h(waypoints[w + 1].n)[waypoints[w].n];
+        const auto t_diff = waypoints[w + 1].t - waypoints[w].t;
+        if (w != static_cast<Waypoint>(waypoints.size() - 2) && t_diff < h)
+        {
+            feasible = false;
+            break;
+        }
+        h_waypoint_to_goal_[w] = std::max(h, t_diff) + h_waypoint_to_goal_[w + 1];
+    }
+
+    // Compute the latest times from which the goal is reachable.
+    if (feasible && backward_pruning_)
+    {
+        compute_latest_reach_time();
+    }
+
+    // Store for the next run of the agent.
+    if (cache)
+    {
+        cache->valid = true;
+        cache->goal = data_.goal;
+        cache->waypoints = waypoints;
+        cache->latest_goal_time = data_.latest_goal_time;
+        cache->latest_visit_time = data_.latest_visit_time;
+        cache->backward_pruning = backward_pruning_;
+        cache->feasible = feasible;
+        cache->h_waypoint_to_goal = h_waypoint_to_goal_;
+        if (feasible && backward_pruning_)
+        {
+            cache->latest_reach_time = latest_reach_time_;
+        }
+        else
+        {
+            cache->latest_reach_time.clear();
+        }
+    }
+    return feasible;
+}
+
+// A path can only leave a node between the earliest time it can get there from the start and the latest time from
+// which it can still get to the goal. If every one of these times has penalties, the smallest penalty of each
+// direction is unavoidable when leaving in that direction. The cheapest path to the goal over these smallest
+// penalties is then a consistent lower bound on the edge penalties, which is added to the h value. The bound is
+// zero almost everywhere unless the agent has little slack to reach the goal.
+void AStar::compute_penalty_heuristic()
+{
+    // Get data.
+    const auto start = data_.start;
+    const auto goal = data_.goal;
+    const auto latest_goal_time = data_.latest_goal_time;
+    const auto& edge_penalties = data_.edge_penalties;
+    const auto& h_goal = heuristic_.get_h(goal);
+    constexpr auto inf_cost = std::numeric_limits<Cost>::infinity();
+    const auto nb_nodes = map_.size();
+
+    // Find the earliest time at each node by breadth-first search from the start.
+    Vector<Time> earliest_time(nb_nodes, std::numeric_limits<Time>::max());
+    {
+        Vector<Node> queue{start};
+        earliest_time[start] = 0;
+        for (size_t idx = 0; idx < queue.size(); ++idx)
+        {
+            const auto n = queue[idx];
+            for (uint8_t mask = map_.neighbours(n) & 0b1111; mask; mask &= mask - 1)
+            {
+                const auto next_n = map_.get_neighbour(n, __builtin_ctz(mask));
+                if (earliest_time[next_n] == std::numeric_limits<Time>::max())
+                {
+                    earliest_time[next_n] = earliest_time[n] + 1;
+                    queue.push_back(next_n);
+                }
+            }
+        }
+    }
+
+    // Find the smallest penalty of each direction over the times at which a path can leave each node.
+    Vector<Time> nb_penalised_times(nb_nodes, 0);
+    Vector<EdgeCosts> min_penalties(nb_nodes, EdgeCosts(inf_cost));
+    edge_penalties.for_each([&](const NodeTime nt, const EdgeCosts& penalties)
+    {
+        if (earliest_time[nt.n] <= nt.t && nt.t <= latest_goal_time - h_goal[nt.n])
+        {
+            ++nb_penalised_times[nt.n];
+            for (Int d = 0; d < 4; ++d)
+            {
+                min_penalties[nt.n].d[d] = std::min(min_penalties[nt.n].d[d], penalties.d[d]);
+            }
+        }
+    });
+
+    // Search backward from the goal over the unavoidable penalties.
+    h_penalty_.assign(nb_nodes, inf_cost);
+    std::priority_queue<Pair<Cost, Node>, Vector<Pair<Cost, Node>>, std::greater<Pair<Cost, Node>>> open;
+    h_penalty_[goal] = 0;
+    open.emplace(0, goal);
+    while (!open.empty())
+    {
+        const auto [h, n] = open.top();
+        open.pop();
+        if (h > h_penalty_[n])
+        {
+            continue;
+        }
+
+        for (uint8_t mask = map_.neighbours(n) & 0b1111; mask; mask &= mask - 1)
+        {
+            // Get the penalty of moving from the neighbour into this node.
+            const auto d = __builtin_ctz(mask);
+            const auto prev_n = map_.get_neighbour(n, d);
+            const auto window = earliest_time[prev_n] < std::numeric_limits<Time>::max() ?
+                                latest_goal_time - h_goal[prev_n] - earliest_time[prev_n] + 1 :
+                                0;
+            const auto penalty = window > 0 && nb_penalised_times[prev_n] == window ?
+                                 min_penalties[prev_n].d[d ^ 1] :
+                                 0;
+            if (penalty < inf_cost && h + penalty < h_penalty_[prev_n])
+            {
+                h_penalty_[prev_n] = h + penalty;
+                open.emplace(h + penalty, prev_n);
+            }
+        }
+    }
+
+    // Use no bound for nodes that cannot reach the goal at a finite cost.
+    for (auto& h : h_penalty_)
+        if (h == inf_cost)
+        {
+            h = 0;
+        }
+}
+
+void AStar::preprocess_input()
+{
+    // Start timer.
+    const auto start_time = std::chrono::steady_clock::now();
+
+    // Get data.
+    auto& [start,
+           waypoints,
+           goal,
+           earliest_goal_time,
+           latest_goal_time,
+           cost_offset,
+           latest_visit_time,
+           edge_penalties,
+           finish_time_penalties
+#ifdef USE_GOAL_CONFLICTS
+         , goal_penalties
+#endif
+    ] = data_;
+
+    // Append the goal as a waypoint.
+    debug_assert(earliest_goal_time <= latest_goal_time);
+    waypoints.push_back(NodeTime{goal, earliest_goal_time});
+
+    // Sum up the finish time penalties.
+    finish_time_penalties.accumulate();
+
+    // Index the node-times with penalties.
+    edge_penalties.build_index(map_.size());
+
+    // Restrict the latest visit times.
+    apply_latest_visit_time();
+
+    // End timer.
+    const auto end_time = std::chrono::steady_clock::now();
+    statistics_.preprocess_seconds += std::chrono::duration<double>(end_time - start_time).count();
+}
 
 template<bool is_farkas>
 Pair<Vector<NodeTime>, Cost> AStar::solve()
+{
+    auto outputs = solve_k<is_farkas>(1);
+    return !outputs.empty() ? std::move(outputs.front()) : Pair<Vector<NodeTime>, Cost>{};
+}
+template Pair<Vector<NodeTime>, Cost> AStar::solve<false>();
+template Pair<Vector<NodeTime>, Cost> AStar::solve<true>();
+
+template<bool is_farkas>
+Pair<Vector<NodeTime>, Cost> AStar::solve_sipp()
+{
+    auto outputs = solve_sipp_k<is_farkas>(1);
+    return !outputs.empty() ? std::move(outputs.front()) : Pair<Vector<NodeTime>, Cost>{};
+}
+template Pair<Vector<NodeTime>, Cost> AStar::solve_sipp<false>();
+template Pair<Vector<NodeTime>, Cost> AStar::solve_sipp<true>();
+
+template<bool is_farkas>
+Vector<Pair<Vector<NodeTime>, Cost>> AStar::solve_k(const Int k)
+{
+    Vector<Pair<Vector<NodeTime>, Cost>> outputs;
+    outputs.resize(solve_k<is_farkas>(k, outputs));
+    return outputs;
+}
+template Vector<Pair<Vector<NodeTime>, Cost>> AStar::solve_k<false>(const Int k);
+template Vector<Pair<Vector<NodeTime>, Cost>> AStar::solve_k<true>(const Int k);
+
+template<bool is_farkas>
+Int AStar::solve_k(const Int k, Vector<Pair<Vector<NodeTime>, Cost>>& outputs)
 {
     constexpr bool is_sipp = false;
 
+    // Start timer.
+    const auto start_time = std::chrono::steady_clock::now();
+
+    // Solve.
+    Int nb_outputs;
 #ifdef USE_GOAL_CONFLICTS
     if (!data_.goal_penalties.empty())
     {
         constexpr bool has_resources = true;
-        return solve<is_sipp, is_farkas, has_resources>();
+        nb_outputs = solve<is_sipp, is_farkas, has_resources>(k, outputs);
     }
     else
 #endif
     {
         constexpr bool has_resources = false;
-        return solve<is_sipp, is_farkas, has_resources>();
+        nb_outputs = solve<is_sipp, is_farkas, has_resources>(k, outputs);
     }
+
+    // End timer.
+    const auto end_time = std::chrono::steady_clock::now();
+    statistics_.solve_seconds += std::chrono::duration<double>(end_time - start_time).count();
+    return nb_outputs;
 }
-template Pair<Vector<NodeTime>, Cost> AStar::solve<false>();
-template Pair<Vector<NodeTime>, Cost> AStar::solve<true>();
+template Int AStar::solve_k<false>(const Int k, Vector<Pair<Vector<NodeTime>, Cost>>& outputs);
+template Int AStar::solve_k<true>(const Int k, Vector<Pair<Vector<NodeTime>, Cost>>& outputs);
 
 template<bool is_farkas>
-Pair<Vector<NodeTime>, Cost> AStar::solve_sipp()
+Vector<Pair<Vector<NodeTime>, Cost>> AStar::solve_sipp_k(const Int k)
+{
+    Vector<Pair<Vector<NodeTime>, Cost>> outputs;
+    outputs.resize(solve_sipp_k<is_farkas>(k, outputs));
+    return outputs;
+}
+template Vector<Pair<Vector<NodeTime>, Cost>> AStar::solve_sipp_k<false>(const Int k);
+template Vector<Pair<Vector<NodeTime>, Cost>> AStar::solve_sipp_k<true>(const Int k);
+
+template<bool is_farkas>
+Int AStar::solve_sipp_k(const Int k, Vector<Pair<Vector<NodeTime>, Cost>>& outputs)
 {
     constexpr bool is_sipp = true;
 
+    // Start timer.
+    const auto start_time = std::chrono::steady_clock::now();
+
+    // Solve.
+    Int nb_outputs;
 #ifdef USE_GOAL_CONFLICTS
     if (!data_.goal_penalties.empty())
     {
         constexpr bool has_resources = true;
-        return solve<is_sipp, is_farkas, has_resources>();
+        nb_outputs = solve<is_sipp, is_farkas, has_resources>(k, outputs);
     }
     else
 #endif
     {
         constexpr bool has_resources = false;
-        return solve<is_sipp, is_farkas, has_resources>();
+        nb_outputs = solve<is_sipp, is_farkas, has_resources>(k, outputs);
     }
+
+    // End timer.
+    const auto end_time = std::chrono::steady_clock::now();
+    statistics_.solve_seconds += std::chrono::duration<double>(end_time - start_time).count();
+    return nb_outputs;
+}
+template Int AStar::solve_sipp_k<false>(const Int k, Vector<Pair<Vector<NodeTime>, Cost>>& outputs);
+template Int AStar::solve_sipp_k<true>(const Int k, Vector<Pair<Vector<NodeTime>, Cost>>& outputs);
+
+// Find the features of the input checked while generating labels
+AStar::Features AStar::get_features() const
+{
+    Features features = 0;
+    if (data_.waypoints.size() > 1)
+    {
+        features |= HAS_WAYPOINTS;
+    }
+    if (data_.finish_time_penalties.size() > 0)
+    {
+        features |= HAS_FINISH_TIME_PENALTIES;
+    }
+    if (!data_.latest_visit_time.empty())
+    {
+        features |= HAS_LATEST_VISIT_TIME;
+    }
+    if (penalty_heuristic_)
+    {
+        features |= HAS_PENALTY_HEURISTIC;
+    }
+    if (backward_pruning_)
+    {
+        features |= HAS_BACKWARD_PRUNING;
+    }
+    return features;
 }
-template Pair<Vector<NodeTime>, Cost> AStar::solve_sipp<false>();
-template Pair<Vector<NodeTime>, Cost> AStar::solve_sipp<true>();
 
+// Dispatch to the kernel specialised for inputs without any feature or to the general kernel. Only these two are
+// instantiated to limit the code size.
 template<bool is_sipp, bool is_farkas, bool has_resources>
-Pair<Vector<NodeTime>, Cost> AStar::solve()
+Int AStar::solve(const Int k, Vector<Pair<Vector<NodeTime>, Cost>>& outputs)
+{
+    if (get_features() == 0)
+    {
+        statistics_.nb_minimal_solves++;
+        return solve_kernel<is_sipp, is_farkas, has_resources, 0>(k, outputs);
+    }
+    else
+    {
+        return solve_kernel<is_sipp, is_farkas, has_resources, ALL_FEATURES>(k, outputs);
+    }
+}
+
+template<bool is_sipp, bool is_farkas, bool has_resources, AStar::Features features>
+Int AStar::solve_kernel(const Int k, Vector<Pair<Vector<NodeTime>, Cost>>& outputs)
 {
+    debug_assert(k >= 1);
+    debug_assert((get_features() & ~features) == 0);
+    constexpr bool has_waypoints = features & HAS_WAYPOINTS;
+
     // Get data.
     const auto& [start,
                  waypoints,
@@ -1296,9 +2073,9 @@ Pair<Vector<NodeTime>, Cost> AStar::solve()
 #endif
 
     // Create output.
-    Pair<Vector<NodeTime>, Cost> output;
-    auto& path = output.first;
-    auto& path_cost = output.second;
+    Int nb_outputs = 0;
+    auto& found_goal_labels = found_goal_labels_;
+    found_goal_labels.clear();
 
     // Prepare costs.
 //     data_.edge_penalties.before_solve();
@@ -1326,33 +2103,59 @@ Pair<Vector<NodeTime>, Cost> AStar::solve()
 #endif
 #endif
 
-    // Reset.
+    // Reset. Moves are free in Farkas pricing so the heuristic only bounds the penalties.
+    h_time_weight_ = is_farkas ? 0 : 1;
+    truncated_ = false;
+    min_pruned_f_ = std::numeric_limits<Cost>::infinity();
+    size_t nb_labels_remaining = label_budget_ > 0 ? label_budget_ : std::numeric_limits<size_t>::max();
     const auto nb_states = nb_goal_crossings;
-    label_pool_.reset(sizeof(Label) + (nb_states + CHAR_BIT - 1) / CHAR_BIT);
+    label_pool_.reset(sizeof(Label) + get_nb_bitset_words(nb_states) * sizeof(uint64_t));
+#ifdef USE_GOAL_CONFLICTS
+    if (nb_goal_crossings > 0)
+    {
+        make_goal_penalty_byte_costs(goal_penalties, goal_penalty_byte_costs_);
+    }
+#endif
     open_.clear();
     if constexpr (has_resources)
     {
         frontier_with_resources_.clear();
+        use_dense_frontier_ = false;
     }
     else
     {
+        // Use the dense frontier if it fits in the memory budget for the node-times up to the latest goal time.
         frontier_without_resources_.clear();
+        const auto horizon = latest_goal_time + 1;
+        use_dense_frontier_ = DenseFrontier<Label*>::nb_bytes(map_, horizon) <= frontier_memory_budget_;
+        if (use_dense_frontier_)
+        {
+            dense_frontier_.reset(map_, horizon);
+        }
     }
 
-    // Compute minimum time between each waypoint.
-    h_waypoint_to_goal_.resize(waypoints.size());
-    h_waypoint_to_goal_.back() = 0;
-    for (Waypoint w = waypoints.size() - 2; w >= 0; --w)
+    // Allow the lower bounds used by earlier searches to be evicted.
+    heuristic_.unpin();
+
+    // Compute minimum time between each waypoint and the latest times from which the goal is reachable.
+    if (!prepare_waypoints())
     {
-        const auto h = heuristic_.get_h(waypoints[w + 1].n)[waypoints[w].n];
-        const auto t_diff = waypoints[w + 1].t - waypoints[w].t;
-        if (w != static_cast<Waypoint>(waypoints.size() - 2) && t_diff < h)
-        {
-            return output;
-        }
-        h_waypoint_to_goal_[w] = std::max(h, t_diff) + h_waypoint_to_goal_[w + 1];
+        return nb_outputs;
+    }
+
+    // Compute the lower bound on the edge penalties to the goal.
+    if (penalty_heuristic_)
+    {
+        compute_penalty_heuristic();
     }
 
+    // Find the time from which no edge or finish time penalty remains.
+    penalty_horizon_ = std::max<Time>(edge_penalties.max_time() + 1, finish_time_penalties.size());
+
+    // Wait over times without penalties in one label. The skipped departure times are equivalent to others, so this
+    // is only done when one path is wanted.
+    macro_waits_ = !is_sipp && !has_resources && k == 1;
+
     // Create the first label.
     Waypoint w = 0;
     h_node_to_waypoint_ = &heuristic_.get_h(waypoints[w].n);
@@ -1366,13 +2169,25 @@ Pair<Vector<NodeTime>, Cost> AStar::solve()
 
     // Solve up to but not including the last waypoint (goal).
     constexpr IntCost default_cost = is_farkas ? 0 : 1;
-    if (waypoints.size() > 1)
+    if (has_waypoints && waypoints.size() > 1)
     {
         while (!open_.empty())
         {
+            // Stop if the budget is exhausted.
+            if (nb_labels_remaining == 0)
+            {
+                truncated_ = true;
+                break;
+            }
+            --nb_labels_remaining;
+
             // Get a label from priority queue.
             const auto current = open_.top();
             open_.pop();
+            statistics_.nb_labels_expanded++;
+#ifdef USE_ASTAR_PREFETCH
+            prefetch_next_expansion();
+#endif
 
             // Advance to the next waypoint.
             debug_assert(current->t <= waypoints[w].t);
@@ -1428,6 +2243,7 @@ Pair<Vector<NodeTime>, Cost> AStar::solve()
                 if (w == static_cast<Waypoint>(waypoints.size() - 1))
                 {
                     open_.push(current);
+                    statistics_.nb_heap_pushes++;
                     break;
                 }
             }
@@ -1435,34 +2251,60 @@ Pair<Vector<NodeTime>, Cost> AStar::solve()
             // Generate neighbours.
             if constexpr (is_sipp)
             {
-                generate_neighbours_sipp<default_cost, has_resources, false>(current, w, waypoints[w].t);
+                generate_neighbours_sipp<default_cost, has_resources, false, features>(current, w, waypoints[w].t);
             }
             else
             {
-                generate_neighbours<default_cost, has_resources, false>(current, w, waypoints[w].t);
+                generate_neighbours<default_cost, has_resources, false, features>(current, w, waypoints[w].t);
             }
         }
     }
 
     // Solve the last segment.
+    if (truncated_)
+    {
+        return nb_outputs;
+    }
     while (!open_.empty())
     {
+        // Stop if the budget is exhausted.
+        if (nb_labels_remaining == 0)
+        {
+            truncated_ = true;
+            break;
+        }
+        --nb_labels_remaining;
+
         // Get a label from priority queue.
         const auto current = open_.top();
         open_.pop();
+        statistics_.nb_labels_expanded++;
+#ifdef USE_ASTAR_PREFETCH
+        prefetch_next_expansion();
+#endif
 
         // Expand the neighbours of the current label or exit if the goal is reached.
         debug_assert(current->t <= latest_goal_time);
         if (current->n >= 0)
         {
+            // Close the path along the lower bounds after the penalty horizon. Only the cheapest completion of the
+            // label is found so this is skipped if more than one path is wanted.
+            if constexpr (!is_sipp)
+            {
+                if (k == 1 && current->t >= penalty_horizon_ && generate_tail<default_cost>(current))
+                {
+                    continue;
+                }
+            }
+
             // Generate neighbours.
             if constexpr (is_sipp)
             {
-                generate_neighbours_sipp<default_cost, has_resources, true>(current);
+                generate_neighbours_sipp<default_cost, has_resources, true, features>(current);
             }
             else
             {
-                generate_neighbours<default_cost, has_resources, true>(current);
+                generate_neighbours<default_cost, has_resources, true, features>(current);
             }
 
             // Generate to the end.
@@ -1473,12 +2315,31 @@ Pair<Vector<NodeTime>, Cost> AStar::solve()
         }
         else
         {
-            // Store the path cost.
+            // Skip paths that only extend a path already found by waiting at the goal.
+            {
+                bool is_extension = false;
+                for (auto l = current->parent; l && l->n == goal && !is_extension; l = l->parent)
+                {
+                    is_extension = std::find(found_goal_labels.begin(), found_goal_labels.end(), l) !=
+                                   found_goal_labels.end();
+                }
+                if (is_extension)
+                {
+                    continue;
+                }
+            }
+            found_goal_labels.push_back(current->parent);
+
+            // Store the path cost. The buffers of earlier runs are reused.
+            if (nb_outputs == static_cast<Int>(outputs.size()))
+            {
+                outputs.emplace_back();
+            }
+            auto& [path, path_cost] = outputs[nb_outputs++];
             path_cost = current->g;
 
-            // Store the path.
-            debug_assert(path.empty());
-            if constexpr (is_sipp)
+            // Store the path. Labels of SIPP and of macro waits skip the times spent waiting.
+            path.clear();
             {
                 auto prev = NodeTime{current->parent->nt};
                 for (auto l = current->parent; l; l = l->parent)
@@ -1492,13 +2353,6 @@ Pair<Vector<NodeTime>, Cost> AStar::solve()
                     prev = NodeTime{l->nt};
                 }
             }
-            else
-            {
-                for (auto l = current->parent; l; l = l->parent)
-                {
-                    path.push_back(l->nt);
-                }
-            }
             std::reverse(path.begin(), path.end());
 
             // Check.
@@ -1540,11 +2394,14 @@ Pair<Vector<NodeTime>, Cost> AStar::solve()
 #endif
 
             // Check.
-            debug_assert(isLT(path_cost, 0));
+            debug_assert(path_cost < cost_threshold_);
             debug_assert(earliest_goal_time <= current->t && current->t <= latest_goal_time);
 
-            // Finish.
-            break;
+            // Finish if enough paths are found.
+            if (nb_outputs >= k)
+            {
+                break;
+            }
         }
     }
 
@@ -1555,20 +2412,261 @@ Pair<Vector<NodeTime>, Cost> AStar::solve()
         println("=======================================");
     }
 #endif
-    return output;
+    return nb_outputs;
 }
 
 // TODO: move back into solve()
 void AStar::before_solve()
 {
+    // Start timer.
+    const auto start_time = std::chrono::steady_clock::now();
+
     // Prepare costs.
     data_.edge_penalties.before_solve();
     data_.finish_time_penalties.before_solve();
 #ifdef USE_GOAL_CONFLICTS
     data_.goal_penalties.before_solve();
 #endif
+
+    // Restrict the latest visit times again in case the input is already preprocessed.
+    apply_latest_visit_time();
+
+    // End timer.
+    const auto end_time = std::chrono::steady_clock::now();
+    statistics_.before_solve_seconds += std::chrono::duration<double>(end_time - start_time).count();
 }
 
+// Run a dynamic program forward in time over the penalties and the move costs. The cost of a path through a node-time
+// is at least the cost to get there plus the minimum time to finish from there because the penalties are
+// non-negative. A node-time whose bound is not below the gap cannot be in a path whose reduced cost is below the gap.
+// The bound never decreases along a path so the program stops at the first time without such node-times.
+Time AStar::compute_reduced_cost_fixing(const Cost gap, Vector<Pair<Node, Time>>& latest_visit_time)
+{
+    // Get data.
+    const auto& [start,
+                 waypoints,
+                 goal,
+                 earliest_goal_time,
+                 latest_goal_time,
+                 cost_offset,
+                 input_latest_visit_time,
+                 edge_penalties,
+                 finish_time_penalties
+#ifdef USE_GOAL_CONFLICTS
+               , goal_penalties
+#endif
+    ] = data_;
+    debug_assert(!waypoints.empty() && waypoints.back().n == goal);
+    constexpr auto inf_cost = std::numeric_limits<Cost>::infinity();
+    const auto nb_nodes = map_.size();
+    heuristic_.unpin();
+    const auto& h_goal = heuristic_.get_h(goal);
+    const auto& h_start = heuristic_.get_h(start);
+
+    // Create the first layer.
+    Vector<Cost> cost(nb_nodes, inf_cost);
+    Vector<Cost> next_cost(nb_nodes, inf_cost);
+    Vector<Node> nodes;
+    Vector<Node> next_nodes;
+    Vector<Time> latest_time(nb_nodes, -1);
+    if (latest_visit_time_[start] >= 0)
+    {
+        cost[start] = cost_offset;
+        nodes.push_back(start);
+    }
+
+    // Extend forward in time.
+    Time latest_finish_time = -1;
+    size_t w = 0;
+    const auto nb_waypoints = waypoints.size() - 1;
+    for (Time t = 0; !nodes.empty(); ++t)
+    {
+        // Keep the waypoint only.
+        if (w < nb_waypoints && waypoints[w].t == t)
+        {
+            const auto waypoint_n = waypoints[w].n;
+            for (const auto n : nodes)
+                if (n != waypoint_n)
+                {
+                    cost[n] = inf_cost;
+                }
+            nodes.clear();
+            if (cost[waypoint_n] < inf_cost)
+            {
+                nodes.push_back(waypoint_n);
+            }
+            ++w;
+        }
+
+        // Remove the node-times whose bound is not below the gap.
+        size_t nb_kept = 0;
+        for (const auto n : nodes)
+        {
+            const auto remaining = std::max<Cost>(h_goal[n], earliest_goal_time - t);
+            if (cost[n] + remaining < gap)
+            {
+                latest_time[n] = t;
+                nodes[nb_kept++] = n;
+            }
+            else
+            {
+                cost[n] = inf_cost;
+            }
+        }
+        nodes.resize(nb_kept);
+
+        // Finish at the goal.
+        if (w == nb_waypoints && t >= earliest_goal_time && cost[goal] < gap)
+        {
+            latest_finish_time = t;
+        }
+        if (t >= latest_goal_time)
+        {
+            break;
+        }
+
+        // Create the next layer.
+        for (const auto n : nodes)
+        {
+            const auto penalties = edge_penalties.find_edge_penalties(NodeTime{n, t});
+            for (uint8_t mask = map_.neighbours(n); mask; mask &= mask - 1)
+            {
+                const auto d = __builtin_ctz(mask);
+                const auto next_n = map_.get_neighbour(n, d);
+                if (t + 1 > latest_visit_time_[next_n])
+                {
+                    continue;
+                }
+                const auto next = cost[n] + 1 + (penalties ? penalties->d[d] : 0);
+                if (next < next_cost[next_n])
+                {
+                    if (next_cost[next_n] == inf_cost)
+                    {
+                        next_nodes.push_back(next_n);
+                    }
+                    next_cost[next_n] = next;
+                }
+            }
+            cost[n] = inf_cost;
+        }
+        std::swap(cost, next_cost);
+        std::swap(nodes, next_nodes);
+        next_nodes.clear();
+    }
+
+    // Restrict the nodes that a path can reach and still finish by the latest goal time at times that no path below
+    // the gap can visit. The goal is restricted by the latest goal time instead.
+    if (latest_finish_time >= 0)
+    {
+        for (Node n = 0; n < nb_nodes; ++n)
+            if (map_[n] && n != goal)
+            {
+                const auto latest_useful_time = std::min<Time>(latest_finish_time - h_goal[n], latest_visit_time_[n]);
+                if (h_start[n] <= latest_useful_time && latest_time[n] < latest_useful_time)
+                {
+                    latest_visit_time.emplace_back(n, latest_time[n]);
+                }
+            }
+    }
+    return latest_finish_time;
+}
+
+// Get a lower bound on the finish time of every path from a start to a goal through some waypoints
+Time AStar::min_finish_time(const Node start, const Vector<NodeTime>& waypoints, const Node goal)
+{
+    heuristic_.unpin();
+    const auto& h = heuristic_.get_h(goal);
+    Time finish_time = h[start];
+    for (const auto nt : waypoints)
+    {
+        finish_time = std::max<Time>(finish_time, nt.t + h[nt.n]);
+    }
+    return finish_time;
+}
+
+// Compute the cost of an existing path under the current input data without searching. Must be called after
+// preprocess_input(). Returns infinity if the path does not satisfy the waypoints, goal times or blocked vertices.
+template<bool is_farkas>
+Cost AStar::calculate_path_cost(const Edge* const path, const Time path_length) const
+{
+    // Get data.
+    const auto& [start,
+                 waypoints,
+                 goal,
+                 earliest_goal_time,
+                 latest_goal_time,
+                 cost_offset,
+                 latest_visit_time,
+                 edge_penalties,
+                 finish_time_penalties
+#ifdef USE_GOAL_CONFLICTS
+               , goal_penalties
+#endif
+    ] = data_;
+    constexpr IntCost default_cost = is_farkas ? 0 : 1;
+    constexpr auto inf = std::numeric_limits<Cost>::infinity();
+
+    // Check the start, the goal and the finish time.
+    debug_assert(path_length >= 1);
+    const auto finish_time = path_length - 1;
+    if (path[0].n != start ||
+        path[finish_time].n != goal ||
+        finish_time < earliest_goal_time ||
+        finish_time > latest_goal_time)
+    {
+        return inf;
+    }
+
+    // Check the waypoints, excluding the goal appended to the end.
+    debug_assert(!waypoints.empty());
+    for (auto it = waypoints.begin(); it != waypoints.end() - 1; ++it)
+        if (it->t > finish_time || path[it->t].n != it->n)
+        {
+            return inf;
+        }
+
+    // Sum the edge costs and check the latest visit times.
+    Cost cost = cost_offset;
+    for (Time t = 0; t < finish_time; ++t)
+    {
+        const auto next_n = path[t + 1].n;
+        if (latest_visit_time_[next_n] < t + 1)
+        {
+            return inf;
+        }
+
+        Cost edge_cost = default_cost;
+        if (const auto penalties = edge_penalties.find_edge_penalties(NodeTime{path[t].n, t}))
+        {
+            edge_cost += penalties->d[path[t].d];
+        }
+        if (edge_cost == inf)
+        {
+            return inf;
+        }
+        cost += edge_cost;
+    }
+
+    // Incur the penalty of every goal crossed.
+#ifdef USE_GOAL_CONFLICTS
+    for (const auto [goal_nt, goal_cost] : goal_penalties)
+        for (Time t = std::max(goal_nt.t, 1); t <= finish_time; ++t)
+            if (path[t].n == goal_nt.n)
+            {
+                cost += goal_cost;
+                break;
+            }
+#endif
+
+    // Incur the finish time penalty.
+    cost += finish_time_penalties.get_penalty(finish_time);
+
+    // Done.
+    return cost;
+}
+template Cost AStar::calculate_path_cost<false>(const Edge* const path, const Time path_length) const;
+template Cost AStar::calculate_path_cost<true>(const Edge* const path, const Time path_length) const;
+
 #ifdef DEBUG
 Pair<Vector<NodeTime>, Cost> AStar::calculate_cost(const Vector<Node>& input_path)
 {
@@ -1586,6 +2684,7 @@ Pair<Vector<NodeTime>, Cost> AStar::calculate_cost(const Vector<Node>& input_pat
     constexpr bool is_farkas = false;
     constexpr bool is_sipp = false;
     constexpr bool is_last_segment = false;
+    constexpr Features features = ALL_FEATURES;
 
     // ------------------------------------
 
@@ -1642,6 +2741,7 @@ Pair<Vector<NodeTime>, Cost> AStar::calculate_cost(const Vector<Node>& input_pat
 #ifdef USE_GOAL_CONFLICTS
     data_.goal_penalties.before_solve();
 #endif
+    apply_latest_visit_time();
 
     // Get number of resources.
 #ifdef USE_GOAL_CONFLICTS
@@ -1652,11 +2752,21 @@ Pair<Vector<NodeTime>, Cost> AStar::calculate_cost(const Vector<Node>& input_pat
 
     // Reset.
     const auto nb_states = nb_goal_crossings;
-    label_pool_.reset(sizeof(Label) + (nb_states + CHAR_BIT - 1) / CHAR_BIT);
+    label_pool_.reset(sizeof(Label) + get_nb_bitset_words(nb_states) * sizeof(uint64_t));
+#ifdef USE_GOAL_CONFLICTS
+    if (nb_goal_crossings > 0)
+    {
+        make_goal_penalty_byte_costs(goal_penalties, goal_penalty_byte_costs_);
+    }
+#endif
     open_.clear();
     frontier_without_resources_.clear();
+    use_dense_frontier_ = false;
     frontier_with_resources_.clear();
 
+    // Allow the lower bounds used by earlier searches to be evicted.
+    heuristic_.unpin();
+
     // Compute minimum time between each waypoint.
     h_waypoint_to_goal_.resize(waypoints.size());
     h_waypoint_to_goal_.back() = 0;
@@ -1671,6 +2781,18 @@ Pair<Vector<NodeTime>, Cost> AStar::calculate_cost(const Vector<Node>& input_pat
         h_waypoint_to_goal_[w] = std::max(h, t_diff) + h_waypoint_to_goal_[w + 1];
     }
 
+    // Compute the latest times from which the goal is reachable.
+    if (backward_pruning_)
+    {
+        compute_latest_reach_time();
+    }
+
+    // Compute the lower bound on the edge penalties to the goal.
+    if (penalty_heuristic_)
+    {
+        compute_penalty_heuristic();
+    }
+
     // Create the first label.
     Waypoint w = 0;
     h_node_to_waypoint_ = &heuristic_.get_h(waypoints[w].n);
@@ -1741,6 +2863,7 @@ Pair<Vector<NodeTime>, Cost> AStar::calculate_cost(const Vector<Node>& input_pat
                 if (w == static_cast<Waypoint>(waypoints.size() - 1))
                 {
                     open_.push(current);
+                    statistics_.nb_heap_pushes++;
                     break;
                 }
             }
@@ -1753,33 +2876,33 @@ Pair<Vector<NodeTime>, Cost> AStar::calculate_cost(const Vector<Node>& input_pat
             const auto next_t = current->t + 1;
             if (const auto next_n = map_.get_north(current_n);
                 idx < static_cast<Int>(input_path.size()) && next_n == input_path[idx] &&
-                latest_visit_time[next_n] >= next_t && edge_costs.north < std::numeric_limits<Cost>::infinity())
+                latest_visit_time_[next_n] >= next_t && edge_costs.north < std::numeric_limits<Cost>::infinity())
             {
-                generate<is_sipp, has_resources, is_last_segment>(current, next_n, next_t, edge_costs.north, w, waypoint_time);
+                generate<is_sipp, has_resources, is_last_segment, features>(current, next_n, next_t, edge_costs.north, w, waypoint_time);
             }
             if (const auto next_n = map_.get_south(current_n);
                 idx < static_cast<Int>(input_path.size()) && next_n == input_path[idx] &&
-                latest_visit_time[next_n] >= next_t && edge_costs.south < std::numeric_limits<Cost>::infinity())
+                latest_visit_time_[next_n] >= next_t && edge_costs.south < std::numeric_limits<Cost>::infinity())
             {
-                generate<is_sipp, has_resources, is_last_segment>(current, next_n, next_t, edge_costs.south, w, waypoint_time);
+                generate<is_sipp, has_resources, is_last_segment, features>(current, next_n, next_t, edge_costs.south, w, waypoint_time);
             }
             if (const auto next_n = map_.get_east(current_n);
                 idx < static_cast<Int>(input_path.size()) && next_n == input_path[idx] &&
-                latest_visit_time[next_n] >= next_t && edge_costs.east < std::numeric_limits<Cost>::infinity())
+                latest_visit_time_[next_n] >= next_t && edge_costs.east < std::numeric_limits<Cost>::infinity())
             {
-                generate<is_sipp, has_resources, is_last_segment>(current, next_n, next_t, edge_costs.east, w, waypoint_time);
+                generate<is_sipp, has_resources, is_last_segment, features>(current, next_n, next_t, edge_costs.east, w, waypoint_time);
             }
             if (const auto next_n = map_.get_west(current_n);
                 idx < static_cast<Int>(input_path.size()) && next_n == input_path[idx] &&
-                latest_visit_time[next_n] >= next_t && edge_costs.west < std::numeric_limits<Cost>::infinity())
+                latest_visit_time_[next_n] >= next_t && edge_costs.west < std::numeric_limits<Cost>::infinity())
             {
-                generate<is_sipp, has_resources, is_last_segment>(current, next_n, next_t, edge_costs.west, w, waypoint_time);
+                generate<is_sipp, has_resources, is_last_segment, features>(current, next_n, next_t, edge_costs.west, w, waypoint_time);
             }
             if (const auto next_n = map_.get_wait(current_n);
                 idx < static_cast<Int>(input_path.size()) && next_n == input_path[idx] &&
-                latest_visit_time[next_n] >= next_t && edge_costs.wait < std::numeric_limits<Cost>::infinity())
+                latest_visit_time_[next_n] >= next_t && edge_costs.wait < std::numeric_limits<Cost>::infinity())
             {
-                generate<is_sipp, has_resources, is_last_segment>(current, next_n, next_t, edge_costs.wait, w, waypoint_time);
+                generate<is_sipp, has_resources, is_last_segment, features>(current, next_n, next_t, edge_costs.wait, w, waypoint_time);
             }
 
             // Advance to the next node.
@@ -1804,33 +2927,33 @@ Pair<Vector<NodeTime>, Cost> AStar::calculate_cost(const Vector<Node>& input_pat
             const auto next_t = current->t + 1;
             if (const auto next_n = map_.get_north(current_n);
                 idx < static_cast<Int>(input_path.size()) && next_n == input_path[idx] &&
-                latest_visit_time[next_n] >= current->t + 1 && edge_costs.north < std::numeric_limits<Cost>::infinity())
+                latest_visit_time_[next_n] >= current->t + 1 && edge_costs.north < std::numeric_limits<Cost>::infinity())
             {
-                generate_last_segment<has_resources, is_sipp>(current, next_n, next_t, edge_costs.north);
+                generate_last_segment<has_resources, is_sipp, features>(current, next_n, next_t, edge_costs.north);
             }
             if (const auto next_n = map_.get_south(current_n);
                 idx < static_cast<Int>(input_path.size()) && next_n == input_path[idx] &&
-                latest_visit_time[next_n] >= current->t + 1 && edge_costs.south < std::numeric_limits<Cost>::infinity())
+                latest_visit_time_[next_n] >= current->t + 1 && edge_costs.south < std::numeric_limits<Cost>::infinity())
             {
-                generate_last_segment<has_resources, is_sipp>(current, next_n, next_t, edge_costs.south);
+                generate_last_segment<has_resources, is_sipp, features>(current, next_n, next_t, edge_costs.south);
             }
             if (const auto next_n = map_.get_east(current_n);
                 idx < static_cast<Int>(input_path.size()) && next_n == input_path[idx] &&
-                latest_visit_time[next_n] >= current->t + 1 && edge_costs.east < std::numeric_limits<Cost>::infinity())
+                latest_visit_time_[next_n] >= current->t + 1 && edge_costs.east < std::numeric_limits<Cost>::infinity())
             {
-                generate_last_segment<has_resources, is_sipp>(current, next_n, next_t, edge_costs.east);
+                generate_last_segment<has_resources, is_sipp, features>(current, next_n, next_t, edge_costs.east);
             }
             if (const auto next_n = map_.get_west(current_n);
                 idx < static_cast<Int>(input_path.size()) && next_n == input_path[idx] &&
-                latest_visit_time[next_n] >= current->t + 1 && edge_costs.west < std::numeric_limits<Cost>::infinity())
+                latest_visit_time_[next_n] >= current->t + 1 && edge_costs.west < std::numeric_limits<Cost>::infinity())
             {
-                generate_last_segment<has_resources, is_sipp>(current, next_n, next_t, edge_costs.west);
+                generate_last_segment<has_resources, is_sipp, features>(current, next_n, next_t, edge_costs.west);
             }
             if (const auto next_n = map_.get_wait(current_n);
                 idx < static_cast<Int>(input_path.size()) && next_n == input_path[idx] &&
-                latest_visit_time[next_n] >= current->t + 1 && edge_costs.wait < std::numeric_limits<Cost>::infinity())
+                latest_visit_time_[next_n] >= current->t + 1 && edge_costs.wait < std::numeric_limits<Cost>::infinity())
             {
-                generate_last_segment<has_resources, is_sipp>(current, next_n, next_t, edge_costs.wait);
+                generate_last_segment<has_resources, is_sipp, features>(current, next_n, next_t, edge_costs.wait);
             }
 
             // Generate to the end.
@@ -1873,7 +2996,7 @@ Pair<Vector<NodeTime>, Cost> AStar::calculate_cost(const Vector<Node>& input_pat
 #endif
 
             // Check.
-            debug_assert(isLT(path_cost, 0));
+            debug_assert(path_cost < cost_threshold_);
             debug_assert(earliest_goal_time <= current->t && current->t <= latest_goal_time);
 
             // Finish.
@@ -24,6 +24,7 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Coordinates.h"
 #include "Map.h"
 #include "LabelPool.h"
+#include "DenseFrontier.h"
 #include "ReservationTable.h"
 #include "PriorityQueue.h"
 #include "Penalties.h"
@@ -34,6 +35,11 @@ Author: Edward Lam <ed@ed-lam.com>
 template <class T, std::size_t N>
 using SmallVector = boost::container::small_vector<T, N>;
 
+// Number of children of each element in the priority queue of the main search
+#ifndef ASTAR_PRIORITY_QUEUE_ARITY
+#define ASTAR_PRIORITY_QUEUE_ARITY 4
+#endif
+
 namespace TruffleHog
 {
 
@@ -58,7 +64,7 @@ class AStar
             };
         };
 #ifdef USE_RESERVATION_TABLE
-        Int reserves;
+        float reserves;
 #endif
         Int pqueue_index;
         std::byte state_[0];
@@ -75,26 +81,40 @@ class AStar
 #ifdef USE_RESERVATION_TABLE
         ReservationTable reservation_table_;
 
-        LabelCompare(const Int map_size) : reservation_table_(map_size) {}
+        LabelCompare(const Map& map) : reservation_table_(map) {}
 #endif
 
-        inline bool operator()(const Label* const a, const Label* const b) const
+        // Weight of the lower bound in the order of the labels. Weights above 1 expand the labels closer to the goal
+        // first and find a path whose cost excluding the offset is within the weight of the optimum.
+        Cost focal_weight_ = 1;
+
+        // The f value with the weighted lower bound is stored in the priority queue
+        using Key = Cost;
+        inline Key key(const Label* const label) const
+        {
+            return label->f + (focal_weight_ - 1) * (label->f - label->g);
+        }
+
+        inline bool operator()(const Key a_f, const Label* const a, const Key b_f, const Label* const b) const
         {
-            // Prefer smallest f (shorter path) and break ties with fewest visits to reserved vertices
-            // and then largest g (i.e., smallest h for the given f).
+            // Prefer smallest f (shorter path) and break ties with the smallest weight of the reserved vertices and
+            // edges in conflict with the path and then largest g (i.e., smallest h for the given f). The labels are
+            // only read to break ties.
+            if (a_f != b_f)
+            {
+                return a_f < b_f;
+            }
 #ifdef USE_RESERVATION_TABLE
-            return (a->f <  b->f) ||
-                   (a->f == b->f && a->reserves <  b->reserves) ||
-                   (a->f == b->f && a->reserves == b->reserves && a->g > b->g);
+            return (a->reserves <  b->reserves) ||
+                   (a->reserves == b->reserves && a->g > b->g);
 #else
-            return (a->f <  b->f) ||
-                   (a->f == b->f && a->g > b->g);
+            return a->g > b->g;
 #endif
         }
     };
 
     // Priority queue holding labels
-    class AStarPriorityQueue : public PriorityQueue<Label, LabelCompare>
+    class AStarPriorityQueue : public PriorityQueue<Label, LabelCompare, ASTAR_PRIORITY_QUEUE_ARITY>
     {
         friend class AStar;
 
@@ -112,14 +132,14 @@ class AStar
         {
             for (Int pqueue_index = 0; pqueue_index < size_; ++pqueue_index)
             {
-                debug_assert(elts_[pqueue_index]->pqueue_index == pqueue_index);
+                debug_assert(elts_[pqueue_index].label->pqueue_index == pqueue_index);
             }
         }
         void check_label(const Label* const label)
         {
             debug_assert(label &&
                          (-1 == label->pqueue_index ||
-                          (label->pqueue_index < size_ && elts_[label->pqueue_index] == label)));
+                          (label->pqueue_index < size_ && elts_[label->pqueue_index].label == label)));
         }
 #endif
 
@@ -134,11 +154,13 @@ class AStar
         void decrease_key(Label* label)
         {
             debug_assert(contains(label));
+            update_key(label->pqueue_index);
             heapify_up(label->pqueue_index);
         }
         void increase_key(Label* label)
         {
             debug_assert(contains(label));
+            update_key(label->pqueue_index);
             heapify_down(label->pqueue_index);
         }
 
@@ -147,12 +169,61 @@ class AStar
         inline bool contains(Label* label) const
         {
             const auto index = label->pqueue_index;
-            return index < size_ && label == elts_[index];
+            return index < size_ && label == elts_[index].label;
         }
 #endif
     };
 
   public:
+    struct Statistics
+    {
+        size_t nb_labels_generated;     // Labels checked for dominance
+        size_t nb_labels_dominated;     // Labels discarded by dominance
+        size_t nb_labels_expanded;      // Labels popped from the priority queue
+        size_t nb_heap_pushes;          // Labels pushed into the priority queue
+        size_t nb_penalty_lookups;      // Lookups of the edge penalties or intervals out of a node
+        size_t nb_tail_shortcuts;       // Paths closed along the lower bounds after the penalty horizon
+        size_t nb_macro_waits;          // Labels waiting over more than one time step without penalties
+        size_t nb_minimal_solves;       // Runs solved by the kernel specialised for inputs without any feature
+        double preprocess_seconds;      // Time in preprocess_input()
+        double before_solve_seconds;    // Time in before_solve()
+        double solve_seconds;           // Time in the search
+    };
+
+#ifdef USE_ASTAR_SOLUTION_CACHING
+    // Inputs of a previous run that can change its optimal path, keeping only the edge penalties read by the search
+    // and the nodes whose latest visit time is earlier than in the map
+    struct CachedData
+    {
+        bool valid = false;
+        Vector<NodeTime> waypoints;
+        Time earliest_goal_time = 0;
+        Time latest_goal_time = 0;
+        Cost cost_offset = 0;
+        Vector<Pair<NodeTime, EdgeCosts>> used_edge_penalties;
+        Vector<Pair<Node, Time>> latest_visit_time;
+        Vector<Cost> finish_time_penalties;
+#ifdef USE_GOAL_CONFLICTS
+        Vector<GoalPenalties::GoalPenalty> goal_penalties;
+#endif
+    };
+#endif
+
+    // Preprocessed inputs of a run that only change with the waypoints, the goal times and the blocked nodes of the
+    // branching decisions. The caller keeps one for each agent so that repricing at the same node reuses them.
+    struct WaypointCache
+    {
+        bool valid = false;
+        Node goal = 0;
+        Vector<NodeTime> waypoints;
+        Time latest_goal_time = 0;
+        Vector<Pair<Node, Time>> latest_visit_time;
+        bool backward_pruning = false;
+        bool feasible = false;                  // Indicates if the waypoints can be visited in time
+        Vector<IntCost> h_waypoint_to_goal;     // Minimum time from each waypoint to the goal
+        Vector<Time> latest_reach_time;         // Latest time at each node to still reach the goal if pruning backward
+    };
+
     struct Data
     {
         // Waypoints
@@ -164,15 +235,20 @@ class AStar
 
         // Costs
         Cost cost_offset;
-        Vector<Time> latest_visit_time;
+        Vector<Pair<Node, Time>> latest_visit_time;    // Nodes whose latest visit time is earlier than in the map
         EdgePenalties edge_penalties;
         FinishTimePenalties finish_time_penalties;
 #ifdef USE_GOAL_CONFLICTS
         GoalPenalties goal_penalties;
 #endif
 
+#ifdef USE_ASTAR_SOLUTION_CACHING
         // Check if any cost is better
-        bool can_be_better(const Data& previous_data);
+        bool can_be_better(const CachedData& previous_data) const;
+
+        // Bound the decrease in the cost of the optimal path since a previous run
+        Cost max_improvement(const CachedData& previous_data) const;
+#endif
     };
 
   private:
@@ -186,13 +262,36 @@ class AStar
     const Vector<IntCost>* h_node_to_waypoint_;
     Vector<IntCost> h_waypoint_to_goal_;
     Heuristic heuristic_;
+    bool backward_pruning_;               // Prune labels that cannot reach the goal in time on the blocked nodes
+    Vector<Time> latest_reach_time_;      // Latest time at each node from which the goal can still be reached
+    WaypointCache* waypoint_cache_;       // Preprocessed waypoints of the agent of the run kept by the caller, or null
+    bool penalty_heuristic_;              // Add a lower bound on the edge penalties to the goal to the heuristic
+    Vector<Cost> h_penalty_;              // Lower bound on the edge penalties from each node to the goal
+    Cost cost_threshold_;                 // Labels whose f value is at least this are pruned
+    Cost h_time_weight_;                  // Cost of a time step in the heuristic (0 in Farkas pricing)
+    Vector<Time> latest_visit_time_;      // Latest visit time of each node in the map with the restrictions of the run
+    Vector<Node> restricted_nodes_;       // Nodes whose latest visit time is restricted in latest_visit_time_
+    size_t label_budget_;                 // Maximum number of labels expanded in a run, or 0 for no limit
+    bool truncated_;                      // Indicates if the last run stopped early after exhausting the budget
+    Cost min_pruned_f_;                   // Lowest f value of the labels pruned by the cost threshold in the last run
     LabelPool label_pool_;
     AStarPriorityQueue open_;
     HashTable<NodeTime, Label*> frontier_without_resources_;
+    DenseFrontier<Label*> dense_frontier_;    // Frontier without resources when it fits in the memory budget
+    size_t frontier_memory_budget_;           // Maximum bytes of the dense frontier (0 to always use the hash table)
+    bool use_dense_frontier_;                 // Indicates if the run stores the frontier in the dense array
     HashTable<NodeTime, SmallVector<Label*, 4>> frontier_with_resources_;
+    Vector<const Label*> found_goal_labels_;
+    Time penalty_horizon_;                // Earliest time from which no edge or finish time penalty remains
+    bool macro_waits_;                    // Indicates if the run waits over times without penalties in one label
+    Vector<Node> tail_;                   // Nodes of the path closed along the lower bounds after the horizon
+#ifdef USE_GOAL_CONFLICTS
+    Vector<Cost> goal_penalty_byte_costs_;    // Cost of the goal penalties in every bit pattern of each state byte
+#endif
 #ifdef DEBUG
     size_t nb_labels_;
 #endif
+    Statistics statistics_;
 
     // SIPP data structures
     SIPPIntervals sipp_intervals_;
@@ -214,15 +313,77 @@ class AStar
 #endif
     auto& data() { return data_; }
     const auto& data() const { return data_; }
+    inline const auto& label_pool() const { return label_pool_; }
+    inline void configure_label_pool(const size_t block_size, const bool huge_pages)
+    {
+        label_pool_.configure(block_size, huge_pages);
+    }
+    inline void set_backward_pruning(const bool on) { backward_pruning_ = on; }
+    inline void set_penalty_heuristic(const bool on) { penalty_heuristic_ = on; }
+    inline void set_cost_threshold(const Cost threshold) { cost_threshold_ = threshold; }
+    inline void set_label_budget(const size_t budget) { label_budget_ = budget; }
+    inline void set_focal_weight(const Cost weight) { debug_assert(weight >= 1); open_.cmp().focal_weight_ = weight; }
+    inline void set_frontier_memory_budget(const size_t nb_bytes) { frontier_memory_budget_ = nb_bytes; }
+    inline void set_waypoint_cache(WaypointCache* cache) { waypoint_cache_ = cache; }
+    inline auto truncated() const { return truncated_; }
+    inline auto min_pruned_cost() const { return min_pruned_f_; }
+    inline const auto& statistics() const { return statistics_; }
+    inline void reset_statistics() { statistics_ = Statistics{}; }
 
     // Solve
-    inline void compute_h(const Node goal) { heuristic_.get_h(goal); }
+    inline void compute_h(const Node goal)
+    {
+        heuristic_.unpin();
+        heuristic_.get_h(goal);
+    }
+    inline const Vector<IntCost>& get_h(const Node goal) { return heuristic_.get_h(goal); }
+    inline auto heuristic_memory_budget() const { return heuristic_.memory_budget(); }
+    inline auto heuristic_memory_used() const { return heuristic_.memory_used(); }
+    inline void set_heuristic_memory_budget(const size_t memory_budget)
+    {
+        heuristic_.set_memory_budget(memory_budget);
+    }
+    inline const auto& heuristic_cache_directory() const { return heuristic_.cache_directory(); }
+    inline void set_heuristic_cache_directory(const std::filesystem::path& cache_directory)
+    {
+        heuristic_.set_cache_directory(cache_directory);
+    }
+    inline const auto& heuristic_shared_cache() const { return heuristic_.shared_cache(); }
+    inline void set_heuristic_shared_cache(const std::shared_ptr<HeuristicCache>& shared_cache)
+    {
+        heuristic_.set_shared_cache(shared_cache);
+    }
     void preprocess_input();
     void before_solve();
     template<bool is_farkas>
     Pair<Vector<NodeTime>, Cost> solve();
     template<bool is_farkas>
     Pair<Vector<NodeTime>, Cost> solve_sipp();
+    template<bool is_farkas>
+    Vector<Pair<Vector<NodeTime>, Cost>> solve_k(const Int k);
+    template<bool is_farkas>
+    Vector<Pair<Vector<NodeTime>, Cost>> solve_sipp_k(const Int k);
+
+    // Solve into the first slots of a buffer kept by the caller and return the number of paths found. The slots after
+    // them are kept for later runs so that the paths reuse their memory.
+    template<bool is_farkas>
+    Int solve_k(const Int k, Vector<Pair<Vector<NodeTime>, Cost>>& outputs);
+    template<bool is_farkas>
+    Int solve_sipp_k(const Int k, Vector<Pair<Vector<NodeTime>, Cost>>& outputs);
+    template<bool is_farkas>
+    Cost calculate_path_cost(const Edge* const path, const Time path_length) const;
+#ifdef USE_ASTAR_SOLUTION_CACHING
+    void cache_data(CachedData& cache) const;
+#endif
+
+    // Find the times at which no path with a reduced cost below a gap can visit the nodes. Must be called after
+    // preprocess_input(). Returns the latest goal time of these paths, or -1 if there is no such path, and outputs
+    // the latest visit time of the nodes that are restricted further than by the latest goal time.
+    Time compute_reduced_cost_fixing(const Cost gap, Vector<Pair<Node, Time>>& latest_visit_time);
+
+    // Get a lower bound on the finish time of every path from a start to a goal through some waypoints. Every edge
+    // costs at least one and the penalties are non-negative so this also bounds the cost of the paths.
+    Time min_finish_time(const Node start, const Vector<NodeTime>& waypoints, const Node goal);
 
     // Debug
 #ifdef DEBUG
@@ -231,9 +392,50 @@ class AStar
 #endif
 
   private:
+    // Features of an input checked while generating labels. The inputs without any of them are solved by a kernel
+    // whose inner loop skips the checks.
+    using Features = uint8_t;
+    static constexpr Features HAS_WAYPOINTS = 0x01;
+    static constexpr Features HAS_FINISH_TIME_PENALTIES = 0x02;
+    static constexpr Features HAS_LATEST_VISIT_TIME = 0x04;
+    static constexpr Features HAS_PENALTY_HEURISTIC = 0x08;
+    static constexpr Features HAS_BACKWARD_PRUNING = 0x10;
+    static constexpr Features ALL_FEATURES = 0x1F;
+    Features get_features() const;
+
     // Solve
     template<bool is_sipp, bool is_farkas, bool has_resources>
-    Pair<Vector<NodeTime>, Cost> solve();
+    Int solve(const Int k, Vector<Pair<Vector<NodeTime>, Cost>>& outputs);
+    template<bool is_sipp, bool is_farkas, bool has_resources, Features features>
+    Int solve_kernel(const Int k, Vector<Pair<Vector<NodeTime>, Cost>>& outputs);
+
+    // Restrict the latest visit times of the map to the nodes restricted in the input
+    void apply_latest_visit_time();
+
+    // Compute the latest time at each node from which the goal can be reached by the latest goal time
+    void compute_latest_reach_time();
+
+    // Compute the minimum time from each waypoint to the goal and the latest reach times, or reuse them from the
+    // waypoint cache. Returns false if the waypoints cannot be visited in time.
+    bool prepare_waypoints();
+
+    // Compute a lower bound on the edge penalties incurred from each node to the goal
+    void compute_penalty_heuristic();
+    inline Cost get_h_penalty(const Node n) const { return penalty_heuristic_ ? h_penalty_[n] : 0; }
+
+    // Weight of the reservations in conflict with moving from a vertex to another vertex arriving at a time
+#ifdef USE_RESERVATION_TABLE
+    inline float get_reservation_weight(const Node n, const Node next_n, const Time next_t)
+    {
+        auto& restab = reservation_table();
+        auto weight = restab.vertex_weight(NodeTime{next_n, next_t});
+        if (n != next_n)
+        {
+            weight += restab.edge_weight(EdgeTime{next_n, map_.get_direction(next_n, n), next_t - 1});
+        }
+        return weight;
+    }
+#endif
 
     // Create start label
     template<bool has_resources>
@@ -247,9 +449,9 @@ class AStar
                                 const Cost cost,
                                 const Waypoint w,
                                 const Time waypoint_time);
-    template<bool is_sipp, bool has_resources>
+    template<bool is_sipp, bool has_resources, Features features>
     void generate_last_segment(Label* const current, const Node next_n, const Time next_t, const Cost cost);
-    template<bool is_sipp, bool has_resources, bool is_last_segment, class... WaypointArgs>
+    template<bool is_sipp, bool has_resources, bool is_last_segment, Features features, class... WaypointArgs>
     inline void generate(Label* const current,
                          const Node next_n,
                          const Time next_t,
@@ -258,7 +460,7 @@ class AStar
     {
         if constexpr (is_last_segment)
         {
-            generate_last_segment<is_sipp, has_resources>(current, next_n, next_t, cost, waypoint_args...);
+            generate_last_segment<is_sipp, has_resources, features>(current, next_n, next_t, cost, waypoint_args...);
         }
         else
         {
@@ -267,13 +469,15 @@ class AStar
     }
 
     // Expand next - time-expanded A*
-    template<IntCost default_cost, bool has_resources, bool is_last_segment, class... WaypointArgs>
+    template<bool is_last_segment, Features features, class... WaypointArgs>
+    Time get_macro_wait_end(const Label* const current, WaypointArgs... waypoint_args) const;
+    template<IntCost default_cost, bool has_resources, bool is_last_segment, Features features, class... WaypointArgs>
     void generate_neighbours(Label* const current, WaypointArgs... waypoint_args);
 
     // Expand next - SIPP
-    template<IntCost default_cost, bool has_resources, bool is_last_segment, class... WaypointArgs>
+    template<IntCost default_cost, bool has_resources, bool is_last_segment, Features features, class... WaypointArgs>
     void generate_neighbours_sipp(Label* const current, WaypointArgs... waypoint_args);
-    template<IntCost default_cost, bool has_resources, bool is_last_segment, class... WaypointArgs>
+    template<IntCost default_cost, bool has_resources, bool is_last_segment, Features features, class... WaypointArgs>
     void generate_neighbours_one_interval_sipp(Label* const current,
                                                const Time wait_start,
                                                const Time wait_end,
@@ -289,6 +493,16 @@ class AStar
     // Create end label
     void generate_end(Label* const current);
 
+    // Close the path of a label along the lower bounds to the goal after the penalty horizon. Returns false if the
+    // path is blocked or crosses the goal of another agent.
+    template<IntCost default_cost>
+    bool generate_tail(Label* const current);
+
+    // Prefetch the data read to expand the label at the top of the priority queue
+#ifdef USE_ASTAR_PREFETCH
+    void prefetch_next_expansion();
+#endif
+
     // Check if a label is dominated by an existing label
     template<bool has_resources>
     AStar::Label* dominated(Label* const new_label);
@@ -0,0 +1,134 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#ifndef TRUFFLEHOG_BUCKETQUEUE_H
+#define TRUFFLEHOG_BUCKETQUEUE_H
+
+#include "Includes.h"
+
+namespace TruffleHog
+{
+
+// Priority queue over labels with non-negative integer keys that are never smaller than the key of the last popped
+// label (e.g., Dijkstra's algorithm with integer edge costs). Labels are stored in one bucket per key, so push and pop
+// are constant time apart from skipping empty buckets. Labels with the same key are popped in reverse order of
+// insertion.
+template<class Label, class Key>
+class BucketQueue
+{
+  protected:
+    Key key_;
+    Vector<Vector<Label*>> buckets_;
+    mutable IntCost min_key_;
+    IntCost max_key_;
+    Int size_;
+
+  public:
+    // Constructors
+    template<class ...Args>
+    BucketQueue(Args... args) :
+        key_(args...),
+        buckets_(),
+        min_key_(0),
+        max_key_(-1),
+        size_(0)
+    {
+        buckets_.resize(64);
+    }
+    BucketQueue(const BucketQueue&) = delete;
+    BucketQueue(BucketQueue&&) = delete;
+    BucketQueue& operator=(const BucketQueue&) = delete;
+    BucketQueue& operator=(BucketQueue&&) = delete;
+    ~BucketQueue() = default;
+
+    // Remove all elements
+    inline void clear()
+    {
+        for (IntCost key = min_key_; key <= max_key_; ++key)
+        {
+            buckets_[key].clear();
+        }
+        min_key_ = 0;
+        max_key_ = -1;
+        size_ = 0;
+    }
+
+    // Add an element
+    void push(Label* label)
+    {
+        const IntCost key = key_(label);
+        debug_assert(key >= 0);
+        debug_assert(key >= min_key_);
+
+        if (key >= static_cast<IntCost>(buckets_.size()))
+        {
+            buckets_.resize(std::max<size_t>(key + 1, buckets_.size() * 2));
+        }
+
+        max_key_ = std::max(max_key_, key);
+        buckets_[key].push_back(label);
+        size_++;
+    }
+
+    // Remove the top element
+    Label* pop()
+    {
+        debug_assert(size_ > 0);
+
+        auto& bucket = buckets_[next_key()];
+        auto label = bucket.back();
+        bucket.pop_back();
+        size_--;
+        return label;
+    }
+
+    // Retrieve the top element without removing it
+    inline Label* top() const
+    {
+        debug_assert(size_ > 0);
+        return buckets_[next_key()].back();
+    }
+
+    // Get the number of elements stored within
+    inline auto size() const
+    {
+        return size_;
+    }
+
+    // Check whether the priority queue is empty
+    inline auto empty() const
+    {
+        return size() == 0;
+    }
+
+  protected:
+    // Move to the first non-empty bucket
+    inline IntCost next_key() const
+    {
+        while (buckets_[min_key_].empty())
+        {
+            ++min_key_;
+        }
+        return min_key_;
+    }
+};
+
+}
+
+#endif
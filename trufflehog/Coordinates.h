@@ -117,6 +117,17 @@ inline bool operator!=(const EdgeTime a, const EdgeTime b)
     return !(a == b);
 }
 
+// Hash of a packed key. The Swiss table mixes every hash with a multiplication, so the keys are hashed to themselves.
+template<class T>
+inline std::size_t hash_packed_key(const T x) noexcept
+{
+#ifdef USE_SWISS_TABLE
+    return static_cast<std::size_t>(x);
+#else
+    return robin_hood::hash<T>{}(x);
+#endif
+}
+
 }
 
 namespace robin_hood
@@ -127,7 +138,7 @@ struct hash<TruffleHog::Edge>
 {
     inline std::size_t operator()(const TruffleHog::Edge e) const noexcept
     {
-        return robin_hood::hash<uint32_t>{}(e.id);
+        return TruffleHog::hash_packed_key(e.id);
     }
 };
 
@@ -136,7 +147,7 @@ struct hash<TruffleHog::NodeTime>
 {
     inline std::size_t operator()(const TruffleHog::NodeTime nt) const noexcept
     {
-        return robin_hood::hash<uint64_t>{}(nt.nt);
+        return TruffleHog::hash_packed_key(nt.nt);
     }
 };
 
@@ -145,7 +156,7 @@ struct hash<TruffleHog::EdgeTime>
 {
     inline std::size_t operator()(const TruffleHog::EdgeTime et) const noexcept
     {
-        return robin_hood::hash<uint64_t>{}(et.id);
+        return TruffleHog::hash_packed_key(et.id);
     }
 };
 
@@ -0,0 +1,128 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#ifndef TRUFFLEHOG_DENSEFRONTIER_H
+#define TRUFFLEHOG_DENSEFRONTIER_H
+
+#include "Includes.h"
+#include "Coordinates.h"
+#include "Map.h"
+
+namespace TruffleHog
+{
+
+// Map from the node-times before a time horizon to a value, stored in an array indexed by time and passable node.
+// Every entry is stamped with the generation in which it was written, so clearing only starts a new generation and the
+// array is never refilled between runs. The array is kept at its largest size for later runs.
+template<class T>
+class DenseFrontier
+{
+    Vector<T> values_;
+    Vector<uint32_t> stamps_;
+    uint32_t generation_;
+    const Map* map_;
+    Node nb_nodes_;
+    Time horizon_;
+
+  public:
+    // Constructors
+    DenseFrontier() :
+        values_(),
+        stamps_(),
+        generation_(1),
+        map_(nullptr),
+        nb_nodes_(0),
+        horizon_(0)
+    {
+    }
+    DenseFrontier(const DenseFrontier&) = delete;
+    DenseFrontier(DenseFrontier&&) = delete;
+    DenseFrontier& operator=(const DenseFrontier&) = delete;
+    DenseFrontier& operator=(DenseFrontier&&) = delete;
+    ~DenseFrontier() = default;
+
+    // Memory needed to store the node-times of a map before a time horizon
+    static inline size_t nb_bytes(const Map& map, const Time horizon)
+    {
+        return static_cast<size_t>(map.nb_passable()) * horizon * (sizeof(T) + sizeof(uint32_t));
+    }
+
+    // Remove all entries and cover the node-times before a time horizon
+    void reset(const Map& map, const Time horizon)
+    {
+        // Forget the stamps if the layout changes or the generation wraps around.
+        if (&map != map_ || map.nb_passable() != nb_nodes_ || ++generation_ == 0)
+        {
+            std::fill(stamps_.begin(), stamps_.end(), 0);
+            generation_ = 1;
+            map_ = &map;
+            nb_nodes_ = map.nb_passable();
+        }
+        horizon_ = horizon;
+
+        // Grow the arrays.
+        if (const auto size = static_cast<size_t>(nb_nodes_) * horizon_; size > stamps_.size())
+        {
+            values_.resize(size);
+            stamps_.resize(size, 0);
+        }
+    }
+
+    // Check if a node-time is before the time horizon
+    inline bool covers(const NodeTime nt) const
+    {
+        return nt.t < horizon_;
+    }
+
+    // Prefetch the entry of a node-time for writing
+    inline void prefetch(const NodeTime nt) const
+    {
+        if (covers(nt))
+        {
+            const auto idx = index(nt);
+            __builtin_prefetch(&stamps_[idx], 1);
+            __builtin_prefetch(&values_[idx], 1);
+        }
+    }
+
+    // Insert a value if the node-time has no entry. Returns the entry of the node-time and true if it is inserted.
+    inline Pair<T*, bool> try_emplace(const NodeTime nt, const T& value)
+    {
+        debug_assert(covers(nt));
+        const auto idx = index(nt);
+        if (stamps_[idx] == generation_)
+        {
+            return {&values_[idx], false};
+        }
+        stamps_[idx] = generation_;
+        values_[idx] = value;
+        return {&values_[idx], true};
+    }
+
+  private:
+    // Position of a node-time in the arrays
+    inline size_t index(const NodeTime nt) const
+    {
+        return static_cast<size_t>(nt.t) * nb_nodes_ + map_->passable_index(nt.n);
+    }
+};
+
+}
+
+#endif
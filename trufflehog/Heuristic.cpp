@@ -20,8 +20,13 @@ Author: Edward Lam <ed@ed-lam.com>
 //#define PRINT_DEBUG
 
 #include "Heuristic.h"
+#include <atomic>
+#include <fstream>
+#include <thread>
+#include <unistd.h>
 
 #define MAX_PATH_LENGTH_FACTOR 2
+#define CACHE_FILE_MAGIC (0x3130474846555254ULL) // "TRUFHG01"
 
 namespace TruffleHog
 {
@@ -30,9 +35,20 @@ Heuristic::Heuristic(const Map& map) :
     map_(map),
     h_(),
     max_path_length_(-1),
+    memory_budget_(0),
+    memory_used_(0),
+    clock_(0),
+    pinned_since_(0),
+    compressed_h_(),
+    component_(),
+    component_nodes_(),
+    cache_directory_(),
+    map_hash_(0),
+    shared_cache_(),
     label_pool_(),
     open_(),
-    visited_(map_.size())
+    visited_(map_.nb_passable(), 0),
+    generation_(0)
 #ifdef DEBUG
   , nb_labels_(0)
 #endif
@@ -42,10 +58,11 @@ Heuristic::Heuristic(const Map& map) :
 
 bool Heuristic::dominated(const Node n)
 {
-    if (!visited_[n])
+    const auto idx = map_.passable_index(n);
+    if (visited_[idx] != generation_)
     {
         // Not yet visited.
-        visited_[n] = true;
+        visited_[idx] = generation_;
         return false;
     }
     else
@@ -117,23 +134,12 @@ void Heuristic::generate(const Label* const current, const Node n)
 
 void Heuristic::generate_neighbours(const Label* const current)
 {
-    // Expand in four directions.
+    // Expand in the four move directions to passable nodes.
     const auto current_n = current->n;
-    if (const auto next_n = map_.get_north(current_n); map_[next_n])
+    for (uint8_t mask = map_.neighbours(current_n) & 0b1111; mask; mask &= mask - 1)
     {
-        generate(current, next_n);
-    }
-    if (const auto next_n = map_.get_south(current_n); map_[next_n])
-    {
-        generate(current, next_n);
-    }
-    if (const auto next_n = map_.get_east(current_n); map_[next_n])
-    {
-        generate(current, next_n);
-    }
-    if (const auto next_n = map_.get_west(current_n); map_[next_n])
-    {
-        generate(current, next_n);
+        const auto d = __builtin_ctz(mask);
+        generate(current, map_.get_neighbour(current_n, d));
     }
 }
 
@@ -142,7 +148,11 @@ void Heuristic::search(const Node goal, Vector<IntCost>& h)
     // Reset.
     label_pool_.reset(sizeof(Label));
     open_.clear();
-    std::fill(visited_.begin(), visited_.end(), false);
+    if (++generation_ == 0)
+    {
+        std::fill(visited_.begin(), visited_.end(), 0);
+        generation_ = 1;
+    }
 
     // Solve.
     debug_assert(h.empty());
@@ -171,14 +181,383 @@ void Heuristic::search(const Node goal, Vector<IntCost>& h)
     debugln("=======================================");
 }
 
-const Vector<IntCost>& Heuristic::get_h(const Node goal)
+void Heuristic::set_cache_directory(const std::filesystem::path& cache_directory)
+{
+    // Store the directory.
+    cache_directory_ = cache_directory;
+
+    // Hash the map (FNV-1a).
+    map_hash_ = 0xcbf29ce484222325ULL;
+    const auto hash = [this](const uint64_t x)
+    {
+        map_hash_ ^= x;
+        map_hash_ *= 0x100000001b3ULL;
+    };
+    hash(map_.width());
+    hash(map_.height());
+    for (Node n = 0; n < map_.size(); ++n)
+    {
+        hash(map_[n]);
+    }
+}
+
+std::filesystem::path Heuristic::cache_path(const Node goal) const
+{
+    return cache_directory_ / fmt::format("{:016x}-{}.h", map_hash_, goal);
+}
+
+bool Heuristic::read_cache(const Node goal, Vector<IntCost>& h) const
+{
+    // Open the file.
+    debug_assert(h.empty());
+    std::ifstream file(cache_path(goal), std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+
+    // Check the header.
+    uint64_t magic = 0;
+    Node size = 0;
+    file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    file.read(reinterpret_cast<char*>(&size), sizeof(size));
+    if (!file || magic != CACHE_FILE_MAGIC || size != map_.size())
+    {
+        return false;
+    }
+
+    // Read the lower bounds.
+    h.resize(size);
+    file.read(reinterpret_cast<char*>(h.data()), sizeof(IntCost) * size);
+    if (!file)
+    {
+        h.clear();
+        return false;
+    }
+
+    // Done.
+    debugln("Read h values of goal {} from cache", goal);
+    return true;
+}
+
+void Heuristic::write_cache(const Node goal, const Vector<IntCost>& h) const
+{
+    // Create the directory.
+    std::error_code ec;
+    std::filesystem::create_directories(cache_directory_, ec);
+    if (ec)
+    {
+        return;
+    }
+
+    // Write to a temporary file and then move it so that other processes never read an incomplete file. The name of
+    // the temporary file is unique to the process, the thread and the write since several solvers in one process can
+    // write the same goal at once.
+    static std::atomic<uint64_t> nb_writes = 0;
+    const auto path = cache_path(goal);
+    auto tmp_path = path;
+    tmp_path += fmt::format(".{}.{}.{}.tmp",
+                            getpid(),
+                            std::hash<std::thread::id>{}(std::this_thread::get_id()),
+                            nb_writes.fetch_add(1, std::memory_order_relaxed));
+    {
+        std::ofstream file(tmp_path, std::ios::binary);
+        const uint64_t magic = CACHE_FILE_MAGIC;
+        const Node size = h.size();
+        file.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
+        file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        file.write(reinterpret_cast<const char*>(h.data()), sizeof(IntCost) * size);
+        if (!file)
+        {
+            file.close();
+            std::filesystem::remove(tmp_path, ec);
+            return;
+        }
+    }
+    std::filesystem::rename(tmp_path, path, ec);
+    if (ec)
+    {
+        std::filesystem::remove(tmp_path, ec);
+    }
+}
+
+#ifdef USE_BITSET_BFS_HEURISTIC
+// Get a word of a bitset shifted up by k bits
+static inline uint64_t get_shifted_word(const Vector<uint64_t>& bits, const Int w, const Int k)
+{
+    const Int nb_words = bits.size();
+    if (k >= 0)
+    {
+        const auto q = k / 64;
+        const auto r = k % 64;
+        const auto hi = w - q >= 0 ? bits[w - q] : 0;
+        const auto lo = r && w - q - 1 >= 0 ? bits[w - q - 1] >> (64 - r) : 0;
+        return (hi << r) | lo;
+    }
+    else
+    {
+        const auto q = -k / 64;
+        const auto r = -k % 64;
+        const auto lo = w + q < nb_words ? bits[w + q] : 0;
+        const auto hi = r && w + q + 1 < nb_words ? bits[w + q + 1] << (64 - r) : 0;
+        return (lo >> r) | hi;
+    }
+}
+
+void Heuristic::search_bfs(const Node goal, Vector<IntCost>& h)
+{
+    // Make bitset of passable nodes. The map is surrounded by obstacles so shifting by one bit never wraps
+    // around to a passable node in another row.
+    const Int nb_words = (map_.size() + 63) / 64;
+    if (passable_bits_.empty())
+    {
+        passable_bits_.resize(nb_words);
+        for (Node n = 0; n < map_.size(); ++n)
+            if (map_[n])
+            {
+                passable_bits_[n / 64] |= uint64_t{1} << (n % 64);
+            }
+        visited_bits_.resize(nb_words);
+        frontier_bits_.resize(nb_words);
+        next_bits_.resize(nb_words);
+    }
+
+    // Reset.
+    std::fill(visited_bits_.begin(), visited_bits_.end(), 0);
+    std::fill(frontier_bits_.begin(), frontier_bits_.end(), 0);
+
+    // Start at the goal.
+    debug_assert(h.empty());
+    h.resize(map_.size());
+    visited_bits_[goal / 64] |= uint64_t{1} << (goal % 64);
+    frontier_bits_[goal / 64] |= uint64_t{1} << (goal % 64);
+
+    // Expand the frontier one level at a time. Only the words near the frontier can change.
+    const Int width = map_.width();
+    const Int reach = width / 64 + 2;
+    Int lo = goal / 64;
+    Int hi = lo + 1;
+    for (IntCost g = 1; lo < hi; ++g)
+    {
+        // Find the unvisited neighbours of the frontier.
+        Int next_lo = nb_words;
+        Int next_hi = 0;
+        for (Int w = std::max(lo - reach, 0), end = std::min(hi + reach, nb_words); w < end; ++w)
+        {
+            const auto neighbours = get_shifted_word(frontier_bits_, w, 1) |
+                                    get_shifted_word(frontier_bits_, w, -1) |
+                                    get_shifted_word(frontier_bits_, w, width) |
+                                    get_shifted_word(frontier_bits_, w, -width);
+            const auto next = neighbours & passable_bits_[w] & ~visited_bits_[w];
+            next_bits_[w] = next;
+            if (next)
+            {
+                next_lo = std::min(next_lo, w);
+                next_hi = w + 1;
+            }
+        }
+
+        // Store h and move to the next frontier.
+        std::fill(frontier_bits_.begin() + lo, frontier_bits_.begin() + hi, 0);
+        for (Int w = next_lo; w < next_hi; ++w)
+        {
+            auto next = next_bits_[w];
+            frontier_bits_[w] = next;
+            visited_bits_[w] |= next;
+            while (next)
+            {
+                const Node n = w * 64 + __builtin_ctzll(next);
+                h[n] = g;
+                next &= next - 1;
+            }
+        }
+        lo = next_lo;
+        hi = next_hi;
+    }
+}
+#endif
+
+void Heuristic::set_memory_budget(const size_t memory_budget)
+{
+    memory_budget_ = memory_budget;
+    evict();
+}
+
+void Heuristic::find_components()
+{
+    // Label the connected components of the passable nodes by breadth-first search.
+    component_.assign(map_.size(), -1);
+    component_nodes_.clear();
+    for (Node start = 0; start < map_.size(); ++start)
+        if (map_[start] && component_[start] < 0)
+        {
+            const Int c = component_nodes_.size();
+            auto& nodes = component_nodes_.emplace_back();
+            component_[start] = c;
+            nodes.push_back(start);
+            for (size_t idx = 0; idx < nodes.size(); ++idx)
+            {
+                const auto n = nodes[idx];
+                for (uint8_t mask = map_.neighbours(n) & 0b1111; mask; mask &= mask - 1)
+                {
+                    const auto next_n = map_.get_neighbour(n, __builtin_ctz(mask));
+                    if (component_[next_n] < 0)
+                    {
+                        component_[next_n] = c;
+                        nodes.push_back(next_n);
+                    }
+                }
+            }
+            nodes.shrink_to_fit();
+        }
+}
+
+void Heuristic::compress(const Node goal, const Vector<IntCost>& h)
+{
+    // Find the components.
+    if (component_.empty())
+    {
+        find_components();
+    }
+
+    // Store the lower bounds of the nodes in the component of the goal. The other nodes cannot reach the goal and
+    // have a lower bound of zero.
+    debug_assert(map_[goal]);
+    const auto& nodes = component_nodes_[component_[goal]];
+    auto& [compressed_h, long_h, last_used] = compressed_h_[goal];
+    compressed_h.resize(nodes.size());
+    for (size_t idx = 0; idx < nodes.size(); ++idx)
+    {
+        const auto n = nodes[idx];
+        if (h[n] < std::numeric_limits<uint16_t>::max())
+        {
+            compressed_h[idx] = h[n];
+        }
+        else
+        {
+            compressed_h[idx] = std::numeric_limits<uint16_t>::max();
+            long_h[n] = h[n];
+        }
+    }
+    last_used = clock_;
+    memory_used_ += sizeof(uint16_t) * compressed_h.size() + (sizeof(Node) + sizeof(IntCost)) * long_h.size();
+}
+
+bool Heuristic::decompress(const Node goal, Vector<IntCost>& h)
+{
+    // Find the compressed lower bounds.
+    auto it = compressed_h_.find(goal);
+    if (it == compressed_h_.end())
+    {
+        return false;
+    }
+    auto& [compressed_h, long_h, last_used] = it->second;
+    last_used = clock_;
+
+    // Decompress.
+    const auto& nodes = component_nodes_[component_[goal]];
+    h.assign(map_.size(), 0);
+    for (size_t idx = 0; idx < nodes.size(); ++idx)
+    {
+        const auto n = nodes[idx];
+        h[n] = compressed_h[idx] < std::numeric_limits<uint16_t>::max() ? compressed_h[idx] : long_h.at(n);
+    }
+    return true;
+}
+
+void Heuristic::evict()
+{
+    const size_t h_size = sizeof(IntCost) * map_.size();
+    while (memory_budget_ > 0 && memory_used_ > memory_budget_)
+    {
+        // Evict the least recently used decompressed lower bounds.
+        {
+            auto lru_it = h_.end();
+            for (auto it = h_.begin(); it != h_.end(); ++it)
+                if (it->second.last_used < pinned_since_ &&
+                    (lru_it == h_.end() || it->second.last_used < lru_it->second.last_used))
+                {
+                    lru_it = it;
+                }
+            if (lru_it != h_.end())
+            {
+                debugln("Evicting h values of goal {}", lru_it->first);
+                if (auto it = compressed_h_.find(lru_it->first); it != compressed_h_.end())
+                {
+                    it->second.last_used = std::max(it->second.last_used, lru_it->second.last_used);
+                }
+                h_.erase(lru_it);
+                memory_used_ -= h_size;
+                continue;
+            }
+        }
+
+        // Evict the least recently used compressed lower bounds.
+        {
+            auto lru_it = compressed_h_.end();
+            for (auto it = compressed_h_.begin(); it != compressed_h_.end(); ++it)
+                if (it->second.last_used < pinned_since_ &&
+                    (lru_it == compressed_h_.end() || it->second.last_used < lru_it->second.last_used))
+                {
+                    lru_it = it;
+                }
+            if (lru_it != compressed_h_.end())
+            {
+                debugln("Evicting compressed h values of goal {}", lru_it->first);
+                const auto& [compressed_h, long_h, last_used] = lru_it->second;
+                memory_used_ -= sizeof(uint16_t) * compressed_h.size() +
+                                (sizeof(Node) + sizeof(IntCost)) * long_h.size();
+                compressed_h_.erase(lru_it);
+                continue;
+            }
+        }
+
+        // Stop if every lower bound is in use.
+        break;
+    }
+}
+
+void Heuristic::find_or_compute_h(const Node goal, Vector<IntCost>& h)
 {
-    auto& h = h_[goal];
-    if (h.empty())
+    const auto compute = [this, goal](Vector<IntCost>& h)
     {
-        // Compute the h values for this goal.
+#ifdef USE_BITSET_BFS_HEURISTIC
+        search_bfs(goal, h);
+#ifdef DEBUG
+        {
+            Vector<IntCost> dijkstra_h;
+            search(goal, dijkstra_h);
+            debug_assert(h == dijkstra_h);
+        }
+#endif
+#else
         search(goal, h);
+#endif
+    };
+    if (!shared_cache_ || !shared_cache_->find(goal, h))
+    {
+        if (cache_directory_.empty())
+        {
+            compute(h);
+        }
+        else if (!read_cache(goal, h))
+        {
+            compute(h);
+            write_cache(goal, h);
+        }
+        if (shared_cache_)
+        {
+            shared_cache_->insert(goal, h);
+        }
+    }
+}
 
+void Heuristic::add_h(const Node goal, UniquePtr<Vector<IntCost>>&& h_ptr, const uint64_t now, const bool is_new,
+                      const bool within_budget)
+{
+    auto& h = *h_ptr;
+    if (is_new)
+    {
         // Get estimate of longest path length.
         {
             auto it = std::max_element(h.begin(), h.end());
@@ -186,8 +565,116 @@ const Vector<IntCost>& Heuristic::get_h(const Node goal)
             const auto new_max_path_length = MAX_PATH_LENGTH_FACTOR * *it;
             max_path_length_ = std::max(new_max_path_length, max_path_length_);
         }
+
+        // Compress the h values to restore them after eviction.
+        if (memory_budget_ > 0)
+        {
+            compress(goal, h);
+
+            // Drop the compressed h values if they do not fit.
+            if (within_budget && memory_used_ > memory_budget_)
+            {
+                auto it = compressed_h_.find(goal);
+                debug_assert(it != compressed_h_.end());
+                const auto& [compressed_h, long_h, last_used] = it->second;
+                memory_used_ -= sizeof(uint16_t) * compressed_h.size() +
+                                (sizeof(Node) + sizeof(IntCost)) * long_h.size();
+                compressed_h_.erase(it);
+                return;
+            }
+        }
     }
+
+    // Keep only the compressed h values if the h values do not fit.
+    if (within_budget && memory_budget_ > 0 && memory_used_ + sizeof(IntCost) * h.size() > memory_budget_)
+    {
+        return;
+    }
+
+    // Store the h values and evict the least recently used h values of other goals.
+    memory_used_ += sizeof(IntCost) * h.size();
+    h_[goal] = GoalH{std::move(h_ptr), now};
+    evict();
+}
+
+const Vector<IntCost>& Heuristic::get_h(const Node goal)
+{
+    // Use the lower bounds if they are in memory.
+    const auto now = ++clock_;
+    if (auto it = h_.find(goal); it != h_.end())
+    {
+        it->second.last_used = now;
+        return *it->second.h;
+    }
+
+    // Decompress the h values for this goal or compute them or read them from the cache.
+    auto h_ptr = std::make_unique<Vector<IntCost>>();
+    auto& h = *h_ptr;
+    const bool is_new = memory_budget_ == 0 || !decompress(goal, h);
+    if (is_new)
+    {
+        find_or_compute_h(goal, h);
+    }
+
+    // Store the h values.
+    add_h(goal, std::move(h_ptr), now, is_new, false);
     return h;
 }
 
+void Heuristic::precompute_h(const Vector<Node>& goals, const Int nb_threads)
+{
+    // Find the distinct goals whose lower bounds are not in memory.
+    Vector<Node> new_goals;
+    {
+        HashTable<Node, bool> seen;
+        for (const auto goal : goals)
+            if (h_.find(goal) == h_.end() && compressed_h_.find(goal) == compressed_h_.end() &&
+                seen.emplace(goal, true).second)
+            {
+                new_goals.push_back(goal);
+            }
+    }
+    if (new_goals.empty())
+    {
+        return;
+    }
+
+    // Compute the lower bounds in parallel. Every thread searches with its own data structures and takes the next
+    // goal when it finishes one, since the searches of goals in small components finish much sooner.
+    Vector<UniquePtr<Vector<IntCost>>> new_h(new_goals.size());
+    {
+        std::atomic<size_t> next_idx = 0;
+        const auto work = [&]()
+        {
+            Heuristic worker(map_);
+            worker.cache_directory_ = cache_directory_;
+            worker.map_hash_ = map_hash_;
+            worker.shared_cache_ = shared_cache_;
+            for (size_t idx; (idx = next_idx.fetch_add(1, std::memory_order_relaxed)) < new_goals.size();)
+            {
+                new_h[idx] = std::make_unique<Vector<IntCost>>();
+                worker.find_or_compute_h(new_goals[idx], *new_h[idx]);
+            }
+        };
+        const auto nb_workers = std::min<size_t>(std::max<Int>(nb_threads, 1), new_goals.size());
+        Vector<std::thread> threads;
+        for (size_t idx = 1; idx < nb_workers; ++idx)
+        {
+            threads.emplace_back(work);
+        }
+        work();
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    // Store the lower bounds as if get_h() computed them. They cannot be evicted until the next unpin(), so the
+    // lower bounds that do not fit in the memory budget are only kept compressed or are left to be found on demand.
+    for (size_t idx = 0; idx < new_goals.size(); ++idx)
+    {
+        add_h(new_goals[idx], std::move(new_h[idx]), ++clock_, true, true);
+    }
+}
+
 }
@@ -24,11 +24,40 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Coordinates.h"
 #include "LabelPool.h"
 #include "Map.h"
-#include "PriorityQueue.h"
+#include "BucketQueue.h"
+#include <filesystem>
+#include <mutex>
 
 namespace TruffleHog
 {
 
+// Lower bounds of every goal shared by the low-level solvers of all instances on the same map
+class HeuristicCache
+{
+    std::mutex mutex_;
+    HashTable<Node, Vector<IntCost>> h_;
+
+  public:
+    // Copy the lower bounds of a goal if they are stored
+    bool find(const Node goal, Vector<IntCost>& h)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (auto it = h_.find(goal); it != h_.end())
+        {
+            h = it->second;
+            return true;
+        }
+        return false;
+    }
+
+    // Store the lower bounds of a goal
+    void insert(const Node goal, const Vector<IntCost>& h)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        h_.emplace(goal, h);
+    }
+};
+
 class Heuristic
 {
     // Label for heuristic
@@ -47,48 +76,72 @@ class Heuristic
     static_assert(sizeof(Label) == 2*4);
 #endif
 
-    // Comparison of labels
-    struct LabelCompare
+    // Key of labels in the priority queue
+    struct LabelKey
     {
-        inline bool operator()(const Label* const a, const Label* const b) const
+        inline IntCost operator()(const Label* const label) const
         {
-            return a->g < b->g;
+            return label->g;
         }
     };
 
-    // Priority queue holding labels
-    class HeuristicPriorityQueue : public PriorityQueue<Label, LabelCompare>
-    {
-      public:
-        // Inherit constructors.
-        using PriorityQueue::PriorityQueue;
+    // Priority queue holding labels. Every edge has unit cost so the labels are popped from buckets in order of g.
+    using HeuristicPriorityQueue = BucketQueue<Label, LabelKey>;
 
-      protected:
-        // Modify the handle in the label pointing to its position in the priority queue
-        inline void update_pqueue_index(Label*, const Int) {}
+    // Lower bounds of a goal
+    struct GoalH
+    {
+        UniquePtr<Vector<IntCost>> h;    // Lower bound from every node
+        uint64_t last_used;              // Time of the last use
+    };
 
-        // Checks.
-#ifdef DEBUG
-        Cost get_f(const Label* label) const { return label->g; }
-        void check_pqueue_index() const {}
-#endif
+    // Lower bounds of a goal in 16 bits for only the nodes in the component of the goal
+    struct CompressedGoalH
+    {
+        Vector<uint16_t> h;                 // Lower bound from every node in the component
+        HashTable<Node, IntCost> long_h;    // Lower bounds too large for 16 bits
+        uint64_t last_used;                 // Time of the last use
     };
 
     // Instance
     const Map& map_;
 
     // Lower bounds
-    HashTable<Node, Vector<IntCost>> h_;
+    HashTable<Node, GoalH> h_;
     Time max_path_length_;
 
+    // Bounded memory for the lower bounds. Decompressed lower bounds are evicted first and then compressed lower
+    // bounds in order of least recent use. Lower bounds used since the last unpin() are never evicted.
+    size_t memory_budget_;
+    size_t memory_used_;
+    uint64_t clock_;
+    uint64_t pinned_since_;
+    HashTable<Node, CompressedGoalH> compressed_h_;
+    Vector<Int> component_;
+    Vector<Vector<Node>> component_nodes_;
+
+    // Cache of lower bounds on disk and in memory
+    std::filesystem::path cache_directory_;
+    uint64_t map_hash_;
+    std::shared_ptr<HeuristicCache> shared_cache_;
+
     // Solver data structures
     LabelPool label_pool_;
     HeuristicPriorityQueue open_;
-    Vector<bool> visited_;
+    Vector<uint32_t> visited_;    // Generation in which each node is last visited
+    uint32_t generation_;
 #ifdef DEBUG
     size_t nb_labels_;
 #endif
 
+    // Bit-parallel breadth-first search data structures
+#ifdef USE_BITSET_BFS_HEURISTIC
+    Vector<uint64_t> passable_bits_;
+    Vector<uint64_t> visited_bits_;
+    Vector<uint64_t> frontier_bits_;
+    Vector<uint64_t> next_bits_;
+#endif
+
   public:
     // Constructors
     Heuristic() = delete;
@@ -101,10 +154,31 @@ class Heuristic
 
     // Getters
     inline auto max_path_length() const { return max_path_length_; }
+    inline const auto& cache_directory() const { return cache_directory_; }
+    inline const auto& shared_cache() const { return shared_cache_; }
+    inline auto memory_budget() const { return memory_budget_; }
+    inline auto memory_used() const { return memory_used_; }
+
+    // Store the lower bounds in a directory for reuse by later runs on the same map
+    void set_cache_directory(const std::filesystem::path& cache_directory);
+
+    // Share the lower bounds with other solvers on the same map
+    inline void set_shared_cache(const std::shared_ptr<HeuristicCache>& shared_cache) { shared_cache_ = shared_cache; }
+
+    // Limit the memory of the lower bounds to a number of bytes or zero if unlimited
+    void set_memory_budget(const size_t memory_budget);
+
+    // Allow the lower bounds used so far to be evicted. Lower bounds returned by get_h() afterwards stay valid
+    // until the next call.
+    inline void unpin() { pinned_since_ = clock_ + 1; }
 
     // Get the lower bound from every node to a goal node
     const Vector<IntCost>& get_h(const Node goal);
 
+    // Compute the lower bounds of many goal nodes in parallel at once instead of one by one in get_h(). The lower
+    // bounds that do not fit in the memory budget are kept compressed or computed again on demand.
+    void precompute_h(const Vector<Node>& goals, const Int nb_threads);
+
   private:
     // Check if a node has already been visited
     bool dominated(const Node n);
@@ -116,6 +190,29 @@ class Heuristic
 
     // Compute lower bound from every node to a goal node
     void search(const Node goal, Vector<IntCost>& h);
+#ifdef USE_BITSET_BFS_HEURISTIC
+    void search_bfs(const Node goal, Vector<IntCost>& h);
+#endif
+
+    // Find the lower bounds of a goal node in the caches or compute them
+    void find_or_compute_h(const Node goal, Vector<IntCost>& h);
+
+    // Store the lower bounds of a goal node in memory, or only what fits in the memory budget if required
+    void add_h(const Node goal, UniquePtr<Vector<IntCost>>&& h_ptr, const uint64_t now, const bool is_new,
+               const bool within_budget);
+
+    // Compress and decompress the lower bounds of a goal node
+    void find_components();
+    void compress(const Node goal, const Vector<IntCost>& h);
+    bool decompress(const Node goal, Vector<IntCost>& h);
+
+    // Evict the least recently used lower bounds until the memory is within the budget
+    void evict();
+
+    // Read and write the lower bounds of a goal node in the cache
+    std::filesystem::path cache_path(const Node goal) const;
+    bool read_cache(const Node goal, Vector<IntCost>& h) const;
+    void write_cache(const Node goal, const Vector<IntCost>& h) const;
 };
 
 }
@@ -27,6 +27,9 @@ Author: Edward Lam <ed@ed-lam.com>
 #include <memory>
 #include <utility>
 #include "robin-hood-hashing/src/include/robin_hood.h"
+#ifdef USE_SWISS_TABLE
+#include "SwissTable.h"
+#endif
 
 namespace TruffleHog
 {
@@ -49,8 +52,27 @@ using Array = std::array<T, Size>;
 template<class T>
 using Vector = std::vector<T>;
 
+#ifdef USE_SWISS_TABLE
+template<class Key, class T, class Hash = robin_hood::hash<Key>, class KeyEqual = std::equal_to<Key>>
+using HashTable = SwissTable<Key, T, Hash, KeyEqual>;
+#else
 template<class Key, class T, class Hash = robin_hood::hash<Key>, class KeyEqual = std::equal_to<Key>>
 using HashTable = robin_hood::unordered_flat_map<Key, T, Hash, KeyEqual, 60>;
+#endif
+
+// Estimate the memory of the elements of a hash table, not including the empty slots
+template<class Table>
+inline size_t hash_table_bytes(const Table& table)
+{
+    return table.size() * sizeof(typename Table::value_type);
+}
+
+// Get the memory reserved for the elements of a vector
+template<class T>
+inline size_t vector_bytes(const Vector<T>& vector)
+{
+    return vector.capacity() * sizeof(T);
+}
 
 template<class T1, class T2>
 using Pair = std::pair<T1, T2>;
@@ -17,8 +17,17 @@ along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
 Author: Edward Lam <ed@ed-lam.com>
 */
 
-#include <fstream>
 #include "Instance.h"
+#include <fstream>
+#include <cctype>
+#include <charconv>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define MAP_CACHE_FILE_MAGIC (0x3130504d48465254ULL) // "TRFHMP01"
 
 namespace TruffleHog
 {
@@ -30,29 +39,231 @@ struct AgentMapData
     Position map_height;
 };
 
-void read_map(const std::filesystem::path& map_path, Map& map)
+// Read-only view of a whole file mapped into memory
+class MappedFile
+{
+    void* data_;
+    size_t size_;
+
+  public:
+    // Constructors
+    MappedFile(const std::filesystem::path& path) :
+        data_(MAP_FAILED),
+        size_(0)
+    {
+        const auto fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return;
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            size_ = st.st_size;
+            data_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        close(fd);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile(MappedFile&&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+    ~MappedFile()
+    {
+        if (data_ != MAP_FAILED)
+        {
+            munmap(data_, size_);
+        }
+    }
+
+    // Getters
+    inline bool good() const { return data_ != MAP_FAILED; }
+    inline std::string_view view() const
+    {
+        return good() ? std::string_view(static_cast<const char*>(data_), size_) : std::string_view();
+    }
+};
+
+// Reader of lines, words and integers from a buffer without copying
+class TextParser
+{
+    std::string_view text_;
+    size_t pos_;
+
+  public:
+    // Constructors
+    TextParser(const std::string_view text) :
+        text_(text),
+        pos_(0)
+    {
+    }
+
+    // Read the rest of the current line without the line break
+    std::string_view line()
+    {
+        const auto begin = pos_;
+        while (pos_ < text_.size() && text_[pos_] != '\n')
+        {
+            ++pos_;
+        }
+        auto end = pos_;
+        if (pos_ < text_.size())
+        {
+            ++pos_;
+        }
+        if (end > begin && text_[end - 1] == '\r')
+        {
+            --end;
+        }
+        return text_.substr(begin, end - begin);
+    }
+
+    // Read the next word separated by whitespace, or an empty string at the end of the buffer
+    std::string_view word()
+    {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_])))
+        {
+            ++pos_;
+        }
+        const auto begin = pos_;
+        while (pos_ < text_.size() && !std::isspace(static_cast<unsigned char>(text_[pos_])))
+        {
+            ++pos_;
+        }
+        return text_.substr(begin, pos_ - begin);
+    }
+
+    // Read the next word as an integer
+    template<class T>
+    bool integer(T& value)
+    {
+        const auto w = word();
+        const auto [ptr, ec] = std::from_chars(w.data(), w.data() + w.size(), value);
+        return !w.empty() && ec == std::errc() && ptr == w.data() + w.size();
+    }
+
+    // Read a character
+    inline bool good() const { return pos_ < text_.size(); }
+    inline char get() { return text_[pos_++]; }
+    inline char peek() const { return text_[pos_]; }
+};
+
+// Read the passable grid of a map from its binary cache if the cache is newer than the map file
+static bool read_map_cache(const std::filesystem::path& map_path,
+                           const std::filesystem::path& cache_path,
+                           Map& map)
+{
+    // Check that the cache is up to date.
+    std::error_code ec;
+    const auto map_time = std::filesystem::last_write_time(map_path, ec);
+    if (ec)
+    {
+        return false;
+    }
+    const auto cache_time = std::filesystem::last_write_time(cache_path, ec);
+    if (ec || cache_time < map_time)
+    {
+        return false;
+    }
+
+    // Check the header.
+    MappedFile file(cache_path);
+    const auto data = file.view();
+    uint64_t magic;
+    Position width;
+    Position height;
+    constexpr auto header_size = sizeof(magic) + sizeof(width) + sizeof(height);
+    if (data.size() < header_size)
+    {
+        return false;
+    }
+    memcpy(&magic, data.data(), sizeof(magic));
+    memcpy(&width, data.data() + sizeof(magic), sizeof(width));
+    memcpy(&height, data.data() + sizeof(magic) + sizeof(width), sizeof(height));
+    if (magic != MAP_CACHE_FILE_MAGIC || width <= 2 || height <= 2 ||
+        data.size() != header_size + static_cast<size_t>(width) * height)
+    {
+        return false;
+    }
+
+    // Read the grid.
+    map.resize(width, height);
+    const auto grid = data.data() + header_size;
+    for (Node n = 0; n < map.size(); ++n)
+        if (grid[n])
+        {
+            map.set_passable(n);
+        }
+    map.compute_neighbours();
+    map.compute_extents();
+
+    // Done.
+    debugln("Read map {} from cache", map_path.string());
+    return true;
+}
+
+// Write the passable grid of a map to its binary cache
+static void write_map_cache(const std::filesystem::path& cache_path, const Map& map)
 {
+    // Write to a temporary file and then move it so that other processes never read an incomplete file.
+    std::error_code ec;
+    auto tmp_path = cache_path;
+    tmp_path += fmt::format(".{}.tmp", getpid());
+    {
+        std::ofstream file(tmp_path, std::ios::binary);
+        const uint64_t magic = MAP_CACHE_FILE_MAGIC;
+        const Position width = map.width();
+        const Position height = map.height();
+        Vector<char> grid(map.size());
+        for (Node n = 0; n < map.size(); ++n)
+        {
+            grid[n] = map[n];
+        }
+        file.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
+        file.write(reinterpret_cast<const char*>(&width), sizeof(width));
+        file.write(reinterpret_cast<const char*>(&height), sizeof(height));
+        file.write(grid.data(), grid.size());
+        if (!file)
+        {
+            file.close();
+            std::filesystem::remove(tmp_path, ec);
+            return;
+        }
+    }
+    std::filesystem::rename(tmp_path, cache_path, ec);
+    if (ec)
+    {
+        std::filesystem::remove(tmp_path, ec);
+    }
+}
+
+void read_map(const std::filesystem::path& map_path, Map& map, const bool use_cache)
+{
+    // Read from the cache.
+    auto cache_path = map_path;
+    cache_path += ".bin";
+    if (use_cache && read_map_cache(map_path, cache_path, map))
+    {
+        return;
+    }
+
     // Open map file.
-    std::ifstream map_file;
-    map_file.open(map_path, std::ios::in);
+    MappedFile map_file(map_path);
     release_assert(map_file.good(), "Invalid map file {}", map_path.string());
+    TextParser parser(map_file.view());
 
     // Read map.
-    {
-        char buf[1024];
-        map_file.getline(buf, 1024);
-        release_assert(strstr(buf, "type octile"), "Invalid map file format");
-    }
+    release_assert(parser.line().find("type octile") != std::string_view::npos, "Invalid map file format");
 
     // Read map size.
     Position width = 0;
     Position height = 0;
-    String param;
     {
-        Int value;
         for (Int i = 0; i < 2; ++i)
         {
-            map_file >> param >> value;
+            const auto param = parser.word();
+            Int value;
+            release_assert(parser.integer(value), "Invalid value of {} in map file", param);
             if (param == "width")
             {
                 width = value;
@@ -76,32 +287,25 @@ void read_map(const std::filesystem::path& map_path, Map& map)
     map.resize(width, height);
 
     // Read grid.
-    map_file >> param;
-    release_assert(param == "map", "Invalid map file header");
+    release_assert(parser.word() == "map", "Invalid map file header");
     {
-        auto c = static_cast<char>(map_file.get());
-        release_assert(map_file.good(), "Invalid map header");
+        release_assert(parser.good(), "Invalid map header");
+        auto c = parser.get();
         if (c == '\r')
         {
-            c = static_cast<char>(map_file.get());
-            release_assert(map_file.good(), "Invalid map header");
+            release_assert(parser.good(), "Invalid map header");
+            c = parser.get();
         }
         release_assert(c == '\n', "Invalid map header");
     }
     Node n = width + 1; // Start reading into the second row, second column of the grid
-    while (true)
+    while (parser.good())
     {
-        auto c = static_cast<char>(map_file.get());
-        if (!map_file.good())
-        {
-            // eof
-            break;
-        }
-
+        const auto c = parser.get();
         switch (c)
         {
             case '\n':
-                if (auto c2 = map_file.peek(); map_file.good() && c2 != '\r' && c2 != '\n')
+                if (parser.good() && parser.peek() != '\r' && parser.peek() != '\n')
                 {
                     n += 2;
                 }
@@ -122,11 +326,40 @@ void read_map(const std::filesystem::path& map_path, Map& map)
     n += width + 1; // Should be +2 but already counted a +1 from the previous \n
     release_assert(n == map.size(), "Unexpected number of cells");
 
-    // Close file.
-    map_file.close();
+    // Find the neighbours and the straight obstacle-free distances of every node.
+    map.compute_neighbours();
+    map.compute_extents();
+
+    // Write the cache.
+    if (use_cache)
+    {
+        write_map_cache(cache_path, map);
+    }
 }
 
-Instance::Instance(const std::filesystem::path& scenario_path, const Agent agent_limit) :
+void MapCache::read(const std::filesystem::path& map_path, Map& map, const bool use_file_cache)
+{
+    // Copy the map if it has already been read.
+    const auto key = std::filesystem::absolute(map_path).lexically_normal().string();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (auto it = maps_.find(key); it != maps_.end())
+        {
+            map = it->second;
+            return;
+        }
+    }
+
+    // Read the map and store it.
+    read_map(map_path, map, use_file_cache);
+    std::lock_guard<std::mutex> lock(mutex_);
+    maps_.emplace(key, map);
+}
+
+Instance::Instance(const std::filesystem::path& scenario_path,
+                   const Agent agent_limit,
+                   const bool cache_map,
+                   MapCache* map_cache) :
     scenario_path(scenario_path),
     map_path(),
     map(),
@@ -136,16 +369,13 @@ Instance::Instance(const std::filesystem::path& scenario_path, const Agent agent
     Vector<AgentMapData> agents_map_data;
     {
         // Open scenario file.
-        std::ifstream scen_file;
-        scen_file.open(scenario_path, std::ios::in);
+        MappedFile scen_file(scenario_path);
         release_assert(scen_file.good(), "Cannot find scenario file {}", scenario_path.string());
+        TextParser parser(scen_file.view());
 
         // Check file format.
-        {
-            char buf[1024];
-            scen_file.getline(buf, 1024);
-            release_assert(strstr(buf, "version 1"), "Expecting \"version 1\" scenario file format");
-        }
+        release_assert(parser.line().find("version 1") != std::string_view::npos,
+                       "Expecting \"version 1\" scenario file format");
 
         // Read agents data.
         {
@@ -153,15 +383,23 @@ Instance::Instance(const std::filesystem::path& scenario_path, const Agent agent
             Position start_y;
             Position goal_x;
             Position goal_y;
-            Float tmp;
             AgentMapData agent_map_data;
-            while (agents.size() < agent_limit &&
-                   (scen_file >> tmp >>
-                    agent_map_data.map_path >>
-                    agent_map_data.map_width >> agent_map_data.map_height >>
-                    start_x >> start_y >>
-                    goal_x >> goal_y >> tmp))
+            while (agents.size() < agent_limit && !parser.word().empty())
             {
+                // Read the line of the agent. The bucket and optimal length are ignored.
+                agent_map_data.map_path = parser.word();
+                const auto good = parser.integer(agent_map_data.map_width) &&
+                                  parser.integer(agent_map_data.map_height) &&
+                                  parser.integer(start_x) &&
+                                  parser.integer(start_y) &&
+                                  parser.integer(goal_x) &&
+                                  parser.integer(goal_y) &&
+                                  !parser.word().empty();
+                if (!good)
+                {
+                    break;
+                }
+
                 // Add padding.
                 agent_map_data.map_width += 2;
                 agent_map_data.map_height += 2;
@@ -177,7 +415,14 @@ Instance::Instance(const std::filesystem::path& scenario_path, const Agent agent
                     map_path = scenario_path.parent_path().append("../map/"+agent_map_data.map_path);
 
                     // Read map.
-                    read_map(map_path, map);
+                    if (map_cache)
+                    {
+                        map_cache->read(map_path, map, cache_map);
+                    }
+                    else
+                    {
+                        read_map(map_path, map, cache_map);
+                    }
                 }
 
                 // Store.
@@ -189,9 +434,6 @@ Instance::Instance(const std::filesystem::path& scenario_path, const Agent agent
                        "Scenario file contained {} agents. Not enough to read {} agents",
                        agents.size(), agent_limit);
         release_assert(!agents.empty(), "No agents in scenario file {}", scenario_path.string());
-
-        // Close file.
-        scen_file.close();
     }
 
     // Check.
@@ -217,4 +459,48 @@ Instance::Instance(const std::filesystem::path& scenario_path, const Agent agent
     }
 }
 
+
+Instance::Instance(const std::filesystem::path& map_name,
+                   const Position width,
+                   const Position height,
+                   const Vector<bool>& passable,
+                   const Vector<Array<Position, 4>>& agent_coordinates) :
+    scenario_path(),
+    map_path(map_name),
+    map(),
+    agents()
+{
+    // Check.
+    release_assert(height > 0, "Invalid map height {}", height);
+    release_assert(width > 0, "Invalid map width {}", width);
+    release_assert(passable.size() == static_cast<size_t>(width) * height,
+                   "Expecting {} cells in a map of size {}x{} but got {}", width * height, width, height,
+                   passable.size());
+    release_assert(!agent_coordinates.empty(), "No agents in instance");
+
+    // Create map with padding.
+    map.resize(width + 2, height + 2);
+    for (Position y = 0; y < height; ++y)
+        for (Position x = 0; x < width; ++x)
+            if (passable[y * width + x])
+            {
+                map.set_passable(map.get_id(x + 1, y + 1));
+            }
+    map.compute_neighbours();
+    map.compute_extents();
+
+    // Add agents with padding.
+    for (Agent a = 0; a < static_cast<Agent>(agent_coordinates.size()); ++a)
+    {
+        const auto [start_x, start_y, goal_x, goal_y] = agent_coordinates[a];
+        release_assert(0 <= start_x && start_x < width && 0 <= start_y && start_y < height &&
+                       passable[start_y * width + start_x],
+                       "Agent {} starts at an obstacle", a);
+        release_assert(0 <= goal_x && goal_x < width && 0 <= goal_y && goal_y < height &&
+                       passable[goal_y * width + goal_x],
+                       "Agent {} ends at an obstacle", a);
+        agents.add_agent(start_x + 1, start_y + 1, goal_x + 1, goal_y + 1, map);
+    }
+}
+
 }
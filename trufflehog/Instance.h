@@ -23,10 +23,22 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "AgentsData.h"
 #include "Map.h"
 #include <filesystem>
+#include <mutex>
 
 namespace TruffleHog
 {
 
+// Parsed maps shared by all instances read in one process
+class MapCache
+{
+    std::mutex mutex_;
+    HashTable<String, Map> maps_;
+
+  public:
+    // Copy a parsed map or read it from file
+    void read(const std::filesystem::path& map_path, Map& map, const bool use_file_cache);
+};
+
 struct Instance
 {
     std::filesystem::path scenario_path;
@@ -38,7 +50,17 @@ struct Instance
   public:
     // Constructors
     Instance() = default;
-    Instance(const std::filesystem::path& scenario_path, const Agent agent_limit = std::numeric_limits<Agent>::max());
+    Instance(const std::filesystem::path& scenario_path,
+             const Agent agent_limit = std::numeric_limits<Agent>::max(),
+             const bool cache_map = false,
+             MapCache* map_cache = nullptr);
+    // Make an instance from a row-major grid of passable cells and the start and goal coordinates of every agent in
+    // the format of the scenario files. Instances with the same map name share lower bounds.
+    Instance(const std::filesystem::path& map_name,
+             const Position width,
+             const Position height,
+             const Vector<bool>& passable,
+             const Vector<Array<Position, 4>>& agent_coordinates);
     Instance(const Instance&) = default;
     Instance(Instance&&) = default;
     Instance& operator=(const Instance&) = default;
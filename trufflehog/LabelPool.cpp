@@ -18,29 +18,110 @@ Author: Edward Lam <ed@ed-lam.com>
 */
 
 #include "LabelPool.h"
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
 
-#define BLOCK_SIZE (10 * 1024 * 1024)
+#define DEFAULT_BLOCK_SIZE (10 * 1024 * 1024)
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
 
 namespace TruffleHog
 {
 
 LabelPool::LabelPool() :
     blocks_(),
+    block_size_(DEFAULT_BLOCK_SIZE),
+    huge_pages_(false),
     block_idx_(0),
     byte_idx_(0),
-    label_size_(1)
+    label_size_(1),
+    peak_bytes_used_(0)
 {
-    debug_assert(BLOCK_SIZE % 8 == 0);
+    debug_assert(DEFAULT_BLOCK_SIZE % 8 == 0);
+    allocate_block();
+}
+
+LabelPool::~LabelPool()
+{
+    free_blocks();
+}
+
+size_t LabelPool::nb_bytes_used() const
+{
+    return static_cast<size_t>(block_idx_) * block_size_ + byte_idx_;
+}
+
+size_t LabelPool::nb_bytes_peak() const
+{
+    return std::max(peak_bytes_used_, nb_bytes_used());
+}
+
+size_t LabelPool::nb_bytes_allocated() const
+{
+    return blocks_.size() * block_size_;
+}
+
+void LabelPool::configure(const size_t block_size, const bool huge_pages)
+{
+    // Release the existing blocks.
+    free_blocks();
+    block_idx_ = 0;
+    byte_idx_ = 0;
+    peak_bytes_used_ = 0;
+
+    // Round up the block size to a whole number of pages.
+    const size_t page_size = huge_pages ? HUGE_PAGE_SIZE : 8;
+    release_assert(block_size > 0, "Invalid block size {} for the label pool", block_size);
+    block_size_ = (block_size + page_size - 1) / page_size * page_size;
+    huge_pages_ = huge_pages;
+
+    // Allocate the first block.
+    allocate_block();
+}
 
-    blocks_.reserve(50);
-    blocks_.push_back(std::make_unique<std::byte[]>(BLOCK_SIZE));
-    debug_assert(blocks_.back());
+void LabelPool::allocate_block()
+{
+    // Allocate without zeroing. Pages are only touched when labels are written into them.
+    std::byte* block = nullptr;
+#ifdef __linux__
+    if (huge_pages_)
+    {
+        auto ptr = mmap(nullptr, block_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        release_assert(ptr != MAP_FAILED, "Failed to map memory for the label pool");
+#ifdef MADV_HUGEPAGE
+        madvise(ptr, block_size_, MADV_HUGEPAGE);
+#endif
+        block = reinterpret_cast<std::byte*>(ptr);
+    }
+    else
+#endif
+    {
+        block = new std::byte[block_size_];
+    }
+    debug_assert(block);
+    blocks_.push_back(block);
+}
+
+void LabelPool::free_blocks()
+{
+    for (auto block : blocks_)
+    {
+#ifdef __linux__
+        if (huge_pages_)
+        {
+            munmap(block, block_size_);
+            continue;
+        }
+#endif
+        delete[] block;
+    }
+    blocks_.clear();
 }
 
 void* LabelPool::get_label_buffer()
 {
     // Move to the next block if there's no space in the current block.
-    if (byte_idx_ + label_size_ >= BLOCK_SIZE)
+    if (byte_idx_ + label_size_ >= block_size_)
     {
         block_idx_++;
         byte_idx_ = 0;
@@ -49,13 +130,12 @@ void* LabelPool::get_label_buffer()
     // Allocate new block if no space left.
     if (block_idx_ == static_cast<Int>(blocks_.size()))
     {
-        blocks_.push_back(std::make_unique<std::byte[]>(BLOCK_SIZE));
-        debug_assert(blocks_.back());
+        allocate_block();
     }
 
     // Find the memory to store the label.
     debug_assert(block_idx_ < static_cast<Int>(blocks_.size()));
-    debug_assert(byte_idx_ < BLOCK_SIZE);
+    debug_assert(byte_idx_ < block_size_);
     auto label = reinterpret_cast<void*>(&(blocks_[block_idx_][byte_idx_]));
     debug_assert(reinterpret_cast<uintptr_t>(label) % 8 == 0);
 
@@ -66,18 +146,21 @@ void* LabelPool::get_label_buffer()
 void LabelPool::commit_latest_label()
 {
     debug_assert(block_idx_ < static_cast<Int>(blocks_.size()));
-    debug_assert(byte_idx_ < BLOCK_SIZE);
+    debug_assert(byte_idx_ < block_size_);
     debug_assert(label_size_ % 8 == 0);
     byte_idx_ += label_size_;
 }
 
 void LabelPool::reset(const Int label_size)
 {
+    peak_bytes_used_ = nb_bytes_peak();
     block_idx_ = 0;
     byte_idx_ = 0;
     label_size_ = label_size % 8 ? // Round up to next multiple of 8
                   label_size + (8 - label_size % 8) :
                   label_size;
+    release_assert(static_cast<size_t>(label_size_) < block_size_,
+                   "Label of {} bytes does not fit in a block of the label pool", label_size_);
 }
 
 }
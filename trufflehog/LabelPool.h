@@ -28,12 +28,18 @@ Author: Edward Lam <ed@ed-lam.com>
 namespace TruffleHog
 {
 
+// Arena of labels. Memory is allocated in blocks that are kept for later runs and is not zeroed. The blocks can be
+// backed by transparent huge pages to reduce TLB misses on large searches. A pool has no shared state, so each
+// thread owns the pool of its own low-level solver.
 class LabelPool
 {
-    Vector<UniquePtr<std::byte[]>> blocks_;
+    Vector<std::byte*> blocks_;
+    size_t block_size_;
+    bool huge_pages_;
     Int block_idx_;
-    Int byte_idx_;
+    size_t byte_idx_;
     Int label_size_;
+    size_t peak_bytes_used_;
 
   public:
     // Constructors
@@ -42,10 +48,18 @@ class LabelPool
     LabelPool(LabelPool&&) = delete;
     LabelPool& operator=(const LabelPool&) = delete;
     LabelPool& operator=(LabelPool&&) = delete;
-    ~LabelPool() = default;
+    ~LabelPool();
 
     // Getters
     inline Int label_size() const { return label_size_; }
+    inline size_t block_size() const { return block_size_; }
+    inline bool huge_pages() const { return huge_pages_; }
+    size_t nb_bytes_used() const;
+    size_t nb_bytes_peak() const;
+    size_t nb_bytes_allocated() const;
+
+    // Change the size of the blocks and whether they are backed by huge pages. All labels are released.
+    void configure(const size_t block_size, const bool huge_pages);
 
     // Get pointer to store a label
     void* get_label_buffer();
@@ -56,7 +70,8 @@ class LabelPool
 
   private:
     // Allocate
-    void allocate_blocks();
+    void allocate_block();
+    void free_blocks();
 };
 
 }
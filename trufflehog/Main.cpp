@@ -17,190 +17,199 @@ along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
 Author: Edward Lam <ed@ed-lam.com>
 */
 
-#define PRINT_DEBUG
-
-#include <cstdio>
-#include <cstdlib>
-#include <cstring>
-#include <fstream>
-#include <vector>
-#include <string>
-#include <queue>
-#include <unordered_map>
-#include "Debug.h"
+// Benchmark of the low-level solvers on pricing problems recorded from bcp-mapf
+
 #include "Includes.h"
 #include "Coordinates.h"
-#include "LabelPool.h"
-#include "AgentsData.h"
 #include "Map.h"
 #include "Instance.h"
-#include "Penalties.h"
-#include "Heuristic.h"
 #include "AStar.h"
+#include "PricingProblemLog.h"
+#include "SwissTable.h"
+#include <chrono>
+#include <cmath>
+
+using namespace TruffleHog;
+
+struct BenchmarkResult
+{
+    Int nb_solves;                   // Number of runs of the low-level solver
+    Int nb_mismatches;               // Number of runs whose cost differs from the recorded cost
+    double seconds;                  // Total run time
+    size_t nb_labels_generated;      // Labels checked for dominance
+    size_t nb_labels_dominated;      // Labels discarded by dominance
+    size_t nb_labels_expanded;       // Labels popped from the priority queue
+    size_t peak_label_pool_bytes;    // Largest memory used by the labels in a run
+};
+
+// Solve every problem and collect statistics
+template<class F>
+static BenchmarkResult run_benchmark(AStar& astar,
+                                     const Map& map,
+                                     const Vector<PricingProblem>& problems,
+                                     const Int nb_repeats,
+                                     F solve)
+{
+    BenchmarkResult result{};
+    for (Int repeat = 0; repeat < nb_repeats; ++repeat)
+        for (const auto& problem : problems)
+        {
+            // Set up the input.
+            astar.data() = problem.data;
+            astar.data().edge_penalties.build_index(map.size());
+            astar.reset_statistics();
+
+            // Solve.
+            const auto start_time = std::chrono::steady_clock::now();
+            astar.before_solve();
+            const auto [path, path_cost] = solve();
+            const auto end_time = std::chrono::steady_clock::now();
+
+            // Check against the pricer.
+            const auto found = !path.empty();
+            if (found != std::isfinite(problem.cost) || (found && std::abs(path_cost - problem.cost) > 1e-6))
+            {
+                result.nb_mismatches++;
+            }
+
+            // Store statistics.
+            const auto& statistics = astar.statistics();
+            result.nb_solves++;
+            result.seconds += std::chrono::duration<double>(end_time - start_time).count();
+            result.nb_labels_generated += statistics.nb_labels_generated;
+            result.nb_labels_dominated += statistics.nb_labels_dominated;
+            result.nb_labels_expanded += statistics.nb_labels_expanded;
+            result.peak_label_pool_bytes = std::max(result.peak_label_pool_bytes, astar.label_pool().nb_bytes_used());
+        }
+    return result;
+}
+
+// Build a table of the edge penalties of every problem and look up each penalised node-time and the node-time after
+// it, which is usually missing
+template<class Table>
+static double run_hash_table_benchmark(const Vector<PricingProblem>& problems, const Int nb_repeats, size_t& nb_found)
+{
+    const auto start_time = std::chrono::steady_clock::now();
+    nb_found = 0;
+    for (Int repeat = 0; repeat < nb_repeats; ++repeat)
+        for (const auto& problem : problems)
+        {
+            Table table;
+            problem.data.edge_penalties.for_each([&](const NodeTime nt, const EdgeCosts& penalties)
+            {
+                table.try_emplace(nt, penalties);
+            });
+            problem.data.edge_penalties.for_each([&](const NodeTime nt, const EdgeCosts&)
+            {
+                nb_found += table.count(nt);
+                nb_found += table.count(NodeTime{nt.n, nt.t + 1});
+            });
+        }
+    const auto end_time = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end_time - start_time).count();
+}
+
+// Print a row of the report
+static void print_result(const char* solver, const BenchmarkResult& result)
+{
+    const auto ns_per_label = result.nb_labels_generated > 0 ?
+                              1e9 * result.seconds / result.nb_labels_generated :
+                              0.0;
+    println("{:<6} {:>10} {:>12.4f} {:>14} {:>14} {:>14} {:>10.1f} {:>16} {:>10}",
+            solver,
+            result.nb_solves,
+            result.seconds,
+            result.nb_labels_generated,
+            result.nb_labels_dominated,
+            result.nb_labels_expanded,
+            ns_per_label,
+            result.peak_label_pool_bytes,
+            result.nb_mismatches);
+}
 
-int main()
+int main(int argc, char** argv)
 {
-    using namespace TruffleHog;
+    // Read arguments.
+    if (argc < 3 || argc > 4)
+    {
+        fmt::print(stderr, "Usage: {} <scenario file> <pricing problem log> [repeats]\n", argv[0]);
+        return 1;
+    }
+    const std::filesystem::path scenario_path = argv[1];
+    const std::filesystem::path log_path = argv[2];
+    const Int nb_repeats = argc == 4 ? std::atoi(argv[3]) : 1;
+    release_assert(nb_repeats >= 1, "Invalid number of repeats {}", argv[3]);
 
     // Load instance.
-    const char* scen_path = "instances/movingai_2018/20x20map/20x20map-20agents-0.scen";
-    const auto instance = Instance(scen_path);
+    const auto instance = Instance(scenario_path);
     const auto& map = instance.map;
-    const auto& agents = instance.agents;
-    const auto A = agents.size();
 
-    // Create shortest path algorithm.
+    // Read the pricing problems.
+    Vector<PricingProblem> problems;
+    {
+        PricingProblemReader reader(map, log_path);
+        PricingProblem problem;
+        while (reader.read(problem))
+        {
+            problems.push_back(problem);
+        }
+    }
+    println("Read {} pricing problems from {}", problems.size(), log_path.string());
+
+    // Compute the heuristic of every waypoint up front so that it is not included in the run time.
     AStar astar(map);
-    astar.set_verbose(true);
-
-    const Vector<NodeTime> waypoints{NodeTime{map.get_id(8, 10), 6},
-                                     NodeTime{map.get_id(6, 10), 8},
-                                     NodeTime{map.get_id(4, 10), 20}};
-//    const Vector<NodeTime> waypoints{NodeTime{map.get_id(4, 10), 20}};
-    for (const auto nt : waypoints)
-        debug_assert(map[nt.n]);
-
-    auto& edge_penalties = astar.edge_penalties();
-
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(map.get_id(5,10),0));
-//        penalties.north=5.0; penalties.south=5.0; penalties.east=5.0; penalties.west=5.0; penalties.wait=4.0; }
-//
-    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(map.get_north(map.get_id(8,10)),5));
-        penalties.north=0.0; penalties.south=5.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=0.0; }
-    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(map.get_south(map.get_id(8,10)),5));
-        penalties.north=5.0; penalties.south=0.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=0.0; }
-    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(map.get_east(map.get_id(8,10)),5));
-        penalties.north=0.0; penalties.south=0.0; penalties.east=0.0; penalties.west=5.0; penalties.wait=0.0; }
-    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(map.get_west(map.get_id(8,10)),5));
-        penalties.north=0.0; penalties.south=0.0; penalties.east=5.0; penalties.west=0.0; penalties.wait=0.0; }
-    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(map.get_wait(map.get_id(8,10)),5));
-        penalties.north=0.0; penalties.south=0.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=4.0; }
-
-    auto& finish_time_penalties = astar.finish_time_penalties();
-    finish_time_penalties.add(20, 10);
-//    finish_time_penalties.add(22, 5);
-    finish_time_penalties.add(24, 2);
-
-    astar.solve<false>(NodeTime{map.get_id(5, 10), 0}, waypoints, 50, 100);
-
-    // Create edge dual values.
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(13393,57)); penalties.north=0.0; penalties.south=0.0; penalties.east=0.0; penalties.west=1.0; penalties.wait=0.0; } // (65,68)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(16159,87)); penalties.north=0.0; penalties.south=0.0; penalties.east=0.0; penalties.west=999876.0; penalties.wait=0.0; } // (87,82)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(13182,30)); penalties.north=1.0; penalties.south=0.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=0.0; } // (50,67)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(15962,87)); penalties.north=0.0; penalties.south=999876.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=0.0; } // (86,81)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(26310,64)); penalties.north=0.0; penalties.south=0.0; penalties.east=0.0; penalties.west=18.0; penalties.wait=0.0; } // (46,134)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(12985,30)); penalties.north=0.0; penalties.south=0.0; penalties.east=1.0; penalties.west=0.0; penalties.wait=0.0; } // (49,66)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(10917,40)); penalties.north=0.0; penalties.south=0.0; penalties.east=0.0; penalties.west=1.0; penalties.wait=0.0; } // (137,55)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(13392,57)); penalties.north=0.0; penalties.south=0.0; penalties.east=1.0; penalties.west=0.0; penalties.wait=1.0; } // (64,68)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(26113,64)); penalties.north=0.0; penalties.south=18.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=0.0; } // (45,133)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(16158,87)); penalties.north=0.0; penalties.south=0.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=999876.0; } // (86,82)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(27082,96)); penalties.north=0.0; penalties.south=0.0; penalties.east=0.0; penalties.west=1.0; penalties.wait=0.0; } // (34,138)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(16743,78)); penalties.north=0.0; penalties.south=0.0; penalties.east=0.0; penalties.west=1.0; penalties.wait=0.0; } // (83,85)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(27079,44)); penalties.north=0.0; penalties.south=0.0; penalties.east=0.0; penalties.west=1.0; penalties.wait=0.0; } // (31,138)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(26321,75)); penalties.north=0.0; penalties.south=0.0; penalties.east=0.0; penalties.west=1.0; penalties.wait=0.0; } // (57,134)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(26309,64)); penalties.north=0.0; penalties.south=0.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=18.0; } // (45,134)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(10916,40)); penalties.north=0.0; penalties.south=0.0; penalties.east=1.0; penalties.west=0.0; penalties.wait=1.0; } // (136,55)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(27088,149)); penalties.north=0.0; penalties.south=0.0; penalties.east=0.0; penalties.west=999902.0; penalties.wait=0.0; } // (40,138)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(16354,87)); penalties.north=999876.0; penalties.south=0.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=0.0; } // (86,83)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(16546,78)); penalties.north=0.0; penalties.south=1.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=0.0; } // (82,84)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(26310,156)); penalties.north=0.0; penalties.south=0.0; penalties.east=0.0; penalties.west=45.0; penalties.wait=0.0; } // (46,134)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(19950,54)); penalties.north=0.0; penalties.south=1.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=0.0; } // (154,101)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(26882,44)); penalties.north=0.0; penalties.south=1.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=0.0; } // (30,137)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(26124,75)); penalties.north=0.0; penalties.south=1.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=0.0; } // (56,133)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(26320,36)); penalties.north=0.0; penalties.south=0.0; penalties.east=0.0; penalties.west=1.0; penalties.wait=0.0; } // (56,134)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(26891,149)); penalties.north=0.0; penalties.south=999902.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=0.0; } // (39,137)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(26310,111)); penalties.north=0.0; penalties.south=0.0; penalties.east=0.0; penalties.west=47.0; penalties.wait=0.0; } // (46,134)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(16157,87)); penalties.north=0.0; penalties.south=0.0; penalties.east=999876.0; penalties.west=0.0; penalties.wait=0.0; } // (85,82)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(26113,156)); penalties.north=0.0; penalties.south=45.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=0.0; } // (45,133)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(27081,96)); penalties.north=0.0; penalties.south=0.0; penalties.east=1.0; penalties.west=0.0; penalties.wait=1.0; } // (33,138)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(26505,64)); penalties.north=18.0; penalties.south=0.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=0.0; } // (45,135)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(26113,111)); penalties.north=0.0; penalties.south=47.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=0.0; } // (45,133)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(28324,127)); penalties.north=0.0; penalties.south=0.0; penalties.east=0.0; penalties.west=1.0; penalties.wait=0.0; } // (100,144)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(20146,54)); penalties.north=1.0; penalties.south=0.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=1.0; } // (154,102)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(16742,78)); penalties.north=0.0; penalties.south=0.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=1.0; } // (82,85)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(27078,44)); penalties.north=0.0; penalties.south=0.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=1.0; } // (30,138)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(26320,75)); penalties.north=0.0; penalties.south=0.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=1.0; } // (56,134)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(26308,64)); penalties.north=0.0; penalties.south=0.0; penalties.east=18.0; penalties.west=0.0; penalties.wait=0.0; } // (44,134)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(27087,149)); penalties.north=0.0; penalties.south=0.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=999902.0; } // (39,138)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(26309,156)); penalties.north=0.0; penalties.south=0.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=45.0; } // (45,134)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(28127,127)); penalties.north=0.0; penalties.south=1.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=0.0; } // (99,143)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(10917,81)); penalties.north=0.0; penalties.south=0.0; penalties.east=0.0; penalties.west=1.0; penalties.wait=0.0; } // (137,55)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(26319,36)); penalties.north=0.0; penalties.south=0.0; penalties.east=1.0; penalties.west=0.0; penalties.wait=1.0; } // (55,134)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(26309,111)); penalties.north=0.0; penalties.south=0.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=47.0; } // (45,134)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(16938,78)); penalties.north=1.0; penalties.south=0.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=0.0; } // (82,86)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(27274,44)); penalties.north=1.0; penalties.south=0.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=0.0; } // (30,139)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(26516,75)); penalties.north=1.0; penalties.south=0.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=0.0; } // (56,135)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(27283,149)); penalties.north=999902.0; penalties.south=0.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=0.0; } // (39,139)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(28325,171)); penalties.north=0.0; penalties.south=0.0; penalties.east=0.0; penalties.west=1.0; penalties.wait=0.0; } // (101,144)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(10720,81)); penalties.north=0.0; penalties.south=1.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=0.0; } // (136,54)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(26505,156)); penalties.north=45.0; penalties.south=0.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=0.0; } // (45,135)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(28323,127)); penalties.north=0.0; penalties.south=0.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=1.0; } // (99,144)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(16741,78)); penalties.north=0.0; penalties.south=0.0; penalties.east=1.0; penalties.west=0.0; penalties.wait=0.0; } // (81,85)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(27077,44)); penalties.north=0.0; penalties.south=0.0; penalties.east=1.0; penalties.west=0.0; penalties.wait=0.0; } // (29,138)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(26319,75)); penalties.north=0.0; penalties.south=0.0; penalties.east=1.0; penalties.west=0.0; penalties.wait=0.0; } // (55,134)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(27086,149)); penalties.north=0.0; penalties.south=0.0; penalties.east=999902.0; penalties.west=0.0; penalties.wait=0.0; } // (38,138)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(28128,171)); penalties.north=0.0; penalties.south=1.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=0.0; } // (100,143)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(26505,111)); penalties.north=47.0; penalties.south=0.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=0.0; } // (45,135)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(26488,108)); penalties.north=0.0; penalties.south=1.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=0.0; } // (28,135)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(26308,156)); penalties.north=0.0; penalties.south=0.0; penalties.east=45.0; penalties.west=0.0; penalties.wait=0.0; } // (44,134)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(10916,81)); penalties.north=0.0; penalties.south=0.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=1.0; } // (136,55)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(26308,111)); penalties.north=0.0; penalties.south=0.0; penalties.east=47.0; penalties.west=0.0; penalties.wait=0.0; } // (44,134)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(28519,127)); penalties.north=1.0; penalties.south=0.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=0.0; } // (99,145)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(28324,171)); penalties.north=0.0; penalties.south=0.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=1.0; } // (100,144)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(26684,108)); penalties.north=1.0; penalties.south=0.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=1.0; } // (28,136)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(28322,127)); penalties.north=0.0; penalties.south=0.0; penalties.east=1.0; penalties.west=0.0; penalties.wait=0.0; } // (98,144)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(12987,30)); penalties.north=0.0; penalties.south=0.0; penalties.east=0.0; penalties.west=1.0; penalties.wait=0.0; } // (51,66)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(11112,81)); penalties.north=1.0; penalties.south=0.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=0.0; } // (136,56)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(12790,30)); penalties.north=0.0; penalties.south=1.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=0.0; } // (50,65)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(28520,171)); penalties.north=1.0; penalties.south=0.0; penalties.east=0.0; penalties.west=0.0; penalties.wait=0.0; } // (100,145)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(10915,81)); penalties.north=0.0; penalties.south=0.0; penalties.east=1.0; penalties.west=0.0; penalties.wait=0.0; } // (135,55)
-//    { auto& penalties = edge_penalties.get_edge_penalties(NodeTime(28323,171)); penalties.north=0.0; penalties.south=0.0; penalties.east=1.0; penalties.west=0.0; penalties.wait=0.0; } // (99,144)
-
-    // Get agent.
-//    const auto a = 1;
-////    1
-////    4
-////    6
-////    9
-////    11
-////    14
-////    24
-////    28
-////    30
-////    34
-////    37
-////    39
-////    40
-////    45
-////    49
-////    50
-////    52
-////    60
-////    63
-////    68
-////    75
-////    79
-////    93
-////    97
-////    for (Agent a = 0; a < A; ++a)
-//    {
-//        println("Agent {}", a);
-//
-//        const auto start = NodeTime(agents[a].start, 0);
-//        const auto goal = agents[a].goal;
-//
-//        // Solve.
-//        astar.compute_h(goal);
-//        const auto path = astar.solve<false>(start, goal);
-//
-//        if (path.second != astar.heuristic_.get_h(goal)[start.n])
-//        {
-//            println("{} {}", a, path.second - astar.heuristic_.get_h(goal)[start.n]);
-//            printf("");
-//        }
-//        fflush(stdout);
-//    }
-
-    // Exit.
+    for (const auto& problem : problems)
+        for (const auto nt : problem.data.waypoints)
+        {
+            astar.compute_h(nt.n);
+        }
+
+    // Run.
+    const auto astar_result = run_benchmark(astar, map, problems, nb_repeats, [&astar]()
+    {
+        return astar.solve<false>();
+    });
+    const auto sipp_result = run_benchmark(astar, map, problems, nb_repeats, [&astar]()
+    {
+        return astar.solve_sipp<false>();
+    });
+
+    // Print.
+    println("{:<6} {:>10} {:>12} {:>14} {:>14} {:>14} {:>10} {:>16} {:>10}",
+            "Solver",
+            "Solves",
+            "Time (s)",
+            "Generated",
+            "Dominated",
+            "Expanded",
+            "ns/label",
+            "Peak pool (B)",
+            "Mismatches");
+    print_result("A*", astar_result);
+    print_result("SIPP", sipp_result);
+
+    // Compare the hash tables on the edge penalties.
+    {
+        using Hash = robin_hood::hash<NodeTime>;
+        using RobinHoodTable = robin_hood::unordered_flat_map<NodeTime, EdgeCosts, Hash, std::equal_to<NodeTime>, 60>;
+        size_t robin_hood_nb_found;
+        size_t swiss_nb_found;
+        const auto robin_hood_seconds =
+            run_hash_table_benchmark<RobinHoodTable>(problems, nb_repeats, robin_hood_nb_found);
+        const auto swiss_seconds =
+            run_hash_table_benchmark<SwissTable<NodeTime, EdgeCosts, Hash>>(problems, nb_repeats, swiss_nb_found);
+        release_assert(robin_hood_nb_found == swiss_nb_found, "Hash tables disagree");
+        println("");
+        println("{:<12} {:>12} {:>14}", "Hash table", "Time (s)", "Found");
+        println("{:<12} {:>12.4f} {:>14}", "Robin hood", robin_hood_seconds, robin_hood_nb_found);
+        println("{:<12} {:>12.4f} {:>14}", "Swiss", swiss_seconds, swiss_nb_found);
+#ifdef USE_SWISS_TABLE
+        println("HashTable is the Swiss table");
+#else
+        println("HashTable is the robin hood table");
+#endif
+    }
+
+    // Done.
     return 0;
 }
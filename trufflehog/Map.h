@@ -29,7 +29,12 @@ namespace TruffleHog
 class Map
 {
     Vector<bool> passable_;  // Row-major matrix
+    Vector<uint8_t> neighbours_;    // Bit d is set if moving in direction d leads to a passable node
+    Array<Node, 5> neighbour_offset_{};    // Difference between the destination and the origin of each direction
+    Vector<Array<Position, 4>> extents_;    // Number of passable nodes in a straight line from a node in each direction
     Vector<Time> latest_visit_time_;
+    Vector<Node> passable_index_;    // Position of each passable node among the passable nodes or -1 at obstacles
+    Vector<Node> passable_nodes_;    // Passable nodes in order of their position
     Position width_ = 0;
     Position height_ = 0;
 
@@ -65,6 +70,41 @@ class Map
         return passable_[n];
     }
     inline const Vector<Time>& latest_visit_time() const { return latest_visit_time_; }
+
+    // Dense index of the passable nodes for arrays that skip the obstacles and the padding
+    inline Node nb_passable() const
+    {
+        return passable_nodes_.size();
+    }
+    inline Node passable_index(const Node n) const
+    {
+        debug_assert(n < size() && passable_[n]);
+        return passable_index_[n];
+    }
+    inline Node passable_node(const Node idx) const
+    {
+        debug_assert(idx < nb_passable());
+        return passable_nodes_[idx];
+    }
+    inline uint8_t neighbours(const Node n) const
+    {
+        debug_assert(n < static_cast<Node>(neighbours_.size()));
+        return neighbours_[n];
+    }
+    inline bool is_passable(const Edge e) const
+    {
+        return (neighbours(e.n) >> e.d) & 1;
+    }
+    inline Position extent(const Node n, const Direction d) const
+    {
+        debug_assert(n < static_cast<Node>(extents_.size()) && d < 4);
+        return extents_[n][d];
+    }
+    inline Node get_neighbour(const Node n, const Int d) const
+    {
+        debug_assert(0 <= d && d < 5);
+        return n + neighbour_offset_[d];
+    }
     inline Node get_id(const Position x, const Position y) const
     {
         return y * width_ + x;
@@ -170,9 +210,11 @@ class Map
     {
         debug_assert(empty());
         passable_.resize(width * height, false);
+        neighbours_.resize(width * height, 0);
         latest_visit_time_.resize(width * height, -1);
         width_ = width;
         height_ = height;
+        neighbour_offset_ = {-width, width, 1, -1, 0};
     }
     void set_passable(const Node n)
     {
@@ -186,6 +228,58 @@ class Map
         passable_[n] = false;
         latest_visit_time_[n] = -1;
     }
+    void compute_neighbours()
+    {
+        // The map is surrounded by obstacles so the neighbours of a passable node are always inside the map.
+        for (Node n = 0; n < size(); ++n)
+        {
+            uint8_t mask = 0;
+            if (passable_[n])
+                for (Int d = 0; d < 5; ++d)
+                    if (passable_[get_neighbour(n, d)])
+                    {
+                        mask |= uint8_t{1} << d;
+                    }
+            neighbours_[n] = mask;
+        }
+
+        // Index the passable nodes.
+        passable_index_.assign(size(), -1);
+        passable_nodes_.clear();
+        for (Node n = 0; n < size(); ++n)
+            if (passable_[n])
+            {
+                passable_index_[n] = passable_nodes_.size();
+                passable_nodes_.push_back(n);
+            }
+    }
+    void compute_extents()
+    {
+        // Sweep each direction from the side the nodes extend towards.
+        extents_.assign(size(), Array<Position, 4>{});
+        for (Node n = 0; n < size(); ++n)
+        {
+            if (const auto m = get_north(n); n >= width_ && passable_[m])
+            {
+                extents_[n][Direction::NORTH] = extents_[m][Direction::NORTH] + 1;
+            }
+            if (const auto m = get_west(n); n % width_ != 0 && passable_[m])
+            {
+                extents_[n][Direction::WEST] = extents_[m][Direction::WEST] + 1;
+            }
+        }
+        for (Node n = size() - 1; n >= 0; --n)
+        {
+            if (const auto m = get_south(n); m < size() && passable_[m])
+            {
+                extents_[n][Direction::SOUTH] = extents_[m][Direction::SOUTH] + 1;
+            }
+            if (const auto m = get_east(n); m % width_ != 0 && passable_[m])
+            {
+                extents_[n][Direction::EAST] = extents_[m][Direction::EAST] + 1;
+            }
+        }
+    }
 
     // Debug
     void print() const
@@ -23,10 +23,16 @@ Author: Edward Lam <ed@ed-lam.com>
 #include "Includes.h"
 #include "Coordinates.h"
 #include "Map.h"
+#include <atomic>
 
 namespace TruffleHog
 {
 
+// Record the edge penalties used in a search for caching and debugging
+#if defined(USE_ASTAR_SOLUTION_CACHING) || defined(DEBUG)
+#define TRACK_USED_EDGE_PENALTIES
+#endif
+
 // Data structure for storing the costs of traversing an edge
 struct EdgeCosts
 {
@@ -42,29 +48,94 @@ struct EdgeCosts
             Cost wait;
         };
     };
-    bool used;
 
-    inline EdgeCosts(const Cost x) : north(x), south(x), east(x), west(x), wait(x), used(false) {}
+    inline EdgeCosts(const Cost x) : north(x), south(x), east(x), west(x), wait(x) {}
     inline EdgeCosts() : EdgeCosts(0) {}
 };
 static_assert(std::is_trivially_copyable<EdgeCosts>::value);
-static_assert(sizeof(EdgeCosts) == 6 * 8);
-
-// Penalties for crossing an edge
+static_assert(sizeof(EdgeCosts) == 5 * 8);
+
+// Penalties for crossing an edge. The penalties can be layered over a read-only base, in which case the
+// penalties of a node-time are copied from the base when first modified. A bitmap of the node-times with penalties
+// can be built to skip the hash table lookup for node-times without penalties. Building the bitmap also stamps the
+// penalties with a new revision so derived data can be reused until they are modified. The node-times whose
+// penalties are read by a search are marked in a second bitmap of the same layout, so reading never writes a hash
+// table once the bitmap is built.
 class EdgePenalties
 {
+    inline static std::atomic<uint64_t> next_revision_{1};
+
     HashTable<NodeTime, EdgeCosts> edge_penalties_;
+    const EdgePenalties* base_;
+#ifdef TRACK_USED_EDGE_PENALTIES
+    Vector<uint64_t> used_bits_;              // Node-times read by the last search while the index is built
+    Vector<size_t> used_words_;               // Non-zero words of used_bits_
+    HashTable<NodeTime, EdgeCosts> used_;     // Penalties read by the last search without the index
+#endif
+
+    // Index of node-times with penalties
+    Vector<uint64_t> index_;
+    Vector<size_t> index_words_;
+    Node index_map_size_;
+    Time index_max_time_;
+    bool index_valid_;
+    uint64_t revision_;
 
   public:
     // Constructors
-    EdgePenalties() noexcept = default;
-    EdgePenalties(const EdgePenalties& other) = default;
+    EdgePenalties() noexcept :
+        edge_penalties_(),
+        base_(nullptr),
+#ifdef TRACK_USED_EDGE_PENALTIES
+        used_bits_(),
+        used_words_(),
+        used_(),
+#endif
+        index_(),
+        index_words_(),
+        index_map_size_(0),
+        index_max_time_(-1),
+        index_valid_(false),
+        revision_(0)
+    {
+    }
+    EdgePenalties(const EdgePenalties& other) :
+        edge_penalties_(other.edge_penalties_),
+        base_(other.base_),
+#ifdef TRACK_USED_EDGE_PENALTIES
+        used_bits_(),
+        used_words_(),
+        used_(),
+#endif
+        index_(),
+        index_words_(),
+        index_map_size_(0),
+        index_max_time_(-1),
+        index_valid_(false),
+        revision_(0)
+    {
+        // Copy the used penalties into the hash table since the index is not copied.
+#ifdef TRACK_USED_EDGE_PENALTIES
+        other.for_each_used([this](const NodeTime nt, const EdgeCosts& penalties) { used_.emplace(nt, penalties); });
+#endif
+    }
     EdgePenalties(EdgePenalties&& other) noexcept = default;
-    EdgePenalties& operator=(const EdgePenalties& other) = default;
+    EdgePenalties& operator=(const EdgePenalties& other)
+    {
+        // Copy the penalties but not the index.
+        edge_penalties_ = other.edge_penalties_;
+        base_ = other.base_;
+#ifdef TRACK_USED_EDGE_PENALTIES
+        clear_used();
+        other.for_each_used([this](const NodeTime nt, const EdgeCosts& penalties) { used_.emplace(nt, penalties); });
+#endif
+        index_valid_ = false;
+        return *this;
+    }
     EdgePenalties& operator=(EdgePenalties&& other) noexcept = default;
     ~EdgePenalties() noexcept = default;
 
-    // Iterators
+    // Iterators over the penalties excluding those in the base
     inline auto begin() { return edge_penalties_.begin(); }
     inline auto begin() const { return edge_penalties_.begin(); }
     inline auto end() { return edge_penalties_.end(); }
@@ -72,6 +143,189 @@ class EdgePenalties
     inline auto find(const NodeTime nt) { return edge_penalties_.find(nt); }
     inline auto find(const NodeTime nt) const { return edge_penalties_.find(nt); }
 
+    // Visit the penalties including those in the base
+    template<class F>
+    void for_each(F&& f) const
+    {
+        for (const auto& [nt, penalties] : edge_penalties_)
+        {
+            f(nt, penalties);
+        }
+        if (base_)
+        {
+            for (const auto& [nt, penalties] : *base_)
+                if (find(nt) == end())
+                {
+                    f(nt, penalties);
+                }
+        }
+    }
+
+    // Number of node-times with penalties including those in the base, counting overridden node-times twice
+    inline size_t size_upper_bound() const
+    {
+        return edge_penalties_.size() + (base_ ? base_->edge_penalties_.size() : 0);
+    }
+
+    // Latest time of the node-times with penalties including those in the base, or -1 if there are none
+    Time max_time() const
+    {
+        Time max_time = -1;
+        if (index_valid_)
+        {
+            max_time = index_max_time_;
+        }
+        else
+        {
+            for (const auto& [nt, penalties] : edge_penalties_)
+            {
+                max_time = std::max<Time>(max_time, nt.t);
+            }
+        }
+        if (base_)
+        {
+            max_time = std::max(max_time, base_->max_time());
+        }
+        return max_time;
+    }
+
+    // Visit the penalties read by the last search
+#ifdef TRACK_USED_EDGE_PENALTIES
+    template<class F>
+    void for_each_used(F&& f) const
+    {
+        for (const auto word : used_words_)
+            for (auto bits = used_bits_[word]; bits; bits &= bits - 1)
+            {
+                const auto bit = word * 64 + __builtin_ctzll(bits);
+                const NodeTime nt{static_cast<Node>(bit % index_map_size_), static_cast<Time>(bit / index_map_size_)};
+                const auto penalties_ptr = find_edge_penalties(nt);
+                debug_assert(penalties_ptr);
+                f(nt, *penalties_ptr);
+            }
+        for (const auto& [nt, penalties] : used_)
+        {
+            f(nt, penalties);
+        }
+    }
+
+    // Number of node-times read by the last search
+    size_t nb_used() const
+    {
+        size_t nb_used = used_.size();
+        for (const auto word : used_words_)
+        {
+            nb_used += __builtin_popcountll(used_bits_[word]);
+        }
+        return nb_used;
+    }
+#endif
+
+    // Set the penalties underneath
+    inline const EdgePenalties* base() const
+    {
+        return base_;
+    }
+    inline void set_base(const EdgePenalties* base)
+    {
+        debug_assert(!base || !base->base_);
+        base_ = base;
+    }
+
+    // Build the index of node-times with penalties
+    void build_index(const Node map_size)
+    {
+        // Clear the previous index.
+        for (const auto word : index_words_)
+        {
+            index_[word] = 0;
+        }
+        index_words_.clear();
+
+        // Set a bit for every node-time with penalties.
+        index_map_size_ = map_size;
+        index_max_time_ = -1;
+        for (const auto& [nt, penalties] : edge_penalties_)
+        {
+            index_max_time_ = std::max<Time>(index_max_time_, nt.t);
+            debug_assert(0 <= nt.n && nt.n < map_size);
+            const auto bit = static_cast<size_t>(nt.t) * map_size + nt.n;
+            const auto word = bit / 64;
+            if (word >= index_.size())
+            {
+                index_.resize(word + 1);
+            }
+            if (!index_[word])
+            {
+                index_words_.push_back(word);
+            }
+            index_[word] |= uint64_t{1} << (bit % 64);
+        }
+        index_valid_ = true;
+        revision_ = next_revision_++;
+    }
+
+    // Revision of the penalties since the index was last built, or 0 if they are modified afterwards
+    inline uint64_t revision() const
+    {
+        return index_valid_ ? revision_ : 0;
+    }
+
+    // Check if a node-time has penalties in this layer, excluding the base
+    inline bool has_own_edge_penalties(const NodeTime nt) const
+    {
+        return index_valid_ ? maybe_has_edge_penalties(nt) : find(nt) != end();
+    }
+
+    // Check if a node-time can have penalties in this layer
+    inline bool maybe_has_edge_penalties(const NodeTime nt) const
+    {
+        if (!index_valid_)
+        {
+            return true;
+        }
+        const auto bit = static_cast<size_t>(nt.t) * index_map_size_ + nt.n;
+        const auto word = bit / 64;
+        return word < index_.size() && ((index_[word] >> (bit % 64)) & 0b1);
+    }
+
+    // Prefetch the index of a node-time in this layer and the base
+    inline void prefetch(const NodeTime nt) const
+    {
+        if (index_valid_)
+        {
+            const auto word = (static_cast<size_t>(nt.t) * index_map_size_ + nt.n) / 64;
+            if (word < index_.size())
+            {
+                __builtin_prefetch(&index_[word]);
+            }
+        }
+        if (base_)
+        {
+            base_->prefetch(nt);
+        }
+    }
+
+    // Return the edge penalties of a node-time without creating it
+    inline const EdgeCosts* find_edge_penalties(const NodeTime nt) const
+    {
+        if (maybe_has_edge_penalties(nt))
+        {
+            if (auto it = find(nt); it != end())
+            {
+                return &it->second;
+            }
+        }
+        if (base_ && base_->maybe_has_edge_penalties(nt))
+        {
+            if (auto it = base_->find(nt); it != base_->end())
+            {
+                return &it->second;
+            }
+        }
+        return nullptr;
+    }
+
     // Return the edge costs of a node-time
     template<IntCost default_cost>
     inline EdgeCosts get_edge_costs(const NodeTime nt)
@@ -80,12 +334,13 @@ class EdgePenalties
         EdgeCosts costs(default_cost);
 
         // Find the edge penalties.
-        auto it = find(nt);
-        if (it != end())
+        if (const auto penalties_ptr = find_edge_penalties(nt))
         {
-            auto& penalties = it->second;
+            const auto& penalties = *penalties_ptr;
 
-            penalties.used = true;
+#ifdef TRACK_USED_EDGE_PENALTIES
+            mark_used(nt, penalties);
+#endif
 
             debug_assert(penalties.north >= 0);
             debug_assert(penalties.south >= 0);
@@ -107,7 +362,16 @@ class EdgePenalties
     // Create or return the outgoing edge penalties of a node-time
     inline EdgeCosts& get_edge_penalties(const NodeTime nt)
     {
-        return edge_penalties_[nt];
+        index_valid_ = false;
+        auto [it, success] = edge_penalties_.emplace(nt, EdgeCosts());
+        if (success && base_)
+        {
+            if (auto base_it = base_->find(nt); base_it != base_->end())
+            {
+                it->second = base_it->second;
+            }
+        }
+        return it->second;
     }
     inline EdgeCosts& get_edge_penalties(const Node n, const Time t)
     {
@@ -118,6 +382,11 @@ class EdgePenalties
     inline void clear()
     {
         edge_penalties_.clear();
+        base_ = nullptr;
+#ifdef TRACK_USED_EDGE_PENALTIES
+        clear_used();
+#endif
+        index_valid_ = false;
     }
 
     // Nothing to do before solving
@@ -125,15 +394,15 @@ class EdgePenalties
     {
         // Check.
 #ifdef DEBUG
-        for (const auto& [nt, penalties] : edge_penalties_)
+        for_each([](const NodeTime, const EdgeCosts& penalties)
         {
             debug_assert(penalties.north >= 0);
             debug_assert(penalties.south >= 0);
             debug_assert(penalties.east >= 0);
             debug_assert(penalties.west >= 0);
             debug_assert(penalties.wait >= 0);
-            debug_assert(!penalties.used);
-        }
+        });
+        debug_assert(used_words_.empty() && used_.empty());
 #endif
     }
 
@@ -141,7 +410,7 @@ class EdgePenalties
     void print(const Map& map)
     {
         HashTable<NodeTime, EdgeCosts> incoming_penalties;
-        for (const auto [outgoing_nt, penalties] : edge_penalties_)
+        for_each([&](const NodeTime outgoing_nt, const EdgeCosts& penalties)
         {
             if (penalties.north != 0)
             {
@@ -178,12 +447,12 @@ class EdgePenalties
                 const NodeTime incoming_nt{incoming_n, incoming_t};
                 incoming_penalties[incoming_nt].wait += penalties.wait;
             }
-        }
+        });
 
         println("Edge penalties:");
         println("{:>20s}{:>8s}{:>8s}{:>8s}{:>8s}{:>15s}{:>15s}{:>15s}{:>15s}{:>15s}",
                 "NT", "N", "T", "X", "Y", "From North", "From South", "From East", "From West", "From Wait");
-        for (const auto [nt, penalties] : incoming_penalties)
+        for (const auto& [nt, penalties] : incoming_penalties)
         {
             println("{:>20d}{:>8d}{:>8d}{:>8d}{:>8d}{:>15.2f}{:>15.2f}{:>15.2f}{:>15.2f}{:>15.2f}",
                     nt.nt, nt.n, nt.t,
@@ -192,14 +461,14 @@ class EdgePenalties
         }
         println("");
     }
+#ifdef TRACK_USED_EDGE_PENALTIES
     void print_used(const Map& map)
     {
         Vector<Pair<NodeTime, EdgeCosts>> all_penalties;
-        for (const auto [nt, penalties] : edge_penalties_)
-            if (penalties.used)
-            {
-                all_penalties.emplace_back(nt, penalties);
-            }
+        for_each_used([&](const NodeTime nt, const EdgeCosts& penalties)
+        {
+            all_penalties.emplace_back(nt, penalties);
+        });
         std::sort(all_penalties.begin(),
                   all_penalties.end(),
                   [](const Pair<NodeTime, EdgeCosts>& a, const Pair<NodeTime, EdgeCosts>& b)
@@ -219,6 +488,44 @@ class EdgePenalties
         }
         println("");
     }
+#endif
+
+#ifdef TRACK_USED_EDGE_PENALTIES
+  private:
+    // Record that the penalties of a node-time are read
+    inline void mark_used(const NodeTime nt, const EdgeCosts& penalties)
+    {
+        if (index_valid_)
+        {
+            const auto bit = static_cast<size_t>(nt.t) * index_map_size_ + nt.n;
+            const auto word = bit / 64;
+            if (word >= used_bits_.size())
+            {
+                used_bits_.resize(std::max(word + 1, 2 * used_bits_.size()));
+            }
+            if (!used_bits_[word])
+            {
+                used_words_.push_back(word);
+            }
+            used_bits_[word] |= uint64_t{1} << (bit % 64);
+        }
+        else
+        {
+            used_.emplace(nt, penalties);
+        }
+    }
+
+    // Clear the record of used penalties
+    void clear_used()
+    {
+        for (const auto word : used_words_)
+        {
+            used_bits_[word] = 0;
+        }
+        used_words_.clear();
+        used_.clear();
+    }
+#endif
 };
 
 // Penalties for crossing the goal of another agent
@@ -294,8 +601,11 @@ class GoalPenalties
 // Penalties finishing at a particular time
 class FinishTimePenalties
 {
-    Vector<Cost> finish_time_penalties_;
+    Vector<Cost> finish_time_penalties_;    // Penalty at each time (cost added at each time before accumulating)
     Vector<Cost> finish_time_h_;
+#ifdef DEBUG
+    bool accumulated_ = false;
+#endif
 
   public:
     // Constructors
@@ -316,45 +626,63 @@ class FinishTimePenalties
     inline Time size() const { return finish_time_penalties_.size(); }
     inline bool empty() const { return !size(); }
     inline const auto& data() const { return finish_time_penalties_; }
-    auto operator[](const Time t) const { return finish_time_penalties_[t]; }
+    auto operator[](const Time t) const { debug_assert(accumulated_); return finish_time_penalties_[t]; }
 
     // Clear for next run
     inline void clear()
     {
         finish_time_penalties_.clear();
         finish_time_h_.clear();
+#ifdef DEBUG
+        accumulated_ = false;
+#endif
     }
 
     // Add a finish time penalty for finishing at or before time t_max
     void add(const Time t_max, const Cost cost)
     {
         debug_assert(cost >= 0);
+        debug_assert(!accumulated_);
+
+        // Nothing to penalise.
+        if (t_max < 0)
+        {
+            return;
+        }
 
-        if (t_max + 1 >= size())
+        // Store the cost at t_max only. The penalty of every earlier time is summed up in accumulate().
+        if (t_max >= size())
         {
             finish_time_penalties_.resize(t_max + 1);
         }
-        for (Time t = 0; t <= t_max; ++t)
+        finish_time_penalties_[t_max] += cost;
+    }
+
+    // Sum up the costs added at or after each time to get the penalty of finishing at that time
+    void accumulate()
+    {
+        debug_assert(!accumulated_);
+        for (Time t = size() - 2; t >= 0; --t)
         {
-            finish_time_penalties_[t] += cost;
+            finish_time_penalties_[t] += finish_time_penalties_[t + 1];
         }
+#ifdef DEBUG
+        accumulated_ = true;
+#endif
     }
 
-    // Sum up the penalties as a lower bound (h value)
+    // Compute the lower bound (h value) by waiting until any time i >= t and then finishing with the penalty at i,
+    // including waiting until after all finish time penalties have elapsed and then finishing at no cost
     void before_solve()
     {
+        debug_assert(accumulated_);
         debug_assert(finish_time_h_.empty());
         finish_time_h_.resize(finish_time_penalties_.size());
-        for (Time t = 0; t < static_cast<Time>(finish_time_h_.size()); ++t)
+        Cost min_finish_cost = finish_time_penalties_.size();
+        for (Time t = static_cast<Time>(finish_time_h_.size()) - 1; t >= 0; --t)
         {
-            // Wait until after all finish time penalties have elapsed and then finish at no cost.
-            finish_time_h_[t] = finish_time_penalties_.size() - t;
-
-            // Wait until time i and then finish with a penalty.
-            for (Time i = t; i < static_cast<Time>(finish_time_penalties_.size()); ++i)
-            {
-                finish_time_h_[t] = std::min(finish_time_h_[t], i - t + finish_time_penalties_[i]);
-            }
+            min_finish_cost = std::min(min_finish_cost, t + finish_time_penalties_[t]);
+            finish_time_h_[t] = min_finish_cost - t;
         }
     }
 
@@ -365,6 +693,7 @@ class FinishTimePenalties
     }
     inline Cost get_penalty(const Time t) const
     {
+        debug_assert(accumulated_);
         return t < static_cast<Time>(finish_time_penalties_.size()) ? finish_time_penalties_[t] : 0.0;
     }
 };
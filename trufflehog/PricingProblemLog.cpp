@@ -0,0 +1,272 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#include "PricingProblemLog.h"
+
+#define LOG_FILE_MAGIC 0x3130505046555254ULL // "TRUFPP01"
+
+namespace TruffleHog
+{
+
+// Records stored in the log
+struct LatestVisitTimeRecord
+{
+    Node n;
+    Time t;
+};
+struct EdgePenaltyRecord
+{
+    NodeTime nt;
+    EdgeCosts costs;
+};
+struct GoalPenaltyRecord
+{
+    NodeTime nt;
+    Cost cost;
+};
+
+// Write a value
+template<class T>
+static inline void write_value(String& buffer, const T& value)
+{
+    static_assert(std::is_trivially_copyable<T>::value);
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Write a vector prefixed by its size
+template<class T>
+static inline void write_vector(String& buffer, const Vector<T>& values)
+{
+    const uint32_t size = values.size();
+    write_value(buffer, size);
+    buffer.append(reinterpret_cast<const char*>(values.data()), sizeof(T) * size);
+}
+
+// Read a value
+template<class T>
+static inline void read_value(std::ifstream& file, T& value)
+{
+    static_assert(std::is_trivially_copyable<T>::value);
+    file.read(reinterpret_cast<char*>(&value), sizeof(T));
+}
+
+// Read a vector prefixed by its size
+template<class T>
+static inline void read_vector(std::ifstream& file, Vector<T>& values)
+{
+    uint32_t size = 0;
+    read_value(file, size);
+    if (file)
+    {
+        values.resize(size);
+        file.read(reinterpret_cast<char*>(values.data()), sizeof(T) * size);
+    }
+}
+
+PricingProblemReader::PricingProblemReader(const Map& map, const std::filesystem::path& path) :
+    map_(map),
+    file_(path, std::ios::binary)
+{
+    // Check the header.
+    release_assert(file_.good(), "Cannot open pricing problem log {}", path.string());
+    uint64_t magic = 0;
+    Position width = 0;
+    Position height = 0;
+    read_value(file_, magic);
+    read_value(file_, width);
+    read_value(file_, height);
+    release_assert(file_ && magic == LOG_FILE_MAGIC, "Invalid pricing problem log {}", path.string());
+    release_assert(width == map_.width() && height == map_.height(),
+                   "Pricing problem log {} is recorded on a map of size {}x{} instead of {}x{}",
+                   path.string(), width, height, map_.width(), map_.height());
+}
+
+PricingProblemWriter::PricingProblemWriter(const Map& map, const std::filesystem::path& path) :
+    map_(map),
+    file_(path, std::ios::binary | std::ios::trunc)
+{
+    // Write the header.
+    release_assert(file_.good(), "Cannot create pricing problem log {}", path.string());
+    String buffer;
+    write_value(buffer, static_cast<uint64_t>(LOG_FILE_MAGIC));
+    write_value(buffer, map_.width());
+    write_value(buffer, map_.height());
+    file_.write(buffer.data(), buffer.size());
+}
+
+void PricingProblemWriter::write(const Agent a, const int64_t node, const Cost cost, const AStar::Data& data)
+{
+    // Get data.
+    const auto& [start,
+                 waypoints,
+                 goal,
+                 earliest_goal_time,
+                 latest_goal_time,
+                 cost_offset,
+                 latest_visit_time,
+                 edge_penalties,
+                 finish_time_penalties
+#ifdef USE_GOAL_CONFLICTS
+               , goal_penalties
+#endif
+    ] = data;
+
+    // Serialise the problem outside the lock.
+    String buffer;
+    write_value(buffer, a);
+    write_value(buffer, node);
+    write_value(buffer, cost);
+    write_value(buffer, start);
+    write_value(buffer, goal);
+    write_value(buffer, earliest_goal_time);
+    write_value(buffer, latest_goal_time);
+    write_vector(buffer, waypoints);
+    write_value(buffer, cost_offset);
+    {
+        Vector<LatestVisitTimeRecord> changes;
+        changes.reserve(latest_visit_time.size());
+        for (const auto& [n, t] : latest_visit_time)
+        {
+            changes.push_back({n, t});
+        }
+        write_vector(buffer, changes);
+    }
+    {
+        Vector<EdgePenaltyRecord> penalties;
+        edge_penalties.for_each([&penalties](const NodeTime nt, const EdgeCosts& costs)
+        {
+            penalties.push_back({nt, costs});
+        });
+        write_vector(buffer, penalties);
+    }
+    write_vector(buffer, finish_time_penalties.data());
+    {
+        Vector<GoalPenaltyRecord> penalties;
+#ifdef USE_GOAL_CONFLICTS
+        for (const auto& [nt, goal_cost] : goal_penalties)
+        {
+            penalties.push_back({nt, goal_cost});
+        }
+#endif
+        write_vector(buffer, penalties);
+    }
+
+    // Append to the log.
+    std::lock_guard<std::mutex> lock(mutex_);
+    file_.write(buffer.data(), buffer.size());
+    release_assert(file_.good(), "Failed to write to pricing problem log");
+}
+
+bool PricingProblemReader::read(PricingProblem& problem)
+{
+    // Get data.
+    auto& [start,
+           waypoints,
+           goal,
+           earliest_goal_time,
+           latest_goal_time,
+           cost_offset,
+           latest_visit_time,
+           edge_penalties,
+           finish_time_penalties
+#ifdef USE_GOAL_CONFLICTS
+         , goal_penalties
+#endif
+    ] = problem.data;
+
+    // Read the output of the pricer.
+    read_value(file_, problem.a);
+    if (file_.eof())
+    {
+        return false;
+    }
+    read_value(file_, problem.node);
+    read_value(file_, problem.cost);
+
+    // Read the waypoints.
+    read_value(file_, start);
+    read_value(file_, goal);
+    read_value(file_, earliest_goal_time);
+    read_value(file_, latest_goal_time);
+    read_vector(file_, waypoints);
+
+    // Read the cost offset.
+    read_value(file_, cost_offset);
+
+    // Read the latest visit times that differ from the map.
+    {
+        Vector<LatestVisitTimeRecord> changes;
+        read_vector(file_, changes);
+        latest_visit_time.clear();
+        for (const auto [n, t] : changes)
+        {
+            release_assert(0 <= n && n < map_.size(), "Invalid node {} in pricing problem log", n);
+            latest_visit_time.emplace_back(n, t);
+        }
+    }
+
+    // Read the edge penalties.
+    {
+        Vector<EdgePenaltyRecord> penalties;
+        read_vector(file_, penalties);
+        edge_penalties.clear();
+        for (const auto& [nt, costs] : penalties)
+        {
+            edge_penalties.get_edge_penalties(nt) = costs;
+        }
+    }
+
+    // Read the finish time penalties. The penalty of finishing at time t sums the costs of the penalties for
+    // finishing at or before every time from t onwards.
+    {
+        Vector<Cost> penalties;
+        read_vector(file_, penalties);
+        finish_time_penalties.clear();
+        for (Time t = 0; t < static_cast<Time>(penalties.size()); ++t)
+        {
+            const auto cost = penalties[t] - (t + 1 < static_cast<Time>(penalties.size()) ? penalties[t + 1] : 0.0);
+            if (cost > 0)
+            {
+                finish_time_penalties.add(t, cost);
+            }
+        }
+        finish_time_penalties.accumulate();
+    }
+
+    // Read the goal penalties.
+    {
+        Vector<GoalPenaltyRecord> penalties;
+        read_vector(file_, penalties);
+#ifdef USE_GOAL_CONFLICTS
+        goal_penalties.clear();
+        for (const auto& [nt, cost] : penalties)
+        {
+            goal_penalties.add(nt, cost);
+        }
+#else
+        release_assert(penalties.empty(), "Pricing problem log contains goal penalties");
+#endif
+    }
+
+    // Done.
+    release_assert(file_.good(), "Truncated pricing problem log");
+    return true;
+}
+
+}
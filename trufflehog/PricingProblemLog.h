@@ -0,0 +1,86 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+#ifndef TRUFFLEHOG_PRICINGPROBLEMLOG_H
+#define TRUFFLEHOG_PRICINGPROBLEMLOG_H
+
+#include "Includes.h"
+#include "Coordinates.h"
+#include "Map.h"
+#include "AStar.h"
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+
+namespace TruffleHog
+{
+
+// Input and output of one run of the low-level solver recorded from the pricer
+struct PricingProblem
+{
+    Agent a;                    // Agent
+    int64_t node;               // Number of the branch-and-bound node
+    Cost cost;                  // Reduced cost of the best path (infinity if no path is found)
+    AStar::Data data;           // Input to the low-level solver after preprocessing
+};
+
+// Read a log of pricing problems
+class PricingProblemReader
+{
+    const Map& map_;
+    std::ifstream file_;
+
+  public:
+    // Constructors
+    PricingProblemReader() = delete;
+    PricingProblemReader(const Map& map, const std::filesystem::path& path);
+    PricingProblemReader(const PricingProblemReader&) = delete;
+    PricingProblemReader(PricingProblemReader&&) = delete;
+    PricingProblemReader& operator=(const PricingProblemReader&) = delete;
+    PricingProblemReader& operator=(PricingProblemReader&&) = delete;
+    ~PricingProblemReader() = default;
+
+    // Read the next problem. Returns false at the end of the log.
+    bool read(PricingProblem& problem);
+};
+
+// Write a log of pricing problems. Problems can be written from several threads.
+class PricingProblemWriter
+{
+    const Map& map_;
+    std::ofstream file_;
+    std::mutex mutex_;
+
+  public:
+    // Constructors
+    PricingProblemWriter() = delete;
+    PricingProblemWriter(const Map& map, const std::filesystem::path& path);
+    PricingProblemWriter(const PricingProblemWriter&) = delete;
+    PricingProblemWriter(PricingProblemWriter&&) = delete;
+    PricingProblemWriter& operator=(const PricingProblemWriter&) = delete;
+    PricingProblemWriter& operator=(PricingProblemWriter&&) = delete;
+    ~PricingProblemWriter() = default;
+
+    // Write a problem
+    void write(const Agent a, const int64_t node, const Cost cost, const AStar::Data& data);
+};
+
+}
+
+#endif
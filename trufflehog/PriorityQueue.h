@@ -30,20 +30,31 @@ Author: Edward Lam <ed@ed-lam.com>
 namespace TruffleHog
 {
 
-template<class Label, class Compare>
+// Binary or d-ary heap over labels. The key of each label is stored next to the pointer to the label so that most
+// comparisons do not read the label. Compare provides the key of a label and compares two labels given their keys.
+template<class Label, class Compare, Int D = 2>
 class PriorityQueue
 {
+    static_assert(D >= 2);
+
   protected:
+    using Key = typename Compare::Key;
+    struct Entry
+    {
+        Key key;
+        Label* label;
+    };
+
     Compare cmp_;
-    Label** elts_;
+    Entry* elts_;
     Int capacity_;
     Int size_;
 
   public:
     // Constructors
     template<class ...Args>
-    PriorityQueue(Args... args) :
-        cmp_(args...),
+    PriorityQueue(Args&&... args) :
+        cmp_(std::forward<Args>(args)...),
         elts_(nullptr),
         capacity_(0),
         size_(0)
@@ -78,8 +89,8 @@ class PriorityQueue
         }
 
         auto index = size_;
-        elts_[index] = label;
-        update_pqueue_index(elts_[index], index);
+        elts_[index] = Entry{cmp_.key(label), label};
+        update_pqueue_index(label, index);
         size_++;
         heapify_up(index);
 
@@ -97,14 +108,14 @@ class PriorityQueue
         check_heap();
 #endif
 
-        auto label = elts_[0];
+        auto label = elts_[0].label;
         update_pqueue_index(label, -1);
         size_--;
 
         if (size_ > 0)
         {
             elts_[0] = elts_[size_];
-            update_pqueue_index(elts_[0], 0);
+            update_pqueue_index(elts_[0].label, 0);
             heapify_down(0);
         }
 
@@ -127,15 +138,15 @@ class PriorityQueue
         --size_;
         if (index == size_)
         {
-            update_pqueue_index(elts_[size_], -1);
+            update_pqueue_index(elts_[size_].label, -1);
         }
         else
         {
             std::swap(elts_[index], elts_[size_]);
-            update_pqueue_index(elts_[index], index);
-            update_pqueue_index(elts_[size_], -1);
+            update_pqueue_index(elts_[index].label, index);
+            update_pqueue_index(elts_[size_].label, -1);
 
-            if (index == 0 || cmp_(elts_[(index - 1) >> 1], elts_[index]))
+            if (index == 0 || less(elts_[(index - 1) / D], elts_[index]))
             {
                 heapify_down(index);
             }
@@ -154,7 +165,16 @@ class PriorityQueue
     inline Label* top() const
     {
         debug_assert(size_ > 0);
-        return elts_[0];
+        return elts_[0].label;
+    }
+
+    // Prefetch the labels that can become the top element after the next pop
+    inline void prefetch_next() const
+    {
+        for (Int idx = 1; idx <= D && idx < size_; ++idx)
+        {
+            __builtin_prefetch(elts_[idx].label);
+        }
     }
 
     // Get the number of elements stored within
@@ -174,17 +194,32 @@ class PriorityQueue
     inline const Compare& cmp() const { return cmp_; }
 
   protected:
+    // Compare two elements
+    inline bool less(const Entry& a, const Entry& b) const
+    {
+        return cmp_(a.key, a.label, b.key, b.label);
+    }
+
+    // Reprioritise an element after its key is reduced or increased
+    void update_key(const Int index)
+    {
+        debug_assert(index < size_);
+        elts_[index].key = cmp_.key(elts_[index].label);
+    }
+
     // Reorder the subtree containing elts_[index]
     void heapify_up(Int index)
     {
         debug_assert(index < size_);
 
+        const auto elt = elts_[index];
         while (index > 0)
         {
-            const auto parent = (index - 1) >> 1;
-            if (cmp_(elts_[index], elts_[parent]))
+            const auto parent = (index - 1) / D;
+            if (less(elt, elts_[parent]))
             {
-                swap(index, parent);
+                elts_[index] = elts_[parent];
+                update_pqueue_index(elts_[index].label, index);
                 index = parent;
             }
             else
@@ -192,6 +227,8 @@ class PriorityQueue
                 break;
             }
         }
+        elts_[index] = elt;
+        update_pqueue_index(elt.label, index);
     }
 
     // Reorders the subtree under elts_[index]
@@ -199,20 +236,28 @@ class PriorityQueue
     {
         debug_assert(index < size_);
 
-        const auto first_leaf_index = size_ >> 1;
-        while (index < first_leaf_index)
+        const auto elt = elts_[index];
+        while (true)
         {
-            // Find Better child.
-            const auto child1 = (index << 1) + 1;
-            const auto child2 = (index << 1) + 2;
-            const auto which = child2 < size_ && cmp_(elts_[child2], elts_[child1]) ?
-                               child2 :
-                               child1;
-
-            // Swap child with parent if necessary.
-            if (cmp_(elts_[which], elts_[index]))
+            // Find best child.
+            const auto first_child = index * D + 1;
+            if (first_child >= size_)
+            {
+                break;
+            }
+            const auto last_child = std::min(first_child + D, size_);
+            auto which = first_child;
+            for (auto child = first_child + 1; child < last_child; ++child)
+                if (less(elts_[child], elts_[which]))
+                {
+                    which = child;
+                }
+
+            // Move child up if necessary.
+            if (less(elts_[which], elt))
             {
-                swap(index, which);
+                elts_[index] = elts_[which];
+                update_pqueue_index(elts_[index].label, index);
                 index = which;
             }
             else
@@ -220,27 +265,19 @@ class PriorityQueue
                 break;
             }
         }
+        elts_[index] = elt;
+        update_pqueue_index(elt.label, index);
     }
 
     // Allocate more memory
     void enlarge(const Int new_capacity)
     {
         debug_assert(new_capacity > capacity_);
-        elts_ = reinterpret_cast<Label**>(std::realloc(elts_, new_capacity * sizeof(Label*)));
+        elts_ = reinterpret_cast<Entry*>(std::realloc(elts_, new_capacity * sizeof(Entry)));
         release_assert(elts_, "Failed to reallocate memory");
         capacity_ = new_capacity;
     }
 
-    // Swap the positions of two labels
-    inline void swap(const Int index1, const Int index2)
-    {
-        debug_assert(index1 < size_ && index2 < size_);
-
-        std::swap(elts_[index1], elts_[index2]);
-        update_pqueue_index(elts_[index1], index1);
-        update_pqueue_index(elts_[index2], index2);
-    }
-
     // Modify the handle in the label pointing to its position in the priority queue
     virtual void update_pqueue_index(Label* label, const Int pqueue_index) = 0;
 
@@ -254,14 +291,13 @@ class PriorityQueue
 
         for (Int index = 1; index < size_; ++index)
         {
-            const auto parent = (index - 1) >> 1;
-            release_assert(isLE(get_f(elts_[parent]), get_f(elts_[index])));
-            // release_assert(!cmp_(elts_[index], elts_[parent]));
+            const auto parent = (index - 1) / D;
+            release_assert(elts_[index].key == cmp_.key(elts_[index].label));
+            release_assert(isLE(get_f(elts_[parent].label), get_f(elts_[index].label)));
         }
     }
 #endif
 };
-
 }
 
 #endif
@@ -22,6 +22,7 @@ Author: Edward Lam <ed@ed-lam.com>
 
 #include "Includes.h"
 #include "Coordinates.h"
+#include "Map.h"
 #include <cmath>
 
 #ifdef USE_RESERVATION_TABLE
@@ -29,20 +30,37 @@ Author: Edward Lam <ed@ed-lam.com>
 namespace TruffleHog
 {
 
+// Weighted conflict-avoidance table over vertices and edges. The weight of a vertex or edge at a time is the total
+// value in the LP of the paths using it. A bitset over vertices and times marks the node-times reserved by a vertex
+// or by an edge leaving the vertex so that most lookups do not probe the weights. Each time step is stored in whole
+// 64-bit words over the passable nodes only and the number of time steps grows geometrically. The weights are added
+// and subtracted so that a path can be unreserved without rebuilding the table.
 class ReservationTable
 {
-    char* table_;
+    using Word = uint64_t;
+    static constexpr size_t WORD_BITS = sizeof(Word) * CHAR_BIT;
+    static constexpr float WEIGHT_EPSILON = 1e-6;
+
+    Word* table_;
     Time timesteps_;
-    const Node map_size_;
+    Time max_reserved_time_;
+    const Map& map_;
+    const size_t words_per_timestep_;
+    HashTable<NodeTime, float> vertex_weights_;
+    HashTable<EdgeTime, float> edge_weights_;
 
   public:
     // Constructors
-    ReservationTable(const Node map_size) :
-        map_size_(map_size)
+    ReservationTable(const Map& map) :
+        table_(nullptr),
+        timesteps_(0),
+        max_reserved_time_(-1),
+        map_(map),
+        words_per_timestep_((static_cast<size_t>(map.nb_passable()) + WORD_BITS - 1) / WORD_BITS),
+        vertex_weights_(),
+        edge_weights_()
     {
-        timesteps_ = 4 * std::sqrt(map_size_);
-        table_ = static_cast<char*>(std::malloc(table_size(timesteps_)));
-        clear_reservations();
+        enlarge(std::max<Time>(4 * std::sqrt(map_.size()), 1));
     }
     ReservationTable() = delete;
     ReservationTable(const ReservationTable&) = delete;
@@ -54,89 +72,157 @@ class ReservationTable
         std::free(table_);
     }
 
+    // Get the memory used by the table
+    inline size_t nb_bytes() const
+    {
+        return table_size(timesteps_) + hash_table_bytes(vertex_weights_) + hash_table_bytes(edge_weights_);
+    }
+
     // Check and make reservation
     inline auto map_size() const
     {
-        return map_size_;
+        return map_.size();
+    }
+    float vertex_weight(const NodeTime nt) const
+    {
+        if (!is_marked(nt))
+        {
+            return 0;
+        }
+        const auto it = vertex_weights_.find(nt);
+        return it != vertex_weights_.end() ? it->second : 0;
+    }
+    float edge_weight(const EdgeTime et) const
+    {
+        if (!is_marked(et.nt()))
+        {
+            return 0;
+        }
+        const auto it = edge_weights_.find(et);
+        return it != edge_weights_.end() ? it->second : 0;
+    }
+    void reserve(const NodeTime nt, const float weight)
+    {
+        mark(nt);
+        vertex_weights_[nt] += weight;
+    }
+    void reserve(const EdgeTime et, const float weight)
+    {
+        mark(et.nt());
+        edge_weights_[et] += weight;
+    }
+    void unreserve(const NodeTime nt, const float weight)
+    {
+        // Subtract the weight and clear the bit when the vertex is no longer used. An edge is only used by paths
+        // using its source vertex so the edges leaving the vertex are also unused. The weight is already removed if
+        // it was rounded away with an earlier path.
+        const auto it = vertex_weights_.find(nt);
+        if (it == vertex_weights_.end())
+        {
+            return;
+        }
+        it->second -= weight;
+        if (it->second <= WEIGHT_EPSILON)
+        {
+            vertex_weights_.erase(it);
+            const auto [idx, mask] = position(nt);
+            table_[idx] &= ~mask;
+        }
+    }
+    void unreserve(const EdgeTime et, const float weight)
+    {
+        const auto it = edge_weights_.find(et);
+        if (it == edge_weights_.end())
+        {
+            return;
+        }
+        it->second -= weight;
+        if (it->second <= WEIGHT_EPSILON)
+        {
+            edge_weights_.erase(it);
+        }
     }
-    bool is_reserved(const NodeTime nt) const
+    inline void clear_reservations()
+    {
+        // Only clear the time steps that have been reserved.
+        if (max_reserved_time_ >= 0)
+        {
+            memset(table_, 0, table_size(max_reserved_time_ + 1));
+            max_reserved_time_ = -1;
+        }
+        vertex_weights_.clear();
+        edge_weights_.clear();
+    }
+
+  private:
+    // Check if a node-time is marked as reserved
+    inline bool is_marked(const NodeTime nt) const
     {
         // Check.
-        debug_assert(0 <= nt.n && nt.n < map_size_);
+        debug_assert(0 <= nt.n && nt.n < map_.size() && map_[nt.n]);
         debug_assert(nt.t >= 0);
 
-        // Not reserved if beyond allocated memory.
-        if (nt.t >= timesteps_)
+        // Not reserved if beyond the last reservation.
+        if (nt.t > max_reserved_time_)
         {
             return false;
         }
 
         // Get the bit.
-        const auto elem = static_cast<size_t>(nt.t) * map_size_ + nt.n;
-        const auto idx = elem / CHAR_BIT;
-        debug_assert(idx < table_size(timesteps_));
-        const char mask = 0b1 << (elem % CHAR_BIT);
-        const auto val = (table_[idx] & mask) != 0b0;
-        return val;
+        const auto [idx, mask] = position(nt);
+        return (table_[idx] & mask) != 0;
     }
-    void reserve(const NodeTime nt)
+
+    // Mark a node-time as reserved
+    void mark(const NodeTime nt)
     {
         // Check.
-        debug_assert(0 <= nt.n && nt.n < map_size_);
+        debug_assert(0 <= nt.n && nt.n < map_.size() && map_[nt.n]);
         debug_assert(nt.t >= 0);
 
-        // Reallocate if not enough memory.
+        // Reallocate if not enough memory. Grow geometrically so that long paths do not reallocate repeatedly.
         if (nt.t >= timesteps_)
         {
-            // Reallocate.
-            const auto new_timesteps = nt.t + 50;
-            table_ = static_cast<char*>(std::realloc(table_, table_size(new_timesteps)));
-            release_assert(table_, "Failed to reallocate memory for reservation table");
-
-            // Clear new section of memory.
-            const auto begin = table_ + table_size(timesteps_);
-            const auto end = table_ + table_size(new_timesteps);
-            memset(begin, 0, end - begin);
-
-            // Set size of memory.
-            timesteps_ = new_timesteps;
+            enlarge(std::max<Time>(nt.t + 1, 2 * timesteps_));
         }
+        max_reserved_time_ = std::max(max_reserved_time_, nt.t);
 
         // Set the bit.
-        const auto elem = static_cast<size_t>(nt.t) * map_size_ + nt.n;
-        const auto idx = elem / CHAR_BIT;
-        debug_assert(idx < table_size(timesteps_));
-        const char mask = 0b1 << (elem % CHAR_BIT);
+        const auto [idx, mask] = position(nt);
         table_[idx] |= mask;
     }
-    inline void unreserve(const NodeTime nt)
-    {
-        // Check.
-        debug_assert(0 <= nt.n && nt.n < map_size_);
-        debug_assert(nt.t >= 0);
 
-        // Clear the bit.
-        if (nt.t < timesteps_)
-        {
-            const auto elem = static_cast<size_t>(nt.t) * map_size_ + nt.n;
-            const auto idx = elem / CHAR_BIT;
-            debug_assert(idx < table_size(timesteps_));
-            const char mask = 0b1 << (elem % CHAR_BIT);
-            table_[idx] &= ~mask;
-        }
-    }
-    inline void clear_reservations()
+    // Find the word and bit of a vertex and time
+    inline Pair<size_t, Word> position(const NodeTime nt) const
     {
-        memset(table_, 0, table_size(timesteps_));
+        const auto n = map_.passable_index(nt.n);
+        const auto idx = static_cast<size_t>(nt.t) * words_per_timestep_ + n / WORD_BITS;
+        debug_assert(idx < static_cast<size_t>(timesteps_) * words_per_timestep_);
+        const auto mask = Word{1} << (n % WORD_BITS);
+        return {idx, mask};
     }
 
-  private:
     // Calculate the size of the reservation table in memory
     inline size_t table_size(const Time timesteps) const
     {
-        const auto tn_size = static_cast<size_t>(timesteps) * static_cast<size_t>(map_size_);
-        const auto size = (tn_size + CHAR_BIT - 1) / CHAR_BIT;
-        return size;
+        return static_cast<size_t>(timesteps) * words_per_timestep_ * sizeof(Word);
+    }
+
+    // Allocate more time steps
+    void enlarge(const Time new_timesteps)
+    {
+        // Reallocate.
+        debug_assert(new_timesteps > timesteps_);
+        table_ = static_cast<Word*>(std::realloc(table_, table_size(new_timesteps)));
+        release_assert(table_, "Failed to reallocate memory for reservation table");
+
+        // Clear new section of memory.
+        const auto begin = reinterpret_cast<char*>(table_) + table_size(timesteps_);
+        const auto end = reinterpret_cast<char*>(table_) + table_size(new_timesteps);
+        memset(begin, 0, end - begin);
+
+        // Set size of memory.
+        timesteps_ = new_timesteps;
     }
 };
 
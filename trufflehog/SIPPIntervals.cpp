@@ -29,6 +29,11 @@ SIPPIntervals::SIPPIntervals(const Map& map) :
     map_size_(map.size()),
 
     edge_penalties_(),
+    overlay_edge_penalties_(),
+
+    base_edge_penalties_(),
+    base_(nullptr),
+    base_revision_(0),
 
     intervals_(),
     intervals_range_(map_size_ * 5 * 2),
@@ -43,6 +48,26 @@ Pair<SIPPInterval*, SIPPInterval*> SIPPIntervals::get_intervals(const Node n, co
             intervals_.data() + intervals_range_[2 * (n * 5 + d) + 1]};
 }
 
+void SIPPIntervals::append_edge_penalties(const EdgePenalties& edge_penalties,
+                                          Vector<Pair<TimeDirectionNode, Cost>>& output) const
+{
+    for (const auto& [nt, edge_penalty] : edge_penalties)
+        if (map_[nt.n])
+            for (Int d = 0; d < 5; ++d)
+                if (const auto penalty = edge_penalty.d[d]; penalty != 0)
+                {
+                    output.emplace_back(TimeDirectionNode{nt.t, static_cast<Direction>(d), nt.n}, penalty);
+                }
+}
+
+void SIPPIntervals::sort_edge_penalties(Vector<Pair<TimeDirectionNode, Cost>>& edge_penalties)
+{
+    std::sort(edge_penalties.begin(),
+              edge_penalties.end(),
+              [](const Pair<TimeDirectionNode, Cost>& a, const Pair<TimeDirectionNode, Cost>& b)
+              { return a.first < b.first; });
+}
+
 // void SIPPIntervals::clear()
 // {
 //     edge_penalties_.clear();
@@ -59,32 +84,69 @@ void SIPPIntervals::create_intervals(const Vector<NodeTime>& waypoints,
                                      const EdgePenalties& edge_penalties,
                                      const FinishTimePenalties& finish_time_penalties)
 {
-    // Reorder edge penalties.
-    edge_penalties_.clear();
-    for (const auto& [nt, edge_penalty] : edge_penalties)
-        if (map_[nt.n])
-            for (Int d = 0; d < 5; ++d)
-                if (const auto penalty = edge_penalty.d[d]; penalty != 0)
-                {
-                    edge_penalties_.emplace_back(TimeDirectionNode{nt.t, static_cast<Direction>(d), nt.n}, penalty);
-                }
+    // Reorder the edge penalties of the base if they are modified since the last run. The base is shared by every
+    // agent in a round so it is only sorted once.
+    const auto base = edge_penalties.base();
+    const auto base_revision = base ? base->revision() : 0;
+    if (base != base_ || base_revision == 0 || base_revision != base_revision_)
+    {
+        base_edge_penalties_.clear();
+        if (base)
+        {
+            append_edge_penalties(*base, base_edge_penalties_);
+            sort_edge_penalties(base_edge_penalties_);
+        }
+        base_ = base;
+        base_revision_ = base_revision;
+    }
+
+    // Reorder the edge penalties of the agent.
+    overlay_edge_penalties_.clear();
+    append_edge_penalties(edge_penalties, overlay_edge_penalties_);
 
     // Add extra intervals to correctly expand to the waypoints (which includes the goal).
     for (const auto nt : waypoints)
         if (const Time t = nt.t; t > 0)
         {
-            edge_penalties_.emplace_back(TimeDirectionNode{t - 1, Direction::WAIT, nt.n}, 0.0);
+            overlay_edge_penalties_.emplace_back(TimeDirectionNode{t - 1, Direction::WAIT, nt.n}, 0.0);
         }
 
     // Add extra intervals to correctly expand to the dummy end node.
     for (Time t = 1; t < static_cast<Time>(finish_time_penalties.size()); ++t)
         if (finish_time_penalties[t] != finish_time_penalties[t - 1])
         {
-            edge_penalties_.emplace_back(TimeDirectionNode{t - 1, Direction::WAIT, goal}, 0.0);
+            overlay_edge_penalties_.emplace_back(TimeDirectionNode{t - 1, Direction::WAIT, goal}, 0.0);
         }
     if (const Time t = finish_time_penalties.size(); t > 0)
     {
-        edge_penalties_.emplace_back(TimeDirectionNode{t - 1, Direction::WAIT, goal}, 0.0);
+        overlay_edge_penalties_.emplace_back(TimeDirectionNode{t - 1, Direction::WAIT, goal}, 0.0);
+    }
+
+    // Merge the penalties of the agent into the penalties of the base. The node-times with penalties of the agent
+    // override the same node-times in the base.
+    sort_edge_penalties(overlay_edge_penalties_);
+    edge_penalties_.clear();
+    {
+        const auto is_overridden = [&](const TimeDirectionNode tdn)
+        {
+            return edge_penalties.has_own_edge_penalties(NodeTime{tdn.n, tdn.t});
+        };
+        auto base_it = base_edge_penalties_.begin();
+        const auto base_end = base_edge_penalties_.end();
+        for (const auto& entry : overlay_edge_penalties_)
+        {
+            for (; base_it != base_end && base_it->first < entry.first; ++base_it)
+                if (!is_overridden(base_it->first))
+                {
+                    edge_penalties_.push_back(*base_it);
+                }
+            edge_penalties_.push_back(entry);
+        }
+        for (; base_it != base_end; ++base_it)
+            if (!is_overridden(base_it->first))
+            {
+                edge_penalties_.push_back(*base_it);
+            }
     }
 
     // Create intervals from edge penalties.
@@ -100,11 +162,7 @@ void SIPPIntervals::create_intervals(const Vector<NodeTime>& waypoints,
     clear_to_ = 0;
     if (!edge_penalties_.empty())
     {
-        // Sort edge penalties.
-        std::sort(edge_penalties_.begin(),
-                  edge_penalties_.end(),
-                  [](const Pair<TimeDirectionNode, Cost>& a, const Pair<TimeDirectionNode, Cost>& b)
-                  { return a.first < b.first; });
+        // Check that the edge penalties are sorted.
 #ifdef DEBUG
         for (Int idx = 0; idx < static_cast<Int>(edge_penalties_.size()) - 1; ++idx)
         {
@@ -55,16 +55,18 @@ struct SIPPInterval
 
 class SIPPIntervals
 {
-#ifdef USE_PRIORITIZED_PLANNING_PRIMAL_HEURISTIC
     using IntervalIndex = uint32_t;
-#else
-    using IntervalIndex = uint16_t;
-#endif
 
     const Map& map_;
     Int map_size_;
 
     Vector<Pair<TimeDirectionNode, Cost>> edge_penalties_;
+    Vector<Pair<TimeDirectionNode, Cost>> overlay_edge_penalties_;
+
+    // Sorted penalties of the base layer kept until the base is modified
+    Vector<Pair<TimeDirectionNode, Cost>> base_edge_penalties_;
+    const EdgePenalties* base_;
+    uint64_t base_revision_;
 
     Vector<SIPPInterval> intervals_;
     Vector<IntervalIndex> intervals_range_;
@@ -91,6 +93,14 @@ class SIPPIntervals
                           const EdgePenalties& edge_penalties,
                           const FinishTimePenalties& finish_time_penalties);
     Pair<SIPPInterval*, SIPPInterval*> get_intervals(const Node n, const Direction d);
+
+  private:
+    // Append the edge penalties of a layer excluding its base
+    void append_edge_penalties(const EdgePenalties& edge_penalties,
+                               Vector<Pair<TimeDirectionNode, Cost>>& output) const;
+
+    // Sort edge penalties by node, direction and time
+    static void sort_edge_penalties(Vector<Pair<TimeDirectionNode, Cost>>& edge_penalties);
 };
 
 }
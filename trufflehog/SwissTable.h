@@ -0,0 +1,573 @@
+/*
+This file is part of BCP-MAPF.
+
+BCP-MAPF is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+BCP-MAPF is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with BCP-MAPF.  If not, see <https://www.gnu.org/licenses/>.
+
+Author: Edward Lam <ed@ed-lam.com>
+*/
+
+
+#ifndef TRUFFLEHOG_SWISSTABLE_H
+#define TRUFFLEHOG_SWISSTABLE_H
+
+#include "Debug.h"
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace TruffleHog
+{
+
+// Open-addressing hash table that probes a group of 16 control bytes at a time. Each slot has a control byte that
+// is empty, deleted or the low 7 bits of the hash of its key, so a lookup compares 16 slots with one SIMD comparison
+// and only reads the keys whose control byte matches. The slots are stored in an array of capacity 2^k - 1 followed
+// by a sentinel and a copy of the first 15 control bytes so a group can be loaded from any position. The interface
+// follows the subset of robin_hood::unordered_flat_map used as HashTable.
+template<class Key, class T, class Hash = std::hash<Key>, class KeyEqual = std::equal_to<Key>>
+class SwissTable
+{
+  public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<Key, T>;
+    using size_type = size_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+
+  private:
+    using Control = int8_t;
+    static constexpr Control EMPTY = -128;
+    static constexpr Control DELETED = -2;
+    static constexpr Control SENTINEL = -1;
+    static constexpr size_t GROUP_WIDTH = 16;
+    static constexpr size_t NB_CLONED_BYTES = GROUP_WIDTH - 1;
+
+    // Control bytes of a table without slots
+    alignas(16) static inline const Control empty_group_[GROUP_WIDTH] = {SENTINEL, EMPTY, EMPTY, EMPTY,
+                                                                        EMPTY, EMPTY, EMPTY, EMPTY,
+                                                                        EMPTY, EMPTY, EMPTY, EMPTY,
+                                                                        EMPTY, EMPTY, EMPTY, EMPTY};
+
+    // Bitmask of matching slots in a group
+    class BitMask
+    {
+        uint32_t mask_;
+
+      public:
+        explicit BitMask(const uint32_t mask) : mask_(mask) {}
+        inline explicit operator bool() const { return mask_ != 0; }
+        inline size_t lowest() const { return __builtin_ctz(mask_); }
+        inline void clear_lowest() { mask_ &= mask_ - 1; }
+    };
+
+    // Group of 16 control bytes
+    class Group
+    {
+#if defined(__SSE2__)
+        __m128i ctrl_;
+
+      public:
+        explicit Group(const Control* ctrl) : ctrl_(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl))) {}
+        inline BitMask match(const Control h2) const
+        {
+            return BitMask(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl_)));
+        }
+        inline BitMask match_empty() const
+        {
+            return BitMask(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(EMPTY), ctrl_)));
+        }
+        inline BitMask match_empty_or_deleted() const
+        {
+            return BitMask(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(SENTINEL), ctrl_)));
+        }
+#else
+        Control ctrl_[GROUP_WIDTH];
+
+        template<class F>
+        inline BitMask match_if(F&& f) const
+        {
+            uint32_t mask = 0;
+            for (size_t idx = 0; idx < GROUP_WIDTH; ++idx)
+            {
+                mask |= static_cast<uint32_t>(f(ctrl_[idx])) << idx;
+            }
+            return BitMask(mask);
+        }
+
+      public:
+        explicit Group(const Control* ctrl) { std::memcpy(ctrl_, ctrl, GROUP_WIDTH); }
+        inline BitMask match(const Control h2) const { return match_if([h2](const Control c) { return c == h2; }); }
+        inline BitMask match_empty() const { return match_if([](const Control c) { return c == EMPTY; }); }
+        inline BitMask match_empty_or_deleted() const
+        {
+            return match_if([](const Control c) { return c < SENTINEL; });
+        }
+#endif
+    };
+
+    template<bool is_const>
+    class Iterator
+    {
+        friend class SwissTable;
+        template<bool> friend class Iterator;
+
+        using Slot = std::conditional_t<is_const, const std::pair<Key, T>, std::pair<Key, T>>;
+        const Control* ctrl_;
+        Slot* slot_;
+
+        Iterator(const Control* ctrl, Slot* slot) : ctrl_(ctrl), slot_(slot) { skip_empty_or_deleted(); }
+
+        // Advance to the next full slot or the sentinel
+        inline void skip_empty_or_deleted()
+        {
+            while (*ctrl_ < SENTINEL)
+            {
+                ++ctrl_;
+                ++slot_;
+            }
+        }
+
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<Key, T>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Slot*;
+        using reference = Slot&;
+
+        Iterator() : ctrl_(nullptr), slot_(nullptr) {}
+        template<bool other_is_const, class = std::enable_if_t<is_const && !other_is_const>>
+        Iterator(const Iterator<other_is_const>& other) : ctrl_(other.ctrl_), slot_(other.slot_) {}
+
+        inline reference operator*() const { return *slot_; }
+        inline pointer operator->() const { return slot_; }
+        inline Iterator& operator++()
+        {
+            ++ctrl_;
+            ++slot_;
+            skip_empty_or_deleted();
+            return *this;
+        }
+        inline Iterator operator++(int)
+        {
+            auto copy = *this;
+            ++*this;
+            return copy;
+        }
+        template<bool other_is_const>
+        inline bool operator==(const Iterator<other_is_const>& other) const { return ctrl_ == other.ctrl_; }
+        template<bool other_is_const>
+        inline bool operator!=(const Iterator<other_is_const>& other) const { return ctrl_ != other.ctrl_; }
+    };
+
+  public:
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+  private:
+    Control* ctrl_;
+    value_type* slots_;
+    size_t capacity_;
+    size_t size_;
+    size_t growth_left_;
+    Hash hash_;
+    KeyEqual equal_;
+
+  public:
+    // Constructors
+    SwissTable() noexcept :
+        ctrl_(const_cast<Control*>(empty_group_)),
+        slots_(nullptr),
+        capacity_(0),
+        size_(0),
+        growth_left_(0),
+        hash_(),
+        equal_()
+    {
+    }
+    SwissTable(const SwissTable& other) : SwissTable()
+    {
+        reserve(other.size());
+        for (const auto& [key, value] : other)
+        {
+            emplace_new(hash_key(key), key, value);
+        }
+    }
+    SwissTable(SwissTable&& other) noexcept : SwissTable()
+    {
+        swap(other);
+    }
+    SwissTable& operator=(const SwissTable& other)
+    {
+        if (this != &other)
+        {
+            SwissTable copy(other);
+            swap(copy);
+        }
+        return *this;
+    }
+    SwissTable& operator=(SwissTable&& other) noexcept
+    {
+        swap(other);
+        return *this;
+    }
+    ~SwissTable()
+    {
+        destroy();
+    }
+
+    // Iterators
+    inline iterator begin() { return iterator(ctrl_, slots_); }
+    inline const_iterator begin() const { return const_iterator(ctrl_, slots_); }
+    inline const_iterator cbegin() const { return begin(); }
+    inline iterator end() { return iterator(ctrl_ + capacity_, slots_ + capacity_); }
+    inline const_iterator end() const { return const_iterator(ctrl_ + capacity_, slots_ + capacity_); }
+    inline const_iterator cend() const { return end(); }
+
+    // Size
+    inline size_t size() const { return size_; }
+    inline bool empty() const { return size_ == 0; }
+
+    // Remove all elements but keep the memory
+    void clear()
+    {
+        if (capacity_ == 0)
+        {
+            return;
+        }
+        if (size_ > 0)
+        {
+            if constexpr (!std::is_trivially_destructible_v<value_type>)
+            {
+                for (size_t idx = 0; idx < capacity_; ++idx)
+                    if (ctrl_[idx] >= 0)
+                    {
+                        slots_[idx].~value_type();
+                    }
+            }
+        }
+        reset_ctrl();
+        size_ = 0;
+        growth_left_ = max_load(capacity_);
+    }
+
+    // Allocate memory for a number of elements
+    void reserve(const size_t count)
+    {
+        if (count > size_ + growth_left_)
+        {
+            resize(capacity_for(count));
+        }
+    }
+
+    // Find an element
+    inline iterator find(const Key& key)
+    {
+        return iterator_at(find_index(key));
+    }
+    inline const_iterator find(const Key& key) const
+    {
+        const auto idx = find_index(key);
+        return const_iterator(ctrl_ + idx, slots_ + idx);
+    }
+    inline size_t count(const Key& key) const
+    {
+        return find_index(key) != capacity_;
+    }
+    inline bool contains(const Key& key) const
+    {
+        return find_index(key) != capacity_;
+    }
+    T& at(const Key& key)
+    {
+        const auto idx = find_index(key);
+        release_assert(idx != capacity_, "Key not found in hash table");
+        return slots_[idx].second;
+    }
+    const T& at(const Key& key) const
+    {
+        const auto idx = find_index(key);
+        release_assert(idx != capacity_, "Key not found in hash table");
+        return slots_[idx].second;
+    }
+
+    // Insert an element
+    template<class... Args>
+    inline std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args)
+    {
+        const auto hash = hash_key(key);
+        if (const auto idx = find_index(key, hash); idx != capacity_)
+        {
+            return {iterator_at(idx), false};
+        }
+        return {emplace_new(hash,
+                            std::piecewise_construct,
+                            std::forward_as_tuple(key),
+                            std::forward_as_tuple(std::forward<Args>(args)...)),
+                true};
+    }
+    template<class... Args>
+    inline std::pair<iterator, bool> emplace(Args&&... args)
+    {
+        value_type value(std::forward<Args>(args)...);
+        const auto hash = hash_key(value.first);
+        if (const auto idx = find_index(value.first, hash); idx != capacity_)
+        {
+            return {iterator_at(idx), false};
+        }
+        return {emplace_new(hash, std::move(value)), true};
+    }
+    inline std::pair<iterator, bool> insert(const value_type& value)
+    {
+        return try_emplace(value.first, value.second);
+    }
+    inline std::pair<iterator, bool> insert(value_type&& value)
+    {
+        return try_emplace(value.first, std::move(value.second));
+    }
+    template<class M>
+    inline std::pair<iterator, bool> insert_or_assign(const Key& key, M&& value)
+    {
+        auto result = try_emplace(key, std::forward<M>(value));
+        if (!result.second)
+        {
+            result.first->second = std::forward<M>(value);
+        }
+        return result;
+    }
+    inline T& operator[](const Key& key)
+    {
+        return try_emplace(key).first->second;
+    }
+
+    // Remove an element
+    iterator erase(const_iterator it)
+    {
+        const auto idx = static_cast<size_t>(it.ctrl_ - ctrl_);
+        debug_assert(idx < capacity_ && ctrl_[idx] >= 0);
+        erase_at(idx);
+        return iterator_at(idx + 1);
+    }
+    inline iterator erase(iterator it)
+    {
+        return erase(const_iterator(it));
+    }
+    size_t erase(const Key& key)
+    {
+        if (const auto idx = find_index(key); idx != capacity_)
+        {
+            erase_at(idx);
+            return 1;
+        }
+        return 0;
+    }
+
+    // Swap the contents of two tables
+    void swap(SwissTable& other) noexcept
+    {
+        std::swap(ctrl_, other.ctrl_);
+        std::swap(slots_, other.slots_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(size_, other.size_);
+        std::swap(growth_left_, other.growth_left_);
+        std::swap(hash_, other.hash_);
+        std::swap(equal_, other.equal_);
+    }
+
+  private:
+    // Cheap mixer of a hash. The packed node-time and edge-time keys are hashed to themselves so the multiplication
+    // is the only mixing they get. The high bits of the product select the group and the low bits are stored in the
+    // control byte.
+    inline size_t hash_key(const Key& key) const
+    {
+        const uint64_t h = static_cast<uint64_t>(hash_(key)) * UINT64_C(0x9E3779B97F4A7C15);
+        return static_cast<size_t>(h ^ (h >> 32));
+    }
+    static inline size_t h1(const size_t hash) { return hash >> 7; }
+    static inline Control h2(const size_t hash) { return static_cast<Control>(hash & 0x7F); }
+
+    // Maximum number of elements before growing
+    static inline size_t max_load(const size_t capacity)
+    {
+        return capacity - capacity / 8;
+    }
+    static inline size_t capacity_for(const size_t count)
+    {
+        size_t capacity = GROUP_WIDTH - 1;
+        while (max_load(capacity) < count)
+        {
+            capacity = capacity * 2 + 1;
+        }
+        return capacity;
+    }
+
+    // Get an iterator to a slot or the next full slot after it
+    inline iterator iterator_at(const size_t idx)
+    {
+        return iterator(ctrl_ + idx, slots_ + idx);
+    }
+
+    // Set the control byte of a slot and its copy after the sentinel
+    inline void set_ctrl(const size_t idx, const Control h)
+    {
+        ctrl_[idx] = h;
+        ctrl_[((idx - NB_CLONED_BYTES) & capacity_) + (NB_CLONED_BYTES & capacity_)] = h;
+    }
+    inline void reset_ctrl()
+    {
+        std::memset(ctrl_, EMPTY, capacity_ + 1 + NB_CLONED_BYTES);
+        ctrl_[capacity_] = SENTINEL;
+    }
+
+    // Find the slot of a key or return the capacity if it is not present
+    inline size_t find_index(const Key& key) const
+    {
+        return find_index(key, hash_key(key));
+    }
+    size_t find_index(const Key& key, const size_t hash) const
+    {
+        size_t pos = h1(hash) & capacity_;
+        for (size_t step = GROUP_WIDTH;; step += GROUP_WIDTH)
+        {
+            const Group group(ctrl_ + pos);
+            for (auto match = group.match(h2(hash)); match; match.clear_lowest())
+            {
+                const auto idx = (pos + match.lowest()) & capacity_;
+                if (equal_(slots_[idx].first, key))
+                {
+                    return idx;
+                }
+            }
+            if (group.match_empty())
+            {
+                return capacity_;
+            }
+            pos = (pos + step) & capacity_;
+        }
+    }
+
+    // Find the first empty or deleted slot in the probe sequence of a hash
+    size_t find_free_index(const size_t hash) const
+    {
+        size_t pos = h1(hash) & capacity_;
+        for (size_t step = GROUP_WIDTH;; step += GROUP_WIDTH)
+        {
+            const Group group(ctrl_ + pos);
+            if (const auto match = group.match_empty_or_deleted())
+            {
+                return (pos + match.lowest()) & capacity_;
+            }
+            pos = (pos + step) & capacity_;
+        }
+    }
+
+    // Insert an element known not to be present
+    template<class... Args>
+    iterator emplace_new(const size_t hash, Args&&... args)
+    {
+        auto idx = find_free_index(hash);
+        if (growth_left_ == 0 && ctrl_[idx] != DELETED)
+        {
+            // Grow if the table is mostly full, otherwise rehash in place to reuse the deleted slots.
+            if (capacity_ == 0)
+            {
+                resize(GROUP_WIDTH - 1);
+            }
+            else
+            {
+                resize(size_ * 2 > max_load(capacity_) ? capacity_ * 2 + 1 : capacity_);
+            }
+            idx = find_free_index(hash);
+        }
+        growth_left_ -= ctrl_[idx] == EMPTY;
+        new (slots_ + idx) value_type(std::forward<Args>(args)...);
+        set_ctrl(idx, h2(hash));
+        size_++;
+        return iterator_at(idx);
+    }
+
+    // Remove the element in a slot
+    void erase_at(const size_t idx)
+    {
+        slots_[idx].~value_type();
+        set_ctrl(idx, DELETED);
+        size_--;
+    }
+
+    // Move the elements to new memory
+    void resize(const size_t new_capacity)
+    {
+        auto old_ctrl = ctrl_;
+        auto old_slots = slots_;
+        const auto old_capacity = capacity_;
+
+        ctrl_ = static_cast<Control*>(::operator new(new_capacity + 1 + NB_CLONED_BYTES));
+        slots_ = static_cast<value_type*>(::operator new(new_capacity * sizeof(value_type),
+                                                         std::align_val_t{alignof(value_type)}));
+        capacity_ = new_capacity;
+        reset_ctrl();
+        growth_left_ = max_load(capacity_) - size_;
+
+        for (size_t idx = 0; idx < old_capacity; ++idx)
+            if (old_ctrl[idx] >= 0)
+            {
+                const auto hash = hash_key(old_slots[idx].first);
+                const auto new_idx = find_free_index(hash);
+                new (slots_ + new_idx) value_type(std::move(old_slots[idx]));
+                old_slots[idx].~value_type();
+                set_ctrl(new_idx, h2(hash));
+            }
+
+        if (old_capacity > 0)
+        {
+            ::operator delete(old_ctrl);
+            ::operator delete(old_slots, std::align_val_t{alignof(value_type)});
+        }
+    }
+
+    // Free all memory
+    void destroy()
+    {
+        if (capacity_ == 0)
+        {
+            return;
+        }
+        if constexpr (!std::is_trivially_destructible_v<value_type>)
+        {
+            for (size_t idx = 0; idx < capacity_; ++idx)
+                if (ctrl_[idx] >= 0)
+                {
+                    slots_[idx].~value_type();
+                }
+        }
+        ::operator delete(ctrl_);
+        ::operator delete(slots_, std::align_val_t{alignof(value_type)});
+        ctrl_ = const_cast<Control*>(empty_group_);
+        slots_ = nullptr;
+        capacity_ = 0;
+        size_ = 0;
+        growth_left_ = 0;
+    }
+};
+
+}
+
+#endif